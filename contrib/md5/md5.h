@@ -20,6 +20,9 @@
  * with this program; if not, visit the http://fsf.org website.
  */
 
+#ifndef _MD5_H
+#define _MD5_H
+
 #undef CAREFUL_ALIGNMENT
 
 /* We know that the x86 can handle misalignment and has the same
@@ -76,3 +79,5 @@ void md5_update(md_context *ctx, const uint8_t *input, uint32_t length);
 void md5_result(md_context *ctx, uint8_t digest[MD5_DIGEST_LEN]);
 
 void get_md5(uint8_t digest[MD5_DIGEST_LEN], const uint8_t *input, int n);
+
+#endif /* _MD5_H */
@@ -0,0 +1,822 @@
+/*
+  Copyright (c) 2011 Gluster, Inc. <http://www.gluster.com>
+  This file is part of GlusterFS.
+
+  GlusterFS is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published
+  by the Free Software Foundation; either version 3 of the License,
+  or (at your option) any later version.
+
+  GlusterFS is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+/* glfs-graph-bm: load a translator graph from a volume file into this
+ * process through libglusterfsclient and drive it with scripted fop mixes
+ * from many threads. No mount, no glusterfsd: the graph usually sits on a
+ * storage/posix volume exporting a scratch directory, so the numbers are
+ * those of the translators themselves.
+ *
+ * Passing two volume files runs the same workloads against both and
+ * prints the second relative to the first.
+ */
+
+#define _GNU_SOURCE
+#define __USE_FILE_OFFSET64
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <argp.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <libglusterfsclient.h>
+
+#define BM_MAX_SPECFILES  2
+#define BM_MAX_THREADS    256
+
+/* latency histogram: exact below 16us, then 16 linear sub-buckets per
+   power of two, i.e. values are known within 1/16th */
+#define BM_HIST_SUB_BITS  4
+#define BM_HIST_SUB       (1 << BM_HIST_SUB_BITS)
+#define BM_HIST_BUCKETS   (64 * BM_HIST_SUB)
+
+typedef enum {
+        BM_FOP_CREAT,
+        BM_FOP_OPEN,
+        BM_FOP_WRITE,
+        BM_FOP_READ,
+        BM_FOP_CLOSE,
+        BM_FOP_STAT,
+        BM_FOP_CHMOD,
+        BM_FOP_SETXATTR,
+        BM_FOP_UNLINK,
+        BM_FOP_MKDIR,
+        BM_FOP_RMDIR,
+        BM_FOP_MAX,
+} bm_fop_t;
+
+static const char *bm_fop_names[BM_FOP_MAX] = {
+        [BM_FOP_CREAT]    = "creat",
+        [BM_FOP_OPEN]     = "open",
+        [BM_FOP_WRITE]    = "write",
+        [BM_FOP_READ]     = "read",
+        [BM_FOP_CLOSE]    = "close",
+        [BM_FOP_STAT]     = "stat",
+        [BM_FOP_CHMOD]    = "chmod",
+        [BM_FOP_SETXATTR] = "setxattr",
+        [BM_FOP_UNLINK]   = "unlink",
+        [BM_FOP_MKDIR]    = "mkdir",
+        [BM_FOP_RMDIR]    = "rmdir",
+};
+
+typedef enum {
+        BM_LOAD_SMALLFILE,
+        BM_LOAD_SEQIO,
+        BM_LOAD_METADATA,
+        BM_LOAD_MAX,
+} bm_load_t;
+
+static const char *bm_load_names[BM_LOAD_MAX] = {
+        [BM_LOAD_SMALLFILE] = "smallfile",
+        [BM_LOAD_SEQIO]     = "seqio",
+        [BM_LOAD_METADATA]  = "metadata",
+};
+
+struct hist {
+        uint64_t count;
+        uint64_t errors;
+        uint64_t total_usec;
+        uint64_t max_usec;
+        uint64_t buckets[BM_HIST_BUCKETS];
+};
+
+struct result {
+        struct hist fops[BM_FOP_MAX];
+        uint64_t    bytes;
+        uint64_t    elapsed_usec;
+        int         done;
+};
+
+struct state {
+        char *specfiles[BM_MAX_SPECFILES];
+        int   specfile_count;
+
+        char *volume_name;
+        char *logfile;
+        char *loglevel;
+
+        char  need_load[BM_LOAD_MAX];
+
+        char  prefix[512];
+        int   threads;
+        long  count;            /* files per thread */
+        size_t block_size;
+        size_t file_size;       /* per thread file of seqio */
+
+        struct result results[BM_MAX_SPECFILES][BM_LOAD_MAX];
+};
+
+struct worker {
+        pthread_t           thread;
+        int                 id;
+        struct state       *state;
+        glusterfs_handle_t  handle;
+        bm_load_t           load;
+        pthread_barrier_t  *barrier;
+        struct hist         fops[BM_FOP_MAX];
+        uint64_t            bytes;
+};
+
+
+static uint64_t
+now_usec (void)
+{
+        struct timeval tv;
+
+        gettimeofday (&tv, NULL);
+
+        return ((uint64_t) tv.tv_sec * 1000000) + tv.tv_usec;
+}
+
+
+static int
+hist_index (uint64_t usec)
+{
+        int msb = 0;
+        int idx = 0;
+
+        if (usec < BM_HIST_SUB)
+                return usec;
+
+        msb = 63 - __builtin_clzll (usec);
+        idx = (msb - BM_HIST_SUB_BITS + 1) * BM_HIST_SUB
+                + (int)((usec >> (msb - BM_HIST_SUB_BITS)) - BM_HIST_SUB);
+
+        if (idx >= BM_HIST_BUCKETS)
+                idx = BM_HIST_BUCKETS - 1;
+
+        return idx;
+}
+
+
+static uint64_t
+hist_value (int idx)
+{
+        int msb = 0;
+        int sub = 0;
+
+        if (idx < BM_HIST_SUB)
+                return idx;
+
+        msb = (idx / BM_HIST_SUB) + BM_HIST_SUB_BITS - 1;
+        sub = idx % BM_HIST_SUB;
+
+        return (uint64_t)(BM_HIST_SUB + sub) << (msb - BM_HIST_SUB_BITS);
+}
+
+
+static void
+hist_add (struct hist *hist, uint64_t usec, int failed)
+{
+        hist->count++;
+        hist->total_usec += usec;
+        if (usec > hist->max_usec)
+                hist->max_usec = usec;
+        hist->buckets[hist_index (usec)]++;
+
+        if (failed)
+                hist->errors++;
+}
+
+
+static void
+hist_merge (struct hist *to, struct hist *from)
+{
+        int i = 0;
+
+        to->count      += from->count;
+        to->errors     += from->errors;
+        to->total_usec += from->total_usec;
+        if (from->max_usec > to->max_usec)
+                to->max_usec = from->max_usec;
+
+        for (i = 0; i < BM_HIST_BUCKETS; i++)
+                to->buckets[i] += from->buckets[i];
+}
+
+
+static uint64_t
+hist_percentile (struct hist *hist, double pct)
+{
+        uint64_t wanted = 0;
+        uint64_t seen   = 0;
+        int      i      = 0;
+
+        if (!hist->count)
+                return 0;
+
+        wanted = (uint64_t)(hist->count * pct / 100.0);
+        if (wanted == 0)
+                wanted = 1;
+
+        for (i = 0; i < BM_HIST_BUCKETS; i++) {
+                seen += hist->buckets[i];
+                if (seen >= wanted)
+                        return hist_value (i);
+        }
+
+        return hist->max_usec;
+}
+
+
+/* run one fop and account its latency. evaluates to the fop's return */
+#define BM_TIMED(w, fop, failcond, call) ({                             \
+                uint64_t __start = now_usec ();                         \
+                typeof (call) __ret = call;                             \
+                hist_add (&(w)->fops[fop], now_usec () - __start,       \
+                          (failcond));                                  \
+                __ret;                                                  \
+        })
+
+
+static int
+bm_creat_write (struct worker *w, const char *path, char *block,
+                size_t size)
+{
+        glusterfs_file_t  fd      = NULL;
+        size_t            written = 0;
+        ssize_t           ret     = 0;
+        size_t            chunk   = 0;
+
+        fd = BM_TIMED (w, BM_FOP_CREAT, (__ret == NULL),
+                       glusterfs_glh_creat (w->handle, path, 0600));
+        if (!fd) {
+                fprintf (stderr, "creat (%s) => %s\n", path, strerror (errno));
+                return -1;
+        }
+
+        while (written < size) {
+                chunk = w->state->block_size;
+                if (chunk > (size - written))
+                        chunk = size - written;
+
+                ret = BM_TIMED (w, BM_FOP_WRITE, (__ret != chunk),
+                                glusterfs_write (fd, block, chunk));
+                if (ret != chunk) {
+                        fprintf (stderr, "write (%s) => %zd/%s\n", path, ret,
+                                 strerror (errno));
+                        break;
+                }
+                written += ret;
+                w->bytes += ret;
+        }
+
+        BM_TIMED (w, BM_FOP_CLOSE, (__ret != 0), glusterfs_close (fd));
+
+        return (written == size) ? 0 : -1;
+}
+
+
+static int
+bm_open_read (struct worker *w, const char *path, char *block)
+{
+        glusterfs_file_t  fd  = NULL;
+        ssize_t           ret = 0;
+
+        fd = BM_TIMED (w, BM_FOP_OPEN, (__ret == NULL),
+                       glusterfs_glh_open (w->handle, path, O_RDONLY));
+        if (!fd) {
+                fprintf (stderr, "open (%s) => %s\n", path, strerror (errno));
+                return -1;
+        }
+
+        do {
+                ret = BM_TIMED (w, BM_FOP_READ, (__ret < 0),
+                                glusterfs_read (fd, block,
+                                                w->state->block_size));
+                if (ret > 0)
+                        w->bytes += ret;
+        } while (ret > 0);
+
+        if (ret < 0)
+                fprintf (stderr, "read (%s) => %s\n", path, strerror (errno));
+
+        BM_TIMED (w, BM_FOP_CLOSE, (__ret != 0), glusterfs_close (fd));
+
+        return (ret < 0) ? -1 : 0;
+}
+
+
+/* create, stat, read back and delete many files of one block each */
+static void
+bm_load_smallfile (struct worker *w, const char *dir, char *block)
+{
+        struct stat  stbuf = {0, };
+        char         path[1024];
+        long         i     = 0;
+
+        for (i = 0; i < w->state->count; i++) {
+                snprintf (path, sizeof (path), "%s/f.%06ld", dir, i);
+                if (bm_creat_write (w, path, block, w->state->block_size))
+                        break;
+        }
+
+        for (i = 0; i < w->state->count; i++) {
+                snprintf (path, sizeof (path), "%s/f.%06ld", dir, i);
+                BM_TIMED (w, BM_FOP_STAT, (__ret != 0),
+                          glusterfs_glh_stat (w->handle, path, &stbuf));
+        }
+
+        for (i = 0; i < w->state->count; i++) {
+                snprintf (path, sizeof (path), "%s/f.%06ld", dir, i);
+                bm_open_read (w, path, block);
+        }
+
+        for (i = 0; i < w->state->count; i++) {
+                snprintf (path, sizeof (path), "%s/f.%06ld", dir, i);
+                BM_TIMED (w, BM_FOP_UNLINK, (__ret != 0),
+                          glusterfs_glh_unlink (w->handle, path));
+        }
+}
+
+
+/* write one large file sequentially, read it back and delete it */
+static void
+bm_load_seqio (struct worker *w, const char *dir, char *block)
+{
+        char path[1024];
+
+        snprintf (path, sizeof (path), "%s/large", dir);
+
+        if (bm_creat_write (w, path, block, w->state->file_size) == 0)
+                bm_open_read (w, path, block);
+
+        BM_TIMED (w, BM_FOP_UNLINK, (__ret != 0),
+                  glusterfs_glh_unlink (w->handle, path));
+}
+
+
+/* namespace and attribute operations without data */
+static void
+bm_load_metadata (struct worker *w, const char *dir, char *block)
+{
+        glusterfs_file_t  fd    = NULL;
+        struct stat       stbuf = {0, };
+        char              path[1024];
+        char              sub[1000];
+        long              i     = 0;
+
+        for (i = 0; i < w->state->count; i++) {
+                snprintf (sub, sizeof (sub), "%s/d.%06ld", dir, i);
+                snprintf (path, sizeof (path), "%s/m", sub);
+
+                BM_TIMED (w, BM_FOP_MKDIR, (__ret != 0),
+                          glusterfs_glh_mkdir (w->handle, sub, 0755));
+
+                fd = BM_TIMED (w, BM_FOP_CREAT, (__ret == NULL),
+                               glusterfs_glh_creat (w->handle, path, 0600));
+                if (fd)
+                        BM_TIMED (w, BM_FOP_CLOSE, (__ret != 0),
+                                  glusterfs_close (fd));
+
+                BM_TIMED (w, BM_FOP_CHMOD, (__ret != 0),
+                          glusterfs_glh_chmod (w->handle, path, 0644));
+                BM_TIMED (w, BM_FOP_STAT, (__ret != 0),
+                          glusterfs_glh_stat (w->handle, path, &stbuf));
+                BM_TIMED (w, BM_FOP_SETXATTR, (__ret != 0),
+                          glusterfs_glh_setxattr (w->handle, path,
+                                                  "user.glfs-graph-bm",
+                                                  block, 16, 0));
+                BM_TIMED (w, BM_FOP_UNLINK, (__ret != 0),
+                          glusterfs_glh_unlink (w->handle, path));
+                BM_TIMED (w, BM_FOP_RMDIR, (__ret != 0),
+                          glusterfs_glh_rmdir (w->handle, sub));
+        }
+}
+
+
+static void *
+worker_run (void *data)
+{
+        struct worker *w     = data;
+        char          *block = NULL;
+        char           dir[1024];
+
+        block = malloc (w->state->block_size);
+        if (!block)
+                return NULL;
+        memset (block, 'g', w->state->block_size);
+
+        snprintf (dir, sizeof (dir), "%s/%s.%d", w->state->prefix,
+                  bm_load_names[w->load], w->id);
+        if (glusterfs_glh_mkdir (w->handle, dir, 0755) && (errno != EEXIST))
+                fprintf (stderr, "mkdir (%s) => %s\n", dir, strerror (errno));
+
+        pthread_barrier_wait (w->barrier);
+
+        switch (w->load) {
+        case BM_LOAD_SMALLFILE:
+                bm_load_smallfile (w, dir, block);
+                break;
+        case BM_LOAD_SEQIO:
+                bm_load_seqio (w, dir, block);
+                break;
+        case BM_LOAD_METADATA:
+                bm_load_metadata (w, dir, block);
+                break;
+        default:
+                break;
+        }
+
+        pthread_barrier_wait (w->barrier);
+
+        glusterfs_glh_rmdir (w->handle, dir);
+        free (block);
+
+        return NULL;
+}
+
+
+static int
+run_load (struct state *state, glusterfs_handle_t handle, bm_load_t load,
+          struct result *result)
+{
+        struct worker     *workers = NULL;
+        pthread_barrier_t  barrier;
+        uint64_t           start   = 0;
+        int                started = 0;
+        int                i       = 0;
+        int                f       = 0;
+
+        workers = calloc (state->threads, sizeof (*workers));
+        if (!workers)
+                return -1;
+
+        /* the workers and this thread, which takes the time */
+        pthread_barrier_init (&barrier, NULL, state->threads + 1);
+
+        for (i = 0; i < state->threads; i++) {
+                workers[i].id      = i;
+                workers[i].state   = state;
+                workers[i].handle  = handle;
+                workers[i].load    = load;
+                workers[i].barrier = &barrier;
+
+                if (pthread_create (&workers[i].thread, NULL, worker_run,
+                                    &workers[i]) != 0) {
+                        fprintf (stderr, "pthread_create () => %s\n",
+                                 strerror (errno));
+                        /* a barrier can not shrink, give up */
+                        exit (1);
+                }
+                started++;
+        }
+
+        pthread_barrier_wait (&barrier);
+        start = now_usec ();
+        pthread_barrier_wait (&barrier);
+        result->elapsed_usec = now_usec () - start;
+
+        for (i = 0; i < started; i++) {
+                pthread_join (workers[i].thread, NULL);
+
+                for (f = 0; f < BM_FOP_MAX; f++)
+                        hist_merge (&result->fops[f], &workers[i].fops[f]);
+                result->bytes += workers[i].bytes;
+        }
+
+        result->done = 1;
+
+        pthread_barrier_destroy (&barrier);
+        free (workers);
+
+        return 0;
+}
+
+
+static void
+print_result (const char *specfile, bm_load_t load, struct result *result)
+{
+        struct hist *hist  = NULL;
+        double       secs  = 0;
+        uint64_t     ops   = 0;
+        int          f     = 0;
+
+        secs = result->elapsed_usec / 1000000.0;
+        if (secs <= 0)
+                secs = 0.000001;
+
+        for (f = 0; f < BM_FOP_MAX; f++)
+                ops += result->fops[f].count;
+
+        fprintf (stdout, "%s: %s: time=%.3fs ops=%"PRIu64" ops/s=%.1f "
+                 "MB/s=%.2f\n", specfile, bm_load_names[load], secs, ops,
+                 ops / secs, (result->bytes / 1048576.0) / secs);
+
+        fprintf (stdout, "  %-10s %10s %8s %10s %8s %8s %8s %8s %8s\n",
+                 "fop", "count", "errors", "ops/s", "avg-us", "p50-us",
+                 "p90-us", "p99-us", "max-us");
+
+        for (f = 0; f < BM_FOP_MAX; f++) {
+                hist = &result->fops[f];
+                if (!hist->count)
+                        continue;
+
+                fprintf (stdout, "  %-10s %10"PRIu64" %8"PRIu64" %10.1f "
+                         "%8"PRIu64" %8"PRIu64" %8"PRIu64" %8"PRIu64" "
+                         "%8"PRIu64"\n", bm_fop_names[f], hist->count,
+                         hist->errors, hist->count / secs,
+                         hist->total_usec / hist->count,
+                         hist_percentile (hist, 50),
+                         hist_percentile (hist, 90),
+                         hist_percentile (hist, 99),
+                         hist->max_usec);
+        }
+}
+
+
+/* second volume file relative to the first one */
+static void
+print_comparison (struct state *state, bm_load_t load)
+{
+        struct result *base  = &state->results[0][load];
+        struct result *other = &state->results[1][load];
+        struct hist   *bh    = NULL;
+        struct hist   *oh    = NULL;
+        double         bsecs = 0;
+        double         osecs = 0;
+        int            f     = 0;
+
+        if (!base->done || !other->done)
+                return;
+
+        bsecs = base->elapsed_usec / 1000000.0;
+        osecs = other->elapsed_usec / 1000000.0;
+        if ((bsecs <= 0) || (osecs <= 0))
+                return;
+
+        fprintf (stdout, "%s: %s vs %s: time x%.2f\n", bm_load_names[load],
+                 state->specfiles[1], state->specfiles[0], osecs / bsecs);
+        fprintf (stdout, "  %-10s %10s %10s %10s\n", "fop", "ops/s",
+                 "p50-us", "p99-us");
+
+        for (f = 0; f < BM_FOP_MAX; f++) {
+                bh = &base->fops[f];
+                oh = &other->fops[f];
+                if (!bh->count || !oh->count)
+                        continue;
+
+                fprintf (stdout, "  %-10s %9.2fx %+10"PRId64" %+10"PRId64"\n",
+                         bm_fop_names[f],
+                         (oh->count / osecs) / (bh->count / bsecs),
+                         (int64_t) hist_percentile (oh, 50)
+                         - (int64_t) hist_percentile (bh, 50),
+                         (int64_t) hist_percentile (oh, 99)
+                         - (int64_t) hist_percentile (bh, 99));
+        }
+}
+
+
+static int
+run_specfile (struct state *state, int idx)
+{
+        glusterfs_init_params_t  params = {0, };
+        glusterfs_handle_t       handle = NULL;
+        int                      load   = 0;
+
+        params.logfile     = state->logfile;
+        params.loglevel    = state->loglevel;
+        params.specfile    = state->specfiles[idx];
+        params.volume_name = state->volume_name;
+
+        handle = glusterfs_init (&params, idx + 1);
+        if (!handle) {
+                fprintf (stderr, "glusterfs_init (%s) => %s\n",
+                         state->specfiles[idx], strerror (errno));
+                return -1;
+        }
+
+        if (glusterfs_glh_mkdir (handle, state->prefix, 0755)
+            && (errno != EEXIST)) {
+                fprintf (stderr, "mkdir (%s) => %s\n", state->prefix,
+                         strerror (errno));
+                glusterfs_fini (handle);
+                return -1;
+        }
+
+        for (load = 0; load < BM_LOAD_MAX; load++) {
+                if (!state->need_load[load])
+                        continue;
+
+                run_load (state, handle, load, &state->results[idx][load]);
+                print_result (state->specfiles[idx], load,
+                              &state->results[idx][load]);
+        }
+
+        glusterfs_glh_rmdir (handle, state->prefix);
+        glusterfs_fini (handle);
+
+        return 0;
+}
+
+
+static size_t
+parse_size (const char *arg)
+{
+        char   *end  = NULL;
+        size_t  size = 0;
+
+        size = strtoull (arg, &end, 10);
+        switch (*end) {
+        case 'k': case 'K':
+                size <<= 10;
+                break;
+        case 'm': case 'M':
+                size <<= 20;
+                break;
+        case 'g': case 'G':
+                size <<= 30;
+                break;
+        default:
+                break;
+        }
+
+        return size;
+}
+
+
+static error_t
+parse_opts (int key, char *arg,
+            struct argp_state *_state)
+{
+        struct state *state = _state->input;
+        int           load  = 0;
+
+        switch (key)
+        {
+        case 's':
+                if (state->specfile_count == BM_MAX_SPECFILES) {
+                        fprintf (stderr, "at most %d specfiles\n",
+                                 BM_MAX_SPECFILES);
+                        return -1;
+                }
+                state->specfiles[state->specfile_count++] = strdup (arg);
+                break;
+        case 'V':
+                state->volume_name = strdup (arg);
+                break;
+        case 'l':
+                state->logfile = strdup (arg);
+                break;
+        case 'L':
+                state->loglevel = strdup (arg);
+                break;
+        case 'w':
+                memset (state->need_load, 0, sizeof (state->need_load));
+                if (strcasecmp (arg, "all") == 0) {
+                        memset (state->need_load, 1,
+                                sizeof (state->need_load));
+                        break;
+                }
+                for (load = 0; load < BM_LOAD_MAX; load++) {
+                        if (strcasecmp (arg, bm_load_names[load]) == 0)
+                                state->need_load[load] = 1;
+                }
+                if (memchr (state->need_load, 1, BM_LOAD_MAX) == NULL) {
+                        fprintf (stderr, "unknown workload: %s\n", arg);
+                        return -1;
+                }
+                break;
+        case 't':
+                state->threads = atoi (arg);
+                if ((state->threads < 1)
+                    || (state->threads > BM_MAX_THREADS)) {
+                        fprintf (stderr, "incorrect thread count: %s\n", arg);
+                        return -1;
+                }
+                break;
+        case 'c':
+                state->count = atol (arg);
+                if (state->count < 1) {
+                        fprintf (stderr, "incorrect count: %s\n", arg);
+                        return -1;
+                }
+                break;
+        case 'b':
+                state->block_size = parse_size (arg);
+                if (!state->block_size) {
+                        fprintf (stderr, "incorrect size: %s\n", arg);
+                        return -1;
+                }
+                break;
+        case 'S':
+                state->file_size = parse_size (arg);
+                if (!state->file_size) {
+                        fprintf (stderr, "incorrect size: %s\n", arg);
+                        return -1;
+                }
+                break;
+        case 'p':
+                strncpy (state->prefix, arg, sizeof (state->prefix) - 1);
+                break;
+        case ARGP_KEY_END:
+                if (!state->specfile_count)
+                        argp_error (_state, "no specfile given");
+                break;
+        case ARGP_KEY_NO_ARGS:
+                break;
+        case ARGP_KEY_ARG:
+                break;
+        }
+
+        return 0;
+}
+
+static struct argp_option options[] = {
+        {"specfile", 's', "SPECFILE", 0,
+         "volume file to load, give twice to compare two graphs"},
+        {"volume-name", 'V', "VOLUME", 0,
+         "volume of the specfile to use - defaults to the top one"},
+        {"workload", 'w', "WORKLOAD", 0,
+         "SMALLFILE|SEQIO|METADATA|ALL - defaults to ALL"},
+        {"threads", 't', "THREADS", 0,
+         "<NUM> - defaults to 4"},
+        {"count", 'c', "COUNT", 0,
+         "files per thread - defaults to 1000"},
+        {"block", 'b', "BLOCKSIZE", 0,
+         "<SIZE> - defaults to 4k"},
+        {"file-size", 'S', "FILESIZE", 0,
+         "size of the seqio file of each thread - defaults to 64m"},
+        {"prefix", 'p', "PREFIX", 0,
+         "directory inside the volume - defaults to /glfs-graph-bm"},
+        {"log-file", 'l', "LOGFILE", 0,
+         "defaults to /dev/stderr"},
+        {"log-level", 'L', "LOGLEVEL", 0,
+         "defaults to WARNING"},
+        {0, 0, 0, 0, 0}
+};
+
+static struct argp argp = {
+        options,
+        parse_opts,
+        "",
+        "in-process benchmark of a translator graph"
+};
+
+int
+main (int argc, char *argv[])
+{
+        struct state  *state = NULL;
+        int            load  = 0;
+        int            i     = 0;
+
+        /* the results are too large for the stack */
+        state = calloc (1, sizeof (*state));
+        if (!state)
+                return 1;
+
+        memset (state->need_load, 1, sizeof (state->need_load));
+
+        state->threads    = 4;
+        state->count      = 1000;
+        state->block_size = 4096;
+        state->file_size  = 64 * 1048576;
+        state->logfile    = "/dev/stderr";
+        state->loglevel   = "WARNING";
+
+        strcpy (state->prefix, "/glfs-graph-bm");
+
+        if (argp_parse (&argp, argc, argv, 0, 0, state) != 0) {
+                fprintf (stderr, "argp_parse() failed\n");
+                return 1;
+        }
+
+        for (i = 0; i < state->specfile_count; i++) {
+                if (run_specfile (state, i) != 0)
+                        return 1;
+        }
+
+        if (state->specfile_count == BM_MAX_SPECFILES) {
+                for (load = 0; load < BM_LOAD_MAX; load++) {
+                        if (state->need_load[load])
+                                print_comparison (state, load);
+                }
+        }
+
+        return 0;
+}
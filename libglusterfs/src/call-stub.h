@@ -35,6 +35,7 @@ typedef struct {
 	call_frame_t *frame;
 	glusterfs_fop_t fop;
        struct mem_pool *stub_mem_pool;    /* pointer to stub mempool in glusterfs ctx */
+        struct timeval queued_at;         /* set by xlators which queue stubs */
 
 	union {
 		/* lookup */
@@ -581,6 +582,71 @@ typedef struct {
                         struct iatt statpost;
                 } fsetattr_cbk;
 
+                /* fallocate */
+                struct {
+                        fop_fallocate_t fn;
+                        fd_t *fd;
+                        int32_t keep_size;
+                        off_t offset;
+                        size_t len;
+                } fallocate;
+                struct {
+                        fop_fallocate_cbk_t fn;
+                        int32_t op_ret;
+                        int32_t op_errno;
+                        struct iatt statpre;
+                        struct iatt statpost;
+                } fallocate_cbk;
+
+                /* discard */
+                struct {
+                        fop_discard_t fn;
+                        fd_t *fd;
+                        off_t offset;
+                        size_t len;
+                } discard;
+                struct {
+                        fop_discard_cbk_t fn;
+                        int32_t op_ret;
+                        int32_t op_errno;
+                        struct iatt statpre;
+                        struct iatt statpost;
+                } discard_cbk;
+
+                /* zerofill */
+                struct {
+                        fop_zerofill_t fn;
+                        fd_t *fd;
+                        off_t offset;
+                        size_t len;
+                } zerofill;
+                struct {
+                        fop_zerofill_cbk_t fn;
+                        int32_t op_ret;
+                        int32_t op_errno;
+                        struct iatt statpre;
+                        struct iatt statpost;
+                } zerofill_cbk;
+
+                /* copy_file_range */
+                struct {
+                        fop_copy_file_range_t fn;
+                        fd_t *fd_in;
+                        off_t off_in;
+                        fd_t *fd_out;
+                        off_t off_out;
+                        size_t len;
+                        uint32_t flags;
+                } copy_file_range;
+                struct {
+                        fop_copy_file_range_cbk_t fn;
+                        int32_t op_ret;
+                        int32_t op_errno;
+                        struct iatt stbuf_in;
+                        struct iatt statpre;
+                        struct iatt statpost;
+                } copy_file_range_cbk;
+
 	} args;
 } call_stub_t;
 
@@ -1111,6 +1177,71 @@ fop_fsetattr_cbk_stub (call_frame_t *frame,
                        struct iatt *statpre,
                        struct iatt *statpost);
 
+call_stub_t *
+fop_fallocate_stub (call_frame_t *frame,
+                    fop_fallocate_t fn,
+                    fd_t *fd,
+                    int32_t keep_size,
+                    off_t offset,
+                    size_t len);
+
+call_stub_t *
+fop_fallocate_cbk_stub (call_frame_t *frame,
+                        fop_fallocate_cbk_t fn,
+                        int32_t op_ret,
+                        int32_t op_errno,
+                        struct iatt *statpre,
+                        struct iatt *statpost);
+
+call_stub_t *
+fop_discard_stub (call_frame_t *frame,
+                  fop_discard_t fn,
+                  fd_t *fd,
+                  off_t offset,
+                  size_t len);
+
+call_stub_t *
+fop_discard_cbk_stub (call_frame_t *frame,
+                      fop_discard_cbk_t fn,
+                      int32_t op_ret,
+                      int32_t op_errno,
+                      struct iatt *statpre,
+                      struct iatt *statpost);
+
+call_stub_t *
+fop_zerofill_stub (call_frame_t *frame,
+                   fop_zerofill_t fn,
+                   fd_t *fd,
+                   off_t offset,
+                   size_t len);
+
+call_stub_t *
+fop_zerofill_cbk_stub (call_frame_t *frame,
+                       fop_zerofill_cbk_t fn,
+                       int32_t op_ret,
+                       int32_t op_errno,
+                       struct iatt *statpre,
+                       struct iatt *statpost);
+
+call_stub_t *
+fop_copy_file_range_stub (call_frame_t *frame,
+                          fop_copy_file_range_t fn,
+                          fd_t *fd_in,
+                          off_t off_in,
+                          fd_t *fd_out,
+                          off_t off_out,
+                          size_t len,
+                          uint32_t flags);
+
+call_stub_t *
+fop_copy_file_range_cbk_stub (call_frame_t *frame,
+                              fop_copy_file_range_cbk_t fn,
+                              int32_t op_ret,
+                              int32_t op_errno,
+                              struct iatt *stbuf_in,
+                              struct iatt *statpre,
+                              struct iatt *statpost);
+
 void call_resume (call_stub_t *stub);
 void call_stub_destroy (call_stub_t *stub);
 #endif
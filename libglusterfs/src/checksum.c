@@ -18,6 +18,7 @@
 */
 
 #include <inttypes.h>
+#include <pthread.h>
 
 #include "glusterfs.h"
 #include "md5.h"
@@ -60,6 +61,26 @@ gf_rsync_weak_checksum (char *buf1, int32_t len)
 }
 
 
+/*
+ * Every byte adds itself to s1 and s1 to s2, so appending @second_len
+ * bytes to the first piece adds second_len times its s1 to s2. Only the
+ * low 16 bits of both are kept in the checksum.
+ */
+
+uint32_t
+gf_rsync_weak_checksum_combine (uint32_t first, uint32_t second,
+                                int32_t second_len)
+{
+        uint32_t s1 = 0;
+        uint32_t s2 = 0;
+
+        s1 = (first & 0xffff) + (second & 0xffff);
+        s2 = (first >> 16) + (second >> 16) + second_len * (first & 0xffff);
+
+        return (s1 & 0xffff) + (s2 << 16);
+}
+
+
 /*
  * The "strong" checksum required for the rsync algorithm,
  * adapted from the rsync source code.
@@ -76,3 +97,354 @@ gf_rsync_strong_checksum (char *buf, int32_t len, uint8_t *sum)
 
         return;
 }
+
+
+/*
+ * CRC32C (Castagnoli), which SSE 4.2 computes 8 bytes per instruction.
+ * Elsewhere it goes through tables, 8 bytes at a time as well
+ * ("slicing-by-8").
+ */
+
+static uint32_t crc32c_table[8][256];
+static pthread_once_t crc32c_once = PTHREAD_ONCE_INIT;
+
+static void
+crc32c_table_init (void)
+{
+        uint32_t crc = 0;
+        int      i   = 0;
+        int      j   = 0;
+
+        for (i = 0; i < 256; i++) {
+                crc = i;
+                for (j = 0; j < 8; j++)
+                        crc = (crc >> 1) ^ ((crc & 1) ? 0x82f63b78 : 0);
+                crc32c_table[0][i] = crc;
+        }
+
+        for (i = 0; i < 256; i++) {
+                crc = crc32c_table[0][i];
+                for (j = 1; j < 8; j++) {
+                        crc = crc32c_table[0][crc & 0xff] ^ (crc >> 8);
+                        crc32c_table[j][i] = crc;
+                }
+        }
+}
+
+static uint32_t
+crc32c_sw (uint32_t crc, const uint8_t *buf, size_t len)
+{
+        uint64_t word = 0;
+
+        while (len && ((uintptr_t) buf & 7)) {
+                crc = crc32c_table[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+                len--;
+        }
+
+        while (len >= 8) {
+                memcpy (&word, buf, 8);
+#if __BYTE_ORDER == __BIG_ENDIAN
+                word = __builtin_bswap64 (word);
+#endif
+                word ^= crc;
+                crc = crc32c_table[7][word & 0xff] ^
+                      crc32c_table[6][(word >> 8) & 0xff] ^
+                      crc32c_table[5][(word >> 16) & 0xff] ^
+                      crc32c_table[4][(word >> 24) & 0xff] ^
+                      crc32c_table[3][(word >> 32) & 0xff] ^
+                      crc32c_table[2][(word >> 40) & 0xff] ^
+                      crc32c_table[1][(word >> 48) & 0xff] ^
+                      crc32c_table[0][word >> 56];
+                buf += 8;
+                len -= 8;
+        }
+
+        while (len--)
+                crc = crc32c_table[0][(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+
+        return crc;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+static int crc32c_hw_usable;
+
+__attribute__ ((target ("sse4.2")))
+static uint32_t
+crc32c_hw (uint32_t crc, const uint8_t *buf, size_t len)
+{
+        uint64_t crc64 = crc;
+        uint64_t word  = 0;
+
+        while (len && ((uintptr_t) buf & 7)) {
+                crc64 = __builtin_ia32_crc32qi ((uint32_t) crc64, *buf++);
+                len--;
+        }
+
+        while (len >= 8) {
+                memcpy (&word, buf, 8);
+                crc64 = __builtin_ia32_crc32di (crc64, word);
+                buf += 8;
+                len -= 8;
+        }
+
+        while (len--)
+                crc64 = __builtin_ia32_crc32qi ((uint32_t) crc64, *buf++);
+
+        return (uint32_t) crc64;
+}
+#endif
+
+static void
+crc32c_init (void)
+{
+        crc32c_table_init ();
+#if defined(__x86_64__) && defined(__GNUC__)
+        __builtin_cpu_init ();
+        crc32c_hw_usable = __builtin_cpu_supports ("sse4.2");
+#endif
+}
+
+static uint32_t
+crc32c_update (uint32_t crc, const uint8_t *buf, size_t len)
+{
+        pthread_once (&crc32c_once, crc32c_init);
+
+#if defined(__x86_64__) && defined(__GNUC__)
+        if (crc32c_hw_usable)
+                return crc32c_hw (crc, buf, len);
+#endif
+        return crc32c_sw (crc, buf, len);
+}
+
+
+/*
+ * xxHash64 (Yann Collet), taking 32 bytes per round in four independent
+ * lanes which the compiler keeps in registers.
+ */
+
+#define XXH_PRIME64_1 0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3 0x165667B19E3779F9ULL
+#define XXH_PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5 0x27D4EB2F165667C5ULL
+
+#define XXH_ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+static inline uint64_t
+xxh64_read64 (const uint8_t *p)
+{
+        uint64_t v = 0;
+
+        memcpy (&v, p, 8);
+#if __BYTE_ORDER == __BIG_ENDIAN
+        v = __builtin_bswap64 (v);
+#endif
+        return v;
+}
+
+static inline uint32_t
+xxh64_read32 (const uint8_t *p)
+{
+        uint32_t v = 0;
+
+        memcpy (&v, p, 4);
+#if __BYTE_ORDER == __BIG_ENDIAN
+        v = __builtin_bswap32 (v);
+#endif
+        return v;
+}
+
+static inline uint64_t
+xxh64_round (uint64_t acc, uint64_t input)
+{
+        acc += input * XXH_PRIME64_2;
+        acc  = XXH_ROTL64 (acc, 31);
+        acc *= XXH_PRIME64_1;
+        return acc;
+}
+
+static inline uint64_t
+xxh64_merge_round (uint64_t acc, uint64_t val)
+{
+        acc ^= xxh64_round (0, val);
+        acc  = acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+        return acc;
+}
+
+static void
+xxh64_reset (gf_checksum_ctx_t *ctx)
+{
+        ctx->u.xxh64.total_len = 0;
+        ctx->u.xxh64.memsize   = 0;
+        ctx->u.xxh64.v[0] = XXH_PRIME64_1 + XXH_PRIME64_2;
+        ctx->u.xxh64.v[1] = XXH_PRIME64_2;
+        ctx->u.xxh64.v[2] = 0;
+        ctx->u.xxh64.v[3] = -XXH_PRIME64_1;
+}
+
+static void
+xxh64_update (gf_checksum_ctx_t *ctx, const uint8_t *p, size_t len)
+{
+        uint64_t       *v   = ctx->u.xxh64.v;
+        const uint8_t  *end = p + len;
+        size_t          fill = 0;
+
+        ctx->u.xxh64.total_len += len;
+
+        if (ctx->u.xxh64.memsize + len < 32) {
+                memcpy (ctx->u.xxh64.mem + ctx->u.xxh64.memsize, p, len);
+                ctx->u.xxh64.memsize += len;
+                return;
+        }
+
+        if (ctx->u.xxh64.memsize) {
+                fill = 32 - ctx->u.xxh64.memsize;
+                memcpy (ctx->u.xxh64.mem + ctx->u.xxh64.memsize, p, fill);
+                v[0] = xxh64_round (v[0], xxh64_read64 (ctx->u.xxh64.mem));
+                v[1] = xxh64_round (v[1], xxh64_read64 (ctx->u.xxh64.mem + 8));
+                v[2] = xxh64_round (v[2], xxh64_read64 (ctx->u.xxh64.mem + 16));
+                v[3] = xxh64_round (v[3], xxh64_read64 (ctx->u.xxh64.mem + 24));
+                p += fill;
+                ctx->u.xxh64.memsize = 0;
+        }
+
+        while (p + 32 <= end) {
+                v[0] = xxh64_round (v[0], xxh64_read64 (p));
+                v[1] = xxh64_round (v[1], xxh64_read64 (p + 8));
+                v[2] = xxh64_round (v[2], xxh64_read64 (p + 16));
+                v[3] = xxh64_round (v[3], xxh64_read64 (p + 24));
+                p += 32;
+        }
+
+        if (p < end) {
+                memcpy (ctx->u.xxh64.mem, p, end - p);
+                ctx->u.xxh64.memsize = end - p;
+        }
+}
+
+static uint64_t
+xxh64_digest (gf_checksum_ctx_t *ctx)
+{
+        uint64_t       *v   = ctx->u.xxh64.v;
+        const uint8_t  *p   = ctx->u.xxh64.mem;
+        const uint8_t  *end = p + ctx->u.xxh64.memsize;
+        uint64_t        h   = 0;
+
+        if (ctx->u.xxh64.total_len >= 32) {
+                h = XXH_ROTL64 (v[0], 1) + XXH_ROTL64 (v[1], 7) +
+                    XXH_ROTL64 (v[2], 12) + XXH_ROTL64 (v[3], 18);
+                h = xxh64_merge_round (h, v[0]);
+                h = xxh64_merge_round (h, v[1]);
+                h = xxh64_merge_round (h, v[2]);
+                h = xxh64_merge_round (h, v[3]);
+        } else {
+                h = v[2] + XXH_PRIME64_5;
+        }
+
+        h += ctx->u.xxh64.total_len;
+
+        while (p + 8 <= end) {
+                h ^= xxh64_round (0, xxh64_read64 (p));
+                h  = XXH_ROTL64 (h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+                p += 8;
+        }
+
+        if (p + 4 <= end) {
+                h ^= (uint64_t) xxh64_read32 (p) * XXH_PRIME64_1;
+                h  = XXH_ROTL64 (h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+                p += 4;
+        }
+
+        while (p < end) {
+                h ^= (*p++) * XXH_PRIME64_5;
+                h  = XXH_ROTL64 (h, 11) * XXH_PRIME64_1;
+        }
+
+        h ^= h >> 33;
+        h *= XXH_PRIME64_2;
+        h ^= h >> 29;
+        h *= XXH_PRIME64_3;
+        h ^= h >> 32;
+
+        return h;
+}
+
+
+int
+gf_checksum_type_from_str (const char *str, gf_checksum_type_t *type)
+{
+        if (!strcmp (str, "md5"))
+                *type = GF_CHECKSUM_MD5;
+        else if (!strcmp (str, "crc32c"))
+                *type = GF_CHECKSUM_CRC32C;
+        else if (!strcmp (str, "xxhash64"))
+                *type = GF_CHECKSUM_XXHASH64;
+        else
+                return -1;
+
+        return 0;
+}
+
+
+void
+gf_checksum_init (gf_checksum_ctx_t *ctx, gf_checksum_type_t type)
+{
+        ctx->type = type;
+
+        switch (type) {
+        case GF_CHECKSUM_CRC32C:
+                ctx->u.crc32c = 0xffffffff;
+                break;
+        case GF_CHECKSUM_XXHASH64:
+                xxh64_reset (ctx);
+                break;
+        default:
+                md5_begin (&ctx->u.md5);
+                break;
+        }
+}
+
+
+void
+gf_checksum_update (gf_checksum_ctx_t *ctx, const char *buf, int32_t len)
+{
+        switch (ctx->type) {
+        case GF_CHECKSUM_CRC32C:
+                ctx->u.crc32c = crc32c_update (ctx->u.crc32c,
+                                               (const uint8_t *) buf, len);
+                break;
+        case GF_CHECKSUM_XXHASH64:
+                xxh64_update (ctx, (const uint8_t *) buf, len);
+                break;
+        default:
+                md5_update (&ctx->u.md5, (const uint8_t *) buf, len);
+                break;
+        }
+}
+
+
+void
+gf_checksum_final (gf_checksum_ctx_t *ctx, uint8_t *sum)
+{
+        uint64_t h = 0;
+        int      i = 0;
+
+        memset (sum, 0, MD5_DIGEST_LEN);
+
+        /* big endian, as MD5 sums compare */
+        switch (ctx->type) {
+        case GF_CHECKSUM_CRC32C:
+                h = (uint32_t) ~ctx->u.crc32c;
+                for (i = 0; i < 4; i++)
+                        sum[i] = (h >> (24 - 8 * i)) & 0xff;
+                break;
+        case GF_CHECKSUM_XXHASH64:
+                h = xxh64_digest (ctx);
+                for (i = 0; i < 8; i++)
+                        sum[i] = (h >> (56 - 8 * i)) & 0xff;
+                break;
+        default:
+                md5_result (&ctx->u.md5, sum);
+                break;
+        }
+}
@@ -20,8 +20,45 @@
 #ifndef __CHECKSUM_H__
 #define __CHECKSUM_H__
 
+#include "md5.h"
+
+typedef enum {
+        GF_CHECKSUM_MD5,
+        GF_CHECKSUM_CRC32C,     /* hardware assisted where available */
+        GF_CHECKSUM_XXHASH64,
+} gf_checksum_type_t;
+
+/* strong checksum computed over data given in pieces; whatever the type
+   the result takes MD5_DIGEST_LEN bytes, zero padded */
+typedef struct {
+        gf_checksum_type_t type;
+        union {
+                md_context md5;
+                uint32_t   crc32c;
+                struct {
+                        uint64_t total_len;
+                        uint64_t v[4];
+                        uint8_t  mem[32];
+                        uint32_t memsize;
+                } xxh64;
+        } u;
+} gf_checksum_ctx_t;
+
 uint32_t gf_rsync_weak_checksum (char *buf, int32_t len);
 
+/* weak checksum of two adjacent pieces of data, from theirs */
+uint32_t gf_rsync_weak_checksum_combine (uint32_t first, uint32_t second,
+                                         int32_t second_len);
+
 void gf_rsync_strong_checksum (char *buf, int32_t len, uint8_t *sum);
 
+int gf_checksum_type_from_str (const char *str, gf_checksum_type_t *type);
+
+void gf_checksum_init (gf_checksum_ctx_t *ctx, gf_checksum_type_t type);
+
+void gf_checksum_update (gf_checksum_ctx_t *ctx, const char *buf,
+                         int32_t len);
+
+void gf_checksum_final (gf_checksum_ctx_t *ctx, uint8_t *sum);
+
 #endif /* __CHECKSUM_H__ */
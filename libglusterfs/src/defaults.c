@@ -417,6 +417,44 @@ default_fsetattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         return 0;
 }
 
+int32_t
+default_fallocate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                       int32_t op_ret, int32_t op_errno, struct iatt *pre,
+                       struct iatt *post)
+{
+        STACK_UNWIND_STRICT (fallocate, frame, op_ret, op_errno, pre, post);
+        return 0;
+}
+
+int32_t
+default_discard_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                     int32_t op_ret, int32_t op_errno, struct iatt *pre,
+                     struct iatt *post)
+{
+        STACK_UNWIND_STRICT (discard, frame, op_ret, op_errno, pre, post);
+        return 0;
+}
+
+int32_t
+default_zerofill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                      int32_t op_ret, int32_t op_errno, struct iatt *pre,
+                      struct iatt *post)
+{
+        STACK_UNWIND_STRICT (zerofill, frame, op_ret, op_errno, pre, post);
+        return 0;
+}
+
+int32_t
+default_copy_file_range_cbk (call_frame_t *frame, void *cookie,
+                             xlator_t *this, int32_t op_ret, int32_t op_errno,
+                             struct iatt *stbuf_in, struct iatt *pre,
+                             struct iatt *post)
+{
+        STACK_UNWIND_STRICT (copy_file_range, frame, op_ret, op_errno,
+                             stbuf_in, pre, post);
+        return 0;
+}
+
 int32_t
 default_getspec_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                      int32_t op_ret, int32_t op_errno, char *spec_data)
@@ -801,6 +839,45 @@ default_fsetattr_resume (call_frame_t *frame, xlator_t *this, fd_t *fd,
         return 0;
 }
 
+int32_t
+default_fallocate_resume (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                          int32_t keep_size, off_t offset, size_t len)
+{
+        STACK_WIND (frame, default_fallocate_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fallocate, fd, keep_size,
+                    offset, len);
+        return 0;
+}
+
+int32_t
+default_discard_resume (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                        off_t offset, size_t len)
+{
+        STACK_WIND (frame, default_discard_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->discard, fd, offset, len);
+        return 0;
+}
+
+int32_t
+default_zerofill_resume (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                         off_t offset, size_t len)
+{
+        STACK_WIND (frame, default_zerofill_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->zerofill, fd, offset, len);
+        return 0;
+}
+
+int32_t
+default_copy_file_range_resume (call_frame_t *frame, xlator_t *this,
+                                fd_t *fd_in, off_t off_in, fd_t *fd_out,
+                                off_t off_out, size_t len, uint32_t flags)
+{
+        STACK_WIND (frame, default_copy_file_range_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags);
+        return 0;
+}
+
 /* FOPS */
 
 int32_t
@@ -1167,6 +1244,45 @@ default_fsetattr (call_frame_t *frame, xlator_t *this, fd_t *fd,
         return 0;
 }
 
+int32_t
+default_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                   int32_t keep_size, off_t offset, size_t len)
+{
+        STACK_WIND (frame, default_fallocate_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fallocate, fd, keep_size,
+                    offset, len);
+        return 0;
+}
+
+int32_t
+default_discard (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                 off_t offset, size_t len)
+{
+        STACK_WIND (frame, default_discard_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->discard, fd, offset, len);
+        return 0;
+}
+
+int32_t
+default_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                  off_t offset, size_t len)
+{
+        STACK_WIND (frame, default_zerofill_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->zerofill, fd, offset, len);
+        return 0;
+}
+
+int32_t
+default_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                         off_t off_in, fd_t *fd_out, off_t off_out,
+                         size_t len, uint32_t flags)
+{
+        STACK_WIND (frame, default_copy_file_range_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags);
+        return 0;
+}
+
 
 int32_t
 default_forget (xlator_t *this, inode_t *inode)
@@ -1235,6 +1351,22 @@ default_notify (xlator_t *this, int32_t event, void *data, ...)
                 }
         }
         break;
+        case GF_EVENT_UPCALL:
+        {
+                /* data is the struct gf_upcall, pass it up unchanged */
+                xlator_list_t *parent = this->parents;
+
+                if (!parent && this->ctx && this->ctx->master)
+                        xlator_notify (this->ctx->master, event, data, NULL);
+
+                while (parent) {
+                        if (parent->xlator->init_succeeded)
+                                xlator_notify (parent->xlator, event,
+                                               data, NULL);
+                        parent = parent->next;
+                }
+        }
+        break;
         default:
         {
                 xlator_list_t *parent = this->parents;
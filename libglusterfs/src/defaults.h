@@ -246,6 +246,34 @@ int32_t default_fsetattr (call_frame_t *frame,
                           struct iatt *stbuf,
                           int32_t valid);
 
+int32_t default_fallocate (call_frame_t *frame,
+                           xlator_t *this,
+                           fd_t *fd,
+                           int32_t keep_size,
+                           off_t offset,
+                           size_t len);
+
+int32_t default_discard (call_frame_t *frame,
+                         xlator_t *this,
+                         fd_t *fd,
+                         off_t offset,
+                         size_t len);
+
+int32_t default_zerofill (call_frame_t *frame,
+                          xlator_t *this,
+                          fd_t *fd,
+                          off_t offset,
+                          size_t len);
+
+int32_t default_copy_file_range (call_frame_t *frame,
+                                 xlator_t *this,
+                                 fd_t *fd_in,
+                                 off_t off_in,
+                                 fd_t *fd_out,
+                                 off_t off_out,
+                                 size_t len,
+                                 uint32_t flags);
+
 /* Resume */
 int32_t default_getspec (call_frame_t *frame,
                          xlator_t *this,
@@ -464,6 +492,34 @@ int32_t default_fsetattr_resume (call_frame_t *frame,
                           struct iatt *stbuf,
                           int32_t valid);
 
+int32_t default_fallocate_resume (call_frame_t *frame,
+                                  xlator_t *this,
+                                  fd_t *fd,
+                                  int32_t keep_size,
+                                  off_t offset,
+                                  size_t len);
+
+int32_t default_discard_resume (call_frame_t *frame,
+                                xlator_t *this,
+                                fd_t *fd,
+                                off_t offset,
+                                size_t len);
+
+int32_t default_zerofill_resume (call_frame_t *frame,
+                                 xlator_t *this,
+                                 fd_t *fd,
+                                 off_t offset,
+                                 size_t len);
+
+int32_t default_copy_file_range_resume (call_frame_t *frame,
+                                        xlator_t *this,
+                                        fd_t *fd_in,
+                                        off_t off_in,
+                                        fd_t *fd_out,
+                                        off_t off_out,
+                                        size_t len,
+                                        uint32_t flags);
+
 /* _cbk */
 
 int32_t
@@ -674,6 +730,27 @@ int32_t
 default_getspec_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                      int32_t op_ret, int32_t op_errno, char *spec_data);
 
+int32_t
+default_fallocate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                       int32_t op_ret, int32_t op_errno, struct iatt *pre,
+                       struct iatt *post);
+
+int32_t
+default_discard_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                     int32_t op_ret, int32_t op_errno, struct iatt *pre,
+                     struct iatt *post);
+
+int32_t
+default_zerofill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                      int32_t op_ret, int32_t op_errno, struct iatt *pre,
+                      struct iatt *post);
+
+int32_t
+default_copy_file_range_cbk (call_frame_t *frame, void *cookie,
+                             xlator_t *this, int32_t op_ret, int32_t op_errno,
+                             struct iatt *stbuf_in, struct iatt *pre,
+                             struct iatt *post);
+
 int32_t
 default_mem_acct_init (xlator_t *this);
 
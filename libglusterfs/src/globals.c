@@ -84,6 +84,10 @@ gf_op_list_init()
         gf_fop_list[GF_FOP_FORGET]      = "FORGET";
         gf_fop_list[GF_FOP_RELEASE]     = "RELEASE";
         gf_fop_list[GF_FOP_RELEASEDIR]  = "RELEASEDIR";
+        gf_fop_list[GF_FOP_FALLOCATE]   = "FALLOCATE";
+        gf_fop_list[GF_FOP_DISCARD]     = "DISCARD";
+        gf_fop_list[GF_FOP_ZEROFILL]    = "ZEROFILL";
+        gf_fop_list[GF_FOP_COPY_FILE_RANGE] = "COPY_FILE_RANGE";
 
         gf_fop_list[GF_MGMT_NULL]  = "NULL";
         return;
@@ -352,6 +356,7 @@ char eventstring[GF_EVENT_MAXVAL+1][64] = {
         "New Volfile",
         "Translator Info",
         "Trigger Volume Heal",
+        "Upcall",
         "Invalid event",
 };
 
@@ -84,10 +84,29 @@
 #define GF_XATTR_LINKINFO_KEY   "trusted.distribute.linkinfo"
 #define GFID_XATTR_KEY "trusted.gfid"
 
+/* gfid under which features/index serves the directory of the files
+   whose changelog is dirty */
+#define GF_XATTROP_INDEX_GFID   "glusterfs.xattrop_index_gfid"
+
 #define ZR_FILE_CONTENT_STR     "glusterfs.file."
 #define ZR_FILE_CONTENT_STRLEN 15
 
 #define GLUSTERFS_OPEN_FD_COUNT "glusterfs.open-fd-count"
+
+/* setxattr of GF_XATTR_RMTREE_KEY on a directory removes it with all that
+   is below it; every brick moves its copy aside and deletes it in the
+   background. getxattr of GF_XATTR_RMTREE_STATUS_KEY tells how far that
+   got, as "pending=<trees> removed=<entries>". Unless root, the caller
+   must be allowed to remove the directory from its parent and own it;
+   what is below it is removed whoever owns it. */
+#define GF_XATTR_RMTREE_KEY        "glusterfs.rmtree"
+#define GF_XATTR_RMTREE_STATUS_KEY "glusterfs.rmtree-status"
+
+/* fgetxattr of the data extents of a file, as pairs of 64 bit offset and
+   length in network byte order. The extents beyond the first
+   GF_DATA_EXTENTS_MAX are reported as one, running to the end of file */
+#define GF_XATTR_DATA_EXTENTS_KEY "glusterfs.data-extents"
+#define GF_DATA_EXTENTS_MAX     1024
 #define GLUSTERFS_INODELK_COUNT "glusterfs.inodelk-count"
 #define GLUSTERFS_ENTRYLK_COUNT "glusterfs.entrylk-count"
 #define GLUSTERFS_POSIXLK_COUNT "glusterfs.posixlk-count"
@@ -161,6 +180,10 @@ typedef enum {
         GF_FOP_RELEASE,
         GF_FOP_RELEASEDIR,
         GF_FOP_GETSPEC,
+        GF_FOP_FALLOCATE,
+        GF_FOP_DISCARD,
+        GF_FOP_ZEROFILL,
+        GF_FOP_COPY_FILE_RANGE,
         GF_FOP_MAXVALUE,
 } glusterfs_fop_t;
 
@@ -382,6 +405,7 @@ typedef enum {
         GF_EVENT_GRAPH_NEW,
         GF_EVENT_TRANSLATOR_INFO,
         GF_EVENT_TRIGGER_HEAL,
+        GF_EVENT_UPCALL,
         GF_EVENT_MAXVAL,
 } glusterfs_event_t;
 
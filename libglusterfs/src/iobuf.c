@@ -739,6 +739,11 @@ iobref_destroy (struct iobref *iobref)
                         iobuf_unref (iobuf);
         }
 
+        if (iobref->file) {
+                close (iobref->file->fd);
+                GF_FREE (iobref->file);
+        }
+
         GF_FREE (iobref);
 
 out:
@@ -831,6 +836,11 @@ iobref_merge (struct iobref *to, struct iobref *from)
                         if (ret < 0)
                                 break;
                 }
+
+                if (from->file && !to->file)
+                        ret = iobref_add_file (to, from->file->fd,
+                                               from->file->offset,
+                                               from->file->size);
         }
         UNLOCK (&from->lock);
 
@@ -839,6 +849,102 @@ out:
 }
 
 
+int
+iobref_add_file (struct iobref *iobref, int fd, off_t offset, size_t size)
+{
+        struct iobref_file *file = NULL;
+        int                 ret  = -EINVAL;
+
+        GF_VALIDATE_OR_GOTO ("iobuf", iobref, out);
+
+        file = GF_CALLOC (1, sizeof (*file), gf_common_mt_iobref_file);
+        if (!file) {
+                ret = -ENOMEM;
+                goto out;
+        }
+
+        file->fd = dup (fd);
+        if (file->fd == -1) {
+                ret = -errno;
+                GF_FREE (file);
+                goto out;
+        }
+        file->offset = offset;
+        file->size   = size;
+
+        LOCK (&iobref->lock);
+        {
+                if (!iobref->file) {
+                        iobref->file = file;
+                        file = NULL;
+                        ret = 0;
+                }
+        }
+        UNLOCK (&iobref->lock);
+
+        if (file) {
+                /* one region per iobref */
+                close (file->fd);
+                GF_FREE (file);
+        }
+out:
+        return ret;
+}
+
+
+/* reads the file region of iobref in an iobuf, which the NULL entry of
+   vector is then pointed at */
+int
+iobref_file_read (struct iobref *iobref, struct iobuf_pool *iobuf_pool,
+                  struct iovec *vector, int count)
+{
+        struct iobuf *iobuf = NULL;
+        ssize_t       size  = 0;
+        int           i     = 0;
+        int           ret   = -EINVAL;
+
+        GF_VALIDATE_OR_GOTO ("iobuf", iobref, out);
+
+        if (!iobref->file)
+                return 0;
+
+        for (i = 0; i < count; i++) {
+                if (!vector[i].iov_base)
+                        break;
+        }
+        if (i == count)
+                return 0;
+
+        iobuf = iobuf_get2 (iobuf_pool, vector[i].iov_len);
+        if (!iobuf) {
+                ret = -ENOMEM;
+                goto out;
+        }
+
+        size = pread (iobref->file->fd, iobuf->ptr, vector[i].iov_len,
+                      iobref->file->offset);
+        if (size == -1) {
+                ret = -errno;
+                goto out;
+        }
+
+        /* the file got shorter, the reply keeps the size it announced */
+        if (size < vector[i].iov_len)
+                memset (iobuf->ptr + size, 0, vector[i].iov_len - size);
+
+        ret = iobref_add (iobref, iobuf);
+        if (ret)
+                goto out;
+
+        vector[i].iov_base = iobuf->ptr;
+out:
+        if (iobuf)
+                iobuf_unref (iobuf);
+
+        return ret;
+}
+
+
 size_t
 iobuf_size (struct iobuf *iobuf)
 {
@@ -144,10 +144,21 @@ void iobuf_to_iovec(struct iobuf *iob, struct iovec *iov);
 #define iobuf_pagesize(iob) (iob->iobuf_arena->page_size)
 
 
+/* a region of a file, which stands for the iov_len bytes of the one
+   entry with a NULL iov_base in the vector going with the iobref. The
+   transports which can send it straight from the file do, for the others
+   it is read in memory by iobref_file_read(). */
+struct iobref_file {
+        int                fd;     /* a dup, closed along with the iobref */
+        off_t              offset;
+        size_t             size;
+};
+
 struct iobref {
-        gf_lock_t          lock;
-        int                ref;
-        struct iobuf      *iobrefs[GF_IOBREF_IOBUF_COUNT];
+        gf_lock_t           lock;
+        int                 ref;
+        struct iobuf       *iobrefs[GF_IOBREF_IOBUF_COUNT];
+        struct iobref_file *file;
 };
 
 struct iobref *iobref_new ();
@@ -155,6 +166,9 @@ struct iobref *iobref_ref (struct iobref *iobref);
 void iobref_unref (struct iobref *iobref);
 int iobref_add (struct iobref *iobref, struct iobuf *iobuf);
 int iobref_merge (struct iobref *to, struct iobref *from);
+int iobref_add_file (struct iobref *iobref, int fd, off_t offset, size_t size);
+int iobref_file_read (struct iobref *iobref, struct iobuf_pool *iobuf_pool,
+                      struct iovec *vector, int count);
 
 
 size_t iobuf_size (struct iobuf *iobuf);
@@ -106,6 +106,8 @@ enum gf_common_mem_types_ {
         gf_common_mt_trie_end             = 81,
         gf_common_mt_run_argv             = 82,
         gf_common_mt_run_logbuf           = 83,
-        gf_common_mt_end                  = 84
+        gf_common_mt_iobref_file          = 84,
+        gf_common_mt_libxl_copy_stream    = 85,
+        gf_common_mt_end                  = 86
 };
 #endif
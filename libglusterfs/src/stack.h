@@ -101,6 +101,9 @@ struct _call_stack_t {
         call_pool_t                  *pool;
         gf_lock_t                     stack_lock;
         void                         *trans;
+        char                         *client_uid; /* brick side: id of
+                                                     the connection of
+                                                     trans */
         uint64_t                      unique;
         void                         *state;  /* pointer to request state */
         uid_t                         uid;
@@ -367,6 +370,7 @@ copy_frame (call_frame_t *frame)
         newstack->frames.root = newstack;
         newstack->pool = oldstack->pool;
         newstack->lk_owner = oldstack->lk_owner;
+        newstack->client_uid = oldstack->client_uid;
 
         LOCK_INIT (&newstack->frames.lock);
         LOCK_INIT (&newstack->stack_lock);
@@ -1099,3 +1099,43 @@ syncop_mknod (xlator_t *subvol, loc_t *loc, mode_t mode, dev_t rdev,
         return args.op_ret;
 
 }
+
+int
+syncop_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                            int32_t op_ret, int32_t op_errno,
+                            struct iatt *stbuf_in, struct iatt *prebuf,
+                            struct iatt *postbuf)
+{
+        struct syncargs *args = NULL;
+
+        args = cookie;
+
+        args->op_ret   = op_ret;
+        args->op_errno = op_errno;
+        if (op_ret >= 0)
+                args->iatt1 = *postbuf;
+
+        __wake (args);
+
+        return 0;
+}
+
+/* copies up to len bytes at off_in of fd_in to off_out of fd_out, on
+   the servers when the translators below can; returns the bytes copied */
+int
+syncop_copy_file_range (xlator_t *subvol, fd_t *fd_in, off_t off_in,
+                        fd_t *fd_out, off_t off_out, size_t len,
+                        uint32_t flags, struct iatt *postbuf)
+{
+        struct syncargs args = {0, };
+
+        SYNCOP (subvol, (&args), syncop_copy_file_range_cbk,
+                subvol->fops->copy_file_range, fd_in, off_in, fd_out,
+                off_out, len, flags);
+
+        if (postbuf)
+                *postbuf = args.iatt1;
+
+        errno = args.op_errno;
+        return args.op_ret;
+}
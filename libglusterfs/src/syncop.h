@@ -213,4 +213,8 @@ int syncop_readlink (xlator_t *subvol, loc_t *loc, char **buffer, size_t size);
 int syncop_mknod (xlator_t *subvol, loc_t *loc, mode_t mode, dev_t rdev,
                   dict_t *dict);
 
+int syncop_copy_file_range (xlator_t *subvol, fd_t *fd_in, off_t off_in,
+                            fd_t *fd_out, off_t off_out, size_t len,
+                            uint32_t flags, struct iatt *postbuf);
+
 #endif /* _SYNCOP_H */
@@ -419,6 +419,39 @@ typedef int32_t (*fop_fsetattr_cbk_t) (call_frame_t *frame,
                                        struct iatt *preop_stbuf,
                                        struct iatt *postop_stbuf);
 
+typedef int32_t (*fop_fallocate_cbk_t) (call_frame_t *frame,
+                                        void *cookie,
+                                        xlator_t *this,
+                                        int32_t op_ret,
+                                        int32_t op_errno,
+                                        struct iatt *preop_stbuf,
+                                        struct iatt *postop_stbuf);
+
+typedef int32_t (*fop_discard_cbk_t) (call_frame_t *frame,
+                                      void *cookie,
+                                      xlator_t *this,
+                                      int32_t op_ret,
+                                      int32_t op_errno,
+                                      struct iatt *preop_stbuf,
+                                      struct iatt *postop_stbuf);
+
+typedef int32_t (*fop_zerofill_cbk_t) (call_frame_t *frame,
+                                       void *cookie,
+                                       xlator_t *this,
+                                       int32_t op_ret,
+                                       int32_t op_errno,
+                                       struct iatt *preop_stbuf,
+                                       struct iatt *postop_stbuf);
+
+typedef int32_t (*fop_copy_file_range_cbk_t) (call_frame_t *frame,
+                                              void *cookie,
+                                              xlator_t *this,
+                                              int32_t op_ret,
+                                              int32_t op_errno,
+                                              struct iatt *stbuf_in,
+                                              struct iatt *preop_stbuf,
+                                              struct iatt *postop_stbuf);
+
 typedef int32_t (*fop_lookup_t) (call_frame_t *frame,
                                  xlator_t *this,
                                  loc_t *loc,
@@ -632,6 +665,34 @@ typedef int32_t (*fop_fsetattr_t) (call_frame_t *frame,
                                    struct iatt *stbuf,
                                    int32_t valid);
 
+typedef int32_t (*fop_fallocate_t) (call_frame_t *frame,
+                                    xlator_t *this,
+                                    fd_t *fd,
+                                    int32_t keep_size,
+                                    off_t offset,
+                                    size_t len);
+
+typedef int32_t (*fop_discard_t) (call_frame_t *frame,
+                                  xlator_t *this,
+                                  fd_t *fd,
+                                  off_t offset,
+                                  size_t len);
+
+typedef int32_t (*fop_zerofill_t) (call_frame_t *frame,
+                                   xlator_t *this,
+                                   fd_t *fd,
+                                   off_t offset,
+                                   size_t len);
+
+typedef int32_t (*fop_copy_file_range_t) (call_frame_t *frame,
+                                          xlator_t *this,
+                                          fd_t *fd_in,
+                                          off_t off_in,
+                                          fd_t *fd_out,
+                                          off_t off_out,
+                                          size_t len,
+                                          uint32_t flags);
+
 
 struct xlator_fops {
         fop_lookup_t         lookup;
@@ -675,6 +736,10 @@ struct xlator_fops {
         fop_setattr_t        setattr;
         fop_fsetattr_t       fsetattr;
         fop_getspec_t        getspec;
+        fop_fallocate_t      fallocate;
+        fop_discard_t        discard;
+        fop_zerofill_t       zerofill;
+        fop_copy_file_range_t copy_file_range;
 
         /* these entries are used for a typechecking hack in STACK_WIND _only_ */
         fop_lookup_cbk_t         lookup_cbk;
@@ -718,6 +783,10 @@ struct xlator_fops {
         fop_setattr_cbk_t        setattr_cbk;
         fop_fsetattr_cbk_t       fsetattr_cbk;
         fop_getspec_cbk_t        getspec_cbk;
+        fop_fallocate_cbk_t      fallocate_cbk;
+        fop_discard_cbk_t        discard_cbk;
+        fop_zerofill_cbk_t       zerofill_cbk;
+        fop_copy_file_range_cbk_t copy_file_range_cbk;
 };
 
 typedef int32_t (*cbk_forget_t) (xlator_t *this,
@@ -750,6 +819,23 @@ struct xlator_dumpops {
         dumpop_fdctx_t           fdctx;
 };
 
+/* what changed on an inode, carried by GF_EVENT_UPCALL */
+#define GF_UPCALL_DATA          0x0001  /* file contents */
+#define GF_UPCALL_ATTR          0x0002  /* iatt or xattrs */
+#define GF_UPCALL_ENTRY         0x0004  /* directory entries */
+#define GF_UPCALL_NAMES         0x0008  /* names of the inode (unlink,
+                                           rename) */
+
+struct gf_upcall {
+        uuid_t                   gfid;
+        uint32_t                 flags;
+        char                    *client_uid; /* brick side: id of the
+                                                connection to be
+                                                notified */
+        inode_t                 *inode;   /* client side: the cached inode,
+                                             NULL if not in the table */
+};
+
 typedef struct xlator_list {
         xlator_t           *xlator;
         struct xlator_list *next;
@@ -64,6 +64,10 @@ enum gf_fop_procnum {
         GFS3_OP_READDIRP,
         GFS3_OP_RELEASE,
         GFS3_OP_RELEASEDIR,
+        GFS3_OP_FALLOCATE,
+        GFS3_OP_DISCARD,
+        GFS3_OP_ZEROFILL,
+        GFS3_OP_COPY_FILE_RANGE,
         GFS3_OP_MAXVALUE,
 } ;
 
@@ -116,6 +120,7 @@ enum gf_cbk_procnum {
         GF_CBK_NULL = 0,
         GF_CBK_FETCHSPEC,
         GF_CBK_INO_FLUSH,
+        GF_CBK_CACHE_INVALIDATION,
         GF_CBK_MAXVALUE,
 };
 
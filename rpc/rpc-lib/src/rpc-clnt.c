@@ -602,6 +602,11 @@ rpc_clnt_reply_fill (rpc_transport_pollin_t *msg,
         if ((rpc_reply_status (replymsg) == MSG_DENIED)
             || (rpc_accepted_reply_status (replymsg) != SUCCESS)) {
                 req->rpc_status = -1;
+                /* e.g. PROC_UNAVAIL from a server older than the
+                   procedure */
+                if (rpc_reply_status (replymsg) != MSG_DENIED)
+                        req->accept_status =
+                                rpc_accepted_reply_status (replymsg);
         }
 
         req->rsp[0] = progmsg;
@@ -685,8 +690,6 @@ rpc_clnt_reply_init (rpc_clnt_connection_t *conn, rpc_transport_pollin_t *msg,
                 saved_frame->rpcreq->prog->progver,
                 saved_frame->rpcreq->procnum, conn->trans->name);
 
-        req->rpc_status = 0;
-
 out:
         if (ret != 0) {
                 req->rpc_status = -1;
@@ -743,7 +746,7 @@ rpc_clnt_handle_cbk (struct rpc_clnt *clnt, rpc_transport_pollin_t *msg)
 
         if (found && (procnum < program->numactors) &&
             (program->actors[procnum].actor)) {
-                program->actors[procnum].actor (&progmsg);
+                program->actors[procnum].actor (clnt, clnt->mydata, &progmsg);
         }
 
 out:
@@ -89,7 +89,8 @@ typedef struct rpc_clnt_program {
         int                   numproc;
 } rpc_clnt_prog_t;
 
-typedef int (*rpcclnt_cb_fn) (void *data);
+/* @mydata is what was passed to rpc_clnt_register_notify () */
+typedef int (*rpcclnt_cb_fn) (struct rpc_clnt *rpc, void *mydata, void *data);
 
 /* The descriptor for each procedure/actor that runs
  * over the RPC service.
@@ -165,6 +166,8 @@ struct rpc_req {
         int                    rspcnt;
         struct iobref         *rsp_iobref;
         int                    rpc_status;
+        int                    accept_status; /* of a reply rpc_status
+                                                 is -1 for */
         rpc_auth_data_t        verf;
         rpc_clnt_prog_t       *prog;
         int                    procnum;
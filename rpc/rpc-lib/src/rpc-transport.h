@@ -214,6 +214,8 @@ struct rpc_transport {
 
         struct list_head           list;
         int                        bind_insecure;
+        gf_boolean_t               sendfile; /* sends the file region of an
+                                                iobref from the file */
 };
 
 struct rpc_transport_ops {
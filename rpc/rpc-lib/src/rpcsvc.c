@@ -818,11 +818,13 @@ rpcsvc_callback_submit (rpcsvc_t *rpc, rpc_transport_t *trans,
                         struct iovec *proghdr, int proghdrcount)
 {
         struct iobuf          *request_iob = NULL;
+        struct iobref         *iobref      = NULL;
         struct iovec           rpchdr      = {0,};
         rpc_transport_req_t    req;
         int                    ret         = -1;
         int                    proglen     = 0;
         uint64_t               callid      = 0;
+        int                    i           = 0;
 
         if (!rpc) {
                 goto out;
@@ -846,10 +848,30 @@ rpcsvc_callback_submit (rpcsvc_t *rpc, rpc_transport_t *trans,
                 goto out;
         }
 
+        /* the transport may queue the message, so the program header is
+         * copied behind the rpc header and the iobuf handed over with it.
+         */
+        if (proglen > (iobuf_pagesize (request_iob) - rpchdr.iov_len)) {
+                gf_log ("rpcsvc", GF_LOG_WARNING,
+                        "callback header too large (%d)", proglen);
+                goto out;
+        }
+
+        for (i = 0; i < proghdrcount; i++) {
+                memcpy ((char *)rpchdr.iov_base + rpchdr.iov_len,
+                        proghdr[i].iov_base, proghdr[i].iov_len);
+                rpchdr.iov_len += proghdr[i].iov_len;
+        }
+
+        iobref = iobref_new ();
+        if (!iobref)
+                goto out;
+
+        iobref_add (iobref, request_iob);
+
         req.msg.rpchdr = &rpchdr;
         req.msg.rpchdrcount = 1;
-        req.msg.proghdr = proghdr;
-        req.msg.proghdrcount = proghdrcount;
+        req.msg.iobref = iobref;
 
         ret = rpc_transport_submit_request (trans, &req);
         if (ret == -1) {
@@ -861,7 +883,11 @@ rpcsvc_callback_submit (rpcsvc_t *rpc, rpc_transport_t *trans,
         ret = 0;
 
 out:
-        iobuf_unref (request_iob);
+        if (iobref)
+                iobref_unref (iobref);
+
+        if (request_iob)
+                iobuf_unref (request_iob);
 
         return ret;
 }
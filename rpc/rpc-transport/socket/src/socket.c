@@ -44,6 +44,9 @@
 #include <errno.h>
 #include <netinet/tcp.h>
 #include <rpc/xdr.h>
+#ifdef GF_LINUX_HOST_OS
+#include <sys/sendfile.h>
+#endif
 #define GF_LOG_ERRNO(errno) ((errno == ENOTCONN) ? GF_LOG_DEBUG : GF_LOG_ERROR)
 #define SA(ptr) ((struct sockaddr *)ptr)
 
@@ -572,8 +575,11 @@ __socket_ioq_new (rpc_transport_t *this, rpc_transport_msg_t *msg)
         entry->pending_vector = entry->vector;
         entry->pending_count  = entry->count;
 
-        if (msg->iobref != NULL)
+        if (msg->iobref != NULL) {
                 entry->iobref = iobref_ref (msg->iobref);
+                if (msg->iobref->file)
+                        entry->file_offset = msg->iobref->file->offset;
+        }
 
         INIT_LIST_HEAD (&entry->list);
 
@@ -590,6 +596,8 @@ __socket_ioq_entry_free (struct ioq *entry)
         list_del_init (&entry->list);
         if (entry->iobref)
                 iobref_unref (entry->iobref);
+        if (entry->padding)
+                GF_FREE (entry->padding);
 
         /* TODO: use mem-pool */
         GF_FREE (entry);
@@ -620,15 +628,104 @@ out:
 }
 
 
+/* sends the file region of the iobref of entry, which the first pending
+   vector (with a NULL iov_base) stands for */
+int
+__socket_sendfile (rpc_transport_t *this, struct ioq *entry)
+{
+        socket_private_t *priv   = NULL;
+        struct iovec     *vector = NULL;
+        ssize_t           ret    = -1;
+
+        priv = this->private;
+        vector = entry->pending_vector;
+
+        if (vector->iov_len && (!entry->iobref || !entry->iobref->file)) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "no file region to send %"GF_PRI_SIZET" bytes from",
+                        vector->iov_len);
+                errno = EINVAL;
+                return -1;
+        }
+
+        while (vector->iov_len) {
+#ifdef GF_LINUX_HOST_OS
+                ret = sendfile (priv->sock, entry->iobref->file->fd,
+                                &entry->file_offset, vector->iov_len);
+#else
+                errno = ENOSYS;
+                ret = -1;
+#endif
+                if (ret == -1) {
+                        if (errno == EINTR)
+                                continue;
+                        if (errno == EAGAIN)
+                                return 1;
+
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "sendfile failed (%s)", strerror (errno));
+                        return -1;
+                }
+
+                if (ret == 0) {
+                        /* the file got shorter, the size announced in the
+                           record is made up with zeroes */
+                        entry->padding = GF_CALLOC (1, vector->iov_len,
+                                                    gf_common_mt_char);
+                        if (!entry->padding) {
+                                errno = ENOMEM;
+                                return -1;
+                        }
+                        vector->iov_base = entry->padding;
+                        return 0;
+                }
+
+                this->total_bytes_write += ret;
+                vector->iov_len -= ret;
+        }
+
+        entry->pending_vector++;
+        entry->pending_count--;
+
+        return 0;
+}
+
+
 int
 __socket_ioq_churn_entry (rpc_transport_t *this, struct ioq *entry)
 {
-        int ret = -1;
+        struct iovec *vector = NULL;
+        int           ret    = 0;
+        int           count  = 0;
+        int           rest   = 0;
+        int           pending = 0;
+
+        while (entry->pending_count) {
+                for (count = 0; count < entry->pending_count; count++) {
+                        if (!entry->pending_vector[count].iov_base)
+                                break;
+                }
+
+                if (!count) {
+                        ret = __socket_sendfile (this, entry);
+                        if (ret != 0)
+                                break;
+                        continue;
+                }
+
+                /* memory up to the file region, if any */
+                rest = entry->pending_count - count;
+                ret = __socket_writev (this, entry->pending_vector, count,
+                                       &vector, &pending);
+                if (ret == -1)
+                        break;
 
-        ret = __socket_writev (this, entry->pending_vector,
-                               entry->pending_count,
-                               &entry->pending_vector,
-                               &entry->pending_count);
+                entry->pending_vector = vector;
+                entry->pending_count  = pending + rest;
+
+                if (ret != 0)
+                        break;
+        }
 
         if (ret == 0) {
                 /* current entry was completely written */
@@ -2559,6 +2656,10 @@ socket_init (rpc_transport_t *this)
 
         pthread_mutex_init (&priv->lock, NULL);
 
+#ifdef GF_LINUX_HOST_OS
+        this->sendfile = _gf_true;
+#endif
+
         priv->sock = -1;
         priv->idx = -1;
         priv->connected = -1;
@@ -109,6 +109,8 @@ struct ioq {
         struct iovec      *pending_vector;
         int                pending_count;
         struct iobref     *iobref;
+        off_t              file_offset;  /* of the iobref file region */
+        char              *padding;
 };
 
 typedef struct {
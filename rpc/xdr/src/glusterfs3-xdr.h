@@ -785,6 +785,82 @@ struct gfs3_readdirp_rsp {
 };
 typedef struct gfs3_readdirp_rsp gfs3_readdirp_rsp;
 
+struct gfs3_cbk_cache_invalidation_req {
+	char gfid[16];
+	u_int flags;
+};
+typedef struct gfs3_cbk_cache_invalidation_req gfs3_cbk_cache_invalidation_req;
+
+struct gfs3_fallocate_req {
+	char gfid[16];
+	quad_t fd;
+	u_int flags;
+	u_quad_t offset;
+	u_quad_t size;
+};
+typedef struct gfs3_fallocate_req gfs3_fallocate_req;
+
+struct gfs3_fallocate_rsp {
+	int op_ret;
+	int op_errno;
+	struct gf_iatt statpre;
+	struct gf_iatt statpost;
+};
+typedef struct gfs3_fallocate_rsp gfs3_fallocate_rsp;
+
+struct gfs3_discard_req {
+	char gfid[16];
+	quad_t fd;
+	u_quad_t offset;
+	u_quad_t size;
+};
+typedef struct gfs3_discard_req gfs3_discard_req;
+
+struct gfs3_discard_rsp {
+	int op_ret;
+	int op_errno;
+	struct gf_iatt statpre;
+	struct gf_iatt statpost;
+};
+typedef struct gfs3_discard_rsp gfs3_discard_rsp;
+
+struct gfs3_zerofill_req {
+	char gfid[16];
+	quad_t fd;
+	u_quad_t offset;
+	u_quad_t size;
+};
+typedef struct gfs3_zerofill_req gfs3_zerofill_req;
+
+struct gfs3_zerofill_rsp {
+	int op_ret;
+	int op_errno;
+	struct gf_iatt statpre;
+	struct gf_iatt statpost;
+};
+typedef struct gfs3_zerofill_rsp gfs3_zerofill_rsp;
+
+struct gfs3_copy_file_range_req {
+	char gfid_in[16];
+	quad_t fd_in;
+	u_quad_t off_in;
+	char gfid_out[16];
+	quad_t fd_out;
+	u_quad_t off_out;
+	u_quad_t size;
+	u_int flags;
+};
+typedef struct gfs3_copy_file_range_req gfs3_copy_file_range_req;
+
+struct gfs3_copy_file_range_rsp {
+	int op_ret;
+	int op_errno;
+	struct gf_iatt stat;
+	struct gf_iatt statpre;
+	struct gf_iatt statpost;
+};
+typedef struct gfs3_copy_file_range_rsp gfs3_copy_file_range_rsp;
+
 /* the xdr functions */
 
 #if defined(__STDC__) || defined(__cplusplus)
@@ -873,6 +949,15 @@ extern  bool_t xdr_gfs3_dirlist (XDR *, gfs3_dirlist*);
 extern  bool_t xdr_gfs3_readdir_rsp (XDR *, gfs3_readdir_rsp*);
 extern  bool_t xdr_gfs3_dirplist (XDR *, gfs3_dirplist*);
 extern  bool_t xdr_gfs3_readdirp_rsp (XDR *, gfs3_readdirp_rsp*);
+extern  bool_t xdr_gfs3_cbk_cache_invalidation_req (XDR *, gfs3_cbk_cache_invalidation_req*);
+extern  bool_t xdr_gfs3_fallocate_req (XDR *, gfs3_fallocate_req*);
+extern  bool_t xdr_gfs3_fallocate_rsp (XDR *, gfs3_fallocate_rsp*);
+extern  bool_t xdr_gfs3_discard_req (XDR *, gfs3_discard_req*);
+extern  bool_t xdr_gfs3_discard_rsp (XDR *, gfs3_discard_rsp*);
+extern  bool_t xdr_gfs3_zerofill_req (XDR *, gfs3_zerofill_req*);
+extern  bool_t xdr_gfs3_zerofill_rsp (XDR *, gfs3_zerofill_rsp*);
+extern  bool_t xdr_gfs3_copy_file_range_req (XDR *, gfs3_copy_file_range_req*);
+extern  bool_t xdr_gfs3_copy_file_range_rsp (XDR *, gfs3_copy_file_range_rsp*);
 
 #else /* K&R C */
 extern bool_t xdr_gf_statfs ();
@@ -960,6 +1045,15 @@ extern bool_t xdr_gfs3_dirlist ();
 extern bool_t xdr_gfs3_readdir_rsp ();
 extern bool_t xdr_gfs3_dirplist ();
 extern bool_t xdr_gfs3_readdirp_rsp ();
+extern bool_t xdr_gfs3_cbk_cache_invalidation_req ();
+extern bool_t xdr_gfs3_fallocate_req ();
+extern bool_t xdr_gfs3_fallocate_rsp ();
+extern bool_t xdr_gfs3_discard_req ();
+extern bool_t xdr_gfs3_discard_rsp ();
+extern bool_t xdr_gfs3_zerofill_req ();
+extern bool_t xdr_gfs3_zerofill_rsp ();
+extern bool_t xdr_gfs3_copy_file_range_req ();
+extern bool_t xdr_gfs3_copy_file_range_rsp ();
 
 #endif /* K&R C */
 
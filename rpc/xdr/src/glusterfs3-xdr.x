@@ -614,3 +614,69 @@ struct gfs3_readdirp_rsp {
        struct gfs3_dirplist *reply;
 };
 
+struct gfs3_cbk_cache_invalidation_req {
+       opaque gfid[16];
+       unsigned int flags;
+};
+
+struct gfs3_fallocate_req {
+        opaque gfid[16];
+        hyper fd;
+        unsigned int flags;
+        unsigned hyper offset;
+        unsigned hyper size;
+};
+
+struct gfs3_fallocate_rsp {
+        int op_ret;
+        int op_errno;
+        struct gf_iatt statpre;
+        struct gf_iatt statpost;
+};
+
+struct gfs3_discard_req {
+        opaque gfid[16];
+        hyper fd;
+        unsigned hyper offset;
+        unsigned hyper size;
+};
+
+struct gfs3_discard_rsp {
+        int op_ret;
+        int op_errno;
+        struct gf_iatt statpre;
+        struct gf_iatt statpost;
+};
+
+struct gfs3_zerofill_req {
+        opaque gfid[16];
+        hyper fd;
+        unsigned hyper offset;
+        unsigned hyper size;
+};
+
+struct gfs3_zerofill_rsp {
+        int op_ret;
+        int op_errno;
+        struct gf_iatt statpre;
+        struct gf_iatt statpost;
+};
+
+struct gfs3_copy_file_range_req {
+        opaque gfid_in[16];
+        hyper fd_in;
+        unsigned hyper off_in;
+        opaque gfid_out[16];
+        hyper fd_out;
+        unsigned hyper off_out;
+        unsigned hyper size;
+        unsigned int flags;
+};
+
+struct gfs3_copy_file_range_rsp {
+        int op_ret;
+        int op_errno;
+        struct gf_iatt stat;
+        struct gf_iatt statpre;
+        struct gf_iatt statpost;
+};
@@ -649,6 +649,170 @@ out:
         return next_call_child;
 }
 
+/* {{{ read policy */
+
+/* once in this many reads the latency policy tries the other children,
+   so that their average follows them getting faster */
+#define AFR_READ_LATENCY_PROBE  64
+
+void
+afr_read_stats_begin (xlator_t *this, int32_t child)
+{
+        afr_private_t *priv = NULL;
+
+        priv = this->private;
+        if (!priv->read_stats)
+                return;
+
+        LOCK (&priv->read_child_lock);
+        {
+                priv->read_stats[child].reads++;
+                priv->read_stats[child].outstanding++;
+        }
+        UNLOCK (&priv->read_child_lock);
+}
+
+
+void
+afr_read_stats_end (xlator_t *this, int32_t child, struct timeval *start)
+{
+        afr_private_t    *priv    = NULL;
+        afr_read_stats_t *stats   = NULL;
+        struct timeval    now     = {0, };
+        uint64_t          latency = 0;
+
+        priv = this->private;
+        if (!priv->read_stats)
+                return;
+
+        gettimeofday (&now, NULL);
+        latency = (now.tv_sec - start->tv_sec) * 1000000 +
+                  (now.tv_usec - start->tv_usec);
+
+        LOCK (&priv->read_child_lock);
+        {
+                stats = &priv->read_stats[child];
+
+                stats->outstanding--;
+                if (stats->latency)
+                        stats->latency = (stats->latency * 7 + latency) / 8;
+                else
+                        stats->latency = latency;
+        }
+        UNLOCK (&priv->read_child_lock);
+}
+
+
+static inline int64_t
+afr_read_stats_value (afr_private_t *priv, int32_t child)
+{
+        if (priv->read_policy == AFR_READ_POLICY_LATENCY)
+                return priv->read_stats[child].latency;
+
+        return priv->read_stats[child].outstanding;
+}
+
+
+/* Picks among the fresh children which are up the one the read policy
+ * prefers, read_child when there is no choice. A NULL inode keeps
+ * read_child: directory offsets are only valid on the child which gave
+ * them.
+ */
+static int32_t
+afr_read_child_by_policy (xlator_t *this, inode_t *inode,
+                          unsigned char *child_up, int32_t *fresh_children,
+                          int32_t read_child)
+{
+        afr_private_t *priv       = NULL;
+        int32_t        child      = -1;
+        int32_t        best       = -1;
+        int64_t        value      = 0;
+        int64_t        best_value = 0;
+        int            count      = 0;
+        int            pick       = 0;
+        int            i          = 0;
+
+        priv = this->private;
+
+        if ((priv->read_policy == AFR_READ_POLICY_STATIC) || !inode ||
+            !priv->read_stats)
+                return read_child;
+
+        for (i = 0; i < priv->child_count; i++) {
+                if (fresh_children[i] == -1)
+                        break;
+                if (child_up[fresh_children[i]])
+                        count++;
+        }
+
+        if (count < 2)
+                return read_child;
+
+        if (priv->read_policy == AFR_READ_POLICY_INODE_HASH) {
+                if (uuid_is_null (inode->gfid))
+                        return read_child;
+
+                pick = SuperFastHash ((char *)inode->gfid,
+                                      sizeof (inode->gfid)) % count;
+                for (i = 0; i < priv->child_count; i++) {
+                        child = fresh_children[i];
+                        if (child == -1)
+                                break;
+                        if (!child_up[child])
+                                continue;
+                        if (pick-- == 0)
+                                return child;
+                }
+
+                return read_child;
+        }
+
+        best = read_child;
+
+        LOCK (&priv->read_child_lock);
+        {
+                if ((priv->read_policy == AFR_READ_POLICY_LATENCY) &&
+                    ((++priv->read_child_rr % AFR_READ_LATENCY_PROBE) == 0)) {
+                        pick = (priv->read_child_rr / AFR_READ_LATENCY_PROBE)
+                                % count;
+                        for (i = 0; i < priv->child_count; i++) {
+                                child = fresh_children[i];
+                                if (child == -1)
+                                        break;
+                                if (!child_up[child])
+                                        continue;
+                                if (pick-- == 0) {
+                                        best = child;
+                                        break;
+                                }
+                        }
+                        goto unlock;
+                }
+
+                /* on a tie, read_child */
+                best_value = afr_read_stats_value (priv, read_child);
+                for (i = 0; i < priv->child_count; i++) {
+                        child = fresh_children[i];
+                        if (child == -1)
+                                break;
+                        if (!child_up[child])
+                                continue;
+
+                        value = afr_read_stats_value (priv, child);
+                        if (value < best_value) {
+                                best = child;
+                                best_value = value;
+                        }
+                }
+        }
+unlock:
+        UNLOCK (&priv->read_child_lock);
+
+        return best;
+}
+
+/* }}} */
+
  /* This function should not be called with the inode's read_children array.
  * The fop's handler should make a copy of the inode's read_children,
  * preferred read_child into the local vars, because while this function is
@@ -656,7 +820,7 @@ out:
  */
 int32_t
 afr_get_call_child (xlator_t *this, unsigned char *child_up, int32_t read_child,
-                    int32_t *fresh_children,
+                    int32_t *fresh_children, inode_t *inode,
                     int32_t *call_child, int32_t *last_index)
 {
         int             ret   = 0;
@@ -674,7 +838,9 @@ afr_get_call_child (xlator_t *this, unsigned char *child_up, int32_t read_child,
         *last_index = -1;
 
         if (child_up[read_child]) {
-                *call_child = read_child;
+                *call_child = afr_read_child_by_policy (this, inode, child_up,
+                                                        fresh_children,
+                                                        read_child);
         } else {
                 for (i = 0; i < priv->child_count; i++) {
                         if (fresh_children[i] == -1)
@@ -792,6 +958,16 @@ afr_local_sh_cleanup (afr_local_t *local, xlator_t *this)
 
         if (sh->write_needed)
                 GF_FREE (sh->write_needed);
+
+        GF_FREE (sh->merkle_ranges);
+
+        if (sh->data_extents) {
+                for (i = 0; i < priv->child_count; i++)
+                        GF_FREE (sh->data_extents[i]);
+                GF_FREE (sh->data_extents);
+        }
+        GF_FREE (sh->data_extent_count);
+
         if (sh->healing_fd)
                 fd_unref (sh->healing_fd);
 }
@@ -850,6 +1026,8 @@ afr_local_cleanup (afr_local_t *local, xlator_t *this)
 
         afr_local_transaction_cleanup (local, this);
 
+        afr_transaction_eager_lock_done (local, this);
+
         priv = this->private;
 
         loc_wipe (&local->loc);
@@ -935,6 +1113,11 @@ afr_local_cleanup (afr_local_t *local, xlator_t *this)
                 GF_FREE (local->cont.writev.vector);
         }
 
+        { /* copy_file_range */
+                if (local->cont.copy_file_range.fd_in)
+                        fd_unref (local->cont.copy_file_range.fd_in);
+        }
+
         { /* setxattr */
                 if (local->cont.setxattr.dict)
                         dict_unref (local->cont.setxattr.dict);
@@ -2148,6 +2331,7 @@ __afr_fd_ctx_set (xlator_t *this, fd_t *fd)
 
         INIT_LIST_HEAD (&fd_ctx->paused_calls);
         INIT_LIST_HEAD (&fd_ctx->entries);
+        INIT_LIST_HEAD (&fd_ctx->eager_transactions);
 
         ret = __fd_ctx_set (fd, this, (uint64_t)(long) fd_ctx);
         if (ret)
@@ -2298,7 +2482,7 @@ afr_flush_done (call_frame_t *frame, xlator_t *this)
 
 
 int
-afr_flush (call_frame_t *frame, xlator_t *this, fd_t *fd)
+afr_flush_resume (call_frame_t *frame, xlator_t *this, fd_t *fd)
 {
         afr_private_t *priv  = NULL;
         afr_local_t   *local = NULL;
@@ -2357,6 +2541,29 @@ out:
         return 0;
 }
 
+
+int
+afr_flush (call_frame_t *frame, xlator_t *this, fd_t *fd)
+{
+        call_stub_t *stub = NULL;
+
+        VALIDATE_OR_GOTO (frame, out);
+        VALIDATE_OR_GOTO (this, out);
+        VALIDATE_OR_GOTO (fd, out);
+
+        stub = fop_flush_stub (frame, afr_flush_resume, fd);
+        if (!stub)
+                return afr_flush_resume (frame, this, fd);
+
+        /* the changelog of the last writes is cleared before the flush */
+        afr_delayed_changelog_wake_resume (this, fd, stub);
+
+        return 0;
+out:
+        AFR_STACK_UNWIND (flush, frame, -1, EINVAL);
+        return 0;
+}
+
 /* }}} */
 
 
@@ -2487,8 +2694,8 @@ afr_fsync_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 
 
 int
-afr_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd,
-           int32_t datasync)
+afr_fsync_resume (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                  int32_t datasync)
 {
         afr_private_t *priv = NULL;
         afr_local_t *local = NULL;
@@ -2533,6 +2740,30 @@ out:
         return 0;
 }
 
+
+int
+afr_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd,
+           int32_t datasync)
+{
+        call_stub_t *stub = NULL;
+
+        VALIDATE_OR_GOTO (frame, out);
+        VALIDATE_OR_GOTO (this, out);
+        VALIDATE_OR_GOTO (fd, out);
+
+        stub = fop_fsync_stub (frame, afr_fsync_resume, fd, datasync);
+        if (!stub)
+                return afr_fsync_resume (frame, this, fd, datasync);
+
+        /* the changelog of the last writes is cleared before the fsync */
+        afr_delayed_changelog_wake_resume (this, fd, stub);
+
+        return 0;
+out:
+        AFR_STACK_UNWIND (fsync, frame, -1, EINVAL, NULL, NULL);
+        return 0;
+}
+
 /* }}} */
 
 /* {{{ fsync */
@@ -3382,6 +3613,30 @@ afr_priv_dump (xlator_t *this)
         gf_proc_dump_write("read_child", "%d", priv->read_child);
         gf_proc_dump_write("favorite_child", "%d", priv->favorite_child);
         gf_proc_dump_write("wait_count", "%u", priv->wait_count);
+        gf_proc_dump_write("eager_lock", "%d", priv->eager_lock);
+        gf_proc_dump_write("post_op_delay_secs", "%u",
+                           priv->post_op_delay_secs);
+        gf_proc_dump_write("read_policy", "%d", priv->read_policy);
+        gf_proc_dump_write("background_self_heals_started", "%u",
+                           priv->background_self_heals_started);
+        gf_proc_dump_write("heals_waiting", "%u", priv->heal_waiting);
+        gf_proc_dump_write("data_self_heal_bandwidth", "%"PRIu64,
+                           priv->sh_bandwidth);
+        for (i = 0; priv->read_stats && (i < priv->child_count); i++) {
+                LOCK (&priv->read_child_lock);
+                {
+                        sprintf (key, "reads[%d]", i);
+                        gf_proc_dump_write(key, "%"PRIu64,
+                                           priv->read_stats[i].reads);
+                        sprintf (key, "outstanding_reads[%d]", i);
+                        gf_proc_dump_write(key, "%"PRId64,
+                                           priv->read_stats[i].outstanding);
+                        sprintf (key, "read_latency_usec[%d]", i);
+                        gf_proc_dump_write(key, "%"PRIu64,
+                                           priv->read_stats[i].latency);
+                }
+                UNLOCK (&priv->read_child_lock);
+        }
 
         return 0;
 }
@@ -3430,6 +3685,10 @@ afr_notify (xlator_t *this, int32_t event,
         if (!priv)
                 return 0;
 
+        /* upcalls carry no child, they go straight to the parents */
+        if (event == GF_EVENT_UPCALL)
+                return default_notify (this, event, data);
+
         had_heard_from_all = 1;
         for (i = 0; i < priv->child_count; i++) {
                 if (!priv->last_event[i]) {
@@ -3921,6 +4180,7 @@ afr_priv_destroy (afr_private_t *priv)
         GF_FREE (priv->pending_key);
         GF_FREE (priv->children);
         GF_FREE (priv->child_up);
+        GF_FREE (priv->read_stats);
         LOCK_DESTROY (&priv->lock);
         LOCK_DESTROY (&priv->read_child_lock);
         pthread_mutex_destroy (&priv->mutex);
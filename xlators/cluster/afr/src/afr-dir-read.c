@@ -663,7 +663,7 @@ afr_do_readdir (call_frame_t *frame, xlator_t *this,
         read_child = afr_inode_get_read_ctx (this, fd->inode,
                                              local->fresh_children);
         ret = afr_get_call_child (this, local->child_up, read_child,
-                                     local->fresh_children,
+                                     local->fresh_children, NULL,
                                      &call_child,
                                      &local->cont.readdir.last_index);
         if (ret < 0) {
@@ -141,7 +141,7 @@ afr_access (call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t mask)
         read_child = afr_inode_get_read_ctx (this, loc->inode,
                                              local->fresh_children);
         ret = afr_get_call_child (this, local->child_up, read_child,
-                                     local->fresh_children,
+                                     local->fresh_children, loc->inode,
                                      &call_child,
                                      &local->cont.access.last_index);
         if (ret < 0) {
@@ -255,7 +255,7 @@ afr_stat (call_frame_t *frame, xlator_t *this, loc_t *loc)
         read_child = afr_inode_get_read_ctx (this, loc->inode,
                                              local->fresh_children);
         ret = afr_get_call_child (this, local->child_up, read_child,
-                                     local->fresh_children,
+                                     local->fresh_children, loc->inode,
                                      &call_child,
                                      &local->cont.stat.last_index);
         if (ret < 0) {
@@ -373,7 +373,7 @@ afr_fstat (call_frame_t *frame, xlator_t *this,
 
 
         ret = afr_get_call_child (this, local->child_up, read_child,
-                                     local->fresh_children,
+                                     local->fresh_children, fd->inode,
                                      &call_child,
                                      &local->cont.fstat.last_index);
         if (ret < 0) {
@@ -490,7 +490,7 @@ afr_readlink (call_frame_t *frame, xlator_t *this,
         read_child = afr_inode_get_read_ctx (this, loc->inode,
                                              local->fresh_children);
         ret = afr_get_call_child (this, local->child_up, read_child,
-                                     local->fresh_children,
+                                     local->fresh_children, loc->inode,
                                      &call_child,
                                      &local->cont.readlink.last_index);
         if (ret < 0) {
@@ -869,7 +869,7 @@ afr_getxattr (call_frame_t *frame, xlator_t *this,
 
         read_child = afr_inode_get_read_ctx (this, loc->inode, local->fresh_children);
         ret = afr_get_call_child (this, local->child_up, read_child,
-                                     local->fresh_children,
+                                     local->fresh_children, loc->inode,
                                      &call_child,
                                      &local->cont.getxattr.last_index);
         if (ret < 0) {
@@ -935,6 +935,8 @@ afr_readv_cbk (call_frame_t *frame, void *cookie,
 
         read_child = (long) cookie;
 
+        afr_read_stats_end (this, read_child, &local->cont.readv.start);
+
         if (op_ret == -1) {
                 last_index = &local->cont.readv.last_index;
                 fresh_children = local->fresh_children;
@@ -947,8 +949,11 @@ afr_readv_cbk (call_frame_t *frame, void *cookie,
 
                 unwind = 0;
 
+                gettimeofday (&local->cont.readv.start, NULL);
+                afr_read_stats_begin (this, next_call_child);
+
                 STACK_WIND_COOKIE (frame, afr_readv_cbk,
-                                   (void *) (long) read_child,
+                                   (void *) (long) next_call_child,
                                    children[next_call_child],
                                    children[next_call_child]->fops->readv,
                                    local->fd, local->cont.readv.size,
@@ -1000,7 +1005,7 @@ afr_readv (call_frame_t *frame, xlator_t *this,
 
         read_child = afr_inode_get_read_ctx (this, fd->inode, local->fresh_children);
         ret = afr_get_call_child (this, local->child_up, read_child,
-                                     local->fresh_children,
+                                     local->fresh_children, fd->inode,
                                      &call_child,
                                      &local->cont.readv.last_index);
         if (ret < 0) {
@@ -1018,6 +1023,10 @@ afr_readv (call_frame_t *frame, xlator_t *this,
                 op_errno = -ret;
                 goto out;
         }
+
+        gettimeofday (&local->cont.readv.start, NULL);
+        afr_read_stats_begin (this, call_child);
+
         STACK_WIND_COOKIE (frame, afr_readv_cbk,
                            (void *) (long) call_child,
                            children[call_child],
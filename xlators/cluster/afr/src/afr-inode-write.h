@@ -49,6 +49,23 @@ int32_t
 afr_ftruncate (call_frame_t *frame, xlator_t *this,
 	       fd_t *fd, off_t offset);
 
+int
+afr_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+               int32_t mode, off_t offset, size_t len);
+
+int
+afr_discard (call_frame_t *frame, xlator_t *this, fd_t *fd,
+             off_t offset, size_t len);
+
+int
+afr_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              off_t offset, size_t len);
+
+int
+afr_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                     off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                     uint32_t flags);
+
 int32_t
 afr_utimens (call_frame_t *frame, xlator_t *this,
 	     loc_t *loc, struct timespec tv[2]);
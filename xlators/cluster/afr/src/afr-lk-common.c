@@ -65,6 +65,17 @@ afr_set_lk_owner (call_frame_t *frame, xlator_t *this)
         frame->root->lk_owner = (uint64_t) (unsigned long)frame->root;
 }
 
+/* eager lock: every transaction on the fd locks and unlocks as the same
+   owner, so that any of them can release the lock another one took */
+void
+afr_set_fd_lk_owner (call_frame_t *frame, xlator_t *this, fd_t *fd)
+{
+        gf_log (this->name, GF_LOG_TRACE,
+                "Setting lk-owner=%llu",
+                (unsigned long long) (unsigned long)fd);
+        frame->root->lk_owner = (uint64_t) (unsigned long)fd;
+}
+
 static int
 is_afr_lock_selfheal (afr_local_t *local)
 {
@@ -570,9 +581,7 @@ afr_unlock_inodelk_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 
         int_lock->inode_locked_nodes[child_index] &= LOCKED_NO;
 
-        if (op_ret == 1) {
-                local->transaction.eager_lock[child_index] = 0;
-        }
+        local->transaction.eager_lock[child_index] = 0;
 
         afr_unlock_common_cbk (frame, cookie, this, op_ret, op_errno);
 
@@ -587,6 +596,8 @@ afr_unlock_inodelk (call_frame_t *frame, xlator_t *this)
         afr_local_t         *local    = NULL;
         afr_private_t       *priv     = NULL;
         struct gf_flock flock = {0,};
+        struct gf_flock full_flock = {0,};
+        struct gf_flock *flock_use = NULL;
         int call_count = 0;
         int i = 0;
         int piggyback = 0;
@@ -601,6 +612,8 @@ afr_unlock_inodelk (call_frame_t *frame, xlator_t *this)
         flock.l_len   = int_lock->lk_flock.l_len;
         flock.l_type  = F_UNLCK;
 
+        full_flock.l_type = F_UNLCK;
+
         gf_log (this->name, GF_LOG_DEBUG, "attempting data unlock range %"PRIu64
                 " %"PRIu64" by %"PRIu64, flock.l_start, flock.l_len,
                 frame->root->lk_owner);
@@ -626,10 +639,12 @@ afr_unlock_inodelk (call_frame_t *frame, xlator_t *this)
                         continue;
 
                 if (local->fd) {
+                        flock_use = &flock;
                         if (!local->transaction.eager_lock[i]) {
                                 goto wind;
                         }
 
+                        flock_use = &full_flock;
                         piggyback = 0;
 
                         LOCK (&local->fd->lock);
@@ -649,17 +664,22 @@ afr_unlock_inodelk (call_frame_t *frame, xlator_t *this)
                                 continue;
                         }
 
-                        fd_ctx->lock_acquired[i]--;
+                        LOCK (&local->fd->lock);
+                        {
+                                fd_ctx->lock_acquired[i]--;
+                        }
+                        UNLOCK (&local->fd->lock);
                 wind:
                         afr_trace_inodelk_in (frame, AFR_INODELK_TRANSACTION,
-                                              AFR_UNLOCK_OP, &flock, F_SETLK, i);
+                                              AFR_UNLOCK_OP, flock_use,
+                                              F_SETLK, i);
 
                         STACK_WIND_COOKIE (frame, afr_unlock_inodelk_cbk,
                                            (void *) (long)i,
                                            priv->children[i],
                                            priv->children[i]->fops->finodelk,
                                            this->name, local->fd,
-                                           F_SETLK, &flock);
+                                           F_SETLK, flock_use);
 
                         if (!--call_count)
                                 break;
@@ -1355,7 +1375,7 @@ afr_nonblocking_inodelk_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                         |= LOCKED_YES;
                 int_lock->inodelk_lock_count++;
 
-                if (priv->eager_lock && local->fd) {
+                if (local->transaction.eager_lock_on) {
                         fd_ctx = afr_fd_ctx_get (local->fd, this);
                         local->transaction.eager_lock[child_index] = 1;
                         /* piggybacked */
@@ -1366,7 +1386,12 @@ afr_nonblocking_inodelk_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                                 /* lock acquired from server */
                                 LOCK (&local->fd->lock);
                                 {
+                                        if (!__afr_fd_eager_lock_held
+                                            (fd_ctx, priv->child_count))
+                                                fd_ctx->lock_time = time (NULL);
                                         fd_ctx->lock_acquired[child_index]++;
+                                        fd_ctx->lock_down_count =
+                                                priv->down_count;
                                 }
                                 UNLOCK (&local->fd->lock);
                         }
@@ -1463,7 +1488,8 @@ afr_nonblocking_inodelk (call_frame_t *frame, xlator_t *this)
                         if (!local->child_up[i] || !local->fd_open_on[i])
                                 continue;
 
-                        if (!priv->eager_lock)
+                        flock_use = &flock;
+                        if (!local->transaction.eager_lock_on)
                                 goto wind;
 
                         flock_use = &full_flock;
@@ -1471,7 +1497,11 @@ afr_nonblocking_inodelk (call_frame_t *frame, xlator_t *this)
 
                         LOCK (&local->fd->lock);
                         {
-                                if (fd_ctx->lock_acquired[i]) {
+                                /* a child which went down since has
+                                   dropped the lock, take it again */
+                                if (fd_ctx->lock_acquired[i] &&
+                                    (fd_ctx->lock_down_count ==
+                                     priv->down_count)) {
                                         fd_ctx->lock_piggyback[i]++;
                                         piggyback = 1;
                                 }
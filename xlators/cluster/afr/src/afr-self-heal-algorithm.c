@@ -34,6 +34,7 @@
 #include "compat.h"
 #include "byte-order.h"
 #include "md5.h"
+#include "timer.h"
 
 #include "afr-transaction.h"
 #include "afr-self-heal.h"
@@ -50,6 +51,20 @@ sh_loop_driver (call_frame_t *sh_frame, xlator_t *this,
 static int
 sh_loop_return (call_frame_t *sh_frame, xlator_t *this, call_frame_t *loop_frame,
                 int32_t op_ret, int32_t op_errno);
+static int
+sh_merkle_next (call_frame_t *loop_frame, xlator_t *this);
+static int
+sh_merkle_checksum_done (call_frame_t *loop_frame, xlator_t *this,
+                         int write_needed);
+
+/*
+  merkle: a loop compares the checksums of a region of
+  AFR_SH_MERKLE_FANOUT ^ AFR_SH_MERKLE_LEVELS blocks, and of its
+  AFR_SH_MERKLE_FANOUT parts only if they differ, down to the blocks
+*/
+#define AFR_SH_MERKLE_FANOUT 16
+#define AFR_SH_MERKLE_LEVELS 2
+
 static int
 sh_destroy_frame (call_frame_t *frame, xlator_t *this)
 {
@@ -100,6 +115,7 @@ sh_loop_driver_done (call_frame_t *sh_frame, xlator_t *this,
         afr_sh_algo_private_t   *sh_priv      = NULL;
         int32_t                 total_blocks = 0;
         int32_t                 diff_blocks  = 0;
+        off_t                   skipped      = 0;
 
         local        = sh_frame->local;
         sh           = &local->self_heal;
@@ -107,6 +123,7 @@ sh_loop_driver_done (call_frame_t *sh_frame, xlator_t *this,
         if (sh_priv) {
                 total_blocks = sh_priv->total_blocks;
                 diff_blocks  = sh_priv->diff_blocks;
+                skipped      = sh_priv->skipped;
         }
 
         sh_private_cleanup (sh_frame, this);
@@ -120,6 +137,10 @@ sh_loop_driver_done (call_frame_t *sh_frame, xlator_t *this,
                 local->self_heal.algo_abort_cbk (sh_frame, this);
         } else {
                 GF_ASSERT (last_loop_frame);
+                if (skipped)
+                        gf_log (this->name, GF_LOG_DEBUG, "self-heal of %s "
+                                "skipped %"PRId64" bytes of holes",
+                                local->loc.path, (int64_t) skipped);
                 if (diff_blocks == total_blocks) {
                         gf_log (this->name, GF_LOG_INFO, "full self-heal "
                                 "completed on %s",local->loc.path);
@@ -249,6 +270,8 @@ sh_loop_frame_create (call_frame_t *sh_frame, xlator_t *this,
         new_loop_sh->active_sinks = sh->active_sinks;
         new_loop_sh->healing_fd = fd_ref (sh->healing_fd);
         new_loop_sh->file_has_holes = sh->file_has_holes;
+        new_loop_sh->sinks_emptied = sh->sinks_emptied;
+        new_loop_sh->merkle_leaf_size = sh->merkle_leaf_size;
         new_loop_sh->old_loop_frame = old_loop_frame;
         new_loop_sh->sh_frame = sh_frame;
         *loop_frame = new_loop_frame;
@@ -293,6 +316,42 @@ out:
         return 0;
 }
 
+/* the first block at or after @offset which holds data on the source or
+   on one of the sinks, sh->file_size if none does */
+static off_t
+sh_loop_skip_holes (afr_self_heal_t *sh, int child_count, off_t offset)
+{
+        off_t   *extents = NULL;
+        off_t    next    = 0;
+        off_t    end     = 0;
+        int      i       = 0;
+        int      j       = 0;
+
+        if (!sh->data_extents)
+                return offset;
+
+        next = sh->file_size;
+        for (i = 0; i < child_count; i++) {
+                extents = sh->data_extents[i];
+                if (!extents)
+                        continue;
+
+                for (j = 0; j < sh->data_extent_count[i]; j++) {
+                        end = extents[2 * j] + extents[2 * j + 1];
+                        if ((extents[2 * j + 1] == 0) || (end <= offset))
+                                continue;
+
+                        next = min (next, max (extents[2 * j], offset));
+                        break;
+                }
+        }
+
+        if (next >= sh->file_size)
+                return sh->file_size;
+
+        return next - (next % sh->block_size);
+}
+
 static int
 sh_loop_driver (call_frame_t *sh_frame, xlator_t *this,
                 gf_boolean_t is_first_call, call_frame_t *old_loop_frame)
@@ -304,6 +363,7 @@ sh_loop_driver (call_frame_t *sh_frame, xlator_t *this,
         blksize_t                   block_size     = 0;
         int                         loop           = 0;
         off_t                       offset         = 0;
+        off_t                       next           = 0;
         afr_private_t               *priv          = NULL;
 
         priv    = this->private;
@@ -321,12 +381,23 @@ sh_loop_driver (call_frame_t *sh_frame, xlator_t *this,
                        (sh_priv->loops_running < priv->data_self_heal_window_size)
                        && (sh_priv->offset < sh->file_size)) {
 
+                        next = sh_loop_skip_holes (sh, priv->child_count,
+                                                   sh_priv->offset);
+                        if (next != sh_priv->offset) {
+                                //the loops spawned below are contiguous
+                                if (loop)
+                                        break;
+                                sh_priv->skipped += next - sh_priv->offset;
+                                sh_priv->offset = next;
+                                offset = next;
+                                if (next >= sh->file_size)
+                                        break;
+                        }
+
+                        //slots left free at a hole are refilled here too
                         loop++;
                         sh_priv->offset += block_size;
                         sh_priv->loops_running++;
-
-                        if (!is_first_call)
-                                break;
                 }
                 if (0 == sh_priv->loops_running) {
                         is_driver_done = _gf_true;
@@ -407,6 +478,29 @@ sh_loop_return (call_frame_t *sh_frame, xlator_t *this, call_frame_t *loop_frame
         return 0;
 }
 
+/* a block of the loop is healed: with merkle the loop goes on with the
+   rest of its region */
+static int
+sh_loop_block_done (call_frame_t *loop_frame, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno)
+{
+        afr_local_t *               loop_local = NULL;
+        afr_self_heal_t *           loop_sh    = NULL;
+        afr_local_t *               sh_local   = NULL;
+        afr_self_heal_t            *sh         = NULL;
+
+        loop_local = loop_frame->local;
+        loop_sh    = &loop_local->self_heal;
+        sh_local   = loop_sh->sh_frame->local;
+        sh         = &sh_local->self_heal;
+
+        if (loop_sh->merkle_ranges && (op_ret >= 0) && !sh->op_failed)
+                return sh_merkle_next (loop_frame, this);
+
+        return sh_loop_return (loop_sh->sh_frame, this, loop_frame,
+                               op_ret, op_errno);
+}
+
 static int
 sh_loop_write_cbk (call_frame_t *loop_frame, void *cookie, xlator_t *this,
                    int32_t op_ret, int32_t op_errno, struct iatt *buf,
@@ -449,8 +543,8 @@ sh_loop_write_cbk (call_frame_t *loop_frame, void *cookie, xlator_t *this,
         call_count = afr_frame_return (loop_frame);
 
         if (call_count == 0) {
-                sh_loop_return (sh_frame, this, loop_frame,
-                                loop_sh->op_ret, loop_sh->op_errno);
+                sh_loop_block_done (loop_frame, this,
+                                    loop_sh->op_ret, loop_sh->op_errno);
         }
 
         return 0;
@@ -499,10 +593,11 @@ sh_loop_read_cbk (call_frame_t *loop_frame, void *cookie,
                 goto out;
         }
 
-        if (loop_sh->file_has_holes && iov_0filled (vector, count) == 0) {
+        /* zeros are left as holes only on sinks which had no data */
+        if (loop_sh->sinks_emptied && iov_0filled (vector, count) == 0) {
                         gf_log (this->name, GF_LOG_DEBUG, "0 filled block");
-                        sh_loop_return (sh_frame, this, loop_frame,
-                                        op_ret, op_errno);
+                        sh_loop_block_done (loop_frame, this,
+                                            op_ret, op_errno);
                         goto out;
         }
 
@@ -530,8 +625,51 @@ out:
 }
 
 
+/* Takes @size bytes from the data self-heal bandwidth of the volume,
+   returns the milliseconds to wait before reading them. The credit
+   builds up to at most one second worth of bandwidth. */
+static uint64_t
+sh_bandwidth_take (xlator_t *this, size_t size)
+{
+        afr_private_t   *priv    = NULL;
+        struct timeval   now     = {0, };
+        int64_t          elapsed = 0;
+        int64_t          credit  = 0;
+        uint64_t         delay   = 0;
+
+        priv = this->private;
+        if (!priv->sh_bandwidth)
+                return 0;
+
+        gettimeofday (&now, NULL);
+
+        LOCK (&priv->sh_bandwidth_lock);
+        {
+                elapsed = (now.tv_sec - priv->sh_bandwidth_stamp.tv_sec)
+                        * 1000000 + (now.tv_usec -
+                                     priv->sh_bandwidth_stamp.tv_usec);
+                if ((elapsed < 0) || (elapsed > 1000000))
+                        elapsed = 1000000;
+
+                credit = priv->sh_bandwidth_credit +
+                        (elapsed * priv->sh_bandwidth) / 1000000;
+                if (credit > priv->sh_bandwidth)
+                        credit = priv->sh_bandwidth;
+
+                credit -= size;
+                if (credit < 0)
+                        delay = (-credit * 1000) / priv->sh_bandwidth;
+
+                priv->sh_bandwidth_credit = credit;
+                priv->sh_bandwidth_stamp  = now;
+        }
+        UNLOCK (&priv->sh_bandwidth_lock);
+
+        return delay;
+}
+
 static int
-sh_loop_read (call_frame_t *loop_frame, xlator_t *this)
+sh_loop_read_wind (call_frame_t *loop_frame, xlator_t *this)
 {
         afr_private_t           *priv       = NULL;
         afr_local_t             *loop_local   = NULL;
@@ -551,6 +689,64 @@ sh_loop_read (call_frame_t *loop_frame, xlator_t *this)
         return 0;
 }
 
+static void
+sh_loop_read_resume (void *data)
+{
+        call_frame_t            *loop_frame = data;
+        afr_local_t             *loop_local = NULL;
+        afr_self_heal_t         *loop_sh    = NULL;
+        gf_timer_t              *timer      = NULL;
+
+        loop_local = loop_frame->local;
+        loop_sh    = &loop_local->self_heal;
+
+        /* a fired event is freed by cancelling it */
+        LOCK (&loop_frame->lock);
+        {
+                timer = loop_sh->throttle_timer;
+                loop_sh->throttle_timer = NULL;
+        }
+        UNLOCK (&loop_frame->lock);
+
+        if (timer)
+                gf_timer_call_cancel (loop_frame->this->ctx, timer);
+
+        sh_loop_read_wind (loop_frame, loop_frame->this);
+}
+
+static int
+sh_loop_read (call_frame_t *loop_frame, xlator_t *this)
+{
+        afr_local_t             *loop_local = NULL;
+        afr_self_heal_t         *loop_sh    = NULL;
+        struct timeval           delta      = {0, };
+        uint64_t                 delay      = 0;
+        gf_timer_t              *timer      = NULL;
+
+        loop_local = loop_frame->local;
+        loop_sh    = &loop_local->self_heal;
+
+        delay = sh_bandwidth_take (this, loop_sh->block_size);
+        if (delay) {
+                delta.tv_sec  = delay / 1000;
+                delta.tv_usec = (delay % 1000) * 1000;
+                /* the resume waits for the event to be kept */
+                LOCK (&loop_frame->lock);
+                {
+                        loop_sh->throttle_timer =
+                                gf_timer_call_after (this->ctx, delta,
+                                                     sh_loop_read_resume,
+                                                     loop_frame);
+                        timer = loop_sh->throttle_timer;
+                }
+                UNLOCK (&loop_frame->lock);
+                if (timer)
+                        return 0;
+        }
+
+        return sh_loop_read_wind (loop_frame, this);
+}
+
 
 static int
 sh_diff_checksum_cbk (call_frame_t *loop_frame, void *cookie, xlator_t *this,
@@ -617,6 +813,12 @@ sh_diff_checksum_cbk (call_frame_t *loop_frame, void *cookie, xlator_t *this,
                         }
                 }
 
+                if (loop_sh->merkle_ranges) {
+                        sh_merkle_checksum_done (loop_frame, this,
+                                                 write_needed);
+                        goto out;
+                }
+
                 LOCK (&sh_priv->lock);
                 {
                         sh_priv->total_blocks++;
@@ -632,7 +834,7 @@ sh_diff_checksum_cbk (call_frame_t *loop_frame, void *cookie, xlator_t *this,
                                         op_ret, op_errno);
                 }
         }
-
+out:
         return 0;
 }
 
@@ -678,6 +880,161 @@ sh_diff_checksum (call_frame_t *loop_frame, xlator_t *this)
         return 0;
 }
 
+static int
+sh_merkle_push (afr_self_heal_t *loop_sh, off_t offset, off_t len)
+{
+        loop_sh->merkle_ranges[2 * loop_sh->merkle_range_count]     = offset;
+        loop_sh->merkle_ranges[2 * loop_sh->merkle_range_count + 1] = len;
+        loop_sh->merkle_range_count++;
+
+        return 0;
+}
+
+/* pushes the parts of the range, the first one last so that it is
+   compared next */
+static int
+sh_merkle_split (afr_self_heal_t *loop_sh, off_t offset, off_t len)
+{
+        off_t  step  = 0;
+        off_t  part  = 0;
+        int    count = 0;
+
+        step = len / AFR_SH_MERKLE_FANOUT;
+        step = ((step + loop_sh->merkle_leaf_size - 1) /
+                loop_sh->merkle_leaf_size) * loop_sh->merkle_leaf_size;
+        if (step < loop_sh->merkle_leaf_size)
+                step = loop_sh->merkle_leaf_size;
+
+        count = (len + step - 1) / step;
+        while (count--) {
+                part = offset + count * step;
+                sh_merkle_push (loop_sh, part, min (step, offset + len - part));
+        }
+
+        return 0;
+}
+
+static int
+sh_merkle_next (call_frame_t *loop_frame, xlator_t *this)
+{
+        afr_private_t           *priv       = NULL;
+        afr_local_t             *loop_local = NULL;
+        afr_self_heal_t         *loop_sh    = NULL;
+        int                      i          = 0;
+
+        priv       = this->private;
+        loop_local = loop_frame->local;
+        loop_sh    = &loop_local->self_heal;
+
+        if (!loop_sh->merkle_range_count) {
+                /* the region is in sync */
+                sh_loop_return (loop_sh->sh_frame, this, loop_frame, 0, 0);
+                goto out;
+        }
+
+        i = --loop_sh->merkle_range_count;
+        loop_sh->offset     = loop_sh->merkle_ranges[2 * i];
+        loop_sh->block_size = loop_sh->merkle_ranges[2 * i + 1];
+
+        memset (loop_sh->write_needed, 0,
+                priv->child_count * sizeof (*loop_sh->write_needed));
+
+        sh_diff_checksum (loop_frame, this);
+out:
+        return 0;
+}
+
+static int
+sh_merkle_checksum_done (call_frame_t *loop_frame, xlator_t *this,
+                         int write_needed)
+{
+        afr_local_t             *loop_local = NULL;
+        afr_self_heal_t         *loop_sh    = NULL;
+        afr_local_t             *sh_local   = NULL;
+        afr_self_heal_t         *sh         = NULL;
+        afr_sh_algo_private_t   *sh_priv    = NULL;
+
+        loop_local = loop_frame->local;
+        loop_sh    = &loop_local->self_heal;
+        sh_local   = loop_sh->sh_frame->local;
+        sh         = &sh_local->self_heal;
+        sh_priv    = sh->private;
+
+        if (sh->op_failed) {
+                sh_loop_return (loop_sh->sh_frame, this, loop_frame, 0, 0);
+                goto out;
+        }
+
+        if (!write_needed) {
+                sh_merkle_next (loop_frame, this);
+                goto out;
+        }
+
+        if (loop_sh->block_size > loop_sh->merkle_leaf_size) {
+                gf_log (this->name, GF_LOG_TRACE, "range %"PRId64" %"PRId64
+                        " of %s differs, comparing its parts",
+                        loop_sh->offset, (int64_t) loop_sh->block_size,
+                        sh_local->loc.path);
+                sh_merkle_split (loop_sh, loop_sh->offset,
+                                 loop_sh->block_size);
+                sh_merkle_next (loop_frame, this);
+                goto out;
+        }
+
+        LOCK (&sh_priv->lock);
+        {
+                sh_priv->diff_blocks++;
+        }
+        UNLOCK (&sh_priv->lock);
+
+        sh_loop_read (loop_frame, this);
+out:
+        return 0;
+}
+
+static int
+sh_merkle_start (call_frame_t *loop_frame, xlator_t *this)
+{
+        afr_local_t             *loop_local = NULL;
+        afr_self_heal_t         *loop_sh    = NULL;
+        afr_local_t             *sh_local   = NULL;
+        afr_self_heal_t         *sh         = NULL;
+        afr_sh_algo_private_t   *sh_priv    = NULL;
+        off_t                    len        = 0;
+
+        loop_local = loop_frame->local;
+        loop_sh    = &loop_local->self_heal;
+        sh_local   = loop_sh->sh_frame->local;
+        sh         = &sh_local->self_heal;
+        sh_priv    = sh->private;
+
+        /* the deepest descent leaves FANOUT - 1 siblings per level */
+        loop_sh->merkle_ranges = GF_CALLOC (2 * (AFR_SH_MERKLE_LEVELS *
+                                                 AFR_SH_MERKLE_FANOUT + 1),
+                                            sizeof (*loop_sh->merkle_ranges),
+                                            gf_afr_mt_sh_diff_loop_state);
+        if (!loop_sh->merkle_ranges) {
+                sh_loop_return (loop_sh->sh_frame, this, loop_frame,
+                                -1, ENOMEM);
+                goto out;
+        }
+        loop_sh->merkle_range_count = 0;
+
+        len = min (loop_sh->block_size, sh->file_size - loop_sh->offset);
+
+        LOCK (&sh_priv->lock);
+        {
+                sh_priv->total_blocks += (len + loop_sh->merkle_leaf_size - 1)
+                        / loop_sh->merkle_leaf_size;
+        }
+        UNLOCK (&sh_priv->lock);
+
+        sh_merkle_push (loop_sh, loop_sh->offset, len);
+        sh_merkle_next (loop_frame, this);
+out:
+        return 0;
+}
+
 static int
 sh_full_read_write_to_sinks (call_frame_t *loop_frame, xlator_t *this)
 {
@@ -776,6 +1133,25 @@ afr_sh_algo_diff (call_frame_t *sh_frame, xlator_t *this)
         return 0;
 }
 
+/* loops lock and compare whole regions, see sh_merkle_start () */
+int
+afr_sh_algo_merkle (call_frame_t *sh_frame, xlator_t *this)
+{
+        afr_local_t             *local = NULL;
+        afr_self_heal_t         *sh    = NULL;
+        int                      i     = 0;
+
+        local = sh_frame->local;
+        sh    = &local->self_heal;
+
+        sh->merkle_leaf_size = sh->block_size;
+        for (i = 0; i < AFR_SH_MERKLE_LEVELS; i++)
+                sh->block_size *= AFR_SH_MERKLE_FANOUT;
+
+        afr_sh_start_loops (sh_frame, this, sh_merkle_start);
+        return 0;
+}
+
 int
 afr_sh_algo_full (call_frame_t *sh_frame, xlator_t *this)
 {
@@ -786,5 +1162,6 @@ afr_sh_algo_full (call_frame_t *sh_frame, xlator_t *this)
 struct afr_sh_algorithm afr_self_heal_algorithms[] = {
         {.name = "full",  .fn = afr_sh_algo_full},
         {.name = "diff",  .fn = afr_sh_algo_diff},
+        {.name = "merkle", .fn = afr_sh_algo_merkle},
         {0, 0},
 };
@@ -29,7 +29,7 @@ struct afr_sh_algorithm {
         afr_sh_algo_fn fn;
 };
 
-extern struct afr_sh_algorithm afr_self_heal_algorithms[3];
+extern struct afr_sh_algorithm afr_self_heal_algorithms[4];
 typedef struct {
         gf_lock_t lock;
         unsigned int loops_running;
@@ -37,6 +37,7 @@ typedef struct {
 
         int32_t total_blocks;
         int32_t diff_blocks;
+        off_t   skipped;   /* bytes of holes on all the children */
 } afr_sh_algo_private_t;
 
 #endif /* __AFR_SELF_HEAL_ALGORITHM_H__ */
@@ -1986,6 +1986,51 @@ out:
         return lc;
 }
 
+/* Queues a background self-heal behind the running ones, those of files
+ * with open fds ahead of the others. */
+static void
+__afr_self_heal_enqueue (afr_private_t *priv, call_frame_t *sh_frame)
+{
+        afr_local_t      *sh_local = NULL;
+        afr_self_heal_t  *sh       = NULL;
+        afr_self_heal_t  *waiting  = NULL;
+        struct list_head *pos      = NULL;
+
+        sh_local = sh_frame->local;
+        sh       = &sh_local->self_heal;
+        sh->sh_frame = sh_frame;
+
+        pos = &priv->heal_waitq;
+        if (sh->open_fd_heal) {
+                list_for_each_entry (waiting, &priv->heal_waitq, heal_wait) {
+                        if (!waiting->open_fd_heal) {
+                                pos = &waiting->heal_wait;
+                                break;
+                        }
+                }
+        }
+
+        /* goes right before pos */
+        list_add_tail (&sh->heal_wait, pos);
+        priv->heal_waiting++;
+}
+
+static call_frame_t *
+__afr_self_heal_dequeue (afr_private_t *priv)
+{
+        afr_self_heal_t *sh = NULL;
+
+        if (list_empty (&priv->heal_waitq))
+                return NULL;
+
+        sh = list_entry (priv->heal_waitq.next, afr_self_heal_t, heal_wait);
+        list_del_init (&sh->heal_wait);
+        priv->heal_waiting--;
+        priv->background_self_heals_started++;
+
+        return sh->sh_frame;
+}
+
 int
 afr_self_heal_completion_cbk (call_frame_t *bgsh_frame, xlator_t *this)
 {
@@ -1994,6 +2039,7 @@ afr_self_heal_completion_cbk (call_frame_t *bgsh_frame, xlator_t *this)
         afr_self_heal_t * sh    = NULL;
         char              sh_type_str[256] = {0,};
         gf_boolean_t      split_brain = _gf_false;
+        call_frame_t     *next  = NULL;
 
         priv  = this->private;
         local = bgsh_frame->local;
@@ -2024,12 +2070,16 @@ afr_self_heal_completion_cbk (call_frame_t *bgsh_frame, xlator_t *this)
                 LOCK (&priv->lock);
                 {
                         priv->background_self_heals_started--;
+                        next = __afr_self_heal_dequeue (priv);
                 }
                 UNLOCK (&priv->lock);
         }
 
         AFR_STACK_DESTROY (bgsh_frame);
 
+        if (next)
+                afr_self_heal_start (next, this);
+
         return 0;
 }
 
@@ -2045,7 +2095,7 @@ afr_self_heal (call_frame_t *frame, xlator_t *this, inode_t *inode)
         afr_self_heal_t *orig_sh = NULL;
         call_frame_t    *sh_frame = NULL;
         afr_local_t     *sh_local = NULL;
-        loc_t           *loc   = NULL;
+        gf_boolean_t     queued = _gf_false;
 
         local = frame->local;
         orig_sh = &local->self_heal;
@@ -2126,14 +2176,38 @@ afr_self_heal (call_frame_t *frame, xlator_t *this, inode_t *inode)
                 goto out;
         }
 
+        if (!local->loc.name) {
+                /* nameless lookup */
+                sh->do_missing_entry_self_heal = _gf_false;
+                sh->do_gfid_self_heal = _gf_false;
+        }
+
         if (local->self_heal.background) {
+                LOCK (&inode->lock);
+                {
+                        sh->open_fd_heal = !list_empty (&inode->fd_list);
+                }
+                UNLOCK (&inode->lock);
+
                 LOCK (&priv->lock);
                 {
                         if (priv->background_self_heals_started
                             < priv->background_self_heal_count) {
                                 priv->background_self_heals_started++;
-
-
+                        } else if (priv->background_self_heals_started &&
+                                   (priv->heal_waiting
+                                    < priv->heal_wait_qlength) &&
+                                   !sh->do_missing_entry_self_heal &&
+                                   !sh->do_gfid_self_heal &&
+                                   !sh->do_entry_self_heal) {
+                                /* one of the running ones starts it, the
+                                   fop is answered now instead of behind
+                                   the heals of other files. Entry and gfid
+                                   heals fill in its reply, they are not
+                                   queued. */
+                                sh->unwound = _gf_true;
+                                __afr_self_heal_enqueue (priv, sh_frame);
+                                queued = _gf_true;
                         } else {
                                 local->self_heal.background = _gf_false;
                                 sh->background = _gf_false;
@@ -2142,12 +2216,35 @@ afr_self_heal (call_frame_t *frame, xlator_t *this, inode_t *inode)
                 UNLOCK (&priv->lock);
         }
 
-        if (!local->loc.name) {
-                /* nameless lookup */
-                sh->do_missing_entry_self_heal = _gf_false;
-                sh->do_gfid_self_heal = _gf_false;
+        op_errno = 0;
+        if (queued) {
+                gf_log (this->name, GF_LOG_DEBUG, "self-heal of %s waits for "
+                        "a running one to finish", local->loc.path);
+                /* sh may be started and gone already */
+                orig_sh->unwind (frame, this, 0, 0);
+                goto out;
         }
 
+        afr_self_heal_start (sh_frame, this);
+out:
+        if (op_errno) {
+                orig_sh->unwind (frame, this, -1, op_errno);
+        }
+        return 0;
+}
+
+int
+afr_self_heal_start (call_frame_t *sh_frame, xlator_t *this)
+{
+        afr_local_t     *sh_local = NULL;
+        afr_self_heal_t *sh       = NULL;
+        loc_t           *loc      = NULL;
+        inode_t         *inode    = NULL;
+
+        sh_local = sh_frame->local;
+        sh       = &sh_local->self_heal;
+        inode    = sh->inode;
+
         FRAME_SU_DO (sh_frame, afr_local_t);
         if (sh->do_missing_entry_self_heal) {
                 afr_self_heal_conflicting_entries (sh_frame, this);
@@ -2164,16 +2261,11 @@ afr_self_heal (call_frame_t *frame, xlator_t *this, inode_t *inode)
                 }
                 gf_log (this->name, GF_LOG_TRACE,
                         "proceeding to metadata check on %s",
-                        local->loc.path);
+                        sh_local->loc.path);
 
                 afr_sh_missing_entries_done (sh_frame, this);
         }
-        op_errno = 0;
 
-out:
-        if (op_errno) {
-                orig_sh->unwind (frame, this, -1, op_errno);
-        }
         return 0;
 }
 
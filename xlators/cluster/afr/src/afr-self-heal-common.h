@@ -108,6 +108,8 @@ afr_sh_data_unlock (call_frame_t *frame, xlator_t *this,
 afr_local_t *
 afr_local_copy (afr_local_t *l, xlator_t *this);
 int
+afr_self_heal_start (call_frame_t *sh_frame, xlator_t *this);
+int
 afr_sh_data_lock (call_frame_t *frame, xlator_t *this,
                   off_t start, off_t len,
                   afr_lock_cbk_t success_handler,
@@ -544,6 +544,152 @@ afr_sh_data_sync_prepare (call_frame_t *frame, xlator_t *this)
         return 0;
 }
 
+int
+afr_sh_data_trim_sinks (call_frame_t *frame, xlator_t *this);
+
+static int
+afr_sh_data_extents_parse (afr_self_heal_t *sh, int child, dict_t *xattr)
+{
+        uint64_t *extents = NULL;
+        int       len     = 0;
+        int       count   = 0;
+        int       i       = 0;
+
+        if (dict_get_ptr_and_len (xattr, GF_XATTR_DATA_EXTENTS_KEY,
+                                  (void **)&extents, &len))
+                return -1;
+
+        count = len / (2 * sizeof (*extents));
+        if (!count)
+                return -1;
+
+        sh->data_extents[child] = GF_CALLOC (2 * count,
+                                             sizeof (**sh->data_extents),
+                                             gf_afr_mt_data_extents_t);
+        if (!sh->data_extents[child])
+                return -1;
+
+        for (i = 0; i < 2 * count; i++)
+                sh->data_extents[child][i] = ntoh64 (extents[i]);
+        sh->data_extent_count[child] = count;
+
+        return 0;
+}
+
+
+int
+afr_sh_data_extents_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                         int32_t op_ret, int32_t op_errno, dict_t *xattr)
+{
+        afr_private_t   *priv        = NULL;
+        afr_local_t     *local       = NULL;
+        afr_self_heal_t *sh          = NULL;
+        int              call_count  = 0;
+        int              child_index = 0;
+        int              i           = 0;
+
+        priv = this->private;
+        local = frame->local;
+        sh = &local->self_heal;
+
+        child_index = (long) cookie;
+
+        LOCK (&frame->lock);
+        {
+                if (op_ret == -1)
+                        gf_log (this->name, GF_LOG_DEBUG,
+                                "data extents of %s on subvolume %s "
+                                "unknown (%s)", local->loc.path,
+                                priv->children[child_index]->name,
+                                strerror (op_errno));
+                else
+                        afr_sh_data_extents_parse (sh, child_index, xattr);
+        }
+        UNLOCK (&frame->lock);
+
+        call_count = afr_frame_return (frame);
+
+        if (call_count == 0) {
+                /* holes are skipped only if known on every child healed */
+                for (i = 0; i < priv->child_count; i++) {
+                        if (sh->sources[i] && (i != sh->source))
+                                continue;
+                        if (!sh->sources[i] && !local->child_up[i])
+                                continue;
+                        if (!sh->data_extents[i])
+                                break;
+                }
+
+                if (i < priv->child_count) {
+                        for (i = 0; i < priv->child_count; i++)
+                                GF_FREE (sh->data_extents[i]);
+                        GF_FREE (sh->data_extents);
+                        sh->data_extents = NULL;
+                }
+
+                afr_sh_data_sync_prepare (frame, this);
+        }
+
+        return 0;
+}
+
+
+/* Fetches the data extents of a sparse source and of the sinks, with
+ * which the loops skip the holes in all of them. */
+int
+afr_sh_data_extents (call_frame_t *frame, xlator_t *this)
+{
+        afr_private_t   *priv       = NULL;
+        afr_local_t     *local      = NULL;
+        afr_self_heal_t *sh         = NULL;
+        int              call_count = 0;
+        int              i          = 0;
+
+        priv = this->private;
+        local = frame->local;
+        sh = &local->self_heal;
+
+        if (!sh->file_has_holes)
+                goto out;
+
+        sh->data_extents = GF_CALLOC (priv->child_count,
+                                      sizeof (*sh->data_extents),
+                                      gf_afr_mt_data_extents_t);
+        sh->data_extent_count = GF_CALLOC (priv->child_count,
+                                           sizeof (*sh->data_extent_count),
+                                           gf_afr_mt_int);
+        if (!sh->data_extents || !sh->data_extent_count) {
+                GF_FREE (sh->data_extents);
+                sh->data_extents = NULL;
+                goto out;
+        }
+
+        call_count = sh->active_sinks + 1;
+        local->call_count = call_count;
+
+        for (i = 0; i < priv->child_count; i++) {
+                if (sh->sources[i] && (i != sh->source))
+                        continue;
+                if (!sh->sources[i] && !local->child_up[i])
+                        continue;
+
+                STACK_WIND_COOKIE (frame, afr_sh_data_extents_cbk,
+                                   (void *) (long) i,
+                                   priv->children[i],
+                                   priv->children[i]->fops->fgetxattr,
+                                   sh->healing_fd, GF_XATTR_DATA_EXTENTS_KEY);
+
+                if (!--call_count)
+                        break;
+        }
+
+        return 0;
+out:
+        afr_sh_data_sync_prepare (frame, this);
+        return 0;
+}
+
+
 int
 afr_sh_data_trim_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                       int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
@@ -551,34 +697,46 @@ afr_sh_data_trim_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 {
         afr_private_t * priv = NULL;
         afr_local_t * local  = NULL;
+        afr_self_heal_t *sh  = NULL;
         int              call_count = 0;
         int              child_index = 0;
 
         priv = this->private;
         local = frame->local;
+        sh = &local->self_heal;
 
         child_index = (long) cookie;
 
         LOCK (&frame->lock);
         {
-                if (op_ret == -1)
+                if (op_ret == -1) {
                         gf_log (this->name, GF_LOG_INFO,
                                 "ftruncate of %s on subvolume %s failed (%s)",
                                 local->loc.path,
                                 priv->children[child_index]->name,
                                 strerror (op_errno));
-                else
+                        if (sh->empty_sinks)
+                                sh->sinks_emptied = _gf_false;
+                } else {
                         gf_log (this->name, GF_LOG_DEBUG,
                                 "ftruncate of %s on subvolume %s completed",
                                 local->loc.path,
                                 priv->children[child_index]->name);
+                }
         }
         UNLOCK (&frame->lock);
 
         call_count = afr_frame_return (frame);
 
-        if (call_count == 0)
-                afr_sh_data_sync_prepare (frame, this);
+        if (call_count == 0) {
+                if (sh->empty_sinks) {
+                        /* now up to the size of the source */
+                        sh->empty_sinks = _gf_false;
+                        afr_sh_data_trim_sinks (frame, this);
+                } else {
+                        afr_sh_data_extents (frame, this);
+                }
+        }
 
         return 0;
 }
@@ -593,6 +751,7 @@ afr_sh_data_trim_sinks (call_frame_t *frame, xlator_t *this)
         int             *sources = NULL;
         int              call_count = 0;
         int              i = 0;
+        off_t            size = 0;
 
 
         priv = this->private;
@@ -604,6 +763,12 @@ afr_sh_data_trim_sinks (call_frame_t *frame, xlator_t *this)
 
         local->call_count = call_count;
 
+        size = sh->file_size;
+        if (sh->empty_sinks) {
+                size = 0;
+                sh->sinks_emptied = _gf_true;
+        }
+
         for (i = 0; i < priv->child_count; i++) {
                 if (sources[i] || !local->child_up[i])
                         continue;
@@ -612,7 +777,7 @@ afr_sh_data_trim_sinks (call_frame_t *frame, xlator_t *this)
                                    (void *) (long) i,
                                    priv->children[i],
                                    priv->children[i]->fops->ftruncate,
-                                   sh->healing_fd, sh->file_size);
+                                   sh->healing_fd, size);
 
                 if (!--call_count)
                         break;
@@ -653,6 +818,7 @@ afr_sh_data_fix (call_frame_t *frame, xlator_t *this)
         int              source = 0;
         int              i = 0;
         int              ret = 0;
+        struct afr_sh_algorithm *algo = NULL;
 
         local = frame->local;
         sh = &local->self_heal;
@@ -725,7 +891,7 @@ afr_sh_data_fix (call_frame_t *frame, xlator_t *this)
                         sh->sources[i] = 0;
         }
 
-        if (sh->background && sh->unwind) {
+        if (sh->background && sh->unwind && !sh->unwound) {
                 sh->unwind (sh->orig_frame, this, sh->op_ret, sh->op_errno);
                 sh->unwound = _gf_true;
         }
@@ -739,6 +905,12 @@ afr_sh_data_fix (call_frame_t *frame, xlator_t *this)
                 return 0;
         }
 
+        /* a full heal rewrites all the data anyway, so the sinks are
+           emptied and blocks of zeros left as holes */
+        algo = afr_sh_data_pick_algo (frame, this);
+        if (sh->file_has_holes && algo && !strcmp (algo->name, "full"))
+                sh->empty_sinks = _gf_true;
+
         gf_log (this->name, GF_LOG_DEBUG,
                 "self-healing file %s from subvolume %s to %d other",
                 local->loc.path, priv->children[sh->source]->name,
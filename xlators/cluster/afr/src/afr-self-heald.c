@@ -204,6 +204,158 @@ out:
         return ret;
 }
 
+/* Looks up the gfids listed in one readdirp of an index, the lookup of
+ * replicate self-heals each of them. */
+static int
+_perform_index_self_heal (xlator_t *this, inode_table_t *itable,
+                          gf_dirent_t *entries, off_t *offset)
+{
+        gf_dirent_t      *entry = NULL;
+        gf_dirent_t      *tmp = NULL;
+        struct iatt      iatt = {0};
+        struct iatt      parent = {0};
+        uuid_t           gfid = {0};
+        loc_t            entry_loc = {0};
+        int              ret = 0;
+
+        list_for_each_entry_safe (entry, tmp, &entries->list, list) {
+                *offset = entry->d_off;
+                if (uuid_parse (entry->d_name, gfid))
+                        continue;
+
+                entry_loc.inode = inode_new (itable);
+                if (!entry_loc.inode) {
+                        ret = -1;
+                        goto out;
+                }
+                uuid_copy (entry_loc.gfid, gfid);
+                ret = gf_asprintf ((char **)&entry_loc.path, "<gfid:%s>",
+                                   entry->d_name);
+                if (ret < 0)
+                        goto out;
+
+                gf_log (this->name, GF_LOG_DEBUG, "lookup %s", entry_loc.path);
+
+                //Don't fail the crawl if lookup fails as it
+                //could be because of split-brain
+                syncop_lookup (this, &entry_loc, NULL, &iatt, NULL, &parent);
+                loc_wipe (&entry_loc);
+        }
+        ret = 0;
+out:
+        loc_wipe (&entry_loc);
+        return ret;
+}
+
+/* Heals the files entered in the index of the brick @child instead of
+ * crawling the whole namespace. Fails when the brick keeps no index. */
+static int
+_crawl_index (xlator_t *this, int child, pid_t pid)
+{
+        afr_private_t   *priv = NULL;
+        xlator_t        *subvol = NULL;
+        dict_t          *xattr = NULL;
+        char            *index_gfid = NULL;
+        fd_t            *fd   = NULL;
+        loc_t           rootloc = {0};
+        loc_t           loc = {0};
+        off_t           offset   = 0;
+        gf_dirent_t     entries;
+        int             ret = -1;
+
+        INIT_LIST_HEAD (&entries.list);
+        priv = this->private;
+        subvol = priv->children[child];
+
+        afr_build_root_loc (priv->root_inode, &rootloc);
+        ret = syncop_getxattr (subvol, &rootloc, &xattr,
+                               GF_XATTROP_INDEX_GFID);
+        if (ret)
+                goto out;
+
+        ret = dict_get_str (xattr, GF_XATTROP_INDEX_GFID, &index_gfid);
+        if (ret)
+                goto out;
+
+        ret = -1;
+        loc.inode = inode_new (priv->root_inode->table);
+        if (!loc.inode)
+                goto out;
+        if (uuid_parse (index_gfid, loc.gfid))
+                goto out;
+        uuid_copy (loc.inode->gfid, loc.gfid);
+        loc.inode->ia_type = IA_IFDIR;
+        if (gf_asprintf ((char **)&loc.path, "<gfid:%s>", index_gfid) < 0)
+                goto out;
+
+        fd = fd_create (loc.inode, pid);
+        if (!fd)
+                goto out;
+
+        ret = syncop_opendir (subvol, &loc, fd);
+        if (ret < 0) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "opendir of the index failed on %s", subvol->name);
+                goto out;
+        }
+
+        gf_log (this->name, GF_LOG_DEBUG, "crawling the index of %s",
+                subvol->name);
+
+        while ((ret = syncop_readdirp (subvol, fd, 131072, offset,
+                                       &entries)) > 0) {
+                if (afr_up_children_count (priv->child_up,
+                                           priv->child_count) < 2) {
+                        gf_log (this->name, GF_LOG_ERROR, "Stopping crawl as "
+                                "< 2 children are up");
+                        ret = -1;
+                        goto out;
+                }
+
+                ret = _perform_index_self_heal (this, loc.inode->table,
+                                                &entries, &offset);
+                gf_dirent_free (&entries);
+                if (ret)
+                        goto out;
+        }
+out:
+        gf_dirent_free (&entries);
+        if (fd)
+                fd_unref (fd);
+        loc_wipe (&loc);
+        if (xattr)
+                dict_unref (xattr);
+        return ret;
+}
+
+/* Crawls the indices of all the local bricks, 1 is returned when one of
+ * them does not keep an index and the namespace has to be crawled. */
+static int
+afr_crawl_indices (xlator_t *this, pid_t pid)
+{
+        afr_private_t    *priv = NULL;
+        int              i = 0;
+        int              ret = 0;
+
+        priv = this->private;
+
+        for (i = 0; i < priv->child_count; i++) {
+                if ((priv->shd.pos[i] != AFR_POS_LOCAL) ||
+                    (priv->child_up[i] != 1))
+                        continue;
+
+                if (_crawl_index (this, i, pid)) {
+                        gf_log (this->name, GF_LOG_INFO, "index of %s could "
+                                "not be crawled, crawling the namespace",
+                                priv->children[i]->name);
+                        ret = 1;
+                        break;
+                }
+        }
+
+        return ret;
+}
+
 int
 afr_find_child_position (xlator_t *this, int child)
 {
@@ -382,7 +534,9 @@ afr_crawl_directory (xlator_t *this, pid_t pid)
 
         afr_build_root_loc (priv->root_inode, &loc);
         while (crawl) {
-                ret = _crawl_directory (&loc, pid);
+                ret = afr_crawl_indices (this, pid);
+                if (ret)
+                        ret = _crawl_directory (&loc, pid);
                 if (ret)
                         gf_log (this->name, GF_LOG_ERROR, "Crawl failed");
                 else
@@ -26,12 +26,24 @@
 
 #include <signal.h>
 
+int
+afr_changelog_post_op (call_frame_t *frame, xlator_t *this);
+
+static void
+afr_delayed_changelog_post_op_done (call_frame_t *frame, xlator_t *this);
+
+static void
+afr_transaction_eager_lock_contended (call_frame_t *frame, xlator_t *this);
+
 
 #define LOCKED_NO       0x0        /* no lock held */
 #define LOCKED_YES      0x1        /* for DATA, METADATA, ENTRY and higher_path
                                       of RENAME */
 #define LOCKED_LOWER    0x2        /* for lower_path of RENAME */
 
+#define AFR_EAGER_LOCK_MAX_HOLD 5  /* seconds an eager lock is kept before
+                                      letting others waiting for it in */
+
 
 afr_fd_ctx_t *
 __afr_fd_ctx_get (fd_t *fd, xlator_t *this)
@@ -260,6 +272,10 @@ __fop_changelog_needed (call_frame_t *frame, xlator_t *this)
 
                 case GF_FOP_WRITE:
                 case GF_FOP_FTRUNCATE:
+                case GF_FOP_FALLOCATE:
+                case GF_FOP_DISCARD:
+                case GF_FOP_ZEROFILL:
+                case GF_FOP_COPY_FILE_RANGE:
                         op_ret = 1;
                         break;
 
@@ -378,6 +394,8 @@ afr_changelog_post_op_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         UNLOCK (&frame->lock);
 
         if (call_count == 0) {
+                afr_delayed_changelog_post_op_done (frame, this);
+
                 if (afr_lock_server_count (priv, local->transaction.type) == 0) {
                         local->transaction.done (frame, this);
                 } else {
@@ -499,6 +517,167 @@ afr_changelog_post_op_call_count (afr_transaction_type type,
         return call_count;
 }
 
+/* {{{ delayed post-op */
+
+/* Resumes whoever waited (flush, fsync) for the changelog post-op which
+   had been delayed by this transaction. */
+static void
+afr_delayed_changelog_post_op_done (call_frame_t *frame, xlator_t *this)
+{
+        afr_local_t *local = NULL;
+        call_stub_t *stub  = NULL;
+
+        local = frame->local;
+
+        stub = local->transaction.resume_stub;
+        local->transaction.resume_stub = NULL;
+
+        if (stub)
+                call_resume (stub);
+}
+
+
+/* With the eager lock held, the post-op of a write which succeeded on
+   all the children can wait: a write which follows finds the changelog
+   still dirty and skips its pre-op (and post-op, see pre_op_piggyback).
+   Failures are always recorded right away. */
+static gf_boolean_t
+afr_changelog_post_op_delay_needed (call_frame_t *frame, xlator_t *this)
+{
+        afr_private_t *priv  = NULL;
+        afr_local_t   *local = NULL;
+        int            index = 0;
+        int            i     = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        if (!priv->post_op_delay_secs)
+                return _gf_false;
+
+        if (!local->transaction.eager_lock_on ||
+            local->transaction.post_op_delayed)
+                return _gf_false;
+
+        if (local->op != GF_FOP_WRITE)
+                return _gf_false;
+
+        index = afr_index_for_transaction_type (local->transaction.type);
+        for (i = 0; i < priv->child_count; i++) {
+                if (!priv->child_up[i] || !local->child_up[i] ||
+                    !local->transaction.pre_op[i] || !local->pending[i][index])
+                        return _gf_false;
+        }
+
+        return _gf_true;
+}
+
+
+static void
+afr_delayed_changelog_timeout (void *data)
+{
+        afr_delayed_changelog_wake_resume (THIS, (fd_t *)data, NULL);
+}
+
+
+/* Parks the transaction in the fd, keeping its lock and its dirty
+   changelog, until the fd has seen no write for post-op-delay-secs or
+   until it is woken up. Returns -1 if it has to go on now. */
+static int
+afr_delayed_changelog_post_op (call_frame_t *frame, xlator_t *this)
+{
+        afr_private_t  *priv   = NULL;
+        afr_local_t    *local  = NULL;
+        afr_fd_ctx_t   *fd_ctx = NULL;
+        struct timeval  delta  = {0, };
+        int             ret    = -1;
+
+        priv  = this->private;
+        local = frame->local;
+
+        fd_ctx = afr_fd_ctx_get (local->fd, this);
+        if (!fd_ctx)
+                goto out;
+
+        delta.tv_sec = priv->post_op_delay_secs;
+
+        /* for the timer */
+        fd_ref (local->fd);
+
+        LOCK (&local->fd->lock);
+        {
+                if (fd_ctx->delay_frame)
+                        goto unlock;
+
+                fd_ctx->delay_timer = gf_timer_call_after (this->ctx, delta,
+                                                afr_delayed_changelog_timeout,
+                                                local->fd);
+                if (!fd_ctx->delay_timer)
+                        goto unlock;
+
+                fd_ctx->delay_frame = frame;
+                ret = 0;
+        }
+unlock:
+        UNLOCK (&local->fd->lock);
+
+        if (ret)
+                fd_unref (local->fd);
+out:
+        return ret;
+}
+
+
+/* Does now the post-op delayed on @fd, if any. @stub (if not NULL) is
+   resumed once that post-op is done, or right away if there is none. */
+int
+afr_delayed_changelog_wake_resume (xlator_t *this, fd_t *fd,
+                                   call_stub_t *stub)
+{
+        afr_fd_ctx_t  *fd_ctx = NULL;
+        afr_local_t   *local  = NULL;
+        call_frame_t  *frame  = NULL;
+        gf_timer_t    *timer  = NULL;
+
+        fd_ctx = afr_fd_ctx_get (fd, this);
+        if (!fd_ctx)
+                goto resume;
+
+        LOCK (&fd->lock);
+        {
+                frame = fd_ctx->delay_frame;
+                fd_ctx->delay_frame = NULL;
+
+                timer = fd_ctx->delay_timer;
+                fd_ctx->delay_timer = NULL;
+        }
+        UNLOCK (&fd->lock);
+
+        if (timer) {
+                gf_timer_call_cancel (this->ctx, timer);
+                fd_unref (fd);
+        }
+
+        if (!frame)
+                goto resume;
+
+        local = frame->local;
+        local->transaction.post_op_delayed = _gf_true;
+        local->transaction.resume_stub = stub;
+
+        afr_changelog_post_op (frame, this);
+
+        return 0;
+
+resume:
+        if (stub)
+                call_resume (stub);
+
+        return 0;
+}
+
+/* }}} */
+
 int
 afr_changelog_post_op (call_frame_t *frame, xlator_t *this)
 {
@@ -518,6 +697,10 @@ afr_changelog_post_op (call_frame_t *frame, xlator_t *this)
         local    = frame->local;
         int_lock = &local->internal_lock;
 
+        if (afr_changelog_post_op_delay_needed (frame, this) &&
+            !afr_delayed_changelog_post_op (frame, this))
+                return 0;
+
         __mark_down_children (local->pending, priv->child_count,
                               local->child_up, local->transaction.type);
 
@@ -542,6 +725,7 @@ afr_changelog_post_op (call_frame_t *frame, xlator_t *this)
 
         if (call_count == 0) {
                 /* no child is up */
+                afr_delayed_changelog_post_op_done (frame, this);
                 int_lock->lock_cbk = local->transaction.done;
                 afr_unlock (frame, this);
                 goto out;
@@ -1004,6 +1188,8 @@ afr_post_nonblocking_inodelk_cbk (call_frame_t *frame, xlator_t *this)
         if (int_lock->lock_op_ret < 0) {
                 gf_log (this->name, GF_LOG_DEBUG,
                         "Non blocking inodelks failed. Proceeding to blocking");
+                if (local->transaction.eager_lock_on)
+                        afr_transaction_eager_lock_contended (frame, this);
                 int_lock->lock_cbk = afr_post_blocking_inodelk_cbk;
                 afr_blocking_lock (frame, this);
         } else {
@@ -1168,11 +1354,18 @@ afr_lock_rec (call_frame_t *frame, xlator_t *this)
 int
 afr_lock (call_frame_t *frame, xlator_t *this)
 {
+        afr_local_t *local = NULL;
+
+        local = frame->local;
+
         afr_pid_save (frame);
 
         frame->root->pid = (long) frame->root;
 
-        afr_set_lk_owner (frame, this);
+        if (local->transaction.eager_lock_on)
+                afr_set_fd_lk_owner (frame, this, local->fd);
+        else
+                afr_set_lk_owner (frame, this);
 
         afr_set_lock_number (frame, this);
 
@@ -1217,6 +1410,8 @@ afr_transaction_resume (call_frame_t *frame, xlator_t *this)
         int_lock = &local->internal_lock;
         priv     = this->private;
 
+        afr_transaction_eager_lock_done (local, this);
+
         if (__fop_changelog_needed (frame, this)) {
                 afr_changelog_post_op (frame, this);
         } else {
@@ -1250,6 +1445,175 @@ afr_transaction_fop_failed (call_frame_t *frame, xlator_t *this, int child_index
 }
 
 
+/* {{{ eager lock */
+
+static gf_boolean_t
+afr_are_multiple_fds_opened (inode_t *inode)
+{
+        fd_t *fd    = NULL;
+        int   count = 0;
+
+        LOCK (&inode->lock);
+        {
+                list_for_each_entry (fd, &inode->fd_list, inode_list) {
+                        if (++count > 1)
+                                break;
+                }
+        }
+        UNLOCK (&inode->lock);
+
+        return (count > 1);
+}
+
+
+/* Someone else holds a lock on the file: this transaction goes on with
+   a lock on its own range, and the fd stops holding the lock across
+   transactions for a while. */
+static void
+afr_transaction_eager_lock_contended (call_frame_t *frame, xlator_t *this)
+{
+        afr_local_t  *local  = NULL;
+        afr_fd_ctx_t *fd_ctx = NULL;
+
+        local = frame->local;
+
+        local->transaction.eager_lock_on = _gf_false;
+
+        fd_ctx = afr_fd_ctx_get (local->fd, this);
+        if (!fd_ctx)
+                return;
+
+        LOCK (&local->fd->lock);
+        {
+                fd_ctx->lock_contended = time (NULL);
+        }
+        UNLOCK (&local->fd->lock);
+
+        gf_log (this->name, GF_LOG_DEBUG,
+                "lock contention on fd %p, not using eager lock", local->fd);
+}
+
+
+static gf_boolean_t
+afr_transaction_ranges_overlap (afr_local_t *local1, afr_local_t *local2)
+{
+        uint64_t start1 = 0;
+        uint64_t start2 = 0;
+        uint64_t end1   = 0;
+        uint64_t end2   = 0;
+
+        /* a len of 0 is up to the end of the file */
+        start1 = local1->transaction.start;
+        end1 = local1->transaction.len ?
+                start1 + local1->transaction.len - 1 : ULLONG_MAX;
+
+        start2 = local2->transaction.start;
+        end2 = local2->transaction.len ?
+                start2 + local2->transaction.len - 1 : ULLONG_MAX;
+
+        return ((start1 <= end2) && (start2 <= end1));
+}
+
+
+/* true if a fop under the eager lock of the fd is in flight on a range
+   the transaction overlaps, to be called with fd->lock held */
+static gf_boolean_t
+__afr_transaction_eager_overlaps (afr_fd_ctx_t *fd_ctx, afr_local_t *local)
+{
+        afr_local_t *each = NULL;
+
+        list_for_each_entry (each, &fd_ctx->eager_transactions,
+                             transaction.eager_list) {
+                if (afr_transaction_ranges_overlap (each, local))
+                        return _gf_true;
+        }
+
+        return _gf_false;
+}
+
+
+/* The fop of the transaction is done, the transactions which follow may
+   overlap its range under the eager lock. */
+void
+afr_transaction_eager_lock_done (afr_local_t *local, xlator_t *this)
+{
+        if (!local->transaction.eager_inflight)
+                return;
+
+        LOCK (&local->fd->lock);
+        {
+                list_del_init (&local->transaction.eager_list);
+                local->transaction.eager_inflight = _gf_false;
+        }
+        UNLOCK (&local->fd->lock);
+}
+
+
+/* Decides whether the data transaction reuses (or takes) the lock held
+   by its fd across transactions. A transaction which does not releases
+   the post-op delayed on the fd, as it would only wait for it.
+
+   The transactions sharing the eager lock are not serialized by it, so
+   the children could apply overlapping writes in different orders. A
+   transaction overlapping one whose fop is in flight takes a lock on its
+   own range instead, which waits for the eager lock to be given up. */
+static void
+afr_transaction_eager_lock_init (afr_local_t *local, xlator_t *this)
+{
+        afr_private_t *priv   = NULL;
+        afr_fd_ctx_t  *fd_ctx = NULL;
+        time_t         now    = 0;
+
+        priv = this->private;
+
+        if (!local->fd || (local->transaction.type != AFR_DATA_TRANSACTION))
+                return;
+
+        if (!priv->eager_lock || fd_is_anonymous (local->fd))
+                goto wake;
+
+        fd_ctx = afr_fd_ctx_get (local->fd, this);
+        if (!fd_ctx)
+                goto wake;
+
+        /* the other fds on the inode would wait for it */
+        if (afr_are_multiple_fds_opened (local->fd->inode))
+                goto wake;
+
+        now = time (NULL);
+
+        LOCK (&local->fd->lock);
+        {
+                if ((now - fd_ctx->lock_contended) < AFR_EAGER_LOCK_MAX_HOLD)
+                        goto unlock;
+
+                if (__afr_fd_eager_lock_held (fd_ctx, priv->child_count) &&
+                    ((now - fd_ctx->lock_time) >= AFR_EAGER_LOCK_MAX_HOLD))
+                        goto unlock;
+
+                if (__afr_transaction_eager_overlaps (fd_ctx, local)) {
+                        gf_log (this->name, GF_LOG_DEBUG,
+                                "transaction overlaps one in flight on fd "
+                                "%p, not using eager lock", local->fd);
+                        goto unlock;
+                }
+
+                local->transaction.eager_lock_on = _gf_true;
+                local->transaction.eager_inflight = _gf_true;
+                list_add_tail (&local->transaction.eager_list,
+                               &fd_ctx->eager_transactions);
+        }
+unlock:
+        UNLOCK (&local->fd->lock);
+
+        if (local->transaction.eager_lock_on)
+                return;
+wake:
+        afr_delayed_changelog_wake_resume (this, local->fd, NULL);
+}
+
+/* }}} */
+
 int
 afr_transaction (call_frame_t *frame, xlator_t *this, afr_transaction_type type)
 {
@@ -1264,6 +1628,8 @@ afr_transaction (call_frame_t *frame, xlator_t *this, afr_transaction_type type)
         local->transaction.resume = afr_transaction_resume;
         local->transaction.type   = type;
 
+        afr_transaction_eager_lock_init (local, this);
+
         if (afr_lock_server_count (priv, local->transaction.type) == 0) {
                 afr_internal_lock_finish (frame, this);
         } else {
@@ -101,6 +101,26 @@ fix_quorum_options (xlator_t *this, afr_private_t *priv, char *qtype)
         }
 }
 
+int
+afr_read_policy_parse (xlator_t *this, afr_private_t *priv, char *policy)
+{
+        if (!strcmp (policy, "static"))
+                priv->read_policy = AFR_READ_POLICY_STATIC;
+        else if (!strcmp (policy, "inode-hash"))
+                priv->read_policy = AFR_READ_POLICY_INODE_HASH;
+        else if (!strcmp (policy, "least-outstanding"))
+                priv->read_policy = AFR_READ_POLICY_LEAST_OUTSTANDING;
+        else if (!strcmp (policy, "latency"))
+                priv->read_policy = AFR_READ_POLICY_LATENCY;
+        else {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "unknown read-policy %s", policy);
+                return -1;
+        }
+
+        return 0;
+}
+
 int
 reconfigure (xlator_t *this, dict_t *options)
 {
@@ -109,6 +129,7 @@ reconfigure (xlator_t *this, dict_t *options)
         int            ret         = -1;
         int            index       = -1;
         char          *qtype       = NULL;
+        char          *read_policy = NULL;
 
         priv = this->private;
 
@@ -116,6 +137,12 @@ reconfigure (xlator_t *this, dict_t *options)
                           priv->background_self_heal_count, options, uint32,
                           out);
 
+        GF_OPTION_RECONF ("heal-wait-queue-length",
+                          priv->heal_wait_qlength, options, uint32, out);
+
+        GF_OPTION_RECONF ("data-self-heal-bandwidth", priv->sh_bandwidth,
+                          options, size, out);
+
         GF_OPTION_RECONF ("metadata-self-heal",
                           priv->metadata_self_heal, options, bool, out);
 
@@ -158,11 +185,20 @@ reconfigure (xlator_t *this, dict_t *options)
                 priv->read_child = index;
         }
 
+        GF_OPTION_RECONF ("eager-lock", priv->eager_lock, options, bool, out);
+
+        GF_OPTION_RECONF ("post-op-delay-secs", priv->post_op_delay_secs,
+                          options, uint32, out);
+
         GF_OPTION_RECONF ("quorum-type", qtype, options, str, out);
         GF_OPTION_RECONF ("quorum-count", priv->quorum_count, options,
                           uint32, out);
         fix_quorum_options(this,priv,qtype);
 
+        GF_OPTION_RECONF ("read-policy", read_policy, options, str, out);
+        if (afr_read_policy_parse (this, priv, read_policy))
+                goto out;
+
         ret = 0;
 out:
         return ret;
@@ -191,6 +227,7 @@ init (xlator_t *this)
         xlator_t      *read_subvol = NULL;
         xlator_t      *fav_child   = NULL;
         char          *qtype       = NULL;
+        char          *read_policy = NULL;
 
         if (!this->children) {
                 gf_log (this->name, GF_LOG_ERROR,
@@ -209,9 +246,11 @@ init (xlator_t *this)
         priv = this->private;
         LOCK_INIT (&priv->lock);
         LOCK_INIT (&priv->read_child_lock);
+        LOCK_INIT (&priv->sh_bandwidth_lock);
         //lock recovery is not done in afr
         pthread_mutex_init (&priv->mutex, NULL);
         INIT_LIST_HEAD (&priv->saved_fds);
+        INIT_LIST_HEAD (&priv->heal_waitq);
 
         child_count = xlator_subvolume_count (this);
 
@@ -248,6 +287,12 @@ init (xlator_t *this)
         GF_OPTION_INIT ("background-self-heal-count",
                         priv->background_self_heal_count, uint32, out);
 
+        GF_OPTION_INIT ("heal-wait-queue-length",
+                        priv->heal_wait_qlength, uint32, out);
+
+        GF_OPTION_INIT ("data-self-heal-bandwidth", priv->sh_bandwidth,
+                        size, out);
+
         GF_OPTION_INIT ("data-self-heal", priv->data_self_heal, str, out);
 
         GF_OPTION_INIT ("data-self-heal-algorithm",
@@ -279,10 +324,20 @@ init (xlator_t *this)
 
         GF_OPTION_INIT ("strict-readdir", priv->strict_readdir, bool, out);
 
+        GF_OPTION_INIT ("eager-lock", priv->eager_lock, bool, out);
+
+        GF_OPTION_INIT ("post-op-delay-secs", priv->post_op_delay_secs,
+                        uint32, out);
+
         GF_OPTION_INIT ("quorum-type", qtype, str, out);
         GF_OPTION_INIT ("quorum-count", priv->quorum_count, uint32, out);
         fix_quorum_options(this,priv,qtype);
 
+        GF_OPTION_INIT ("read-policy", read_policy, str, out);
+        ret = afr_read_policy_parse (this, priv, read_policy);
+        if (ret)
+                goto out;
+
         priv->wait_count = 1;
 
         priv->child_up = GF_CALLOC (sizeof (unsigned char), child_count,
@@ -306,6 +361,13 @@ init (xlator_t *this)
                 goto out;
         }
 
+        priv->read_stats = GF_CALLOC (sizeof (*priv->read_stats), child_count,
+                                      gf_afr_mt_read_stats_t);
+        if (!priv->read_stats) {
+                ret = -ENOMEM;
+                goto out;
+        }
+
         priv->pending_key = GF_CALLOC (sizeof (*priv->pending_key),
                                        child_count,
                                        gf_afr_mt_char);
@@ -399,6 +461,10 @@ struct xlator_fops fops = {
         .fsetxattr   = afr_fsetxattr,
         .setattr     = afr_setattr,
         .fsetattr    = afr_fsetattr,
+        .fallocate   = afr_fallocate,
+        .discard     = afr_discard,
+        .zerofill    = afr_zerofill,
+        .copy_file_range = afr_copy_file_range,
         .removexattr = afr_removexattr,
 
         /* dir read */
@@ -442,6 +508,23 @@ struct volume_options options[] = {
           .min  = 0,
           .default_value = "16",
         },
+        { .key  = {"heal-wait-queue-length"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 0,
+          .max  = 10000,
+          .default_value = "128",
+          .description = "Number of background self-heals which wait for "
+                         "one of the running ones to finish, those of files "
+                         "with open fds first. Beyond it files are healed in "
+                         "the foreground."
+        },
+        { .key  = {"data-self-heal-bandwidth"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .default_value = "0",
+          .description = "Bytes per second which all data self-heals of "
+                         "the volume may read from the sources, 0 for no "
+                         "limit."
+        },
         { .key  = {"data-self-heal"},
           .type = GF_OPTION_TYPE_STR,
           .default_value = "",
@@ -457,8 +540,11 @@ struct volume_options options[] = {
                            "\"full\" algorithm copies the entire file from "
                            "source to sink. The \"diff\" algorithm copies to "
                            "sink only those blocks whose checksums don't match "
-                           "with those of source.",
-          .value = { "diff", "full", "" }
+                           "with those of source. The \"merkle\" algorithm "
+                           "compares the checksums of large regions first, "
+                           "and those of smaller parts only where they "
+                           "differ.",
+          .value = { "diff", "full", "merkle", "" }
         },
         { .key  = {"data-self-heal-window-size"},
           .type = GF_OPTION_TYPE_INT,
@@ -508,6 +594,24 @@ struct volume_options options[] = {
           .type = GF_OPTION_TYPE_BOOL,
           .default_value = "off",
         },
+        { .key = {"eager-lock"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Keep the inode lock taken by a write transaction "
+                         "on an fd for the transactions which follow on the "
+                         "same fd, instead of unlocking and locking again "
+                         "for each of them.",
+        },
+        { .key = {"post-op-delay-secs"},
+          .type = GF_OPTION_TYPE_INT,
+          .min = 0,
+          .max = 60,
+          .default_value = "1",
+          .description = "With eager-lock, the changelog of a file being "
+                         "written to is cleared only after it has seen no "
+                         "writes for this many seconds, or at flush/fsync. "
+                         "0 clears it after every write.",
+        },
         { .key = {"quorum-type"},
           .type = GF_OPTION_TYPE_STR,
           .value = { "none", "auto", "fixed", "" },
@@ -527,5 +631,18 @@ struct volume_options options[] = {
                          "this many bricks or present.  Other quorum types "
                          "will OVERWRITE this value.",
         },
+        { .key = {"read-policy"},
+          .type = GF_OPTION_TYPE_STR,
+          .value = { "static", "inode-hash", "least-outstanding", "latency",
+                     "" },
+          .default_value = "static",
+          .description = "How the subvolume a read goes to is chosen among "
+                         "those known to be in sync. \"static\" uses "
+                         "read-subvolume, or the first one; \"inode-hash\" "
+                         "spreads files over them by gfid; "
+                         "\"least-outstanding\" picks the one with the "
+                         "fewest reads in flight and \"latency\" the one "
+                         "which answered reads the fastest lately.",
+        },
         { .key  = {NULL} },
 };
@@ -27,6 +27,7 @@
 #endif
 
 #include "call-stub.h"
+#include "timer.h"
 #include "compat-errno.h"
 #include "afr-mem-types.h"
 #include "afr-self-heal-algorithm.h"
@@ -95,12 +96,29 @@ typedef struct afr_self_heald_ {
         afr_child_pos_t *pos;
 } afr_self_heald_t;
 
+typedef enum {
+        AFR_READ_POLICY_STATIC,            /* read-subvolume or first fresh */
+        AFR_READ_POLICY_INODE_HASH,        /* gfid hashed on fresh children */
+        AFR_READ_POLICY_LEAST_OUTSTANDING, /* fewest reads in flight */
+        AFR_READ_POLICY_LATENCY,           /* lowest average read latency */
+} afr_read_policy_t;
+
+typedef struct {
+        uint64_t reads;        /* reads wound to the child */
+        int64_t  outstanding;  /* of those, not answered yet */
+        uint64_t latency;      /* moving average of the latency, usecs */
+} afr_read_stats_t;
+
 typedef struct _afr_private {
         gf_lock_t lock;               /* to guard access to child_count, etc */
         unsigned int child_count;     /* total number of children   */
 
         unsigned int read_child_rr;   /* round-robin index of the read_child */
-        gf_lock_t read_child_lock;    /* lock to protect above */
+        gf_lock_t read_child_lock;    /* lock to protect above and
+                                         read_stats */
+
+        afr_read_policy_t read_policy;
+        afr_read_stats_t *read_stats; /* per child */
 
         xlator_t **children;
 
@@ -118,6 +136,17 @@ typedef struct _afr_private {
 
         unsigned int background_self_heal_count;
         unsigned int background_self_heals_started;
+        /* background self-heals waiting for one of the above to finish,
+           those of files with open fds first */
+        struct list_head heal_waitq;
+        unsigned int heal_waiting;
+        unsigned int heal_wait_qlength;
+
+        /* bytes per second all data self-heals may read, 0 for no limit */
+        uint64_t       sh_bandwidth;
+        gf_lock_t      sh_bandwidth_lock;
+        int64_t        sh_bandwidth_credit;
+        struct timeval sh_bandwidth_stamp;
         gf_boolean_t metadata_self_heal;   /* on/off */
         gf_boolean_t entry_self_heal;      /* on/off */
 
@@ -146,6 +175,7 @@ typedef struct _afr_private {
         struct list_head saved_fds;   /* list of fds on which locks have succeeded */
         gf_boolean_t      optimistic_change_log;
         gf_boolean_t      eager_lock;
+        uint32_t          post_op_delay_secs;
         unsigned int      quorum_count;
 
         char                   vol_uuid[UUID_SIZE + 1];
@@ -241,8 +271,27 @@ typedef struct {
         off_t offset;
         unsigned char *write_needed;
         uint8_t *checksum;
+        /* merkle diff: size of the blocks compared last, and the ranges
+           of the loop's region still to be compared (offset, len) */
+        blksize_t merkle_leaf_size;
+        off_t *merkle_ranges;
+        int    merkle_range_count;
+        /* sparse files: a full heal truncates the sinks to 0 so that
+           blocks of zeros are left as holes, and the data extents of the
+           source and the sinks (offset, len pairs, per child) let the
+           loops skip the holes they have in common */
+        gf_boolean_t empty_sinks;
+        gf_boolean_t sinks_emptied;
+        off_t **data_extents;
+        int    *data_extent_count;
+        /* holds the read of a loop back under data-self-heal-bandwidth */
+        gf_timer_t *throttle_timer;
         afr_post_remove_call_t post_remove_call;
 
+        /* in priv->heal_waitq */
+        struct list_head heal_wait;
+        gf_boolean_t open_fd_heal;
+
         loc_t parent_loc;
 
         call_frame_t *orig_frame;
@@ -478,6 +527,7 @@ typedef struct _afr_local {
                         size_t size;
                         off_t offset;
                         int last_index;
+                        struct timeval start;
                 } readv;
 
                 /* dir read */
@@ -530,6 +580,40 @@ typedef struct _afr_local {
                         struct iatt postbuf;
                 } ftruncate;
 
+                struct {
+                        int32_t mode;
+                        off_t offset;
+                        size_t len;
+                        struct iatt prebuf;
+                        struct iatt postbuf;
+                } fallocate;
+
+                struct {
+                        off_t offset;
+                        size_t len;
+                        struct iatt prebuf;
+                        struct iatt postbuf;
+                } discard;
+
+                struct {
+                        off_t offset;
+                        size_t len;
+                        struct iatt prebuf;
+                        struct iatt postbuf;
+                } zerofill;
+
+                struct {
+                        fd_t *fd_in;
+                        off_t off_in;
+                        off_t off_out;
+                        size_t len;
+                        uint32_t flags;
+                        gf_boolean_t streamed;
+                        struct iatt stbuf_in;
+                        struct iatt prebuf;
+                        struct iatt postbuf;
+                } copy_file_range;
+
                 struct {
                         struct iatt in_buf;
                         int32_t valid;
@@ -646,6 +730,16 @@ typedef struct _afr_local {
                 off_t start, len;
 
                 int *eager_lock;
+                /* inode lock of the fd, held across transactions */
+                gf_boolean_t eager_lock_on;
+                /* post-op already delayed once, do it now */
+                gf_boolean_t post_op_delayed;
+                /* resumed once the delayed post-op is done */
+                call_stub_t *resume_stub;
+                /* in the eager transactions of the fd until its fop is
+                   done, see afr_transaction_eager_lock_init */
+                gf_boolean_t     eager_inflight;
+                struct list_head eager_list;
 
                 char *basename;
                 char *new_basename;
@@ -713,9 +807,38 @@ typedef struct {
 
         unsigned char *locked_on; /* which subvolumes locks have been successful */
 	struct list_head  paused_calls; /* queued calls while fix_open happens  */
+
+        /* eager lock: when it was taken, and the number of CHILD_DOWNs
+           seen then (a child which went down has dropped it) */
+        time_t         lock_time;
+        uint64_t       lock_down_count;
+        time_t         lock_contended; /* last time it could not be
+                                          taken at once */
+
+        /* transaction whose changelog post-op is being delayed */
+        call_frame_t  *delay_frame;
+        gf_timer_t    *delay_timer;
+
+        /* transactions under the eager lock whose fop is in flight */
+        struct list_head eager_transactions;
 } afr_fd_ctx_t;
 
 
+/* true while the eager lock of the fd is held on any of the children,
+   to be called with fd->lock held */
+static inline gf_boolean_t
+__afr_fd_eager_lock_held (afr_fd_ctx_t *fd_ctx, unsigned int child_count)
+{
+        unsigned int i = 0;
+
+        for (i = 0; i < child_count; i++)
+                if (fd_ctx->lock_acquired[i])
+                        return _gf_true;
+
+        return _gf_false;
+}
+
+
 /* try alloc and if it fails, goto label */
 #define ALLOC_OR_GOTO(var, type, label) do {                    \
                 var = GF_CALLOC (sizeof (type), 1,              \
@@ -762,6 +885,16 @@ afr_mark_locked_nodes (xlator_t *this, fd_t *fd,
 void
 afr_set_lk_owner (call_frame_t *frame, xlator_t *this);
 
+void
+afr_set_fd_lk_owner (call_frame_t *frame, xlator_t *this, fd_t *fd);
+
+int
+afr_delayed_changelog_wake_resume (xlator_t *this, fd_t *fd,
+                                   call_stub_t *stub);
+
+void
+afr_transaction_eager_lock_done (afr_local_t *local, xlator_t *this);
+
 int
 afr_set_lock_number (call_frame_t *frame, xlator_t *this);
 
@@ -926,9 +1059,15 @@ afr_set_read_ctx_from_policy (xlator_t *this, inode_t *inode,
 
 int32_t
 afr_get_call_child (xlator_t *this, unsigned char *child_up, int32_t read_child,
-                    int32_t *fresh_children,
+                    int32_t *fresh_children, inode_t *inode,
                     int32_t *call_child, int32_t *last_index);
 
+void
+afr_read_stats_begin (xlator_t *this, int32_t child);
+
+void
+afr_read_stats_end (xlator_t *this, int32_t child, struct timeval *start);
+
 int32_t
 afr_next_call_child (int32_t *fresh_children, unsigned char *child_up,
                      size_t child_count, int32_t *last_index,
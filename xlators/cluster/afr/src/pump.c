@@ -1430,7 +1430,7 @@ pump_getxattr (call_frame_t *frame, xlator_t *this,
 
         read_child = afr_inode_get_read_ctx (this, loc->inode, local->fresh_children);
         ret = afr_get_call_child (this, local->child_up, read_child,
-                                     local->fresh_children,
+                                     local->fresh_children, loc->inode,
                                      &call_child,
                                      &local->cont.getxattr.last_index);
         if (ret < 0) {
@@ -2289,6 +2289,99 @@ pump_fsetattr (call_frame_t *frame,
 }
 
 
+static int32_t
+pump_fallocate (call_frame_t *frame,
+                xlator_t *this,
+                fd_t *fd,
+                int32_t mode,
+                off_t offset,
+                size_t len)
+{
+        afr_private_t *priv  = NULL;
+        priv = this->private;
+        if (!priv->use_afr_in_pump) {
+                STACK_WIND (frame,
+                            default_fallocate_cbk,
+                            FIRST_CHILD (this),
+                            FIRST_CHILD (this)->fops->fallocate,
+                            fd, mode, offset, len);
+                return 0;
+        }
+        afr_fallocate (frame, this, fd, mode, offset, len);
+        return 0;
+}
+
+
+static int32_t
+pump_discard (call_frame_t *frame,
+              xlator_t *this,
+              fd_t *fd,
+              off_t offset,
+              size_t len)
+{
+        afr_private_t *priv  = NULL;
+        priv = this->private;
+        if (!priv->use_afr_in_pump) {
+                STACK_WIND (frame,
+                            default_discard_cbk,
+                            FIRST_CHILD (this),
+                            FIRST_CHILD (this)->fops->discard,
+                            fd, offset, len);
+                return 0;
+        }
+        afr_discard (frame, this, fd, offset, len);
+        return 0;
+}
+
+
+static int32_t
+pump_zerofill (call_frame_t *frame,
+               xlator_t *this,
+               fd_t *fd,
+               off_t offset,
+               size_t len)
+{
+        afr_private_t *priv  = NULL;
+        priv = this->private;
+        if (!priv->use_afr_in_pump) {
+                STACK_WIND (frame,
+                            default_zerofill_cbk,
+                            FIRST_CHILD (this),
+                            FIRST_CHILD (this)->fops->zerofill,
+                            fd, offset, len);
+                return 0;
+        }
+        afr_zerofill (frame, this, fd, offset, len);
+        return 0;
+}
+
+
+static int32_t
+pump_copy_file_range (call_frame_t *frame,
+                      xlator_t *this,
+                      fd_t *fd_in,
+                      off_t off_in,
+                      fd_t *fd_out,
+                      off_t off_out,
+                      size_t len,
+                      uint32_t flags)
+{
+        afr_private_t *priv  = NULL;
+        priv = this->private;
+        if (!priv->use_afr_in_pump) {
+                STACK_WIND (frame,
+                            default_copy_file_range_cbk,
+                            FIRST_CHILD (this),
+                            FIRST_CHILD (this)->fops->copy_file_range,
+                            fd_in, off_in, fd_out, off_out, len, flags);
+                return 0;
+        }
+        afr_copy_file_range (frame, this, fd_in, off_in, fd_out, off_out,
+                             len, flags);
+        return 0;
+}
+
+
 /* End of defaults */
 
 
@@ -2388,9 +2481,11 @@ init (xlator_t *this)
 	priv = this->private;
         LOCK_INIT (&priv->lock);
         LOCK_INIT (&priv->read_child_lock);
+        LOCK_INIT (&priv->sh_bandwidth_lock);
         //lock recovery is not done in afr
         pthread_mutex_init (&priv->mutex, NULL);
         INIT_LIST_HEAD (&priv->saved_fds);
+        INIT_LIST_HEAD (&priv->heal_waitq);
 
         child_count = xlator_subvolume_count (this);
         if (child_count != 2) {
@@ -2568,6 +2663,10 @@ struct xlator_fops fops = {
 	.setxattr    = pump_setxattr,
         .setattr     = pump_setattr,
 	.fsetattr    = pump_fsetattr,
+        .fallocate   = pump_fallocate,
+        .discard     = pump_discard,
+        .zerofill    = pump_zerofill,
+        .copy_file_range = pump_copy_file_range,
 	.removexattr = pump_removexattr,
 
 	/* dir read */
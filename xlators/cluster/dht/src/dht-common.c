@@ -35,6 +35,32 @@
 #include <sys/time.h>
 #include <libgen.h>
 
+static void
+dht_aggregate_rmtree_status (dict_t *dst, char *key, data_t *value)
+{
+        char     *status  = NULL;
+        char     *sum     = NULL;
+        uint64_t  pending = 0;
+        uint64_t  removed = 0;
+        uint64_t  p       = 0;
+        uint64_t  r       = 0;
+
+        if (sscanf (data_to_str (value), "pending=%"SCNu64" removed=%"SCNu64,
+                    &p, &r) != 2)
+                return;
+
+        if (dict_get_str (dst, key, &status) == 0)
+                sscanf (status, "pending=%"SCNu64" removed=%"SCNu64,
+                        &pending, &removed);
+
+        if (gf_asprintf (&sum, "pending=%"PRIu64" removed=%"PRIu64,
+                         pending + p, removed + r) < 0)
+                return;
+
+        if (dict_set_dynstr (dst, key, sum))
+                GF_FREE (sum);
+}
+
 void
 dht_aggregate (dict_t *this, char *key, data_t *value, void *data)
 {
@@ -71,6 +97,8 @@ dht_aggregate (dict_t *this, char *key, data_t *value, void *data)
                 }
 
                 *size = hton64 (ntoh64 (*size) + ntoh64 (*ptr));
+        } else if (strcmp (key, GF_XATTR_RMTREE_STATUS_KEY) == 0) {
+                dht_aggregate_rmtree_status (dst, key, value);
         } else {
                 /* compare user xattrs only */
                 if (!strncmp (key, "user.", strlen ("user."))) {
@@ -341,6 +369,13 @@ dht_discover (call_frame_t *frame, xlator_t *this, loc_t *loc)
                         "%s: failed to set 'trusted.glusterfs.dht' key",
                         loc->path);
 
+        ret = dict_set_uint32 (local->xattr_req, DHT_COMMITHASH_KEY,
+                               sizeof (uint32_t));
+        if (ret)
+                gf_log (this->name, GF_LOG_WARNING,
+                        "%s: failed to set '"DHT_COMMITHASH_KEY"' key",
+                        loc->path);
+
         ret = dict_set_uint32 (local->xattr_req,
                                "trusted.glusterfs.dht.linkto", 256);
         if (ret)
@@ -1145,6 +1180,55 @@ out:
 }
 
 
+int
+dht_lookup_commit_check_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                             int op_ret, int op_errno, inode_t *inode,
+                             struct iatt *stbuf, dict_t *xattr,
+                             struct iatt *postparent)
+{
+        dht_local_t  *local  = NULL;
+        call_frame_t *prev   = NULL;
+        dht_layout_t *layout = NULL;
+        int           i      = 0;
+
+        local = frame->local;
+        prev  = cookie;
+
+        layout = dht_layout_get (this, local->loc2.inode);
+        if (!layout)
+                goto everywhere;
+
+        /* the range and the marker on disk are still the ones the
+           cached layout was committed with */
+        if ((op_ret != -1) && dht_layout_is_committed (this, layout) &&
+            !dht_layout_dir_mismatch (this, layout, prev->this,
+                                      &local->loc2, xattr)) {
+                dht_layout_unref (this, layout);
+                WIPE (&local->postparent);
+                DHT_STACK_UNWIND (lookup, frame, -1, ENOENT, NULL,
+                                  NULL, NULL, &local->postparent);
+                return 0;
+        }
+
+        /* not trusted again until a revalidate brings the new layout */
+        for (i = 0; i < layout->cnt; i++) {
+                if (layout->list[i].xlator == prev->this)
+                        layout->list[i].commit_hash = DHT_LAYOUT_HASH_INVALID;
+        }
+        dht_layout_unref (this, layout);
+
+everywhere:
+        gf_log (this->name, GF_LOG_DEBUG,
+                "%s: layout of the parent changed on %s, "
+                "looking up everywhere", local->loc.path, prev->this->name);
+
+        local->op_errno = ENOENT;
+        dht_lookup_everywhere (frame, this, &local->loc);
+
+        return 0;
+}
+
+
 int
 dht_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 int op_ret, int op_errno,
@@ -1161,6 +1245,8 @@ dht_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         int           ret           = 0;
         uint64_t      tmp_layout    = 0;
         dht_layout_t *parent_layout = NULL;
+        gf_boolean_t  committed     = _gf_false;
+        dict_t       *xattr_req     = NULL;
 
         GF_VALIDATE_OR_GOTO ("dht", frame, err);
         GF_VALIDATE_OR_GOTO ("dht", this, out);
@@ -1183,6 +1269,44 @@ dht_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         if (ENTRY_MISSING (op_ret, op_errno)) {
                 gf_log (this->name, GF_LOG_TRACE, "Entry %s missing on subvol"
                         " %s", loc->path, prev->this->name);
+
+                /* parent is fully rebalanced, the hashed subvolume has
+                   either the entry or its linkfile: no need to look for
+                   it anywhere else */
+                if (loc->parent) {
+                        parent_layout = dht_layout_get (this, loc->parent);
+                        committed = dht_layout_is_committed (this,
+                                                             parent_layout);
+                        if (parent_layout)
+                                dht_layout_unref (this, parent_layout);
+                        parent_layout = NULL;
+                        /* the cached layout may have been changed by
+                           another client's fix-layout or remove-brick
+                           since: the marker on disk is checked first */
+                        if (committed)
+                                xattr_req = dict_new ();
+                        if (xattr_req &&
+                            !dict_set_uint32 (xattr_req,
+                                              "trusted.glusterfs.dht", 4 * 4) &&
+                            !dict_set_uint32 (xattr_req, DHT_COMMITHASH_KEY,
+                                              sizeof (uint32_t)) &&
+                            !dht_build_parent_loc (&local->loc2, loc)) {
+                                gf_log (this->name, GF_LOG_TRACE,
+                                        "%s: parent layout committed, "
+                                        "skipping lookup everywhere",
+                                        loc->path);
+                                STACK_WIND (frame,
+                                            dht_lookup_commit_check_cbk,
+                                            prev->this,
+                                            prev->this->fops->lookup,
+                                            &local->loc2, xattr_req);
+                                dict_unref (xattr_req);
+                                return 0;
+                        }
+                        if (xattr_req)
+                                dict_unref (xattr_req);
+                }
+
                 if (conf->search_unhashed == GF_DHT_LOOKUP_UNHASHED_ON) {
                         local->op_errno = ENOENT;
                         dht_lookup_everywhere (frame, this, loc);
@@ -1192,7 +1316,7 @@ dht_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                     (loc->parent)) {
                         ret = inode_ctx_get (loc->parent, this, &tmp_layout);
                         parent_layout = (dht_layout_t *)(long)tmp_layout;
-                        if (parent_layout->search_unhashed) {
+                        if (parent_layout && parent_layout->search_unhashed) {
                                 local->op_errno = ENOENT;
                                 dht_lookup_everywhere (frame, this, loc);
                                 return 0;
@@ -1367,6 +1491,10 @@ dht_lookup (call_frame_t *frame, xlator_t *this,
                                        "trusted.glusterfs.dht", 4 * 4);
 
                 if (IA_ISDIR (local->inode->ia_type)) {
+                        ret = dict_set_uint32 (local->xattr_req,
+                                               DHT_COMMITHASH_KEY,
+                                               sizeof (uint32_t));
+
                         local->call_cnt = call_cnt = conf->subvolume_cnt;
                         for (i = 0; i < call_cnt; i++) {
                                 STACK_WIND (frame, dht_revalidate_cbk,
@@ -1398,6 +1526,9 @@ dht_lookup (call_frame_t *frame, xlator_t *this,
                 ret = dict_set_uint32 (local->xattr_req,
                                        "trusted.glusterfs.dht", 4 * 4);
 
+                ret = dict_set_uint32 (local->xattr_req,
+                                       DHT_COMMITHASH_KEY, sizeof (uint32_t));
+
                 ret = dict_set_uint32 (local->xattr_req,
                                        DHT_LINKFILE_KEY, 256);
 
@@ -2180,6 +2311,21 @@ dht_setxattr (call_frame_t *frame, xlator_t *this,
                 return 0;
         }
 
+        tmp = dict_get (xattr, GF_XATTR_COMMIT_LAYOUT_KEY);
+        if (tmp) {
+                if (!IA_ISDIR (loc->inode->ia_type)) {
+                        op_errno = ENOTDIR;
+                        goto err;
+                }
+
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "committing the layout of %s", loc->path);
+
+                dht_commit_directory_layout (frame, dht_common_setxattr_cbk,
+                                             layout);
+                return 0;
+        }
+
         tmp = dict_get (xattr, "distribute.directory-spread-count");
         if (tmp) {
                 /* Setxattr value is packed as 'binary', not string */
@@ -2728,11 +2874,372 @@ unwind:
 }
 
 
+static dht_rdp_ctx_t *
+dht_rdp_ctx_get (xlator_t *this, fd_t *fd)
+{
+        dht_conf_t    *conf  = NULL;
+        dht_rdp_ctx_t *ctx   = NULL;
+        uint64_t       value = 0;
+        int            i     = 0;
+
+        conf = this->private;
+
+        LOCK (&fd->lock);
+        {
+                if (__fd_ctx_get (fd, this, &value) == 0) {
+                        ctx = (dht_rdp_ctx_t *)(long) value;
+                        goto unlock;
+                }
+
+                ctx = GF_CALLOC (1, sizeof (*ctx) + (conf->subvolume_cnt *
+                                 sizeof (struct dht_rdp_slot)),
+                                 gf_dht_mt_rdp_ctx_t);
+                if (!ctx)
+                        goto unlock;
+
+                LOCK_INIT (&ctx->lock);
+                ctx->cnt = conf->subvolume_cnt;
+                for (i = 0; i < ctx->cnt; i++)
+                        INIT_LIST_HEAD (&ctx->slots[i].entries.list);
+
+                if (__fd_ctx_set (fd, this, (uint64_t)(long) ctx)) {
+                        LOCK_DESTROY (&ctx->lock);
+                        GF_FREE (ctx);
+                        ctx = NULL;
+                }
+        }
+unlock:
+        UNLOCK (&fd->lock);
+
+        return ctx;
+}
+
+
+int
+dht_releasedir (xlator_t *this, fd_t *fd)
+{
+        dht_rdp_ctx_t *ctx   = NULL;
+        uint64_t       value = 0;
+        int            i     = 0;
+
+        if (fd_ctx_del (fd, this, &value))
+                goto out;
+
+        ctx = (dht_rdp_ctx_t *)(long) value;
+        for (i = 0; i < ctx->cnt; i++)
+                gf_dirent_free (&ctx->slots[i].entries);
+
+        LOCK_DESTROY (&ctx->lock);
+        GF_FREE (ctx);
+out:
+        return 0;
+}
+
+
+static int dht_rdp_serve (call_frame_t *frame, xlator_t *this);
+
+int
+dht_rdp_fetch_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int op_ret, int op_errno, gf_dirent_t *orig_entries)
+{
+        dht_local_t         *local  = NULL;
+        dht_rdp_ctx_t       *ctx    = NULL;
+        struct dht_rdp_slot *slot   = NULL;
+        call_frame_t        *waiter = NULL;
+        int                  idx    = 0;
+
+        local = frame->local;
+        idx = (long) cookie;
+
+        ctx = dht_rdp_ctx_get (this, local->fd);
+        if (!ctx)
+                goto out;
+
+        if (op_ret < 0)
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "readdirp on %s failed (%s)",
+                        ((dht_conf_t *)this->private)->subvolumes[idx]->name,
+                        strerror (op_errno));
+
+        LOCK (&ctx->lock);
+        {
+                slot = &ctx->slots[idx];
+
+                /* the subvolume is done with when it says so, or when it
+                   has nothing (more) to give, as in the serial walk */
+                if (op_ret > 0)
+                        list_splice_init (&orig_entries->list,
+                                          &slot->entries.list);
+                slot->eof = ((op_ret <= 0) || (op_errno == ENOENT));
+                slot->state = DHT_RDP_READY;
+
+                waiter = ctx->waiter;
+                ctx->waiter = NULL;
+        }
+        UNLOCK (&ctx->lock);
+
+        if (waiter)
+                dht_rdp_serve (waiter, this);
+out:
+        DHT_STACK_DESTROY (frame);
+
+        return 0;
+}
+
+
+static int
+dht_rdp_fetch (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+               int idx, off_t offset)
+{
+        dht_conf_t    *conf        = NULL;
+        call_frame_t  *fetch_frame = NULL;
+        dht_local_t   *fetch_local = NULL;
+
+        conf = this->private;
+
+        fetch_frame = copy_frame (frame);
+        if (!fetch_frame)
+                goto err;
+
+        fetch_local = dht_local_init (fetch_frame, NULL, fd, GF_FOP_READDIRP);
+        if (!fetch_local)
+                goto err;
+
+        fetch_local->size = size;
+
+        STACK_WIND_COOKIE (fetch_frame, dht_rdp_fetch_cbk, (void *)(long) idx,
+                           conf->subvolumes[idx],
+                           conf->subvolumes[idx]->fops->readdirp,
+                           fd, size, offset);
+        return 0;
+
+err:
+        if (fetch_frame)
+                DHT_STACK_DESTROY (fetch_frame);
+
+        return -1;
+}
+
+
+/* Fills a reply from the batches read ahead, in subvolume order and
+   across subvolume boundaries, so that every entry still carries the
+   offset the serial walk would have given it. Batches not read yet are
+   fetched from all the subvolumes at once; the request waits for one
+   only when it has nothing to return without it. */
+static int
+dht_rdp_serve (call_frame_t *frame, xlator_t *this)
+{
+        dht_local_t         *local     = NULL;
+        dht_conf_t          *conf      = NULL;
+        dht_rdp_ctx_t       *ctx       = NULL;
+        struct dht_rdp_slot *slot      = NULL;
+        dht_layout_t        *layout    = NULL;
+        xlator_t            *subvol    = NULL;
+        xlator_t            *xvol      = NULL;
+        gf_dirent_t          entries;
+        gf_dirent_t         *entry     = NULL;
+        gf_dirent_t         *tmp       = NULL;
+        off_t               *fetch     = NULL;
+        off_t                offset    = 0;
+        off_t                want      = 0;
+        size_t               filled    = 0;
+        size_t               this_size = 0;
+        int                  count     = 0;
+        int                  op_errno  = 0;
+        int                  wait      = -1;
+        int                  i         = 0;
+        int                  j         = 0;
+
+        local = frame->local;
+        conf  = this->private;
+
+        INIT_LIST_HEAD (&entries.list);
+
+        ctx = dht_rdp_ctx_get (this, local->fd);
+        if (!ctx)
+                goto serial;
+
+        fetch = GF_CALLOC (ctx->cnt, sizeof (off_t), gf_common_mt_char);
+        if (!fetch)
+                goto serial;
+
+        if (!local->layout)
+                local->layout = dht_layout_get (this, local->fd->inode);
+        layout = local->layout;
+
+again:
+        for (i = 0; i < ctx->cnt; i++)
+                fetch[i] = -1;
+        wait = -1;
+
+        dht_deitransform (this, local->yoff, &xvol, (uint64_t *)&offset);
+
+        LOCK (&ctx->lock);
+        {
+                for (i = dht_subvol_cnt (this, xvol); i < ctx->cnt;
+                     i++, offset = 0) {
+                        slot = &ctx->slots[i];
+                        subvol = conf->subvolumes[i];
+
+                        want = offset;
+                        if (slot->offset != offset) {
+                                /* seekdir(), or rewind after a full pass */
+                                if (slot->state == DHT_RDP_PENDING)
+                                        break;
+                                gf_dirent_free (&slot->entries);
+                                slot->state = DHT_RDP_EMPTY;
+                        }
+
+                        if (slot->state == DHT_RDP_EMPTY) {
+                                slot->state = DHT_RDP_PENDING;
+                                slot->offset = offset;
+                                slot->eof = _gf_false;
+                                fetch[i] = offset;
+                        }
+
+                        if (slot->state == DHT_RDP_PENDING) {
+                                wait = i;
+                                break;
+                        }
+
+                        list_for_each_entry_safe (entry, tmp,
+                                                  &slot->entries.list, list) {
+                                this_size = sizeof (gf_dirent_t) +
+                                        strlen (entry->d_name) + 1;
+                                if (filled && (filled + this_size >
+                                               local->size))
+                                        break;
+
+                                filled += this_size;
+                                slot->offset = entry->d_off;
+                                list_del_init (&entry->list);
+
+                                if (check_is_linkfile_wo_dict (NULL,
+                                                       (&entry->d_stat))
+                                    || (check_is_dir (NULL, (&entry->d_stat),
+                                                      NULL)
+                                        && (subvol !=
+                                            dht_first_up_subvol (this)))) {
+                                        GF_FREE (entry);
+                                        continue;
+                                }
+
+                                if ((conf->search_unhashed ==
+                                     GF_DHT_LOOKUP_UNHASHED_AUTO) && layout &&
+                                    (dht_layout_search (this, layout,
+                                                        entry->d_name)
+                                     != subvol))
+                                        layout->search_unhashed++;
+
+                                dht_itransform (this, subvol, entry->d_off,
+                                                &entry->d_off);
+                                list_add_tail (&entry->list, &entries.list);
+                                count++;
+                        }
+
+                        /* reply is full */
+                        if (!list_empty (&slot->entries.list))
+                                break;
+
+                        if (!slot->eof) {
+                                /* read ahead the next batch */
+                                slot->state = DHT_RDP_PENDING;
+                                fetch[i] = slot->offset;
+                                want = slot->offset;
+                                wait = i;
+                                break;
+                        }
+                }
+
+                if (i == ctx->cnt)
+                        op_errno = ENOENT;
+
+                for (j = i + 1; j < ctx->cnt; j++) {
+                        slot = &ctx->slots[j];
+                        if (slot->state != DHT_RDP_EMPTY)
+                                continue;
+                        slot->state = DHT_RDP_PENDING;
+                        slot->offset = 0;
+                        slot->eof = _gf_false;
+                        fetch[j] = 0;
+                }
+        }
+        UNLOCK (&ctx->lock);
+
+        for (j = 0; j < ctx->cnt; j++) {
+                if (fetch[j] == -1)
+                        continue;
+                if (dht_rdp_fetch (frame, this, local->fd, local->size, j,
+                                   fetch[j])) {
+                        LOCK (&ctx->lock);
+                        {
+                                ctx->slots[j].state = DHT_RDP_EMPTY;
+                        }
+                        UNLOCK (&ctx->lock);
+                        if (j == wait)
+                                wait = -1;
+                }
+        }
+
+        if (count || (i == ctx->cnt))
+                goto unwind;
+
+        /* the position moves along with the entries filtered out */
+        dht_itransform (this, conf->subvolumes[i], want,
+                        (uint64_t *)&local->yoff);
+
+        /* a read from an earlier position is still in flight, or the
+           read ahead could not be sent */
+        if (wait == -1)
+                goto serial;
+
+        /* wait for the batch the reply starts with */
+        LOCK (&ctx->lock);
+        {
+                slot = &ctx->slots[wait];
+                if (slot->state == DHT_RDP_READY)
+                        wait = -2;
+                else if (!ctx->waiter)
+                        ctx->waiter = frame;
+                else
+                        wait = -1;
+        }
+        UNLOCK (&ctx->lock);
+
+        if (wait == -2)
+                goto again;
+
+        if (wait == -1)
+                goto serial;
+
+        GF_FREE (fetch);
+        return 0;
+
+serial:
+        GF_FREE (fetch);
+
+        dht_deitransform (this, local->yoff, &xvol, (uint64_t *)&offset);
+        STACK_WIND (frame, dht_readdirp_cbk, xvol, xvol->fops->readdirp,
+                    local->fd, local->size, offset);
+        return 0;
+
+unwind:
+        GF_FREE (fetch);
+
+        DHT_STACK_UNWIND (readdirp, frame, count, op_errno, &entries);
+
+        gf_dirent_free (&entries);
+
+        return 0;
+}
+
+
 int
 dht_do_readdir (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
                 off_t yoff, int whichop)
 {
         dht_local_t  *local  = NULL;
+        dht_conf_t   *conf = NULL;
         int           op_errno = -1;
         xlator_t     *xvol = NULL;
         off_t         xoff = 0;
@@ -2751,6 +3258,13 @@ dht_do_readdir (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
         local->fd = fd_ref (fd);
         local->size = size;
 
+        conf = this->private;
+        if ((whichop == GF_FOP_READDIRP) && conf->parallel_readdir) {
+                local->yoff = yoff;
+                dht_rdp_serve (frame, this);
+                return 0;
+        }
+
         dht_deitransform (this, yoff, &xvol, (uint64_t *)&xoff);
 
         /* TODO: do proper readdir */
@@ -4032,6 +4546,12 @@ dht_rmdir (call_frame_t *frame, xlator_t *this, loc_t *loc, int flags)
 
         local->flags = flags;
 
+        /* a recursive rmdir does not need the directory to be empty */
+        if (flags) {
+                dht_rmdir_do (frame, this);
+                return 0;
+        }
+
         local->fd = fd_create (local->loc.inode, frame->root->pid);
         if (!local->fd) {
 
@@ -4191,6 +4711,9 @@ dht_notify (xlator_t *this, int event, void *data, ...)
         if (!conf)
                 return ret;
 
+        if (event == GF_EVENT_UPCALL)
+                return default_notify (this, event, data);
+
         /* had all subvolumes reported status once till now? */
         had_heard_from_all = 1;
         for (i = 0; i < conf->subvolume_cnt; i++) {
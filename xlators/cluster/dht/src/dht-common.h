@@ -30,6 +30,7 @@
 #define _DHT_H
 
 #define GF_XATTR_FIX_LAYOUT_KEY     "distribute.fix.layout"
+#define GF_XATTR_COMMIT_LAYOUT_KEY  "distribute.commit.layout"
 #define GF_DHT_LOOKUP_UNHASHED_ON   1
 #define GF_DHT_LOOKUP_UNHASHED_AUTO 2
 #define DHT_PATHINFO_HEADER         "DISTRIBUTE:"
@@ -60,6 +61,10 @@ struct dht_layout {
                                   */
                 uint32_t   start;
                 uint32_t   stop;
+                uint32_t   commit_hash; /* == conf->vol_commit_hash when
+                                           the directory is known to have
+                                           every entry on (or linked from)
+                                           its hashed subvolume */
                 xlator_t  *xlator;
         } list[0];
 };
@@ -163,14 +168,44 @@ struct dht_local {
         glusterfs_fop_t      fop;
 
         struct dht_rebalance_ rebalance;
+
+        /* copy_file_range: the source, fd being the destination */
+        fd_t                 *fd_in;
+        off_t                 offset_in;
+        gf_boolean_t          streamed;
+
+        /* parallel readdirp: position the request is to be served from */
+        off_t                 yoff;
 };
 typedef struct dht_local dht_local_t;
 
+/* parallel readdirp: one batch of entries read ahead per subvolume,
+   kept in the context of the directory fd */
+#define DHT_RDP_EMPTY    0
+#define DHT_RDP_PENDING  1
+#define DHT_RDP_READY    2
+
+struct dht_rdp_slot {
+        int            state;
+        off_t          offset;  /* subvolume offset 'entries' start at */
+        gf_boolean_t   eof;
+        gf_dirent_t    entries;
+};
+
+struct dht_rdp_ctx {
+        gf_lock_t            lock;
+        call_frame_t        *waiter;  /* request waiting for a batch */
+        int                  cnt;
+        struct dht_rdp_slot  slots[0];
+};
+typedef struct dht_rdp_ctx dht_rdp_ctx_t;
+
 /* du - disk-usage */
 struct dht_du {
         double   avail_percent;
 	double   avail_inodes;
         uint64_t avail_space;
+        uint64_t total_space;
         uint32_t log;
 };
 typedef struct dht_du dht_du_t;
@@ -208,6 +243,21 @@ struct dht_conf {
 
         /* to keep track of nodes which are decomissioned */
         xlator_t     **decommissioned_bricks;
+
+        /* derived from the set of subvolumes, a directory whose layout
+           carries this value on all subvolumes needs no lookup-everywhere */
+        uint32_t       vol_commit_hash;
+
+        /* rebalance: blocks in flight per file, and the latency (msec)
+           of a block beyond which that window is halved */
+        uint32_t       rebal_window;
+        uint32_t       rebal_throttle_msec;
+
+        /* size the hash range of each subvolume by its capacity */
+        gf_boolean_t   do_weighting;
+
+        /* read directories from all the subvolumes at once */
+        gf_boolean_t   parallel_readdir;
 };
 typedef struct dht_conf dht_conf_t;
 
@@ -235,6 +285,8 @@ typedef struct dht_disk_layout dht_disk_layout_t;
 #define DHT_MIGRATION_COMPLETED   2
 
 #define DHT_LINKFILE_KEY         "trusted.glusterfs.dht.linkto"
+#define DHT_COMMITHASH_KEY       "trusted.glusterfs.dht.commithash"
+#define DHT_LAYOUT_HASH_INVALID  0
 #define DHT_LINKFILE_MODE        (S_ISVTX)
 
 #define check_is_linkfile(i,s,x) (                                      \
@@ -301,6 +353,7 @@ int dht_layout_anomalies (xlator_t      *this, loc_t *loc, dht_layout_t *layout,
                           uint32_t      *misc_p);
 int dht_layout_dir_mismatch (xlator_t   *this, dht_layout_t *layout,
                              xlator_t   *subvol, loc_t *loc, dict_t *xattr);
+gf_boolean_t dht_layout_is_committed (xlator_t *this, dht_layout_t *layout);
 
 xlator_t *dht_linkfile_subvol (xlator_t *this, inode_t *inode,
                                struct iatt *buf, dict_t *xattr);
@@ -360,6 +413,9 @@ int dht_get_du_info (call_frame_t *frame, xlator_t *this, loc_t *loc);
 gf_boolean_t dht_is_subvol_filled (xlator_t *this, xlator_t *subvol);
 xlator_t *dht_free_disk_available_subvol (xlator_t *this, xlator_t *subvol);
 int       dht_get_du_info_for_subvol (xlator_t *this, int subvol_idx);
+void      dht_du_info_update (xlator_t *this, xlator_t *subvol,
+                              struct statvfs *statvfs);
+gf_boolean_t dht_du_info_available (xlator_t *this);
 
 int dht_layout_preset (xlator_t *this, xlator_t *subvol, inode_t *inode);
 int           dht_layout_set (xlator_t *this, inode_t *inode, dht_layout_t *layout);
@@ -379,11 +435,19 @@ int dht_rename_links_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                           inode_t          *inode, struct iatt *stbuf,
                           struct iatt      *preparent, struct iatt *postparent);
 
+int dht_releasedir (xlator_t *this, fd_t *fd);
+
 int dht_fix_directory_layout (call_frame_t *frame,
                               dht_selfheal_dir_cbk_t  dir_cbk,
                               dht_layout_t           *layout);
 
+int dht_commit_directory_layout (call_frame_t *frame,
+                                 dht_selfheal_dir_cbk_t  dir_cbk,
+                                 dht_layout_t           *layout);
+
 int dht_init_subvolumes (xlator_t *this, dht_conf_t *conf);
+uint32_t dht_vol_commit_hash_compute (dht_conf_t *conf);
+int dht_build_parent_loc (loc_t *parent, loc_t *child);
 
 /* migration/rebalance */
 int dht_start_rebalance_task (xlator_t *this, call_frame_t *frame);
@@ -416,6 +480,34 @@ int32_t dht_ftruncate (call_frame_t *frame,
                        fd_t     *fd,
                        off_t     offset);
 
+int32_t dht_fallocate (call_frame_t *frame,
+                       xlator_t *this,
+                       fd_t     *fd,
+                       int32_t   keep_size,
+                       off_t     offset,
+                       size_t    len);
+
+int32_t dht_discard (call_frame_t *frame,
+                     xlator_t *this,
+                     fd_t     *fd,
+                     off_t     offset,
+                     size_t    len);
+
+int32_t dht_zerofill (call_frame_t *frame,
+                      xlator_t *this,
+                      fd_t     *fd,
+                      off_t     offset,
+                      size_t    len);
+
+int32_t dht_copy_file_range (call_frame_t *frame,
+                             xlator_t *this,
+                             fd_t     *fd_in,
+                             off_t     off_in,
+                             fd_t     *fd_out,
+                             off_t     off_out,
+                             size_t    len,
+                             uint32_t  flags);
+
 int32_t dht_access (call_frame_t *frame,
                     xlator_t *this,
                     loc_t    *loc,
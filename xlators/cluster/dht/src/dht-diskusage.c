@@ -33,30 +33,22 @@
 #include <sys/time.h>
 
 
-int
-dht_du_info_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
-		 int op_ret, int op_errno, struct statvfs *statvfs)
+void
+dht_du_info_update (xlator_t *this, xlator_t *subvol, struct statvfs *statvfs)
 {
 	dht_conf_t    *conf         = NULL;
-	call_frame_t  *prev          = NULL;
-	int            this_call_cnt = 0;
 	int            i = 0;
 	double         percent = 0;
 	double         percent_inodes = 0;
 	uint64_t       bytes = 0;
+	uint64_t       total = 0;
 
 	conf = this->private;
-	prev = cookie;
-
-	if (op_ret == -1) {
-		gf_log (this->name, GF_LOG_WARNING,
-			"failed to get disk info from %s", prev->this->name);
-		goto out;
-	}
 
 	if (statvfs && statvfs->f_blocks) {
 		percent = (statvfs->f_bavail * 100) / statvfs->f_blocks;
 		bytes = (statvfs->f_bavail * statvfs->f_frsize);
+		total = (statvfs->f_blocks * statvfs->f_frsize);
 	}
 
 	if (statvfs && statvfs->f_files) {
@@ -74,21 +66,67 @@ dht_du_info_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 	LOCK (&conf->subvolume_lock);
 	{
 		for (i = 0; i < conf->subvolume_cnt; i++)
-			if (prev->this == conf->subvolumes[i]) {
+			if (subvol == conf->subvolumes[i]) {
 				conf->du_stats[i].avail_percent = percent;
 				conf->du_stats[i].avail_space   = bytes;
 				conf->du_stats[i].avail_inodes  = percent_inodes;
+				conf->du_stats[i].total_space   = total;
 				gf_log (this->name, GF_LOG_DEBUG,
 					"on subvolume '%s': avail_percent is: "
 					"%.2f and avail_space is: %"PRIu64" "
 					"and avail_inodes is: %.2f",
-					prev->this->name,
+					subvol->name,
 					conf->du_stats[i].avail_percent,
 					conf->du_stats[i].avail_space,
 					conf->du_stats[i].avail_inodes);
 			}
 	}
 	UNLOCK (&conf->subvolume_lock);
+}
+
+
+/* true once every subvolume has answered a statfs, so that the
+   capacities needed for a weighted layout are all known */
+gf_boolean_t
+dht_du_info_available (xlator_t *this)
+{
+	dht_conf_t    *conf = NULL;
+	int            i = 0;
+	gf_boolean_t   available = _gf_true;
+
+	conf = this->private;
+
+	LOCK (&conf->subvolume_lock);
+	{
+		for (i = 0; i < conf->subvolume_cnt; i++) {
+			if (!conf->du_stats[i].total_space) {
+				available = _gf_false;
+				break;
+			}
+		}
+	}
+	UNLOCK (&conf->subvolume_lock);
+
+	return available;
+}
+
+
+int
+dht_du_info_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+		 int op_ret, int op_errno, struct statvfs *statvfs)
+{
+	call_frame_t  *prev          = NULL;
+	int            this_call_cnt = 0;
+
+	prev = cookie;
+
+	if (op_ret == -1) {
+		gf_log (this->name, GF_LOG_WARNING,
+			"failed to get disk info from %s", prev->this->name);
+		goto out;
+	}
+
+	dht_du_info_update (this, prev->this, statvfs);
 
 out:
 	this_call_cnt = dht_frame_return (frame);
@@ -23,6 +23,8 @@
 #endif
 
 
+#include <libgen.h>
+
 #include "glusterfs.h"
 #include "xlator.h"
 #include "dht-common.h"
@@ -202,6 +204,11 @@ dht_local_wipe (xlator_t *this, dht_local_t *local)
                 local->fd = NULL;
         }
 
+        if (local->fd_in) {
+                fd_unref (local->fd_in);
+                local->fd_in = NULL;
+        }
+
         if (local->params) {
                 dict_unref (local->params);
                 local->params = NULL;
@@ -531,6 +538,63 @@ err:
 
 
 
+/* adding or removing a subvolume changes the value, which makes every
+   committed directory layout 'in flux' until it is rebalanced again */
+uint32_t
+dht_vol_commit_hash_compute (dht_conf_t *conf)
+{
+        uint32_t  commit_hash = 0;
+        uint32_t  hash = 0;
+        int       i = 0;
+
+        for (i = 0; i < conf->subvolume_cnt; i++) {
+                hash = 0;
+                dht_hash_compute (DHT_HASH_TYPE_DM,
+                                  conf->subvolumes[i]->name, &hash);
+                commit_hash = ((commit_hash << 5) | (commit_hash >> 27));
+                commit_hash ^= hash;
+        }
+
+        if (commit_hash == DHT_LAYOUT_HASH_INVALID)
+                commit_hash = 1;
+
+        return commit_hash;
+}
+
+
+int
+dht_build_parent_loc (loc_t *parent, loc_t *child)
+{
+        char *tmp = NULL;
+
+        if (!child->parent || !child->path)
+                return -1;
+
+        tmp = gf_strdup (child->path);
+        if (!tmp)
+                return -1;
+
+        parent->path = gf_strdup (dirname (tmp));
+        GF_FREE (tmp);
+        if (!parent->path)
+                return -1;
+
+        parent->name = strrchr (parent->path, '/');
+        if (parent->name)
+                parent->name++;
+
+        parent->inode  = inode_ref (child->parent);
+        parent->parent = inode_parent (parent->inode, 0, NULL);
+
+        if (!uuid_is_null (child->pargfid))
+                uuid_copy (parent->gfid, child->pargfid);
+        else
+                uuid_copy (parent->gfid, child->parent->gfid);
+
+        return 0;
+}
+
+
 int
 dht_init_subvolumes (xlator_t *this, dht_conf_t *conf)
 {
@@ -584,6 +648,8 @@ dht_init_subvolumes (xlator_t *this, dht_conf_t *conf)
                 return -1;
         }
 
+        conf->vol_commit_hash = dht_vol_commit_hash_compute (conf);
+
         return 0;
 }
 
@@ -27,6 +27,12 @@
 
 int dht_writev2 (xlator_t *this, call_frame_t *frame, int ret);
 int dht_truncate2 (xlator_t *this, call_frame_t *frame, int ret);
+int dht_fallocate2 (xlator_t *this, call_frame_t *frame, int ret);
+int dht_copy_file_range2 (xlator_t *this, call_frame_t *frame, int ret);
+int dht_copy_file_range_cbk (call_frame_t *frame, void *cookie,
+                             xlator_t *this, int op_ret, int op_errno,
+                             struct iatt *stbuf_in, struct iatt *prebuf,
+                             struct iatt *postbuf);
 int dht_setattr2 (xlator_t *this, call_frame_t *frame, int ret);
 
 int
@@ -350,6 +356,452 @@ err:
         return 0;
 }
 
+/* fallocate, discard and zerofill share their callback, a file being
+   migrated gets the range allocated on the target as well */
+int
+dht_fallocate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int op_ret, int op_errno, struct iatt *prebuf,
+                   struct iatt *postbuf)
+{
+        dht_local_t  *local = NULL;
+        call_frame_t *prev = NULL;
+        int           ret = -1;
+
+        GF_VALIDATE_OR_GOTO ("dht", frame, err);
+        GF_VALIDATE_OR_GOTO ("dht", this, out);
+        GF_VALIDATE_OR_GOTO ("dht", frame->local, out);
+        GF_VALIDATE_OR_GOTO ("dht", cookie, out);
+
+        local = frame->local;
+        prev = cookie;
+
+        if ((op_ret == -1) && (op_errno != ENOENT)) {
+                local->op_errno = op_errno;
+                local->op_ret = -1;
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "subvolume %s returned -1 (%s)",
+                        prev->this->name, strerror (op_errno));
+
+                goto out;
+        }
+
+        if (local->call_cnt != 1) {
+                if (local->stbuf.ia_blocks) {
+                        dht_iatt_merge (this, postbuf, &local->stbuf, NULL);
+                        dht_iatt_merge (this, prebuf, &local->prebuf, NULL);
+                }
+                goto out;
+        }
+
+        local->rebalance.target_op_fn = dht_fallocate2;
+
+        /* Phase 2 of migration */
+        if ((op_ret == -1) || IS_DHT_MIGRATION_PHASE2 (postbuf)) {
+                ret = dht_rebalance_complete_check (this, frame);
+                if (!ret)
+                        return 0;
+        }
+
+        /* Check if the rebalance phase1 is true */
+        if (IS_DHT_MIGRATION_PHASE1 (postbuf)) {
+                dht_iatt_merge (this, &local->stbuf, postbuf, NULL);
+                dht_iatt_merge (this, &local->prebuf, prebuf, NULL);
+                ret = fd_ctx_get (local->fd, this, NULL);
+                if (!ret) {
+                        dht_fallocate2 (this, frame, 0);
+                        return 0;
+                }
+                ret = dht_rebalance_in_progress_check (this, frame);
+                if (!ret)
+                        return 0;
+        }
+
+out:
+        DHT_STRIP_PHASE1_FLAGS (postbuf);
+        DHT_STRIP_PHASE1_FLAGS (prebuf);
+        DHT_STACK_UNWIND (fallocate, frame, op_ret, op_errno,
+                          prebuf, postbuf);
+err:
+        return 0;
+}
+
+
+int
+dht_fallocate2 (xlator_t *this, call_frame_t *frame, int op_ret)
+{
+        dht_local_t  *local  = NULL;
+        xlator_t     *subvol = NULL;
+        uint64_t      tmp_subvol = 0;
+        int           ret = -1;
+
+        local = frame->local;
+
+        if (local->fd)
+                ret = fd_ctx_get (local->fd, this, &tmp_subvol);
+        if (!ret)
+                subvol = (xlator_t *)(long)tmp_subvol;
+
+        if (!subvol)
+                subvol = local->cached_subvol;
+
+        local->call_cnt = 2; /* This is the second attempt */
+
+        if (local->fop == GF_FOP_FALLOCATE) {
+                STACK_WIND (frame, dht_fallocate_cbk, subvol,
+                            subvol->fops->fallocate, local->fd,
+                            local->rebalance.flags, local->rebalance.offset,
+                            local->rebalance.size);
+        } else if (local->fop == GF_FOP_DISCARD) {
+                STACK_WIND (frame, dht_fallocate_cbk, subvol,
+                            subvol->fops->discard, local->fd,
+                            local->rebalance.offset, local->rebalance.size);
+        } else {
+                STACK_WIND (frame, dht_fallocate_cbk, subvol,
+                            subvol->fops->zerofill, local->fd,
+                            local->rebalance.offset, local->rebalance.size);
+        }
+
+        return 0;
+}
+
+int
+dht_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+               int32_t keep_size, off_t offset, size_t len)
+{
+        xlator_t     *subvol = NULL;
+        int           op_errno = -1;
+        dht_local_t  *local = NULL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        local = dht_local_init (frame, NULL, fd, GF_FOP_FALLOCATE);
+        if (!local) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        local->rebalance.flags  = keep_size;
+        local->rebalance.offset = offset;
+        local->rebalance.size   = len;
+        local->call_cnt = 1;
+        subvol = local->cached_subvol;
+        if (!subvol) {
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "no cached subvolume for fd=%p", fd);
+                op_errno = EINVAL;
+                goto err;
+        }
+
+        STACK_WIND (frame, dht_fallocate_cbk,
+                    subvol, subvol->fops->fallocate,
+                    fd, keep_size, offset, len);
+
+        return 0;
+
+err:
+        op_errno = (op_errno == -1) ? errno : op_errno;
+        DHT_STACK_UNWIND (fallocate, frame, -1, op_errno, NULL, NULL);
+
+        return 0;
+}
+
+int
+dht_discard (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+             size_t len)
+{
+        xlator_t     *subvol = NULL;
+        int           op_errno = -1;
+        dht_local_t  *local = NULL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        local = dht_local_init (frame, NULL, fd, GF_FOP_DISCARD);
+        if (!local) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        local->rebalance.offset = offset;
+        local->rebalance.size   = len;
+        local->call_cnt = 1;
+        subvol = local->cached_subvol;
+        if (!subvol) {
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "no cached subvolume for fd=%p", fd);
+                op_errno = EINVAL;
+                goto err;
+        }
+
+        STACK_WIND (frame, dht_fallocate_cbk,
+                    subvol, subvol->fops->discard,
+                    fd, offset, len);
+
+        return 0;
+
+err:
+        op_errno = (op_errno == -1) ? errno : op_errno;
+        DHT_STACK_UNWIND (discard, frame, -1, op_errno, NULL, NULL);
+
+        return 0;
+}
+
+int
+dht_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+              size_t len)
+{
+        xlator_t     *subvol = NULL;
+        int           op_errno = -1;
+        dht_local_t  *local = NULL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        local = dht_local_init (frame, NULL, fd, GF_FOP_ZEROFILL);
+        if (!local) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        local->rebalance.offset = offset;
+        local->rebalance.size   = len;
+        local->call_cnt = 1;
+        subvol = local->cached_subvol;
+        if (!subvol) {
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "no cached subvolume for fd=%p", fd);
+                op_errno = EINVAL;
+                goto err;
+        }
+
+        STACK_WIND (frame, dht_fallocate_cbk,
+                    subvol, subvol->fops->zerofill,
+                    fd, offset, len);
+
+        return 0;
+
+err:
+        op_errno = (op_errno == -1) ? errno : op_errno;
+        DHT_STACK_UNWIND (zerofill, frame, -1, op_errno, NULL, NULL);
+
+        return 0;
+}
+
+/* the subvolume fd is read from, the one it was migrated to when the
+   migration of its file has completed */
+static xlator_t *
+dht_fd_subvol_get (xlator_t *this, fd_t *fd)
+{
+        uint64_t  tmp_subvol = 0;
+        int       ret        = -1;
+
+        ret = fd_ctx_get (fd, this, &tmp_subvol);
+        if (!ret && tmp_subvol)
+                return (xlator_t *)(long)tmp_subvol;
+
+        return dht_subvol_get_cached (this, fd->inode);
+}
+
+
+/* the source and the destination on one subvolume copy there, else the
+   data is read from one and written to the other through this client */
+static int
+dht_copy_file_range_wind (xlator_t *this, call_frame_t *frame,
+                          xlator_t *subvol)
+{
+        dht_local_t  *local  = NULL;
+        xlator_t     *src    = NULL;
+        int           ret    = -1;
+
+        local = frame->local;
+
+        src = dht_fd_subvol_get (this, local->fd_in);
+        if (!src) {
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "no cached subvolume for fd=%p", local->fd_in);
+                DHT_STACK_UNWIND (copy_file_range, frame, -1, EINVAL,
+                                  NULL, NULL, NULL);
+                return 0;
+        }
+
+        if ((src == subvol) && !local->streamed) {
+                STACK_WIND (frame, dht_copy_file_range_cbk, subvol,
+                            subvol->fops->copy_file_range, local->fd_in,
+                            local->offset_in, local->fd,
+                            local->rebalance.offset, local->rebalance.size,
+                            local->rebalance.flags);
+                return 0;
+        }
+
+        local->streamed = _gf_true;
+
+        ret = cluster_copy_file_range_stream (frame, this, src, local->fd_in,
+                                              local->offset_in, subvol,
+                                              local->fd,
+                                              local->rebalance.offset,
+                                              local->rebalance.size,
+                                              dht_copy_file_range_cbk);
+        if (ret)
+                DHT_STACK_UNWIND (copy_file_range, frame, -1, ENOMEM,
+                                  NULL, NULL, NULL);
+
+        return 0;
+}
+
+
+int
+dht_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                         int op_ret, int op_errno, struct iatt *stbuf_in,
+                         struct iatt *prebuf, struct iatt *postbuf)
+{
+        dht_local_t  *local = NULL;
+        call_frame_t *prev = NULL;
+        int           ret = -1;
+
+        GF_VALIDATE_OR_GOTO ("dht", frame, err);
+        GF_VALIDATE_OR_GOTO ("dht", this, out);
+        GF_VALIDATE_OR_GOTO ("dht", frame->local, out);
+
+        local = frame->local;
+        /* a streamed copy is answered without a frame of the subvolume */
+        prev = cookie;
+
+        /* a subvolume which can not copy the range itself */
+        if ((op_ret == -1) && !local->streamed &&
+            ((op_errno == EXDEV) || (op_errno == ENOSYS) ||
+             (op_errno == EOPNOTSUPP))) {
+                local->streamed = _gf_true;
+                dht_copy_file_range_wind (this, frame, prev->this);
+                return 0;
+        }
+
+        if ((op_ret == -1) && (op_errno != ENOENT)) {
+                local->op_errno = op_errno;
+                local->op_ret = -1;
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "copy to %s failed (%s)",
+                        prev ? prev->this->name : "the destination",
+                        strerror (op_errno));
+
+                goto out;
+        }
+
+        if (local->call_cnt != 1) {
+                if (local->stbuf.ia_blocks) {
+                        dht_iatt_merge (this, postbuf, &local->stbuf, NULL);
+                        dht_iatt_merge (this, prebuf, &local->prebuf, NULL);
+                }
+                goto out;
+        }
+
+        local->rebalance.target_op_fn = dht_copy_file_range2;
+
+        /* Phase 2 of migration */
+        if ((op_ret == -1) || IS_DHT_MIGRATION_PHASE2 (postbuf)) {
+                ret = dht_rebalance_complete_check (this, frame);
+                if (!ret)
+                        return 0;
+        }
+
+        /* Check if the rebalance phase1 is true */
+        if (IS_DHT_MIGRATION_PHASE1 (postbuf)) {
+                dht_iatt_merge (this, &local->stbuf, postbuf, NULL);
+                dht_iatt_merge (this, &local->prebuf, prebuf, NULL);
+                ret = fd_ctx_get (local->fd, this, NULL);
+                if (!ret) {
+                        dht_copy_file_range2 (this, frame, 0);
+                        return 0;
+                }
+                ret = dht_rebalance_in_progress_check (this, frame);
+                if (!ret)
+                        return 0;
+        }
+
+out:
+        DHT_STRIP_PHASE1_FLAGS (stbuf_in);
+        DHT_STRIP_PHASE1_FLAGS (postbuf);
+        DHT_STRIP_PHASE1_FLAGS (prebuf);
+        DHT_STACK_UNWIND (copy_file_range, frame, op_ret, op_errno,
+                          stbuf_in, prebuf, postbuf);
+err:
+        return 0;
+}
+
+
+int
+dht_copy_file_range2 (xlator_t *this, call_frame_t *frame, int op_ret)
+{
+        dht_local_t  *local  = NULL;
+        xlator_t     *subvol = NULL;
+        uint64_t      tmp_subvol = 0;
+        int           ret = -1;
+
+        local = frame->local;
+
+        if (local->fd)
+                ret = fd_ctx_get (local->fd, this, &tmp_subvol);
+        if (!ret)
+                subvol = (xlator_t *)(long)tmp_subvol;
+
+        if (!subvol)
+                subvol = local->cached_subvol;
+
+        local->call_cnt = 2; /* This is the second attempt */
+        local->streamed = _gf_false;
+
+        return dht_copy_file_range_wind (this, frame, subvol);
+}
+
+int
+dht_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                     off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                     uint32_t flags)
+{
+        xlator_t     *subvol = NULL;
+        int           op_errno = -1;
+        dht_local_t  *local = NULL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd_in, err);
+        VALIDATE_OR_GOTO (fd_out, err);
+
+        local = dht_local_init (frame, NULL, fd_out, GF_FOP_COPY_FILE_RANGE);
+        if (!local) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        local->fd_in            = fd_ref (fd_in);
+        local->offset_in        = off_in;
+        local->rebalance.offset = off_out;
+        local->rebalance.size   = len;
+        local->rebalance.flags  = flags;
+        local->call_cnt = 1;
+        subvol = local->cached_subvol;
+        if (!subvol) {
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "no cached subvolume for fd=%p", fd_out);
+                op_errno = EINVAL;
+                goto err;
+        }
+
+        dht_copy_file_range_wind (this, frame, subvol);
+
+        return 0;
+
+err:
+        op_errno = (op_errno == -1) ? errno : op_errno;
+        DHT_STACK_UNWIND (copy_file_range, frame, -1, op_errno, NULL, NULL,
+                          NULL);
+
+        return 0;
+}
+
 /* handle cases of migration here for 'setattr()' calls */
 int
 dht_file_setattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
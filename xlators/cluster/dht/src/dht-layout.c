@@ -349,6 +349,9 @@ dht_layout_merge (xlator_t *this, dht_layout_t *layout, xlator_t *subvol,
         int      err   = -1;
         void    *disk_layout_raw = NULL;
         int      disk_layout_len = 0;
+        void    *commit_hash_raw = NULL;
+        int      commit_hash_len = 0;
+        uint32_t commit_hash = 0;
 
         if (op_ret != 0) {
                 err = op_errno;
@@ -392,6 +395,17 @@ dht_layout_merge (xlator_t *this, dht_layout_t *layout, xlator_t *subvol,
         }
         layout->list[i].err = 0;
 
+        /* directories written before the commit marker existed (or by
+           a fix-layout which has not been followed by a data migration)
+           do not carry it, and are treated as 'in flux' */
+        layout->list[i].commit_hash = DHT_LAYOUT_HASH_INVALID;
+        if (!dict_get_ptr_and_len (xattr, DHT_COMMITHASH_KEY,
+                                   &commit_hash_raw, &commit_hash_len) &&
+            (commit_hash_len == sizeof (commit_hash))) {
+                memcpy (&commit_hash, commit_hash_raw, sizeof (commit_hash));
+                layout->list[i].commit_hash = ntoh32 (commit_hash);
+        }
+
 out:
         return ret;
 }
@@ -402,23 +416,27 @@ dht_layout_entry_swap (dht_layout_t *layout, int i, int j)
 {
         uint32_t  start_swap = 0;
         uint32_t  stop_swap = 0;
+        uint32_t  commit_swap = 0;
         xlator_t *xlator_swap = 0;
         int       err_swap = 0;
 
         start_swap  = layout->list[i].start;
         stop_swap   = layout->list[i].stop;
+        commit_swap = layout->list[i].commit_hash;
         xlator_swap = layout->list[i].xlator;
         err_swap    = layout->list[i].err;
 
-        layout->list[i].start  = layout->list[j].start;
-        layout->list[i].stop   = layout->list[j].stop;
-        layout->list[i].xlator = layout->list[j].xlator;
-        layout->list[i].err    = layout->list[j].err;
-
-        layout->list[j].start  = start_swap;
-        layout->list[j].stop   = stop_swap;
-        layout->list[j].xlator = xlator_swap;
-        layout->list[j].err    = err_swap;
+        layout->list[i].start       = layout->list[j].start;
+        layout->list[i].stop        = layout->list[j].stop;
+        layout->list[i].commit_hash = layout->list[j].commit_hash;
+        layout->list[i].xlator      = layout->list[j].xlator;
+        layout->list[i].err         = layout->list[j].err;
+
+        layout->list[j].start       = start_swap;
+        layout->list[j].stop        = stop_swap;
+        layout->list[j].commit_hash = commit_swap;
+        layout->list[j].xlator      = xlator_swap;
+        layout->list[j].err         = err_swap;
 }
 
 int64_t
@@ -636,6 +654,9 @@ dht_layout_dir_mismatch (xlator_t *this, dht_layout_t *layout, xlator_t *subvol,
         int32_t   count = -1;
         uint32_t  start_off = -1;
         uint32_t  stop_off = -1;
+        uint32_t  commit_hash = DHT_LAYOUT_HASH_INVALID;
+        void     *commit_hash_raw = NULL;
+        int       commit_hash_len = 0;
 
 
         for (idx = 0; idx < layout->cnt; idx++) {
@@ -700,6 +721,23 @@ dht_layout_dir_mismatch (xlator_t *this, dht_layout_t *layout, xlator_t *subvol,
                         layout->list[pos].start, layout->list[pos].stop,
                         start_off, stop_off);
                 ret = 1;
+                goto out;
+        }
+
+        if (!dict_get_ptr_and_len (xattr, DHT_COMMITHASH_KEY,
+                                   &commit_hash_raw, &commit_hash_len) &&
+            (commit_hash_len == sizeof (commit_hash))) {
+                memcpy (&commit_hash, commit_hash_raw, sizeof (commit_hash));
+                commit_hash = ntoh32 (commit_hash);
+        }
+
+        if (layout->list[pos].commit_hash != commit_hash) {
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "subvol: %s; inode commit hash - %"PRIu32"; "
+                        "disk commit hash - %"PRIu32,
+                        layout->list[pos].xlator->name,
+                        layout->list[pos].commit_hash, commit_hash);
+                ret = 1;
         } else {
                 ret = 0;
         }
@@ -708,6 +746,36 @@ out:
 }
 
 
+gf_boolean_t
+dht_layout_is_committed (xlator_t *this, dht_layout_t *layout)
+{
+        dht_conf_t   *conf = NULL;
+        int           i = 0;
+        gf_boolean_t  committed = _gf_false;
+
+        conf = this->private;
+        if (!conf || !layout || layout->preset)
+                goto out;
+
+        /* a subvolume missing from the layout (or holding the directory
+           without a range) may have entries the hashed subvolume does
+           not know about */
+        if (layout->cnt != conf->subvolume_cnt)
+                goto out;
+
+        for (i = 0; i < layout->cnt; i++) {
+                if (layout->list[i].err)
+                        goto out;
+                if (layout->list[i].commit_hash != conf->vol_commit_hash)
+                        goto out;
+        }
+
+        committed = _gf_true;
+out:
+        return committed;
+}
+
+
 int
 dht_layout_preset (xlator_t *this, xlator_t *subvol, inode_t *inode)
 {
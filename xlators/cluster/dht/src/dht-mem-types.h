@@ -37,6 +37,8 @@ enum gf_dht_mem_types_ {
         gf_switch_mt_switch_struct,
         gf_dht_mt_subvol_time,
         gf_dht_mt_loc_t,
+        gf_dht_mt_migrate_block_t,
+        gf_dht_mt_rdp_ctx_t,
         gf_dht_mt_end
 };
 #endif
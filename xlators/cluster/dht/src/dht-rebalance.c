@@ -30,75 +30,6 @@
 #define DHT_REBALANCE_BLKSIZE           (128 * 1024)
 #define DHT_MIGRATE_EVEN_IF_LINK_EXISTS 1
 
-static int
-dht_write_with_holes (xlator_t *to, fd_t *fd, struct iovec *vec, int count,
-                      int32_t size, off_t offset, struct iobref *iobref)
-{
-        int i            = 0;
-        int ret          = -1;
-        int start_idx    = 0;
-        int tmp_offset   = 0;
-        int write_needed = 0;
-        int buf_len      = 0;
-        int size_pending = 0;
-        char *buf        = NULL;
-
-        /* loop through each vector */
-        for (i = 0; i < count; i++) {
-                buf = vec[i].iov_base;
-                buf_len = vec[i].iov_len;
-
-                for (start_idx = 0; (start_idx + GF_DISK_SECTOR_SIZE) <= buf_len;
-                     start_idx += GF_DISK_SECTOR_SIZE) {
-
-                        if (mem_0filled (buf + start_idx, GF_DISK_SECTOR_SIZE) != 0) {
-                                write_needed = 1;
-                                continue;
-                        }
-
-                        if (write_needed) {
-                                ret = syncop_write (to, fd, (buf + tmp_offset),
-                                                    (start_idx - tmp_offset),
-                                                    (offset + tmp_offset),
-                                                    iobref);
-                                /* 'path' will be logged in calling function */
-                                if (ret < 0) {
-                                        gf_log (THIS->name, GF_LOG_WARNING,
-                                                "failed to write (%s)",
-                                                strerror (errno));
-                                        goto out;
-                                }
-
-                                write_needed = 0;
-                        }
-                        tmp_offset = start_idx + GF_DISK_SECTOR_SIZE;
-                }
-
-                if ((start_idx < buf_len) || write_needed) {
-                        /* This means, last chunk is not yet written.. write it */
-                        ret = syncop_write (to, fd, (buf + tmp_offset),
-                                            (buf_len - tmp_offset),
-                                            (offset + tmp_offset), iobref);
-                        if (ret < 0) {
-                                /* 'path' will be logged in calling function */
-                                gf_log (THIS->name, GF_LOG_WARNING,
-                                        "failed to write (%s)",
-                                        strerror (errno));
-                                goto out;
-                        }
-                }
-
-                size_pending = (size - buf_len);
-                if (!size_pending)
-                        break;
-        }
-
-        ret = size;
-out:
-        return ret;
-
-}
-
 static inline int
 __is_file_migratable (xlator_t *this, loc_t *loc, struct iatt *stbuf)
 {
@@ -246,55 +177,352 @@ out:
         return ret;
 }
 
+/* Data of a file is copied by a pipeline of blocks: up to 'window' blocks
+   are read from the source and written to the destination in parallel,
+   while the synctask doing the migration sleeps. The window shrinks by
+   half whenever a block takes longer than 'rebalance-throttle-latency'
+   to go through, and grows back one block at a time otherwise, so that a
+   busy brick (or a busy client in front of it) slows the migration down */
+struct dht_migrate_pipe {
+        gf_lock_t        lock;
+        struct synctask *task;
+        xlator_t        *from;
+        xlator_t        *to;
+        fd_t            *src;
+        fd_t            *dst;
+        uint64_t         ia_size;
+        uint64_t         offset;       /* next offset to read */
+        int              hole_exists;
+        int              window;       /* current, <= max_window */
+        int              max_window;
+        uint32_t         throttle_msec;
+        int              inflight;
+        int              waiting;
+        int              eof;
+        int              op_ret;
+        int              op_errno;
+};
+
+struct dht_migrate_block {
+        struct dht_migrate_pipe *pipe;
+        uint64_t                 offset;
+        size_t                   size;
+        struct timeval           start;
+        int                      pending;   /* writes in flight */
+        int                      op_ret;
+        int                      op_errno;
+};
+
+
+static void
+dht_migrate_block_done (struct dht_migrate_block *block)
+{
+        struct dht_migrate_pipe *pipe  = NULL;
+        struct timeval           now   = {0,};
+        uint64_t                 msec  = 0;
+        int                      wake  = 0;
+
+        pipe = block->pipe;
+
+        gettimeofday (&now, NULL);
+        msec = (((now.tv_sec - block->start.tv_sec) * 1000) +
+                ((now.tv_usec - block->start.tv_usec) / 1000));
+
+        LOCK (&pipe->lock);
+        {
+                pipe->inflight--;
+
+                if (block->op_ret < 0) {
+                        pipe->op_ret   = -1;
+                        pipe->op_errno = block->op_errno;
+                }
+
+                if (pipe->throttle_msec && (msec > pipe->throttle_msec)) {
+                        pipe->window /= 2;
+                        if (!pipe->window)
+                                pipe->window = 1;
+                } else if (pipe->window < pipe->max_window) {
+                        pipe->window++;
+                }
+
+                if (pipe->waiting) {
+                        pipe->waiting = 0;
+                        wake = 1;
+                }
+        }
+        UNLOCK (&pipe->lock);
+
+        if (wake)
+                synctask_wake (pipe->task);
+
+        GF_FREE (block);
+}
+
+
+static int
+dht_migrate_block_write_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                             int32_t op_ret, int32_t op_errno,
+                             struct iatt *prebuf, struct iatt *postbuf)
+{
+        struct dht_migrate_block *block   = NULL;
+        int                       pending = 0;
+
+        block = cookie;
+
+        LOCK (&block->pipe->lock);
+        {
+                if (op_ret < 0) {
+                        block->op_ret   = -1;
+                        block->op_errno = op_errno;
+                }
+                pending = --block->pending;
+        }
+        UNLOCK (&block->pipe->lock);
+
+        if (op_ret < 0)
+                gf_log (this->name, GF_LOG_WARNING,
+                        "failed to write (%s)", strerror (op_errno));
+
+        if (!pending)
+                dht_migrate_block_done (block);
+
+        return 0;
+}
+
+
+/* Walks the sectors of @vec and calls back (or only counts, when @frame
+   is NULL) for every run of data which has to reach the destination:
+   non-zero sectors and the unaligned tail of each vector. Zero filled
+   sectors are skipped to keep the holes of a sparse file. */
+static int
+dht_migrate_block_extents (call_frame_t *frame,
+                           struct dht_migrate_block *block,
+                           struct iovec *vec, int count,
+                           struct iobref *iobref)
+{
+        struct dht_migrate_pipe *pipe     = NULL;
+        struct iovec             extent   = {0,};
+        char                    *buf      = NULL;
+        size_t                   buf_len  = 0;
+        size_t                   idx      = 0;
+        size_t                   run      = 0;
+        uint64_t                 offset   = 0;
+        int                      i        = 0;
+        int                      extents  = 0;
+        int                      wound    = 0;
+        int                      total    = 0;
+
+        pipe = block->pipe;
+        offset = block->offset;
+
+        if (frame)
+                total = block->pending;
+
+        for (i = 0; i < count; i++) {
+                buf = vec[i].iov_base;
+                buf_len = vec[i].iov_len;
+                run = 0;
+
+                for (idx = 0; idx <= buf_len; idx += GF_DISK_SECTOR_SIZE) {
+                        if ((idx + GF_DISK_SECTOR_SIZE <= buf_len) &&
+                            (mem_0filled (buf + idx, GF_DISK_SECTOR_SIZE)
+                             != 0)) {
+                                /* sector with data, extend the run */
+                                continue;
+                        }
+
+                        /* a zero filled sector or the tail ends the run;
+                           the tail itself is always written */
+                        if (idx + GF_DISK_SECTOR_SIZE > buf_len)
+                                idx = buf_len;
+
+                        if (idx > run) {
+                                extents++;
+                                if (frame) {
+                                        extent.iov_base = buf + run;
+                                        extent.iov_len  = idx - run;
+                                        wound++;
+                                        STACK_WIND_COOKIE (frame,
+                                                dht_migrate_block_write_cbk,
+                                                block, pipe->to,
+                                                pipe->to->fops->writev,
+                                                pipe->dst, &extent, 1,
+                                                offset + run, iobref);
+                                        /* @block is gone with the last
+                                           completion */
+                                        if (wound == total)
+                                                return extents;
+                                }
+                        }
+                        run = idx + GF_DISK_SECTOR_SIZE;
+                }
+
+                offset += buf_len;
+        }
+
+        return extents;
+}
+
+
+static int
+dht_migrate_block_read_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                            int32_t op_ret, int32_t op_errno,
+                            struct iovec *vector, int32_t count,
+                            struct iatt *stbuf, struct iobref *iobref)
+{
+        struct dht_migrate_block *block   = NULL;
+        struct dht_migrate_pipe  *pipe    = NULL;
+        int                       extents = 0;
+
+        block = cookie;
+        pipe  = block->pipe;
+
+        if (op_ret <= 0) {
+                /* '0' is end of file (file shrunk while migrating), not
+                   a failure; no more blocks are to be issued */
+                LOCK (&pipe->lock);
+                {
+                        pipe->eof = 1;
+                }
+                UNLOCK (&pipe->lock);
+
+                if (op_ret < 0) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "failed to read at offset %"PRIu64" (%s)",
+                                block->offset, strerror (op_errno));
+                        block->op_ret   = -1;
+                        block->op_errno = op_errno;
+                }
+                dht_migrate_block_done (block);
+                goto out;
+        }
+
+        if (!pipe->hole_exists) {
+                block->pending = 1;
+                STACK_WIND_COOKIE (frame, dht_migrate_block_write_cbk, block,
+                                   pipe->to, pipe->to->fops->writev,
+                                   pipe->dst, vector, count, block->offset,
+                                   iobref);
+                goto out;
+        }
+
+        extents = dht_migrate_block_extents (NULL, block, vector, count,
+                                             iobref);
+        if (!extents) {
+                /* whole block is a hole */
+                dht_migrate_block_done (block);
+                goto out;
+        }
+
+        block->pending = extents;
+        dht_migrate_block_extents (frame, block, vector, count, iobref);
+
+out:
+        return 0;
+}
+
+
 static inline int
-__dht_rebalance_migrate_data (xlator_t *from, xlator_t *to, fd_t *src, fd_t *dst,
-                             uint64_t ia_size, int hole_exists)
+__dht_rebalance_migrate_data (xlator_t *this, xlator_t *from, xlator_t *to,
+                              fd_t *src, fd_t *dst, uint64_t ia_size,
+                              int hole_exists)
 {
-        int            ret    = 0;
-        int            count  = 0;
-        off_t          offset = 0;
-        struct iovec  *vector = NULL;
-        struct iobref *iobref = NULL;
-        uint64_t       total  = 0;
-        size_t         read_size = 0;
-
-        /* if file size is '0', no need to enter this loop */
-        while (total < ia_size) {
-                read_size = (((ia_size - total) > DHT_REBALANCE_BLKSIZE) ?
-                             DHT_REBALANCE_BLKSIZE : (ia_size - total));
-                ret = syncop_readv (from, src, read_size,
-                                    offset, &vector, &count, &iobref);
-                if (!ret || (ret < 0)) {
-                        break;
+        dht_conf_t               *conf   = NULL;
+        struct dht_migrate_pipe   pipe   = {0,};
+        struct dht_migrate_block *block  = NULL;
+        call_frame_t             *frame  = NULL;
+        size_t                    size   = 0;
+        int                       ret    = 0;
+
+        conf = this->private;
+
+        LOCK_INIT (&pipe.lock);
+        pipe.task        = synctask_get ();
+        pipe.from        = from;
+        pipe.to          = to;
+        pipe.src         = src;
+        pipe.dst         = dst;
+        pipe.ia_size     = ia_size;
+        pipe.hole_exists = hole_exists;
+        pipe.max_window  = (conf->rebal_window ? conf->rebal_window : 1);
+        pipe.window      = pipe.max_window;
+        pipe.throttle_msec = conf->rebal_throttle_msec;
+
+        frame = pipe.task->frame;
+
+        for (;;) {
+                /* fill the window */
+                for (;;) {
+                        LOCK (&pipe.lock);
+                        {
+                                if ((pipe.op_ret < 0) || pipe.eof ||
+                                    (pipe.offset >= pipe.ia_size) ||
+                                    (pipe.inflight >= pipe.window)) {
+                                        UNLOCK (&pipe.lock);
+                                        break;
+                                }
+
+                                size = (((pipe.ia_size - pipe.offset) >
+                                         DHT_REBALANCE_BLKSIZE) ?
+                                        DHT_REBALANCE_BLKSIZE :
+                                        (pipe.ia_size - pipe.offset));
+
+                                block = GF_CALLOC (1, sizeof (*block),
+                                                   gf_dht_mt_migrate_block_t);
+                                if (!block) {
+                                        pipe.op_ret = -1;
+                                        pipe.op_errno = ENOMEM;
+                                        UNLOCK (&pipe.lock);
+                                        break;
+                                }
+
+                                block->pipe   = &pipe;
+                                block->offset = pipe.offset;
+                                block->size   = size;
+
+                                pipe.offset += size;
+                                pipe.inflight++;
+                        }
+                        UNLOCK (&pipe.lock);
+
+                        gettimeofday (&block->start, NULL);
+                        STACK_WIND_COOKIE (frame, dht_migrate_block_read_cbk,
+                                           block, from, from->fops->readv,
+                                           src, block->size, block->offset);
                 }
 
-                if (hole_exists)
-                        ret = dht_write_with_holes (to, dst, vector, count,
-                                                    ret, offset, iobref);
-                else
-                        ret = syncop_writev (to, dst, vector, count,
-                                             offset, iobref);
-                if (ret < 0) {
-                        break;
+                /* wait for a slot (or for the last block) */
+                LOCK (&pipe.lock);
+                {
+                        if (!pipe.inflight) {
+                                UNLOCK (&pipe.lock);
+                                break;
+                        }
+                        pipe.waiting = 1;
+                        synctask_yawn (pipe.task);
                 }
-                offset += ret;
-                total += ret;
+                UNLOCK (&pipe.lock);
 
-                if (vector)
-                        GF_FREE (vector);
-                if (iobref)
-                        iobref_unref (iobref);
-                iobref = NULL;
-                vector = NULL;
+                synctask_yield (pipe.task);
         }
-        if (iobref)
-                iobref_unref (iobref);
-        if (vector)
-                GF_FREE (vector);
 
-        if (ret >= 0)
-                ret = 0;
+        LOCK_DESTROY (&pipe.lock);
+
+        if (pipe.op_ret < 0) {
+                errno = pipe.op_errno;
+                ret = -1;
+                goto out;
+        }
 
+        /* a hole at the end of the file was never written */
+        if (hole_exists && !pipe.eof) {
+                ret = syncop_ftruncate (to, dst, ia_size);
+                if (ret)
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "failed to set the size of destination (%s)",
+                                strerror (errno));
+        }
+out:
         return ret;
 }
 
@@ -570,8 +798,8 @@ dht_migrate_file (xlator_t *this, loc_t *loc, xlator_t *from, xlator_t *to,
                 file_has_holes = 1;
 
         /* All I/O happens in this function */
-        ret = __dht_rebalance_migrate_data (from, to, src_fd, dst_fd,
-					    stbuf.ia_size, file_has_holes);
+        ret = __dht_rebalance_migrate_data (this, from, to, src_fd, dst_fd,
+                                            stbuf.ia_size, file_has_holes);
         if (ret) {
                 gf_log (this->name, GF_LOG_ERROR, "%s: failed to migrate data",
                         loc->path);
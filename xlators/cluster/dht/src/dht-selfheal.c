@@ -26,6 +26,7 @@
 #include "glusterfs.h"
 #include "xlator.h"
 #include "dht-common.h"
+#include "byte-order.h"
 
 
 #define DHT_SET_LAYOUT_RANGE(layout,i,srt,chunk,cnt,path)    do {       \
@@ -136,6 +137,7 @@ dht_selfheal_dir_xattr_persubvol (call_frame_t *frame, loc_t *loc,
         int                ret = 0;
         xlator_t          *this = NULL;
         int32_t           *disk_layout = NULL;
+        uint32_t          *commit_hash = NULL;
         dht_local_t       *local = NULL;
 
 
@@ -166,6 +168,23 @@ dht_selfheal_dir_xattr_persubvol (call_frame_t *frame, loc_t *loc,
         }
         disk_layout = NULL;
 
+        /* a new range always goes out with the commit marker of the
+           layout entry, which overwrites any stale one on the subvolume */
+        commit_hash = GF_CALLOC (1, sizeof (uint32_t), gf_dht_mt_int32_t);
+        if (!commit_hash)
+                goto err;
+
+        *commit_hash = hton32 (layout->list[i].commit_hash);
+        ret = dict_set_bin (xattr, DHT_COMMITHASH_KEY, commit_hash,
+                            sizeof (uint32_t));
+        if (ret == -1) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "%s: (subvol %s) failed to set commit hash",
+                        loc->path, subvol->name);
+                goto err;
+        }
+        commit_hash = NULL;
+
         gf_log (this->name, GF_LOG_TRACE,
                 "setting hash range %u - %u (type %d) on subvolume %s for %s",
                 layout->list[i].start, layout->list[i].stop,
@@ -191,6 +210,9 @@ err:
         if (disk_layout)
                 GF_FREE (disk_layout);
 
+        if (commit_hash)
+                GF_FREE (commit_hash);
+
         dht_selfheal_dir_xattr_cbk (frame, subvol, frame->this,
                                     -1, ENOMEM);
         return 0;
@@ -511,6 +533,165 @@ dht_get_layout_count (xlator_t *this, dht_layout_t *layout, int new_layout)
 }
 
 
+/* Capacity (in MB) of the subvolumes of the 'cnt' layout entries in
+   'order', as last reported by statfs. Returns the sum, or 0 when the
+   capacity of any of them is not known yet. */
+static uint64_t
+dht_selfheal_layout_weights (xlator_t *this, dht_layout_t *layout,
+                             int *order, int cnt, uint64_t *weights)
+{
+        dht_conf_t *conf  = NULL;
+        uint64_t    total = 0;
+        int         i     = 0;
+        int         j     = 0;
+
+        conf = this->private;
+
+        LOCK (&conf->subvolume_lock);
+        {
+                for (i = 0; i < cnt; i++) {
+                        weights[i] = 0;
+                        for (j = 0; j < conf->subvolume_cnt; j++) {
+                                if (conf->subvolumes[j] ==
+                                    layout->list[order[i]].xlator) {
+                                        weights[i] =
+                                          conf->du_stats[j].total_space >> 20;
+                                        break;
+                                }
+                        }
+                        if (!weights[i]) {
+                                total = 0;
+                                break;
+                        }
+                        total += weights[i];
+                }
+        }
+        UNLOCK (&conf->subvolume_lock);
+
+        return total;
+}
+
+
+/* Hands out the hash space to the 'cnt' layout entries in 'order', in
+   that order, each one getting a range proportional to the capacity of
+   its subvolume. Returns -1 (layout untouched) when capacities are not
+   known, so that the caller can fall back to equal ranges. */
+static int
+dht_selfheal_layout_set_weighted (xlator_t *this, loc_t *loc,
+                                  dht_layout_t *layout, int *order, int cnt)
+{
+        uint64_t     *weights = NULL;
+        uint64_t      total   = 0;
+        uint32_t      start   = 0;
+        uint32_t      chunk   = 0;
+        int           i       = 0;
+        int           ret     = -1;
+
+        if (!cnt)
+                goto out;
+
+        weights = GF_CALLOC (cnt, sizeof (uint64_t), gf_common_mt_char);
+        if (!weights)
+                goto out;
+
+        total = dht_selfheal_layout_weights (this, layout, order, cnt,
+                                             weights);
+        if (!total) {
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "%s: subvolume sizes not known yet, using equal "
+                        "ranges", loc->path);
+                goto out;
+        }
+
+        for (i = 0; i < cnt; i++) {
+                chunk = (uint32_t) (((double) 0xffffffff * weights[i]) /
+                                    total);
+                if (!chunk)
+                        chunk = 1;
+
+                layout->list[order[i]].err = -1;
+                DHT_SET_LAYOUT_RANGE (layout, order[i], start, chunk, cnt,
+                                      loc->path);
+                if (i == (cnt - 1))
+                        layout->list[order[i]].stop = 0xffffffff;
+                start += chunk;
+        }
+
+        ret = 0;
+out:
+        GF_FREE (weights);
+
+        return ret;
+}
+
+
+/* Weighted version of the fix-layout: the subvolumes which already hold
+   a range keep their relative order on the hash ring (so only the
+   boundaries move, and with them the least amount of data), and those
+   without one are appended after them. */
+static int
+dht_fix_layout_weighted (xlator_t *this, loc_t *loc, dht_layout_t *layout,
+                         dht_layout_t *new_layout, int count,
+                         int start_subvol)
+{
+        int          *order = NULL;
+        int           cnt   = 0;
+        int           tmp   = 0;
+        int           i     = 0;
+        int           j     = 0;
+        int           ret   = -1;
+
+        order = GF_CALLOC (layout->cnt, sizeof (int), gf_common_mt_char);
+        if (!order)
+                goto out;
+
+        for (i = 0; i < layout->cnt; i++) {
+                if (layout->list[i].err != -1)
+                        continue;
+                if ((layout->list[i].stop - layout->list[i].start) == 0)
+                        continue;
+
+                /* insertion sort on the existing start of the range */
+                for (j = cnt; j > 0; j--) {
+                        tmp = order[j - 1];
+                        if (layout->list[tmp].start <= layout->list[i].start)
+                                break;
+                        order[j] = tmp;
+                }
+                order[j] = i;
+                cnt++;
+        }
+
+        for (j = 0, i = start_subvol; j < layout->cnt; i++, j++) {
+                if (i == layout->cnt)
+                        i = 0;
+                if (layout->list[i].err != -1)
+                        continue;
+                if ((layout->list[i].stop - layout->list[i].start) != 0)
+                        continue;
+                order[cnt++] = i;
+        }
+
+        if (cnt > count)
+                cnt = count;
+
+        ret = dht_selfheal_layout_set_weighted (this, loc, new_layout,
+                                                order, cnt);
+        if (ret)
+                goto out;
+
+        for (i = 0; i < layout->cnt; i++) {
+                if ((new_layout->list[i].err == -ENOENT) &&
+                    (layout->list[i].err != -1))
+                        new_layout->list[i].err = layout->list[i].err;
+        }
+out:
+        GF_FREE (order);
+
+        return ret;
+}
+
+
 dht_layout_t *
 dht_fix_layout_of_directory (call_frame_t *frame, loc_t *loc,
                              dht_layout_t *layout)
@@ -561,6 +742,11 @@ dht_fix_layout_of_directory (call_frame_t *frame, loc_t *loc,
                         new_layout->list[i].xlator = layout->list[i].xlator;
         }
 
+        if (priv->do_weighting &&
+            !dht_fix_layout_weighted (this, loc, layout, new_layout, count,
+                                      start_subvol))
+                goto done;
+
         /* Check if there are any overlap in layout, and give the proper fix */
         for (i = 0; i < layout->cnt; i++) {
                 /* No need to fix if 'err' is not '-1' */
@@ -668,14 +854,19 @@ dht_selfheal_layout_new_directory (call_frame_t *frame, loc_t *loc,
                                    dht_layout_t *layout)
 {
         xlator_t    *this = NULL;
+        dht_conf_t  *conf = NULL;
         uint32_t     chunk = 0;
         int          i = 0;
+        int          j = 0;
         uint32_t     start = 0;
         int          cnt = 0;
         int          err = 0;
         int          start_subvol = 0;
+        int         *order = NULL;
+        int          ret = -1;
 
         this = frame->this;
+        conf = this->private;
 
         cnt = dht_get_layout_count (this, layout, 1);
 
@@ -683,6 +874,28 @@ dht_selfheal_layout_new_directory (call_frame_t *frame, loc_t *loc,
 
         start_subvol = dht_selfheal_layout_alloc_start (this, loc, layout);
 
+        if (conf->do_weighting) {
+                order = GF_CALLOC (layout->cnt, sizeof (int),
+                                   gf_common_mt_char);
+                if (!order)
+                        goto equal;
+
+                for (i = start_subvol; (j < cnt) && (i < layout->cnt); i++)
+                        if (layout->list[i].err == -1)
+                                order[j++] = i;
+                for (i = 0; (j < cnt) && (i < start_subvol); i++)
+                        if (layout->list[i].err == -1)
+                                order[j++] = i;
+
+                ret = dht_selfheal_layout_set_weighted (this, loc, layout,
+                                                        order, j);
+                GF_FREE (order);
+                if (!ret)
+                        goto done;
+        }
+
+equal:
+
         for (i = start_subvol; i < layout->cnt; i++) {
                 err = layout->list[i].err;
                 if (err == -1) {
@@ -770,34 +983,238 @@ dht_selfheal_new_directory (call_frame_t *frame,
                             dht_layout_t *layout)
 {
         dht_local_t *local = NULL;
+        dht_conf_t  *conf = NULL;
+        int          i = 0;
 
         local = frame->local;
+        conf = frame->this->private;
 
         local->selfheal.dir_cbk = dir_cbk;
         local->selfheal.layout = dht_layout_ref (frame->this, layout);
 
+        /* a directory which was just created can not have any entry
+           away from its hashed subvolume, so it starts out committed */
+        for (i = 0; i < layout->cnt; i++)
+                layout->list[i].commit_hash = conf->vol_commit_hash;
+
         dht_layout_sort_volname (layout);
         dht_selfheal_layout_new_directory (frame, &local->loc, layout);
         dht_selfheal_dir_xattr (frame, &local->loc, layout);
         return 0;
 }
 
+static int
+dht_fix_directory_layout_apply (call_frame_t *frame)
+{
+        dht_local_t  *local = NULL;
+        dht_layout_t *tmp_layout = NULL;
+
+        local = frame->local;
+
+        /* No layout sorting required here */
+        tmp_layout = dht_fix_layout_of_directory (frame, &local->loc,
+                                                  local->selfheal.layout);
+        dht_fix_dir_xattr (frame, &local->loc, tmp_layout);
+
+        return 0;
+}
+
+
+int
+dht_fix_directory_du_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                          int op_ret, int op_errno, struct statvfs *statvfs)
+{
+        call_frame_t *prev = NULL;
+        int           this_call_cnt = 0;
+
+        prev = cookie;
+
+        if (op_ret == -1)
+                gf_log (this->name, GF_LOG_WARNING,
+                        "failed to get disk info from %s (%s)",
+                        prev->this->name, strerror (op_errno));
+        else
+                dht_du_info_update (this, prev->this, statvfs);
+
+        this_call_cnt = dht_frame_return (frame);
+        if (is_last_call (this_call_cnt))
+                dht_fix_directory_layout_apply (frame);
+
+        return 0;
+}
+
+
 int
 dht_fix_directory_layout (call_frame_t *frame,
                           dht_selfheal_dir_cbk_t dir_cbk,
                           dht_layout_t *layout)
 {
         dht_local_t  *local = NULL;
-        dht_layout_t *tmp_layout = NULL;
+        dht_conf_t   *conf = NULL;
+        int           i = 0;
 
         local = frame->local;
+        conf = frame->this->private;
 
         local->selfheal.dir_cbk = dir_cbk;
         local->selfheal.layout = dht_layout_ref (frame->this, layout);
 
-        /* No layout sorting required here */
-        tmp_layout = dht_fix_layout_of_directory (frame, &local->loc, layout);
-        dht_fix_dir_xattr (frame, &local->loc, tmp_layout);
+        /* the weighted layout needs the size of every subvolume; get
+           them before the first directory is fixed */
+        if (conf->do_weighting && !dht_du_info_available (frame->this)) {
+                local->call_cnt = conf->subvolume_cnt;
+                for (i = 0; i < conf->subvolume_cnt; i++) {
+                        STACK_WIND (frame, dht_fix_directory_du_cbk,
+                                    conf->subvolumes[i],
+                                    conf->subvolumes[i]->fops->statfs,
+                                    &local->loc);
+                }
+                return 0;
+        }
+
+        dht_fix_directory_layout_apply (frame);
+
+        return 0;
+}
+
+
+int
+dht_commit_dir_xattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                          int op_ret, int op_errno)
+{
+        dht_local_t  *local = NULL;
+        dht_conf_t   *conf = NULL;
+        dht_layout_t *layout = NULL;
+        call_frame_t *prev = NULL;
+        int           i = 0;
+        int           this_call_cnt = 0;
+
+        local = frame->local;
+        conf = this->private;
+        layout = local->selfheal.layout;
+        prev = cookie;
+
+        LOCK (&frame->lock);
+        {
+                if (op_ret == -1) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "%s: failed to commit layout on %s (%s)",
+                                local->loc.path, prev->this->name,
+                                strerror (op_errno));
+                        local->op_ret = -1;
+                        local->op_errno = op_errno;
+                        goto unlock;
+                }
+
+                for (i = 0; i < layout->cnt; i++) {
+                        if (layout->list[i].xlator == prev->this) {
+                                layout->list[i].commit_hash =
+                                        conf->vol_commit_hash;
+                                break;
+                        }
+                }
+        }
+unlock:
+        UNLOCK (&frame->lock);
+
+        this_call_cnt = dht_frame_return (frame);
+
+        if (is_last_call (this_call_cnt))
+                dht_selfheal_dir_finish (frame, this, local->op_ret);
+
+        return 0;
+}
+
+
+/* Marks a directory as fully rebalanced: every entry of it is on its
+   hashed subvolume, or has a linkfile there. Lookups of missing names
+   in such a directory are answered by the hashed subvolume alone. */
+int
+dht_commit_directory_layout (call_frame_t *frame,
+                             dht_selfheal_dir_cbk_t dir_cbk,
+                             dht_layout_t *layout)
+{
+        dht_local_t  *local = NULL;
+        dht_conf_t   *conf = NULL;
+        xlator_t     *this = NULL;
+        dict_t       *xattr = NULL;
+        uint32_t     *commit_hash = NULL;
+        int           i = 0;
+        int           ret = -1;
+        int           count = 0;
+
+        local = frame->local;
+        this = frame->this;
+        conf = this->private;
+
+        local->selfheal.dir_cbk = dir_cbk;
+        local->selfheal.layout = dht_layout_ref (this, layout);
+
+        if (layout->cnt != conf->subvolume_cnt) {
+                local->op_errno = EAGAIN;
+                goto err;
+        }
+
+        for (i = 0; i < layout->cnt; i++) {
+                if (layout->list[i].err) {
+                        gf_log (this->name, GF_LOG_INFO,
+                                "%s: layout not complete on %s, "
+                                "not committing", local->loc.path,
+                                layout->list[i].xlator->name);
+                        local->op_errno = EAGAIN;
+                        goto err;
+                }
+        }
+
+        xattr = dict_new ();
+        if (!xattr) {
+                local->op_errno = ENOMEM;
+                goto err;
+        }
+
+        commit_hash = GF_CALLOC (1, sizeof (uint32_t), gf_dht_mt_int32_t);
+        if (!commit_hash) {
+                local->op_errno = ENOMEM;
+                goto err;
+        }
+
+        *commit_hash = hton32 (conf->vol_commit_hash);
+        ret = dict_set_bin (xattr, DHT_COMMITHASH_KEY, commit_hash,
+                            sizeof (uint32_t));
+        if (ret) {
+                GF_FREE (commit_hash);
+                local->op_errno = ENOMEM;
+                goto err;
+        }
+
+        if (!uuid_is_null (local->gfid))
+                uuid_copy (local->loc.gfid, local->gfid);
+
+        gf_log (this->name, GF_LOG_DEBUG,
+                "committing layout of %s (hash %"PRIu32")",
+                local->loc.path, conf->vol_commit_hash);
+
+        local->op_ret = 0;
+        local->call_cnt = count = layout->cnt;
+
+        for (i = 0; i < layout->cnt; i++) {
+                STACK_WIND (frame, dht_commit_dir_xattr_cbk,
+                            layout->list[i].xlator,
+                            layout->list[i].xlator->fops->setxattr,
+                            &local->loc, xattr, 0);
+                if (--count == 0)
+                        break;
+        }
+
+        dict_unref (xattr);
+
+        return 0;
+
+err:
+        if (xattr)
+                dict_unref (xattr);
+
+        dht_selfheal_dir_finish (frame, this, -1);
 
         return 0;
 }
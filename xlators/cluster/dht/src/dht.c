@@ -62,6 +62,8 @@ dht_layout_dump (dht_layout_t  *layout, const char *prefix)
                 gf_proc_dump_write(key, "%u", layout->list[i].start);
                 gf_proc_dump_build_key(key, prefix,"list[%d].stop", i);
                 gf_proc_dump_write(key, "%u", layout->list[i].stop);
+                gf_proc_dump_build_key(key, prefix,"list[%d].commit_hash", i);
+                gf_proc_dump_write(key, "%u", layout->list[i].commit_hash);
                 if (layout->list[i].xlator) {
                         gf_proc_dump_build_key(key, prefix,
                                                "list[%d].xlator.type", i);
@@ -130,6 +132,12 @@ dht_priv_dump (xlator_t *this)
 
         gf_proc_dump_write("search_unhashed", "%d", conf->search_unhashed);
         gf_proc_dump_write("gen", "%d", conf->gen);
+        gf_proc_dump_write("vol_commit_hash", "%u", conf->vol_commit_hash);
+        gf_proc_dump_write("rebalance_read_window", "%u", conf->rebal_window);
+        gf_proc_dump_write("rebalance_throttle_latency", "%u",
+                           conf->rebal_throttle_msec);
+        gf_proc_dump_write("weighted_rebalance", "%d", conf->do_weighting);
+        gf_proc_dump_write("parallel_readdir", "%d", conf->parallel_readdir);
         gf_proc_dump_write("min_free_disk", "%lu", conf->min_free_disk);
 	gf_proc_dump_write("min_free_inodes", "%lu", conf->min_free_inodes);
         gf_proc_dump_write("disk_unit", "%c", conf->disk_unit);
@@ -327,6 +335,14 @@ reconfigure (xlator_t *this, dict_t *options)
                           percent, out);
         GF_OPTION_RECONF ("directory-layout-spread", conf->dir_spread_cnt,
                           options, uint32, out);
+        GF_OPTION_RECONF ("rebalance-read-window", conf->rebal_window,
+                          options, uint32, out);
+        GF_OPTION_RECONF ("rebalance-throttle-latency",
+                          conf->rebal_throttle_msec, options, uint32, out);
+        GF_OPTION_RECONF ("weighted-rebalance", conf->do_weighting, options,
+                          bool, out);
+        GF_OPTION_RECONF ("parallel-readdir", conf->parallel_readdir, options,
+                          bool, out);
 
         if (dict_get_str (options, "decommissioned-bricks", &temp_str) == 0) {
                 ret = dht_parse_decommissioned_bricks (this, conf, temp_str);
@@ -393,6 +409,16 @@ init (xlator_t *this)
         GF_OPTION_INIT ("assert-no-child-down", conf->assert_no_child_down,
                         bool, err);
 
+        GF_OPTION_INIT ("rebalance-read-window", conf->rebal_window,
+                        uint32, err);
+
+        GF_OPTION_INIT ("rebalance-throttle-latency",
+                        conf->rebal_throttle_msec, uint32, err);
+
+        GF_OPTION_INIT ("weighted-rebalance", conf->do_weighting, bool, err);
+
+        GF_OPTION_INIT ("parallel-readdir", conf->parallel_readdir, bool, err);
+
         ret = dht_init_subvolumes (this, conf);
         if (ret == -1) {
                 goto err;
@@ -491,6 +517,10 @@ struct xlator_fops fops = {
         .fsetxattr   = dht_fsetxattr,
         .truncate    = dht_truncate,
         .ftruncate   = dht_ftruncate,
+        .fallocate   = dht_fallocate,
+        .discard     = dht_discard,
+        .zerofill    = dht_zerofill,
+        .copy_file_range = dht_copy_file_range,
         .writev      = dht_writev,
         .xattrop     = dht_xattrop,
         .fxattrop    = dht_fxattrop,
@@ -506,7 +536,7 @@ struct xlator_dumpops dumpops = {
 
 struct xlator_cbks cbks = {
 //      .release    = dht_release,
-//      .releasedir = dht_releasedir,
+        .releasedir = dht_releasedir,
         .forget     = dht_forget
 };
 
@@ -548,5 +578,36 @@ struct volume_options options[] = {
         { .key  = {"decommissioned-bricks"},
           .type = GF_OPTION_TYPE_ANY,
         },
+        { .key  = {"rebalance-read-window"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 1,
+          .max  = 64,
+          .default_value = "4",
+          .description = "Number of blocks of a file kept in flight while "
+                         "migrating it during rebalance."
+        },
+        { .key  = {"rebalance-throttle-latency"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 0,
+          .default_value = "200",
+          .description = "Time (in milliseconds) a migrated block may take "
+                         "before rebalance reduces the number of blocks in "
+                         "flight. 0 disables throttling."
+        },
+        { .key  = {"weighted-rebalance"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "When enabled, the hash range given to each "
+                         "subvolume in a directory layout is proportional "
+                         "to its size. Run fix-layout to apply it to "
+                         "existing directories."
+        },
+        { .key  = {"parallel-readdir"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Read directories from all the subvolumes at "
+                         "once, keeping one batch of entries read ahead "
+                         "per subvolume."
+        },
         { .key  = {NULL} },
 };
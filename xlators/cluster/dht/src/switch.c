@@ -289,6 +289,8 @@ switch_lookup (call_frame_t *frame, xlator_t *this,
                 /* NOTE: we don't require 'trusted.glusterfs.dht.linkto'
                  * attribute, revalidates directly go to the cached-subvolume.
                  */
+                ret = dict_set_uint32 (local->xattr_req, DHT_COMMITHASH_KEY,
+                                       sizeof (uint32_t));
                 ret = dict_set_uint32 (local->xattr_req,
                                        "trusted.glusterfs.dht", 4 * 4);
                 if (ret < 0)
@@ -308,6 +310,8 @@ switch_lookup (call_frame_t *frame, xlator_t *this,
                 }
         } else {
         do_fresh_lookup:
+                ret = dict_set_uint32 (local->xattr_req, DHT_COMMITHASH_KEY,
+                                       sizeof (uint32_t));
                 ret = dict_set_uint32 (local->xattr_req,
                                        "trusted.glusterfs.dht", 4 * 4);
                 if (ret < 0)
@@ -971,6 +975,10 @@ struct xlator_fops fops = {
         .fstat       = dht_fstat,
         .truncate    = dht_truncate,
         .ftruncate   = dht_ftruncate,
+        .fallocate   = dht_fallocate,
+        .discard     = dht_discard,
+        .zerofill    = dht_zerofill,
+        .copy_file_range = dht_copy_file_range,
         .access      = dht_access,
         .readlink    = dht_readlink,
         .setxattr    = dht_setxattr,
@@ -0,0 +1,317 @@
+/*
+  Copyright (c) 2012 Gluster, Inc. <http://www.gluster.com>
+  This file is part of GlusterFS.
+
+  GlusterFS is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published
+  by the Free Software Foundation; either version 3 of the License,
+  or (at your option) any later version.
+
+  GlusterFS is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <pthread.h>
+
+#include "ec-gf.h"
+
+/* x^8 + x^4 + x^3 + x^2 + 1 */
+#define EC_GF_POLY     0x11d
+#define EC_GF_MAX_ROWS 256
+
+static pthread_once_t ec_gf_once = PTHREAD_ONCE_INIT;
+
+static uint8_t ec_gf_exp[512];
+static uint8_t ec_gf_log[256];
+
+/* products of every field element with every field element */
+static uint8_t ec_gf_mul_table[256][256];
+
+#if defined(__x86_64__) && defined(__GNUC__)
+static int ec_gf_ssse3_usable;
+#endif
+
+static void
+ec_gf_init (void)
+{
+        int      i = 0;
+        int      j = 0;
+        uint16_t x = 1;
+
+        for (i = 0; i < 255; i++) {
+                ec_gf_exp[i] = x;
+                ec_gf_log[x] = i;
+                x <<= 1;
+                if (x & 0x100)
+                        x ^= EC_GF_POLY;
+        }
+        for (i = 255; i < 512; i++)
+                ec_gf_exp[i] = ec_gf_exp[i - 255];
+
+        for (i = 1; i < 256; i++)
+                for (j = 1; j < 256; j++)
+                        ec_gf_mul_table[i][j] =
+                                ec_gf_exp[ec_gf_log[i] + ec_gf_log[j]];
+
+#if defined(__x86_64__) && defined(__GNUC__)
+        __builtin_cpu_init ();
+        ec_gf_ssse3_usable = __builtin_cpu_supports ("ssse3");
+#endif
+}
+
+uint8_t
+ec_gf_mul (uint8_t a, uint8_t b)
+{
+        pthread_once (&ec_gf_once, ec_gf_init);
+
+        return ec_gf_mul_table[a][b];
+}
+
+uint8_t
+ec_gf_inv (uint8_t a)
+{
+        pthread_once (&ec_gf_once, ec_gf_init);
+
+        if (!a)
+                return 0;
+
+        return ec_gf_exp[255 - ec_gf_log[a]];
+}
+
+static void
+ec_gf_xor_region (uint8_t *dst, const uint8_t *src, size_t len)
+{
+        uint64_t a = 0;
+        uint64_t b = 0;
+
+        while (len >= 8) {
+                memcpy (&a, dst, 8);
+                memcpy (&b, src, 8);
+                a ^= b;
+                memcpy (dst, &a, 8);
+                dst += 8;
+                src += 8;
+                len -= 8;
+        }
+
+        while (len--)
+                *dst++ ^= *src++;
+}
+
+static void
+ec_gf_muladd_region_sw (uint8_t *dst, const uint8_t *src, uint8_t c,
+                        size_t len)
+{
+        const uint8_t *row = ec_gf_mul_table[c];
+
+        while (len--)
+                *dst++ ^= row[*src++];
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+typedef char          ec_v16qi  __attribute__ ((vector_size (16)));
+typedef unsigned char ec_v16uqi __attribute__ ((vector_size (16)));
+
+/* c * x is c * (x & 0x0f) ^ c * (x & 0xf0): both products are looked up
+   16 bytes at a time from the 16 entry tables of the two nibbles */
+__attribute__ ((target ("ssse3")))
+static void
+ec_gf_muladd_region_ssse3 (uint8_t *dst, const uint8_t *src, uint8_t c,
+                           size_t len)
+{
+        ec_v16qi   lo_table;
+        ec_v16qi   hi_table;
+        ec_v16uqi  mask;
+        ec_v16uqi  x;
+        ec_v16qi   d;
+        ec_v16qi   prod;
+        int        i = 0;
+
+        for (i = 0; i < 16; i++) {
+                lo_table[i] = ec_gf_mul_table[c][i];
+                hi_table[i] = ec_gf_mul_table[c][i << 4];
+                mask[i]     = 0x0f;
+        }
+
+        while (len >= 16) {
+                memcpy (&x, src, 16);
+                memcpy (&d, dst, 16);
+                prod = __builtin_ia32_pshufb128 (lo_table,
+                                                 (ec_v16qi) (x & mask));
+                prod ^= __builtin_ia32_pshufb128 (hi_table,
+                                                  (ec_v16qi) ((x >> 4) & mask));
+                d ^= prod;
+                memcpy (dst, &d, 16);
+                dst += 16;
+                src += 16;
+                len -= 16;
+        }
+
+        ec_gf_muladd_region_sw (dst, src, c, len);
+}
+#endif
+
+void
+ec_gf_muladd_region (uint8_t *dst, const uint8_t *src, uint8_t c, size_t len)
+{
+        pthread_once (&ec_gf_once, ec_gf_init);
+
+        if (!c)
+                return;
+
+        if (c == 1) {
+                ec_gf_xor_region (dst, src, len);
+                return;
+        }
+
+#if defined(__x86_64__) && defined(__GNUC__)
+        if (ec_gf_ssse3_usable) {
+                ec_gf_muladd_region_ssse3 (dst, src, c, len);
+                return;
+        }
+#endif
+        ec_gf_muladd_region_sw (dst, src, c, len);
+}
+
+void
+ec_gf_matrix_build (uint8_t *matrix, int k, int m)
+{
+        int i = 0;
+        int j = 0;
+
+        pthread_once (&ec_gf_once, ec_gf_init);
+
+        memset (matrix, 0, (k + m) * k);
+
+        for (i = 0; i < k; i++)
+                matrix[i * k + i] = 1;
+
+        /* 1 / (x_i + y_j) with x_i = k + i and y_j = j, all distinct */
+        for (i = 0; i < m; i++)
+                for (j = 0; j < k; j++)
+                        matrix[(k + i) * k + j] =
+                                ec_gf_inv ((uint8_t) ((k + i) ^ j));
+}
+
+int
+ec_gf_matrix_invert (uint8_t *matrix, int n)
+{
+        uint8_t  work[EC_GF_MAX_ROWS * EC_GF_MAX_ROWS / 4];
+        uint8_t *inv = work;
+        uint8_t  tmp = 0;
+        uint8_t  f   = 0;
+        int      row = 0;
+        int      col = 0;
+        int      i   = 0;
+
+        if (n * n > sizeof (work))
+                return -1;
+
+        memset (inv, 0, n * n);
+        for (i = 0; i < n; i++)
+                inv[i * n + i] = 1;
+
+        for (col = 0; col < n; col++) {
+                for (row = col; row < n; row++)
+                        if (matrix[row * n + col])
+                                break;
+                if (row == n)
+                        return -1;
+
+                if (row != col) {
+                        for (i = 0; i < n; i++) {
+                                tmp = matrix[row * n + i];
+                                matrix[row * n + i] = matrix[col * n + i];
+                                matrix[col * n + i] = tmp;
+                                tmp = inv[row * n + i];
+                                inv[row * n + i] = inv[col * n + i];
+                                inv[col * n + i] = tmp;
+                        }
+                }
+
+                f = ec_gf_inv (matrix[col * n + col]);
+                for (i = 0; i < n; i++) {
+                        matrix[col * n + i] = ec_gf_mul (f,
+                                                         matrix[col * n + i]);
+                        inv[col * n + i] = ec_gf_mul (f, inv[col * n + i]);
+                }
+
+                for (row = 0; row < n; row++) {
+                        if (row == col || !matrix[row * n + col])
+                                continue;
+                        f = matrix[row * n + col];
+                        for (i = 0; i < n; i++) {
+                                matrix[row * n + i] ^=
+                                        ec_gf_mul (f, matrix[col * n + i]);
+                                inv[row * n + i] ^=
+                                        ec_gf_mul (f, inv[col * n + i]);
+                        }
+                }
+        }
+
+        memcpy (matrix, inv, n * n);
+
+        return 0;
+}
+
+void
+ec_gf_encode (const uint8_t *matrix, int k, int m, uint8_t **data,
+              uint8_t **parity, size_t len)
+{
+        int i = 0;
+        int j = 0;
+
+        for (i = 0; i < m; i++) {
+                memset (parity[i], 0, len);
+                for (j = 0; j < k; j++)
+                        ec_gf_muladd_region (parity[i], data[j],
+                                             matrix[(k + i) * k + j], len);
+        }
+}
+
+int
+ec_gf_decode (const uint8_t *matrix, int k, const int *rows,
+              uint8_t **frags, uint8_t **data, size_t len)
+{
+        uint8_t sub[EC_GF_MAX_ROWS * EC_GF_MAX_ROWS / 4];
+        int     have[EC_GF_MAX_ROWS];
+        int     i = 0;
+        int     j = 0;
+
+        if (k * k > sizeof (sub))
+                return -1;
+
+        for (j = 0; j < k; j++)
+                have[j] = -1;
+
+        for (i = 0; i < k; i++) {
+                memcpy (&sub[i * k], &matrix[rows[i] * k], k);
+                if (rows[i] < k)
+                        have[rows[i]] = i;
+        }
+
+        if (ec_gf_matrix_invert (sub, k) != 0)
+                return -1;
+
+        for (j = 0; j < k; j++) {
+                if (have[j] >= 0) {
+                        if (data[j] != frags[have[j]])
+                                memcpy (data[j], frags[have[j]], len);
+                        continue;
+                }
+
+                memset (data[j], 0, len);
+                for (i = 0; i < k; i++)
+                        ec_gf_muladd_region (data[j], frags[i],
+                                             sub[j * k + i], len);
+        }
+
+        return 0;
+}
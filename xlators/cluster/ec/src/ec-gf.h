@@ -0,0 +1,57 @@
+/*
+  Copyright (c) 2012 Gluster, Inc. <http://www.gluster.com>
+  This file is part of GlusterFS.
+
+  GlusterFS is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published
+  by the Free Software Foundation; either version 3 of the License,
+  or (at your option) any later version.
+
+  GlusterFS is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __EC_GF_H__
+#define __EC_GF_H__
+
+#include <stdint.h>
+#include <sys/types.h>
+
+/* Reed-Solomon coding over GF(2^8).
+
+   The code is systematic: fragments 0 .. k-1 are the data itself and
+   fragment k + i is the sum over j of matrix[k + i][j] * data[j], where
+   the parity rows form a Cauchy matrix. Any k rows of the (k + m) x k
+   matrix are independent, so the data can be rebuilt from any k of the
+   k + m fragments. */
+
+uint8_t ec_gf_mul (uint8_t a, uint8_t b);
+
+uint8_t ec_gf_inv (uint8_t a);
+
+/* dst[i] ^= c * src[i] for 0 <= i < len */
+void ec_gf_muladd_region (uint8_t *dst, const uint8_t *src, uint8_t c,
+                          size_t len);
+
+/* fills the (k + m) x k encoding matrix, k + m <= 256 */
+void ec_gf_matrix_build (uint8_t *matrix, int k, int m);
+
+/* inverts the n x n matrix in place, -1 if it is singular */
+int ec_gf_matrix_invert (uint8_t *matrix, int n);
+
+/* parity[i] for 0 <= i < m from data[j] for 0 <= j < k, each of len bytes */
+void ec_gf_encode (const uint8_t *matrix, int k, int m, uint8_t **data,
+                   uint8_t **parity, size_t len);
+
+/* rebuilds the k data fragments into data[] from the k fragments in
+   frags[], rows[i] being the index of frags[i] in the code */
+int ec_gf_decode (const uint8_t *matrix, int k, const int *rows,
+                  uint8_t **frags, uint8_t **data, size_t len);
+
+#endif /* __EC_GF_H__ */
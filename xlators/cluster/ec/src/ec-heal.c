@@ -0,0 +1,526 @@
+/*
+  Copyright (c) 2012 Gluster, Inc. <http://www.gluster.com>
+  This file is part of GlusterFS.
+
+  GlusterFS is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published
+  by the Free Software Foundation; either version 3 of the License,
+  or (at your option) any later version.
+
+  GlusterFS is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+
+/* Self-heal of ec: a stale or missing fragment found by lookup is rebuilt
+   from the good children. Missing entries are created again with the
+   gfid of the others. The data of a stale regular file is read and
+   encoded again under the same lock and changelog as writes; rchecksum
+   of every chunk of a stale fragment is compared with the one of the
+   rebuilt chunk, and only the chunks that differ are written. The dirty
+   marks of the fragments are cleared once they all hold the same data. */
+
+#include "ec.h"
+#include "checksum.h"
+
+static int ec_heal_data_next (call_frame_t *frame, xlator_t *this);
+
+static int
+ec_heal_done (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t   *priv  = NULL;
+        ec_local_t     *local = NULL;
+        ec_inode_ctx_t *ctx   = NULL;
+
+        priv  = this->private;
+        local = frame->local;
+
+        ctx = ec_inode_ctx_get (this, local->loc.inode);
+        if (ctx) {
+                LOCK (&local->loc.inode->lock);
+                {
+                        ctx->healing = _gf_false;
+                }
+                UNLOCK (&local->loc.inode->lock);
+        }
+
+        if (local->op_ret < 0) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "self-heal of %s failed (%s)", local->loc.path,
+                        strerror (local->op_errno));
+        } else {
+                gf_log (this->name, GF_LOG_INFO,
+                        "self-heal of %s done", local->loc.path);
+
+                LOCK (&priv->lock);
+                {
+                        priv->heals_done++;
+                }
+                UNLOCK (&priv->lock);
+        }
+
+        EC_STACK_DESTROY (frame);
+        return 0;
+}
+
+static int
+ec_heal_truncate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                      int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                      struct iatt *postbuf)
+{
+        ec_local_t *local      = NULL;
+        int         child      = (long) cookie;
+        int         call_count = 0;
+
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                if (op_ret < 0)
+                        local->heal &= ~EC_BIT (child);
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        /* the healed children get the size and version of the good ones,
+           and the dirty marks of all of them are cleared */
+        local->done        = local->heal | local->good;
+        local->new_size    = local->file_size;
+        local->new_version = local->version;
+        local->op_ret      = local->heal ? 0 : -1;
+        local->op_errno    = local->heal ? 0 : EIO;
+
+        return ec_postop (frame, this);
+}
+
+static int
+ec_heal_truncate (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv   = NULL;
+        ec_local_t   *local  = NULL;
+        uint64_t      stripe = 0;
+        off_t         len    = 0;
+
+        priv   = this->private;
+        local  = frame->local;
+        stripe = local->block_size * priv->fragments;
+        len    = (local->file_size + stripe - 1) / stripe * local->block_size;
+
+        local->wind       = local->heal;
+        local->call_count = ec_count (local->heal);
+
+        EC_WIND (frame, local, priv, ec_heal_truncate_cbk, ftruncate,
+                 local->fd, len);
+        return 0;
+}
+
+static int
+ec_heal_write_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                   struct iatt *postbuf)
+{
+        ec_local_t *local      = NULL;
+        int         child      = (long) cookie;
+        int         call_count = 0;
+
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                if (op_ret < 0)
+                        local->heal &= ~EC_BIT (child);
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        if (!local->heal) {
+                local->op_ret   = -1;
+                local->op_errno = op_errno;
+                return ec_unlock (frame, this);
+        }
+
+        local->offset += local->read_count;
+        return ec_heal_data_next (frame, this);
+}
+
+static int
+ec_heal_checksum_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                      int32_t op_ret, int32_t op_errno, uint32_t weak_checksum,
+                      uint8_t *strong_checksum)
+{
+        ec_local_t *local      = NULL;
+        uint8_t     sum[MD5_DIGEST_LEN];
+        int         child      = (long) cookie;
+        int         call_count = 0;
+        int         same       = 0;
+
+        local = frame->local;
+
+        if ((op_ret == 0) && strong_checksum) {
+                gf_rsync_strong_checksum ((char *) local->wfrags[child],
+                                          local->read_count *
+                                          local->block_size, sum);
+                same = !memcmp (sum, strong_checksum, MD5_DIGEST_LEN);
+        }
+
+        LOCK (&frame->lock);
+        {
+                if (!same)
+                        local->done |= EC_BIT (child);
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        if (!local->done) {
+                local->offset += local->read_count;
+                return ec_heal_data_next (frame, this);
+        }
+
+        return ec_fragments_write (frame, this, local->done,
+                                   local->read_stripe * local->block_size,
+                                   local->read_count * local->block_size,
+                                   ec_heal_write_cbk);
+}
+
+static int
+ec_heal_data_read_cbk (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv  = NULL;
+        ec_local_t   *local = NULL;
+        size_t        len   = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        if (local->op_ret < 0)
+                return ec_unlock (frame, this);
+
+        len = local->read_count * local->block_size;
+        if (ec_frags_alloc (priv->child_count, &local->wfrags,
+                            EC_BIT (priv->child_count) - 1, len)) {
+                local->op_ret   = -1;
+                local->op_errno = ENOMEM;
+                return ec_unlock (frame, this);
+        }
+
+        ec_stripe_encode (this, local, local->rbuf, local->read_count,
+                          local->wfrags);
+
+        local->done       = 0;
+        local->wind       = local->heal;
+        local->call_count = ec_count (local->heal);
+
+        EC_WIND (frame, local, priv, ec_heal_checksum_cbk, rchecksum,
+                 local->fd, local->read_stripe * local->block_size, len);
+        return 0;
+}
+
+/* local->offset is the next stripe to heal */
+static int
+ec_heal_data_next (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv   = NULL;
+        ec_local_t   *local  = NULL;
+        uint64_t      stripe = 0;
+        off_t         total  = 0;
+        int           count  = 0;
+
+        priv   = this->private;
+        local  = frame->local;
+        stripe = local->block_size * priv->fragments;
+        total  = (local->file_size + stripe - 1) / stripe;
+
+        if (local->offset >= total)
+                return ec_heal_truncate (frame, this);
+
+        count = max (1, EC_HEAL_FRAGMENT_SIZE / local->block_size);
+        count = min (count, total - local->offset);
+
+        return ec_stripe_read (frame, this, local->offset, count,
+                               ec_heal_data_read_cbk);
+}
+
+/* runs under the lock, once the good children are known */
+static int
+ec_heal_data (call_frame_t *frame, xlator_t *this)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        local->clear_dirty = _gf_true;
+
+        local->heal = local->locked & ~local->good;
+        if (!local->heal) {
+                /* only dirty marks left by updates done since */
+                local->done        = local->good;
+                local->new_size    = local->file_size;
+                local->new_version = local->version;
+                local->op_ret      = 0;
+                local->op_errno    = 0;
+                return ec_postop (frame, this);
+        }
+
+        gf_log (this->name, GF_LOG_DEBUG, "healing data of %s, version "
+                "%"PRIu64", size %"PRIu64, local->loc.path, local->version,
+                local->file_size);
+
+        local->offset = 0;
+        return ec_heal_data_next (frame, this);
+}
+
+static int
+ec_heal_open_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, fd_t *fd)
+{
+        ec_private_t *priv       = NULL;
+        ec_local_t   *local      = NULL;
+        int           child      = (long) cookie;
+        int           call_count = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                if (op_ret < 0)
+                        local->op_errno = op_errno;
+                else
+                        local->success |= EC_BIT (child);
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        if (ec_count (local->success) < priv->fragments) {
+                local->op_ret = -1;
+                return ec_heal_done (frame, this);
+        }
+
+        local->transaction_fn = ec_heal_data;
+        return ec_transaction (frame, this, local->success);
+}
+
+static int
+ec_heal_open (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv  = NULL;
+        ec_local_t   *local = NULL;
+
+        priv  = this->private;
+        local = frame->local;
+
+        if (!IA_ISREG (local->stbuf.ia_type) || !local->heal) {
+                local->op_ret   = 0;
+                local->op_errno = 0;
+                return ec_heal_done (frame, this);
+        }
+
+        local->fd = fd_create (local->loc.inode, frame->root->pid);
+        if (!local->fd) {
+                local->op_ret   = -1;
+                local->op_errno = ENOMEM;
+                return ec_heal_done (frame, this);
+        }
+
+        local->success    = 0;
+        local->wind       = ec_up_children (this);
+        local->call_count = ec_count (local->wind);
+        if (local->call_count < priv->fragments) {
+                local->op_ret   = -1;
+                local->op_errno = ENOTCONN;
+                return ec_heal_done (frame, this);
+        }
+
+        EC_WIND (frame, local, priv, ec_heal_open_cbk, open, &local->loc,
+                 O_RDWR, local->fd, 0);
+        return 0;
+}
+
+static int
+ec_heal_entry_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno, inode_t *inode,
+                   struct iatt *buf, struct iatt *preparent,
+                   struct iatt *postparent)
+{
+        ec_local_t *local      = NULL;
+        int         child      = (long) cookie;
+        int         call_count = 0;
+
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                if (op_ret < 0) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "%s: could not create the entry on child "
+                                "%d (%s)", local->loc.path, child,
+                                strerror (op_errno));
+                        local->heal &= ~EC_BIT (child);
+                }
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        return ec_heal_open (frame, this);
+}
+
+/* missing entries are created with the gfid, owner and mode of the
+   others; the data of a regular file is healed after that */
+static int
+ec_heal_entry (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv       = NULL;
+        ec_local_t   *local      = NULL;
+        uuid_t       *gfid       = NULL;
+        uint64_t      block_size = 0;
+        mode_t        mode       = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        if (!local->missing)
+                return ec_heal_open (frame, this);
+
+        local->xattr_req = dict_new ();
+        gfid = GF_CALLOC (1, sizeof (uuid_t), gf_ec_mt_uint8_t);
+        if (!local->xattr_req || !gfid)
+                goto nomem;
+
+        uuid_copy (*gfid, local->stbuf.ia_gfid);
+        if (dict_set_dynptr (local->xattr_req, "gfid-req", gfid,
+                             sizeof (uuid_t))) {
+                GF_FREE (gfid);
+                goto nomem;
+        }
+
+        if (IA_ISREG (local->stbuf.ia_type)) {
+                ec_inode_ctx_size (this, local->loc.inode, NULL, &block_size,
+                                   NULL);
+                if (!block_size)
+                        block_size = ec_get_matching_bs (local->loc.path,
+                                                         priv->pattern,
+                                                         priv->block_size);
+                if (ec_new_file_xattrs (local->xattr_req, block_size))
+                        goto nomem;
+        }
+
+        mode = st_mode_from_ia (local->stbuf.ia_prot, local->stbuf.ia_type);
+
+        local->wind       = local->missing;
+        local->call_count = ec_count (local->missing);
+
+        if (IA_ISDIR (local->stbuf.ia_type))
+                EC_WIND (frame, local, priv, ec_heal_entry_cbk, mkdir,
+                         &local->loc, mode, local->xattr_req);
+        else
+                EC_WIND (frame, local, priv, ec_heal_entry_cbk, mknod,
+                         &local->loc, mode, 0, local->xattr_req);
+        return 0;
+
+nomem:
+        local->op_ret   = -1;
+        local->op_errno = ENOMEM;
+        return ec_heal_done (frame, this);
+}
+
+void
+ec_heal (xlator_t *this, loc_t *loc, struct iatt *buf, uint64_t bad,
+         uint64_t missing)
+{
+        ec_private_t   *priv  = NULL;
+        ec_local_t     *local = NULL;
+        ec_inode_ctx_t *ctx   = NULL;
+        call_frame_t   *frame = NULL;
+        int             busy  = 0;
+
+        priv = this->private;
+
+        if (!IA_ISREG (buf->ia_type) && !IA_ISDIR (buf->ia_type))
+                return;
+
+        /* entries can only be created again when the parent is known */
+        if (!loc->parent || !loc->name) {
+                bad &= ~missing;
+                missing = 0;
+        }
+
+        if (!bad)
+                return;
+
+        ctx = ec_inode_ctx_get (this, loc->inode);
+        if (!ctx)
+                return;
+
+        LOCK (&loc->inode->lock);
+        {
+                busy = ctx->healing;
+                ctx->healing = _gf_true;
+        }
+        UNLOCK (&loc->inode->lock);
+
+        if (busy)
+                return;
+
+        frame = create_frame (this, this->ctx->pool);
+        if (!frame)
+                goto err;
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local = local;
+        frame->root->uid = buf->ia_uid;
+        frame->root->gid = buf->ia_gid;
+
+        if (loc_copy (&local->loc, loc) != 0)
+                goto err;
+
+        local->stbuf   = *buf;
+        local->heal    = bad;
+        local->missing = missing;
+        local->unwind  = ec_heal_done;
+
+        LOCK (&priv->lock);
+        {
+                priv->heals_started++;
+        }
+        UNLOCK (&priv->lock);
+
+        gf_log (this->name, GF_LOG_DEBUG, "starting self-heal of %s",
+                loc->path);
+
+        ec_heal_entry (frame, this);
+        return;
+
+err:
+        if (frame)
+                EC_STACK_DESTROY (frame);
+
+        LOCK (&loc->inode->lock);
+        {
+                ctx->healing = _gf_false;
+        }
+        UNLOCK (&loc->inode->lock);
+}
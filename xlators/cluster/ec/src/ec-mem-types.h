@@ -0,0 +1,38 @@
+/*
+  Copyright (c) 2012 Gluster, Inc. <http://www.gluster.com>
+  This file is part of GlusterFS.
+
+  GlusterFS is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published
+  by the Free Software Foundation; either version 3 of the License,
+  or (at your option) any later version.
+
+  GlusterFS is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef __EC_MEM_TYPES_H__
+#define __EC_MEM_TYPES_H__
+
+#include "mem-types.h"
+
+enum gf_ec_mem_types_ {
+        gf_ec_mt_ec_private_t = gf_common_mt_end + 1,
+        gf_ec_mt_ec_local_t,
+        gf_ec_mt_ec_inode_ctx_t,
+        gf_ec_mt_ec_options,
+        gf_ec_mt_xlator_t,
+        gf_ec_mt_uint8_t,
+        gf_ec_mt_uint64_t,
+        gf_ec_mt_frags,
+        gf_ec_mt_iovec,
+        gf_ec_mt_end
+};
+#endif
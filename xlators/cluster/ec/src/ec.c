@@ -0,0 +1,4363 @@
+/*
+  Copyright (c) 2012 Gluster, Inc. <http://www.gluster.com>
+  This file is part of GlusterFS.
+
+  GlusterFS is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published
+  by the Free Software Foundation; either version 3 of the License,
+  or (at your option) any later version.
+
+  GlusterFS is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * xlators/cluster/ec:
+ *    Erasure coding translator. Files are cut in stripes of
+ *    fragments * block-size bytes. Every stripe is split in 'fragments'
+ *    blocks of data to which 'redundancy' Reed-Solomon parity blocks are
+ *    added, and block i of every stripe goes to child i, at offset
+ *    stripe * block-size. Data stays readable while at most 'redundancy'
+ *    children are down or stale: reads are served by any 'fragments'
+ *    children, the data being rebuilt on the fly when parity is used.
+ *
+ *    The size of the file and a version bumped by every update are kept
+ *    in xattrs of every fragment. Updates run under an inodelk of all
+ *    the children, and only touch the children holding the latest
+ *    version found on enough of them; the fragments stay marked dirty
+ *    while an update is going on. Stale, dirty and missing fragments
+ *    found by lookup are healed in the background from the others.
+ */
+#include <fnmatch.h>
+
+#include "ec.h"
+#include "byte-order.h"
+#include "statedump.h"
+
+struct volume_options options[];
+
+static int ec_lock_next (call_frame_t *frame, xlator_t *this);
+
+void
+ec_local_wipe (ec_local_t *local)
+{
+        if (!local)
+                goto out;
+
+        loc_wipe (&local->loc);
+        loc_wipe (&local->loc2);
+
+        if (local->fd)
+                fd_unref (local->fd);
+
+        if (local->inode)
+                inode_unref (local->inode);
+
+        if (local->xattr)
+                dict_unref (local->xattr);
+
+        if (local->xattr_req)
+                dict_unref (local->xattr_req);
+
+        if (local->iobref)
+                iobref_unref (local->iobref);
+
+        if (local->wiobref)
+                iobref_unref (local->wiobref);
+
+        ec_frags_free (local->child_count, &local->frags);
+        ec_frags_free (local->child_count, &local->wfrags);
+
+        GF_FREE (local->vector);
+        GF_FREE (local->wvec);
+        GF_FREE (local->rbuf);
+        GF_FREE (local->wbuf);
+        GF_FREE (local->iatts);
+        GF_FREE (local->versions);
+        GF_FREE (local->sizes);
+        GF_FREE (local->block_sizes);
+        GF_FREE (local->dirties);
+        GF_FREE (local->errnos);
+
+out:
+        return;
+}
+
+ec_local_t *
+ec_local_init (xlator_t *this)
+{
+        ec_private_t *priv  = NULL;
+        ec_local_t   *local = NULL;
+        int           n     = 0;
+
+        priv = this->private;
+        n = priv->child_count;
+
+        local = GF_CALLOC (1, sizeof (ec_local_t), gf_ec_mt_ec_local_t);
+        if (!local)
+                goto out;
+
+        local->op_ret      = -1;
+        local->op_errno    = ENOTCONN;
+        local->child_count = n;
+        local->lock_child  = -1;
+
+        local->iatts       = GF_CALLOC (n, sizeof (struct iatt),
+                                        gf_ec_mt_uint8_t);
+        local->versions    = GF_CALLOC (n, sizeof (uint64_t),
+                                        gf_ec_mt_uint64_t);
+        local->sizes       = GF_CALLOC (n, sizeof (uint64_t),
+                                        gf_ec_mt_uint64_t);
+        local->block_sizes = GF_CALLOC (n, sizeof (uint64_t),
+                                        gf_ec_mt_uint64_t);
+        local->dirties     = GF_CALLOC (n, sizeof (uint64_t),
+                                        gf_ec_mt_uint64_t);
+        local->errnos      = GF_CALLOC (n, sizeof (int32_t),
+                                        gf_ec_mt_uint8_t);
+        local->wvec        = GF_CALLOC (n, sizeof (struct iovec),
+                                        gf_ec_mt_iovec);
+
+        if (!local->iatts || !local->versions || !local->sizes ||
+            !local->block_sizes || !local->dirties || !local->errnos ||
+            !local->wvec) {
+                ec_local_wipe (local);
+                GF_FREE (local);
+                local = NULL;
+        }
+
+out:
+        return local;
+}
+
+int
+ec_count (uint64_t mask)
+{
+        return __builtin_popcountll (mask);
+}
+
+static int
+ec_first (uint64_t mask)
+{
+        if (!mask)
+                return -1;
+
+        return __builtin_ctzll (mask);
+}
+
+uint64_t
+ec_up_children (xlator_t *this)
+{
+        ec_private_t *priv = NULL;
+        uint64_t      up   = 0;
+
+        priv = this->private;
+
+        LOCK (&priv->lock);
+        {
+                up = priv->up;
+        }
+        UNLOCK (&priv->lock);
+
+        return up;
+}
+
+int
+ec_frags_alloc (int child_count, uint8_t ***frags_p, uint64_t mask,
+                size_t len)
+{
+        uint8_t **frags = NULL;
+        int       i     = 0;
+
+        ec_frags_free (child_count, frags_p);
+
+        frags = GF_CALLOC (child_count, sizeof (uint8_t *), gf_ec_mt_frags);
+        if (!frags)
+                return -1;
+
+        *frags_p = frags;
+
+        for (i = 0; i < child_count; i++) {
+                if (!(mask & EC_BIT (i)))
+                        continue;
+                frags[i] = GF_CALLOC (1, len, gf_ec_mt_uint8_t);
+                if (!frags[i])
+                        return -1;
+        }
+
+        return 0;
+}
+
+void
+ec_frags_free (int child_count, uint8_t ***frags_p)
+{
+        uint8_t **frags = *frags_p;
+        int       i     = 0;
+
+        if (!frags)
+                return;
+
+        for (i = 0; i < child_count; i++)
+                GF_FREE (frags[i]);
+
+        GF_FREE (frags);
+        *frags_p = NULL;
+}
+
+/**
+ * ec_get_matching_bs - Get the matching block size for the given path.
+ */
+uint64_t
+ec_get_matching_bs (const char *path, struct ec_options *opts,
+                    uint64_t default_bs)
+{
+        struct ec_options *trav       = NULL;
+        uint64_t           block_size = 0;
+
+        block_size = default_bs;
+
+        if (!path || !opts)
+                goto out;
+
+        trav = opts;
+        while (trav) {
+                if (!fnmatch (trav->path_pattern, path, FNM_NOESCAPE)) {
+                        block_size = trav->block_size;
+                        break;
+                }
+                trav = trav->next;
+        }
+
+out:
+        return block_size;
+}
+
+ec_inode_ctx_t *
+ec_inode_ctx_get (xlator_t *this, inode_t *inode)
+{
+        ec_inode_ctx_t *ctx   = NULL;
+        uint64_t        value = 0;
+        int             ret   = 0;
+
+        if (!inode)
+                return NULL;
+
+        LOCK (&inode->lock);
+        {
+                ret = __inode_ctx_get (inode, this, &value);
+                if (ret == 0) {
+                        ctx = (ec_inode_ctx_t *) (long) value;
+                        goto unlock;
+                }
+
+                ctx = GF_CALLOC (1, sizeof (ec_inode_ctx_t),
+                                 gf_ec_mt_ec_inode_ctx_t);
+                if (!ctx)
+                        goto unlock;
+
+                ret = __inode_ctx_put (inode, this, (uint64_t) (long) ctx);
+                if (ret) {
+                        GF_FREE (ctx);
+                        ctx = NULL;
+                }
+        }
+unlock:
+        UNLOCK (&inode->lock);
+
+        return ctx;
+}
+
+static void
+ec_inode_ctx_set_size (xlator_t *this, inode_t *inode, uint64_t size,
+                       uint64_t block_size, uint64_t bad)
+{
+        ec_inode_ctx_t *ctx = NULL;
+
+        ctx = ec_inode_ctx_get (this, inode);
+        if (!ctx)
+                return;
+
+        LOCK (&inode->lock);
+        {
+                ctx->size       = size;
+                ctx->block_size = block_size;
+                ctx->bad        = bad;
+                ctx->size_known = _gf_true;
+        }
+        UNLOCK (&inode->lock);
+}
+
+int
+ec_inode_ctx_size (xlator_t *this, inode_t *inode, uint64_t *size,
+                   uint64_t *block_size, uint64_t *bad)
+{
+        ec_inode_ctx_t *ctx   = NULL;
+        int             known = 0;
+
+        ctx = ec_inode_ctx_get (this, inode);
+        if (!ctx)
+                return 0;
+
+        LOCK (&inode->lock);
+        {
+                known = ctx->size_known;
+                if (size)
+                        *size = ctx->size;
+                if (block_size)
+                        *block_size = ctx->block_size;
+                if (bad)
+                        *bad = ctx->bad;
+        }
+        UNLOCK (&inode->lock);
+
+        return known;
+}
+
+/* the size of a regular file as seen above ec, and the space taken by all
+   of its fragments */
+void
+ec_iatt_fix (xlator_t *this, struct iatt *buf, uint64_t size)
+{
+        ec_private_t *priv = NULL;
+
+        priv = this->private;
+
+        if (!buf || !IA_ISREG (buf->ia_type))
+                return;
+
+        buf->ia_size    = size;
+        buf->ia_blocks *= priv->child_count;
+}
+
+static void
+ec_iatt_fix_inode (xlator_t *this, inode_t *inode, struct iatt *buf)
+{
+        ec_private_t *priv = NULL;
+        uint64_t      size = 0;
+
+        priv = this->private;
+
+        if (!buf || !IA_ISREG (buf->ia_type))
+                return;
+
+        if (inode && ec_inode_ctx_size (this, inode, &size, NULL, NULL))
+                ec_iatt_fix (this, buf, size);
+        else
+                buf->ia_blocks *= priv->child_count;
+}
+
+static int
+ec_dict_get_u64 (dict_t *xattr, char *key, uint64_t *value)
+{
+        void *ptr = NULL;
+        int   len = 0;
+        int   ret = -1;
+
+        *value = 0;
+
+        if (!xattr)
+                goto out;
+
+        ret = dict_get_ptr_and_len (xattr, key, &ptr, &len);
+        if (ret || len != sizeof (uint64_t))
+                goto out;
+
+        *value = ntoh64 (*(uint64_t *) ptr);
+        ret = 0;
+out:
+        return ret;
+}
+
+static int
+ec_dict_set_u64 (dict_t *xattr, char *key, uint64_t value)
+{
+        uint64_t *buf = NULL;
+        int       ret = -1;
+
+        buf = GF_CALLOC (1, sizeof (uint64_t), gf_ec_mt_uint64_t);
+        if (!buf)
+                goto out;
+
+        *buf = hton64 (value);
+        ret = dict_set_bin (xattr, key, buf, sizeof (uint64_t));
+        if (ret)
+                GF_FREE (buf);
+out:
+        return ret;
+}
+
+/* xattrs of a new regular file, passed with the create params */
+int
+ec_new_file_xattrs (dict_t *params, uint64_t block_size)
+{
+        int ret = 0;
+
+        ret = ec_dict_set_u64 (params, EC_XATTR_SIZE, 0);
+        if (!ret)
+                ret = ec_dict_set_u64 (params, EC_XATTR_VERSION, 0);
+        if (!ret)
+                ret = ec_dict_set_u64 (params, EC_XATTR_BLOCK_SIZE,
+                                       block_size);
+        return ret;
+}
+
+/* records one reply of a fop wound to many children, under frame->lock;
+   tells whether it is the first success */
+static int
+__ec_fop_reply (ec_local_t *local, int child, int32_t op_ret,
+                int32_t op_errno)
+{
+        int first = 0;
+
+        if (op_ret < 0) {
+                local->errnos[child] = op_errno;
+                local->op_errno = op_errno;
+                return 0;
+        }
+
+        first = !local->success;
+        local->success |= EC_BIT (child);
+
+        return first;
+}
+
+/* a fop wound to many children succeeds when enough of them still hold
+   the entry for the data to be readable */
+static void
+ec_fop_result (xlator_t *this, ec_local_t *local)
+{
+        ec_private_t *priv = NULL;
+
+        priv = this->private;
+
+        if (ec_count (local->success) >= priv->fragments) {
+                local->op_ret   = 0;
+                local->op_errno = 0;
+        } else {
+                local->op_ret = -1;
+                if (!local->op_errno)
+                        local->op_errno = EIO;
+        }
+}
+
+static int
+ec_wind_init (xlator_t *this, ec_local_t *local, int32_t *op_errno)
+{
+        ec_private_t *priv = NULL;
+
+        priv = this->private;
+
+        local->wind = ec_up_children (this);
+        local->call_count = ec_count (local->wind);
+
+        if (local->call_count < priv->fragments) {
+                *op_errno = ENOTCONN;
+                return -1;
+        }
+
+        return 0;
+}
+
+
+/* Locking, changelog and reads of whole stripes, shared by the fops
+   updating data and by self-heal. */
+
+static int
+ec_transaction_lock (call_frame_t *frame, xlator_t *this, uint64_t children,
+                     short type)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        frame->root->lk_owner = (uint64_t) (unsigned long) frame->root;
+
+        local->wind       = children;
+        local->locked     = 0;
+        local->lock_child = -1;
+
+        local->flock.l_type   = type;
+        local->flock.l_whence = SEEK_SET;
+        local->flock.l_start  = 0;
+        local->flock.l_len    = 0;
+
+        return ec_lock_next (frame, this);
+}
+
+/* the fragments stay dirty from the pre-op to the post-op of the
+   update */
+int
+ec_transaction (call_frame_t *frame, xlator_t *this, uint64_t children)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+        local->update = _gf_true;
+
+        return ec_transaction_lock (frame, this, children, F_WRLCK);
+}
+
+static int
+ec_lock_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+             int32_t op_ret, int32_t op_errno)
+{
+        ec_local_t *local = NULL;
+        int         child = (long) cookie;
+
+        local = frame->local;
+
+        if (op_ret == 0)
+                local->locked |= EC_BIT (child);
+        else
+                local->op_errno = op_errno;
+
+        ec_lock_next (frame, this);
+
+        return 0;
+}
+
+/* locks are taken one child after the other, in the order of the
+   children, so that two clients never wait on each other */
+static int
+ec_lock_next (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv  = NULL;
+        ec_local_t   *local = NULL;
+        int           i     = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        for (i = local->lock_child + 1; i < priv->child_count; i++)
+                if (local->wind & EC_BIT (i))
+                        break;
+
+        if (i < priv->child_count) {
+                local->lock_child = i;
+                STACK_WIND_COOKIE (frame, ec_lock_cbk, (void *) (long) i,
+                                   priv->children[i],
+                                   priv->children[i]->fops->finodelk,
+                                   this->name, local->fd, F_SETLKW,
+                                   &local->flock);
+                return 0;
+        }
+
+        if (ec_count (local->locked) < priv->fragments) {
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "could lock only %d children",
+                        ec_count (local->locked));
+                local->op_ret = -1;
+                if (!local->op_errno)
+                        local->op_errno = ENOTCONN;
+                return ec_unlock (frame, this);
+        }
+
+        return ec_preop (frame, this);
+}
+
+static int
+ec_unlock_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno)
+{
+        ec_local_t *local      = NULL;
+        int         call_count = 0;
+
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (!call_count)
+                local->unwind (frame, this);
+
+        return 0;
+}
+
+int
+ec_unlock (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv  = NULL;
+        ec_local_t   *local = NULL;
+
+        priv  = this->private;
+        local = frame->local;
+
+        if (local->nolock || !local->locked)
+                return local->unwind (frame, this);
+
+        local->flock.l_type = F_UNLCK;
+        local->wind         = local->locked;
+        local->call_count   = ec_count (local->locked);
+        local->locked       = 0;
+
+        EC_WIND (frame, local, priv, ec_unlock_cbk, finodelk,
+                 this->name, local->fd, F_SETLK, &local->flock);
+
+        return 0;
+}
+
+/* The good children hold the latest version found on enough of them to
+   be decoded. A failed update leaves a newer one on fewer children, it
+   is skipped; the update after it goes above it. Returns the number of
+   good children. */
+static int
+ec_version_good (xlator_t *this, ec_local_t *local)
+{
+        ec_private_t *priv = NULL;
+        uint64_t      good = 0;
+        int           i    = 0;
+        int           j    = 0;
+
+        priv = this->private;
+
+        local->version     = 0;
+        local->max_version = 0;
+        local->good        = 0;
+
+        for (i = 0; i < priv->child_count; i++) {
+                if (!(local->success & EC_BIT (i)))
+                        continue;
+
+                if (local->versions[i] > local->max_version)
+                        local->max_version = local->versions[i];
+
+                good = 0;
+                for (j = 0; j < priv->child_count; j++)
+                        if ((local->success & EC_BIT (j)) &&
+                            local->versions[j] == local->versions[i])
+                                good |= EC_BIT (j);
+
+                if (ec_count (good) >= priv->fragments &&
+                    (!local->good || local->versions[i] > local->version)) {
+                        local->version = local->versions[i];
+                        local->good    = good;
+                }
+        }
+
+        return ec_count (local->good);
+}
+
+/* Under the lock of an update, a fragment still dirty from another one
+   was left by a client which died between its writes and its post-op:
+   it may hold data newer than its version. The good children are the
+   clean ones when there are enough of them. Otherwise the data is taken
+   from the first of the dirty ones, and the others are rebuilt. */
+static void
+ec_preop_dirty (xlator_t *this, ec_local_t *local)
+{
+        ec_private_t *priv  = NULL;
+        uint64_t      dirty = 0;
+        uint64_t      good  = 0;
+        int           i     = 0;
+
+        priv = this->private;
+
+        /* the pre-op added its own to every one */
+        for (i = 0; i < priv->child_count; i++)
+                if ((local->good & EC_BIT (i)) && (local->dirties[i] > 1))
+                        dirty |= EC_BIT (i);
+
+        if (!dirty)
+                return;
+
+        good = local->good & ~dirty;
+        for (i = 0; i < priv->child_count; i++) {
+                if (ec_count (good) >= priv->fragments)
+                        break;
+                if (dirty & EC_BIT (i))
+                        good |= EC_BIT (i);
+        }
+
+        gf_log (this->name, GF_LOG_WARNING,
+                "gfid %s: %d fragments left dirty, %d of them not trusted",
+                uuid_utoa (local->fd->inode->gfid), ec_count (dirty),
+                ec_count (local->good & ~good));
+
+        local->good = good;
+}
+
+static int
+ec_preop_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, dict_t *xattr)
+{
+        ec_private_t   *priv       = NULL;
+        ec_local_t     *local      = NULL;
+        int             child      = (long) cookie;
+        int             call_count = 0;
+        int             first      = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                __ec_fop_reply (local, child, op_ret, op_errno);
+                if (op_ret == 0) {
+                        ec_dict_get_u64 (xattr, EC_XATTR_SIZE,
+                                         &local->sizes[child]);
+                        ec_dict_get_u64 (xattr, EC_XATTR_VERSION,
+                                         &local->versions[child]);
+                        ec_dict_get_u64 (xattr, EC_XATTR_BLOCK_SIZE,
+                                         &local->block_sizes[child]);
+                        ec_dict_get_u64 (xattr, EC_XATTR_DIRTY,
+                                         &local->dirties[child]);
+                }
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        if (ec_count (local->success) < priv->fragments) {
+                local->op_ret = -1;
+                goto unlock;
+        }
+
+        if (ec_version_good (this, local) < priv->fragments) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "no version of gfid %s is held by %d children",
+                        uuid_utoa (local->fd->inode->gfid), priv->fragments);
+                local->op_ret   = -1;
+                local->op_errno = EIO;
+                goto unlock;
+        }
+
+        if (local->update)
+                ec_preop_dirty (this, local);
+
+        first = ec_first (local->good);
+        local->file_size  = local->sizes[first];
+        local->block_size = local->block_sizes[first];
+        if (!local->block_size)
+                local->block_size = priv->block_size;
+
+        ec_inode_ctx_set_size (this, local->fd->inode, local->file_size,
+                               local->block_size, local->wind & ~local->good);
+
+        local->op_ret   = 0;
+        local->op_errno = 0;
+
+        return local->transaction_fn (frame, this);
+
+unlock:
+        return ec_unlock (frame, this);
+}
+
+/* reads the size, version, block-size and dirty xattrs of the fragments
+   held by local->locked, or by local->wind when no lock is needed. An
+   update marks them dirty too */
+int
+ec_preop (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv  = NULL;
+        ec_local_t   *local = NULL;
+        dict_t       *xattr = NULL;
+        int           i     = 0;
+        int           count = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        if (!local->nolock)
+                local->wind = local->locked;
+
+        local->success    = 0;
+        local->call_count = ec_count (local->wind);
+        count             = local->call_count;
+
+        for (i = 0; i < priv->child_count; i++) {
+                if (!(local->wind & EC_BIT (i)))
+                        continue;
+
+                /* one dict per child, the replies come back in them */
+                xattr = dict_new ();
+                if (!xattr ||
+                    ec_dict_set_u64 (xattr, EC_XATTR_SIZE, 0) ||
+                    ec_dict_set_u64 (xattr, EC_XATTR_VERSION, 0) ||
+                    ec_dict_set_u64 (xattr, EC_XATTR_BLOCK_SIZE, 0) ||
+                    ec_dict_set_u64 (xattr, EC_XATTR_DIRTY,
+                                     local->update ? 1 : 0)) {
+                        if (xattr)
+                                dict_unref (xattr);
+                        ec_preop_cbk (frame, (void *) (long) i, this, -1,
+                                      ENOMEM, NULL);
+                } else {
+                        STACK_WIND_COOKIE (frame, ec_preop_cbk,
+                                           (void *) (long) i,
+                                           priv->children[i],
+                                           priv->children[i]->fops->fxattrop,
+                                           local->fd, GF_XATTROP_ADD_ARRAY64,
+                                           xattr);
+                        dict_unref (xattr);
+                }
+
+                if (!--count)
+                        break;
+        }
+
+        return 0;
+}
+
+static int
+ec_postop_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, dict_t *xattr)
+{
+        ec_local_t *local      = NULL;
+        int         child      = (long) cookie;
+        int         call_count = 0;
+        uint64_t    current    = 0;
+        ec_inode_ctx_t *ctx    = NULL;
+
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                if (op_ret < 0) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "post-op on child %d failed (%s)", child,
+                                strerror (op_errno));
+                        local->done &= ~EC_BIT (child);
+                }
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        /* the children now holding the new version; a failed update
+           leaves it on too few of them, the ones it did not reach stay
+           current */
+        current = local->done;
+        if (local->new_version == local->version)
+                current |= local->good;
+        else if (local->op_ret < 0)
+                current = local->good & ~local->wind;
+
+        ctx = ec_inode_ctx_get (this, local->fd->inode);
+        if (ctx) {
+                LOCK (&local->fd->inode->lock);
+                {
+                        ctx->size       = local->new_size;
+                        ctx->block_size = local->block_size;
+                        ctx->size_known = _gf_true;
+                        ctx->bad = (ctx->bad | local->locked) & ~current;
+                }
+                UNLOCK (&local->fd->inode->lock);
+        }
+
+        return ec_unlock (frame, this);
+}
+
+/* brings the size, version and block-size xattrs of the children of
+   local->done to local->new_size, local->new_version and
+   local->block_size, and takes back the dirty mark of the update */
+int
+ec_postop (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv  = NULL;
+        ec_local_t   *local = NULL;
+        dict_t       *xattr = NULL;
+        int           i     = 0;
+        int           count = 0;
+        int           ret   = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        if (!local->done)
+                return ec_unlock (frame, this);
+
+        local->wind       = local->done;
+        local->call_count = ec_count (local->done);
+        count             = local->call_count;
+
+        for (i = 0; i < priv->child_count; i++) {
+                if (!(local->done & EC_BIT (i)))
+                        continue;
+
+                ret = -1;
+                xattr = dict_new ();
+                if (xattr)
+                        ret = ec_dict_set_u64 (xattr, EC_XATTR_SIZE,
+                                               local->new_size -
+                                               local->sizes[i]);
+                if (!ret)
+                        ret = ec_dict_set_u64 (xattr, EC_XATTR_VERSION,
+                                               local->new_version -
+                                               local->versions[i]);
+                if (!ret)
+                        ret = ec_dict_set_u64 (xattr, EC_XATTR_BLOCK_SIZE,
+                                               local->block_size -
+                                               local->block_sizes[i]);
+                if (!ret && local->update)
+                        ret = ec_dict_set_u64 (xattr, EC_XATTR_DIRTY,
+                                               local->clear_dirty ?
+                                               -local->dirties[i] :
+                                               (uint64_t) -1);
+                if (ret) {
+                        if (xattr)
+                                dict_unref (xattr);
+                        ec_postop_cbk (frame, (void *) (long) i, this, -1,
+                                       ENOMEM, NULL);
+                } else {
+                        STACK_WIND_COOKIE (frame, ec_postop_cbk,
+                                           (void *) (long) i,
+                                           priv->children[i],
+                                           priv->children[i]->fops->fxattrop,
+                                           local->fd, GF_XATTROP_ADD_ARRAY64,
+                                           xattr);
+                        dict_unref (xattr);
+                }
+
+                if (!--count)
+                        break;
+        }
+
+        return 0;
+}
+
+/* splits count stripes of buf in the data fragments and computes the
+   parity ones; every frags[i] holds count * block_size bytes */
+int
+ec_stripe_encode (xlator_t *this, ec_local_t *local, uint8_t *buf,
+                  int count, uint8_t **frags)
+{
+        ec_private_t *priv   = NULL;
+        uint64_t      bs     = 0;
+        uint64_t      stripe = 0;
+        int           s      = 0;
+        int           j      = 0;
+
+        priv   = this->private;
+        bs     = local->block_size;
+        stripe = bs * priv->fragments;
+
+        for (s = 0; s < count; s++)
+                for (j = 0; j < priv->fragments; j++)
+                        memcpy (frags[j] + s * bs, buf + s * stripe + j * bs,
+                                bs);
+
+        ec_gf_encode (priv->matrix, priv->fragments, priv->redundancy,
+                      frags, frags + priv->fragments, count * bs);
+
+        return 0;
+}
+
+static int ec_stripe_read_wind (call_frame_t *frame, xlator_t *this);
+
+static int
+ec_stripe_read_decode (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        uint8_t      *in[EC_MAX_CHILDREN];
+        int           rows[EC_MAX_CHILDREN];
+        uint64_t      bs       = 0;
+        uint64_t      stripe   = 0;
+        uint64_t      start    = 0;
+        uint64_t      len      = 0;
+        int           degraded = 0;
+        int           n        = 0;
+        int           i        = 0;
+        int           s        = 0;
+
+        priv   = this->private;
+        local  = frame->local;
+        bs     = local->block_size;
+        stripe = bs * priv->fragments;
+        len    = local->read_count * bs;
+
+        for (i = 0; i < priv->child_count; i++) {
+                if (!(local->reading & EC_BIT (i)))
+                        continue;
+                rows[n] = i;
+                in[n++] = local->frags[i];
+                if (i >= priv->fragments)
+                        degraded = 1;
+        }
+
+        if (degraded) {
+                /* missing data fragments are rebuilt in buffers of their
+                   own, the ones read are left in place */
+                for (i = 0; i < priv->fragments; i++) {
+                        if (local->frags[i])
+                                continue;
+                        local->frags[i] = GF_CALLOC (1, len,
+                                                     gf_ec_mt_uint8_t);
+                        if (!local->frags[i])
+                                goto nomem;
+                }
+
+                if (ec_gf_decode (priv->matrix, priv->fragments, rows, in,
+                                  local->frags, len) != 0) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "could not decode the fragments of %s",
+                                uuid_utoa (local->fd->inode->gfid));
+                        local->op_ret   = -1;
+                        local->op_errno = EIO;
+                        goto out;
+                }
+
+                LOCK (&priv->lock);
+                {
+                        priv->degraded_reads++;
+                }
+                UNLOCK (&priv->lock);
+        }
+
+        for (s = 0; s < local->read_count; s++)
+                for (i = 0; i < priv->fragments; i++)
+                        memcpy (local->rbuf + s * stripe + i * bs,
+                                local->frags[i] + s * bs, bs);
+
+        /* whatever lies past the end of file reads as zeros */
+        start = local->read_stripe * stripe;
+        if (start + local->read_count * stripe > local->file_size) {
+                if (local->file_size > start)
+                        memset (local->rbuf + (local->file_size - start), 0,
+                                start + local->read_count * stripe -
+                                local->file_size);
+                else
+                        memset (local->rbuf, 0, local->read_count * stripe);
+        }
+
+        local->op_ret   = 0;
+        local->op_errno = 0;
+        goto out;
+
+nomem:
+        local->op_ret   = -1;
+        local->op_errno = ENOMEM;
+out:
+        ec_frags_free (priv->child_count, &local->frags);
+        return local->read_done (frame, this);
+}
+
+static int
+ec_stripe_read_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, struct iovec *vector,
+                    int32_t count, struct iatt *stbuf, struct iobref *iobref)
+{
+        ec_local_t *local      = NULL;
+        int         child      = (long) cookie;
+        int         call_count = 0;
+        size_t      len        = 0;
+        size_t      copied     = 0;
+        size_t      n          = 0;
+        int         i          = 0;
+
+        local = frame->local;
+        len   = local->read_count * local->block_size;
+
+        LOCK (&frame->lock);
+        {
+                if (op_ret < 0) {
+                        local->read_failed |= EC_BIT (child);
+                        local->op_errno = op_errno;
+                        goto unlock;
+                }
+
+                /* a short fragment is one with a hole at its end */
+                for (i = 0; i < count && copied < len; i++) {
+                        n = min (vector[i].iov_len, len - copied);
+                        memcpy (local->frags[child] + copied,
+                                vector[i].iov_base, n);
+                        copied += n;
+                }
+
+                if (stbuf)
+                        local->stbuf = *stbuf;
+        }
+unlock:
+        call_count = --local->call_count;
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        if (local->reading & local->read_failed)
+                return ec_stripe_read_wind (frame, this);
+
+        return ec_stripe_read_decode (frame, this);
+}
+
+static int
+ec_stripe_read_wind (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv  = NULL;
+        ec_local_t   *local = NULL;
+        uint64_t      avail = 0;
+        size_t        len   = 0;
+        int           i     = 0;
+        int           count = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        avail = local->good & ~local->read_failed & ec_up_children (this);
+        if (ec_count (avail) < priv->fragments) {
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "only %d children can be read, %d needed",
+                        ec_count (avail), priv->fragments);
+                local->op_ret = -1;
+                if (!local->op_errno)
+                        local->op_errno = EIO;
+                return local->read_done (frame, this);
+        }
+
+        /* the lowest children first: data fragments need no decoding */
+        local->reading = 0;
+        for (i = 0; i < priv->child_count && count < priv->fragments; i++) {
+                if (!(avail & EC_BIT (i)))
+                        continue;
+                local->reading |= EC_BIT (i);
+                count++;
+        }
+
+        /* a decode racing a write could mix fragments of both */
+        if (local->nolock && local->read_degraded &&
+            (local->reading != EC_BIT (priv->fragments) - 1))
+                return local->read_degraded (frame, this);
+
+        len = local->read_count * local->block_size;
+        if (ec_frags_alloc (priv->child_count, &local->frags, local->reading,
+                            len)) {
+                local->op_ret   = -1;
+                local->op_errno = ENOMEM;
+                return local->read_done (frame, this);
+        }
+
+        local->wind       = local->reading;
+        local->call_count = count;
+
+        EC_WIND (frame, local, priv, ec_stripe_read_cbk, readv, local->fd,
+                 len, local->read_stripe * local->block_size);
+
+        return 0;
+}
+
+/* reads count stripes from stripe on, from the good children, into
+   local->rbuf and calls done */
+int
+ec_stripe_read (call_frame_t *frame, xlator_t *this, off_t stripe,
+                int count, ec_local_fn_t done)
+{
+        ec_private_t *priv  = NULL;
+        ec_local_t   *local = NULL;
+
+        priv  = this->private;
+        local = frame->local;
+
+        local->read_stripe = stripe;
+        local->read_count  = count;
+        local->read_done   = done;
+        local->read_failed = 0;
+        local->op_errno    = 0;
+
+        GF_FREE (local->rbuf);
+        local->rbuf = GF_CALLOC (count, local->block_size * priv->fragments,
+                                 gf_ec_mt_uint8_t);
+        if (!local->rbuf) {
+                local->op_ret   = -1;
+                local->op_errno = ENOMEM;
+                return done (frame, this);
+        }
+
+        return ec_stripe_read_wind (frame, this);
+}
+
+/* writes local->wfrags, of len bytes each, at offset in the fragments of
+   the children of mask */
+int
+ec_fragments_write (call_frame_t *frame, xlator_t *this, uint64_t mask,
+                    off_t offset, size_t len, fop_writev_cbk_t cbk)
+{
+        ec_private_t *priv  = NULL;
+        ec_local_t   *local = NULL;
+        int           i     = 0;
+        int           count = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        if (!local->wiobref) {
+                local->wiobref = iobref_new ();
+                if (!local->wiobref) {
+                        local->op_ret   = -1;
+                        local->op_errno = ENOMEM;
+                        return ec_unlock (frame, this);
+                }
+        }
+
+        local->done       = 0;
+        local->wind       = mask;
+        local->call_count = ec_count (mask);
+        count             = local->call_count;
+
+        for (i = 0; i < priv->child_count; i++) {
+                if (!(mask & EC_BIT (i)))
+                        continue;
+
+                local->wvec[i].iov_base = local->wfrags[i];
+                local->wvec[i].iov_len  = len;
+
+                STACK_WIND_COOKIE (frame, cbk, (void *) (long) i,
+                                   priv->children[i],
+                                   priv->children[i]->fops->writev,
+                                   local->fd, &local->wvec[i], 1, offset,
+                                   local->wiobref);
+                if (!--count)
+                        break;
+        }
+
+        return 0;
+}
+
+
+/* lookup and stat */
+
+static int
+ec_lookup_unwind (call_frame_t *frame, xlator_t *this)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        EC_STACK_UNWIND (lookup, frame, local->op_ret, local->op_errno,
+                         local->loc.inode, &local->stbuf, local->xattr,
+                         &local->postparent);
+        return 0;
+}
+
+static int
+ec_stat_unwind (call_frame_t *frame, xlator_t *this)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        EC_STACK_UNWIND (stat, frame, local->op_ret, local->op_errno,
+                         &local->stbuf);
+        return 0;
+}
+
+static void
+ec_lookup_done (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv    = NULL;
+        ec_local_t   *local   = NULL;
+        uint64_t      missing = 0;
+        uint64_t      dirty   = 0;
+        uint64_t      bad     = 0;
+        uint64_t      bs      = 0;
+        int           first   = 0;
+        int           i       = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        for (i = 0; i < priv->child_count; i++)
+                if ((local->wind & EC_BIT (i)) &&
+                    local->errnos[i] == ENOENT)
+                        missing |= EC_BIT (i);
+
+        if (ec_count (local->success) < priv->fragments) {
+                local->op_ret = -1;
+                local->op_errno = missing ? ENOENT : local->op_errno;
+                if (!local->op_errno)
+                        local->op_errno = EIO;
+                goto out;
+        }
+
+        first = ec_first (local->success);
+        local->good = local->success;
+
+        if (IA_ISREG (local->iatts[first].ia_type)) {
+                if (ec_version_good (this, local) < priv->fragments) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "%s: no version is held by %d children",
+                                local->loc.path, priv->fragments);
+                        local->op_ret   = -1;
+                        local->op_errno = EIO;
+                        goto out;
+                }
+
+                first = ec_first (local->good);
+                bs = local->block_sizes[first];
+                if (!bs)
+                        bs = priv->block_size;
+
+                ec_inode_ctx_set_size (this, local->loc.inode,
+                                       local->sizes[first], bs,
+                                       local->wind & ~local->good);
+
+                /* a dirty fragment may hold data newer than its version,
+                   left by a client gone before its post-op: heal checks
+                   it under the lock, where a write still going on ends */
+                for (i = 0; i < priv->child_count; i++)
+                        if ((local->good & EC_BIT (i)) && local->dirties[i])
+                                dirty |= EC_BIT (i);
+        }
+
+        local->stbuf = local->iatts[first];
+        ec_iatt_fix (this, &local->stbuf, local->sizes[first]);
+
+        local->op_ret   = 0;
+        local->op_errno = 0;
+
+        bad = (local->success & ~local->good) | dirty | missing;
+        if (bad && priv->self_heal)
+                ec_heal (this, &local->loc, &local->stbuf, bad, missing);
+
+out:
+        local->unwind (frame, this);
+}
+
+static int
+ec_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, inode_t *inode,
+               struct iatt *buf, dict_t *xattr, struct iatt *postparent)
+{
+        ec_local_t *local      = NULL;
+        int         child      = (long) cookie;
+        int         call_count = 0;
+
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                if (__ec_fop_reply (local, child, op_ret, op_errno)) {
+                        if (postparent)
+                                local->postparent = *postparent;
+                        if (xattr)
+                                local->xattr = dict_ref (xattr);
+                }
+
+                if (op_ret == 0) {
+                        local->iatts[child] = *buf;
+                        ec_dict_get_u64 (xattr, EC_XATTR_SIZE,
+                                         &local->sizes[child]);
+                        ec_dict_get_u64 (xattr, EC_XATTR_VERSION,
+                                         &local->versions[child]);
+                        ec_dict_get_u64 (xattr, EC_XATTR_BLOCK_SIZE,
+                                         &local->block_sizes[child]);
+                        ec_dict_get_u64 (xattr, EC_XATTR_DIRTY,
+                                         &local->dirties[child]);
+                }
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (!call_count)
+                ec_lookup_done (frame, this);
+
+        return 0;
+}
+
+static int
+ec_lookup_wind (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                dict_t *xattr_req)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = ENOMEM;
+        int           ret      = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        if (loc_copy (&local->loc, loc) != 0)
+                goto err;
+
+        local->xattr_req = xattr_req ? dict_ref (xattr_req) : dict_new ();
+        if (!local->xattr_req)
+                goto err;
+
+        ret = dict_set_uint64 (local->xattr_req, EC_XATTR_SIZE, 0);
+        if (!ret)
+                ret = dict_set_uint64 (local->xattr_req, EC_XATTR_VERSION, 0);
+        if (!ret)
+                ret = dict_set_uint64 (local->xattr_req, EC_XATTR_BLOCK_SIZE,
+                                       0);
+        if (!ret)
+                ret = dict_set_uint64 (local->xattr_req, EC_XATTR_DIRTY, 0);
+        if (ret)
+                goto err;
+
+        if (ec_wind_init (this, local, &op_errno))
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_lookup_cbk, lookup, loc,
+                 local->xattr_req);
+        return 0;
+
+err:
+        local->op_ret   = -1;
+        local->op_errno = op_errno;
+        local->unwind (frame, this);
+        return 0;
+}
+
+int
+ec_lookup (call_frame_t *frame, xlator_t *this, loc_t *loc,
+           dict_t *xattr_req)
+{
+        ec_local_t *local = NULL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+        VALIDATE_OR_GOTO (loc->inode, err);
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local  = local;
+        local->unwind = ec_lookup_unwind;
+
+        return ec_lookup_wind (frame, this, loc, xattr_req);
+err:
+        EC_STACK_UNWIND (lookup, frame, -1, ENOMEM, NULL, NULL, NULL, NULL);
+        return 0;
+}
+
+/* the size lives in xattrs of the fragments: stat is a lookup */
+int
+ec_stat (call_frame_t *frame, xlator_t *this, loc_t *loc)
+{
+        ec_local_t *local = NULL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+        VALIDATE_OR_GOTO (loc->inode, err);
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local  = local;
+        local->unwind = ec_stat_unwind;
+
+        return ec_lookup_wind (frame, this, loc, NULL);
+err:
+        EC_STACK_UNWIND (stat, frame, -1, ENOMEM, NULL);
+        return 0;
+}
+
+static int
+ec_fstat_unwind (call_frame_t *frame, xlator_t *this)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        EC_STACK_UNWIND (fstat, frame, local->op_ret, local->op_errno,
+                         &local->stbuf);
+        return 0;
+}
+
+static int
+ec_fstat_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, struct iatt *buf)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        local->op_ret   = op_ret;
+        local->op_errno = op_errno;
+        if (op_ret == 0) {
+                local->stbuf = *buf;
+                ec_iatt_fix (this, &local->stbuf, local->file_size);
+        }
+
+        return ec_unlock (frame, this);
+}
+
+static int
+ec_fstat_resume (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv  = NULL;
+        ec_local_t   *local = NULL;
+        int           child = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        child = ec_first (local->good);
+
+        STACK_WIND (frame, ec_fstat_cbk, priv->children[child],
+                    priv->children[child]->fops->fstat, local->fd);
+        return 0;
+}
+
+int
+ec_fstat (call_frame_t *frame, xlator_t *this, fd_t *fd)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        uint64_t      bad      = 0;
+        int32_t       op_errno = ENOMEM;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local   = local;
+        local->fd      = fd_ref (fd);
+        local->unwind  = ec_fstat_unwind;
+        local->nolock  = _gf_true;
+
+        if (ec_wind_init (this, local, &op_errno))
+                goto err;
+
+        if (!IA_ISREG (fd->inode->ia_type)) {
+                local->good = local->wind;
+                return ec_fstat_resume (frame, this);
+        }
+
+        /* the size is read from the fragments unless known already */
+        if (ec_inode_ctx_size (this, fd->inode, &local->file_size,
+                               &local->block_size, &bad) &&
+            ec_count (local->wind & ~bad) >= priv->fragments) {
+                local->good = local->wind & ~bad;
+                return ec_fstat_resume (frame, this);
+        }
+
+        local->transaction_fn = ec_fstat_resume;
+        return ec_preop (frame, this);
+err:
+        EC_STACK_UNWIND (fstat, frame, -1, op_errno, NULL);
+        return 0;
+}
+
+
+/* readv */
+
+static int
+ec_readv_unwind (call_frame_t *frame, xlator_t *this)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        EC_STACK_UNWIND (readv, frame, local->op_ret, local->op_errno,
+                         local->vector, local->count, &local->stbuf,
+                         local->iobref);
+        return 0;
+}
+
+static int
+ec_readv_done (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv   = NULL;
+        ec_local_t   *local  = NULL;
+        struct iobuf *iobuf  = NULL;
+        uint64_t      stripe = 0;
+        size_t        len    = 0;
+        size_t        skip   = 0;
+        size_t        page   = 0;
+        size_t        copied = 0;
+        size_t        n      = 0;
+        int           i      = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        if (local->op_ret < 0)
+                goto out;
+
+        stripe = local->block_size * priv->fragments;
+        skip   = local->offset - local->read_stripe * stripe;
+        len    = min (local->size, local->file_size - local->offset);
+
+        /* the reply is handed over in iobufs, which the callers above can
+           keep a reference on */
+        page = iobpool_default_pagesize ((struct iobuf_pool *)
+                                         this->ctx->iobuf_pool);
+        local->count  = (len + page - 1) / page;
+        local->vector = GF_CALLOC (local->count, sizeof (struct iovec),
+                                   gf_ec_mt_iovec);
+        local->iobref = iobref_new ();
+        if (!local->vector || !local->iobref)
+                goto nomem;
+
+        for (i = 0; i < local->count; i++) {
+                iobuf = iobuf_get (this->ctx->iobuf_pool);
+                if (!iobuf)
+                        goto nomem;
+
+                n = min (page, len - copied);
+                memcpy (iobuf->ptr, local->rbuf + skip + copied, n);
+                local->vector[i].iov_base = iobuf->ptr;
+                local->vector[i].iov_len  = n;
+                copied += n;
+
+                iobref_add (local->iobref, iobuf);
+                iobuf_unref (iobuf);
+        }
+
+        ec_iatt_fix (this, &local->stbuf, local->file_size);
+        local->op_ret   = len;
+        local->op_errno = 0;
+        goto out;
+
+nomem:
+        local->op_ret   = -1;
+        local->op_errno = ENOMEM;
+        local->count    = 0;
+out:
+        return ec_unlock (frame, this);
+}
+
+static int
+ec_readv_resume (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv   = NULL;
+        ec_local_t   *local  = NULL;
+        uint64_t      stripe = 0;
+        uint64_t      end    = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        if (local->offset >= local->file_size) {
+                local->op_ret   = 0;
+                local->op_errno = 0;
+                local->iobref   = iobref_new ();
+                return ec_unlock (frame, this);
+        }
+
+        stripe = local->block_size * priv->fragments;
+        end = min (local->offset + local->size, local->file_size);
+
+        return ec_stripe_read (frame, this, local->offset / stripe,
+                               (end + stripe - 1) / stripe -
+                               local->offset / stripe, ec_readv_done);
+}
+
+/* starts over under a shared lock, size and version read again under it */
+static int
+ec_readv_lock (call_frame_t *frame, xlator_t *this)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        local->nolock         = _gf_false;
+        local->transaction_fn = ec_readv_resume;
+
+        return ec_transaction_lock (frame, this, ec_up_children (this),
+                                    F_RDLCK);
+}
+
+/* reads take no lock as long as the data fragments can be read: they
+   are served from the children that were good at the last lookup or
+   update when they end before the size known then, size and version are
+   read again otherwise. A read that needs decoding takes a shared lock,
+   so that no write changes the fragments meanwhile. */
+int
+ec_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+          off_t offset)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        uint64_t      bad      = 0;
+        uint64_t      data     = 0;
+        int32_t       op_errno = ENOMEM;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local   = local;
+        local->fd      = fd_ref (fd);
+        local->size    = size;
+        local->offset  = offset;
+        local->unwind  = ec_readv_unwind;
+        local->nolock  = _gf_true;
+        local->read_degraded = ec_readv_lock;
+
+        if (ec_wind_init (this, local, &op_errno))
+                goto err;
+
+        data = EC_BIT (priv->fragments) - 1;
+        if (ec_inode_ctx_size (this, fd->inode, &local->file_size,
+                               &local->block_size, &bad) &&
+            (offset + size < local->file_size) &&
+            ((local->wind & ~bad & data) == data)) {
+                local->good = local->wind & ~bad;
+                return ec_readv_resume (frame, this);
+        }
+
+        local->transaction_fn = ec_readv_resume;
+        return ec_preop (frame, this);
+err:
+        EC_STACK_UNWIND (readv, frame, -1, op_errno, NULL, 0, NULL, NULL);
+        return 0;
+}
+
+
+/* writev */
+
+static int
+ec_writev_unwind (call_frame_t *frame, xlator_t *this)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        if (local->op_ret >= 0) {
+                ec_iatt_fix (this, &local->prebuf, local->file_size);
+                ec_iatt_fix (this, &local->postbuf, local->new_size);
+        }
+
+        EC_STACK_UNWIND (writev, frame, local->op_ret, local->op_errno,
+                         &local->prebuf, &local->postbuf);
+        return 0;
+}
+
+/* An update which reached fewer than `fragments' children leaves them
+   holding data newer than their version: they get a version above any
+   other one, too few to be decoded, and are healed back from the
+   children it did not reach. Those it failed on keep their dirty mark */
+static int
+ec_update_failed (call_frame_t *frame, xlator_t *this)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        local->op_ret = -1;
+        if (!local->op_errno)
+                local->op_errno = EIO;
+
+        if (!local->done)
+                return ec_unlock (frame, this);
+
+        local->new_size    = local->file_size;
+        local->new_version = local->max_version + 1;
+
+        return ec_postop (frame, this);
+}
+
+static int
+ec_writev_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+               struct iatt *postbuf)
+{
+        ec_private_t *priv       = NULL;
+        ec_local_t   *local      = NULL;
+        int           child      = (long) cookie;
+        int           call_count = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                if (op_ret < 0) {
+                        local->op_errno = op_errno;
+                } else {
+                        if (!local->done) {
+                                local->prebuf  = *prebuf;
+                                local->postbuf = *postbuf;
+                        }
+                        local->done |= EC_BIT (child);
+                }
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        if (ec_count (local->done) < priv->fragments)
+                return ec_update_failed (frame, this);
+
+        local->op_ret      = local->size;
+        local->op_errno    = 0;
+        local->new_size    = max (local->file_size,
+                                  local->offset + local->size);
+        local->new_version = local->max_version + 1;
+
+        return ec_postop (frame, this);
+}
+
+static int
+ec_writev_encode (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv   = NULL;
+        ec_local_t   *local  = NULL;
+        uint64_t      stripe = 0;
+        size_t        pos    = 0;
+        size_t        len    = 0;
+        int           i      = 0;
+
+        priv   = this->private;
+        local  = frame->local;
+        stripe = local->block_size * priv->fragments;
+        len    = local->write_count * local->block_size;
+
+        pos = local->offset - local->write_stripe * stripe;
+        for (i = 0; i < local->count; i++) {
+                memcpy (local->wbuf + pos, local->vector[i].iov_base,
+                        local->vector[i].iov_len);
+                pos += local->vector[i].iov_len;
+        }
+
+        if (ec_frags_alloc (priv->child_count, &local->wfrags,
+                            EC_BIT (priv->child_count) - 1, len)) {
+                local->op_ret   = -1;
+                local->op_errno = ENOMEM;
+                return ec_unlock (frame, this);
+        }
+
+        ec_stripe_encode (this, local, local->wbuf, local->write_count,
+                          local->wfrags);
+
+        return ec_fragments_write (frame, this, local->good,
+                                   local->write_stripe * local->block_size,
+                                   len, ec_writev_cbk);
+}
+
+static int ec_writev_rmw (call_frame_t *frame, xlator_t *this);
+
+static int
+ec_writev_rmw_cbk (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv   = NULL;
+        ec_local_t   *local  = NULL;
+        uint64_t      stripe = 0;
+
+        priv   = this->private;
+        local  = frame->local;
+        stripe = local->block_size * priv->fragments;
+
+        if (local->op_ret < 0)
+                return ec_unlock (frame, this);
+
+        memcpy (local->wbuf + (local->read_stripe - local->write_stripe) *
+                stripe, local->rbuf, stripe);
+
+        return ec_writev_rmw (frame, this);
+}
+
+/* the first and last stripes are read first when partly written */
+static int
+ec_writev_rmw (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv   = NULL;
+        ec_local_t   *local  = NULL;
+        uint64_t      stripe = 0;
+        off_t         last   = 0;
+
+        priv   = this->private;
+        local  = frame->local;
+        stripe = local->block_size * priv->fragments;
+        last   = local->write_stripe + local->write_count - 1;
+
+        switch (local->state) {
+        case 0:
+                local->state = 1;
+                if ((local->offset % stripe) &&
+                    (local->write_stripe * stripe < local->file_size)) {
+                        local->head_read = _gf_true;
+                        return ec_stripe_read (frame, this,
+                                               local->write_stripe, 1,
+                                               ec_writev_rmw_cbk);
+                }
+                /* fall through */
+        case 1:
+                local->state = 2;
+                if (((local->offset + local->size) % stripe) &&
+                    (last * stripe < local->file_size) &&
+                    !(last == local->write_stripe && local->head_read))
+                        return ec_stripe_read (frame, this, last, 1,
+                                               ec_writev_rmw_cbk);
+                /* fall through */
+        default:
+                break;
+        }
+
+        return ec_writev_encode (frame, this);
+}
+
+static int
+ec_writev_work (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv   = NULL;
+        ec_local_t   *local  = NULL;
+        uint64_t      stripe = 0;
+        uint64_t      end    = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        if (local->fd->flags & O_APPEND)
+                local->offset = local->file_size;
+
+        stripe = local->block_size * priv->fragments;
+        end    = local->offset + local->size;
+
+        local->write_stripe = local->offset / stripe;
+        local->write_count  = (end + stripe - 1) / stripe -
+                              local->write_stripe;
+
+        local->wbuf = GF_CALLOC (local->write_count, stripe,
+                                 gf_ec_mt_uint8_t);
+        if (!local->wbuf) {
+                local->op_ret   = -1;
+                local->op_errno = ENOMEM;
+                return ec_unlock (frame, this);
+        }
+
+        local->state = 0;
+        return ec_writev_rmw (frame, this);
+}
+
+int
+ec_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
+           struct iovec *vector, int32_t count, off_t offset,
+           struct iobref *iobref)
+{
+        ec_local_t *local    = NULL;
+        int32_t     op_errno = ENOMEM;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local  = local;
+        local->fd     = fd_ref (fd);
+        local->offset = offset;
+        local->size   = iov_length (vector, count);
+        local->count  = count;
+        local->vector = iov_dup (vector, count);
+        if (!local->vector)
+                goto err;
+        if (iobref)
+                local->iobref = iobref_ref (iobref);
+
+        local->unwind         = ec_writev_unwind;
+        local->transaction_fn = ec_writev_work;
+
+        if (ec_wind_init (this, local, &op_errno))
+                goto err;
+
+        return ec_transaction (frame, this, local->wind);
+err:
+        EC_STACK_UNWIND (writev, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+/* truncate and ftruncate */
+
+static int
+ec_ftruncate_unwind (call_frame_t *frame, xlator_t *this)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        if (local->op_ret >= 0) {
+                ec_iatt_fix (this, &local->prebuf, local->file_size);
+                ec_iatt_fix (this, &local->postbuf, local->new_size);
+        }
+
+        EC_STACK_UNWIND (ftruncate, frame, local->op_ret, local->op_errno,
+                         &local->prebuf, &local->postbuf);
+        return 0;
+}
+
+static int
+ec_truncate_unwind (call_frame_t *frame, xlator_t *this)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        if (local->op_ret >= 0) {
+                ec_iatt_fix (this, &local->prebuf, local->file_size);
+                ec_iatt_fix (this, &local->postbuf, local->new_size);
+        }
+
+        EC_STACK_UNWIND (truncate, frame, local->op_ret, local->op_errno,
+                         &local->prebuf, &local->postbuf);
+        return 0;
+}
+
+static int
+ec_truncate_fragments_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                           int32_t op_ret, int32_t op_errno,
+                           struct iatt *prebuf, struct iatt *postbuf)
+{
+        ec_private_t *priv       = NULL;
+        ec_local_t   *local      = NULL;
+        int           child      = (long) cookie;
+        int           call_count = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                if (op_ret < 0) {
+                        local->op_errno = op_errno;
+                } else {
+                        if (!local->done) {
+                                local->prebuf  = *prebuf;
+                                local->postbuf = *postbuf;
+                        }
+                        local->done |= EC_BIT (child);
+                }
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        if (ec_count (local->done) < priv->fragments)
+                return ec_update_failed (frame, this);
+
+        local->op_ret      = 0;
+        local->op_errno    = 0;
+        local->new_version = local->max_version + 1;
+
+        return ec_postop (frame, this);
+}
+
+/* every fragment is cut after the last stripe holding data */
+static int
+ec_truncate_fragments (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv   = NULL;
+        ec_local_t   *local  = NULL;
+        uint64_t      stripe = 0;
+        off_t         len    = 0;
+
+        priv   = this->private;
+        local  = frame->local;
+        stripe = local->block_size * priv->fragments;
+        len    = (local->new_size + stripe - 1) / stripe * local->block_size;
+
+        local->wind       = local->good;
+        local->done       = 0;
+        local->call_count = ec_count (local->good);
+
+        EC_WIND (frame, local, priv, ec_truncate_fragments_cbk, ftruncate,
+                 local->fd, len);
+        return 0;
+}
+
+static int
+ec_truncate_write_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                       int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                       struct iatt *postbuf)
+{
+        ec_private_t *priv       = NULL;
+        ec_local_t   *local      = NULL;
+        int           child      = (long) cookie;
+        int           call_count = 0;
+
+        priv  = this->private;
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                if (op_ret < 0)
+                        local->op_errno = op_errno;
+                else
+                        local->done |= EC_BIT (child);
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        if (ec_count (local->done) < priv->fragments)
+                return ec_update_failed (frame, this);
+
+        local->good = local->done;
+        return ec_truncate_fragments (frame, this);
+}
+
+/* the part of the last stripe past the new end of file is zeroed, so
+   that it reads as zeros when the file grows again */
+static int
+ec_truncate_rmw_cbk (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv   = NULL;
+        ec_local_t   *local  = NULL;
+        uint64_t      stripe = 0;
+        uint64_t      cut    = 0;
+
+        priv   = this->private;
+        local  = frame->local;
+        stripe = local->block_size * priv->fragments;
+
+        if (local->op_ret < 0)
+                return ec_unlock (frame, this);
+
+        cut = local->new_size % stripe;
+        memset (local->rbuf + cut, 0, stripe - cut);
+
+        if (ec_frags_alloc (priv->child_count, &local->wfrags,
+                            EC_BIT (priv->child_count) - 1,
+                            local->block_size)) {
+                local->op_ret   = -1;
+                local->op_errno = ENOMEM;
+                return ec_unlock (frame, this);
+        }
+
+        ec_stripe_encode (this, local, local->rbuf, 1, local->wfrags);
+
+        return ec_fragments_write (frame, this, local->good,
+                                   local->read_stripe * local->block_size,
+                                   local->block_size, ec_truncate_write_cbk);
+}
+
+static int
+ec_truncate_work (call_frame_t *frame, xlator_t *this)
+{
+        ec_private_t *priv   = NULL;
+        ec_local_t   *local  = NULL;
+        uint64_t      stripe = 0;
+
+        priv   = this->private;
+        local  = frame->local;
+        stripe = local->block_size * priv->fragments;
+
+        local->new_size = local->offset;
+
+        if ((local->offset < local->file_size) && (local->offset % stripe))
+                return ec_stripe_read (frame, this, local->offset / stripe, 1,
+                                       ec_truncate_rmw_cbk);
+
+        return ec_truncate_fragments (frame, this);
+}
+
+int
+ec_ftruncate (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset)
+{
+        ec_local_t *local    = NULL;
+        int32_t     op_errno = ENOMEM;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local          = local;
+        local->fd             = fd_ref (fd);
+        local->offset         = offset;
+        local->unwind         = ec_ftruncate_unwind;
+        local->transaction_fn = ec_truncate_work;
+
+        if (ec_wind_init (this, local, &op_errno))
+                goto err;
+
+        return ec_transaction (frame, this, local->wind);
+err:
+        EC_STACK_UNWIND (ftruncate, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+static int
+ec_truncate_open_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                      int32_t op_ret, int32_t op_errno, fd_t *fd)
+{
+        ec_local_t *local      = NULL;
+        int         child      = (long) cookie;
+        int         call_count = 0;
+
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                __ec_fop_reply (local, child, op_ret, op_errno);
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        ec_fop_result (this, local);
+        if (local->op_ret < 0)
+                return local->unwind (frame, this);
+
+        return ec_transaction (frame, this, local->success);
+}
+
+/* the fragments are read and truncated through an fd of our own */
+int
+ec_truncate (call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = ENOMEM;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+        VALIDATE_OR_GOTO (loc->inode, err);
+
+        priv = this->private;
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local          = local;
+        local->offset         = offset;
+        local->unwind         = ec_truncate_unwind;
+        local->transaction_fn = ec_truncate_work;
+
+        if (loc_copy (&local->loc, loc) != 0)
+                goto err;
+
+        local->fd = fd_create (loc->inode, frame->root->pid);
+        if (!local->fd)
+                goto err;
+
+        if (ec_wind_init (this, local, &op_errno))
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_truncate_open_cbk, open, loc,
+                 O_RDWR, local->fd, 0);
+        return 0;
+err:
+        EC_STACK_UNWIND (truncate, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+/* open and create */
+
+static int
+ec_open_unwind (call_frame_t *frame, xlator_t *this)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        EC_STACK_UNWIND (open, frame, local->op_ret, local->op_errno,
+                         local->fd);
+        return 0;
+}
+
+static int
+ec_open_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+             int32_t op_ret, int32_t op_errno, fd_t *fd)
+{
+        ec_local_t *local      = NULL;
+        int         child      = (long) cookie;
+        int         call_count = 0;
+
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                __ec_fop_reply (local, child, op_ret, op_errno);
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        ec_fop_result (this, local);
+
+        /* O_TRUNC was kept from the children: the size xattrs have to be
+           updated with the fragments */
+        if ((local->op_ret == 0) && (local->flags & O_TRUNC) &&
+            IA_ISREG (local->fd->inode->ia_type)) {
+                local->offset         = 0;
+                local->transaction_fn = ec_truncate_work;
+                return ec_transaction (frame, this, local->success);
+        }
+
+        return local->unwind (frame, this);
+}
+
+/* fragments are always opened for reading too, as partial writes of a
+   stripe read the rest of it */
+static int32_t
+ec_child_flags (int32_t flags)
+{
+        flags &= ~(O_TRUNC | O_APPEND);
+        if ((flags & O_ACCMODE) == O_WRONLY)
+                flags = (flags & ~O_ACCMODE) | O_RDWR;
+
+        return flags;
+}
+
+int
+ec_open (call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+         fd_t *fd, int32_t wbflags)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = ENOMEM;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local  = local;
+        local->fd     = fd_ref (fd);
+        local->flags  = flags;
+        local->unwind = ec_open_unwind;
+
+        if (ec_wind_init (this, local, &op_errno))
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_open_cbk, open, loc,
+                 ec_child_flags (flags), fd, wbflags);
+        return 0;
+err:
+        EC_STACK_UNWIND (open, frame, -1, op_errno, NULL);
+        return 0;
+}
+
+static int
+ec_create_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, fd_t *fd, inode_t *inode,
+               struct iatt *buf, struct iatt *preparent,
+               struct iatt *postparent)
+{
+        ec_local_t *local      = NULL;
+        int         child      = (long) cookie;
+        int         call_count = 0;
+
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                if (__ec_fop_reply (local, child, op_ret, op_errno)) {
+                        local->stbuf      = *buf;
+                        local->preparent  = *preparent;
+                        local->postparent = *postparent;
+                }
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        ec_fop_result (this, local);
+        if (local->op_ret == 0) {
+                ec_inode_ctx_set_size (this, local->loc.inode, 0,
+                                       local->block_size,
+                                       local->wind & ~local->success);
+                ec_iatt_fix (this, &local->stbuf, 0);
+        }
+
+        EC_STACK_UNWIND (create, frame, local->op_ret, local->op_errno,
+                         local->fd, local->loc.inode, &local->stbuf,
+                         &local->preparent, &local->postparent);
+        return 0;
+}
+
+int
+ec_create (call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+           mode_t mode, fd_t *fd, dict_t *params)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = ENOMEM;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local      = local;
+        local->fd         = fd_ref (fd);
+        local->block_size = ec_get_matching_bs (loc->path, priv->pattern,
+                                                priv->block_size);
+
+        if (loc_copy (&local->loc, loc) != 0)
+                goto err;
+
+        local->xattr_req = params ? dict_ref (params) : dict_new ();
+        if (!local->xattr_req ||
+            ec_new_file_xattrs (local->xattr_req, local->block_size))
+                goto err;
+
+        if (ec_wind_init (this, local, &op_errno))
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_create_cbk, create, loc,
+                 ec_child_flags (flags), mode, fd, local->xattr_req);
+        return 0;
+err:
+        EC_STACK_UNWIND (create, frame, -1, op_errno, NULL, NULL, NULL, NULL,
+                         NULL);
+        return 0;
+}
+
+
+/* entry fops, sent to all the children */
+
+static int
+ec_entry_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, inode_t *inode,
+              struct iatt *buf, struct iatt *preparent,
+              struct iatt *postparent)
+{
+        ec_local_t *local      = NULL;
+        int         child      = (long) cookie;
+        int         call_count = 0;
+
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                if (__ec_fop_reply (local, child, op_ret, op_errno)) {
+                        local->stbuf      = *buf;
+                        local->preparent  = *preparent;
+                        local->postparent = *postparent;
+                }
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        ec_fop_result (this, local);
+        local->unwind (frame, this);
+
+        return 0;
+}
+
+static int
+ec_mknod_unwind (call_frame_t *frame, xlator_t *this)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((local->op_ret == 0) && IA_ISREG (local->stbuf.ia_type)) {
+                ec_inode_ctx_set_size (this, local->loc.inode, 0,
+                                       local->block_size,
+                                       local->wind & ~local->success);
+                ec_iatt_fix (this, &local->stbuf, 0);
+        }
+
+        EC_STACK_UNWIND (mknod, frame, local->op_ret, local->op_errno,
+                         local->loc.inode, &local->stbuf, &local->preparent,
+                         &local->postparent);
+        return 0;
+}
+
+int
+ec_mknod (call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+          dev_t rdev, dict_t *params)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = ENOMEM;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+
+        priv = this->private;
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local      = local;
+        local->unwind     = ec_mknod_unwind;
+        local->block_size = ec_get_matching_bs (loc->path, priv->pattern,
+                                                priv->block_size);
+
+        if (loc_copy (&local->loc, loc) != 0)
+                goto err;
+
+        local->xattr_req = params ? dict_ref (params) : dict_new ();
+        if (!local->xattr_req)
+                goto err;
+
+        if (S_ISREG (mode) &&
+            ec_new_file_xattrs (local->xattr_req, local->block_size))
+                goto err;
+
+        if (ec_wind_init (this, local, &op_errno))
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_entry_cbk, mknod, loc, mode, rdev,
+                 local->xattr_req);
+        return 0;
+err:
+        EC_STACK_UNWIND (mknod, frame, -1, op_errno, NULL, NULL, NULL, NULL);
+        return 0;
+}
+
+static int
+ec_mkdir_unwind (call_frame_t *frame, xlator_t *this)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        EC_STACK_UNWIND (mkdir, frame, local->op_ret, local->op_errno,
+                         local->loc.inode, &local->stbuf, &local->preparent,
+                         &local->postparent);
+        return 0;
+}
+
+int
+ec_mkdir (call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+          dict_t *params)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = ENOMEM;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+
+        priv = this->private;
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local  = local;
+        local->unwind = ec_mkdir_unwind;
+
+        if (loc_copy (&local->loc, loc) != 0)
+                goto err;
+
+        if (ec_wind_init (this, local, &op_errno))
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_entry_cbk, mkdir, loc, mode, params);
+        return 0;
+err:
+        EC_STACK_UNWIND (mkdir, frame, -1, op_errno, NULL, NULL, NULL, NULL);
+        return 0;
+}
+
+static int
+ec_symlink_unwind (call_frame_t *frame, xlator_t *this)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        EC_STACK_UNWIND (symlink, frame, local->op_ret, local->op_errno,
+                         local->loc.inode, &local->stbuf, &local->preparent,
+                         &local->postparent);
+        return 0;
+}
+
+int
+ec_symlink (call_frame_t *frame, xlator_t *this, const char *linkname,
+            loc_t *loc, dict_t *params)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = ENOMEM;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+
+        priv = this->private;
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local  = local;
+        local->unwind = ec_symlink_unwind;
+
+        if (loc_copy (&local->loc, loc) != 0)
+                goto err;
+
+        if (ec_wind_init (this, local, &op_errno))
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_entry_cbk, symlink, linkname, loc,
+                 params);
+        return 0;
+err:
+        EC_STACK_UNWIND (symlink, frame, -1, op_errno, NULL, NULL, NULL, NULL);
+        return 0;
+}
+
+static int
+ec_link_unwind (call_frame_t *frame, xlator_t *this)
+{
+        ec_local_t *local = NULL;
+
+        local = frame->local;
+
+        if (local->op_ret == 0)
+                ec_iatt_fix_inode (this, local->loc.inode, &local->stbuf);
+
+        EC_STACK_UNWIND (link, frame, local->op_ret, local->op_errno,
+                         local->loc.inode, &local->stbuf, &local->preparent,
+                         &local->postparent);
+        return 0;
+}
+
+int
+ec_link (call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = ENOMEM;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (oldloc, err);
+        VALIDATE_OR_GOTO (newloc, err);
+
+        priv = this->private;
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local  = local;
+        local->unwind = ec_link_unwind;
+
+        if (loc_copy (&local->loc, oldloc) != 0)
+                goto err;
+
+        if (ec_wind_init (this, local, &op_errno))
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_entry_cbk, link, oldloc, newloc);
+        return 0;
+err:
+        EC_STACK_UNWIND (link, frame, -1, op_errno, NULL, NULL, NULL, NULL);
+        return 0;
+}
+
+static int
+ec_unlink_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct iatt *preparent,
+               struct iatt *postparent)
+{
+        ec_local_t *local      = NULL;
+        int         child      = (long) cookie;
+        int         call_count = 0;
+
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                if (__ec_fop_reply (local, child, op_ret, op_errno)) {
+                        local->preparent  = *preparent;
+                        local->postparent = *postparent;
+                }
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        ec_fop_result (this, local);
+
+        if (local->state)
+                EC_STACK_UNWIND (rmdir, frame, local->op_ret, local->op_errno,
+                                 &local->preparent, &local->postparent);
+        else
+                EC_STACK_UNWIND (unlink, frame, local->op_ret,
+                                 local->op_errno, &local->preparent,
+                                 &local->postparent);
+        return 0;
+}
+
+int
+ec_unlink (call_frame_t *frame, xlator_t *this, loc_t *loc)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = ENOMEM;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+
+        priv = this->private;
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local = local;
+
+        if (ec_wind_init (this, local, &op_errno))
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_unlink_cbk, unlink, loc);
+        return 0;
+err:
+        EC_STACK_UNWIND (unlink, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+int
+ec_rmdir (call_frame_t *frame, xlator_t *this, loc_t *loc, int flags)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = ENOMEM;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+
+        priv = this->private;
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local = local;
+        local->state = 1;
+
+        if (ec_wind_init (this, local, &op_errno))
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_unlink_cbk, rmdir, loc, flags);
+        return 0;
+err:
+        EC_STACK_UNWIND (rmdir, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+static int
+ec_rename_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct iatt *buf,
+               struct iatt *preoldparent, struct iatt *postoldparent,
+               struct iatt *prenewparent, struct iatt *postnewparent)
+{
+        ec_local_t *local      = NULL;
+        int         child      = (long) cookie;
+        int         call_count = 0;
+
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                if (__ec_fop_reply (local, child, op_ret, op_errno)) {
+                        local->stbuf       = *buf;
+                        local->preparent   = *preoldparent;
+                        local->postparent  = *postoldparent;
+                        local->preparent2  = *prenewparent;
+                        local->postparent2 = *postnewparent;
+                }
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        ec_fop_result (this, local);
+        if (local->op_ret == 0)
+                ec_iatt_fix_inode (this, local->loc.inode, &local->stbuf);
+
+        EC_STACK_UNWIND (rename, frame, local->op_ret, local->op_errno,
+                         &local->stbuf, &local->preparent, &local->postparent,
+                         &local->preparent2, &local->postparent2);
+        return 0;
+}
+
+int
+ec_rename (call_frame_t *frame, xlator_t *this, loc_t *oldloc,
+           loc_t *newloc)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = ENOMEM;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (oldloc, err);
+        VALIDATE_OR_GOTO (newloc, err);
+
+        priv = this->private;
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local = local;
+
+        if (loc_copy (&local->loc, oldloc) != 0)
+                goto err;
+
+        if (ec_wind_init (this, local, &op_errno))
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_rename_cbk, rename, oldloc, newloc);
+        return 0;
+err:
+        EC_STACK_UNWIND (rename, frame, -1, op_errno, NULL, NULL, NULL, NULL,
+                         NULL);
+        return 0;
+}
+
+
+/* fops only returning a status, sent to all the children; local->state
+   is the fop */
+
+static int
+ec_status_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno)
+{
+        ec_local_t *local      = NULL;
+        int         child      = (long) cookie;
+        int         call_count = 0;
+
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                __ec_fop_reply (local, child, op_ret, op_errno);
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        ec_fop_result (this, local);
+
+        switch (local->state) {
+        case GF_FOP_SETXATTR:
+                EC_STACK_UNWIND (setxattr, frame, local->op_ret,
+                                 local->op_errno);
+                break;
+        case GF_FOP_FSETXATTR:
+                EC_STACK_UNWIND (fsetxattr, frame, local->op_ret,
+                                 local->op_errno);
+                break;
+        case GF_FOP_REMOVEXATTR:
+                EC_STACK_UNWIND (removexattr, frame, local->op_ret,
+                                 local->op_errno);
+                break;
+        case GF_FOP_FLUSH:
+                EC_STACK_UNWIND (flush, frame, local->op_ret,
+                                 local->op_errno);
+                break;
+        case GF_FOP_FSYNCDIR:
+                EC_STACK_UNWIND (fsyncdir, frame, local->op_ret,
+                                 local->op_errno);
+                break;
+        case GF_FOP_INODELK:
+                EC_STACK_UNWIND (inodelk, frame, local->op_ret,
+                                 local->op_errno);
+                break;
+        case GF_FOP_FINODELK:
+                EC_STACK_UNWIND (finodelk, frame, local->op_ret,
+                                 local->op_errno);
+                break;
+        case GF_FOP_ENTRYLK:
+                EC_STACK_UNWIND (entrylk, frame, local->op_ret,
+                                 local->op_errno);
+                break;
+        case GF_FOP_FENTRYLK:
+                EC_STACK_UNWIND (fentrylk, frame, local->op_ret,
+                                 local->op_errno);
+                break;
+        default:
+                gf_log (this->name, GF_LOG_ERROR, "unexpected fop %d",
+                        local->state);
+                break;
+        }
+
+        return 0;
+}
+
+static ec_local_t *
+ec_status_local (call_frame_t *frame, xlator_t *this, int fop,
+                 int32_t *op_errno)
+{
+        ec_local_t *local = NULL;
+
+        local = ec_local_init (this);
+        if (!local) {
+                *op_errno = ENOMEM;
+                return NULL;
+        }
+
+        frame->local = local;
+        local->state = fop;
+
+        if (ec_wind_init (this, local, op_errno))
+                return NULL;
+
+        return local;
+}
+
+int
+ec_setxattr (call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *dict,
+             int32_t flags)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        data_pair_t  *trav     = NULL;
+        int32_t       op_errno = EINVAL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+
+        priv = this->private;
+
+        GF_IF_INTERNAL_XATTR_GOTO ("trusted.ec.*", dict, trav, op_errno, err);
+
+        local = ec_status_local (frame, this, GF_FOP_SETXATTR, &op_errno);
+        if (!local)
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_status_cbk, setxattr, loc, dict,
+                 flags);
+        return 0;
+err:
+        EC_STACK_UNWIND (setxattr, frame, -1, op_errno);
+        return 0;
+}
+
+int
+ec_fsetxattr (call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *dict,
+              int32_t flags)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        data_pair_t  *trav     = NULL;
+        int32_t       op_errno = EINVAL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        GF_IF_INTERNAL_XATTR_GOTO ("trusted.ec.*", dict, trav, op_errno, err);
+
+        local = ec_status_local (frame, this, GF_FOP_FSETXATTR, &op_errno);
+        if (!local)
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_status_cbk, fsetxattr, fd, dict,
+                 flags);
+        return 0;
+err:
+        EC_STACK_UNWIND (fsetxattr, frame, -1, op_errno);
+        return 0;
+}
+
+int
+ec_removexattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                const char *name)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = EINVAL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+
+        priv = this->private;
+
+        if (name && !fnmatch ("trusted.ec.*", name, 0)) {
+                op_errno = EPERM;
+                goto err;
+        }
+
+        local = ec_status_local (frame, this, GF_FOP_REMOVEXATTR, &op_errno);
+        if (!local)
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_status_cbk, removexattr, loc, name);
+        return 0;
+err:
+        EC_STACK_UNWIND (removexattr, frame, -1, op_errno);
+        return 0;
+}
+
+int
+ec_flush (call_frame_t *frame, xlator_t *this, fd_t *fd)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = EINVAL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        local = ec_status_local (frame, this, GF_FOP_FLUSH, &op_errno);
+        if (!local)
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_status_cbk, flush, fd);
+        return 0;
+err:
+        EC_STACK_UNWIND (flush, frame, -1, op_errno);
+        return 0;
+}
+
+int
+ec_fsyncdir (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t flags)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = EINVAL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        local = ec_status_local (frame, this, GF_FOP_FSYNCDIR, &op_errno);
+        if (!local)
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_status_cbk, fsyncdir, fd, flags);
+        return 0;
+err:
+        EC_STACK_UNWIND (fsyncdir, frame, -1, op_errno);
+        return 0;
+}
+
+int
+ec_inodelk (call_frame_t *frame, xlator_t *this, const char *volume,
+            loc_t *loc, int32_t cmd, struct gf_flock *flock)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = EINVAL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+
+        priv = this->private;
+
+        local = ec_status_local (frame, this, GF_FOP_INODELK, &op_errno);
+        if (!local)
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_status_cbk, inodelk, volume, loc,
+                 cmd, flock);
+        return 0;
+err:
+        EC_STACK_UNWIND (inodelk, frame, -1, op_errno);
+        return 0;
+}
+
+int
+ec_finodelk (call_frame_t *frame, xlator_t *this, const char *volume,
+             fd_t *fd, int32_t cmd, struct gf_flock *flock)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = EINVAL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        local = ec_status_local (frame, this, GF_FOP_FINODELK, &op_errno);
+        if (!local)
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_status_cbk, finodelk, volume, fd,
+                 cmd, flock);
+        return 0;
+err:
+        EC_STACK_UNWIND (finodelk, frame, -1, op_errno);
+        return 0;
+}
+
+int
+ec_entrylk (call_frame_t *frame, xlator_t *this, const char *volume,
+            loc_t *loc, const char *basename, entrylk_cmd cmd,
+            entrylk_type type)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = EINVAL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+
+        priv = this->private;
+
+        local = ec_status_local (frame, this, GF_FOP_ENTRYLK, &op_errno);
+        if (!local)
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_status_cbk, entrylk, volume, loc,
+                 basename, cmd, type);
+        return 0;
+err:
+        EC_STACK_UNWIND (entrylk, frame, -1, op_errno);
+        return 0;
+}
+
+int
+ec_fentrylk (call_frame_t *frame, xlator_t *this, const char *volume,
+             fd_t *fd, const char *basename, entrylk_cmd cmd,
+             entrylk_type type)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = EINVAL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        local = ec_status_local (frame, this, GF_FOP_FENTRYLK, &op_errno);
+        if (!local)
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_status_cbk, fentrylk, volume, fd,
+                 basename, cmd, type);
+        return 0;
+err:
+        EC_STACK_UNWIND (fentrylk, frame, -1, op_errno);
+        return 0;
+}
+
+
+/* fops returning the attributes before and after, sent to all the
+   children; local->state is the fop */
+
+static int
+ec_attr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+             int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+             struct iatt *postbuf)
+{
+        ec_local_t *local      = NULL;
+        int         child      = (long) cookie;
+        int         call_count = 0;
+
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                if (__ec_fop_reply (local, child, op_ret, op_errno)) {
+                        local->prebuf  = *prebuf;
+                        local->postbuf = *postbuf;
+                }
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        ec_fop_result (this, local);
+        if (local->op_ret == 0) {
+                ec_iatt_fix_inode (this, local->inode, &local->prebuf);
+                ec_iatt_fix_inode (this, local->inode, &local->postbuf);
+        }
+
+        switch (local->state) {
+        case GF_FOP_SETATTR:
+                EC_STACK_UNWIND (setattr, frame, local->op_ret,
+                                 local->op_errno, &local->prebuf,
+                                 &local->postbuf);
+                break;
+        case GF_FOP_FSETATTR:
+                EC_STACK_UNWIND (fsetattr, frame, local->op_ret,
+                                 local->op_errno, &local->prebuf,
+                                 &local->postbuf);
+                break;
+        case GF_FOP_FSYNC:
+                EC_STACK_UNWIND (fsync, frame, local->op_ret,
+                                 local->op_errno, &local->prebuf,
+                                 &local->postbuf);
+                break;
+        default:
+                gf_log (this->name, GF_LOG_ERROR, "unexpected fop %d",
+                        local->state);
+                break;
+        }
+
+        return 0;
+}
+
+int
+ec_setattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+            struct iatt *stbuf, int32_t valid)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = EINVAL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+        VALIDATE_OR_GOTO (loc->inode, err);
+
+        priv = this->private;
+
+        local = ec_status_local (frame, this, GF_FOP_SETATTR, &op_errno);
+        if (!local)
+                goto err;
+
+        local->inode = inode_ref (loc->inode);
+
+        EC_WIND (frame, local, priv, ec_attr_cbk, setattr, loc, stbuf, valid);
+        return 0;
+err:
+        EC_STACK_UNWIND (setattr, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+int
+ec_fsetattr (call_frame_t *frame, xlator_t *this, fd_t *fd,
+             struct iatt *stbuf, int32_t valid)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = EINVAL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        local = ec_status_local (frame, this, GF_FOP_FSETATTR, &op_errno);
+        if (!local)
+                goto err;
+
+        local->inode = inode_ref (fd->inode);
+
+        EC_WIND (frame, local, priv, ec_attr_cbk, fsetattr, fd, stbuf, valid);
+        return 0;
+err:
+        EC_STACK_UNWIND (fsetattr, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+int
+ec_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t datasync)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = EINVAL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        local = ec_status_local (frame, this, GF_FOP_FSYNC, &op_errno);
+        if (!local)
+                goto err;
+
+        local->inode = inode_ref (fd->inode);
+
+        EC_WIND (frame, local, priv, ec_attr_cbk, fsync, fd, datasync);
+        return 0;
+err:
+        EC_STACK_UNWIND (fsync, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+/* opendir, lk and statfs */
+
+static int
+ec_opendir_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, fd_t *fd)
+{
+        ec_local_t *local      = NULL;
+        int         child      = (long) cookie;
+        int         call_count = 0;
+
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                __ec_fop_reply (local, child, op_ret, op_errno);
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        ec_fop_result (this, local);
+
+        EC_STACK_UNWIND (opendir, frame, local->op_ret, local->op_errno,
+                         local->fd);
+        return 0;
+}
+
+int
+ec_opendir (call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = EINVAL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        local = ec_status_local (frame, this, GF_FOP_OPENDIR, &op_errno);
+        if (!local)
+                goto err;
+
+        local->fd = fd_ref (fd);
+
+        EC_WIND (frame, local, priv, ec_opendir_cbk, opendir, loc, fd);
+        return 0;
+err:
+        EC_STACK_UNWIND (opendir, frame, -1, op_errno, NULL);
+        return 0;
+}
+
+static int
+ec_lk_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+           int32_t op_ret, int32_t op_errno, struct gf_flock *lock)
+{
+        ec_local_t *local      = NULL;
+        int         child      = (long) cookie;
+        int         call_count = 0;
+
+        local = frame->local;
+
+        LOCK (&frame->lock);
+        {
+                if (__ec_fop_reply (local, child, op_ret, op_errno) && lock)
+                        local->flock = *lock;
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        ec_fop_result (this, local);
+
+        EC_STACK_UNWIND (lk, frame, local->op_ret, local->op_errno,
+                         &local->flock);
+        return 0;
+}
+
+int
+ec_lk (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t cmd,
+       struct gf_flock *flock)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = EINVAL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        local = ec_status_local (frame, this, GF_FOP_LK, &op_errno);
+        if (!local)
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_lk_cbk, lk, fd, cmd, flock);
+        return 0;
+err:
+        EC_STACK_UNWIND (lk, frame, -1, op_errno, NULL);
+        return 0;
+}
+
+static int
+ec_statfs_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct statvfs *buf)
+{
+        ec_private_t   *priv       = NULL;
+        ec_local_t     *local      = NULL;
+        struct statvfs *dst        = NULL;
+        int             child      = (long) cookie;
+        int             call_count = 0;
+
+        priv  = this->private;
+        local = frame->local;
+        dst   = &local->statvfs;
+
+        LOCK (&frame->lock);
+        {
+                /* the volume fills up with its smallest child */
+                if (__ec_fop_reply (local, child, op_ret, op_errno)) {
+                        *dst = *buf;
+                } else if (op_ret == 0) {
+                        dst->f_blocks = min (dst->f_blocks, buf->f_blocks);
+                        dst->f_bfree  = min (dst->f_bfree, buf->f_bfree);
+                        dst->f_bavail = min (dst->f_bavail, buf->f_bavail);
+                        dst->f_files  = min (dst->f_files, buf->f_files);
+                        dst->f_ffree  = min (dst->f_ffree, buf->f_ffree);
+                        dst->f_favail = min (dst->f_favail, buf->f_favail);
+                }
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (call_count)
+                return 0;
+
+        ec_fop_result (this, local);
+        if (local->op_ret == 0) {
+                dst->f_blocks *= priv->fragments;
+                dst->f_bfree  *= priv->fragments;
+                dst->f_bavail *= priv->fragments;
+        }
+
+        EC_STACK_UNWIND (statfs, frame, local->op_ret, local->op_errno, dst);
+        return 0;
+}
+
+int
+ec_statfs (call_frame_t *frame, xlator_t *this, loc_t *loc)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = EINVAL;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+
+        priv = this->private;
+
+        local = ec_status_local (frame, this, GF_FOP_STATFS, &op_errno);
+        if (!local)
+                goto err;
+
+        EC_WIND (frame, local, priv, ec_statfs_cbk, statfs, loc);
+        return 0;
+err:
+        EC_STACK_UNWIND (statfs, frame, -1, op_errno, NULL);
+        return 0;
+}
+
+
+/* fops served by a single child */
+
+static int
+ec_read_child (xlator_t *this, inode_t *inode)
+{
+        uint64_t up  = 0;
+        uint64_t bad = 0;
+
+        up = ec_up_children (this);
+        if (inode)
+                ec_inode_ctx_size (this, inode, NULL, NULL, &bad);
+
+        if (up & ~bad)
+                return ec_first (up & ~bad);
+
+        return ec_first (up);
+}
+
+static int
+ec_access_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno)
+{
+        EC_STACK_UNWIND (access, frame, op_ret, op_errno);
+        return 0;
+}
+
+int
+ec_access (call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t mask)
+{
+        ec_private_t *priv  = NULL;
+        int           child = 0;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+
+        priv  = this->private;
+        child = ec_read_child (this, loc->inode);
+        if (child < 0)
+                goto err;
+
+        STACK_WIND (frame, ec_access_cbk, priv->children[child],
+                    priv->children[child]->fops->access, loc, mask);
+        return 0;
+err:
+        EC_STACK_UNWIND (access, frame, -1, ENOTCONN);
+        return 0;
+}
+
+static int
+ec_readlink_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, const char *path,
+                 struct iatt *buf)
+{
+        EC_STACK_UNWIND (readlink, frame, op_ret, op_errno, path, buf);
+        return 0;
+}
+
+int
+ec_readlink (call_frame_t *frame, xlator_t *this, loc_t *loc, size_t size)
+{
+        ec_private_t *priv  = NULL;
+        int           child = 0;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+
+        priv  = this->private;
+        child = ec_read_child (this, loc->inode);
+        if (child < 0)
+                goto err;
+
+        STACK_WIND (frame, ec_readlink_cbk, priv->children[child],
+                    priv->children[child]->fops->readlink, loc, size);
+        return 0;
+err:
+        EC_STACK_UNWIND (readlink, frame, -1, ENOTCONN, NULL, NULL);
+        return 0;
+}
+
+static int
+ec_getxattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, dict_t *dict)
+{
+        EC_STACK_UNWIND (getxattr, frame, op_ret, op_errno, dict);
+        return 0;
+}
+
+int
+ec_getxattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+             const char *name)
+{
+        ec_private_t *priv  = NULL;
+        int           child = 0;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (loc, err);
+
+        priv  = this->private;
+        child = ec_read_child (this, loc->inode);
+        if (child < 0)
+                goto err;
+
+        STACK_WIND (frame, ec_getxattr_cbk, priv->children[child],
+                    priv->children[child]->fops->getxattr, loc, name);
+        return 0;
+err:
+        EC_STACK_UNWIND (getxattr, frame, -1, ENOTCONN, NULL);
+        return 0;
+}
+
+static int
+ec_fgetxattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, dict_t *dict)
+{
+        EC_STACK_UNWIND (fgetxattr, frame, op_ret, op_errno, dict);
+        return 0;
+}
+
+int
+ec_fgetxattr (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              const char *name)
+{
+        ec_private_t *priv  = NULL;
+        int           child = 0;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv  = this->private;
+        child = ec_read_child (this, fd->inode);
+        if (child < 0)
+                goto err;
+
+        STACK_WIND (frame, ec_fgetxattr_cbk, priv->children[child],
+                    priv->children[child]->fops->fgetxattr, fd, name);
+        return 0;
+err:
+        EC_STACK_UNWIND (fgetxattr, frame, -1, ENOTCONN, NULL);
+        return 0;
+}
+
+static int
+ec_readdir_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, gf_dirent_t *entries)
+{
+        EC_STACK_UNWIND (readdir, frame, op_ret, op_errno, entries);
+        return 0;
+}
+
+/* every child holds the same entries: a directory is read from one of
+   them, always the same as offsets are those of its backend */
+int
+ec_readdir (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+            off_t offset)
+{
+        ec_private_t *priv  = NULL;
+        int           child = 0;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv  = this->private;
+        child = ec_first (ec_up_children (this));
+        if (child < 0)
+                goto err;
+
+        STACK_WIND (frame, ec_readdir_cbk, priv->children[child],
+                    priv->children[child]->fops->readdir, fd, size, offset);
+        return 0;
+err:
+        EC_STACK_UNWIND (readdir, frame, -1, ENOTCONN, NULL);
+        return 0;
+}
+
+static int
+ec_readdirp_entry_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                       int32_t op_ret, int32_t op_errno, inode_t *inode,
+                       struct iatt *buf, dict_t *xattr,
+                       struct iatt *postparent)
+{
+        ec_local_t  *local      = NULL;
+        gf_dirent_t *entry      = NULL;
+        uint64_t     size       = 0;
+        int          call_count = 0;
+
+        local = frame->local;
+        entry = cookie;
+
+        if ((op_ret == 0) && !ec_dict_get_u64 (xattr, EC_XATTR_SIZE, &size))
+                ec_iatt_fix (this, &entry->d_stat, size);
+
+        LOCK (&frame->lock);
+        {
+                call_count = --local->call_count;
+        }
+        UNLOCK (&frame->lock);
+
+        if (!call_count) {
+                EC_STACK_UNWIND (readdirp, frame, local->op_ret,
+                                 local->op_errno, &local->entries);
+                gf_dirent_free (&local->entries);
+        }
+
+        return 0;
+}
+
+/* the sizes of the regular files are in the xattrs of their fragments,
+   they are looked up on the child the entries came from */
+static int
+ec_readdirp_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, gf_dirent_t *entries)
+{
+        ec_local_t  *local = NULL;
+        xlator_t    *child = NULL;
+        gf_dirent_t *entry = NULL;
+        gf_dirent_t *tmp   = NULL;
+        loc_t        loc   = {0, };
+        int          count = 0;
+
+        local = frame->local;
+        child = ((call_frame_t *) cookie)->this;
+
+        local->op_ret   = op_ret;
+        local->op_errno = op_errno;
+
+        if (op_ret <= 0)
+                goto unwind;
+
+        list_splice_init (&entries->list, &local->entries.list);
+
+        list_for_each_entry (entry, &local->entries.list, list)
+                if (IA_ISREG (entry->d_stat.ia_type))
+                        count++;
+
+        if (!count)
+                goto unwind;
+
+        local->xattr_req = dict_new ();
+        if (!local->xattr_req ||
+            dict_set_uint64 (local->xattr_req, EC_XATTR_SIZE, 0))
+                goto unwind;
+
+        /* one more, for the entries winding below */
+        local->call_count = count + 1;
+
+        list_for_each_entry_safe (entry, tmp, &local->entries.list, list) {
+                if (!IA_ISREG (entry->d_stat.ia_type))
+                        continue;
+
+                memset (&loc, 0, sizeof (loc));
+                loc.inode  = inode_new (local->fd->inode->table);
+                loc.parent = inode_ref (local->fd->inode);
+                uuid_copy (loc.gfid, entry->d_stat.ia_gfid);
+                uuid_copy (loc.pargfid, local->fd->inode->gfid);
+                if (!loc.inode ||
+                    inode_path (local->fd->inode, entry->d_name,
+                                (char **) &loc.path) < 0) {
+                        loc_wipe (&loc);
+                        ec_readdirp_entry_cbk (frame, entry, this, -1,
+                                               ENOMEM, NULL, NULL, NULL,
+                                               NULL);
+                        continue;
+                }
+                loc.name = strrchr (loc.path, '/') + 1;
+
+                STACK_WIND_COOKIE (frame, ec_readdirp_entry_cbk, entry,
+                                   child, child->fops->lookup, &loc,
+                                   local->xattr_req);
+                loc_wipe (&loc);
+        }
+
+        ec_readdirp_entry_cbk (frame, NULL, this, -1, 0, NULL, NULL, NULL,
+                               NULL);
+        return 0;
+
+unwind:
+        EC_STACK_UNWIND (readdirp, frame, local->op_ret, local->op_errno,
+                         &local->entries);
+        gf_dirent_free (&local->entries);
+        return 0;
+}
+
+int
+ec_readdirp (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+             off_t offset)
+{
+        ec_private_t *priv     = NULL;
+        ec_local_t   *local    = NULL;
+        int32_t       op_errno = ENOMEM;
+        int           child    = 0;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+
+        priv = this->private;
+
+        child = ec_first (ec_up_children (this));
+        if (child < 0) {
+                op_errno = ENOTCONN;
+                goto err;
+        }
+
+        local = ec_local_init (this);
+        if (!local)
+                goto err;
+
+        frame->local = local;
+        local->fd    = fd_ref (fd);
+        INIT_LIST_HEAD (&local->entries.list);
+
+        STACK_WIND (frame, ec_readdirp_cbk, priv->children[child],
+                    priv->children[child]->fops->readdirp, fd, size, offset);
+        return 0;
+err:
+        EC_STACK_UNWIND (readdirp, frame, -1, op_errno, NULL);
+        return 0;
+}
+
+
+/* the changelog of the fragments is ec's own */
+
+int
+ec_xattrop (call_frame_t *frame, xlator_t *this, loc_t *loc,
+            gf_xattrop_flags_t flags, dict_t *dict)
+{
+        EC_STACK_UNWIND (xattrop, frame, -1, ENOTSUP, NULL);
+        return 0;
+}
+
+int
+ec_fxattrop (call_frame_t *frame, xlator_t *this, fd_t *fd,
+             gf_xattrop_flags_t flags, dict_t *dict)
+{
+        EC_STACK_UNWIND (fxattrop, frame, -1, ENOTSUP, NULL);
+        return 0;
+}
+
+int
+ec_rchecksum (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+              int32_t len)
+{
+        EC_STACK_UNWIND (rchecksum, frame, -1, ENOTSUP, 0, NULL);
+        return 0;
+}
+
+/* the fragments would have to be re-encoded over the range, which a
+   single fop on each child can not do */
+int
+ec_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              int32_t keep_size, off_t offset, size_t len)
+{
+        EC_STACK_UNWIND (fallocate, frame, -1, EOPNOTSUPP, NULL, NULL);
+        return 0;
+}
+
+int
+ec_discard (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+            size_t len)
+{
+        EC_STACK_UNWIND (discard, frame, -1, EOPNOTSUPP, NULL, NULL);
+        return 0;
+}
+
+int
+ec_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+             size_t len)
+{
+        EC_STACK_UNWIND (zerofill, frame, -1, EOPNOTSUPP, NULL, NULL);
+        return 0;
+}
+
+/* a fragment copied as it is would not be the fragment of the
+   destination: EXDEV has the caller stream the data through ec */
+int
+ec_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                    uint32_t flags)
+{
+        EC_STACK_UNWIND (copy_file_range, frame, -1, EXDEV, NULL, NULL,
+                         NULL);
+        return 0;
+}
+
+
+int
+ec_forget (xlator_t *this, inode_t *inode)
+{
+        uint64_t        value = 0;
+        ec_inode_ctx_t *ctx   = NULL;
+
+        inode_ctx_del (inode, this, &value);
+        ctx = (ec_inode_ctx_t *) (long) value;
+        GF_FREE (ctx);
+
+        return 0;
+}
+
+int32_t
+notify (xlator_t *this, int32_t event, void *data, ...)
+{
+        ec_private_t *priv      = NULL;
+        int           i         = 0;
+        int           propagate = 0;
+        int           up        = 0;
+
+        if (!this)
+                return 0;
+
+        priv = this->private;
+        if (!priv)
+                return 0;
+
+        for (i = 0; i < priv->child_count; i++)
+                if (data == priv->children[i])
+                        break;
+
+        switch (event) {
+        case GF_EVENT_CHILD_UP:
+        case GF_EVENT_CHILD_DOWN:
+                if (i == priv->child_count)
+                        break;
+
+                /* the volume is up as long as the data can be read */
+                LOCK (&priv->lock);
+                {
+                        if (event == GF_EVENT_CHILD_UP)
+                                priv->up |= EC_BIT (i);
+                        else
+                                priv->up &= ~EC_BIT (i);
+
+                        up = (ec_count (priv->up) >= priv->fragments);
+                        if (up != priv->notified_up) {
+                                priv->notified_up = up;
+                                propagate = 1;
+                        }
+                }
+                UNLOCK (&priv->lock);
+
+                gf_log (this->name, GF_LOG_INFO, "subvolume %s is %s",
+                        priv->children[i]->name,
+                        (event == GF_EVENT_CHILD_UP) ? "up" : "down");
+
+                if (propagate)
+                        default_notify (this, up ? GF_EVENT_CHILD_UP :
+                                        GF_EVENT_CHILD_DOWN, data);
+                break;
+
+        case GF_EVENT_CHILD_CONNECTING:
+                LOCK (&priv->lock);
+                {
+                        propagate = !priv->notified_up;
+                }
+                UNLOCK (&priv->lock);
+
+                if (propagate)
+                        default_notify (this, event, data);
+                break;
+
+        default:
+                default_notify (this, event, data);
+                break;
+        }
+
+        return 0;
+}
+
+static void
+ec_options_free (struct ec_options *opts)
+{
+        struct ec_options *prev = NULL;
+
+        while (opts) {
+                prev = opts;
+                opts = opts->next;
+                GF_FREE (prev);
+        }
+}
+
+static int
+set_ec_block_size (xlator_t *this, ec_private_t *priv, char *data)
+{
+        int                ret        = -1;
+        char              *tmp_str    = NULL;
+        char              *tmp_str1   = NULL;
+        char              *dup_str    = NULL;
+        char              *ec_str     = NULL;
+        char              *pattern    = NULL;
+        char              *num        = NULL;
+        struct ec_options *temp_ecopt = NULL;
+        struct ec_options *ec_opt     = NULL;
+
+        if (!this || !priv || !data)
+                goto out;
+
+        /* "option block-size *avi:1MB,128KB" etc */
+        ec_str = strtok_r (data, ",", &tmp_str);
+        while (ec_str) {
+                dup_str = gf_strdup (ec_str);
+                ec_opt = GF_CALLOC (1, sizeof (struct ec_options),
+                                    gf_ec_mt_ec_options);
+                if (!dup_str || !ec_opt) {
+                        GF_FREE (dup_str);
+                        GF_FREE (ec_opt);
+                        goto out;
+                }
+
+                pattern = strtok_r (dup_str, ":", &tmp_str1);
+                num = strtok_r (NULL, ":", &tmp_str1);
+                if (!num) {
+                        num = pattern;
+                        pattern = "*";
+                }
+                if (gf_string2bytesize (num, &ec_opt->block_size) != 0) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "invalid number format \"%s\"", num);
+                        goto err;
+                }
+
+                if (ec_opt->block_size < 512 || ec_opt->block_size % 512) {
+                        gf_log (this->name, GF_LOG_ERROR, "Block-size: %s "
+                                "should be a multiple of 512 bytes", num);
+                        goto err;
+                }
+
+                strncpy (ec_opt->path_pattern, pattern,
+                         sizeof (ec_opt->path_pattern) - 1);
+
+                gf_log (this->name, GF_LOG_DEBUG,
+                        "block-size : pattern %s : size %"PRIu64,
+                        ec_opt->path_pattern, ec_opt->block_size);
+
+                if (!priv->pattern) {
+                        priv->pattern = ec_opt;
+                } else {
+                        temp_ecopt = priv->pattern;
+                        while (temp_ecopt->next)
+                                temp_ecopt = temp_ecopt->next;
+                        temp_ecopt->next = ec_opt;
+                }
+                ec_str = strtok_r (NULL, ",", &tmp_str);
+                GF_FREE (dup_str);
+        }
+
+        ret = 0;
+out:
+        return ret;
+err:
+        GF_FREE (dup_str);
+        GF_FREE (ec_opt);
+        return -1;
+}
+
+int32_t
+ec_priv_dump (xlator_t *this)
+{
+        char               key[GF_DUMP_MAX_BUF_LEN];
+        ec_private_t      *priv    = NULL;
+        struct ec_options *options = NULL;
+        int                ret     = -1;
+        int                i       = 0;
+
+        GF_VALIDATE_OR_GOTO ("ec", this, out);
+
+        priv = this->private;
+        if (!priv)
+                goto out;
+
+        ret = TRY_LOCK (&priv->lock);
+        if (ret != 0)
+                goto out;
+
+        gf_proc_dump_add_section ("xlator.cluster.ec.%s.priv", this->name);
+        gf_proc_dump_write ("child_count", "%d", priv->child_count);
+        gf_proc_dump_write ("fragments", "%d", priv->fragments);
+        gf_proc_dump_write ("redundancy", "%d", priv->redundancy);
+
+        for (i = 0; i < priv->child_count; i++) {
+                sprintf (key, "child_up[%d]", i);
+                gf_proc_dump_write (key, "%d",
+                                    !!(priv->up & EC_BIT (i)));
+        }
+
+        options = priv->pattern;
+        while (options != NULL) {
+                gf_proc_dump_write ("path_pattern", "%s",
+                                    options->path_pattern);
+                gf_proc_dump_write ("options_block_size", "%"PRIu64,
+                                    options->block_size);
+                options = options->next;
+        }
+
+        gf_proc_dump_write ("self_heal", "%d", priv->self_heal);
+        gf_proc_dump_write ("degraded_reads", "%"PRIu64,
+                            priv->degraded_reads);
+        gf_proc_dump_write ("heals_started", "%"PRIu64, priv->heals_started);
+        gf_proc_dump_write ("heals_done", "%"PRIu64, priv->heals_done);
+
+        UNLOCK (&priv->lock);
+out:
+        return ret;
+}
+
+int32_t
+mem_acct_init (xlator_t *this)
+{
+        int     ret = -1;
+
+        if (!this)
+                goto out;
+
+        ret = xlator_mem_acct_init (this, gf_ec_mt_end + 1);
+
+        if (ret != 0) {
+                gf_log (this->name, GF_LOG_ERROR, "Memory accounting init"
+                        "failed");
+                goto out;
+        }
+
+out:
+        return ret;
+}
+
+int
+reconfigure (xlator_t *this, dict_t *options)
+{
+        ec_private_t *priv = NULL;
+        int           ret  = -1;
+
+        priv = this->private;
+
+        GF_OPTION_RECONF ("self-heal", priv->self_heal, options, bool, out);
+
+        ret = 0;
+out:
+        return ret;
+}
+
+int32_t
+init (xlator_t *this)
+{
+        ec_private_t  *priv       = NULL;
+        xlator_list_t *trav       = NULL;
+        char          *block_size = NULL;
+        int32_t        count      = 0;
+        int            ret        = -1;
+
+        if (!this)
+                goto out;
+
+        trav = this->children;
+        while (trav) {
+                count++;
+                trav = trav->next;
+        }
+
+        if (count < 2) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "ec needs at least two subvolumes. exiting");
+                goto out;
+        }
+
+        if (count > EC_MAX_CHILDREN) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "maximum number of ec subvolumes supported is %d",
+                        EC_MAX_CHILDREN);
+                goto out;
+        }
+
+        if (!this->parents) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "dangling volume. check volfile ");
+        }
+
+        priv = GF_CALLOC (1, sizeof (ec_private_t), gf_ec_mt_ec_private_t);
+        if (!priv)
+                goto out;
+
+        LOCK_INIT (&priv->lock);
+
+        priv->children = GF_CALLOC (count, sizeof (xlator_t *),
+                                    gf_ec_mt_xlator_t);
+        if (!priv->children)
+                goto out;
+
+        priv->child_count = count;
+        count = 0;
+        trav = this->children;
+        while (trav) {
+                priv->children[count++] = trav->xlator;
+                trav = trav->next;
+        }
+
+        GF_OPTION_INIT ("redundancy", priv->redundancy, int32, out);
+        if (priv->redundancy < 1 || priv->redundancy >= priv->child_count) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "redundancy %d is not possible with %d subvolumes",
+                        priv->redundancy, priv->child_count);
+                goto out;
+        }
+        priv->fragments = priv->child_count - priv->redundancy;
+
+        priv->matrix = GF_CALLOC (priv->child_count, priv->fragments,
+                                  gf_ec_mt_uint8_t);
+        if (!priv->matrix)
+                goto out;
+        ec_gf_matrix_build (priv->matrix, priv->fragments, priv->redundancy);
+
+        /* option block-size *avi:1MB,128KB */
+        GF_OPTION_INIT ("block-size", block_size, str, out);
+        block_size = gf_strdup (block_size);
+        if (!block_size)
+                goto out;
+        ret = set_ec_block_size (this, priv, block_size);
+        GF_FREE (block_size);
+        if (ret)
+                goto out;
+        ret = -1;
+
+        priv->block_size = ec_get_matching_bs ("/", priv->pattern,
+                                               128 * GF_UNIT_KB);
+
+        GF_OPTION_INIT ("self-heal", priv->self_heal, bool, out);
+
+        gf_log (this->name, GF_LOG_INFO, "%d data and %d parity fragments "
+                "per stripe", priv->fragments, priv->redundancy);
+
+        this->private = priv;
+        ret = 0;
+out:
+        if (ret && priv) {
+                ec_options_free (priv->pattern);
+                GF_FREE (priv->matrix);
+                GF_FREE (priv->children);
+                LOCK_DESTROY (&priv->lock);
+                GF_FREE (priv);
+        }
+        return ret;
+}
+
+void
+fini (xlator_t *this)
+{
+        ec_private_t *priv = NULL;
+
+        if (!this)
+                goto out;
+
+        priv = this->private;
+        if (priv) {
+                this->private = NULL;
+                GF_FREE (priv->children);
+                GF_FREE (priv->matrix);
+                ec_options_free (priv->pattern);
+                LOCK_DESTROY (&priv->lock);
+                GF_FREE (priv);
+        }
+
+out:
+        return;
+}
+
+struct xlator_fops fops = {
+        .lookup      = ec_lookup,
+        .stat        = ec_stat,
+        .fstat       = ec_fstat,
+        .readv       = ec_readv,
+        .writev      = ec_writev,
+        .truncate    = ec_truncate,
+        .ftruncate   = ec_ftruncate,
+        .open        = ec_open,
+        .create      = ec_create,
+        .mknod       = ec_mknod,
+        .mkdir       = ec_mkdir,
+        .symlink     = ec_symlink,
+        .link        = ec_link,
+        .unlink      = ec_unlink,
+        .rmdir       = ec_rmdir,
+        .rename      = ec_rename,
+        .setxattr    = ec_setxattr,
+        .fsetxattr   = ec_fsetxattr,
+        .getxattr    = ec_getxattr,
+        .fgetxattr   = ec_fgetxattr,
+        .removexattr = ec_removexattr,
+        .flush       = ec_flush,
+        .fsync       = ec_fsync,
+        .fsyncdir    = ec_fsyncdir,
+        .setattr     = ec_setattr,
+        .fsetattr    = ec_fsetattr,
+        .opendir     = ec_opendir,
+        .readdir     = ec_readdir,
+        .readdirp    = ec_readdirp,
+        .access      = ec_access,
+        .readlink    = ec_readlink,
+        .statfs      = ec_statfs,
+        .lk          = ec_lk,
+        .inodelk     = ec_inodelk,
+        .finodelk    = ec_finodelk,
+        .entrylk     = ec_entrylk,
+        .fentrylk    = ec_fentrylk,
+        .xattrop     = ec_xattrop,
+        .fxattrop    = ec_fxattrop,
+        .rchecksum   = ec_rchecksum,
+        .fallocate   = ec_fallocate,
+        .discard     = ec_discard,
+        .zerofill    = ec_zerofill,
+        .copy_file_range = ec_copy_file_range,
+};
+
+struct xlator_cbks cbks = {
+        .forget = ec_forget,
+};
+
+struct xlator_dumpops dumpops = {
+        .priv = ec_priv_dump,
+};
+
+struct volume_options options[] = {
+        { .key  = {"redundancy"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 1,
+          .max  = EC_MAX_CHILDREN - 1,
+          .default_value = "1",
+          .description = "Number of parity fragments of every stripe, "
+                         "that is the number of subvolumes which can be "
+                         "lost without losing data."
+        },
+        { .key  = {"block-size"},
+          .type = GF_OPTION_TYPE_ANY,
+          .default_value = "128KB",
+          .description = "Size of the fragment of a stripe written to "
+                         "every subvolume, optionally per path pattern as "
+                         "in \"*.avi:1MB,128KB\"."
+        },
+        { .key  = {"self-heal"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "on",
+          .description = "Rebuild stale and missing fragments found by "
+                         "lookup in the background."
+        },
+        { .key  = {NULL} },
+};
@@ -0,0 +1,277 @@
+/*
+  Copyright (c) 2012 Gluster, Inc. <http://www.gluster.com>
+  This file is part of GlusterFS.
+
+  GlusterFS is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published
+  by the Free Software Foundation; either version 3 of the License,
+  or (at your option) any later version.
+
+  GlusterFS is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _EC_H_
+#define _EC_H_
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include "xlator.h"
+#include "logging.h"
+#include "defaults.h"
+#include "common-utils.h"
+#include "compat.h"
+#include "compat-errno.h"
+#include "ec-mem-types.h"
+#include "ec-gf.h"
+
+/* kept on every fragment of a regular file, as 8 byte big endian numbers */
+#define EC_XATTR_SIZE       "trusted.ec.size"
+#define EC_XATTR_VERSION    "trusted.ec.version"
+#define EC_XATTR_BLOCK_SIZE "trusted.ec.block-size"
+/* updates in flight on the fragment: raised by the pre-op of a write,
+   lowered by its post-op. Left raised, the fragment may hold data newer
+   than its version */
+#define EC_XATTR_DIRTY      "trusted.ec.dirty"
+
+/* children are tracked in 64 bit masks */
+#define EC_MAX_CHILDREN     64
+
+/* amount of every fragment healed in one round */
+#define EC_HEAL_FRAGMENT_SIZE (1024 * 1024)
+
+#define EC_BIT(i)           (1ULL << (i))
+
+/* winds the fop to every child of local->wind, with the child index as
+   cookie */
+#define EC_WIND(frame, local, priv, cbk, fop, args ...) do {                \
+                int __i     = 0;                                        \
+                int __count = ec_count ((local)->wind);                 \
+                for (__i = 0; __i < (priv)->child_count; __i++) {       \
+                        if (!((local)->wind & EC_BIT (__i)))            \
+                                continue;                               \
+                        STACK_WIND_COOKIE (frame, cbk, (void *) (long) __i, \
+                                           (priv)->children[__i],       \
+                                           (priv)->children[__i]->fops->fop, \
+                                           args);                       \
+                        if (!--__count)                                 \
+                                break;                                  \
+                }                                                       \
+        } while (0)
+
+#define EC_STACK_UNWIND(fop, frame, params ...) do {            \
+                ec_local_t *__local = NULL;                     \
+                if (frame) {                                    \
+                        __local = frame->local;                 \
+                        frame->local = NULL;                    \
+                }                                               \
+                STACK_UNWIND_STRICT (fop, frame, params);       \
+                if (__local) {                                  \
+                        ec_local_wipe (__local);                \
+                        GF_FREE (__local);                      \
+                }                                               \
+        } while (0)
+
+#define EC_STACK_DESTROY(frame) do {                            \
+                ec_local_t *__local = NULL;                     \
+                __local = frame->local;                         \
+                frame->local = NULL;                            \
+                STACK_DESTROY (frame->root);                    \
+                if (__local) {                                  \
+                        ec_local_wipe (__local);                \
+                        GF_FREE (__local);                      \
+                }                                               \
+        } while (0)
+
+/**
+ * struct ec_options : the pattern and block-size pairs of the block-size
+ *     option, as in cluster/stripe.
+ */
+struct ec_options {
+        struct ec_options *next;
+        char               path_pattern[256];
+        uint64_t           block_size;
+};
+
+/**
+ * Private structure for the ec translator. The data of every stripe of
+ * fragments * block_size bytes is split in 'fragments' blocks to which
+ * 'redundancy' parity blocks are added, one block on every child.
+ */
+typedef struct {
+        xlator_t          **children;
+        int                 child_count;
+        int                 fragments;
+        int                 redundancy;
+        uint64_t            up;
+        uint8_t            *matrix;
+        struct ec_options  *pattern;
+        uint64_t            block_size;
+        gf_boolean_t        self_heal;
+        gf_boolean_t        notified_up;
+        uint64_t            degraded_reads;
+        uint64_t            heals_started;
+        uint64_t            heals_done;
+        gf_lock_t           lock;
+} ec_private_t;
+
+/**
+ * Per inode state: the size of the file as seen above ec and the
+ * children whose fragments are known to be stale.
+ */
+typedef struct {
+        uint64_t            size;
+        uint64_t            block_size;
+        uint64_t            bad;
+        gf_boolean_t        size_known;
+        gf_boolean_t        healing;
+} ec_inode_ctx_t;
+
+struct ec_local;
+typedef struct ec_local ec_local_t;
+
+typedef int (*ec_local_fn_t) (call_frame_t *frame, xlator_t *this);
+
+struct ec_local {
+        int32_t             op_ret;
+        int32_t             op_errno;
+        int                 call_count;
+        int                 child_count;
+        int                 state;
+        gf_boolean_t        nolock;
+        ec_local_fn_t       unwind;
+
+        uint64_t            wind;          /* children the fop went to */
+        uint64_t            success;       /* children it succeeded on */
+        uint64_t            good;          /* children with current data */
+        uint64_t            locked;
+        uint64_t            done;          /* children the update reached */
+        int                 lock_child;
+
+        loc_t               loc;
+        loc_t               loc2;
+        fd_t               *fd;
+        inode_t            *inode;
+        dict_t             *xattr;
+        dict_t             *xattr_req;
+        int32_t             flags;
+        mode_t              mode;
+        size_t              size;
+        off_t               offset;
+
+        struct iatt         stbuf;
+        struct iatt         prebuf;
+        struct iatt         postbuf;
+        struct iatt         preparent;
+        struct iatt         postparent;
+        struct iatt         preparent2;
+        struct iatt         postparent2;
+        struct statvfs      statvfs;
+        struct gf_flock     flock;
+        gf_dirent_t         entries;
+
+        /* per child view of the file */
+        struct iatt        *iatts;
+        uint64_t           *versions;
+        uint64_t           *sizes;
+        uint64_t           *block_sizes;
+        uint64_t           *dirties;
+        int32_t            *errnos;
+
+        /* transaction */
+        uint64_t            file_size;     /* before the update */
+        uint64_t            new_size;
+        uint64_t            version;       /* of the good children */
+        uint64_t            max_version;   /* of any child, new versions
+                                              go above it */
+        uint64_t            new_version;
+        uint64_t            block_size;
+        ec_local_fn_t       transaction_fn;
+        gf_boolean_t        update;        /* the pre-op marks dirty */
+        gf_boolean_t        clear_dirty;   /* the post-op clears all of
+                                              it, not only its own */
+
+        /* stripes read with ec_stripe_read */
+        off_t               read_stripe;
+        int                 read_count;
+        uint64_t            reading;
+        uint64_t            read_failed;
+        uint8_t           **frags;
+        uint8_t            *rbuf;
+        ec_local_fn_t       read_done;
+        ec_local_fn_t       read_degraded; /* called instead of decoding
+                                              without a lock */
+
+        /* writes */
+        struct iovec       *vector;
+        int32_t             count;
+        struct iobref      *iobref;
+        uint8_t            *wbuf;
+        off_t               write_stripe;
+        int                 write_count;
+        uint8_t           **wfrags;
+        struct iovec       *wvec;
+        struct iobref      *wiobref;
+        gf_boolean_t        head_read;
+
+        /* heal */
+        uint64_t            heal;          /* children being healed */
+        uint64_t            missing;       /* children without the entry */
+        uint64_t            heal_fragment_size;
+};
+
+void ec_local_wipe (ec_local_t *local);
+
+ec_local_t *ec_local_init (xlator_t *this);
+
+int ec_count (uint64_t mask);
+
+ec_inode_ctx_t *ec_inode_ctx_get (xlator_t *this, inode_t *inode);
+
+int ec_inode_ctx_size (xlator_t *this, inode_t *inode, uint64_t *size,
+                       uint64_t *block_size, uint64_t *bad);
+
+int ec_new_file_xattrs (dict_t *params, uint64_t block_size);
+
+uint64_t ec_get_matching_bs (const char *path, struct ec_options *opts,
+                             uint64_t default_bs);
+
+uint64_t ec_up_children (xlator_t *this);
+
+int ec_transaction (call_frame_t *frame, xlator_t *this, uint64_t children);
+
+int ec_preop (call_frame_t *frame, xlator_t *this);
+
+int ec_unlock (call_frame_t *frame, xlator_t *this);
+
+int ec_postop (call_frame_t *frame, xlator_t *this);
+
+int ec_stripe_read (call_frame_t *frame, xlator_t *this, off_t stripe,
+                    int count, ec_local_fn_t done);
+
+int ec_stripe_encode (xlator_t *this, ec_local_t *local, uint8_t *buf,
+                      int count, uint8_t **frags);
+
+int ec_fragments_write (call_frame_t *frame, xlator_t *this, uint64_t mask,
+                        off_t offset, size_t len, fop_writev_cbk_t cbk);
+
+int ec_frags_alloc (int child_count, uint8_t ***frags_p, uint64_t mask,
+                    size_t len);
+
+void ec_frags_free (int child_count, uint8_t ***frags_p);
+
+void ec_iatt_fix (xlator_t *this, struct iatt *buf, uint64_t size);
+
+void ec_heal (xlator_t *this, loc_t *loc, struct iatt *buf, uint64_t bad,
+              uint64_t missing);
+
+#endif /* _EC_H_ */
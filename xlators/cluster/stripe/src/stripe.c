@@ -3366,6 +3366,246 @@ err:
         return 0;
 }
 
+/* fallocate and zerofill are split on the stripe blocks like a write, each
+   child allocating only the blocks it holds; a discard is sent whole to
+   every child, the blocks of the others being holes there already */
+int32_t
+stripe_fallocate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                      int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                      struct iatt *postbuf)
+{
+        int32_t         callcnt = 0;
+        stripe_local_t *local = NULL;
+        call_frame_t   *prev = NULL;
+
+        if (!this || !frame || !frame->local || !cookie) {
+                gf_log ("stripe", GF_LOG_DEBUG, "possible NULL deref");
+                goto out;
+        }
+
+        prev  = cookie;
+        local = frame->local;
+
+        LOCK(&frame->lock);
+        {
+                callcnt = ++local->call_count;
+
+                if (op_ret == -1) {
+                        gf_log (this->name, GF_LOG_DEBUG,
+                                "%s returned error %s",
+                                prev->this->name, strerror (op_errno));
+                        local->op_errno = op_errno;
+                        local->op_ret = -1;
+                }
+                if (op_ret == 0) {
+                        local->post_buf = *postbuf;
+                        local->pre_buf = *prebuf;
+
+                        if (local->prebuf_size < prebuf->ia_size)
+                                local->prebuf_size = prebuf->ia_size;
+
+                        if (local->postbuf_size < postbuf->ia_size)
+                                local->postbuf_size = postbuf->ia_size;
+                }
+        }
+        UNLOCK (&frame->lock);
+
+        if ((callcnt == local->wind_count) && local->unwind) {
+                if (local->op_ret != -1) {
+                        local->pre_buf.ia_size  = local->prebuf_size;
+                        local->post_buf.ia_size = local->postbuf_size;
+                }
+
+                STRIPE_STACK_UNWIND (fallocate, frame, local->op_ret,
+                                     local->op_errno, &local->pre_buf,
+                                     &local->post_buf);
+        }
+out:
+        return 0;
+}
+
+
+static int32_t
+stripe_do_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                     glusterfs_fop_t fop, int32_t keep_size, off_t offset,
+                     size_t len)
+{
+        stripe_local_t   *local = NULL;
+        stripe_fd_ctx_t  *fctx = NULL;
+        int32_t           op_errno = 1;
+        int32_t           idx = 0;
+        off_t             offset_offset = 0;
+        off_t             remaining_size = 0;
+        off_t             fill_size = 0;
+        uint64_t          tmp_fctx = 0;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+        VALIDATE_OR_GOTO (fd->inode, err);
+
+        fd_ctx_get (fd, this, &tmp_fctx);
+        if (!tmp_fctx) {
+                op_errno = EINVAL;
+                goto err;
+        }
+        fctx = (stripe_fd_ctx_t *)(long)tmp_fctx;
+
+        remaining_size = len;
+
+        local = GF_CALLOC (1, sizeof (stripe_local_t),
+                           gf_stripe_mt_stripe_local_t);
+        if (!local) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+        frame->local = local;
+        local->stripe_size = fctx->stripe_size;
+
+        while (1) {
+                idx = (((offset + offset_offset) /
+                        local->stripe_size) % fctx->stripe_count);
+
+                fill_size = (local->stripe_size -
+                             ((offset + offset_offset) % local->stripe_size));
+                if (fill_size > remaining_size)
+                        fill_size = remaining_size;
+
+                remaining_size -= fill_size;
+
+                local->wind_count++;
+                if (remaining_size == 0)
+                        local->unwind = 1;
+
+                if (fop == GF_FOP_FALLOCATE)
+                        STACK_WIND (frame, stripe_fallocate_cbk,
+                                    fctx->xl_array[idx],
+                                    fctx->xl_array[idx]->fops->fallocate, fd,
+                                    keep_size, offset + offset_offset,
+                                    fill_size);
+                else
+                        STACK_WIND (frame, stripe_fallocate_cbk,
+                                    fctx->xl_array[idx],
+                                    fctx->xl_array[idx]->fops->zerofill, fd,
+                                    offset + offset_offset, fill_size);
+
+                offset_offset += fill_size;
+                if (remaining_size == 0)
+                        break;
+        }
+
+        return 0;
+err:
+        STRIPE_STACK_UNWIND (fallocate, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+stripe_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                  int32_t keep_size, off_t offset, size_t len)
+{
+        return stripe_do_fallocate (frame, this, fd, GF_FOP_FALLOCATE,
+                                    keep_size, offset, len);
+}
+
+
+int32_t
+stripe_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+                 size_t len)
+{
+        return stripe_do_fallocate (frame, this, fd, GF_FOP_ZEROFILL, 0,
+                                    offset, len);
+}
+
+
+int32_t
+stripe_discard (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+                size_t len)
+{
+        stripe_local_t   *local = NULL;
+        stripe_private_t *priv = NULL;
+        xlator_list_t    *trav = NULL;
+        int32_t           op_errno = 1;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd, err);
+        VALIDATE_OR_GOTO (fd->inode, err);
+
+        priv = this->private;
+        trav = this->children;
+
+        /* Initialization */
+        local = GF_CALLOC (1, sizeof (stripe_local_t),
+                           gf_stripe_mt_stripe_local_t);
+        if (!local) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+        local->op_ret = -1;
+        frame->local = local;
+        local->call_count = priv->child_count;
+
+        while (trav) {
+                STACK_WIND (frame, stripe_truncate_cbk, trav->xlator,
+                            trav->xlator->fops->discard, fd, offset, len);
+                trav = trav->next;
+        }
+
+        return 0;
+err:
+        STRIPE_STACK_UNWIND (discard, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+stripe_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                            int32_t op_ret, int32_t op_errno,
+                            struct iatt *stbuf_in, struct iatt *prebuf,
+                            struct iatt *postbuf)
+{
+        STRIPE_STACK_UNWIND (copy_file_range, frame, op_ret, op_errno,
+                             stbuf_in, prebuf, postbuf);
+        return 0;
+}
+
+
+/* the blocks of the source and the destination are on the same child
+   only by chance, so the copy is read and written through stripe */
+int32_t
+stripe_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                        off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                        uint32_t flags)
+{
+        int32_t op_errno = EINVAL;
+        int     ret      = -1;
+
+        VALIDATE_OR_GOTO (frame, err);
+        VALIDATE_OR_GOTO (this, err);
+        VALIDATE_OR_GOTO (fd_in, err);
+        VALIDATE_OR_GOTO (fd_out, err);
+
+        if (flags)
+                goto err;
+
+        ret = cluster_copy_file_range_stream (frame, this, this, fd_in,
+                                              off_in, this, fd_out, off_out,
+                                              len, stripe_copy_file_range_cbk);
+        if (ret) {
+                op_errno = ENOMEM;
+                goto err;
+        }
+
+        return 0;
+err:
+        STRIPE_STACK_UNWIND (copy_file_range, frame, -1, op_errno, NULL, NULL,
+                             NULL);
+        return 0;
+}
+
+
 
 int32_t
 stripe_fsyncdir_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
@@ -4975,6 +5215,10 @@ struct xlator_fops fops = {
         .flush       = stripe_flush,
         .fsync       = stripe_fsync,
         .ftruncate   = stripe_ftruncate,
+        .fallocate   = stripe_fallocate,
+        .discard     = stripe_discard,
+        .zerofill    = stripe_zerofill,
+        .copy_file_range = stripe_copy_file_range,
         .fstat       = stripe_fstat,
         .mkdir       = stripe_mkdir,
         .rmdir       = stripe_rmdir,
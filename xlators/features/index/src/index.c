@@ -0,0 +1,844 @@
+/*
+   Copyright (c) 2010-2011 Gluster, Inc. <http://www.gluster.com>
+   This file is part of GlusterFS.
+
+   GlusterFS is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 3 of the License,
+   or (at your option) any later version.
+
+   GlusterFS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see
+   <http://www.gnu.org/licenses/>.
+*/
+
+/* Brick side index of the files which need self-heal.
+ *
+ * Sits right above storage/posix and watches the xattrops of replicate's
+ * changelog. When an xattrop leaves a non zero trusted.afr.* count on a
+ * file, the file's gfid is entered in <index-base>/xattrop as a hard link
+ * to a common base file. When an xattrop leaves all the counts zero and no
+ * other xattrop is in flight on the inode, the entry is dropped again.
+ *
+ * The index directory is exported through a virtual gfid, which is
+ * fetched with a getxattr of GF_XATTROP_INDEX_GFID on any inode. A
+ * nameless lookup, opendir and readdir(p) of that gfid list the gfids of
+ * the index, so the self-heal daemon needs to look up only those files
+ * instead of crawling the whole namespace.
+ */
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include "index.h"
+#include "defaults.h"
+#include "statedump.h"
+
+
+static int
+index_mkdir_p (xlator_t *this, const char *path)
+{
+        char        *dup = NULL;
+        char        *p   = NULL;
+        int          ret = -1;
+
+        dup = gf_strdup (path);
+        if (!dup)
+                goto out;
+
+        for (p = dup + 1; ; p++) {
+                if (*p != '/' && *p != '\0')
+                        continue;
+
+                if (*p == '/')
+                        *p = '\0';
+                else
+                        p = NULL;
+
+                ret = mkdir (dup, 0700);
+                if (ret && errno != EEXIST) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "mkdir of %s failed (%s)", dup,
+                                strerror (errno));
+                        goto out;
+                }
+                ret = 0;
+
+                if (!p)
+                        break;
+                *p = '/';
+        }
+out:
+        GF_FREE (dup);
+        return ret;
+}
+
+
+static void
+index_path (index_priv_t *priv, const char *name, char *path, size_t len)
+{
+        snprintf (path, len, "%s/%s/%s", priv->index_basepath,
+                  XATTROP_SUBDIR, name);
+}
+
+
+static int
+index_create_base (xlator_t *this)
+{
+        index_priv_t *priv = NULL;
+        char          path[PATH_MAX];
+        int           fd   = -1;
+
+        priv = this->private;
+
+        index_path (priv, XATTROP_BASE, path, sizeof (path));
+
+        fd = open (path, O_CREAT | O_RDWR, 0600);
+        if (fd < 0) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "creating %s failed (%s)", path, strerror (errno));
+                return -1;
+        }
+
+        close (fd);
+        return 0;
+}
+
+
+static void
+index_add (xlator_t *this, uuid_t gfid)
+{
+        index_priv_t *priv = NULL;
+        char          base[PATH_MAX];
+        char          path[PATH_MAX];
+        int           ret  = -1;
+
+        priv = this->private;
+
+        index_path (priv, XATTROP_BASE, base, sizeof (base));
+        index_path (priv, uuid_utoa (gfid), path, sizeof (path));
+
+        ret = link (base, path);
+        if (ret && errno == ENOENT) {
+                /* the base was removed from under us */
+                if (index_create_base (this) == 0)
+                        ret = link (base, path);
+        }
+
+        if (ret && errno != EEXIST) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "adding %s to the index failed (%s)",
+                        uuid_utoa (gfid), strerror (errno));
+                return;
+        }
+
+        if (ret == 0) {
+                LOCK (&priv->lock);
+                {
+                        priv->added++;
+                }
+                UNLOCK (&priv->lock);
+        }
+}
+
+
+static void
+index_del (xlator_t *this, uuid_t gfid)
+{
+        index_priv_t *priv = NULL;
+        char          path[PATH_MAX];
+        int           ret  = -1;
+
+        priv = this->private;
+
+        index_path (priv, uuid_utoa (gfid), path, sizeof (path));
+
+        ret = unlink (path);
+        if (ret && errno != ENOENT) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "removing %s from the index failed (%s)",
+                        uuid_utoa (gfid), strerror (errno));
+                return;
+        }
+
+        if (ret == 0) {
+                LOCK (&priv->lock);
+                {
+                        priv->removed++;
+                }
+                UNLOCK (&priv->lock);
+        }
+}
+
+
+static void
+_check_changelog_key (dict_t *dict, char *key, data_t *value, void *data)
+{
+        int *matched = data;
+
+        if (strncmp (key, INDEX_XATTROP_PREFIX,
+                     strlen (INDEX_XATTROP_PREFIX)) == 0)
+                *matched = 1;
+}
+
+
+static void
+_check_changelog_dirty (dict_t *dict, char *key, data_t *value, void *data)
+{
+        int *dirty = data;
+        int  i     = 0;
+
+        if (strncmp (key, INDEX_XATTROP_PREFIX,
+                     strlen (INDEX_XATTROP_PREFIX)) != 0)
+                return;
+
+        for (i = 0; i < value->len; i++) {
+                if (value->data[i]) {
+                        *dirty = 1;
+                        return;
+                }
+        }
+}
+
+
+static index_inode_ctx_t *
+__index_inode_ctx_get (xlator_t *this, inode_t *inode)
+{
+        index_inode_ctx_t *ctx   = NULL;
+        uint64_t           value = 0;
+
+        if (__inode_ctx_get (inode, this, &value) == 0)
+                return (index_inode_ctx_t *)(long) value;
+
+        ctx = GF_CALLOC (1, sizeof (*ctx), gf_index_mt_inode_ctx_t);
+        if (!ctx)
+                return NULL;
+
+        if (__inode_ctx_put (inode, this, (uint64_t)(long) ctx) != 0) {
+                GF_FREE (ctx);
+                return NULL;
+        }
+
+        return ctx;
+}
+
+
+/* Counts the xattrop in flight on @inode, returns 0 when @dict does not
+ * carry the changelog and the xattrop is of no interest to the index. */
+static int
+index_xattrop_track (xlator_t *this, inode_t *inode, dict_t *dict)
+{
+        index_inode_ctx_t *ctx     = NULL;
+        int                matched = 0;
+
+        if (!inode || !dict)
+                return 0;
+
+        dict_foreach (dict, _check_changelog_key, &matched);
+        if (!matched)
+                return 0;
+
+        LOCK (&inode->lock);
+        {
+                ctx = __index_inode_ctx_get (this, inode);
+                if (ctx)
+                        ctx->in_flight++;
+        }
+        UNLOCK (&inode->lock);
+
+        return (ctx != NULL);
+}
+
+
+/* @xattr holds the counts after the xattrop, NULL if it failed.
+ *
+ * Whether the entry is to be added or dropped is decided under the inode
+ * lock, the link or unlink is done out of it. A thread finding another
+ * one at it leaves its decision in the ctx, and the one at it applies the
+ * latest decision before it leaves, so that the entry ends up as the last
+ * xattrop left it. */
+static void
+index_xattrop_done (xlator_t *this, inode_t *inode, dict_t *xattr)
+{
+        index_inode_ctx_t *ctx   = NULL;
+        int                dirty = 0;
+        int                op    = INDEX_OP_NONE;
+        uuid_t             gfid  = {0, };
+
+        if (xattr)
+                dict_foreach (xattr, _check_changelog_dirty, &dirty);
+
+        LOCK (&inode->lock);
+        {
+                ctx = __index_inode_ctx_get (this, inode);
+                if (!ctx)
+                        goto unlock;
+
+                if (ctx->in_flight)
+                        ctx->in_flight--;
+
+                if (xattr && !uuid_is_null (inode->gfid)) {
+                        /* a concurrent xattrop may still be in its pre-op,
+                           keep the entry until the last one is done */
+                        if (dirty)
+                                ctx->pending = INDEX_OP_ADD;
+                        else if (!ctx->in_flight)
+                                ctx->pending = INDEX_OP_DEL;
+                }
+
+                if (ctx->busy || (ctx->pending == INDEX_OP_NONE))
+                        goto unlock;
+
+                ctx->busy = _gf_true;
+                uuid_copy (gfid, inode->gfid);
+        }
+unlock:
+        UNLOCK (&inode->lock);
+
+        if (uuid_is_null (gfid))
+                return;
+
+        for (;;) {
+                LOCK (&inode->lock);
+                {
+                        op = ctx->pending;
+                        ctx->pending = INDEX_OP_NONE;
+                        if (op == INDEX_OP_NONE)
+                                ctx->busy = _gf_false;
+                }
+                UNLOCK (&inode->lock);
+
+                if (op == INDEX_OP_ADD)
+                        index_add (this, gfid);
+                else if (op == INDEX_OP_DEL)
+                        index_del (this, gfid);
+                else
+                        break;
+        }
+}
+
+
+int32_t
+index_xattrop_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno, dict_t *xattr)
+{
+        inode_t *inode = NULL;
+
+        inode = frame->local;
+        frame->local = NULL;
+
+        if (inode) {
+                index_xattrop_done (this, inode,
+                                    (op_ret == 0) ? xattr : NULL);
+                inode_unref (inode);
+        }
+
+        STACK_UNWIND_STRICT (xattrop, frame, op_ret, op_errno, xattr);
+        return 0;
+}
+
+
+int32_t
+index_fxattrop_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, dict_t *xattr)
+{
+        inode_t *inode = NULL;
+
+        inode = frame->local;
+        frame->local = NULL;
+
+        if (inode) {
+                index_xattrop_done (this, inode,
+                                    (op_ret == 0) ? xattr : NULL);
+                inode_unref (inode);
+        }
+
+        STACK_UNWIND_STRICT (fxattrop, frame, op_ret, op_errno, xattr);
+        return 0;
+}
+
+
+int32_t
+index_xattrop (call_frame_t *frame, xlator_t *this, loc_t *loc,
+               gf_xattrop_flags_t flags, dict_t *dict)
+{
+        if (index_xattrop_track (this, loc->inode, dict))
+                frame->local = inode_ref (loc->inode);
+
+        STACK_WIND (frame, index_xattrop_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->xattrop, loc, flags, dict);
+        return 0;
+}
+
+
+int32_t
+index_fxattrop (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                gf_xattrop_flags_t flags, dict_t *dict)
+{
+        if (index_xattrop_track (this, fd->inode, dict))
+                frame->local = inode_ref (fd->inode);
+
+        STACK_WIND (frame, index_fxattrop_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fxattrop, fd, flags, dict);
+        return 0;
+}
+
+
+static int
+index_is_virtual (xlator_t *this, loc_t *loc)
+{
+        index_priv_t *priv = NULL;
+
+        priv = this->private;
+
+        if (!uuid_is_null (loc->gfid))
+                return !uuid_compare (loc->gfid, priv->xattrop_vgfid);
+        if (loc->inode && !uuid_is_null (loc->inode->gfid))
+                return !uuid_compare (loc->inode->gfid, priv->xattrop_vgfid);
+
+        return 0;
+}
+
+
+int32_t
+index_getxattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                const char *name)
+{
+        index_priv_t *priv     = NULL;
+        dict_t       *xattr    = NULL;
+        char         *gfid_str = NULL;
+        int32_t       op_ret   = -1;
+        int32_t       op_errno = ENOMEM;
+
+        if (!name || strcmp (name, GF_XATTROP_INDEX_GFID)) {
+                STACK_WIND (frame, default_getxattr_cbk, FIRST_CHILD (this),
+                            FIRST_CHILD (this)->fops->getxattr, loc, name);
+                return 0;
+        }
+
+        priv = this->private;
+
+        xattr = dict_new ();
+        if (!xattr)
+                goto out;
+
+        gfid_str = gf_strdup (uuid_utoa (priv->xattrop_vgfid));
+        if (!gfid_str)
+                goto out;
+
+        if (dict_set_dynstr (xattr, (char *)name, gfid_str)) {
+                GF_FREE (gfid_str);
+                goto out;
+        }
+
+        op_ret = 0;
+        op_errno = 0;
+out:
+        STACK_UNWIND_STRICT (getxattr, frame, op_ret, op_errno, xattr);
+        if (xattr)
+                dict_unref (xattr);
+        return 0;
+}
+
+
+int32_t
+index_lookup (call_frame_t *frame, xlator_t *this, loc_t *loc,
+              dict_t *xattr_req)
+{
+        index_priv_t *priv     = NULL;
+        struct iatt   stbuf    = {0, };
+        struct iatt   postparent = {0, };
+        struct stat   lstatbuf = {0, };
+        char          path[PATH_MAX];
+        int32_t       op_ret   = -1;
+        int32_t       op_errno = 0;
+
+        if (!index_is_virtual (this, loc)) {
+                STACK_WIND (frame, default_lookup_cbk, FIRST_CHILD (this),
+                            FIRST_CHILD (this)->fops->lookup, loc, xattr_req);
+                return 0;
+        }
+
+        priv = this->private;
+
+        snprintf (path, sizeof (path), "%s/%s", priv->index_basepath,
+                  XATTROP_SUBDIR);
+
+        op_ret = lstat (path, &lstatbuf);
+        if (op_ret) {
+                op_errno = errno;
+                goto out;
+        }
+
+        iatt_from_stat (&stbuf, &lstatbuf);
+        uuid_copy (stbuf.ia_gfid, priv->xattrop_vgfid);
+        stbuf.ia_ino = -1;
+out:
+        STACK_UNWIND_STRICT (lookup, frame, op_ret, op_errno, loc->inode,
+                             &stbuf, NULL, &postparent);
+        return 0;
+}
+
+
+int32_t
+index_opendir (call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd)
+{
+        index_priv_t   *priv     = NULL;
+        index_fd_ctx_t *fctx     = NULL;
+        char            path[PATH_MAX];
+        int32_t         op_ret   = -1;
+        int32_t         op_errno = ENOMEM;
+
+        if (!index_is_virtual (this, loc)) {
+                STACK_WIND (frame, default_opendir_cbk, FIRST_CHILD (this),
+                            FIRST_CHILD (this)->fops->opendir, loc, fd);
+                return 0;
+        }
+
+        priv = this->private;
+
+        fctx = GF_CALLOC (1, sizeof (*fctx), gf_index_mt_fd_ctx_t);
+        if (!fctx)
+                goto out;
+
+        snprintf (path, sizeof (path), "%s/%s", priv->index_basepath,
+                  XATTROP_SUBDIR);
+
+        fctx->dir = opendir (path);
+        if (!fctx->dir) {
+                op_errno = errno;
+                goto out;
+        }
+
+        LOCK_INIT (&fctx->lock);
+
+        if (fd_ctx_set (fd, this, (uint64_t)(long)fctx)) {
+                LOCK_DESTROY (&fctx->lock);
+                closedir (fctx->dir);
+                goto out;
+        }
+        fctx = NULL;
+
+        op_ret = 0;
+        op_errno = 0;
+out:
+        GF_FREE (fctx);
+        STACK_UNWIND_STRICT (opendir, frame, op_ret, op_errno, fd);
+        return 0;
+}
+
+
+/* Fills @entries with the gfids of the index starting at @off, the base
+ * file and anything else which is not a gfid are skipped. */
+static int
+index_fill_readdir (index_fd_ctx_t *fctx, off_t off, size_t size,
+                    gf_dirent_t *entries, int32_t *op_errno)
+{
+        struct dirent *entry     = NULL;
+        gf_dirent_t   *tmp       = NULL;
+        uuid_t         gfid      = {0, };
+        off_t          in_case   = 0;
+        size_t         filled    = 0;
+        size_t         this_size = 0;
+        int            count     = 0;
+
+        LOCK (&fctx->lock);
+        {
+                if (off)
+                        seekdir (fctx->dir, off);
+                else
+                        rewinddir (fctx->dir);
+
+                while (filled <= size) {
+                        in_case = telldir (fctx->dir);
+
+                        errno = 0;
+                        entry = readdir (fctx->dir);
+                        if (!entry) {
+                                if (errno) {
+                                        *op_errno = errno;
+                                        count = -1;
+                                }
+                                break;
+                        }
+
+                        if (strlen (entry->d_name) != 36 ||
+                            uuid_parse (entry->d_name, gfid))
+                                continue;
+
+                        this_size = sizeof (gf_dirent_t) +
+                                    strlen (entry->d_name) + 1;
+                        if (this_size + filled > size) {
+                                seekdir (fctx->dir, in_case);
+                                break;
+                        }
+
+                        tmp = gf_dirent_for_name (entry->d_name);
+                        if (!tmp) {
+                                *op_errno = ENOMEM;
+                                count = -1;
+                                break;
+                        }
+
+                        tmp->d_ino = entry->d_ino;
+                        tmp->d_off = telldir (fctx->dir);
+                        tmp->d_type = entry->d_type;
+                        uuid_copy (tmp->d_stat.ia_gfid, gfid);
+
+                        list_add_tail (&tmp->list, &entries->list);
+                        filled += this_size;
+                        count++;
+                }
+        }
+        UNLOCK (&fctx->lock);
+
+        return count;
+}
+
+
+static int
+index_fd_ctx_get (xlator_t *this, fd_t *fd, index_fd_ctx_t **fctx)
+{
+        uint64_t  value = 0;
+        int       ret   = -1;
+
+        ret = fd_ctx_get (fd, this, &value);
+        if (ret == 0)
+                *fctx = (index_fd_ctx_t *)(long)value;
+
+        return ret;
+}
+
+
+int32_t
+index_readdir (call_frame_t *frame, xlator_t *this, fd_t *fd,
+               size_t size, off_t off)
+{
+        index_fd_ctx_t *fctx     = NULL;
+        gf_dirent_t     entries;
+        int32_t         op_ret   = -1;
+        int32_t         op_errno = 0;
+
+        if (index_fd_ctx_get (this, fd, &fctx)) {
+                STACK_WIND (frame, default_readdir_cbk, FIRST_CHILD (this),
+                            FIRST_CHILD (this)->fops->readdir, fd, size, off);
+                return 0;
+        }
+
+        INIT_LIST_HEAD (&entries.list);
+
+        op_ret = index_fill_readdir (fctx, off, size, &entries, &op_errno);
+
+        STACK_UNWIND_STRICT (readdir, frame, op_ret, op_errno, &entries);
+        gf_dirent_free (&entries);
+        return 0;
+}
+
+
+int32_t
+index_readdirp (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                size_t size, off_t off)
+{
+        index_fd_ctx_t *fctx     = NULL;
+        gf_dirent_t     entries;
+        int32_t         op_ret   = -1;
+        int32_t         op_errno = 0;
+
+        if (index_fd_ctx_get (this, fd, &fctx)) {
+                STACK_WIND (frame, default_readdirp_cbk, FIRST_CHILD (this),
+                            FIRST_CHILD (this)->fops->readdirp, fd, size, off);
+                return 0;
+        }
+
+        INIT_LIST_HEAD (&entries.list);
+
+        op_ret = index_fill_readdir (fctx, off, size, &entries, &op_errno);
+
+        STACK_UNWIND_STRICT (readdirp, frame, op_ret, op_errno, &entries);
+        gf_dirent_free (&entries);
+        return 0;
+}
+
+
+int32_t
+index_releasedir (xlator_t *this, fd_t *fd)
+{
+        index_fd_ctx_t *fctx  = NULL;
+        uint64_t        value = 0;
+
+        if (fd_ctx_del (fd, this, &value))
+                return 0;
+
+        fctx = (index_fd_ctx_t *)(long)value;
+        if (fctx->dir)
+                closedir (fctx->dir);
+        LOCK_DESTROY (&fctx->lock);
+        GF_FREE (fctx);
+
+        return 0;
+}
+
+
+int32_t
+index_forget (xlator_t *this, inode_t *inode)
+{
+        uint64_t value = 0;
+
+        inode_ctx_del (inode, this, &value);
+        if (value)
+                GF_FREE ((index_inode_ctx_t *)(long) value);
+        return 0;
+}
+
+
+int
+index_priv_dump (xlator_t *this)
+{
+        index_priv_t *priv = NULL;
+        char          key_prefix[GF_DUMP_MAX_BUF_LEN];
+
+        priv = this->private;
+        if (!priv)
+                return 0;
+
+        gf_proc_dump_build_key (key_prefix, "xlator.features.index", "priv");
+        gf_proc_dump_add_section (key_prefix);
+
+        gf_proc_dump_write ("index_base", "%s", priv->index_basepath);
+        gf_proc_dump_write ("xattrop_vgfid", "%s",
+                            uuid_utoa (priv->xattrop_vgfid));
+        gf_proc_dump_write ("added", "%"PRIu64, priv->added);
+        gf_proc_dump_write ("removed", "%"PRIu64, priv->removed);
+
+        return 0;
+}
+
+
+int32_t
+mem_acct_init (xlator_t *this)
+{
+        int     ret = -1;
+
+        if (!this)
+                return ret;
+
+        ret = xlator_mem_acct_init (this, gf_index_mt_end + 1);
+
+        if (ret != 0) {
+                gf_log (this->name, GF_LOG_ERROR, "Memory accounting init"
+                        "failed");
+                return ret;
+        }
+
+        return ret;
+}
+
+
+int
+init (xlator_t *this)
+{
+        index_priv_t *priv     = NULL;
+        char         *basepath = NULL;
+        char          path[PATH_MAX];
+        int           ret      = -1;
+
+        if (!this->children || this->children->next) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "FATAL: index not configured with exactly one child");
+                goto out;
+        }
+
+        if (!this->parents) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "dangling volume. check volfile ");
+        }
+
+        priv = GF_CALLOC (1, sizeof (*priv), gf_index_mt_priv_t);
+        if (!priv)
+                goto out;
+
+        LOCK_INIT (&priv->lock);
+
+        GF_OPTION_INIT ("index-base", basepath, path, out);
+
+        priv->index_basepath = gf_strdup (basepath);
+        if (!priv->index_basepath)
+                goto out;
+
+        uuid_generate (priv->xattrop_vgfid);
+
+        this->private = priv;
+
+        snprintf (path, sizeof (path), "%s/%s", priv->index_basepath,
+                  XATTROP_SUBDIR);
+
+        ret = index_mkdir_p (this, path);
+        if (ret)
+                goto out;
+
+        ret = index_create_base (this);
+out:
+        if (ret && priv) {
+                this->private = NULL;
+                LOCK_DESTROY (&priv->lock);
+                GF_FREE (priv->index_basepath);
+                GF_FREE (priv);
+        }
+
+        return ret;
+}
+
+
+void
+fini (xlator_t *this)
+{
+        index_priv_t *priv = NULL;
+
+        priv = this->private;
+        if (!priv)
+                return;
+
+        this->private = NULL;
+
+        LOCK_DESTROY (&priv->lock);
+        GF_FREE (priv->index_basepath);
+        GF_FREE (priv);
+
+        return;
+}
+
+
+struct xlator_fops fops = {
+        .xattrop     = index_xattrop,
+        .fxattrop    = index_fxattrop,
+        .getxattr    = index_getxattr,
+        .lookup      = index_lookup,
+        .opendir     = index_opendir,
+        .readdir     = index_readdir,
+        .readdirp    = index_readdirp,
+};
+
+struct xlator_cbks cbks = {
+        .forget      = index_forget,
+        .releasedir  = index_releasedir,
+};
+
+struct xlator_dumpops dumpops = {
+        .priv        = index_priv_dump,
+};
+
+struct volume_options options[] = {
+        { .key  = {"index-base"},
+          .type = GF_OPTION_TYPE_PATH,
+          .description = "Directory on the brick holding the index of "
+                         "files which need self-heal"
+        },
+        { .key  = {NULL} },
+};
@@ -0,0 +1,64 @@
+/*
+   Copyright (c) 2010-2011 Gluster, Inc. <http://www.gluster.com>
+   This file is part of GlusterFS.
+
+   GlusterFS is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 3 of the License,
+   or (at your option) any later version.
+
+   GlusterFS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see
+   <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __INDEX_H__
+#define __INDEX_H__
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <dirent.h>
+
+#include "xlator.h"
+#include "index-mem-types.h"
+
+/* the changelog xattrs of replicate, whose values tell a file needs heal */
+#define INDEX_XATTROP_PREFIX "trusted.afr."
+
+#define XATTROP_SUBDIR "xattrop"
+#define XATTROP_BASE   "xattrop-base"  /* index entries are links to it */
+
+typedef struct {
+        char             *index_basepath;
+        uuid_t            xattrop_vgfid; /* of the index directory */
+        gf_lock_t         lock;
+        uint64_t          added;
+        uint64_t          removed;
+} index_priv_t;
+
+#define INDEX_OP_NONE  0
+#define INDEX_OP_ADD   1
+#define INDEX_OP_DEL   2
+
+/* per inode, under inode->lock */
+typedef struct {
+        uint64_t          in_flight;  /* xattrops of the changelog */
+        int               pending;    /* INDEX_OP_* left to do on disk */
+        gf_boolean_t      busy;       /* a thread is doing them */
+} index_inode_ctx_t;
+
+/* opendir of the index directory */
+typedef struct {
+        DIR              *dir;
+        gf_lock_t         lock;
+} index_fd_ctx_t;
+
+#endif /* __INDEX_H__ */
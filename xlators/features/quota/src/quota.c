@@ -1975,6 +1975,412 @@ err:
 }
 
 
+/* accounts the blocks a data fop on local->loc.inode added or freed */
+static void
+quota_update_blocks (xlator_t *this, quota_local_t *local,
+                     struct iatt *prebuf, struct iatt *postbuf)
+{
+        int64_t            delta = 0;
+        quota_inode_ctx_t *ctx   = NULL;
+
+        delta = (postbuf->ia_blocks - prebuf->ia_blocks) * 512;
+
+        quota_update_size (this, local->loc.inode, NULL, NULL, delta);
+
+        quota_inode_ctx_get (local->loc.inode, -1, this, NULL, NULL,
+                             &ctx, 0);
+        if (ctx == NULL) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "quota context not set in inode (gfid:%s)",
+                        uuid_utoa (local->loc.inode->gfid));
+                return;
+        }
+
+        LOCK (&ctx->lock);
+        {
+                ctx->buf = *postbuf;
+        }
+        UNLOCK (&ctx->lock);
+}
+
+
+/* checks size more bytes of fd against the limits of its parents, as
+   writev does. stub is resumed once they are validated, and fails with
+   EDQUOT if one is exceeded */
+static int32_t
+quota_check_data_fop (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                      call_stub_t *stub, int64_t size)
+{
+        int32_t            parents = 0;
+        quota_local_t     *local   = NULL;
+        quota_inode_ctx_t *ctx     = NULL;
+        quota_dentry_t    *dentry  = NULL;
+        int32_t            ret     = -1;
+
+        local = frame->local;
+
+        quota_inode_ctx_get (fd->inode, -1, this, NULL, NULL, &ctx, 0);
+        if (ctx == NULL) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "quota context not set in inode (gfid:%s)",
+                        uuid_utoa (fd->inode->gfid));
+                goto out;
+        }
+
+        LOCK (&ctx->lock);
+        {
+                list_for_each_entry (dentry, &ctx->parents, next) {
+                        parents++;
+                }
+        }
+        UNLOCK (&ctx->lock);
+
+        local->delta = size;
+        local->stub = stub;
+        local->link_count = parents;
+
+        list_for_each_entry (dentry, &ctx->parents, next) {
+                ret = quota_check_limit (frame, fd->inode, this, dentry->name,
+                                         dentry->par);
+                if (ret == -1) {
+                        break;
+                }
+        }
+
+        stub = NULL;
+
+        LOCK (&local->lock);
+        {
+                local->link_count = 0;
+                if (local->validate_count == 0) {
+                        stub = local->stub;
+                        local->stub = NULL;
+                }
+        }
+        UNLOCK (&local->lock);
+
+        if (stub != NULL) {
+                call_resume (stub);
+        }
+
+        ret = 0;
+out:
+        return ret;
+}
+
+
+int32_t
+quota_fallocate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                     int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                     struct iatt *postbuf)
+{
+        quota_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret < 0) || (local == NULL)) {
+                goto out;
+        }
+
+        quota_update_blocks (this, local, prebuf, postbuf);
+
+out:
+        QUOTA_STACK_UNWIND (fallocate, frame, op_ret, op_errno, prebuf,
+                            postbuf);
+        return 0;
+}
+
+
+int32_t
+quota_fallocate_helper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                        int32_t keep_size, off_t offset, size_t len)
+{
+        quota_local_t *local    = NULL;
+        int32_t        op_errno = EINVAL;
+
+        local = frame->local;
+        if (local == NULL) {
+                gf_log (this->name, GF_LOG_WARNING, "local is NULL");
+                goto unwind;
+        }
+
+        if (local->op_ret == -1) {
+                op_errno = local->op_errno;
+                goto unwind;
+        }
+
+        STACK_WIND (frame, quota_fallocate_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->fallocate, fd, keep_size,
+                    offset, len);
+        return 0;
+
+unwind:
+        QUOTA_STACK_UNWIND (fallocate, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+/* the reserved blocks count even when the size is kept */
+int32_t
+quota_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                 int32_t keep_size, off_t offset, size_t len)
+{
+        int32_t        op_errno = ENOMEM;
+        quota_local_t *local    = NULL;
+        call_stub_t   *stub     = NULL;
+
+        local = quota_local_new ();
+        if (local == NULL)
+                goto unwind;
+
+        frame->local = local;
+        local->loc.inode = inode_ref (fd->inode);
+
+        stub = fop_fallocate_stub (frame, quota_fallocate_helper, fd,
+                                   keep_size, offset, len);
+        if (stub == NULL)
+                goto unwind;
+
+        if (quota_check_data_fop (frame, this, fd, stub, len)) {
+                call_stub_destroy (stub);
+                op_errno = EINVAL;
+                goto unwind;
+        }
+
+        return 0;
+
+unwind:
+        QUOTA_STACK_UNWIND (fallocate, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+quota_zerofill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                    struct iatt *postbuf)
+{
+        quota_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret < 0) || (local == NULL)) {
+                goto out;
+        }
+
+        quota_update_blocks (this, local, prebuf, postbuf);
+
+out:
+        QUOTA_STACK_UNWIND (zerofill, frame, op_ret, op_errno, prebuf,
+                            postbuf);
+        return 0;
+}
+
+
+int32_t
+quota_zerofill_helper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                       off_t offset, size_t len)
+{
+        quota_local_t *local    = NULL;
+        int32_t        op_errno = EINVAL;
+
+        local = frame->local;
+        if (local == NULL) {
+                gf_log (this->name, GF_LOG_WARNING, "local is NULL");
+                goto unwind;
+        }
+
+        if (local->op_ret == -1) {
+                op_errno = local->op_errno;
+                goto unwind;
+        }
+
+        STACK_WIND (frame, quota_zerofill_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->zerofill, fd, offset, len);
+        return 0;
+
+unwind:
+        QUOTA_STACK_UNWIND (zerofill, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+/* zeroing a hole allocates it */
+int32_t
+quota_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+                size_t len)
+{
+        int32_t        op_errno = ENOMEM;
+        quota_local_t *local    = NULL;
+        call_stub_t   *stub     = NULL;
+
+        local = quota_local_new ();
+        if (local == NULL)
+                goto unwind;
+
+        frame->local = local;
+        local->loc.inode = inode_ref (fd->inode);
+
+        stub = fop_zerofill_stub (frame, quota_zerofill_helper, fd, offset,
+                                  len);
+        if (stub == NULL)
+                goto unwind;
+
+        if (quota_check_data_fop (frame, this, fd, stub, len)) {
+                call_stub_destroy (stub);
+                op_errno = EINVAL;
+                goto unwind;
+        }
+
+        return 0;
+
+unwind:
+        QUOTA_STACK_UNWIND (zerofill, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+quota_discard_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                   struct iatt *postbuf)
+{
+        quota_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret < 0) || (local == NULL)) {
+                goto out;
+        }
+
+        quota_update_blocks (this, local, prebuf, postbuf);
+
+out:
+        QUOTA_STACK_UNWIND (discard, frame, op_ret, op_errno, prebuf,
+                            postbuf);
+        return 0;
+}
+
+
+/* only frees blocks, nothing to check */
+int32_t
+quota_discard (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+               size_t len)
+{
+        quota_local_t *local = NULL;
+
+        local = quota_local_new ();
+        if (local == NULL)
+                goto err;
+
+        frame->local = local;
+
+        local->loc.inode = inode_ref (fd->inode);
+
+        STACK_WIND (frame, quota_discard_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->discard, fd, offset, len);
+
+        return 0;
+err:
+        QUOTA_STACK_UNWIND (discard, frame, -1, ENOMEM, NULL, NULL);
+
+        return 0;
+}
+
+
+int32_t
+quota_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                           int32_t op_ret, int32_t op_errno,
+                           struct iatt *stbuf_in, struct iatt *prebuf,
+                           struct iatt *postbuf)
+{
+        quota_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret < 0) || (local == NULL)) {
+                goto out;
+        }
+
+        quota_update_blocks (this, local, prebuf, postbuf);
+
+out:
+        QUOTA_STACK_UNWIND (copy_file_range, frame, op_ret, op_errno,
+                            stbuf_in, prebuf, postbuf);
+        return 0;
+}
+
+
+int32_t
+quota_copy_file_range_helper (call_frame_t *frame, xlator_t *this,
+                              fd_t *fd_in, off_t off_in, fd_t *fd_out,
+                              off_t off_out, size_t len, uint32_t flags)
+{
+        quota_local_t *local    = NULL;
+        int32_t        op_errno = EINVAL;
+
+        local = frame->local;
+        if (local == NULL) {
+                gf_log (this->name, GF_LOG_WARNING, "local is NULL");
+                goto unwind;
+        }
+
+        if (local->op_ret == -1) {
+                op_errno = local->op_errno;
+                goto unwind;
+        }
+
+        STACK_WIND (frame, quota_copy_file_range_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags);
+        return 0;
+
+unwind:
+        QUOTA_STACK_UNWIND (copy_file_range, frame, -1, op_errno, NULL, NULL,
+                            NULL);
+        return 0;
+}
+
+
+/* the destination grows by up to len, whether the data is cloned,
+   copied or streamed below */
+int32_t
+quota_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                       off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                       uint32_t flags)
+{
+        int32_t        op_errno = ENOMEM;
+        quota_local_t *local    = NULL;
+        call_stub_t   *stub     = NULL;
+
+        local = quota_local_new ();
+        if (local == NULL)
+                goto unwind;
+
+        frame->local = local;
+        local->loc.inode = inode_ref (fd_out->inode);
+
+        stub = fop_copy_file_range_stub (frame, quota_copy_file_range_helper,
+                                         fd_in, off_in, fd_out, off_out, len,
+                                         flags);
+        if (stub == NULL)
+                goto unwind;
+
+        if (quota_check_data_fop (frame, this, fd_out, stub, len)) {
+                call_stub_destroy (stub);
+                op_errno = EINVAL;
+                goto unwind;
+        }
+
+        return 0;
+
+unwind:
+        QUOTA_STACK_UNWIND (copy_file_range, frame, -1, op_errno, NULL, NULL,
+                            NULL);
+        return 0;
+}
+
+
 int32_t
 quota_send_dir_limit_to_cli (call_frame_t *frame, xlator_t *this,
                              inode_t *inode, const char *name)
@@ -3020,7 +3426,11 @@ struct xlator_fops fops = {
         .fsetattr  = quota_fsetattr,
         .mknod     = quota_mknod,
         .setxattr  = quota_setxattr,
-        .fsetxattr = quota_fsetxattr
+        .fsetxattr = quota_fsetxattr,
+        .fallocate = quota_fallocate,
+        .discard   = quota_discard,
+        .zerofill  = quota_zerofill,
+        .copy_file_range = quota_copy_file_range,
 };
 
 struct xlator_cbks cbks = {
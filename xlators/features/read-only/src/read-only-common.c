@@ -113,6 +113,40 @@ ro_ftruncate (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset)
 	return 0;
 }
 
+int32_t
+ro_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              int32_t keep_size, off_t offset, size_t len)
+{
+        STACK_UNWIND_STRICT (fallocate, frame, -1, EROFS, NULL, NULL);
+        return 0;
+}
+
+int32_t
+ro_discard (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+            size_t len)
+{
+        STACK_UNWIND_STRICT (discard, frame, -1, EROFS, NULL, NULL);
+        return 0;
+}
+
+int32_t
+ro_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+             size_t len)
+{
+        STACK_UNWIND_STRICT (zerofill, frame, -1, EROFS, NULL, NULL);
+        return 0;
+}
+
+int32_t
+ro_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                    uint32_t flags)
+{
+        STACK_UNWIND_STRICT (copy_file_range, frame, -1, EROFS, NULL, NULL,
+                             NULL);
+        return 0;
+}
+
 int
 ro_mknod (call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
           dev_t rdev, dict_t *params)
@@ -70,6 +70,23 @@ ro_truncate (call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset);
 int32_t
 ro_ftruncate (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset);
 
+int32_t
+ro_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              int32_t keep_size, off_t offset, size_t len);
+
+int32_t
+ro_discard (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+            size_t len);
+
+int32_t
+ro_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+             size_t len);
+
+int32_t
+ro_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                    uint32_t flags);
+
 int
 ro_mknod (call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
           dev_t rdev, dict_t *params);
@@ -82,6 +82,10 @@ struct xlator_fops fops = {
         .rmdir       = ro_rmdir,
         .rename      = ro_rename,
         .truncate    = ro_truncate,
+        .fallocate   = ro_fallocate,
+        .discard     = ro_discard,
+        .zerofill    = ro_zerofill,
+        .copy_file_range = ro_copy_file_range,
         .removexattr = ro_removexattr,
         .fsyncdir    = ro_fsyncdir,
         .xattrop     = ro_xattrop,
@@ -0,0 +1,1315 @@
+/*
+   Copyright (c) 2010-2011 Gluster, Inc. <http://www.gluster.com>
+   This file is part of GlusterFS.
+
+   GlusterFS is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 3 of the License,
+   or (at your option) any later version.
+
+   GlusterFS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see
+   <http://www.gnu.org/licenses/>.
+*/
+
+/* Brick side bookkeeping of which clients may be caching an inode, and
+ * cache invalidation of those clients when the inode is changed by
+ * somebody else.
+ *
+ * Every fop which hands inode state to a client registers that client in
+ * the inode context. A fop which changes an inode (or a directory's
+ * entries) raises GF_EVENT_UPCALL up the graph once for every other
+ * client which accessed the inode in the last cache-invalidation-timeout
+ * seconds. protocol/server turns the event into a GF_CBK_CACHE_INVALIDATION
+ * callback on that client's connection.
+ */
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include "upcall.h"
+#include "defaults.h"
+#include "statedump.h"
+
+
+void
+upcall_local_free (upcall_local_t *local)
+{
+        if (!local)
+                return;
+
+        if (local->inode)
+                inode_unref (local->inode);
+        if (local->parent)
+                inode_unref (local->parent);
+        if (local->newparent)
+                inode_unref (local->newparent);
+        if (local->victim)
+                inode_unref (local->victim);
+
+        GF_FREE (local);
+}
+
+
+static upcall_local_t *
+upcall_local_init (call_frame_t *frame, xlator_t *this, inode_t *inode,
+                   inode_t *parent, inode_t *newparent, inode_t *victim)
+{
+        upcall_private_t *priv  = NULL;
+        upcall_local_t   *local = NULL;
+
+        priv = this->private;
+        if (!priv->cache_invalidation)
+                goto out;
+
+        local = GF_CALLOC (1, sizeof (*local), gf_upcall_mt_local_t);
+        if (!local)
+                goto out;
+
+        if (inode)
+                local->inode = inode_ref (inode);
+        if (parent)
+                local->parent = inode_ref (parent);
+        if (newparent)
+                local->newparent = inode_ref (newparent);
+        if (victim)
+                local->victim = inode_ref (victim);
+
+        frame->local = local;
+out:
+        return local;
+}
+
+
+static upcall_inode_ctx_t *
+upcall_inode_ctx_get (inode_t *inode, xlator_t *this)
+{
+        upcall_inode_ctx_t *ctx   = NULL;
+        uint64_t            value = 0;
+        int                 ret   = 0;
+
+        LOCK (&inode->lock);
+        {
+                ret = __inode_ctx_get (inode, this, &value);
+                if (ret == 0) {
+                        ctx = (upcall_inode_ctx_t *)(long) value;
+                        goto unlock;
+                }
+
+                ctx = GF_CALLOC (1, sizeof (*ctx), gf_upcall_mt_inode_ctx_t);
+                if (!ctx)
+                        goto unlock;
+
+                INIT_LIST_HEAD (&ctx->clients);
+                LOCK_INIT (&ctx->lock);
+
+                ret = __inode_ctx_put (inode, this, (uint64_t)(long) ctx);
+                if (ret) {
+                        LOCK_DESTROY (&ctx->lock);
+                        GF_FREE (ctx);
+                        ctx = NULL;
+                }
+        }
+unlock:
+        UNLOCK (&inode->lock);
+
+        return ctx;
+}
+
+
+/* remember that the client which sent @frame now caches @inode */
+static void
+upcall_client_register (call_frame_t *frame, xlator_t *this, inode_t *inode)
+{
+        upcall_inode_ctx_t *ctx    = NULL;
+        upcall_client_t    *client = NULL;
+        upcall_client_t    *tmp    = NULL;
+        char               *origin = NULL;
+
+        origin = frame->root->client_uid;
+        if (!inode || !origin)
+                return;
+
+        ctx = upcall_inode_ctx_get (inode, this);
+        if (!ctx)
+                return;
+
+        LOCK (&ctx->lock);
+        {
+                list_for_each_entry (tmp, &ctx->clients, list) {
+                        if (strcmp (tmp->client_uid, origin) == 0) {
+                                client = tmp;
+                                break;
+                        }
+                }
+
+                if (!client) {
+                        client = GF_CALLOC (1, sizeof (*client),
+                                            gf_upcall_mt_client_t);
+                        if (!client)
+                                goto unlock;
+
+                        client->client_uid = gf_strdup (origin);
+                        if (!client->client_uid) {
+                                GF_FREE (client);
+                                client = NULL;
+                                goto unlock;
+                        }
+                        list_add_tail (&client->list, &ctx->clients);
+                }
+
+                client->access_time = time (NULL);
+        }
+unlock:
+        UNLOCK (&ctx->lock);
+}
+
+
+/* tell every other client which recently accessed @inode that it changed.
+ * @stbuf, when given, supplies the gfid: inodes created by this very fop
+ * are not linked yet.
+ */
+static void
+upcall_cache_invalidate (call_frame_t *frame, xlator_t *this, inode_t *inode,
+                         struct iatt *stbuf, uint32_t flags)
+{
+        upcall_private_t   *priv    = NULL;
+        upcall_inode_ctx_t *ctx     = NULL;
+        upcall_client_t    *client  = NULL;
+        upcall_client_t    *tmp     = NULL;
+        char              **targets = NULL;
+        struct gf_upcall    upcall  = {{0, }, };
+        char               *origin  = NULL;
+        time_t              now     = 0;
+        int                 count   = 0;
+        int                 expired = 0;
+        int                 i       = 0;
+
+        priv = this->private;
+
+        if (!inode)
+                return;
+
+        if (stbuf && !uuid_is_null (stbuf->ia_gfid))
+                uuid_copy (upcall.gfid, stbuf->ia_gfid);
+        else
+                uuid_copy (upcall.gfid, inode->gfid);
+
+        if (uuid_is_null (upcall.gfid))
+                goto out;
+
+        ctx = upcall_inode_ctx_get (inode, this);
+        if (!ctx)
+                goto out;
+
+        origin = frame->root->client_uid;
+        now = time (NULL);
+
+        LOCK (&ctx->lock);
+        {
+                list_for_each_entry_safe (client, tmp, &ctx->clients, list) {
+                        if ((now - client->access_time) > priv->timeout) {
+                                list_del_init (&client->list);
+                                GF_FREE (client->client_uid);
+                                GF_FREE (client);
+                                expired++;
+                                continue;
+                        }
+
+                        if (!origin || strcmp (client->client_uid, origin))
+                                count++;
+                }
+
+                if (count)
+                        targets = GF_CALLOC (count, sizeof (*targets),
+                                             gf_upcall_mt_client_list_t);
+
+                if (targets) {
+                        list_for_each_entry (client, &ctx->clients, list) {
+                                if (origin &&
+                                    !strcmp (client->client_uid, origin))
+                                        continue;
+                                targets[i] = gf_strdup (client->client_uid);
+                                if (targets[i])
+                                        i++;
+                        }
+                        count = i;
+                }
+        }
+        UNLOCK (&ctx->lock);
+
+        upcall.flags = flags;
+
+        for (i = 0; targets && (i < count); i++) {
+                upcall.client_uid = targets[i];
+
+                gf_log (this->name, GF_LOG_TRACE,
+                        "invalidating %s (flags 0x%x) on client %s",
+                        uuid_utoa (upcall.gfid), flags, upcall.client_uid);
+
+                default_notify (this, GF_EVENT_UPCALL, &upcall);
+                GF_FREE (targets[i]);
+        }
+
+        LOCK (&priv->lock);
+        {
+                if (targets)
+                        priv->notifications += count;
+                priv->expired += expired;
+        }
+        UNLOCK (&priv->lock);
+
+        if (targets)
+                GF_FREE (targets);
+out:
+        /* the modifying client has the new state */
+        upcall_client_register (frame, this, inode);
+}
+
+
+int32_t
+upcall_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno, inode_t *inode,
+                   struct iatt *buf, dict_t *xattr, struct iatt *postparent)
+{
+        upcall_private_t *priv = NULL;
+
+        priv = this->private;
+
+        if ((op_ret >= 0) && priv->cache_invalidation)
+                upcall_client_register (frame, this, inode);
+
+        STACK_UNWIND_STRICT (lookup, frame, op_ret, op_errno, inode, buf,
+                             xattr, postparent);
+        return 0;
+}
+
+
+int32_t
+upcall_lookup (call_frame_t *frame, xlator_t *this, loc_t *loc,
+               dict_t *xattr_req)
+{
+        STACK_WIND (frame, upcall_lookup_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->lookup, loc, xattr_req);
+        return 0;
+}
+
+
+int32_t
+upcall_stat_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *buf)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_client_register (frame, this, local->inode);
+
+        UPCALL_STACK_UNWIND (stat, frame, op_ret, op_errno, buf);
+        return 0;
+}
+
+
+int32_t
+upcall_stat (call_frame_t *frame, xlator_t *this, loc_t *loc)
+{
+        upcall_local_init (frame, this, loc->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_stat_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->stat, loc);
+        return 0;
+}
+
+
+int32_t
+upcall_fstat_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iatt *buf)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_client_register (frame, this, local->inode);
+
+        UPCALL_STACK_UNWIND (fstat, frame, op_ret, op_errno, buf);
+        return 0;
+}
+
+
+int32_t
+upcall_fstat (call_frame_t *frame, xlator_t *this, fd_t *fd)
+{
+        upcall_local_init (frame, this, fd->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_fstat_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fstat, fd);
+        return 0;
+}
+
+
+int32_t
+upcall_open_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, fd_t *fd)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_client_register (frame, this, local->inode);
+
+        UPCALL_STACK_UNWIND (open, frame, op_ret, op_errno, fd);
+        return 0;
+}
+
+
+int32_t
+upcall_open (call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+             fd_t *fd, int32_t wbflags)
+{
+        upcall_local_init (frame, this, fd->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_open_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->open, loc, flags, fd, wbflags);
+        return 0;
+}
+
+
+int32_t
+upcall_readv_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iovec *vector,
+                  int32_t count, struct iatt *stbuf, struct iobref *iobref)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_client_register (frame, this, local->inode);
+
+        UPCALL_STACK_UNWIND (readv, frame, op_ret, op_errno, vector, count,
+                             stbuf, iobref);
+        return 0;
+}
+
+
+int32_t
+upcall_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+              off_t offset)
+{
+        upcall_local_init (frame, this, fd->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_readv_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->readv, fd, size, offset);
+        return 0;
+}
+
+
+int32_t
+upcall_readlink_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                     int32_t op_ret, int32_t op_errno, const char *path,
+                     struct iatt *buf)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_client_register (frame, this, local->inode);
+
+        UPCALL_STACK_UNWIND (readlink, frame, op_ret, op_errno, path, buf);
+        return 0;
+}
+
+
+int32_t
+upcall_readlink (call_frame_t *frame, xlator_t *this, loc_t *loc, size_t size)
+{
+        upcall_local_init (frame, this, loc->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_readlink_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->readlink, loc, size);
+        return 0;
+}
+
+
+int32_t
+upcall_getxattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                     int32_t op_ret, int32_t op_errno, dict_t *dict)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_client_register (frame, this, local->inode);
+
+        UPCALL_STACK_UNWIND (getxattr, frame, op_ret, op_errno, dict);
+        return 0;
+}
+
+
+int32_t
+upcall_getxattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                 const char *name)
+{
+        upcall_local_init (frame, this, loc->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_getxattr_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->getxattr, loc, name);
+        return 0;
+}
+
+
+int32_t
+upcall_fgetxattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                      int32_t op_ret, int32_t op_errno, dict_t *dict)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_client_register (frame, this, local->inode);
+
+        UPCALL_STACK_UNWIND (fgetxattr, frame, op_ret, op_errno, dict);
+        return 0;
+}
+
+
+int32_t
+upcall_fgetxattr (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                  const char *name)
+{
+        upcall_local_init (frame, this, fd->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_fgetxattr_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fgetxattr, fd, name);
+        return 0;
+}
+
+
+int32_t
+upcall_opendir_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, fd_t *fd)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_client_register (frame, this, local->inode);
+
+        UPCALL_STACK_UNWIND (opendir, frame, op_ret, op_errno, fd);
+        return 0;
+}
+
+
+int32_t
+upcall_opendir (call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd)
+{
+        upcall_local_init (frame, this, fd->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_opendir_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->opendir, loc, fd);
+        return 0;
+}
+
+
+int32_t
+upcall_readdir_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, gf_dirent_t *entries)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_client_register (frame, this, local->inode);
+
+        UPCALL_STACK_UNWIND (readdir, frame, op_ret, op_errno, entries);
+        return 0;
+}
+
+
+int32_t
+upcall_readdir (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+                off_t off)
+{
+        upcall_local_init (frame, this, fd->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_readdir_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->readdir, fd, size, off);
+        return 0;
+}
+
+
+int32_t
+upcall_readdirp_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                     int32_t op_ret, int32_t op_errno, gf_dirent_t *entries)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        /* the entries' inodes are not linked on the brick, they get
+           registered on their first lookup */
+        if ((op_ret >= 0) && local)
+                upcall_client_register (frame, this, local->inode);
+
+        UPCALL_STACK_UNWIND (readdirp, frame, op_ret, op_errno, entries);
+        return 0;
+}
+
+
+int32_t
+upcall_readdirp (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+                 off_t off)
+{
+        upcall_local_init (frame, this, fd->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_readdirp_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->readdirp, fd, size, off);
+        return 0;
+}
+
+
+int32_t
+upcall_writev_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                   struct iatt *postbuf)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_cache_invalidate (frame, this, local->inode, postbuf,
+                                         GF_UPCALL_DATA | GF_UPCALL_ATTR);
+
+        UPCALL_STACK_UNWIND (writev, frame, op_ret, op_errno, prebuf,
+                             postbuf);
+        return 0;
+}
+
+
+int32_t
+upcall_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
+               struct iovec *vector, int32_t count, off_t off,
+               struct iobref *iobref)
+{
+        upcall_local_init (frame, this, fd->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_writev_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->writev, fd, vector, count, off,
+                    iobref);
+        return 0;
+}
+
+
+int32_t
+upcall_truncate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                     int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                     struct iatt *postbuf)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_cache_invalidate (frame, this, local->inode, postbuf,
+                                         GF_UPCALL_DATA | GF_UPCALL_ATTR);
+
+        UPCALL_STACK_UNWIND (truncate, frame, op_ret, op_errno, prebuf,
+                             postbuf);
+        return 0;
+}
+
+
+int32_t
+upcall_truncate (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                 off_t offset)
+{
+        upcall_local_init (frame, this, loc->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_truncate_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->truncate, loc, offset);
+        return 0;
+}
+
+
+int32_t
+upcall_ftruncate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                      int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                      struct iatt *postbuf)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_cache_invalidate (frame, this, local->inode, postbuf,
+                                         GF_UPCALL_DATA | GF_UPCALL_ATTR);
+
+        UPCALL_STACK_UNWIND (ftruncate, frame, op_ret, op_errno, prebuf,
+                             postbuf);
+        return 0;
+}
+
+
+int32_t
+upcall_ftruncate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                  off_t offset)
+{
+        upcall_local_init (frame, this, fd->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_ftruncate_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->ftruncate, fd, offset);
+        return 0;
+}
+
+
+int32_t
+upcall_setattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, struct iatt *preop,
+                    struct iatt *postop)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_cache_invalidate (frame, this, local->inode, postop,
+                                         GF_UPCALL_ATTR);
+
+        UPCALL_STACK_UNWIND (setattr, frame, op_ret, op_errno, preop,
+                             postop);
+        return 0;
+}
+
+
+int32_t
+upcall_setattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                struct iatt *stbuf, int32_t valid)
+{
+        upcall_local_init (frame, this, loc->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_setattr_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->setattr, loc, stbuf, valid);
+        return 0;
+}
+
+
+int32_t
+upcall_fsetattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                     int32_t op_ret, int32_t op_errno, struct iatt *preop,
+                     struct iatt *postop)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_cache_invalidate (frame, this, local->inode, postop,
+                                         GF_UPCALL_ATTR);
+
+        UPCALL_STACK_UNWIND (fsetattr, frame, op_ret, op_errno, preop,
+                             postop);
+        return 0;
+}
+
+
+int32_t
+upcall_fsetattr (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                 struct iatt *stbuf, int32_t valid)
+{
+        upcall_local_init (frame, this, fd->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_fsetattr_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fsetattr, fd, stbuf, valid);
+        return 0;
+}
+
+
+int32_t
+upcall_setxattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                     int32_t op_ret, int32_t op_errno)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_cache_invalidate (frame, this, local->inode, NULL,
+                                         GF_UPCALL_ATTR);
+
+        UPCALL_STACK_UNWIND (setxattr, frame, op_ret, op_errno);
+        return 0;
+}
+
+
+int32_t
+upcall_setxattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                 dict_t *dict, int32_t flags)
+{
+        upcall_local_init (frame, this, loc->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_setxattr_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->setxattr, loc, dict, flags);
+        return 0;
+}
+
+
+int32_t
+upcall_fsetxattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                      int32_t op_ret, int32_t op_errno)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_cache_invalidate (frame, this, local->inode, NULL,
+                                         GF_UPCALL_ATTR);
+
+        UPCALL_STACK_UNWIND (fsetxattr, frame, op_ret, op_errno);
+        return 0;
+}
+
+
+int32_t
+upcall_fsetxattr (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                  dict_t *dict, int32_t flags)
+{
+        upcall_local_init (frame, this, fd->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_fsetxattr_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fsetxattr, fd, dict, flags);
+        return 0;
+}
+
+
+int32_t
+upcall_removexattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                        int32_t op_ret, int32_t op_errno)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local)
+                upcall_cache_invalidate (frame, this, local->inode, NULL,
+                                         GF_UPCALL_ATTR);
+
+        UPCALL_STACK_UNWIND (removexattr, frame, op_ret, op_errno);
+        return 0;
+}
+
+
+int32_t
+upcall_removexattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                    const char *name)
+{
+        upcall_local_init (frame, this, loc->inode, NULL, NULL, NULL);
+
+        STACK_WIND (frame, upcall_removexattr_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->removexattr, loc, name);
+        return 0;
+}
+
+
+/* create, mknod, mkdir and symlink: the parent gained an entry */
+static void
+upcall_new_entry (call_frame_t *frame, xlator_t *this, inode_t *inode,
+                  struct iatt *postparent)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        upcall_cache_invalidate (frame, this, local->parent, postparent,
+                                 GF_UPCALL_ENTRY | GF_UPCALL_ATTR);
+        upcall_client_register (frame, this, inode);
+}
+
+
+int32_t
+upcall_create_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno, fd_t *fd, inode_t *inode,
+                   struct iatt *buf, struct iatt *preparent,
+                   struct iatt *postparent)
+{
+        if ((op_ret >= 0) && frame->local)
+                upcall_new_entry (frame, this, inode, postparent);
+
+        UPCALL_STACK_UNWIND (create, frame, op_ret, op_errno, fd, inode, buf,
+                             preparent, postparent);
+        return 0;
+}
+
+
+int32_t
+upcall_create (call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+               mode_t mode, fd_t *fd, dict_t *params)
+{
+        upcall_local_init (frame, this, NULL, loc->parent, NULL, NULL);
+
+        STACK_WIND (frame, upcall_create_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->create, loc, flags, mode, fd,
+                    params);
+        return 0;
+}
+
+
+int32_t
+upcall_mknod_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, inode_t *inode,
+                  struct iatt *buf, struct iatt *preparent,
+                  struct iatt *postparent)
+{
+        if ((op_ret >= 0) && frame->local)
+                upcall_new_entry (frame, this, inode, postparent);
+
+        UPCALL_STACK_UNWIND (mknod, frame, op_ret, op_errno, inode, buf,
+                             preparent, postparent);
+        return 0;
+}
+
+
+int32_t
+upcall_mknod (call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+              dev_t rdev, dict_t *params)
+{
+        upcall_local_init (frame, this, NULL, loc->parent, NULL, NULL);
+
+        STACK_WIND (frame, upcall_mknod_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->mknod, loc, mode, rdev, params);
+        return 0;
+}
+
+
+int32_t
+upcall_mkdir_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, inode_t *inode,
+                  struct iatt *buf, struct iatt *preparent,
+                  struct iatt *postparent)
+{
+        if ((op_ret >= 0) && frame->local)
+                upcall_new_entry (frame, this, inode, postparent);
+
+        UPCALL_STACK_UNWIND (mkdir, frame, op_ret, op_errno, inode, buf,
+                             preparent, postparent);
+        return 0;
+}
+
+
+int32_t
+upcall_mkdir (call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+              dict_t *params)
+{
+        upcall_local_init (frame, this, NULL, loc->parent, NULL, NULL);
+
+        STACK_WIND (frame, upcall_mkdir_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->mkdir, loc, mode, params);
+        return 0;
+}
+
+
+int32_t
+upcall_symlink_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, inode_t *inode,
+                    struct iatt *buf, struct iatt *preparent,
+                    struct iatt *postparent)
+{
+        if ((op_ret >= 0) && frame->local)
+                upcall_new_entry (frame, this, inode, postparent);
+
+        UPCALL_STACK_UNWIND (symlink, frame, op_ret, op_errno, inode, buf,
+                             preparent, postparent);
+        return 0;
+}
+
+
+int32_t
+upcall_symlink (call_frame_t *frame, xlator_t *this, const char *linkpath,
+                loc_t *loc, dict_t *params)
+{
+        upcall_local_init (frame, this, NULL, loc->parent, NULL, NULL);
+
+        STACK_WIND (frame, upcall_symlink_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->symlink, linkpath, loc, params);
+        return 0;
+}
+
+
+int32_t
+upcall_link_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, inode_t *inode,
+                 struct iatt *buf, struct iatt *preparent,
+                 struct iatt *postparent)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local) {
+                upcall_cache_invalidate (frame, this, local->inode, buf,
+                                         GF_UPCALL_NAMES | GF_UPCALL_ATTR);
+                upcall_cache_invalidate (frame, this, local->newparent,
+                                         postparent,
+                                         GF_UPCALL_ENTRY | GF_UPCALL_ATTR);
+        }
+
+        UPCALL_STACK_UNWIND (link, frame, op_ret, op_errno, inode, buf,
+                             preparent, postparent);
+        return 0;
+}
+
+
+int32_t
+upcall_link (call_frame_t *frame, xlator_t *this, loc_t *oldloc,
+             loc_t *newloc)
+{
+        upcall_local_init (frame, this, oldloc->inode, NULL, newloc->parent,
+                           NULL);
+
+        STACK_WIND (frame, upcall_link_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->link, oldloc, newloc);
+        return 0;
+}
+
+
+int32_t
+upcall_unlink_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno, struct iatt *preparent,
+                   struct iatt *postparent)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local) {
+                upcall_cache_invalidate (frame, this, local->inode, NULL,
+                                         GF_UPCALL_NAMES | GF_UPCALL_ATTR);
+                upcall_cache_invalidate (frame, this, local->parent,
+                                         postparent,
+                                         GF_UPCALL_ENTRY | GF_UPCALL_ATTR);
+        }
+
+        UPCALL_STACK_UNWIND (unlink, frame, op_ret, op_errno, preparent,
+                             postparent);
+        return 0;
+}
+
+
+int32_t
+upcall_unlink (call_frame_t *frame, xlator_t *this, loc_t *loc)
+{
+        upcall_local_init (frame, this, loc->inode, loc->parent, NULL, NULL);
+
+        STACK_WIND (frame, upcall_unlink_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->unlink, loc);
+        return 0;
+}
+
+
+int32_t
+upcall_rmdir_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iatt *preparent,
+                  struct iatt *postparent)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local) {
+                upcall_cache_invalidate (frame, this, local->inode, NULL,
+                                         GF_UPCALL_NAMES | GF_UPCALL_ATTR);
+                upcall_cache_invalidate (frame, this, local->parent,
+                                         postparent,
+                                         GF_UPCALL_ENTRY | GF_UPCALL_ATTR);
+        }
+
+        UPCALL_STACK_UNWIND (rmdir, frame, op_ret, op_errno, preparent,
+                             postparent);
+        return 0;
+}
+
+
+int32_t
+upcall_rmdir (call_frame_t *frame, xlator_t *this, loc_t *loc, int flags)
+{
+        upcall_local_init (frame, this, loc->inode, loc->parent, NULL, NULL);
+
+        STACK_WIND (frame, upcall_rmdir_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->rmdir, loc, flags);
+        return 0;
+}
+
+
+int32_t
+upcall_rename_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno, struct iatt *buf,
+                   struct iatt *preoldparent, struct iatt *postoldparent,
+                   struct iatt *prenewparent, struct iatt *postnewparent)
+{
+        upcall_local_t *local = NULL;
+
+        local = frame->local;
+
+        if ((op_ret >= 0) && local) {
+                upcall_cache_invalidate (frame, this, local->inode, buf,
+                                         GF_UPCALL_NAMES | GF_UPCALL_ATTR);
+                upcall_cache_invalidate (frame, this, local->parent,
+                                         postoldparent,
+                                         GF_UPCALL_ENTRY | GF_UPCALL_ATTR);
+
+                if (local->newparent != local->parent)
+                        upcall_cache_invalidate (frame, this,
+                                                 local->newparent,
+                                                 postnewparent,
+                                                 GF_UPCALL_ENTRY
+                                                 | GF_UPCALL_ATTR);
+
+                if (local->victim && (local->victim != local->inode))
+                        upcall_cache_invalidate (frame, this, local->victim,
+                                                 NULL, GF_UPCALL_NAMES
+                                                 | GF_UPCALL_ATTR);
+        }
+
+        UPCALL_STACK_UNWIND (rename, frame, op_ret, op_errno, buf,
+                             preoldparent, postoldparent, prenewparent,
+                             postnewparent);
+        return 0;
+}
+
+
+int32_t
+upcall_rename (call_frame_t *frame, xlator_t *this, loc_t *oldloc,
+               loc_t *newloc)
+{
+        upcall_local_init (frame, this, oldloc->inode, oldloc->parent,
+                           newloc->parent, newloc->inode);
+
+        STACK_WIND (frame, upcall_rename_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->rename, oldloc, newloc);
+        return 0;
+}
+
+
+int32_t
+upcall_forget (xlator_t *this, inode_t *inode)
+{
+        upcall_inode_ctx_t *ctx    = NULL;
+        upcall_client_t    *client = NULL;
+        upcall_client_t    *tmp    = NULL;
+        uint64_t            value  = 0;
+
+        inode_ctx_del (inode, this, &value);
+        if (!value)
+                return 0;
+
+        ctx = (upcall_inode_ctx_t *)(long) value;
+
+        list_for_each_entry_safe (client, tmp, &ctx->clients, list) {
+                list_del (&client->list);
+                GF_FREE (client->client_uid);
+                GF_FREE (client);
+        }
+
+        LOCK_DESTROY (&ctx->lock);
+        GF_FREE (ctx);
+
+        return 0;
+}
+
+
+int32_t
+upcall_priv_dump (xlator_t *this)
+{
+        upcall_private_t *priv = NULL;
+        char              key_prefix[GF_DUMP_MAX_BUF_LEN];
+
+        priv = this->private;
+        if (!priv)
+                return 0;
+
+        gf_proc_dump_build_key (key_prefix, "xlator.features.upcall",
+                                "priv");
+        gf_proc_dump_add_section (key_prefix);
+
+        gf_proc_dump_write ("cache_invalidation", "%s",
+                            priv->cache_invalidation ? "on" : "off");
+        gf_proc_dump_write ("cache_invalidation_timeout", "%d",
+                            priv->timeout);
+        gf_proc_dump_write ("notifications", "%"PRIu64,
+                            priv->notifications);
+        gf_proc_dump_write ("expired_clients", "%"PRIu64, priv->expired);
+
+        return 0;
+}
+
+
+int32_t
+mem_acct_init (xlator_t *this)
+{
+        int     ret = -1;
+
+        if (!this)
+                return ret;
+
+        ret = xlator_mem_acct_init (this, gf_upcall_mt_end + 1);
+
+        if (ret != 0) {
+                gf_log (this->name, GF_LOG_ERROR, "Memory accounting init"
+                        "failed");
+                return ret;
+        }
+
+        return ret;
+}
+
+
+int
+reconfigure (xlator_t *this, dict_t *options)
+{
+        upcall_private_t *priv = NULL;
+        int               ret  = -1;
+
+        priv = this->private;
+
+        GF_OPTION_RECONF ("cache-invalidation", priv->cache_invalidation,
+                          options, bool, out);
+
+        GF_OPTION_RECONF ("cache-invalidation-timeout", priv->timeout,
+                          options, int32, out);
+
+        ret = 0;
+out:
+        return ret;
+}
+
+
+int
+init (xlator_t *this)
+{
+        upcall_private_t *priv = NULL;
+        int               ret  = -1;
+
+        if (!this->children || this->children->next) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "FATAL: upcall not configured with exactly one child");
+                goto out;
+        }
+
+        if (!this->parents) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "dangling volume. check volfile ");
+        }
+
+        priv = GF_CALLOC (1, sizeof (*priv), gf_upcall_mt_private_t);
+        if (!priv)
+                goto out;
+
+        LOCK_INIT (&priv->lock);
+
+        GF_OPTION_INIT ("cache-invalidation", priv->cache_invalidation, bool,
+                        out);
+
+        GF_OPTION_INIT ("cache-invalidation-timeout", priv->timeout, int32,
+                        out);
+
+        this->private = priv;
+        ret = 0;
+out:
+        if (ret && priv) {
+                LOCK_DESTROY (&priv->lock);
+                GF_FREE (priv);
+        }
+
+        return ret;
+}
+
+
+void
+fini (xlator_t *this)
+{
+        upcall_private_t *priv = NULL;
+
+        priv = this->private;
+        if (!priv)
+                return;
+
+        this->private = NULL;
+
+        LOCK_DESTROY (&priv->lock);
+        GF_FREE (priv);
+
+        return;
+}
+
+
+struct xlator_fops fops = {
+        .lookup      = upcall_lookup,
+        .stat        = upcall_stat,
+        .fstat       = upcall_fstat,
+        .open        = upcall_open,
+        .readv       = upcall_readv,
+        .readlink    = upcall_readlink,
+        .getxattr    = upcall_getxattr,
+        .fgetxattr   = upcall_fgetxattr,
+        .opendir     = upcall_opendir,
+        .readdir     = upcall_readdir,
+        .readdirp    = upcall_readdirp,
+        .writev      = upcall_writev,
+        .truncate    = upcall_truncate,
+        .ftruncate   = upcall_ftruncate,
+        .setattr     = upcall_setattr,
+        .fsetattr    = upcall_fsetattr,
+        .setxattr    = upcall_setxattr,
+        .fsetxattr   = upcall_fsetxattr,
+        .removexattr = upcall_removexattr,
+        .create      = upcall_create,
+        .mknod       = upcall_mknod,
+        .mkdir       = upcall_mkdir,
+        .symlink     = upcall_symlink,
+        .link        = upcall_link,
+        .unlink      = upcall_unlink,
+        .rmdir       = upcall_rmdir,
+        .rename      = upcall_rename,
+};
+
+struct xlator_cbks cbks = {
+        .forget      = upcall_forget,
+};
+
+struct xlator_dumpops dumpops = {
+        .priv        = upcall_priv_dump,
+};
+
+struct volume_options options[] = {
+        { .key  = {"cache-invalidation"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Notify clients caching an inode when it is "
+                         "modified by another client"
+        },
+        { .key  = {"cache-invalidation-timeout"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 1,
+          .max  = 3600,
+          .default_value = "60",
+          .description = "Seconds after its last access for which a client "
+                         "is considered to be caching an inode"
+        },
+        { .key  = {NULL} },
+};
@@ -0,0 +1,72 @@
+/*
+   Copyright (c) 2010-2011 Gluster, Inc. <http://www.gluster.com>
+   This file is part of GlusterFS.
+
+   GlusterFS is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 3 of the License,
+   or (at your option) any later version.
+
+   GlusterFS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see
+   <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __UPCALL_H__
+#define __UPCALL_H__
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include "xlator.h"
+#include "upcall-mem-types.h"
+
+/* a client which has (recently) fetched an inode and may be caching it */
+typedef struct {
+        struct list_head  list;
+        char             *client_uid;   /* id of the connection, which
+                                           outlives it: a connection
+                                           taking the address of a gone
+                                           one has an id of its own */
+        time_t            access_time;
+} upcall_client_t;
+
+typedef struct {
+        struct list_head  clients;
+        gf_lock_t         lock;
+} upcall_inode_ctx_t;
+
+typedef struct {
+        gf_boolean_t      cache_invalidation;
+        int32_t           timeout;      /* seconds a client stays
+                                           registered after its last
+                                           access */
+        uint64_t          notifications;
+        uint64_t          expired;
+        gf_lock_t         lock;
+} upcall_private_t;
+
+typedef struct {
+        inode_t          *inode;
+        inode_t          *parent;
+        inode_t          *newparent;    /* link, rename */
+        inode_t          *victim;       /* rename: overwritten target */
+} upcall_local_t;
+
+void upcall_local_free (upcall_local_t *local);
+
+#define UPCALL_STACK_UNWIND(op, frame, params ...) do {         \
+                upcall_local_t *__local = frame->local;         \
+                frame->local = NULL;                            \
+                STACK_UNWIND_STRICT (op, frame, params);        \
+                upcall_local_free (__local);                    \
+        } while (0)
+
+#endif /* __UPCALL_H__ */
@@ -409,3 +409,206 @@ err:
         return -1;
 
 }
+
+
+struct cluster_copy_stream {
+        call_frame_t              *frame;
+        fop_copy_file_range_cbk_t  unwind;
+        xlator_t                  *src;
+        xlator_t                  *dst;
+        fd_t                      *fd_in;
+        fd_t                      *fd_out;
+        off_t                      off_in;
+        off_t                      off_out;
+        size_t                     len;
+        size_t                     copied;
+        size_t                     chunk;
+        struct iatt                stbuf_in;
+        struct iatt                preop;
+        struct iatt                postop;
+};
+
+
+static void
+cluster_copy_stream_done (call_frame_t *frame, xlator_t *this,
+                          int32_t op_errno)
+{
+        struct cluster_copy_stream *stream = NULL;
+        int32_t                     op_ret = 0;
+
+        stream = frame->local;
+
+        /* what was copied before a failure is the result */
+        if (stream->copied)
+                op_ret = stream->copied;
+        else if (op_errno)
+                op_ret = -1;
+
+        stream->unwind (stream->frame, NULL, this, op_ret, op_errno,
+                        &stream->stbuf_in, &stream->preop, &stream->postop);
+
+        fd_unref (stream->fd_in);
+        fd_unref (stream->fd_out);
+
+        STACK_DESTROY (frame->root);
+}
+
+
+static void cluster_copy_stream_read (call_frame_t *frame);
+
+
+static int32_t
+cluster_copy_stream_writev_cbk (call_frame_t *frame, void *cookie,
+                                xlator_t *this, int32_t op_ret,
+                                int32_t op_errno, struct iatt *prebuf,
+                                struct iatt *postbuf)
+{
+        struct cluster_copy_stream *stream = NULL;
+
+        stream = frame->local;
+
+        if (op_ret < 0) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "write of the copy to %s failed: %s",
+                        stream->dst->name, strerror (op_errno));
+                cluster_copy_stream_done (frame, this, op_errno);
+                return 0;
+        }
+
+        stream->postop  = *postbuf;
+        stream->copied += op_ret;
+
+        if ((op_ret < stream->chunk) || (stream->copied >= stream->len)) {
+                cluster_copy_stream_done (frame, this, 0);
+                return 0;
+        }
+
+        cluster_copy_stream_read (frame);
+
+        return 0;
+}
+
+
+static int32_t
+cluster_copy_stream_readv_cbk (call_frame_t *frame, void *cookie,
+                               xlator_t *this, int32_t op_ret,
+                               int32_t op_errno, struct iovec *vector,
+                               int32_t count, struct iatt *stbuf,
+                               struct iobref *iobref)
+{
+        struct cluster_copy_stream *stream = NULL;
+
+        stream = frame->local;
+
+        if (op_ret < 0) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "read of the copy from %s failed: %s",
+                        stream->src->name, strerror (op_errno));
+                cluster_copy_stream_done (frame, this, op_errno);
+                return 0;
+        }
+
+        stream->stbuf_in = *stbuf;
+
+        /* the end of the source */
+        if (op_ret == 0) {
+                cluster_copy_stream_done (frame, this, 0);
+                return 0;
+        }
+
+        stream->chunk = op_ret;
+
+        STACK_WIND (frame, cluster_copy_stream_writev_cbk, stream->dst,
+                    stream->dst->fops->writev, stream->fd_out, vector, count,
+                    stream->off_out + stream->copied, iobref);
+
+        return 0;
+}
+
+
+static void
+cluster_copy_stream_read (call_frame_t *frame)
+{
+        struct cluster_copy_stream *stream = NULL;
+
+        stream = frame->local;
+
+        stream->chunk = min (stream->len - stream->copied,
+                             CLUSTER_COPY_CHUNK_SIZE);
+
+        STACK_WIND (frame, cluster_copy_stream_readv_cbk, stream->src,
+                    stream->src->fops->readv, stream->fd_in, stream->chunk,
+                    stream->off_in + stream->copied);
+}
+
+
+static int32_t
+cluster_copy_stream_fstat_cbk (call_frame_t *frame, void *cookie,
+                               xlator_t *this, int32_t op_ret,
+                               int32_t op_errno, struct iatt *buf)
+{
+        struct cluster_copy_stream *stream = NULL;
+
+        stream = frame->local;
+
+        if (op_ret < 0) {
+                cluster_copy_stream_done (frame, this, op_errno);
+                return 0;
+        }
+
+        /* a copy of nothing still has the attributes of the destination */
+        stream->preop  = *buf;
+        stream->postop = *buf;
+
+        if (stream->len == 0) {
+                cluster_copy_stream_done (frame, this, 0);
+                return 0;
+        }
+
+        cluster_copy_stream_read (frame);
+
+        return 0;
+}
+
+
+int
+cluster_copy_file_range_stream (call_frame_t *frame, xlator_t *this,
+                                xlator_t *src, fd_t *fd_in, off_t off_in,
+                                xlator_t *dst, fd_t *fd_out, off_t off_out,
+                                size_t len, fop_copy_file_range_cbk_t unwind)
+{
+        struct cluster_copy_stream *stream       = NULL;
+        call_frame_t               *stream_frame = NULL;
+
+        stream = GF_CALLOC (1, sizeof (*stream),
+                            gf_common_mt_libxl_copy_stream);
+        if (!stream)
+                return -1;
+
+        stream_frame = copy_frame (frame);
+        if (!stream_frame) {
+                GF_FREE (stream);
+                return -1;
+        }
+
+        stream->frame   = frame;
+        stream->unwind  = unwind;
+        stream->src     = src;
+        stream->dst     = dst;
+        stream->fd_in   = fd_ref (fd_in);
+        stream->fd_out  = fd_ref (fd_out);
+        stream->off_in  = off_in;
+        stream->off_out = off_out;
+        stream->len     = min (len, CLUSTER_COPY_MAX);
+
+        stream_frame->local = stream;
+
+        gf_log (this->name, GF_LOG_DEBUG,
+                "copying %"GF_PRI_SIZET" bytes from %s to %s through the "
+                "client", stream->len, src->name, dst->name);
+
+        STACK_WIND (stream_frame, cluster_copy_stream_fstat_cbk, dst,
+                    dst->fops->fstat, fd_out);
+
+        return 0;
+}
@@ -24,6 +24,10 @@
 #define MARKER_XTIME_TYPE   2
 #define GF_XATTR_QUOTA_SIZE_KEY "trusted.glusterfs.quota.size"
 
+#define CLUSTER_COPY_CHUNK_SIZE (128 * 1024)
+/* the most one copy_file_range does, its count has to fit op_ret */
+#define CLUSTER_COPY_MAX        (1024 * 1024 * 1024)
+
 
 typedef int32_t (*xlator_specf_unwind_t) (call_frame_t *frame,
                                          int op_ret, int op_errno, dict_t *dict);
@@ -85,6 +89,16 @@ cluster_getmarkerattr (call_frame_t *frame,xlator_t *this, loc_t *loc,
 int
 match_uuid_local (const char *name, char *uuid);
 
+/* answers a copy_file_range between two subvolumes, which can not copy
+   between each other, by reading fd_in from src and writing fd_out on
+   dst a chunk at a time. unwind is called with frame and the result, as
+   the cbk of the copy would be; -1 when the copy could not be started */
+int
+cluster_copy_file_range_stream (call_frame_t *frame, xlator_t *this,
+                                xlator_t *src, fd_t *fd_in, off_t off_in,
+                                xlator_t *dst, fd_t *fd_out, off_t off_out,
+                                size_t len, fop_copy_file_range_cbk_t unwind);
+
 
 
 
@@ -40,12 +40,300 @@
 #include "glusterd-op-sm.h"
 #include "glusterd-utils.h"
 #include "glusterd-store.h"
+#include "glusterd-volgen.h"
 #include "run.h"
 
 #include "syscall.h"
 #include "cli1-xdr.h"
 #include "xdr-generic.h"
 
+#define GLUSTERD_DEFRAG_PARALLEL_FILES     4
+#define GLUSTERD_DEFRAG_MAX_PARALLEL_FILES 64
+
+/* a directory whose files are being migrated; its layout is committed
+   once the last of them is done, if none was left behind */
+struct gf_defrag_dir {
+        char                 *path;
+        int                   pending; /* queued files, +1 for the walk */
+        int                   settled;
+};
+
+struct gf_defrag_file {
+        struct list_head      list;
+        char                 *path;
+        uint64_t              size;
+        struct gf_defrag_dir *dir;
+};
+
+
+static void
+gf_glusterd_rebalance_dir_unref (glusterd_volinfo_t *volinfo,
+                                 struct gf_defrag_dir *dir)
+{
+        glusterd_defrag_info_t *defrag  = NULL;
+        int                     pending = 0;
+
+        defrag = volinfo->defrag;
+
+        pthread_mutex_lock (&defrag->queue_mutex);
+        {
+                pending = --dir->pending;
+        }
+        pthread_mutex_unlock (&defrag->queue_mutex);
+
+        if (pending)
+                return;
+
+        /* all the files of this directory are on their hashed subvolume
+           now, let distribute answer lookups of missing names in it from
+           the hashed subvolume alone */
+        if (dir->settled && (volinfo->defrag_status ==
+                             GF_DEFRAG_STATUS_MIGRATE_DATA_STARTED))
+                sys_lsetxattr (dir->path, "distribute.commit.layout",
+                               "yes", 3, 0);
+
+        GF_FREE (dir->path);
+        GF_FREE (dir);
+}
+
+
+static void
+gf_glusterd_rebalance_dir_unsettle (glusterd_volinfo_t *volinfo,
+                                    struct gf_defrag_dir *dir)
+{
+        pthread_mutex_lock (&volinfo->defrag->queue_mutex);
+        {
+                dir->settled = 0;
+        }
+        pthread_mutex_unlock (&volinfo->defrag->queue_mutex);
+}
+
+
+/* return values - 0: file is on its hashed subvolume, 1: it is not */
+static int
+gf_glusterd_rebalance_migrate_file (glusterd_volinfo_t *volinfo,
+                                    struct gf_defrag_file *file)
+{
+        int                     ret                    = -1;
+        glusterd_defrag_info_t *defrag                 = NULL;
+        char                    linkinfo[PATH_MAX]     = {0,};
+        char                   *force_string           = NULL;
+
+        defrag = volinfo->defrag;
+
+        if ((defrag->cmd == GF_DEFRAG_CMD_START_MIGRATE_DATA_FORCE) ||
+            (defrag->cmd == GF_DEFRAG_CMD_START_FORCE)) {
+                force_string = "force";
+        } else {
+                force_string = "not-force";
+        }
+
+        /* if distribute is present, it will honor this key.
+           -1 is returned if distribute is not present or file doesn't
+           have a link-file. If file has link-file, the path of
+           link-file will be the value, and also that guarantees
+           that file has to be mostly migrated */
+        ret = sys_lgetxattr (file->path, GF_XATTR_LINKINFO_KEY,
+                             &linkinfo, PATH_MAX);
+        if (ret <= 0) {
+                /* ENODATA: file is on its hashed subvolume,
+                   anything else may be a misplaced file */
+                if ((ret == -1) && (errno != ENODATA))
+                        return 1;
+                return 0;
+        }
+
+        ret = sys_lsetxattr (file->path, "distribute.migrate-data",
+                             force_string, strlen (force_string), 0);
+
+        /* EEXIST: file is already on its hashed subvolume */
+        if (ret == -1)
+                return ((errno == EEXIST) ? 0 : 1);
+
+        LOCK (&defrag->lock);
+        {
+                defrag->total_files += 1;
+                defrag->total_data += file->size;
+        }
+        UNLOCK (&defrag->lock);
+
+        return 0;
+}
+
+
+static void *
+gf_glusterd_rebalance_worker (void *data)
+{
+        glusterd_volinfo_t     *volinfo = NULL;
+        glusterd_defrag_info_t *defrag  = NULL;
+        struct gf_defrag_file  *file    = NULL;
+        int                     ret     = 0;
+
+        volinfo = data;
+        defrag  = volinfo->defrag;
+
+        THIS = volinfo->xl;
+
+        for (;;) {
+                pthread_mutex_lock (&defrag->queue_mutex);
+                {
+                        while (list_empty (&defrag->queue) &&
+                               !defrag->queue_done)
+                                pthread_cond_wait (&defrag->queue_cond,
+                                                   &defrag->queue_mutex);
+
+                        if (list_empty (&defrag->queue)) {
+                                pthread_mutex_unlock (&defrag->queue_mutex);
+                                break;
+                        }
+
+                        file = list_entry (defrag->queue.next,
+                                           struct gf_defrag_file, list);
+                        list_del_init (&file->list);
+                        defrag->queue_len--;
+                        pthread_cond_broadcast (&defrag->queue_cond);
+                }
+                pthread_mutex_unlock (&defrag->queue_mutex);
+
+                /* after 'stop' the queue is only drained */
+                ret = 1;
+                if (volinfo->defrag_status ==
+                    GF_DEFRAG_STATUS_MIGRATE_DATA_STARTED)
+                        ret = gf_glusterd_rebalance_migrate_file (volinfo,
+                                                                  file);
+                if (ret)
+                        gf_glusterd_rebalance_dir_unsettle (volinfo,
+                                                            file->dir);
+
+                gf_glusterd_rebalance_dir_unref (volinfo, file->dir);
+
+                GF_FREE (file->path);
+                GF_FREE (file);
+        }
+
+        return NULL;
+}
+
+
+static int
+gf_glusterd_rebalance_queue_file (glusterd_volinfo_t *volinfo,
+                                  struct gf_defrag_dir *dir,
+                                  const char *path, struct stat *stbuf)
+{
+        glusterd_defrag_info_t *defrag = NULL;
+        struct gf_defrag_file  *file   = NULL;
+
+        defrag = volinfo->defrag;
+
+        file = GF_CALLOC (1, sizeof (*file), gf_gld_mt_defrag_file_t);
+        if (!file)
+                return -1;
+
+        file->path = gf_strdup (path);
+        if (!file->path) {
+                GF_FREE (file);
+                return -1;
+        }
+        file->size = stbuf->st_size;
+        file->dir  = dir;
+        INIT_LIST_HEAD (&file->list);
+
+        pthread_mutex_lock (&defrag->queue_mutex);
+        {
+                /* keep the walk only a little ahead of the workers */
+                while (defrag->queue_len >= (2 * defrag->worker_cnt))
+                        pthread_cond_wait (&defrag->queue_cond,
+                                           &defrag->queue_mutex);
+
+                list_add_tail (&file->list, &defrag->queue);
+                defrag->queue_len++;
+                dir->pending++;
+                pthread_cond_broadcast (&defrag->queue_cond);
+        }
+        pthread_mutex_unlock (&defrag->queue_mutex);
+
+        return 0;
+}
+
+
+static int
+gf_glusterd_rebalance_workers_start (glusterd_volinfo_t *volinfo)
+{
+        glusterd_defrag_info_t *defrag   = NULL;
+        char                   *value    = NULL;
+        int                     parallel = GLUSTERD_DEFRAG_PARALLEL_FILES;
+        int                     i        = 0;
+        int                     ret      = -1;
+
+        defrag = volinfo->defrag;
+
+        ret = glusterd_volinfo_get (volinfo, "cluster.rebalance-parallel-files",
+                                    &value);
+        if (!ret && value && gf_string2int (value, &parallel))
+                parallel = GLUSTERD_DEFRAG_PARALLEL_FILES;
+        if (parallel < 1)
+                parallel = 1;
+        if (parallel > GLUSTERD_DEFRAG_MAX_PARALLEL_FILES)
+                parallel = GLUSTERD_DEFRAG_MAX_PARALLEL_FILES;
+
+        pthread_mutex_init (&defrag->queue_mutex, NULL);
+        pthread_cond_init (&defrag->queue_cond, NULL);
+        INIT_LIST_HEAD (&defrag->queue);
+        defrag->queue_len  = 0;
+        defrag->queue_done = 0;
+        defrag->worker_cnt = 0;
+
+        defrag->workers = GF_CALLOC (parallel, sizeof (pthread_t),
+                                     gf_gld_mt_defrag_worker_t);
+        if (!defrag->workers)
+                return -1;
+
+        for (i = 0; i < parallel; i++) {
+                ret = pthread_create (&defrag->workers[i], NULL,
+                                      gf_glusterd_rebalance_worker, volinfo);
+                if (ret) {
+                        gf_log (THIS->name, GF_LOG_WARNING,
+                                "failed to start rebalance worker (%s)",
+                                strerror (ret));
+                        break;
+                }
+                defrag->worker_cnt++;
+        }
+
+        gf_log (THIS->name, GF_LOG_INFO,
+                "migrating up to %d files in parallel", defrag->worker_cnt);
+
+        return (defrag->worker_cnt ? 0 : -1);
+}
+
+
+static void
+gf_glusterd_rebalance_workers_stop (glusterd_volinfo_t *volinfo)
+{
+        glusterd_defrag_info_t *defrag = NULL;
+        int                     i      = 0;
+
+        defrag = volinfo->defrag;
+
+        pthread_mutex_lock (&defrag->queue_mutex);
+        {
+                defrag->queue_done = 1;
+                pthread_cond_broadcast (&defrag->queue_cond);
+        }
+        pthread_mutex_unlock (&defrag->queue_mutex);
+
+        for (i = 0; i < defrag->worker_cnt; i++)
+                pthread_join (defrag->workers[i], NULL);
+
+        GF_FREE (defrag->workers);
+        defrag->workers = NULL;
+        defrag->worker_cnt = 0;
+
+        pthread_cond_destroy (&defrag->queue_cond);
+        pthread_mutex_destroy (&defrag->queue_mutex);
+}
+
+
 /* return values - 0: success, +ve: stopped, -ve: failure */
 int
 gf_glusterd_rebalance_move_data (glusterd_volinfo_t *volinfo, const char *dir)
@@ -56,8 +344,7 @@ gf_glusterd_rebalance_move_data (glusterd_volinfo_t *volinfo, const char *dir)
         struct dirent          *entry                  = NULL;
         struct stat             stbuf                  = {0,};
         char                    full_path[PATH_MAX]    = {0,};
-        char                    linkinfo[PATH_MAX]     = {0,};
-        char                    force_string[64]       = {0,};
+        struct gf_defrag_dir   *defrag_dir             = NULL;
 
         if (!volinfo->defrag)
                 goto out;
@@ -68,13 +355,18 @@ gf_glusterd_rebalance_move_data (glusterd_volinfo_t *volinfo, const char *dir)
         if (!fd)
                 goto out;
 
-        if ((defrag->cmd == GF_DEFRAG_CMD_START_MIGRATE_DATA_FORCE) ||
-            (defrag->cmd == GF_DEFRAG_CMD_START_FORCE)) {
-                strcpy (force_string, "force");
-        } else {
-                strcpy (force_string, "not-force");
+        defrag_dir = GF_CALLOC (1, sizeof (*defrag_dir),
+                                gf_gld_mt_defrag_dir_t);
+        if (!defrag_dir) {
+                closedir (fd);
+                goto out;
         }
+        defrag_dir->path = gf_strdup (dir);
+        defrag_dir->pending = 1;
+        defrag_dir->settled = (defrag_dir->path != NULL);
 
+        /* files are handed over to the workers, which migrate them in
+           parallel; the directory is settled when the last one is done */
         while ((entry = readdir (fd))) {
                 if (!entry)
                         break;
@@ -85,6 +377,7 @@ gf_glusterd_rebalance_move_data (glusterd_volinfo_t *volinfo, const char *dir)
                     GF_DEFRAG_STATUS_MIGRATE_DATA_STARTED) {
                         /* It can be one of 'stopped|paused|commit' etc */
                         closedir (fd);
+                        gf_glusterd_rebalance_dir_unref (volinfo, defrag_dir);
                         ret = 1;
                         goto out;
                 }
@@ -101,56 +394,30 @@ gf_glusterd_rebalance_move_data (glusterd_volinfo_t *volinfo, const char *dir)
                 if (S_ISDIR (stbuf.st_mode))
                         continue;
 
-                defrag->num_files_lookedup += 1;
+                LOCK (&defrag->lock);
+                {
+                        defrag->num_files_lookedup += 1;
+                        defrag->total_scanned += stbuf.st_size;
+                }
+                UNLOCK (&defrag->lock);
 
                 /* TODO: bring in feature to support hardlink rebalance */
-                if (stbuf.st_nlink > 1)
-                        continue;
-
-                /* if distribute is present, it will honor this key.
-                   -1 is returned if distribute is not present or file doesn't
-                   have a link-file. If file has link-file, the path of
-                   link-file will be the value, and also that guarantees
-                   that file has to be mostly migrated */
-                ret = sys_lgetxattr (full_path, GF_XATTR_LINKINFO_KEY,
-                                     &linkinfo, PATH_MAX);
-                if (ret <= 0)
-                        continue;
-
-                ret = sys_lsetxattr (full_path, "distribute.migrate-data",
-                                     force_string, strlen (force_string), 0);
-
-                /* if errno is not ENOSPC or ENOTCONN, we can still continue
-                   with rebalance process */
-                if ((ret == -1) && ((errno != ENOSPC) ||
-                                    (errno != ENOTCONN)))
+                if (stbuf.st_nlink > 1) {
+                        gf_glusterd_rebalance_dir_unsettle (volinfo,
+                                                            defrag_dir);
                         continue;
-
-                if ((ret == -1) && (errno == ENOTCONN)) {
-                        /* Most probably mount point went missing (mostly due
-                           to a brick down), say rebalance failure to user,
-                           let him restart it if everything is fine */
-                        volinfo->defrag_status = GF_DEFRAG_STATUS_FAILED;
-                        break;
                 }
 
-                if ((ret == -1) && (errno == ENOSPC)) {
-                        /* rebalance process itself failed, may be
-                           remote brick went down, or write failed due to
-                           disk full etc etc.. */
-                        volinfo->defrag_status = GF_DEFRAG_STATUS_FAILED;
-                        break;
-                }
-
-                LOCK (&defrag->lock);
-                {
-                        defrag->total_files += 1;
-                        defrag->total_data += stbuf.st_size;
-                }
-                UNLOCK (&defrag->lock);
+                ret = gf_glusterd_rebalance_queue_file (volinfo, defrag_dir,
+                                                        full_path, &stbuf);
+                if (ret)
+                        gf_glusterd_rebalance_dir_unsettle (volinfo,
+                                                            defrag_dir);
         }
         closedir (fd);
 
+        gf_glusterd_rebalance_dir_unref (volinfo, defrag_dir);
+
         fd = opendir (dir);
         if (!fd)
                 goto out;
@@ -263,12 +530,15 @@ glusterd_defrag_start (void *data)
         glusterd_defrag_info_t *defrag  = NULL;
         int                     ret     = -1;
         struct stat             stbuf   = {0,};
+        struct statvfs          svfs    = {0,};
 
         THIS = volinfo->xl;
         defrag = volinfo->defrag;
         if (!defrag)
                 goto out;
 
+        volinfo->rebalance_time = 0;
+
         sleep (1);
         ret = lstat (defrag->mount, &stbuf);
         if ((ret == -1) && (errno == ENOTCONN)) {
@@ -312,8 +582,27 @@ glusterd_defrag_start (void *data)
 
                 volinfo->defrag_status = GF_DEFRAG_STATUS_MIGRATE_DATA_STARTED;
 
+                /* what is in use now is what the walk has to go through,
+                   progress against it gives the ETA */
+                if (!statvfs (defrag->mount, &svfs))
+                        defrag->volume_used = ((svfs.f_blocks - svfs.f_bfree) *
+                                               svfs.f_frsize);
+                defrag->start_time = time (NULL);
+
+                ret = gf_glusterd_rebalance_workers_start (volinfo);
+                if (ret) {
+                        volinfo->defrag_status = GF_DEFRAG_STATUS_FAILED;
+                        goto out;
+                }
+
                 /* Step 2: Iterate over directories to move data */
                 ret = gf_glusterd_rebalance_move_data (volinfo, defrag->mount);
+
+                /* let the workers finish with what is already queued */
+                gf_glusterd_rebalance_workers_stop (volinfo);
+
+                volinfo->rebalance_time = time (NULL) - defrag->start_time;
+
                 if (ret < 0)
                         volinfo->defrag_status = GF_DEFRAG_STATUS_FAILED;
                 /* in both 'stopped' or 'failure' cases goto out */
@@ -414,10 +703,15 @@ int
 glusterd_defrag_status_get (glusterd_volinfo_t *volinfo,
                             dict_t *dict)
 {
-        int      ret    = 0;
-        uint64_t files  = 0;
-        uint64_t size   = 0;
-        uint64_t lookup = 0;
+        int      ret     = 0;
+        uint64_t files   = 0;
+        uint64_t size    = 0;
+        uint64_t lookup  = 0;
+        uint64_t scanned = 0;
+        uint64_t used    = 0;
+        uint64_t elapsed = 0;
+        uint64_t eta     = 0;
+        time_t   start   = 0;
 
         if (!volinfo || !dict)
                 goto out;
@@ -429,15 +723,28 @@ glusterd_defrag_status_get (glusterd_volinfo_t *volinfo,
         if (volinfo->defrag) {
                 LOCK (&volinfo->defrag->lock);
                 {
-                        files  = volinfo->defrag->total_files;
-                        size   = volinfo->defrag->total_data;
-                        lookup = volinfo->defrag->num_files_lookedup;
+                        files   = volinfo->defrag->total_files;
+                        size    = volinfo->defrag->total_data;
+                        lookup  = volinfo->defrag->num_files_lookedup;
+                        scanned = volinfo->defrag->total_scanned;
+                        used    = volinfo->defrag->volume_used;
+                        start   = volinfo->defrag->start_time;
                 }
                 UNLOCK (&volinfo->defrag->lock);
+
+                if (start)
+                        elapsed = time (NULL) - start;
+
+                /* the part of the volume still to be walked takes as long
+                   as the part walked so far did */
+                if (elapsed && scanned && (scanned < used))
+                        eta = (elapsed * ((used - scanned) /
+                                          (double) scanned));
         } else {
-                files  = volinfo->rebalance_files;
-                size   = volinfo->rebalance_data;
-                lookup = volinfo->lookedup_files;
+                files   = volinfo->rebalance_files;
+                size    = volinfo->rebalance_data;
+                lookup  = volinfo->lookedup_files;
+                elapsed = volinfo->rebalance_time;
         }
 
         ret = dict_set_uint64 (dict, "files", files);
@@ -455,6 +762,16 @@ glusterd_defrag_status_get (glusterd_volinfo_t *volinfo,
                 gf_log (THIS->name, GF_LOG_WARNING,
                         "failed to set lookedup file count");
 
+        ret = dict_set_uint64 (dict, "elapsed", elapsed);
+        if (ret)
+                gf_log (THIS->name, GF_LOG_WARNING,
+                        "failed to set elapsed time");
+
+        ret = dict_set_uint64 (dict, "eta", eta);
+        if (ret)
+                gf_log (THIS->name, GF_LOG_WARNING,
+                        "failed to set estimated time left");
+
         ret = dict_set_int32 (dict, "status", volinfo->defrag_status);
         if (ret)
                 gf_log (THIS->name, GF_LOG_WARNING,
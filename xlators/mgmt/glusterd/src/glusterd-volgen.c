@@ -112,6 +112,11 @@ static struct volopt_map_entry glusterd_volopt_map[] = {
         {"cluster.lookup-unhashed",              "cluster/distribute", NULL, NULL, NO_DOC, 0    },
         {"cluster.min-free-disk",                "cluster/distribute", NULL, NULL, NO_DOC, 0    },
 	{"cluster.min-free-inodes",              "cluster/distribute", NULL, NULL, NO_DOC, 0    },
+        {"cluster.rebalance-read-window",        "cluster/distribute", NULL, NULL, NO_DOC, 0    },
+        {"cluster.rebalance-throttle-latency",   "cluster/distribute", NULL, NULL, NO_DOC, 0    },
+        {"cluster.rebalance-parallel-files",     "cluster/distribute", "!rebalance-parallel-files", NULL, NO_DOC, 0},
+        {"cluster.weighted-rebalance",           "cluster/distribute", NULL, NULL, NO_DOC, 0    },
+        {"cluster.parallel-readdir",             "cluster/distribute", NULL, NULL, NO_DOC, 0    },
 
         {"cluster.entry-change-log",             "cluster/replicate",  NULL, NULL, NO_DOC, 0     },
         {"cluster.read-subvolume",               "cluster/replicate",  NULL, NULL, NO_DOC, 0    },
@@ -127,6 +132,11 @@ static struct volopt_map_entry glusterd_volopt_map[] = {
         {"cluster.data-self-heal-algorithm",     "cluster/replicate",         "data-self-heal-algorithm", NULL,DOC, 0},
         {"cluster.quorum-type",                  "cluster/replicate",  "quorum-type", NULL, NO_DOC, 0},
         {"cluster.quorum-count",                 "cluster/replicate",  "quorum-count", NULL, NO_DOC, 0},
+        {"cluster.eager-lock",                   "cluster/replicate",  NULL, NULL, NO_DOC, 0     },
+        {"cluster.post-op-delay-secs",           "cluster/replicate",  NULL, NULL, NO_DOC, 0     },
+        {"cluster.read-policy",                  "cluster/replicate",  NULL, NULL, NO_DOC, 0     },
+        {"cluster.heal-wait-queue-length",       "cluster/replicate",  NULL, NULL, NO_DOC, 0     },
+        {"cluster.data-self-heal-bandwidth",     "cluster/replicate",  NULL, NULL, NO_DOC, 0     },
 
         {"cluster.stripe-block-size",            "cluster/stripe",            "block-size", NULL, DOC, 0},
 
@@ -145,9 +155,12 @@ static struct volopt_map_entry glusterd_volopt_map[] = {
         {"performance.cache-priority",           "performance/io-cache",      "priority", NULL, DOC, 0},
         {"performance.cache-size",               "performance/io-cache",   NULL, NULL, NO_DOC, 0 },
         {"performance.cache-size",               "performance/quick-read", NULL, NULL, NO_DOC, 0 },
+        {"performance.quick-read-compression",   "performance/quick-read", "cache-compression", NULL, DOC, 0},
         {"performance.flush-behind",             "performance/write-behind",      "flush-behind", NULL, DOC, 0},
 
         {"performance.io-thread-count",          "performance/io-threads",    "thread-count", DOC, 0},
+        {"performance.io-thread-autoscaling",    "performance/io-threads",    "autoscaling", NULL, DOC, 0},
+        {"performance.io-thread-wait-target",    "performance/io-threads",    "queue-wait-target", NULL, DOC, 0},
 
         {"performance.disk-usage-limit",         "performance/quota",   NULL, NULL, NO_DOC, 0    },
         {"performance.min-free-disk-limit",      "performance/quota",   NULL, NULL, NO_DOC, 0    },
@@ -164,6 +177,7 @@ static struct volopt_map_entry glusterd_volopt_map[] = {
         {"transport.keepalive",                   "protocol/server",           "transport.socket.keepalive", NULL, NO_DOC, 0},
         {"server.allow-insecure",                 "protocol/server",          "rpc-auth-allow-insecure", NULL, NO_DOC, 0},
 
+        {"performance.readdir-ahead",            "performance/readdir-ahead", "!perf", "off", NO_DOC, 0},
         {"performance.write-behind",             "performance/write-behind",  "!perf", "on", NO_DOC, 0},
         {"performance.read-ahead",               "performance/read-ahead",    "!perf", "on", NO_DOC, 0},
         {"performance.io-cache",                 "performance/io-cache",      "!perf", "on", NO_DOC, 0},
@@ -198,6 +212,18 @@ static struct volopt_map_entry glusterd_volopt_map[] = {
         {VKEY_FEATURES_QUOTA,                    "features/marker",           "quota", "off", NO_DOC, OPT_FLAG_FORCE},
         {VKEY_FEATURES_LIMIT_USAGE,              "features/quota",            "limit-set", NULL, NO_DOC, 0},
         {"features.quota-timeout",               "features/quota",            "timeout", "0", DOC, 0},
+        {"features.cache-invalidation",          "features/upcall",           "cache-invalidation", "off", DOC, 0},
+        {"features.cache-invalidation-timeout",  "features/upcall",           "cache-invalidation-timeout", NULL, DOC, 0},
+        {"storage.checksum-type",                "storage/posix",             "checksum-type", NULL, DOC, 0},
+        {"storage.linux-aio",                    "storage/posix",             "linux-aio", NULL, DOC, 0},
+        {"storage.handle-cache-size",            "storage/posix",             "handle-cache-size", NULL, DOC, 0},
+        {"storage.xattr-cache",                  "storage/posix",             "xattr-cache", NULL, DOC, 0},
+        {"storage.xattrop-batch",                "storage/posix",             "xattrop-batch", NULL, DOC, 0},
+        {"storage.xattrop-flush-interval",       "storage/posix",             "xattrop-flush-interval", NULL, DOC, 0},
+        {"storage.readdirp-threads",             "storage/posix",             "readdirp-threads", NULL, DOC, 0},
+        {"storage.zero-copy-read",               "storage/posix",             "zero-copy-read", NULL, DOC, 0},
+        {"storage.pack-small-files",             "storage/posix",             "pack-small-files", NULL, DOC, 0},
+        {"storage.pack-threshold",               "storage/posix",             "pack-threshold", NULL, DOC, 0},
         {"server.statedump-path",                "protocol/server",           "statedump-path", NULL, NO_DOC, 0},
         {NULL,                                                                }
 };
@@ -1492,6 +1518,7 @@ server_graph_builder (volgen_graph_t *graph, glusterd_volinfo_t *volinfo,
         char     *ptranst               = NULL;
         char      volume_id[64]         = {0,};
         char      tstamp_file[PATH_MAX] = {0,};
+        char      index_basepath[PATH_MAX] = {0,};
         int       ret                   = 0;
         char     *xlator                = NULL;
         char     *loglevel              = NULL;
@@ -1525,6 +1552,16 @@ server_graph_builder (volgen_graph_t *graph, glusterd_volinfo_t *volinfo,
         if (ret)
                 return -1;
 
+        xl = volgen_graph_add (graph, "features/index", volname);
+        if (!xl)
+                return -1;
+
+        snprintf (index_basepath, sizeof (index_basepath), "%s/%s",
+                  path, ".glusterfs/indices");
+        ret = xlator_set_option (xl, "index-base", index_basepath);
+        if (ret)
+                return -1;
+
         xl = volgen_graph_add (graph, "features/access-control", volname);
         if (!xl)
                 return -1;
@@ -1583,6 +1620,10 @@ server_graph_builder (volgen_graph_t *graph, glusterd_volinfo_t *volinfo,
         if (ret)
                 return -1;
 
+        xl = volgen_graph_add (graph, "features/upcall", volname);
+        if (!xl)
+                return -1;
+
         xl = volgen_graph_add_as (graph, "debug/io-stats", path);
         if (!xl)
                 return -1;
@@ -167,6 +167,20 @@ struct glusterd_defrag_info_ {
         struct gf_defrag_brickinfo_ *bricks; /* volinfo->brick_count */
 
         defrag_cbk_fn_t              cbk_fn;
+
+        /* files found by the directory walk, migrated by 'workers' */
+        pthread_mutex_t              queue_mutex;
+        pthread_cond_t               queue_cond;
+        struct list_head             queue;
+        int                          queue_len;
+        int                          queue_done;
+        int                          worker_cnt;
+        pthread_t                   *workers;
+
+        /* progress, for throughput and ETA in status */
+        time_t                       start_time;
+        uint64_t                     total_scanned; /* bytes looked up */
+        uint64_t                     volume_used;   /* bytes at start */
 };
 
 
@@ -207,6 +221,7 @@ struct glusterd_volinfo_ {
         uint64_t                rebalance_files;
         uint64_t                rebalance_data;
         uint64_t                lookedup_files;
+        uint64_t                rebalance_time;
         glusterd_defrag_info_t  *defrag;
 
         /* Replace brick status */
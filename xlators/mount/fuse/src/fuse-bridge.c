@@ -185,6 +185,47 @@ fuse_invalidate (xlator_t *this, uint64_t fuse_ino)
         }
 }
 
+/* @off 0 drops the page cache and the attributes of the inode, -1 only the
+ * attributes.
+ */
+static void
+fuse_invalidate_inode (xlator_t *this, uint64_t fuse_ino, int64_t off)
+{
+        struct fuse_out_header             *fouh   = NULL;
+        struct fuse_notify_inval_inode_out *fniio  = NULL;
+        fuse_private_t                     *priv   = NULL;
+        int                                 rv     = 0;
+
+        char inval_buf[INVAL_BUF_SIZE] = {0,};
+
+        fouh  = (struct fuse_out_header *)inval_buf;
+        fniio = (struct fuse_notify_inval_inode_out *)(fouh + 1);
+
+        priv = this->private;
+        if (priv->revchan_out == -1)
+                return;
+
+        fouh->unique = 0;
+        fouh->error = FUSE_NOTIFY_INVAL_INODE;
+        fouh->len = sizeof (*fouh) + sizeof (*fniio);
+
+        fniio->ino = fuse_ino;
+        fniio->off = off;
+        fniio->len = 0;
+
+        rv = write (priv->revchan_out, inval_buf, fouh->len);
+        if (rv != fouh->len) {
+                gf_log ("glusterfs-fuse", GF_LOG_ERROR,
+                        "kernel notification daemon defunct");
+
+                close (priv->fd);
+                return;
+        }
+
+        gf_log ("glusterfs-fuse", GF_LOG_TRACE, "INVALIDATE inode: "
+                "%"PRIu64" (off %"PRId64")", fuse_ino, off);
+}
+
 int
 send_fuse_err (xlator_t *this, fuse_in_header_t *finh, int error)
 {
@@ -1007,6 +1048,55 @@ fuse_fsync_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 }
 
 
+#if defined(GF_LINUX_HOST_OS) || defined(__NetBSD__)
+static int
+fuse_fallocate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                    struct iatt *postbuf)
+{
+        return fuse_err_cbk (frame, cookie, this, op_ret, op_errno);
+}
+#endif
+
+
+#if defined(GF_LINUX_HOST_OS) || defined(__NetBSD__)
+static int
+fuse_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                          int32_t op_ret, int32_t op_errno,
+                          struct iatt *stbuf_in, struct iatt *prebuf,
+                          struct iatt *postbuf)
+{
+        fuse_state_t *state = NULL;
+        fuse_in_header_t *finh = NULL;
+        struct fuse_write_out fwo = {0, };
+
+        state = frame->root->state;
+        finh = state->finh;
+
+        if (op_ret >= 0) {
+                gf_log ("glusterfs-fuse", GF_LOG_TRACE,
+                        "%"PRIu64": COPY_FILE_RANGE => %d/%"GF_PRI_SIZET,
+                        frame->root->unique, op_ret, state->size);
+
+                fwo.size = op_ret;
+                send_fuse_obj (this, finh, &fwo);
+        } else {
+                gf_log ("glusterfs-fuse",
+                        (op_errno == EXDEV) ? GF_LOG_DEBUG : GF_LOG_WARNING,
+                        "%"PRIu64": COPY_FILE_RANGE => -1 (%s)",
+                        frame->root->unique, strerror (op_errno));
+
+                send_fuse_err (this, finh, op_errno);
+        }
+
+        free_fuse_state (state);
+        STACK_DESTROY (frame->root);
+
+        return 0;
+}
+#endif
+
+
 static int
 fuse_setxattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                    int32_t op_ret, int32_t op_errno)
@@ -1462,6 +1552,51 @@ fuse_rmdir (xlator_t *this, fuse_in_header_t *finh, void *msg)
         return;
 }
 
+static int
+fuse_rmtree_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *preparent,
+                 struct iatt *postparent)
+{
+        fuse_state_t *state = NULL;
+
+        state = frame->root->state;
+
+        /* the kernel still has the entry of the directory and whatever
+           it has looked up below it */
+        if (op_ret == 0)
+                fuse_invalidate (this, state->finh->nodeid);
+
+        return fuse_unlink_cbk (frame, cookie, this, op_ret, op_errno,
+                                preparent, postparent);
+}
+
+void
+fuse_rmtree_resume (fuse_state_t *state)
+{
+        if (!state->loc.inode || !state->loc.parent) {
+                gf_log ("glusterfs-fuse", GF_LOG_WARNING,
+                        "%"PRIu64": RMTREE %s: no parent to remove it from",
+                        state->finh->unique, state->loc.path);
+                send_fuse_err (state->this, state->finh, EINVAL);
+                free_fuse_state (state);
+                return;
+        }
+
+        if (!IA_ISDIR (state->loc.inode->ia_type)) {
+                send_fuse_err (state->this, state->finh, ENOTDIR);
+                free_fuse_state (state);
+                return;
+        }
+
+        gf_log ("glusterfs-fuse", GF_LOG_TRACE,
+                "%"PRIu64": RMTREE %s", state->finh->unique,
+                state->loc.path);
+
+        /* rmdir with flags set removes the directory with its contents */
+        FUSE_FOP (state, fuse_rmtree_cbk, GF_FOP_RMDIR,
+                  rmdir, &state->loc, 1);
+}
+
 void
 fuse_symlink_resume (fuse_state_t *state)
 {
@@ -2253,6 +2388,102 @@ fuse_fsync (xlator_t *this, fuse_in_header_t *finh, void *msg)
         return;
 }
 
+#if defined(GF_LINUX_HOST_OS) || defined(__NetBSD__)
+/* same values as the FALLOC_FL_* flags of fallocate(2) */
+#define FUSE_FALLOC_KEEP_SIZE   0x01
+#define FUSE_FALLOC_PUNCH_HOLE  0x02
+
+void
+fuse_fallocate_resume (fuse_state_t *state)
+{
+        if (state->flags & FUSE_FALLOC_PUNCH_HOLE) {
+                FUSE_FOP (state, fuse_fallocate_cbk, GF_FOP_DISCARD,
+                          discard, state->fd, state->off, state->size);
+        } else {
+                FUSE_FOP (state, fuse_fallocate_cbk, GF_FOP_FALLOCATE,
+                          fallocate, state->fd,
+                          state->flags & FUSE_FALLOC_KEEP_SIZE, state->off,
+                          state->size);
+        }
+}
+
+static void
+fuse_fallocate (xlator_t *this, fuse_in_header_t *finh, void *msg)
+{
+        struct fuse_fallocate_in *ffi = msg;
+
+        fuse_state_t *state = NULL;
+        fd_t         *fd = NULL;
+
+        GET_STATE (this, finh, state);
+        fd = FH_TO_FD (ffi->fh);
+        state->fd = fd;
+
+        gf_log ("glusterfs-fuse", GF_LOG_TRACE,
+                "%"PRIu64": FALLOCATE %p (mode=%"PRIu32", offset=%"PRIu64
+                ", length=%"PRIu64")", finh->unique, fd, ffi->mode,
+                ffi->offset, ffi->length);
+
+        /* a hole is only punched with the size kept, as fallocate(2) */
+        if ((ffi->mode & ~(FUSE_FALLOC_KEEP_SIZE | FUSE_FALLOC_PUNCH_HOLE)) ||
+            ((ffi->mode & FUSE_FALLOC_PUNCH_HOLE) &&
+             !(ffi->mode & FUSE_FALLOC_KEEP_SIZE))) {
+                send_fuse_err (this, finh, EOPNOTSUPP);
+                free_fuse_state (state);
+                return;
+        }
+
+        state->flags = ffi->mode;
+        state->off   = ffi->offset;
+        state->size  = ffi->length;
+        fuse_resolve_and_resume (state, fuse_fallocate_resume);
+        return;
+}
+#endif
+
+#if defined(GF_LINUX_HOST_OS) || defined(__NetBSD__)
+void
+fuse_copy_file_range_resume (fuse_state_t *state)
+{
+        FUSE_FOP (state, fuse_copy_file_range_cbk, GF_FOP_COPY_FILE_RANGE,
+                  copy_file_range, state->fd, state->off, state->fd_out,
+                  state->off_out, state->size, state->flags);
+}
+
+static void
+fuse_copy_file_range (xlator_t *this, fuse_in_header_t *finh, void *msg)
+{
+        struct fuse_copy_file_range_in *fci = msg;
+
+        fuse_state_t *state = NULL;
+
+        GET_STATE (this, finh, state);
+        state->fd     = FH_TO_FD (fci->fh_in);
+        state->fd_out = FH_TO_FD (fci->fh_out);
+
+        gf_log ("glusterfs-fuse", GF_LOG_TRACE,
+                "%"PRIu64": COPY_FILE_RANGE %p (%"PRIu64") -> %p (%"PRIu64
+                "), length=%"PRIu64, finh->unique, state->fd, fci->off_in,
+                state->fd_out, fci->off_out, fci->len);
+
+        /* the fds of another graph than the one of the source can not
+           take part in the copy, the kernel copies it itself then */
+        if (fci->flags || !state->fd || !state->fd_out ||
+            (state->fd->inode->table != state->fd_out->inode->table)) {
+                send_fuse_err (this, finh, fci->flags ? EINVAL : EXDEV);
+                free_fuse_state (state);
+                return;
+        }
+
+        state->off     = fci->off_in;
+        state->off_out = fci->off_out;
+        state->size    = fci->len;
+        state->flags   = 0;
+        fuse_resolve_and_resume (state, fuse_copy_file_range_resume);
+        return;
+}
+#endif
+
 void
 fuse_opendir_resume (fuse_state_t *state)
 {
@@ -2662,6 +2893,14 @@ fuse_setxattr (xlator_t *this, fuse_in_header_t *finh, void *msg)
                 return;
         }
 
+        if (!strcmp (GF_XATTR_RMTREE_KEY, name)) {
+                uuid_copy (state->resolve.gfid, state->loc.inode->gfid);
+                state->resolve.path = gf_strdup (state->loc.path);
+
+                fuse_resolve_and_resume (state, fuse_rmtree_resume);
+                return;
+        }
+
         state->dict = get_new_dict ();
         if (!state->dict) {
                 gf_log ("glusterfs-fuse", GF_LOG_ERROR,
@@ -3721,6 +3960,26 @@ fuse_graph_setup (xlator_t *this, glusterfs_graph_t *graph)
 }
 
 
+static void
+fuse_process_upcall (xlator_t *this, struct gf_upcall *upcall)
+{
+        uint64_t nodeid = 0;
+
+        if (!upcall || !upcall->inode)
+                return;
+
+        nodeid = inode_to_fuse_nodeid (upcall->inode);
+
+        if (upcall->flags & GF_UPCALL_NAMES)
+                fuse_invalidate (this, nodeid);
+
+        if (upcall->flags & (GF_UPCALL_DATA | GF_UPCALL_ENTRY))
+                fuse_invalidate_inode (this, nodeid, 0);
+        else if (upcall->flags & GF_UPCALL_ATTR)
+                fuse_invalidate_inode (this, nodeid, -1);
+}
+
+
 int
 notify (xlator_t *this, int32_t event, void *data, ...)
 {
@@ -3730,6 +3989,12 @@ notify (xlator_t *this, int32_t event, void *data, ...)
 
         private = this->private;
 
+        if (event == GF_EVENT_UPCALL) {
+                /* another client changed an inode we may be caching */
+                fuse_process_upcall (this, data);
+                return 0;
+        }
+
         graph = data;
 
         gf_log ("fuse", GF_LOG_DEBUG, "got event %d on graph %d",
@@ -3839,6 +4104,10 @@ static fuse_handler_t *fuse_std_ops[FUSE_OP_HIGH] = {
         [FUSE_GETLK]       = fuse_getlk,
         [FUSE_SETLK]       = fuse_setlk,
         [FUSE_SETLKW]      = fuse_setlk,
+#if defined(GF_LINUX_HOST_OS) || defined(__NetBSD__)
+        [FUSE_FALLOCATE]   = fuse_fallocate,
+        [FUSE_COPY_FILE_RANGE] = fuse_copy_file_range,
+#endif
 };
 
 
@@ -56,7 +56,7 @@
 #include "dict.h"
 
 #if defined(GF_LINUX_HOST_OS) || defined(__NetBSD__)
-#define FUSE_OP_HIGH (FUSE_POLL + 1)
+#define FUSE_OP_HIGH (FUSE_COPY_FILE_RANGE + 1)
 #endif
 #ifdef GF_DARWIN_HOST_OS
 #define FUSE_OP_HIGH (FUSE_DESTROY + 1)
@@ -263,6 +263,8 @@ typedef struct {
         size_t            size;
         unsigned long     nlookup;
         fd_t             *fd;
+        fd_t             *fd_out;    /* copy_file_range, fd is the source */
+        off_t             off_out;
         dict_t           *dict;
         char             *name;
         char              is_revalidate;
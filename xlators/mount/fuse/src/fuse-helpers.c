@@ -105,6 +105,10 @@ free_fuse_state (fuse_state_t *state)
                 fd_unref (state->fd);
                 state->fd = (void *)0xfdfdfdfd;
         }
+        if (state->fd_out) {
+                fd_unref (state->fd_out);
+                state->fd_out = (void *)0xfdfdfdfd;
+        }
         if (state->finh) {
                 GF_FREE (state->finh);
                 state->finh = NULL;
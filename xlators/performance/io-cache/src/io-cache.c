@@ -26,6 +26,7 @@
 #include "logging.h"
 #include "dict.h"
 #include "xlator.h"
+#include "defaults.h"
 #include "io-cache.h"
 #include "ioc-mem-types.h"
 #include "statedump.h"
@@ -326,6 +327,35 @@ ioc_forget (xlator_t *this, inode_t *inode)
 }
 
 
+/*
+ * notify - drop the cached pages of an inode another client changed
+ *
+ * @this:
+ * @event:
+ * @data:
+ *
+ */
+int
+notify (xlator_t *this, int32_t event, void *data, ...)
+{
+        struct gf_upcall *upcall    = NULL;
+        uint64_t          ioc_inode = 0;
+
+        if (event == GF_EVENT_UPCALL) {
+                upcall = data;
+
+                if (upcall->inode
+                    && (upcall->flags & (GF_UPCALL_DATA | GF_UPCALL_NAMES))) {
+                        inode_ctx_get (upcall->inode, this, &ioc_inode);
+                        if (ioc_inode)
+                                ioc_inode_flush ((ioc_inode_t *)(long)ioc_inode);
+                }
+        }
+
+        return default_notify (this, event, data);
+}
+
+
 /*
  * ioc_cache_validate_cbk -
  *
@@ -1373,6 +1403,126 @@ ioc_ftruncate (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset)
         return 0;
 }
 
+int32_t
+ioc_fallocate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                   struct iatt *postbuf)
+{
+        STACK_UNWIND_STRICT (fallocate, frame, op_ret, op_errno, prebuf,
+                             postbuf);
+        return 0;
+}
+
+
+/* the cached pages of the range are no longer what is on the file */
+int32_t
+ioc_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+               int32_t keep_size, off_t offset, size_t len)
+{
+        uint64_t ioc_inode = 0;
+
+        inode_ctx_get (fd->inode, this, &ioc_inode);
+
+        if (ioc_inode)
+                ioc_inode_flush ((ioc_inode_t *)(long)ioc_inode);
+
+        STACK_WIND (frame, ioc_fallocate_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->fallocate, fd, keep_size, offset,
+                    len);
+        return 0;
+}
+
+
+int32_t
+ioc_discard_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                 struct iatt *postbuf)
+{
+        STACK_UNWIND_STRICT (discard, frame, op_ret, op_errno, prebuf,
+                             postbuf);
+        return 0;
+}
+
+
+/* the cached pages of the range are no longer what is on the file */
+int32_t
+ioc_discard (call_frame_t *frame, xlator_t *this, fd_t *fd,
+             off_t offset, size_t len)
+{
+        uint64_t ioc_inode = 0;
+
+        inode_ctx_get (fd->inode, this, &ioc_inode);
+
+        if (ioc_inode)
+                ioc_inode_flush ((ioc_inode_t *)(long)ioc_inode);
+
+        STACK_WIND (frame, ioc_discard_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->discard, fd, offset, len);
+        return 0;
+}
+
+
+int32_t
+ioc_zerofill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                  struct iatt *postbuf)
+{
+        STACK_UNWIND_STRICT (zerofill, frame, op_ret, op_errno, prebuf,
+                             postbuf);
+        return 0;
+}
+
+
+/* the cached pages of the range are no longer what is on the file */
+int32_t
+ioc_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              off_t offset, size_t len)
+{
+        uint64_t ioc_inode = 0;
+
+        inode_ctx_get (fd->inode, this, &ioc_inode);
+
+        if (ioc_inode)
+                ioc_inode_flush ((ioc_inode_t *)(long)ioc_inode);
+
+        STACK_WIND (frame, ioc_zerofill_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->zerofill, fd, offset, len);
+        return 0;
+}
+
+
+int32_t
+ioc_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                         int32_t op_ret, int32_t op_errno,
+                         struct iatt *stbuf_in, struct iatt *prebuf,
+                         struct iatt *postbuf)
+{
+        STACK_UNWIND_STRICT (copy_file_range, frame, op_ret, op_errno,
+                             stbuf_in, prebuf, postbuf);
+        return 0;
+}
+
+
+/* the cached pages of the destination are no longer what is on the file */
+int32_t
+ioc_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                     off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                     uint32_t flags)
+{
+        uint64_t ioc_inode = 0;
+
+        inode_ctx_get (fd_out->inode, this, &ioc_inode);
+
+        if (ioc_inode)
+                ioc_inode_flush ((ioc_inode_t *)(long)ioc_inode);
+
+        STACK_WIND (frame, ioc_copy_file_range_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags);
+        return 0;
+}
+
+
 int32_t
 ioc_lk_cbk (call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
             int32_t op_errno, struct gf_flock *lock)
@@ -1921,6 +2071,10 @@ struct xlator_fops fops = {
         .writev      = ioc_writev,
         .truncate    = ioc_truncate,
         .ftruncate   = ioc_ftruncate,
+        .fallocate   = ioc_fallocate,
+        .discard     = ioc_discard,
+        .zerofill    = ioc_zerofill,
+        .copy_file_range = ioc_copy_file_range,
         .lookup      = ioc_lookup,
         .lk          = ioc_lk,
         .setattr     = ioc_setattr,
@@ -32,53 +32,307 @@
 #include <sys/time.h>
 #include <time.h>
 #include "locking.h"
+#include "statedump.h"
 
 void *iot_worker (void *arg);
 int iot_workers_scale (iot_conf_t *conf);
 int __iot_workers_scale (iot_conf_t *conf);
+static int32_t __iot_workers_wanted (iot_conf_t *conf);
 struct volume_options options[];
 
+static const char *iot_pri_keys[IOT_PRI_MAX] = {
+        [IOT_PRI_HI]     = "high",
+        [IOT_PRI_NORMAL] = "normal",
+        [IOT_PRI_LO]     = "low",
+        [IOT_PRI_LEAST]  = "least",
+};
+
+
+static inline int
+iot_hist_bucket (uint64_t value)
+{
+        int     bucket = 0;
+
+        while ((value >>= 1) && (bucket < (IOT_HIST_BUCKETS - 1)))
+                bucket++;
+
+        return bucket;
+}
+
+
+static inline uint64_t
+iot_tv_usecs (struct timeval *begin, struct timeval *end)
+{
+        if (timercmp (end, begin, <))
+                return 0;
+
+        return ((end->tv_sec - begin->tv_sec) * 1000000
+                + (end->tv_usec - begin->tv_usec));
+}
+
+
+/* take the oldest request of the highest priority which is still below its
+ * concurrency limit. only the per-priority queue locks are taken.
+ */
 call_stub_t *
-__iot_dequeue (iot_conf_t *conf, int *pri)
+iot_dequeue (iot_conf_t *conf, int *pri)
 {
-        call_stub_t  *stub = NULL;
-        int           i = 0;
+        call_stub_t     *stub  = NULL;
+        iot_queue_t     *queue = NULL;
+        struct timeval   now   = {0, };
+        uint64_t         wait  = 0;
+        int              i     = 0;
 
         *pri = -1;
+
+        gettimeofday (&now, NULL);
+
         for (i = 0; i < IOT_PRI_MAX; i++) {
-                if (list_empty (&conf->reqs[i]) ||
-                   (conf->ac_iot_count[i] >= conf->ac_iot_limit[i]))
+                queue = &conf->queues[i];
+
+                /* unlocked peek, rechecked below */
+                if (!queue->depth)
                         continue;
-                stub = list_entry (conf->reqs[i].next, call_stub_t, list);
-                conf->ac_iot_count[i]++;
-                *pri = i;
-                break;
-        }
 
-        if (!stub)
-                return NULL;
+                LOCK (&queue->lock);
+                {
+                        if (list_empty (&queue->reqs)
+                            || (queue->active >= queue->limit))
+                                goto unlock;
+
+                        stub = list_entry (queue->reqs.next, call_stub_t, list);
+                        list_del_init (&stub->list);
+
+                        queue->depth--;
+                        queue->active++;
+                        queue->dequeued++;
+
+                        wait = iot_tv_usecs (&stub->queued_at, &now);
+                        queue->wait_total += wait;
+                        queue->wait_hist[iot_hist_bucket (wait)]++;
+                }
+        unlock:
+                UNLOCK (&queue->lock);
 
-        conf->queue_size--;
-        list_del_init (&stub->list);
+                if (stub) {
+                        *pri = i;
+                        break;
+                }
+        }
+
+        if (stub)
+                iot_atomic_dec (&conf->queue_size);
 
         return stub;
 }
 
 
 void
-__iot_enqueue (iot_conf_t *conf, call_stub_t *stub, int pri)
+iot_enqueue (iot_conf_t *conf, call_stub_t *stub, int pri)
 {
+        iot_queue_t     *queue = NULL;
+
         if (pri < 0 || pri >= IOT_PRI_MAX)
                 pri = IOT_PRI_MAX-1;
 
-        list_add_tail (&stub->list, &conf->reqs[pri]);
+        queue = &conf->queues[pri];
 
-        conf->queue_size++;
+        gettimeofday (&stub->queued_at, NULL);
+
+        LOCK (&queue->lock);
+        {
+                list_add_tail (&stub->list, &queue->reqs);
+
+                queue->depth++;
+                queue->enqueued++;
+                if (queue->depth > queue->max_depth)
+                        queue->max_depth = queue->depth;
+                queue->depth_hist[iot_hist_bucket (queue->depth)]++;
+        }
+        UNLOCK (&queue->lock);
+
+        iot_atomic_inc (&conf->queue_size);
 
         return;
 }
 
 
+static void
+iot_request_done (iot_conf_t *conf, int pri, uint64_t service)
+{
+        iot_queue_t     *queue = NULL;
+
+        queue = &conf->queues[pri];
+
+        LOCK (&queue->lock);
+        {
+                queue->active--;
+                queue->service_total += service;
+                queue->serviced++;
+        }
+        UNLOCK (&queue->lock);
+}
+
+
+/* is there a request which a worker is allowed to pick up right now? */
+static gf_boolean_t
+iot_have_runnable (iot_conf_t *conf)
+{
+        iot_queue_t     *queue    = NULL;
+        gf_boolean_t     runnable = _gf_false;
+        int              i        = 0;
+
+        for (i = 0; (i < IOT_PRI_MAX) && !runnable; i++) {
+                queue = &conf->queues[i];
+
+                LOCK (&queue->lock);
+                {
+                        runnable = (!list_empty (&queue->reqs)
+                                    && (queue->active < queue->limit));
+                }
+                UNLOCK (&queue->lock);
+        }
+
+        return runnable;
+}
+
+
+static int32_t
+__iot_workers_wanted (iot_conf_t *conf)
+{
+        int32_t   scale = 0;
+
+        if (conf->autoscaling)
+                return conf->target_count;
+
+        scale = log_base2 (conf->queue_size);
+
+        if (scale < IOT_MIN_THREADS)
+                scale = IOT_MIN_THREADS;
+
+        if (scale > conf->max_count)
+                scale = conf->max_count;
+
+        return scale;
+}
+
+
+/* Autoscaling: every tune-interval, compare how long requests waited in the
+ * queues against queue-wait-target. Requests queueing up means we want
+ * more workers, unless the last increase made every request take longer to
+ * complete, in which case the backend is saturated and more concurrency
+ * only hurts. Caller holds conf->mutex.
+ */
+static void
+__iot_autoscale_tune (iot_conf_t *conf)
+{
+        iot_queue_t     *queue         = NULL;
+        uint64_t         wait_total    = 0;
+        uint64_t         service_total = 0;
+        uint64_t         serviced      = 0;
+        uint64_t         count         = 0;
+        uint64_t         avg_wait      = 0;
+        uint64_t         avg_service   = 0;
+        int32_t          target        = 0;
+        int              i             = 0;
+
+        for (i = 0; i < IOT_PRI_MAX; i++) {
+                queue = &conf->queues[i];
+
+                LOCK (&queue->lock);
+                {
+                        wait_total += queue->wait_total;
+                        service_total += queue->service_total;
+                        serviced += queue->serviced;
+                }
+                UNLOCK (&queue->lock);
+        }
+
+        count = serviced - conf->last_serviced;
+        if (count) {
+                avg_wait = (wait_total - conf->last_wait_total) / count;
+                avg_service = (service_total - conf->last_service_total)
+                        / count;
+        }
+
+        conf->last_wait_total = wait_total;
+        conf->last_service_total = service_total;
+        conf->last_serviced = serviced;
+
+        /* nothing ran: idle workers time out on their own */
+        if (!count)
+                return;
+
+        target = conf->target_count;
+
+        if (avg_wait > conf->wait_target) {
+                if (conf->service_at_grow
+                    && (avg_service > (conf->service_at_grow * 3 / 2))) {
+                        target--;
+                        conf->service_at_grow = 0;
+                } else if (target < conf->max_count) {
+                        target += max (1, target / 4);
+                        conf->service_at_grow = avg_service;
+                }
+        } else if (avg_wait < (conf->wait_target / 4)) {
+                target--;
+                conf->service_at_grow = 0;
+        }
+
+        if (target > conf->max_count)
+                target = conf->max_count;
+        if (target < IOT_MIN_THREADS)
+                target = IOT_MIN_THREADS;
+
+        if (target != conf->target_count)
+                gf_log (conf->this->name, GF_LOG_DEBUG,
+                        "autoscaling workers %d -> %d (avg wait %"PRIu64"us, "
+                        "avg service %"PRIu64"us)", conf->target_count, target,
+                        avg_wait, avg_service);
+
+        conf->target_count = target;
+
+        __iot_workers_scale (conf);
+}
+
+
+/* called by a worker after each request when autoscaling. returns 1 if the
+ * worker should exit because we are above the target.
+ */
+static int
+iot_autoscale (iot_conf_t *conf, struct timeval *now)
+{
+        int     bye = 0;
+
+        if ((iot_atomic_get (&conf->curr_count) <= conf->target_count)
+            && (iot_tv_usecs (&conf->last_tune, now)
+                < (conf->tune_interval * 1000ULL)))
+                return 0;
+
+        /* somebody else is tuning or spawning; we'll get another chance */
+        if (pthread_mutex_trylock (&conf->mutex) != 0)
+                return 0;
+        {
+                if (iot_tv_usecs (&conf->last_tune, now)
+                    >= (conf->tune_interval * 1000ULL)) {
+                        conf->last_tune = *now;
+                        __iot_autoscale_tune (conf);
+                }
+
+                if (conf->curr_count > conf->target_count) {
+                        iot_atomic_dec (&conf->curr_count);
+                        bye = 1;
+                        gf_log (conf->this->name, GF_LOG_DEBUG,
+                                "above autoscaling target, terminated. "
+                                "conf->curr_count=%d", conf->curr_count);
+                }
+        }
+        pthread_mutex_unlock (&conf->mutex);
+
+        return bye;
+}
+
+
 void *
 iot_worker (void *data)
 {
@@ -86,6 +340,8 @@ iot_worker (void *data)
         xlator_t         *this = NULL;
         call_stub_t      *stub = NULL;
         struct timespec   sleep_till = {0, };
+        struct timeval    begin = {0, };
+        struct timeval    end = {0, };
         int               ret = 0;
         int               pri = -1;
         char              timeout = 0;
@@ -96,76 +352,81 @@ iot_worker (void *data)
         THIS = this;
 
         for (;;) {
+                stub = iot_dequeue (conf, &pri);
+                if (stub) {
+                        gettimeofday (&begin, NULL);
+                        call_resume (stub);
+                        gettimeofday (&end, NULL);
+
+                        iot_request_done (conf, pri,
+                                          iot_tv_usecs (&begin, &end));
+
+                        if (conf->autoscaling && iot_autoscale (conf, &end))
+                                break;
+
+                        continue;
+                }
+
                 sleep_till.tv_sec = time (NULL) + conf->idle_time;
 
                 pthread_mutex_lock (&conf->mutex);
                 {
-                        if (pri != -1) {
-                                conf->ac_iot_count[pri]--;
-                                pri = -1;
-                        }
-                        while (conf->queue_size == 0) {
-                                conf->sleep_count++;
+                        iot_atomic_inc (&conf->sleep_count);
 
+                        while (!iot_have_runnable (conf)) {
                                 ret = pthread_cond_timedwait (&conf->cond,
                                                               &conf->mutex,
                                                               &sleep_till);
-                                conf->sleep_count--;
-
                                 if (ret == ETIMEDOUT) {
                                         timeout = 1;
                                         break;
                                 }
                         }
 
+                        iot_atomic_dec (&conf->sleep_count);
+
                         if (timeout) {
-                                if (conf->curr_count > IOT_MIN_THREADS) {
-                                        conf->curr_count--;
+                                timeout = 0;
+                                if ((conf->curr_count > IOT_MIN_THREADS)
+                                    && !iot_have_runnable (conf)) {
+                                        iot_atomic_dec (&conf->curr_count);
                                         bye = 1;
                                         gf_log (conf->this->name, GF_LOG_DEBUG,
                                                 "timeout, terminated. conf->curr_count=%d",
                                                 conf->curr_count);
-                                } else {
-                                        timeout = 0;
                                 }
                         }
-
-                        stub = __iot_dequeue (conf, &pri);
                 }
                 pthread_mutex_unlock (&conf->mutex);
 
-                if (stub) /* guard against spurious wakeups */
-                        call_resume (stub);
-
                 if (bye)
                         break;
         }
 
-        if (pri != -1) {
-                pthread_mutex_lock (&conf->mutex);
-                {
-                        conf->ac_iot_count[pri]--;
-                }
-                pthread_mutex_unlock (&conf->mutex);
-        }
         return NULL;
 }
 
 
+/* the common case takes only the queue lock of @pri; conf->mutex is taken
+ * when a worker has to be woken up or spawned.
+ */
 int
 do_iot_schedule (iot_conf_t *conf, call_stub_t *stub, int pri)
 {
         int   ret = 0;
 
-        pthread_mutex_lock (&conf->mutex);
-        {
-                __iot_enqueue (conf, stub, pri);
-
-                pthread_cond_signal (&conf->cond);
+        iot_enqueue (conf, stub, pri);
 
-                ret = __iot_workers_scale (conf);
+        if (iot_atomic_get (&conf->sleep_count)) {
+                pthread_mutex_lock (&conf->mutex);
+                {
+                        pthread_cond_signal (&conf->cond);
+                }
+                pthread_mutex_unlock (&conf->mutex);
+        } else if (iot_atomic_get (&conf->curr_count)
+                   < __iot_workers_wanted (conf)) {
+                ret = iot_workers_scale (conf);
         }
-        pthread_mutex_unlock (&conf->mutex);
 
         return ret;
 }
@@ -251,6 +512,10 @@ iot_schedule (call_frame_t *frame, xlator_t *this, call_stub_t *stub)
         case GF_FOP_FSYNCDIR:
         case GF_FOP_XATTROP:
         case GF_FOP_FXATTROP:
+        case GF_FOP_FALLOCATE:
+        case GF_FOP_DISCARD:
+        case GF_FOP_ZEROFILL:
+        case GF_FOP_COPY_FILE_RANGE:
                 pri = IOT_PRI_LO;
                 break;
 
@@ -1350,6 +1615,208 @@ out:
 	return 0;
 }
 
+int
+iot_fallocate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno,
+                   struct iatt *preop, struct iatt *postop)
+{
+        STACK_UNWIND_STRICT (fallocate, frame, op_ret, op_errno, preop, postop);
+        return 0;
+}
+
+
+int
+iot_fallocate_wrapper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                       int32_t keep_size, off_t offset, size_t len)
+{
+        STACK_WIND (frame, iot_fallocate_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->fallocate, fd, keep_size, offset,
+                    len);
+        return 0;
+}
+
+
+int
+iot_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+               int32_t keep_size, off_t offset, size_t len)
+{
+        call_stub_t     *stub = NULL;
+        int              ret = -1;
+
+        stub = fop_fallocate_stub (frame, iot_fallocate_wrapper, fd, keep_size,
+                                   offset, len);
+        if (!stub) {
+                gf_log (this->name, GF_LOG_ERROR, "cannot create fallocate stub"
+                        "(out of memory)");
+                ret = -ENOMEM;
+                goto out;
+        }
+
+        ret = iot_schedule (frame, this, stub);
+
+out:
+        if (ret < 0) {
+                STACK_UNWIND_STRICT (fallocate, frame, -1, -ret, NULL, NULL);
+                if (stub != NULL) {
+                        call_stub_destroy (stub);
+                }
+        }
+        return 0;
+}
+
+
+int
+iot_discard_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno,
+                 struct iatt *preop, struct iatt *postop)
+{
+        STACK_UNWIND_STRICT (discard, frame, op_ret, op_errno, preop, postop);
+        return 0;
+}
+
+
+int
+iot_discard_wrapper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                     off_t offset, size_t len)
+{
+        STACK_WIND (frame, iot_discard_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->discard, fd, offset, len);
+        return 0;
+}
+
+
+int
+iot_discard (call_frame_t *frame, xlator_t *this, fd_t *fd,
+             off_t offset, size_t len)
+{
+        call_stub_t     *stub = NULL;
+        int              ret = -1;
+
+        stub = fop_discard_stub (frame, iot_discard_wrapper, fd, offset, len);
+        if (!stub) {
+                gf_log (this->name, GF_LOG_ERROR, "cannot create discard stub"
+                        "(out of memory)");
+                ret = -ENOMEM;
+                goto out;
+        }
+
+        ret = iot_schedule (frame, this, stub);
+
+out:
+        if (ret < 0) {
+                STACK_UNWIND_STRICT (discard, frame, -1, -ret, NULL, NULL);
+                if (stub != NULL) {
+                        call_stub_destroy (stub);
+                }
+        }
+        return 0;
+}
+
+
+int
+iot_zerofill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno,
+                  struct iatt *preop, struct iatt *postop)
+{
+        STACK_UNWIND_STRICT (zerofill, frame, op_ret, op_errno, preop, postop);
+        return 0;
+}
+
+
+int
+iot_zerofill_wrapper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                      off_t offset, size_t len)
+{
+        STACK_WIND (frame, iot_zerofill_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->zerofill, fd, offset, len);
+        return 0;
+}
+
+
+int
+iot_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              off_t offset, size_t len)
+{
+        call_stub_t     *stub = NULL;
+        int              ret = -1;
+
+        stub = fop_zerofill_stub (frame, iot_zerofill_wrapper, fd, offset, len);
+        if (!stub) {
+                gf_log (this->name, GF_LOG_ERROR, "cannot create zerofill stub"
+                        "(out of memory)");
+                ret = -ENOMEM;
+                goto out;
+        }
+
+        ret = iot_schedule (frame, this, stub);
+
+out:
+        if (ret < 0) {
+                STACK_UNWIND_STRICT (zerofill, frame, -1, -ret, NULL, NULL);
+                if (stub != NULL) {
+                        call_stub_destroy (stub);
+                }
+        }
+        return 0;
+}
+
+
+int
+iot_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                         int32_t op_ret, int32_t op_errno,
+                         struct iatt *stbuf_in, struct iatt *preop,
+                         struct iatt *postop)
+{
+        STACK_UNWIND_STRICT (copy_file_range, frame, op_ret, op_errno,
+                             stbuf_in, preop, postop);
+        return 0;
+}
+
+
+int
+iot_copy_file_range_wrapper (call_frame_t *frame, xlator_t *this,
+                             fd_t *fd_in, off_t off_in, fd_t *fd_out,
+                             off_t off_out, size_t len, uint32_t flags)
+{
+        STACK_WIND (frame, iot_copy_file_range_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags);
+        return 0;
+}
+
+
+int
+iot_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                     off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                     uint32_t flags)
+{
+        call_stub_t     *stub = NULL;
+        int              ret = -1;
+
+        stub = fop_copy_file_range_stub (frame, iot_copy_file_range_wrapper,
+                                         fd_in, off_in, fd_out, off_out, len,
+                                         flags);
+        if (!stub) {
+                gf_log (this->name, GF_LOG_ERROR, "cannot create "
+                        "copy_file_range stub (out of memory)");
+                ret = -ENOMEM;
+                goto out;
+        }
+
+        ret = iot_schedule (frame, this, stub);
+
+out:
+        if (ret < 0) {
+                STACK_UNWIND_STRICT (copy_file_range, frame, -1, -ret, NULL,
+                                     NULL, NULL);
+                if (stub != NULL) {
+                        call_stub_destroy (stub);
+                }
+        }
+        return 0;
+}
+
+
 
 
 int
@@ -2264,21 +2731,12 @@ out:
 int
 __iot_workers_scale (iot_conf_t *conf)
 {
-        int       log2 = 0;
         int       scale = 0;
         int       diff = 0;
         pthread_t thread;
         int       ret = 0;
 
-        log2 = log_base2 (conf->queue_size);
-
-        scale = log2;
-
-        if (log2 < IOT_MIN_THREADS)
-                scale = IOT_MIN_THREADS;
-
-        if (log2 > conf->max_count)
-                scale = conf->max_count;
+        scale = __iot_workers_wanted (conf);
 
         if (conf->curr_count < scale) {
                 diff = scale - conf->curr_count;
@@ -2289,7 +2747,7 @@ __iot_workers_scale (iot_conf_t *conf)
 
                 ret = pthread_create (&thread, &conf->w_attr, iot_worker, conf);
                 if (ret == 0) {
-                        conf->curr_count++;
+                        iot_atomic_inc (&conf->curr_count);
                         gf_log (conf->this->name, GF_LOG_DEBUG,
                                 "scaled threads to %d (queue_size=%d/%d)",
                                 conf->curr_count, conf->queue_size, scale);
@@ -2371,19 +2829,37 @@ reconfigure (xlator_t *this, dict_t *options)
         GF_OPTION_RECONF ("thread-count", conf->max_count, options, int32, out);
 
         GF_OPTION_RECONF ("high-prio-threads",
-                          conf->ac_iot_limit[IOT_PRI_HI], options, int32, out);
+                          conf->queues[IOT_PRI_HI].limit, options, int32, out);
 
         GF_OPTION_RECONF ("normal-prio-threads",
-                          conf->ac_iot_limit[IOT_PRI_NORMAL], options, int32,
+                          conf->queues[IOT_PRI_NORMAL].limit, options, int32,
                           out);
 
         GF_OPTION_RECONF ("low-prio-threads",
-                          conf->ac_iot_limit[IOT_PRI_LO], options, int32, out);
+                          conf->queues[IOT_PRI_LO].limit, options, int32, out);
 
         GF_OPTION_RECONF ("least-prio-threads",
-                          conf->ac_iot_limit[IOT_PRI_LEAST], options, int32,
+                          conf->queues[IOT_PRI_LEAST].limit, options, int32,
+                          out);
+
+        GF_OPTION_RECONF ("autoscaling", conf->autoscaling, options, bool,
                           out);
 
+        GF_OPTION_RECONF ("queue-wait-target", conf->wait_target, options,
+                          int32, out);
+
+        GF_OPTION_RECONF ("autoscaling-interval", conf->tune_interval,
+                          options, int32, out);
+
+        pthread_mutex_lock (&conf->mutex);
+        {
+                if (conf->target_count > conf->max_count)
+                        conf->target_count = conf->max_count;
+                if (conf->target_count < IOT_MIN_THREADS)
+                        conf->target_count = IOT_MIN_THREADS;
+        }
+        pthread_mutex_unlock (&conf->mutex);
+
 	ret = 0;
 out:
 	return ret;
@@ -2433,23 +2909,36 @@ init (xlator_t *this)
         GF_OPTION_INIT ("thread-count", conf->max_count, int32, out);
 
         GF_OPTION_INIT ("high-prio-threads",
-                        conf->ac_iot_limit[IOT_PRI_HI], int32, out);
+                        conf->queues[IOT_PRI_HI].limit, int32, out);
 
         GF_OPTION_INIT ("normal-prio-threads",
-                        conf->ac_iot_limit[IOT_PRI_NORMAL], int32, out);
+                        conf->queues[IOT_PRI_NORMAL].limit, int32, out);
 
         GF_OPTION_INIT ("low-prio-threads",
-                        conf->ac_iot_limit[IOT_PRI_LO], int32, out);
+                        conf->queues[IOT_PRI_LO].limit, int32, out);
 
         GF_OPTION_INIT ("least-prio-threads",
-                        conf->ac_iot_limit[IOT_PRI_LEAST], int32, out);
+                        conf->queues[IOT_PRI_LEAST].limit, int32, out);
 
         GF_OPTION_INIT ("idle-time", conf->idle_time, int32, out);
 
+        GF_OPTION_INIT ("autoscaling", conf->autoscaling, bool, out);
+
+        GF_OPTION_INIT ("queue-wait-target", conf->wait_target, int32, out);
+
+        GF_OPTION_INIT ("autoscaling-interval", conf->tune_interval, int32,
+                        out);
+
         conf->this = this;
 
+        /* start from a quarter of the maximum and let the autoscaler find
+           the worker count the backend is happiest with */
+        conf->target_count = max (conf->max_count / 4, IOT_MIN_THREADS);
+        gettimeofday (&conf->last_tune, NULL);
+
         for (i = 0; i < IOT_PRI_MAX; i++) {
-                INIT_LIST_HEAD (&conf->reqs[i]);
+                LOCK_INIT (&conf->queues[i].lock);
+                INIT_LIST_HEAD (&conf->queues[i].reqs);
         }
 
 	ret = iot_workers_scale (conf);
@@ -2472,6 +2961,13 @@ void
 fini (xlator_t *this)
 {
 	iot_conf_t *conf = this->private;
+        int         i = 0;
+
+        if (!conf)
+                return;
+
+        for (i = 0; i < IOT_PRI_MAX; i++)
+                LOCK_DESTROY (&conf->queues[i].lock);
 
 	GF_FREE (conf);
 
@@ -2480,6 +2976,91 @@ fini (xlator_t *this)
 }
 
 
+int
+iot_priv_dump (xlator_t *this)
+{
+        iot_conf_t      *conf = NULL;
+        iot_queue_t     *queue = NULL;
+        iot_queue_t      snap;
+        char             key_prefix[GF_DUMP_MAX_BUF_LEN];
+        char             key[GF_DUMP_MAX_BUF_LEN];
+        int              i = 0;
+        int              j = 0;
+
+        if (!this)
+                return 0;
+
+        conf = this->private;
+        if (!conf)
+                return 0;
+
+        gf_proc_dump_build_key (key_prefix, "xlator.performance.io-threads",
+                                "priv");
+        gf_proc_dump_add_section (key_prefix);
+
+        gf_proc_dump_write ("maximum_threads_count", "%d", conf->max_count);
+        gf_proc_dump_write ("current_threads_count", "%d", conf->curr_count);
+        gf_proc_dump_write ("sleep_count", "%d", conf->sleep_count);
+        gf_proc_dump_write ("idle_time", "%d", conf->idle_time);
+        gf_proc_dump_write ("queue_size", "%d", conf->queue_size);
+        gf_proc_dump_write ("autoscaling", "%s",
+                            conf->autoscaling ? "on" : "off");
+        gf_proc_dump_write ("target_threads_count", "%d", conf->target_count);
+        gf_proc_dump_write ("queue_wait_target", "%d", conf->wait_target);
+
+        for (i = 0; i < IOT_PRI_MAX; i++) {
+                queue = &conf->queues[i];
+
+                LOCK (&queue->lock);
+                {
+                        snap = *queue;
+                }
+                UNLOCK (&queue->lock);
+
+                gf_proc_dump_build_key (key, iot_pri_keys[i], "queue_depth");
+                gf_proc_dump_write (key, "%d", snap.depth);
+                gf_proc_dump_build_key (key, iot_pri_keys[i], "active");
+                gf_proc_dump_write (key, "%d", snap.active);
+                gf_proc_dump_build_key (key, iot_pri_keys[i], "limit");
+                gf_proc_dump_write (key, "%d", snap.limit);
+                gf_proc_dump_build_key (key, iot_pri_keys[i], "enqueued");
+                gf_proc_dump_write (key, "%"PRIu64, snap.enqueued);
+                gf_proc_dump_build_key (key, iot_pri_keys[i], "dequeued");
+                gf_proc_dump_write (key, "%"PRIu64, snap.dequeued);
+                gf_proc_dump_build_key (key, iot_pri_keys[i],
+                                        "max_queue_depth");
+                gf_proc_dump_write (key, "%d", snap.max_depth);
+                gf_proc_dump_build_key (key, iot_pri_keys[i], "avg_wait_usec");
+                gf_proc_dump_write (key, "%"PRIu64, snap.dequeued ?
+                                    snap.wait_total / snap.dequeued : 0);
+                gf_proc_dump_build_key (key, iot_pri_keys[i],
+                                        "avg_service_usec");
+                gf_proc_dump_write (key, "%"PRIu64, snap.serviced ?
+                                    snap.service_total / snap.serviced : 0);
+
+                /* log2 histograms, bucket j counts values in [2^j, 2^(j+1)) */
+                for (j = 0; j < IOT_HIST_BUCKETS; j++) {
+                        if (!snap.wait_hist[j])
+                                continue;
+                        gf_proc_dump_build_key (key, iot_pri_keys[i],
+                                                "wait_usec_hist[%d]", 1 << j);
+                        gf_proc_dump_write (key, "%"PRIu64, snap.wait_hist[j]);
+                }
+
+                for (j = 0; j < IOT_HIST_BUCKETS; j++) {
+                        if (!snap.depth_hist[j])
+                                continue;
+                        gf_proc_dump_build_key (key, iot_pri_keys[i],
+                                                "depth_hist[%d]", 1 << j);
+                        gf_proc_dump_write (key, "%"PRIu64,
+                                            snap.depth_hist[j]);
+                }
+        }
+
+        return 0;
+}
+
+
 struct xlator_fops fops = {
 	.open        = iot_open,
 	.create      = iot_create,
@@ -2496,6 +3077,10 @@ struct xlator_fops fops = {
         .lookup      = iot_lookup,
         .setattr     = iot_setattr,
         .fsetattr    = iot_fsetattr,
+        .fallocate   = iot_fallocate,
+        .discard     = iot_discard,
+        .zerofill    = iot_zerofill,
+        .copy_file_range = iot_copy_file_range,
         .access      = iot_access,
         .readlink    = iot_readlink,
         .mknod       = iot_mknod,
@@ -2526,6 +3111,10 @@ struct xlator_fops fops = {
 struct xlator_cbks cbks = {
 };
 
+struct xlator_dumpops dumpops = {
+        .priv = iot_priv_dump,
+};
+
 struct volume_options options[] = {
 	{ .key  = {"thread-count"},
 	  .type = GF_OPTION_TYPE_INT,
@@ -2577,6 +3166,28 @@ struct volume_options options[] = {
          .max   = 0x7fffffff,
          .default_value = "120",
         },
+        { .key  = {"autoscaling"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Adjust the number of worker threads to the queueing "
+                         "delay observed, between 1 and thread-count"
+        },
+        { .key  = {"queue-wait-target"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 1,
+          .max  = 10000000,
+          .default_value = "1000",
+          .description = "Average time (in microseconds) a request may wait "
+                         "in the queue before autoscaling adds workers"
+        },
+        { .key  = {"autoscaling-interval"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 10,
+          .max  = 3600000,
+          .default_value = "1000",
+          .description = "Interval (in milliseconds) at which autoscaling "
+                         "re-evaluates the number of workers"
+        },
 	{ .key  = {NULL},
         },
 };
@@ -62,6 +62,37 @@ typedef enum {
 } iot_pri_t;
 
 
+#define IOT_HIST_BUCKETS        24      /* log2 buckets: 1us .. ~8s */
+
+/* queue_size, sleep_count and curr_count are read on the enqueue fast
+   path without conf->mutex; every modification goes through these */
+#define iot_atomic_inc(ptr)     __sync_add_and_fetch ((ptr), 1)
+#define iot_atomic_dec(ptr)     __sync_sub_and_fetch ((ptr), 1)
+#define iot_atomic_get(ptr)     __sync_add_and_fetch ((ptr), 0)
+
+
+struct iot_queue {
+        gf_lock_t            lock;
+        struct list_head     reqs;
+        int32_t              depth;       /* requests queued */
+        int32_t              active;      /* requests being executed */
+        int32_t              limit;       /* max requests executed at once */
+
+        uint64_t             enqueued;
+        uint64_t             dequeued;
+        int32_t              max_depth;
+
+        /* cumulative, in usecs */
+        uint64_t             wait_total;
+        uint64_t             service_total;
+        uint64_t             serviced;
+
+        uint64_t             wait_hist[IOT_HIST_BUCKETS];
+        uint64_t             depth_hist[IOT_HIST_BUCKETS];
+};
+typedef struct iot_queue iot_queue_t;
+
+
 struct iot_conf {
         pthread_mutex_t      mutex;
         pthread_cond_t       cond;
@@ -72,16 +103,24 @@ struct iot_conf {
 
         int32_t              idle_time;   /* in seconds */
 
-        struct list_head     reqs[IOT_PRI_MAX];
-
-        int32_t              ac_iot_limit[IOT_PRI_MAX];
-        int32_t              ac_iot_count[IOT_PRI_MAX];
+        iot_queue_t          queues[IOT_PRI_MAX];
         int                  queue_size;
         pthread_attr_t       w_attr;
 
+        /* autoscaling */
+        gf_boolean_t         autoscaling;
+        int32_t              target_count;  /* worker count aimed at */
+        int32_t              wait_target;   /* usecs */
+        int32_t              tune_interval; /* msecs */
+        struct timeval       last_tune;
+        uint64_t             last_wait_total;
+        uint64_t             last_service_total;
+        uint64_t             last_serviced;
+        uint64_t             service_at_grow; /* avg service time (usecs)
+                                                 when we last grew */
+
         xlator_t            *this;
 };
-
 typedef struct iot_conf iot_conf_t;
 
 #endif /* __IOT_H */
@@ -227,14 +227,15 @@ out:
 }
 
 
-/* To be called with qr_inode->table->lock held */
+/* To be called with table->lock held */
 void
-__qr_inode_free (qr_inode_t *qr_inode)
+__qr_inode_free (qr_inode_table_t *table, qr_inode_t *qr_inode)
 {
         GF_VALIDATE_OR_GOTO ("quick-read", qr_inode, out);
 
         if (qr_inode->xattr) {
                 dict_unref (qr_inode->xattr);
+                table->cache_used -= qr_inode->size;
         }
 
         list_del (&qr_inode->lru);
@@ -267,17 +268,14 @@ __qr_cache_prune (xlator_t *this)
 
         for (index=0; index < conf->max_pri; index++) {
                 list_for_each_entry_safe (curr, next, &table->lru[index], lru) {
-                        size_pruned += curr->stbuf.ia_size;
+                        size_pruned += curr->size;
                         inode_ctx_del (curr->inode, this, NULL);
-                        __qr_inode_free (curr);
+                        __qr_inode_free (table, curr);
                         if (size_pruned >= size_to_prune)
-                                goto done;
+                                goto out;
                 }
         }
 
-done:
-        table->cache_used -= size_pruned;
-
 out:
         return;
 }
@@ -298,6 +296,92 @@ out:
 }
 
 
+#ifdef HAVE_LIBZ
+/* returns a dict holding only the deflated @content, or NULL if it does not
+ * get smaller.
+ */
+static dict_t *
+qr_content_deflate (xlator_t *this, data_t *content, uint64_t *size)
+{
+        dict_t *dict = NULL;
+        char   *buf  = NULL;
+        char   *tmp  = NULL;
+        uLongf  len  = 0;
+        int     ret  = -1;
+
+        len = compressBound (content->len);
+        buf = GF_MALLOC (len, gf_qr_mt_content_t);
+        if (buf == NULL) {
+                goto out;
+        }
+
+        ret = compress2 ((Bytef *)buf, &len, (Bytef *)content->data,
+                         content->len, Z_BEST_SPEED);
+        if ((ret != Z_OK) || (len >= content->len)) {
+                ret = -1;
+                goto out;
+        }
+
+        tmp = GF_REALLOC (buf, len);
+        if (tmp != NULL) {
+                buf = tmp;
+        }
+
+        dict = dict_new ();
+        if (dict == NULL) {
+                ret = -1;
+                goto out;
+        }
+
+        ret = dict_set_bin (dict, GF_CONTENT_KEY, buf, len);
+        if (ret < 0) {
+                goto out;
+        }
+
+        buf = NULL;
+        *size = len;
+out:
+        if (buf != NULL) {
+                GF_FREE (buf);
+        }
+
+        if ((ret < 0) && (dict != NULL)) {
+                dict_unref (dict);
+                dict = NULL;
+        }
+
+        return dict;
+}
+
+
+static char *
+qr_content_inflate (xlator_t *this, data_t *content, uint64_t raw_size)
+{
+        char   *buf = NULL;
+        uLongf  len = 0;
+        int     ret = 0;
+
+        buf = GF_MALLOC (raw_size, gf_qr_mt_content_t);
+        if (buf == NULL) {
+                goto out;
+        }
+
+        len = raw_size;
+        ret = uncompress ((Bytef *)buf, &len, (Bytef *)content->data,
+                          content->len);
+        if ((ret != Z_OK) || (len != raw_size)) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "cannot inflate cached content (%d)", ret);
+                GF_FREE (buf);
+                buf = NULL;
+        }
+
+out:
+        return buf;
+}
+#endif
+
+
 int32_t
 qr_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                int32_t op_ret, int32_t op_errno, inode_t *inode,
@@ -311,6 +395,8 @@ qr_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         qr_inode_table_t *table    = NULL;
         qr_private_t     *priv     = NULL;
         qr_local_t       *local    = NULL;
+        dict_t           *zdict    = NULL;
+        uint64_t          zsize    = 0;
 
         GF_ASSERT (frame);
 
@@ -354,6 +440,12 @@ qr_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 goto out;
         }
 
+#ifdef HAVE_LIBZ
+        if (conf->compress) {
+                zdict = qr_content_deflate (this, content, &zsize);
+        }
+#endif
+
         LOCK (&table->lock);
         {
                 ret = inode_ctx_get (inode, this, &value);
@@ -368,7 +460,7 @@ qr_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                         ret = inode_ctx_put (inode, this,
                                              (uint64_t)(long)qr_inode);
                         if (ret == -1) {
-                                __qr_inode_free (qr_inode);
+                                __qr_inode_free (table, qr_inode);
                                 qr_inode = NULL;
                                 op_ret = -1;
                                 op_errno = EINVAL;
@@ -394,12 +486,23 @@ qr_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 if (qr_inode->xattr) {
                         dict_unref (qr_inode->xattr);
                         qr_inode->xattr = NULL;
-                        table->cache_used -= qr_inode->stbuf.ia_size;
+                        table->cache_used -= qr_inode->size;
+                }
+
+                qr_inode->raw_size = content->len;
+                if (zdict != NULL) {
+                        qr_inode->xattr = zdict;
+                        qr_inode->compressed = 1;
+                        qr_inode->size = zsize;
+                        zdict = NULL;
+                } else {
+                        qr_inode->xattr = dict_ref (dict);
+                        qr_inode->compressed = 0;
+                        qr_inode->size = buf->ia_size;
                 }
 
-                qr_inode->xattr = dict_ref (dict);
                 qr_inode->stbuf = *buf;
-                table->cache_used += buf->ia_size;
+                table->cache_used += qr_inode->size;
 
                 gettimeofday (&qr_inode->tv, NULL);
                 if (__qr_need_cache_prune (conf, table)) {
@@ -409,6 +512,10 @@ qr_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 unlock:
         UNLOCK (&table->lock);
 
+        if (zdict != NULL) {
+                dict_unref (zdict);
+        }
+
 out:
         /*
          * FIXME: content size in dict can be greater than the size application
@@ -593,7 +700,7 @@ qr_open_cbk (call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
                                         qr_inode = (qr_inode_t *)(long) value;
 
                                         if (qr_inode != NULL) {
-                                                __qr_inode_free (qr_inode);
+                                                __qr_inode_free (table, qr_inode);
                                         }
                                 }
                         }
@@ -843,7 +950,7 @@ qr_validate_cache_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                             || (qr_inode->stbuf.ia_mtime_nsec
                                 != buf->ia_mtime_nsec)) {
                                 inode_ctx_del (local->fd->inode, this, NULL);
-                                __qr_inode_free (qr_inode);
+                                __qr_inode_free (table, qr_inode);
                         }
                 }
         }
@@ -1078,6 +1185,11 @@ qr_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
         struct iobref     *iobref         = NULL;
         struct iatt        stbuf          = {0, };
         data_t            *content        = NULL;
+        char              *data           = NULL;
+        char              *inflated       = NULL;
+        char               compressed     = 0;
+        uint64_t           raw_size       = 0;
+        size_t             data_len       = 0;
         qr_fd_ctx_t       *qr_fd_ctx      = NULL;
         call_stub_t       *stub           = NULL;
         loc_t              loc            = {0, };
@@ -1131,101 +1243,113 @@ qr_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
                                                 goto unlock;
                                         }
 
+                                        /* copied out of the lock, the ref
+                                           keeps it if the cache is
+                                           refreshed meanwhile */
                                         content = dict_get (qr_inode->xattr,
                                                             GF_CONTENT_KEY);
+                                        content = data_ref (content);
+                                        compressed = qr_inode->compressed;
+                                        raw_size = qr_inode->raw_size;
 
                                         stbuf = qr_inode->stbuf;
                                         content_cached = 1;
                                         list_move_tail (&qr_inode->lru,
                                                         &table->lru[qr_inode->priority]);
+                                }
+                        }
+                }
+        }
+unlock:
+        UNLOCK (&table->lock);
 
-                                        if (offset > content->len) {
-                                                op_ret = 0;
-                                                end = content->len;
-                                        } else {
-                                                if ((offset + size)
-                                                    > content->len) {
-                                                        op_ret = content->len
-                                                                - offset;
-                                                        end = content->len;
-                                                } else {
-                                                        op_ret = size;
-                                                        end =  offset + size;
-                                                }
-                                        }
+        if (!content_cached) {
+                goto out;
+        }
 
-                                        count = (op_ret
-                                                 / iobuf_pool->default_page_size);
-                                        if ((op_ret % iobuf_pool->default_page_size)
-                                            != 0) {
-                                                count++;
-                                        }
+        data = content->data;
+        data_len = content->len;
 
-                                        if (count == 0) {
-                                                op_ret = 0;
-                                                goto unlock;
-                                        }
+#ifdef HAVE_LIBZ
+        if (compressed) {
+                inflated = qr_content_inflate (this, content, raw_size);
+                if (inflated == NULL) {
+                        /* the read is wound to the child */
+                        content_cached = 0;
+                        goto out;
+                }
 
-                                        vector = GF_CALLOC (count,
-                                                            sizeof (*vector),
-                                                            gf_qr_mt_iovec);
-                                        if (vector == NULL) {
-                                                op_ret = -1;
-                                                op_errno = ENOMEM;
-                                                need_unwind = 1;
-                                                goto unlock;
-                                        }
+                data = inflated;
+                data_len = raw_size;
+        }
+#endif
 
-                                        iobref = iobref_new ();
-                                        if (iobref == NULL) {
-                                                op_ret = -1;
-                                                op_errno = ENOMEM;
-                                                need_unwind = 1;
-                                                goto unlock;
-                                        }
+        if (offset > data_len) {
+                op_ret = 0;
+                end = data_len;
+        } else {
+                if ((offset + size) > data_len) {
+                        op_ret = data_len - offset;
+                        end = data_len;
+                } else {
+                        op_ret = size;
+                        end =  offset + size;
+                }
+        }
 
-                                        for (i = 0; i < count; i++) {
-                                                iobuf = iobuf_get (iobuf_pool);
-                                                if (iobuf == NULL) {
-                                                        op_ret = -1;
-                                                        op_errno = ENOMEM;
-                                                        need_unwind = 1;
-                                                        goto unlock;
-                                                }
+        count = (op_ret / iobuf_pool->default_page_size);
+        if ((op_ret % iobuf_pool->default_page_size) != 0) {
+                count++;
+        }
 
-                                                start = offset
-                                                        +
-                                                        (iobuf_pool->default_page_size
-                                                         * i);
-
-                                                if (start > end) {
-                                                        len = 0;
-                                                } else {
-                                                        len =
-                                                        (iobuf_pool->default_page_size
-                                                               > (end - start))
-                                                                ? (end - start)
-                                                                :
-                                                                iobuf_pool->default_page_size;
-
-                                                        memcpy (iobuf->ptr,
-                                                                content->data
-                                                                + start,
-                                                                len);
-                                                }
+        if (count == 0) {
+                op_ret = 0;
+                goto out;
+        }
 
-                                                iobref_add (iobref, iobuf);
-                                                iobuf_unref (iobuf);
+        vector = GF_CALLOC (count, sizeof (*vector), gf_qr_mt_iovec);
+        if (vector == NULL) {
+                op_ret = -1;
+                op_errno = ENOMEM;
+                need_unwind = 1;
+                goto out;
+        }
 
-                                                vector[i].iov_base = iobuf->ptr;
-                                                vector[i].iov_len = len;
-                                        }
-                                }
-                        }
+        iobref = iobref_new ();
+        if (iobref == NULL) {
+                op_ret = -1;
+                op_errno = ENOMEM;
+                need_unwind = 1;
+                goto out;
+        }
+
+        for (i = 0; i < count; i++) {
+                iobuf = iobuf_get (iobuf_pool);
+                if (iobuf == NULL) {
+                        op_ret = -1;
+                        op_errno = ENOMEM;
+                        need_unwind = 1;
+                        goto out;
                 }
+
+                start = offset + (iobuf_pool->default_page_size * i);
+
+                if (start > end) {
+                        len = 0;
+                } else {
+                        len = (iobuf_pool->default_page_size > (end - start))
+                                ? (end - start)
+                                : iobuf_pool->default_page_size;
+
+                        memcpy (iobuf->ptr, data + start, len);
+                }
+
+                iobref_add (iobref, iobuf);
+                iobuf_unref (iobuf);
+
+                vector[i].iov_base = iobuf->ptr;
+                vector[i].iov_len = len;
         }
-unlock:
-        UNLOCK (&table->lock);
 
 out:
         if (content_cached || need_unwind) {
@@ -1333,6 +1457,14 @@ ret:
                 iobref_unref (iobref);
         }
 
+        if (inflated != NULL) {
+                GF_FREE (inflated);
+        }
+
+        if (content != NULL) {
+                data_unref (content);
+        }
+
         return 0;
 }
 
@@ -1424,7 +1556,7 @@ qr_writev (call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
                         qr_inode = (qr_inode_t *)(long)value;
                         if (qr_inode != NULL) {
                                 inode_ctx_del (fd->inode, this, NULL);
-                                __qr_inode_free (qr_inode);
+                                __qr_inode_free (table, qr_inode);
                         }
                 }
         }
@@ -2800,7 +2932,7 @@ qr_ftruncate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                                 {
                                         inode_ctx_del (local->fd->inode, this,
                                                        NULL);
-                                        __qr_inode_free (qr_inode);
+                                        __qr_inode_free (table, qr_inode);
                                 }
                         }
                 }
@@ -2963,20 +3095,70 @@ ret:
         return 0;
 }
 
-
 int32_t
-qr_lk_cbk (call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
-           int32_t op_errno, struct gf_flock *lock)
+qr_fallocate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                  struct iatt *postbuf)
 {
+        int32_t           ret      = 0;
+        uint64_t          value    = 0;
+        qr_inode_t       *qr_inode = NULL;
+        qr_local_t       *local    = NULL;
+        qr_private_t     *priv     = NULL;
+        qr_inode_table_t *table    = NULL;
+
         GF_ASSERT (frame);
-        QR_STACK_UNWIND (lk, frame, op_ret, op_errno, lock);
+
+        if (op_ret == -1) {
+                goto out;
+        }
+
+        local = frame->local;
+        if ((local == NULL) || (local->fd == NULL)
+            || (local->fd->inode == NULL)) {
+                op_ret = -1;
+                op_errno = EINVAL;
+                gf_log (frame->this->name, GF_LOG_WARNING, "cannot get inode");
+                goto out;
+        }
+
+        if ((this == NULL) || (this->private == NULL)) {
+                gf_log (frame->this->name, GF_LOG_WARNING,
+                        (this == NULL) ? "xlator object (this) is NULL"
+                        : "cannot get quick read configuration from xlator "
+                        "object");
+                op_ret = -1;
+                op_errno = EINVAL;
+                goto out;
+        }
+
+        priv = this->private;
+        table = &priv->table;
+
+        LOCK (&table->lock);
+        {
+                ret = inode_ctx_get (local->fd->inode, this, &value);
+                if (ret == 0) {
+                        qr_inode = (qr_inode_t *)(long) value;
+
+                        if (qr_inode) {
+                                inode_ctx_del (local->fd->inode, this, NULL);
+                                __qr_inode_free (table, qr_inode);
+                        }
+                }
+        }
+        UNLOCK (&table->lock);
+
+out:
+        QR_STACK_UNWIND (fallocate, frame, op_ret, op_errno, prebuf,
+                         postbuf);
         return 0;
 }
 
 
 int32_t
-qr_lk_helper (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t cmd,
-              struct gf_flock *lock)
+qr_fallocate_helper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                     int32_t keep_size, off_t offset, size_t len)
 {
         qr_local_t  *local    = NULL;
         qr_fd_ctx_t *fdctx    = NULL;
@@ -3000,31 +3182,33 @@ qr_lk_helper (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t cmd,
                 }
 
                 gf_log (this->name, GF_LOG_WARNING,
-                        "open failed on path (%s) (%s), unwinding lk call",
+                        "open failed on path (%s) (%s), unwinding fallocate "
+                        "call",
                         fdctx ? fdctx->path : NULL, strerror (op_errno));
                 goto unwind;
         }
 
-        STACK_WIND (frame, qr_lk_cbk, FIRST_CHILD(this),
-                    FIRST_CHILD(this)->fops->lk, fd, cmd, lock);
-
+        STACK_WIND (frame, qr_fallocate_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->fallocate, fd, keep_size, offset,
+                    len);
         return 0;
 
 unwind:
-        QR_STACK_UNWIND (lk, frame, -1, op_errno, NULL);
+        QR_STACK_UNWIND (fallocate, frame, -1, op_errno, NULL, NULL);
         return 0;
 }
 
 
 int32_t
-qr_lk (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t cmd,
-       struct gf_flock *lock)
+qr_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              int32_t keep_size, off_t offset, size_t len)
 {
         int           flags      = 0;
         uint64_t      value      = 0;
         call_stub_t  *stub       = NULL;
         char         *path       = NULL;
         loc_t         loc        = {0, };
+        qr_local_t   *local      = NULL;
         qr_fd_ctx_t  *qr_fd_ctx  = NULL;
         int32_t       ret        = -1, op_ret = -1, op_errno = EINVAL;
         char          need_open  = 0, can_wind = 0, need_unwind = 0;
@@ -3044,6 +3228,17 @@ qr_lk (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t cmd,
                 qr_fd_ctx = (qr_fd_ctx_t *)(long)value;
         }
 
+        local = GF_CALLOC (1, sizeof (*local), gf_qr_mt_qr_local_t);
+        if (local == NULL) {
+                op_ret = -1;
+                op_errno = ENOMEM;
+                need_unwind = 1;
+                goto out;
+        }
+
+        local->fd = fd;
+        frame->local = local;
+
         if (qr_fd_ctx) {
                 LOCK (&qr_fd_ctx->lock);
                 {
@@ -3059,19 +3254,10 @@ qr_lk (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t cmd,
                         if (qr_fd_ctx->opened) {
                                 can_wind = 1;
                         } else {
-                                frame->local = GF_CALLOC (1,
-                                                          sizeof (qr_local_t),
-                                                          gf_qr_mt_qr_local_t);
-                                if (frame->local == NULL) {
-                                        op_ret = -1;
-                                        op_errno = ENOMEM;
-                                        need_unwind = 1;
-                                        qr_fd_ctx->open_in_transit = 0;
-                                        goto unlock;
-                                }
-
-                                stub = fop_lk_stub (frame, qr_lk_helper, fd,
-                                                    cmd, lock);
+                                stub = fop_fallocate_stub (frame,
+                                                           qr_fallocate_helper,
+                                                           fd, keep_size,
+                                                           offset, len);
                                 if (stub == NULL) {
                                         op_ret = -1;
                                         op_errno = ENOMEM;
@@ -3092,10 +3278,12 @@ qr_lk (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t cmd,
 
 out:
         if (need_unwind) {
-                QR_STACK_UNWIND (lk, frame, op_ret, op_errno, NULL);
+                QR_STACK_UNWIND (fallocate, frame, op_ret, op_errno, NULL,
+                                 NULL);
         } else if (can_wind) {
-                STACK_WIND (frame, qr_lk_cbk, FIRST_CHILD(this),
-                            FIRST_CHILD(this)->fops->lk, fd, cmd, lock);
+                STACK_WIND (frame, qr_fallocate_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->fallocate, fd, keep_size,
+                            offset, len);
         } else if (need_open) {
                 op_ret = qr_loc_fill (&loc, fd->inode, path);
                 if (op_ret == -1) {
@@ -3123,32 +3311,835 @@ ret:
 
 
 int32_t
-qr_release (xlator_t *this, fd_t *fd)
+qr_discard_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                struct iatt *postbuf)
 {
-        qr_fd_ctx_t *qr_fd_ctx = NULL;
-        int32_t      ret       = 0;
-        uint64_t     value     = 0;
+        int32_t           ret      = 0;
+        uint64_t          value    = 0;
+        qr_inode_t       *qr_inode = NULL;
+        qr_local_t       *local    = NULL;
+        qr_private_t     *priv     = NULL;
+        qr_inode_table_t *table    = NULL;
 
-        GF_VALIDATE_OR_GOTO ("quick-read", this, out);
-        GF_VALIDATE_OR_GOTO (this->name, fd, out);
+        GF_ASSERT (frame);
 
-        ret = fd_ctx_del (fd, this, &value);
-        if (ret == 0) {
-                qr_fd_ctx = (qr_fd_ctx_t *)(long) value;
-                if (qr_fd_ctx) {
-                        qr_fd_ctx_free (qr_fd_ctx);
-                }
+        if (op_ret == -1) {
+                goto out;
         }
 
-out:
-        return 0;
-}
+        local = frame->local;
+        if ((local == NULL) || (local->fd == NULL)
+            || (local->fd->inode == NULL)) {
+                op_ret = -1;
+                op_errno = EINVAL;
+                gf_log (frame->this->name, GF_LOG_WARNING, "cannot get inode");
+                goto out;
+        }
 
+        if ((this == NULL) || (this->private == NULL)) {
+                gf_log (frame->this->name, GF_LOG_WARNING,
+                        (this == NULL) ? "xlator object (this) is NULL"
+                        : "cannot get quick read configuration from xlator "
+                        "object");
+                op_ret = -1;
+                op_errno = EINVAL;
+                goto out;
+        }
 
-int32_t
-qr_forget (xlator_t *this, inode_t *inode)
-{
-        qr_inode_t   *qr_inode = NULL;
+        priv = this->private;
+        table = &priv->table;
+
+        LOCK (&table->lock);
+        {
+                ret = inode_ctx_get (local->fd->inode, this, &value);
+                if (ret == 0) {
+                        qr_inode = (qr_inode_t *)(long) value;
+
+                        if (qr_inode) {
+                                inode_ctx_del (local->fd->inode, this, NULL);
+                                __qr_inode_free (table, qr_inode);
+                        }
+                }
+        }
+        UNLOCK (&table->lock);
+
+out:
+        QR_STACK_UNWIND (discard, frame, op_ret, op_errno, prebuf,
+                         postbuf);
+        return 0;
+}
+
+
+int32_t
+qr_discard_helper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                   off_t offset, size_t len)
+{
+        qr_local_t  *local    = NULL;
+        qr_fd_ctx_t *fdctx    = NULL;
+        uint64_t     value    = 0;
+        int32_t      ret      = 0;
+        int32_t      op_errno = EINVAL;
+
+        GF_ASSERT (frame);
+
+        local = frame->local;
+        GF_VALIDATE_OR_GOTO (frame->this->name, local, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd, unwind);
+
+        if (local->op_ret < 0) {
+                op_errno = local->op_errno;
+
+                ret = fd_ctx_get (fd, this, &value);
+                if (ret == 0) {
+                        fdctx = (qr_fd_ctx_t *)(long) value;
+                }
+
+                gf_log (this->name, GF_LOG_WARNING,
+                        "open failed on path (%s) (%s), unwinding discard "
+                        "call",
+                        fdctx ? fdctx->path : NULL, strerror (op_errno));
+                goto unwind;
+        }
+
+        STACK_WIND (frame, qr_discard_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->discard, fd, offset, len);
+        return 0;
+
+unwind:
+        QR_STACK_UNWIND (discard, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+qr_discard (call_frame_t *frame, xlator_t *this, fd_t *fd,
+            off_t offset, size_t len)
+{
+        int           flags      = 0;
+        uint64_t      value      = 0;
+        call_stub_t  *stub       = NULL;
+        char         *path       = NULL;
+        loc_t         loc        = {0, };
+        qr_local_t   *local      = NULL;
+        qr_fd_ctx_t  *qr_fd_ctx  = NULL;
+        int32_t       ret        = -1, op_ret = -1, op_errno = EINVAL;
+        char          need_open  = 0, can_wind = 0, need_unwind = 0;
+        call_frame_t *open_frame = NULL;
+
+        GF_ASSERT (frame);
+        if ((this == NULL) || (fd == NULL)) {
+                gf_log (frame->this->name, GF_LOG_WARNING,
+                        (this == NULL) ? "xlator object (this) is NULL"
+                        : "fd is NULL");
+                need_unwind = 1;
+                goto out;
+        }
+
+        ret = fd_ctx_get (fd, this, &value);
+        if (ret == 0) {
+                qr_fd_ctx = (qr_fd_ctx_t *)(long)value;
+        }
+
+        local = GF_CALLOC (1, sizeof (*local), gf_qr_mt_qr_local_t);
+        if (local == NULL) {
+                op_ret = -1;
+                op_errno = ENOMEM;
+                need_unwind = 1;
+                goto out;
+        }
+
+        local->fd = fd;
+        frame->local = local;
+
+        if (qr_fd_ctx) {
+                LOCK (&qr_fd_ctx->lock);
+                {
+                        path = qr_fd_ctx->path;
+                        flags = qr_fd_ctx->flags;
+
+                        if (!(qr_fd_ctx->opened
+                              || qr_fd_ctx->open_in_transit)) {
+                                need_open = 1;
+                                qr_fd_ctx->open_in_transit = 1;
+                        }
+
+                        if (qr_fd_ctx->opened) {
+                                can_wind = 1;
+                        } else {
+                                stub = fop_discard_stub (frame,
+                                                         qr_discard_helper,
+                                                         fd, offset, len);
+                                if (stub == NULL) {
+                                        op_ret = -1;
+                                        op_errno = ENOMEM;
+                                        need_unwind = 1;
+                                        qr_fd_ctx->open_in_transit = 0;
+                                        goto unlock;
+                                }
+
+                                list_add_tail (&stub->list,
+                                               &qr_fd_ctx->waiting_ops);
+                        }
+                }
+        unlock:
+                UNLOCK (&qr_fd_ctx->lock);
+        } else {
+                can_wind = 1;
+        }
+
+out:
+        if (need_unwind) {
+                QR_STACK_UNWIND (discard, frame, op_ret, op_errno, NULL,
+                                 NULL);
+        } else if (can_wind) {
+                STACK_WIND (frame, qr_discard_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->discard, fd, offset, len);
+        } else if (need_open) {
+                op_ret = qr_loc_fill (&loc, fd->inode, path);
+                if (op_ret == -1) {
+                        qr_resume_pending_ops (qr_fd_ctx, -1, errno);
+                        goto ret;
+                }
+
+                open_frame = create_frame (this, this->ctx->pool);
+                if (open_frame == NULL) {
+                        qr_resume_pending_ops (qr_fd_ctx, -1, ENOMEM);
+                        qr_loc_wipe (&loc);
+                        goto ret;
+                }
+
+                STACK_WIND (open_frame, qr_open_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->open, &loc, flags, fd,
+                            qr_fd_ctx->wbflags);
+
+                qr_loc_wipe (&loc);
+        }
+
+ret:
+        return 0;
+}
+
+
+int32_t
+qr_zerofill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                 struct iatt *postbuf)
+{
+        int32_t           ret      = 0;
+        uint64_t          value    = 0;
+        qr_inode_t       *qr_inode = NULL;
+        qr_local_t       *local    = NULL;
+        qr_private_t     *priv     = NULL;
+        qr_inode_table_t *table    = NULL;
+
+        GF_ASSERT (frame);
+
+        if (op_ret == -1) {
+                goto out;
+        }
+
+        local = frame->local;
+        if ((local == NULL) || (local->fd == NULL)
+            || (local->fd->inode == NULL)) {
+                op_ret = -1;
+                op_errno = EINVAL;
+                gf_log (frame->this->name, GF_LOG_WARNING, "cannot get inode");
+                goto out;
+        }
+
+        if ((this == NULL) || (this->private == NULL)) {
+                gf_log (frame->this->name, GF_LOG_WARNING,
+                        (this == NULL) ? "xlator object (this) is NULL"
+                        : "cannot get quick read configuration from xlator "
+                        "object");
+                op_ret = -1;
+                op_errno = EINVAL;
+                goto out;
+        }
+
+        priv = this->private;
+        table = &priv->table;
+
+        LOCK (&table->lock);
+        {
+                ret = inode_ctx_get (local->fd->inode, this, &value);
+                if (ret == 0) {
+                        qr_inode = (qr_inode_t *)(long) value;
+
+                        if (qr_inode) {
+                                inode_ctx_del (local->fd->inode, this, NULL);
+                                __qr_inode_free (table, qr_inode);
+                        }
+                }
+        }
+        UNLOCK (&table->lock);
+
+out:
+        QR_STACK_UNWIND (zerofill, frame, op_ret, op_errno, prebuf,
+                         postbuf);
+        return 0;
+}
+
+
+int32_t
+qr_zerofill_helper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                    off_t offset, size_t len)
+{
+        qr_local_t  *local    = NULL;
+        qr_fd_ctx_t *fdctx    = NULL;
+        uint64_t     value    = 0;
+        int32_t      ret      = 0;
+        int32_t      op_errno = EINVAL;
+
+        GF_ASSERT (frame);
+
+        local = frame->local;
+        GF_VALIDATE_OR_GOTO (frame->this->name, local, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd, unwind);
+
+        if (local->op_ret < 0) {
+                op_errno = local->op_errno;
+
+                ret = fd_ctx_get (fd, this, &value);
+                if (ret == 0) {
+                        fdctx = (qr_fd_ctx_t *)(long) value;
+                }
+
+                gf_log (this->name, GF_LOG_WARNING,
+                        "open failed on path (%s) (%s), unwinding zerofill "
+                        "call",
+                        fdctx ? fdctx->path : NULL, strerror (op_errno));
+                goto unwind;
+        }
+
+        STACK_WIND (frame, qr_zerofill_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->zerofill, fd, offset, len);
+        return 0;
+
+unwind:
+        QR_STACK_UNWIND (zerofill, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+qr_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd,
+             off_t offset, size_t len)
+{
+        int           flags      = 0;
+        uint64_t      value      = 0;
+        call_stub_t  *stub       = NULL;
+        char         *path       = NULL;
+        loc_t         loc        = {0, };
+        qr_local_t   *local      = NULL;
+        qr_fd_ctx_t  *qr_fd_ctx  = NULL;
+        int32_t       ret        = -1, op_ret = -1, op_errno = EINVAL;
+        char          need_open  = 0, can_wind = 0, need_unwind = 0;
+        call_frame_t *open_frame = NULL;
+
+        GF_ASSERT (frame);
+        if ((this == NULL) || (fd == NULL)) {
+                gf_log (frame->this->name, GF_LOG_WARNING,
+                        (this == NULL) ? "xlator object (this) is NULL"
+                        : "fd is NULL");
+                need_unwind = 1;
+                goto out;
+        }
+
+        ret = fd_ctx_get (fd, this, &value);
+        if (ret == 0) {
+                qr_fd_ctx = (qr_fd_ctx_t *)(long)value;
+        }
+
+        local = GF_CALLOC (1, sizeof (*local), gf_qr_mt_qr_local_t);
+        if (local == NULL) {
+                op_ret = -1;
+                op_errno = ENOMEM;
+                need_unwind = 1;
+                goto out;
+        }
+
+        local->fd = fd;
+        frame->local = local;
+
+        if (qr_fd_ctx) {
+                LOCK (&qr_fd_ctx->lock);
+                {
+                        path = qr_fd_ctx->path;
+                        flags = qr_fd_ctx->flags;
+
+                        if (!(qr_fd_ctx->opened
+                              || qr_fd_ctx->open_in_transit)) {
+                                need_open = 1;
+                                qr_fd_ctx->open_in_transit = 1;
+                        }
+
+                        if (qr_fd_ctx->opened) {
+                                can_wind = 1;
+                        } else {
+                                stub = fop_zerofill_stub (frame,
+                                                          qr_zerofill_helper,
+                                                          fd, offset, len);
+                                if (stub == NULL) {
+                                        op_ret = -1;
+                                        op_errno = ENOMEM;
+                                        need_unwind = 1;
+                                        qr_fd_ctx->open_in_transit = 0;
+                                        goto unlock;
+                                }
+
+                                list_add_tail (&stub->list,
+                                               &qr_fd_ctx->waiting_ops);
+                        }
+                }
+        unlock:
+                UNLOCK (&qr_fd_ctx->lock);
+        } else {
+                can_wind = 1;
+        }
+
+out:
+        if (need_unwind) {
+                QR_STACK_UNWIND (zerofill, frame, op_ret, op_errno, NULL,
+                                 NULL);
+        } else if (can_wind) {
+                STACK_WIND (frame, qr_zerofill_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->zerofill, fd, offset, len);
+        } else if (need_open) {
+                op_ret = qr_loc_fill (&loc, fd->inode, path);
+                if (op_ret == -1) {
+                        qr_resume_pending_ops (qr_fd_ctx, -1, errno);
+                        goto ret;
+                }
+
+                open_frame = create_frame (this, this->ctx->pool);
+                if (open_frame == NULL) {
+                        qr_resume_pending_ops (qr_fd_ctx, -1, ENOMEM);
+                        qr_loc_wipe (&loc);
+                        goto ret;
+                }
+
+                STACK_WIND (open_frame, qr_open_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->open, &loc, flags, fd,
+                            qr_fd_ctx->wbflags);
+
+                qr_loc_wipe (&loc);
+        }
+
+ret:
+        return 0;
+}
+
+
+/* fd, the destination, is opened and has what is cached of it dropped as
+   for a write. A source not opened yet is read by the bricks through an
+   anonymous fd */
+int32_t
+qr_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                        int32_t op_ret, int32_t op_errno,
+                        struct iatt *stbuf_in, struct iatt *prebuf,
+                        struct iatt *postbuf)
+{
+        int32_t           ret      = 0;
+        uint64_t          value    = 0;
+        qr_inode_t       *qr_inode = NULL;
+        qr_local_t       *local    = NULL;
+        qr_private_t     *priv     = NULL;
+        qr_inode_table_t *table    = NULL;
+
+        GF_ASSERT (frame);
+
+        if (op_ret == -1) {
+                goto out;
+        }
+
+        local = frame->local;
+        if ((local == NULL) || (local->fd == NULL)
+            || (local->fd->inode == NULL)) {
+                op_ret = -1;
+                op_errno = EINVAL;
+                gf_log (frame->this->name, GF_LOG_WARNING, "cannot get inode");
+                goto out;
+        }
+
+        if ((this == NULL) || (this->private == NULL)) {
+                gf_log (frame->this->name, GF_LOG_WARNING,
+                        (this == NULL) ? "xlator object (this) is NULL"
+                        : "cannot get quick read configuration from xlator "
+                        "object");
+                op_ret = -1;
+                op_errno = EINVAL;
+                goto out;
+        }
+
+        priv = this->private;
+        table = &priv->table;
+
+        LOCK (&table->lock);
+        {
+                ret = inode_ctx_get (local->fd->inode, this, &value);
+                if (ret == 0) {
+                        qr_inode = (qr_inode_t *)(long) value;
+
+                        if (qr_inode) {
+                                inode_ctx_del (local->fd->inode, this, NULL);
+                                __qr_inode_free (table, qr_inode);
+                        }
+                }
+        }
+        UNLOCK (&table->lock);
+
+out:
+        QR_STACK_UNWIND (copy_file_range, frame, op_ret, op_errno, stbuf_in,
+                         prebuf, postbuf);
+        return 0;
+}
+
+
+int32_t
+qr_copy_file_range_helper (call_frame_t *frame, xlator_t *this,
+                           fd_t *fd_in, off_t off_in, fd_t *fd,
+                           off_t off_out, size_t len, uint32_t flags)
+{
+        qr_local_t  *local    = NULL;
+        qr_fd_ctx_t *fdctx    = NULL;
+        uint64_t     value    = 0;
+        int32_t      ret      = 0;
+        int32_t      op_errno = EINVAL;
+
+        GF_ASSERT (frame);
+
+        local = frame->local;
+        GF_VALIDATE_OR_GOTO (frame->this->name, local, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd, unwind);
+
+        if (local->op_ret < 0) {
+                op_errno = local->op_errno;
+
+                ret = fd_ctx_get (fd, this, &value);
+                if (ret == 0) {
+                        fdctx = (qr_fd_ctx_t *)(long) value;
+                }
+
+                gf_log (this->name, GF_LOG_WARNING,
+                        "open failed on path (%s) (%s), unwinding "
+                        "copy_file_range call",
+                        fdctx ? fdctx->path : NULL, strerror (op_errno));
+                goto unwind;
+        }
+
+        STACK_WIND (frame, qr_copy_file_range_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                    fd, off_out, len, flags);
+        return 0;
+
+unwind:
+        QR_STACK_UNWIND (copy_file_range, frame, -1, op_errno, NULL, NULL,
+                         NULL);
+        return 0;
+}
+
+
+int32_t
+qr_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off_t off_in, fd_t *fd, off_t off_out, size_t len,
+                    uint32_t flags)
+{
+        int           open_flags = 0;
+        uint64_t      value      = 0;
+        call_stub_t  *stub       = NULL;
+        char         *path       = NULL;
+        loc_t         loc        = {0, };
+        qr_local_t   *local      = NULL;
+        qr_fd_ctx_t  *qr_fd_ctx  = NULL;
+        int32_t       ret        = -1, op_ret = -1, op_errno = EINVAL;
+        char          need_open  = 0, can_wind = 0, need_unwind = 0;
+        call_frame_t *open_frame = NULL;
+
+        GF_ASSERT (frame);
+        if ((this == NULL) || (fd == NULL)) {
+                gf_log (frame->this->name, GF_LOG_WARNING,
+                        (this == NULL) ? "xlator object (this) is NULL"
+                        : "fd is NULL");
+                need_unwind = 1;
+                goto out;
+        }
+
+        ret = fd_ctx_get (fd, this, &value);
+        if (ret == 0) {
+                qr_fd_ctx = (qr_fd_ctx_t *)(long)value;
+        }
+
+        local = GF_CALLOC (1, sizeof (*local), gf_qr_mt_qr_local_t);
+        if (local == NULL) {
+                op_ret = -1;
+                op_errno = ENOMEM;
+                need_unwind = 1;
+                goto out;
+        }
+
+        local->fd = fd;
+        frame->local = local;
+
+        if (qr_fd_ctx) {
+                LOCK (&qr_fd_ctx->lock);
+                {
+                        path = qr_fd_ctx->path;
+                        open_flags = qr_fd_ctx->flags;
+
+                        if (!(qr_fd_ctx->opened
+                              || qr_fd_ctx->open_in_transit)) {
+                                need_open = 1;
+                                qr_fd_ctx->open_in_transit = 1;
+                        }
+
+                        if (qr_fd_ctx->opened) {
+                                can_wind = 1;
+                        } else {
+                                stub = fop_copy_file_range_stub (frame,
+                                        qr_copy_file_range_helper, fd_in,
+                                        off_in, fd, off_out, len, flags);
+                                if (stub == NULL) {
+                                        op_ret = -1;
+                                        op_errno = ENOMEM;
+                                        need_unwind = 1;
+                                        qr_fd_ctx->open_in_transit = 0;
+                                        goto unlock;
+                                }
+
+                                list_add_tail (&stub->list,
+                                               &qr_fd_ctx->waiting_ops);
+                        }
+                }
+        unlock:
+                UNLOCK (&qr_fd_ctx->lock);
+        } else {
+                can_wind = 1;
+        }
+
+out:
+        if (need_unwind) {
+                QR_STACK_UNWIND (copy_file_range, frame, op_ret, op_errno,
+                                 NULL, NULL, NULL);
+        } else if (can_wind) {
+                STACK_WIND (frame, qr_copy_file_range_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->copy_file_range, fd_in,
+                            off_in, fd, off_out, len, flags);
+        } else if (need_open) {
+                op_ret = qr_loc_fill (&loc, fd->inode, path);
+                if (op_ret == -1) {
+                        qr_resume_pending_ops (qr_fd_ctx, -1, errno);
+                        goto ret;
+                }
+
+                open_frame = create_frame (this, this->ctx->pool);
+                if (open_frame == NULL) {
+                        qr_resume_pending_ops (qr_fd_ctx, -1, ENOMEM);
+                        qr_loc_wipe (&loc);
+                        goto ret;
+                }
+
+                STACK_WIND (open_frame, qr_open_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->open, &loc, open_flags,
+                            fd, qr_fd_ctx->wbflags);
+
+                qr_loc_wipe (&loc);
+        }
+
+ret:
+        return 0;
+}
+
+
+int32_t
+qr_lk_cbk (call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
+           int32_t op_errno, struct gf_flock *lock)
+{
+        GF_ASSERT (frame);
+        QR_STACK_UNWIND (lk, frame, op_ret, op_errno, lock);
+        return 0;
+}
+
+
+int32_t
+qr_lk_helper (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t cmd,
+              struct gf_flock *lock)
+{
+        qr_local_t  *local    = NULL;
+        qr_fd_ctx_t *fdctx    = NULL;
+        uint64_t     value    = 0;
+        int32_t      ret      = 0;
+        int32_t      op_errno = EINVAL;
+
+        GF_ASSERT (frame);
+
+        local = frame->local;
+        GF_VALIDATE_OR_GOTO (frame->this->name, local, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd, unwind);
+
+        if (local->op_ret < 0) {
+                op_errno = local->op_errno;
+
+                ret = fd_ctx_get (fd, this, &value);
+                if (ret == 0) {
+                        fdctx = (qr_fd_ctx_t *)(long) value;
+                }
+
+                gf_log (this->name, GF_LOG_WARNING,
+                        "open failed on path (%s) (%s), unwinding lk call",
+                        fdctx ? fdctx->path : NULL, strerror (op_errno));
+                goto unwind;
+        }
+
+        STACK_WIND (frame, qr_lk_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->lk, fd, cmd, lock);
+
+        return 0;
+
+unwind:
+        QR_STACK_UNWIND (lk, frame, -1, op_errno, NULL);
+        return 0;
+}
+
+
+int32_t
+qr_lk (call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t cmd,
+       struct gf_flock *lock)
+{
+        int           flags      = 0;
+        uint64_t      value      = 0;
+        call_stub_t  *stub       = NULL;
+        char         *path       = NULL;
+        loc_t         loc        = {0, };
+        qr_fd_ctx_t  *qr_fd_ctx  = NULL;
+        int32_t       ret        = -1, op_ret = -1, op_errno = EINVAL;
+        char          need_open  = 0, can_wind = 0, need_unwind = 0;
+        call_frame_t *open_frame = NULL;
+
+        GF_ASSERT (frame);
+        if ((this == NULL) || (fd == NULL)) {
+                gf_log (frame->this->name, GF_LOG_WARNING,
+                        (this == NULL) ? "xlator object (this) is NULL"
+                        : "fd is NULL");
+                need_unwind = 1;
+                goto out;
+        }
+
+        ret = fd_ctx_get (fd, this, &value);
+        if (ret == 0) {
+                qr_fd_ctx = (qr_fd_ctx_t *)(long)value;
+        }
+
+        if (qr_fd_ctx) {
+                LOCK (&qr_fd_ctx->lock);
+                {
+                        path = qr_fd_ctx->path;
+                        flags = qr_fd_ctx->flags;
+
+                        if (!(qr_fd_ctx->opened
+                              || qr_fd_ctx->open_in_transit)) {
+                                need_open = 1;
+                                qr_fd_ctx->open_in_transit = 1;
+                        }
+
+                        if (qr_fd_ctx->opened) {
+                                can_wind = 1;
+                        } else {
+                                frame->local = GF_CALLOC (1,
+                                                          sizeof (qr_local_t),
+                                                          gf_qr_mt_qr_local_t);
+                                if (frame->local == NULL) {
+                                        op_ret = -1;
+                                        op_errno = ENOMEM;
+                                        need_unwind = 1;
+                                        qr_fd_ctx->open_in_transit = 0;
+                                        goto unlock;
+                                }
+
+                                stub = fop_lk_stub (frame, qr_lk_helper, fd,
+                                                    cmd, lock);
+                                if (stub == NULL) {
+                                        op_ret = -1;
+                                        op_errno = ENOMEM;
+                                        need_unwind = 1;
+                                        qr_fd_ctx->open_in_transit = 0;
+                                        goto unlock;
+                                }
+
+                                list_add_tail (&stub->list,
+                                               &qr_fd_ctx->waiting_ops);
+                        }
+                }
+        unlock:
+                UNLOCK (&qr_fd_ctx->lock);
+        } else {
+                can_wind = 1;
+        }
+
+out:
+        if (need_unwind) {
+                QR_STACK_UNWIND (lk, frame, op_ret, op_errno, NULL);
+        } else if (can_wind) {
+                STACK_WIND (frame, qr_lk_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->lk, fd, cmd, lock);
+        } else if (need_open) {
+                op_ret = qr_loc_fill (&loc, fd->inode, path);
+                if (op_ret == -1) {
+                        qr_resume_pending_ops (qr_fd_ctx, -1, errno);
+                        goto ret;
+                }
+
+                open_frame = create_frame (this, this->ctx->pool);
+                if (open_frame == NULL) {
+                        qr_resume_pending_ops (qr_fd_ctx, -1, ENOMEM);
+                        qr_loc_wipe (&loc);
+                        goto ret;
+                }
+
+                STACK_WIND (open_frame, qr_open_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->open, &loc, flags, fd,
+                            qr_fd_ctx->wbflags);
+
+                qr_loc_wipe (&loc);
+        }
+
+ret:
+        return 0;
+}
+
+
+int32_t
+qr_release (xlator_t *this, fd_t *fd)
+{
+        qr_fd_ctx_t *qr_fd_ctx = NULL;
+        int32_t      ret       = 0;
+        uint64_t     value     = 0;
+
+        GF_VALIDATE_OR_GOTO ("quick-read", this, out);
+        GF_VALIDATE_OR_GOTO (this->name, fd, out);
+
+        ret = fd_ctx_del (fd, this, &value);
+        if (ret == 0) {
+                qr_fd_ctx = (qr_fd_ctx_t *)(long) value;
+                if (qr_fd_ctx) {
+                        qr_fd_ctx_free (qr_fd_ctx);
+                }
+        }
+
+out:
+        return 0;
+}
+
+
+int32_t
+qr_forget (xlator_t *this, inode_t *inode)
+{
+        qr_inode_t   *qr_inode = NULL;
         uint64_t      value     = 0;
         int32_t       ret       = -1;
         qr_private_t *priv      = NULL;
@@ -3164,7 +4155,7 @@ qr_forget (xlator_t *this, inode_t *inode)
                 ret = inode_ctx_del (inode, this, &value);
                 if (ret == 0) {
                         qr_inode = (qr_inode_t *)(long) value;
-                        __qr_inode_free (qr_inode);
+                        __qr_inode_free (&priv->table, qr_inode);
                 }
         }
         UNLOCK (&priv->table.lock);
@@ -3174,6 +4165,26 @@ out:
 }
 
 
+int
+notify (xlator_t *this, int32_t event, void *data, ...)
+{
+        struct gf_upcall *upcall = NULL;
+
+        if (event == GF_EVENT_UPCALL) {
+                upcall = data;
+
+                /* the whole file is cached along with its attributes, so
+                   any change of the inode makes the cache stale */
+                if (upcall->inode
+                    && (upcall->flags & (GF_UPCALL_DATA | GF_UPCALL_ATTR
+                                         | GF_UPCALL_NAMES)))
+                        qr_forget (this, upcall->inode);
+        }
+
+        return default_notify (this, event, data);
+}
+
+
 int32_t
 qr_inodectx_dump (xlator_t *this, inode_t *inode)
 {
@@ -3198,6 +4209,8 @@ qr_inodectx_dump (xlator_t *this, inode_t *inode)
         gf_proc_dump_add_section (key_prefix);
 
         gf_proc_dump_write ("entire-file-cached", "%s", qr_inode->xattr ? "yes" : "no");
+        gf_proc_dump_write ("compressed", "%s",
+                            qr_inode->compressed ? "yes" : "no");
 
         tm = localtime (&qr_inode->tv.tv_sec);
         strftime (buf, 256, "%Y-%m-%d %H:%M:%S", tm);
@@ -3283,6 +4296,7 @@ qr_priv_dump (xlator_t *this)
         uint32_t          i          = 0;
         qr_inode_t       *curr       = NULL;
         uint64_t          total_size = 0;
+        uint64_t          raw_size   = 0;
         char              key_prefix[GF_DUMP_MAX_BUF_LEN];
 
         if (!this) {
@@ -3315,13 +4329,21 @@ qr_priv_dump (xlator_t *this)
                 for (i = 0; i < conf->max_pri; i++) {
                         list_for_each_entry (curr, &table->lru[i], lru) {
                                 file_count++;
-                                total_size += curr->stbuf.ia_size;
+                                total_size += curr->size;
+                                raw_size += curr->raw_size;
                         }
                 }
         }
 
         gf_proc_dump_write ("total_files_cached", "%d", file_count);
-        gf_proc_dump_write ("total_cache_used", "%d", total_size);
+        gf_proc_dump_write ("total_cache_used", "%"PRIu64, total_size);
+        gf_proc_dump_write ("cache_compression", "%s",
+                            conf->compress ? "on" : "off");
+        gf_proc_dump_write ("total_content_size", "%"PRIu64, raw_size);
+        if (total_size) {
+                gf_proc_dump_write ("compression_ratio", "%.2f",
+                                    (double) raw_size / total_size);
+        }
 
 out:
         return 0;
@@ -3404,6 +4426,9 @@ reconfigure (xlator_t *this, dict_t *options)
         GF_OPTION_RECONF ("cache-timeout", conf->cache_timeout, options, int32,
                           out);
 
+        GF_OPTION_RECONF ("cache-compression", conf->compress, options, bool,
+                          out);
+
         GF_OPTION_RECONF ("cache-size", cache_size_new, options, size, out);
         if (!check_cache_size_ok (this, cache_size_new)) {
                 ret = -1;
@@ -3553,6 +4578,14 @@ init (xlator_t *this)
 
         GF_OPTION_INIT ("cache-timeout", conf->cache_timeout, int32, out);
 
+        GF_OPTION_INIT ("cache-compression", conf->compress, bool, out);
+#ifndef HAVE_LIBZ
+        if (conf->compress) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "built without zlib, cache-compression is ignored");
+        }
+#endif
+
         GF_OPTION_INIT ("cache-size", conf->cache_size, size, out);
         if (!check_cache_size_ok (this, conf->cache_size)) {
                 ret = -1;
@@ -3618,6 +4651,10 @@ struct xlator_fops fops = {
         .finodelk    = qr_finodelk,
         .fsync       = qr_fsync,
         .ftruncate   = qr_ftruncate,
+        .fallocate   = qr_fallocate,
+        .discard     = qr_discard,
+        .zerofill    = qr_zerofill,
+        .copy_file_range = qr_copy_file_range,
         .lk          = qr_lk,
         .fsetattr    = qr_fsetattr,
 };
@@ -3656,4 +4693,11 @@ struct volume_options options[] = {
           .max  = 1 * GF_UNIT_KB * 1000,
           .default_value = "64KB",
         },
+        { .key  = {"cache-compression"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Keep the cached file contents deflated. More "
+                         "files fit in cache-size at the cost of inflating "
+                         "them on every read."
+        },
 };
@@ -43,6 +43,10 @@
 #include <fnmatch.h>
 #include "quick-read-mem-types.h"
 
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+
 struct qr_fd_ctx {
         char              opened;
         char              disabled;
@@ -71,6 +75,9 @@ struct qr_inode {
         dict_t           *xattr;
         inode_t          *inode;
         int               priority;
+        char              compressed;   /* content in xattr is deflated */
+        uint64_t          raw_size;     /* size of the file content */
+        uint64_t          size;         /* bytes charged to the cache */
         struct iatt       stbuf;
         struct timeval    tv;
         struct list_head  lru;
@@ -88,6 +95,7 @@ struct qr_conf {
         uint64_t         max_file_size;
         int32_t          cache_timeout;
         uint64_t         cache_size;
+        gf_boolean_t     compress;
         int              max_pri;
         struct list_head priority_list;
 };
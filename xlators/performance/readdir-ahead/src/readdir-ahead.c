@@ -0,0 +1,1164 @@
+/*
+  Copyright (c) 2008-2011 Gluster, Inc. <http://www.gluster.com>
+  This file is part of GlusterFS.
+
+  GlusterFS is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published
+  by the Free Software Foundation; either version 3 of the License,
+  or (at your option) any later version.
+
+  GlusterFS is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+/*
+ * readdir-ahead: prefetch directory entries (with their iatts) in the
+ * background as soon as a directory is opened, and serve sequential
+ * readdir(p) requests out of a bounded per-fd buffer. Sitting below
+ * stat-prefetch, the iatts we hand up populate its dentry cache exactly
+ * like a synchronous readdirp would.
+ *
+ * Only strictly sequential readers are served from the buffer; the first
+ * request at an unexpected offset switches the fd to pass-through.
+ *
+ * Buffered iatts are only as fresh as the moment the fill was wound. Every
+ * directory has a generation number, kept in the ctx of its inode, which
+ * is bumped when an entry is added to or removed from it, or when the
+ * attributes of one of its entries are set. Entries fetched under an
+ * older generation of their directory are thrown away and fetched again
+ * instead of being handed up. Writes do not bump it: the size and times
+ * of a file written meanwhile are as a readdirp wound at the fill would
+ * have returned them.
+ */
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include "glusterfs.h"
+#include "xlator.h"
+#include "call-stub.h"
+#include "statedump.h"
+#include "readdir-ahead.h"
+
+static void
+rda_fill_fd (call_frame_t *frame, xlator_t *this);
+
+
+static rda_fd_ctx_t *
+get_rda_fd_ctx (fd_t *fd, xlator_t *this)
+{
+        uint64_t      val = 0;
+        rda_fd_ctx_t *ctx = NULL;
+
+        LOCK (&fd->lock);
+        {
+                if (__fd_ctx_get (fd, this, &val) == 0) {
+                        ctx = (rda_fd_ctx_t *)(long) val;
+                        goto unlock;
+                }
+
+                ctx = GF_CALLOC (1, sizeof (*ctx), gf_rda_mt_rda_fd_ctx_t);
+                if (!ctx)
+                        goto unlock;
+
+                LOCK_INIT (&ctx->lock);
+                INIT_LIST_HEAD (&ctx->entries.list);
+                ctx->state = RDA_FD_NEW;
+
+                if (__fd_ctx_set (fd, this, (uint64_t)(long) ctx) < 0) {
+                        LOCK_DESTROY (&ctx->lock);
+                        GF_FREE (ctx);
+                        ctx = NULL;
+                }
+        }
+unlock:
+        UNLOCK (&fd->lock);
+
+        return ctx;
+}
+
+
+static uint64_t
+rda_get_gen (xlator_t *this, inode_t *dir)
+{
+        uint64_t gen = 0;
+
+        inode_ctx_get (dir, this, &gen);
+
+        return gen;
+}
+
+
+static void
+rda_mark_modified (xlator_t *this, inode_t *dir)
+{
+        uint64_t gen = 0;
+
+        if (!dir)
+                return;
+
+        LOCK (&dir->lock);
+        {
+                __inode_ctx_get (dir, this, &gen);
+                __inode_ctx_put (dir, this, gen + 1);
+        }
+        UNLOCK (&dir->lock);
+}
+
+
+/* the directory loc is an entry of, referenced */
+static inode_t *
+rda_loc_parent (loc_t *loc)
+{
+        if (loc->parent)
+                return inode_ref (loc->parent);
+
+        if (loc->inode)
+                return inode_parent (loc->inode, loc->pargfid, loc->name);
+
+        return NULL;
+}
+
+
+static void
+rda_mark_modified_unref (xlator_t *this, int32_t op_ret, inode_t *dir)
+{
+        if (!dir)
+                return;
+
+        if (op_ret >= 0)
+                rda_mark_modified (this, dir);
+
+        inode_unref (dir);
+}
+
+
+/* throw away everything buffered and restart the fill from the offset the
+ * reader is at. caller holds ctx->lock.
+ */
+static void
+__rda_reset_buffer (rda_fd_ctx_t *ctx)
+{
+        gf_dirent_free (&ctx->entries);
+        INIT_LIST_HEAD (&ctx->entries.list);
+
+        ctx->cur_size    = 0;
+        ctx->next_offset = ctx->cur_offset;
+        ctx->state      &= ~(RDA_FD_EOD | RDA_FD_ERROR);
+        ctx->seq++;
+}
+
+
+/* move at most @request_size bytes worth of dirents (but at least one) from
+ * the buffer into @entries. caller holds ctx->lock.
+ */
+static int32_t
+__rda_serve (rda_fd_ctx_t *ctx, size_t request_size, gf_dirent_t *entries)
+{
+        gf_dirent_t *dirent      = NULL;
+        gf_dirent_t *tmp         = NULL;
+        size_t       dirent_size = 0;
+        size_t       size        = 0;
+        int32_t      count       = 0;
+
+        list_for_each_entry_safe (dirent, tmp, &ctx->entries.list, list) {
+                dirent_size = gf_dirent_size (dirent->d_name);
+                if (count && ((size + dirent_size) > request_size))
+                        break;
+
+                size += dirent_size;
+                ctx->cur_size -= dirent_size;
+                ctx->cur_offset = dirent->d_off;
+
+                list_del_init (&dirent->list);
+                list_add_tail (&dirent->list, &entries->list);
+                count++;
+        }
+
+        return count;
+}
+
+
+/* set up (or reuse) the background frame which carries the fill, and mark
+ * the fd as having a fill in flight. caller holds ctx->lock.
+ */
+static call_frame_t *
+__rda_prepare_fill (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                    rda_fd_ctx_t *ctx, uint64_t gen)
+{
+        call_frame_t *fill_frame = NULL;
+        rda_local_t  *local      = NULL;
+
+        fill_frame = ctx->fill_frame;
+        if (!fill_frame) {
+                fill_frame = copy_frame (frame);
+                if (!fill_frame)
+                        goto out;
+
+                local = GF_CALLOC (1, sizeof (*local), gf_rda_mt_rda_local_t);
+                if (!local) {
+                        STACK_DESTROY (fill_frame->root);
+                        fill_frame = NULL;
+                        goto out;
+                }
+
+                local->fd = fd_ref (fd);
+                fill_frame->local = local;
+                ctx->fill_frame = fill_frame;
+        }
+
+        local = fill_frame->local;
+        local->offset = ctx->next_offset;
+        local->gen    = gen;
+        local->seq    = ctx->seq;
+
+        ctx->state &= ~(RDA_FD_NEW | RDA_FD_PLUGGED);
+        ctx->state |= RDA_FD_RUNNING;
+out:
+        return fill_frame;
+}
+
+
+static void
+rda_unwind (call_frame_t *frame, gf_boolean_t plus, int32_t op_ret,
+            int32_t op_errno, gf_dirent_t *entries)
+{
+        if (plus)
+                STACK_UNWIND_STRICT (readdirp, frame, op_ret, op_errno,
+                                     entries);
+        else
+                STACK_UNWIND_STRICT (readdir, frame, op_ret, op_errno,
+                                     entries);
+}
+
+
+int32_t
+rda_fill_fd_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, gf_dirent_t *entries)
+{
+        rda_priv_t   *priv        = NULL;
+        rda_local_t  *local       = NULL;
+        rda_fd_ctx_t *ctx         = NULL;
+        gf_dirent_t  *dirent      = NULL;
+        gf_dirent_t  *tmp         = NULL;
+        call_frame_t *wait_frame  = NULL;
+        gf_boolean_t  wait_plus   = _gf_false;
+        gf_boolean_t  refill      = _gf_false;
+        int32_t       serve_ret   = 0;
+        int32_t       serve_errno = 0;
+        uint64_t      gen         = 0;
+        gf_dirent_t   serve;
+
+        priv  = this->private;
+        local = frame->local;
+
+        INIT_LIST_HEAD (&serve.list);
+
+        ctx = get_rda_fd_ctx (local->fd, this);
+        if (!ctx) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "fd context of fd (%p) vanished during a fill",
+                        local->fd);
+                goto out;
+        }
+
+        gen = rda_get_gen (this, local->fd->inode);
+
+        LOCK (&ctx->lock);
+        {
+                /* the buffer was reset while we were in flight */
+                if (local->seq != ctx->seq)
+                        goto next;
+
+                if (!ctx->cur_size)
+                        ctx->gen = local->gen;
+
+                if (op_ret < 0) {
+                        ctx->state |= RDA_FD_ERROR;
+                        ctx->op_errno = op_errno;
+                } else if (op_ret == 0) {
+                        ctx->state |= RDA_FD_EOD;
+                } else {
+                        list_for_each_entry_safe (dirent, tmp, &entries->list,
+                                                  list) {
+                                list_del_init (&dirent->list);
+                                list_add_tail (&dirent->list,
+                                               &ctx->entries.list);
+                                ctx->cur_size += gf_dirent_size (dirent->d_name);
+                                ctx->next_offset = dirent->d_off;
+                        }
+                }
+
+        next:
+                if (ctx->wait_frame
+                    && (ctx->cur_size
+                        || (ctx->state & (RDA_FD_EOD | RDA_FD_ERROR)))) {
+                        if (ctx->gen < ctx->wait_gen) {
+                                /* fetched before the reader showed up, and
+                                   something changed since. go again. */
+                                __rda_reset_buffer (ctx);
+                        } else {
+                                wait_frame = ctx->wait_frame;
+                                wait_plus = ctx->wait_plus;
+                                ctx->wait_frame = NULL;
+
+                                if (ctx->cur_size) {
+                                        serve_ret = __rda_serve (ctx,
+                                                                 ctx->wait_size,
+                                                                 &serve);
+                                } else if (ctx->state & RDA_FD_EOD) {
+                                        serve_ret = 0;
+                                } else {
+                                        serve_ret = -1;
+                                        serve_errno = ctx->op_errno;
+                                        ctx->state |= RDA_FD_BYPASS;
+                                }
+                        }
+                }
+
+                if ((ctx->state & (RDA_FD_EOD | RDA_FD_ERROR | RDA_FD_BYPASS))
+                    && !ctx->wait_frame) {
+                        refill = _gf_false;
+                } else if ((ctx->cur_size >= priv->rda_high_wmark)
+                           && !ctx->wait_frame) {
+                        ctx->state |= RDA_FD_PLUGGED;
+                        refill = _gf_false;
+                } else {
+                        local->offset = ctx->next_offset;
+                        local->gen    = gen;
+                        local->seq    = ctx->seq;
+                        refill = _gf_true;
+                }
+
+                if (!refill) {
+                        ctx->state &= ~RDA_FD_RUNNING;
+                        ctx->fill_frame = NULL;
+                }
+        }
+        UNLOCK (&ctx->lock);
+
+        if (wait_frame) {
+                rda_unwind (wait_frame, wait_plus, serve_ret, serve_errno,
+                            &serve);
+                gf_dirent_free (&serve);
+        }
+
+        if (refill) {
+                rda_fill_fd (frame, this);
+                return 0;
+        }
+
+out:
+        fd_unref (local->fd);
+        local->fd = NULL;
+        STACK_DESTROY (frame->root);
+
+        return 0;
+}
+
+
+static void
+rda_fill_fd (call_frame_t *frame, xlator_t *this)
+{
+        rda_priv_t  *priv  = NULL;
+        rda_local_t *local = NULL;
+
+        priv  = this->private;
+        local = frame->local;
+
+        STACK_WIND (frame, rda_fill_fd_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->readdirp, local->fd,
+                    priv->rda_req_size, local->offset);
+}
+
+
+static int32_t
+rda_do_readdir (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+                off_t off, gf_boolean_t plus)
+{
+        rda_priv_t   *priv       = NULL;
+        rda_fd_ctx_t *ctx        = NULL;
+        call_frame_t *fill_frame = NULL;
+        gf_boolean_t  bypass     = _gf_false;
+        gf_boolean_t  serve      = _gf_false;
+        gf_boolean_t  disabled   = _gf_false;
+        int32_t       op_ret     = -1;
+        int32_t       op_errno   = 0;
+        uint64_t      gen        = 0;
+        gf_dirent_t   entries;
+
+        priv = this->private;
+
+        INIT_LIST_HEAD (&entries.list);
+
+        ctx = get_rda_fd_ctx (fd, this);
+        if (!ctx) {
+                bypass = _gf_true;
+                goto wind;
+        }
+
+        gen = rda_get_gen (this, fd->inode);
+
+        LOCK (&ctx->lock);
+        {
+                if (ctx->state & RDA_FD_BYPASS) {
+                        bypass = _gf_true;
+                        goto unlock;
+                }
+
+                /* another reader is already waiting on this fd; let this
+                   one go straight through */
+                if (ctx->wait_frame) {
+                        bypass = _gf_true;
+                        goto unlock;
+                }
+
+                if (off != ctx->cur_offset) {
+                        gf_log (this->name, GF_LOG_DEBUG,
+                                "non-sequential readdir on fd (%p) "
+                                "(expected %"PRId64", got %"PRId64"), "
+                                "disabling readdir-ahead", fd,
+                                (int64_t) ctx->cur_offset, (int64_t) off);
+                        __rda_reset_buffer (ctx);
+                        ctx->state |= RDA_FD_BYPASS;
+                        bypass = _gf_true;
+                        disabled = _gf_true;
+                        goto unlock;
+                }
+
+                if ((ctx->cur_size || (ctx->state & RDA_FD_EOD))
+                    && (ctx->gen != gen))
+                        __rda_reset_buffer (ctx);
+
+                if (ctx->cur_size) {
+                        op_ret = __rda_serve (ctx, size, &entries);
+                        ctx->hits++;
+                        serve = _gf_true;
+                } else if (ctx->state & RDA_FD_EOD) {
+                        op_ret = 0;
+                        serve = _gf_true;
+                } else if (ctx->state & RDA_FD_ERROR) {
+                        op_ret = -1;
+                        op_errno = ctx->op_errno;
+                        ctx->state |= RDA_FD_BYPASS;
+                        serve = _gf_true;
+                } else {
+                        ctx->wait_frame = frame;
+                        ctx->wait_size  = size;
+                        ctx->wait_plus  = plus;
+                        ctx->wait_gen   = gen;
+                        ctx->waits++;
+                }
+
+                if (!(ctx->state & (RDA_FD_RUNNING | RDA_FD_EOD | RDA_FD_ERROR
+                                    | RDA_FD_BYPASS))
+                    && (ctx->wait_frame
+                        || (ctx->cur_size < priv->rda_low_wmark))) {
+                        fill_frame = __rda_prepare_fill (frame, this, fd, ctx,
+                                                         gen);
+                        if (!fill_frame && !serve) {
+                                /* nobody will wake the reader up */
+                                ctx->wait_frame = NULL;
+                                ctx->state |= RDA_FD_BYPASS;
+                                bypass = _gf_true;
+                                disabled = _gf_true;
+                        }
+                }
+        }
+unlock:
+        UNLOCK (&ctx->lock);
+
+        if (disabled) {
+                LOCK (&priv->lock);
+                {
+                        priv->bypassed++;
+                }
+                UNLOCK (&priv->lock);
+        }
+
+        if (fill_frame)
+                rda_fill_fd (fill_frame, this);
+
+        if (serve) {
+                rda_unwind (frame, plus, op_ret, op_errno, &entries);
+                gf_dirent_free (&entries);
+        }
+
+wind:
+        if (bypass) {
+                if (plus)
+                        STACK_WIND (frame, default_readdirp_cbk,
+                                    FIRST_CHILD (this),
+                                    FIRST_CHILD (this)->fops->readdirp,
+                                    fd, size, off);
+                else
+                        STACK_WIND (frame, default_readdir_cbk,
+                                    FIRST_CHILD (this),
+                                    FIRST_CHILD (this)->fops->readdir,
+                                    fd, size, off);
+        }
+
+        return 0;
+}
+
+
+int32_t
+rda_readdirp (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+              off_t off)
+{
+        return rda_do_readdir (frame, this, fd, size, off, _gf_true);
+}
+
+
+int32_t
+rda_readdir (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+             off_t off)
+{
+        return rda_do_readdir (frame, this, fd, size, off, _gf_false);
+}
+
+
+int32_t
+rda_opendir_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, fd_t *fd)
+{
+        rda_fd_ctx_t *ctx        = NULL;
+        call_frame_t *fill_frame = NULL;
+        uint64_t      gen        = 0;
+
+        if (op_ret < 0)
+                goto unwind;
+
+        ctx = get_rda_fd_ctx (fd, this);
+        if (!ctx)
+                goto unwind;
+
+        gen = rda_get_gen (this, fd->inode);
+
+        LOCK (&ctx->lock);
+        {
+                if (ctx->state == RDA_FD_NEW)
+                        fill_frame = __rda_prepare_fill (frame, this, fd, ctx,
+                                                         gen);
+        }
+        UNLOCK (&ctx->lock);
+
+        if (fill_frame)
+                rda_fill_fd (fill_frame, this);
+
+unwind:
+        STACK_UNWIND_STRICT (opendir, frame, op_ret, op_errno, fd);
+        return 0;
+}
+
+
+int32_t
+rda_opendir (call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd)
+{
+        STACK_WIND (frame, rda_opendir_cbk, FIRST_CHILD (this),
+                    FIRST_CHILD (this)->fops->opendir, loc, fd);
+        return 0;
+}
+
+
+/* modification fops: the directory of the entries they change is
+   handed to their callback as cookie, referenced */
+
+int32_t
+rda_setattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *statpre,
+                 struct iatt *statpost)
+{
+        rda_mark_modified_unref (this, op_ret, cookie);
+
+        STACK_UNWIND_STRICT (setattr, frame, op_ret, op_errno, statpre,
+                             statpost);
+        return 0;
+}
+
+
+int32_t
+rda_setattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+             struct iatt *stbuf, int32_t valid)
+{
+        STACK_WIND_COOKIE (frame, rda_setattr_cbk, rda_loc_parent (loc),
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->setattr, loc, stbuf,
+                           valid);
+        return 0;
+}
+
+
+int32_t
+rda_fsetattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iatt *statpre,
+                  struct iatt *statpost)
+{
+        rda_mark_modified_unref (this, op_ret, cookie);
+
+        STACK_UNWIND_STRICT (fsetattr, frame, op_ret, op_errno, statpre,
+                             statpost);
+        return 0;
+}
+
+
+int32_t
+rda_fsetattr (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              struct iatt *stbuf, int32_t valid)
+{
+        STACK_WIND_COOKIE (frame, rda_fsetattr_cbk,
+                           inode_parent (fd->inode, NULL, NULL),
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->fsetattr, fd, stbuf,
+                           valid);
+        return 0;
+}
+
+
+int32_t
+rda_create_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, fd_t *fd, inode_t *inode,
+                struct iatt *buf, struct iatt *preparent,
+                struct iatt *postparent)
+{
+        rda_mark_modified_unref (this, op_ret, cookie);
+
+        STACK_UNWIND_STRICT (create, frame, op_ret, op_errno, fd, inode, buf,
+                             preparent, postparent);
+        return 0;
+}
+
+
+int32_t
+rda_create (call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+            mode_t mode, fd_t *fd, dict_t *params)
+{
+        STACK_WIND_COOKIE (frame, rda_create_cbk, rda_loc_parent (loc),
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->create, loc, flags, mode,
+                           fd, params);
+        return 0;
+}
+
+
+int32_t
+rda_mknod_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, inode_t *inode,
+               struct iatt *buf, struct iatt *preparent,
+               struct iatt *postparent)
+{
+        rda_mark_modified_unref (this, op_ret, cookie);
+
+        STACK_UNWIND_STRICT (mknod, frame, op_ret, op_errno, inode, buf,
+                             preparent, postparent);
+        return 0;
+}
+
+
+int32_t
+rda_mknod (call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+           dev_t rdev, dict_t *params)
+{
+        STACK_WIND_COOKIE (frame, rda_mknod_cbk, rda_loc_parent (loc),
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->mknod, loc, mode, rdev,
+                           params);
+        return 0;
+}
+
+
+int32_t
+rda_mkdir_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, inode_t *inode,
+               struct iatt *buf, struct iatt *preparent,
+               struct iatt *postparent)
+{
+        rda_mark_modified_unref (this, op_ret, cookie);
+
+        STACK_UNWIND_STRICT (mkdir, frame, op_ret, op_errno, inode, buf,
+                             preparent, postparent);
+        return 0;
+}
+
+
+int32_t
+rda_mkdir (call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+           dict_t *params)
+{
+        STACK_WIND_COOKIE (frame, rda_mkdir_cbk, rda_loc_parent (loc),
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->mkdir, loc, mode, params);
+        return 0;
+}
+
+
+int32_t
+rda_symlink_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, inode_t *inode,
+                 struct iatt *buf, struct iatt *preparent,
+                 struct iatt *postparent)
+{
+        rda_mark_modified_unref (this, op_ret, cookie);
+
+        STACK_UNWIND_STRICT (symlink, frame, op_ret, op_errno, inode, buf,
+                             preparent, postparent);
+        return 0;
+}
+
+
+int32_t
+rda_symlink (call_frame_t *frame, xlator_t *this, const char *linkpath,
+             loc_t *loc, dict_t *params)
+{
+        STACK_WIND_COOKIE (frame, rda_symlink_cbk, rda_loc_parent (loc),
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->symlink, linkpath, loc,
+                           params);
+        return 0;
+}
+
+
+int32_t
+rda_link_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, inode_t *inode,
+              struct iatt *buf, struct iatt *preparent,
+              struct iatt *postparent)
+{
+        rda_mark_modified_unref (this, op_ret, cookie);
+
+        STACK_UNWIND_STRICT (link, frame, op_ret, op_errno, inode, buf,
+                             preparent, postparent);
+        return 0;
+}
+
+
+int32_t
+rda_link (call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc)
+{
+        STACK_WIND_COOKIE (frame, rda_link_cbk, rda_loc_parent (newloc),
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->link, oldloc, newloc);
+        return 0;
+}
+
+
+int32_t
+rda_unlink_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, struct iatt *preparent,
+                struct iatt *postparent)
+{
+        rda_mark_modified_unref (this, op_ret, cookie);
+
+        STACK_UNWIND_STRICT (unlink, frame, op_ret, op_errno, preparent,
+                             postparent);
+        return 0;
+}
+
+
+int32_t
+rda_unlink (call_frame_t *frame, xlator_t *this, loc_t *loc)
+{
+        STACK_WIND_COOKIE (frame, rda_unlink_cbk, rda_loc_parent (loc),
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->unlink, loc);
+        return 0;
+}
+
+
+int32_t
+rda_rmdir_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct iatt *preparent,
+               struct iatt *postparent)
+{
+        rda_mark_modified_unref (this, op_ret, cookie);
+
+        STACK_UNWIND_STRICT (rmdir, frame, op_ret, op_errno, preparent,
+                             postparent);
+        return 0;
+}
+
+
+int32_t
+rda_rmdir (call_frame_t *frame, xlator_t *this, loc_t *loc, int flags)
+{
+        STACK_WIND_COOKIE (frame, rda_rmdir_cbk, rda_loc_parent (loc),
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->rmdir, loc, flags);
+        return 0;
+}
+
+
+int32_t
+rda_rename_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, struct iatt *buf,
+                struct iatt *preoldparent, struct iatt *postoldparent,
+                struct iatt *prenewparent, struct iatt *postnewparent)
+{
+        rda_local_t *local = NULL;
+
+        local = frame->local;
+        frame->local = NULL;
+
+        rda_mark_modified_unref (this, op_ret, cookie);
+        if (local) {
+                rda_mark_modified_unref (this, op_ret, local->newparent);
+                GF_FREE (local);
+        }
+
+        STACK_UNWIND_STRICT (rename, frame, op_ret, op_errno, buf,
+                             preoldparent, postoldparent, prenewparent,
+                             postnewparent);
+        return 0;
+}
+
+
+int32_t
+rda_rename (call_frame_t *frame, xlator_t *this, loc_t *oldloc,
+            loc_t *newloc)
+{
+        rda_local_t *local = NULL;
+
+        /* the new parent, when it is another directory, in the local */
+        if (newloc->parent && (newloc->parent != oldloc->parent)) {
+                local = GF_CALLOC (1, sizeof (*local), gf_rda_mt_rda_local_t);
+                if (local) {
+                        local->newparent = inode_ref (newloc->parent);
+                        frame->local = local;
+                } else {
+                        /* at least the readdirps wound from now on */
+                        rda_mark_modified (this, newloc->parent);
+                }
+        }
+
+        STACK_WIND_COOKIE (frame, rda_rename_cbk, rda_loc_parent (oldloc),
+                           FIRST_CHILD (this),
+                           FIRST_CHILD (this)->fops->rename, oldloc, newloc);
+        return 0;
+}
+
+
+int32_t
+rda_releasedir (xlator_t *this, fd_t *fd)
+{
+        uint64_t      val = 0;
+        rda_fd_ctx_t *ctx = NULL;
+
+        if (fd_ctx_del (fd, this, &val) < 0)
+                return 0;
+
+        ctx = (rda_fd_ctx_t *)(long) val;
+        if (!ctx)
+                return 0;
+
+        gf_dirent_free (&ctx->entries);
+        LOCK_DESTROY (&ctx->lock);
+        GF_FREE (ctx);
+
+        return 0;
+}
+
+
+int
+notify (xlator_t *this, int32_t event, void *data, ...)
+{
+        struct gf_upcall *upcall = NULL;
+        inode_t          *parent = NULL;
+
+        /* entries another client added, removed or changed may be in
+           the prefetched buffers; its writes are let go as ours are */
+        if (event == GF_EVENT_UPCALL)
+                upcall = data;
+
+        if (upcall && upcall->inode) {
+                if (upcall->flags & GF_UPCALL_ENTRY)
+                        rda_mark_modified (this, upcall->inode);
+
+                if ((upcall->flags & GF_UPCALL_ATTR) &&
+                    !(upcall->flags & GF_UPCALL_DATA)) {
+                        parent = inode_parent (upcall->inode, NULL, NULL);
+                        rda_mark_modified_unref (this, 0, parent);
+                }
+        }
+
+        return default_notify (this, event, data);
+}
+
+
+int32_t
+rda_fdctx_dump (xlator_t *this, fd_t *fd)
+{
+        rda_fd_ctx_t *ctx   = NULL;
+        uint64_t      value = 0;
+        int32_t       ret   = 0;
+        char          key_prefix[GF_DUMP_MAX_BUF_LEN] = {0, };
+
+        ret = fd_ctx_get (fd, this, &value);
+        if (ret != 0)
+                goto out;
+
+        ctx = (rda_fd_ctx_t *)(long) value;
+        if (ctx == NULL)
+                goto out;
+
+        gf_proc_dump_build_key (key_prefix, "xlator.performance.readdir-ahead",
+                                "fdctx");
+        gf_proc_dump_add_section (key_prefix);
+
+        gf_proc_dump_write ("fd", "%p", fd);
+
+        LOCK (&ctx->lock);
+        {
+                gf_proc_dump_write ("state", "%s%s%s%s%s%s",
+                                    (ctx->state & RDA_FD_NEW) ? "new " : "",
+                                    (ctx->state & RDA_FD_RUNNING) ?
+                                    "running " : "",
+                                    (ctx->state & RDA_FD_EOD) ? "eod " : "",
+                                    (ctx->state & RDA_FD_ERROR) ?
+                                    "error " : "",
+                                    (ctx->state & RDA_FD_BYPASS) ?
+                                    "bypass " : "",
+                                    (ctx->state & RDA_FD_PLUGGED) ?
+                                    "plugged" : "");
+                gf_proc_dump_write ("cur_offset", "%"PRId64,
+                                    (int64_t) ctx->cur_offset);
+                gf_proc_dump_write ("next_offset", "%"PRId64,
+                                    (int64_t) ctx->next_offset);
+                gf_proc_dump_write ("cur_size", "%lu",
+                                    (unsigned long) ctx->cur_size);
+                gf_proc_dump_write ("reader_waiting", "%s",
+                                    ctx->wait_frame ? "yes" : "no");
+                gf_proc_dump_write ("generation", "%"PRIu64, ctx->gen);
+                gf_proc_dump_write ("hits", "%"PRIu64, ctx->hits);
+                gf_proc_dump_write ("waits", "%"PRIu64, ctx->waits);
+        }
+        UNLOCK (&ctx->lock);
+out:
+        return 0;
+}
+
+
+int
+rda_priv_dump (xlator_t *this)
+{
+        rda_priv_t *priv = NULL;
+        char        key_prefix[GF_DUMP_MAX_BUF_LEN];
+
+        if (!this)
+                return -1;
+
+        priv = this->private;
+        if (!priv)
+                return -1;
+
+        gf_proc_dump_build_key (key_prefix, "xlator.performance.readdir-ahead",
+                                "priv");
+        gf_proc_dump_add_section (key_prefix);
+
+        gf_proc_dump_write ("rda_request_size", "%"PRIu64,
+                            priv->rda_req_size);
+        gf_proc_dump_write ("rda_low_wmark", "%"PRIu64, priv->rda_low_wmark);
+        gf_proc_dump_write ("rda_high_wmark", "%"PRIu64,
+                            priv->rda_high_wmark);
+
+        LOCK (&priv->lock);
+        {
+                gf_proc_dump_write ("fds_bypassed", "%"PRIu64,
+                                    priv->bypassed);
+        }
+        UNLOCK (&priv->lock);
+
+        return 0;
+}
+
+
+int32_t
+mem_acct_init (xlator_t *this)
+{
+        int     ret = -1;
+
+        if (!this)
+                return ret;
+
+        ret = xlator_mem_acct_init (this, gf_rda_mt_end + 1);
+
+        if (ret != 0) {
+                gf_log (this->name, GF_LOG_ERROR, "Memory accounting init"
+                        "failed");
+                return ret;
+        }
+
+        return ret;
+}
+
+
+static int
+rda_check_wmarks (xlator_t *this, uint64_t low, uint64_t high)
+{
+        if (low > high) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "rda-low-wmark (%"PRIu64") must not be larger "
+                        "than rda-high-wmark (%"PRIu64")", low, high);
+                return -1;
+        }
+
+        return 0;
+}
+
+
+int
+reconfigure (xlator_t *this, dict_t *options)
+{
+        rda_priv_t *priv     = NULL;
+        uint64_t    req_size = 0;
+        uint64_t    low      = 0;
+        uint64_t    high     = 0;
+        int         ret      = -1;
+
+        GF_VALIDATE_OR_GOTO ("readdir-ahead", this, out);
+        GF_VALIDATE_OR_GOTO (this->name, this->private, out);
+        GF_VALIDATE_OR_GOTO (this->name, options, out);
+
+        priv = this->private;
+
+        GF_OPTION_RECONF ("rda-request-size", req_size, options, size, out);
+        GF_OPTION_RECONF ("rda-low-wmark", low, options, size, out);
+        GF_OPTION_RECONF ("rda-high-wmark", high, options, size, out);
+
+        if (rda_check_wmarks (this, low, high))
+                goto out;
+
+        priv->rda_req_size   = req_size;
+        priv->rda_low_wmark  = low;
+        priv->rda_high_wmark = high;
+
+        ret = 0;
+out:
+        return ret;
+}
+
+
+int32_t
+init (xlator_t *this)
+{
+        rda_priv_t *priv = NULL;
+        int32_t     ret  = -1;
+
+        GF_VALIDATE_OR_GOTO ("readdir-ahead", this, out);
+
+        if (!this->children || this->children->next) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "FATAL: readdir-ahead not configured with exactly one"
+                        " child");
+                goto out;
+        }
+
+        if (!this->parents) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "dangling volume. check volfile ");
+        }
+
+        priv = GF_CALLOC (1, sizeof (*priv), gf_rda_mt_rda_priv_t);
+        if (!priv)
+                goto out;
+
+        LOCK_INIT (&priv->lock);
+        this->private = priv;
+
+        GF_OPTION_INIT ("rda-request-size", priv->rda_req_size, size, err);
+        GF_OPTION_INIT ("rda-low-wmark", priv->rda_low_wmark, size, err);
+        GF_OPTION_INIT ("rda-high-wmark", priv->rda_high_wmark, size, err);
+
+        if (rda_check_wmarks (this, priv->rda_low_wmark,
+                              priv->rda_high_wmark))
+                goto err;
+
+        return 0;
+
+err:
+        LOCK_DESTROY (&priv->lock);
+        GF_FREE (priv);
+        this->private = NULL;
+out:
+        return ret;
+}
+
+
+void
+fini (xlator_t *this)
+{
+        rda_priv_t *priv = NULL;
+
+        GF_VALIDATE_OR_GOTO ("readdir-ahead", this, out);
+
+        priv = this->private;
+        if (!priv)
+                goto out;
+
+        this->private = NULL;
+        LOCK_DESTROY (&priv->lock);
+        GF_FREE (priv);
+out:
+        return;
+}
+
+
+struct xlator_fops fops = {
+        .opendir     = rda_opendir,
+        .readdir     = rda_readdir,
+        .readdirp    = rda_readdirp,
+        .setattr     = rda_setattr,
+        .fsetattr    = rda_fsetattr,
+        .create      = rda_create,
+        .mknod       = rda_mknod,
+        .mkdir       = rda_mkdir,
+        .symlink     = rda_symlink,
+        .link        = rda_link,
+        .unlink      = rda_unlink,
+        .rmdir       = rda_rmdir,
+        .rename      = rda_rename,
+};
+
+struct xlator_cbks cbks = {
+        .releasedir  = rda_releasedir,
+};
+
+struct xlator_dumpops dumpops = {
+        .priv        = rda_priv_dump,
+        .fdctx       = rda_fdctx_dump,
+};
+
+struct volume_options options[] = {
+        { .key = {"rda-request-size"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min = 4096,
+          .max = 131072,
+          .default_value = "131072",
+          .description = "size of the buffer requested from the child by "
+                         "each background readdirp.",
+        },
+        { .key = {"rda-low-wmark"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min = 0,
+          .max = 10 * GF_UNIT_MB,
+          .default_value = "65536",
+          .description = "a new background fill is started when the "
+                         "buffer of an fd drains below this.",
+        },
+        { .key = {"rda-high-wmark"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min = 0,
+          .max = 100 * GF_UNIT_MB,
+          .default_value = "131072",
+          .description = "background fills stop once the buffer of an fd "
+                         "holds this much.",
+        },
+        { .key = {NULL} },
+};
@@ -0,0 +1,91 @@
+/*
+  Copyright (c) 2008-2011 Gluster, Inc. <http://www.gluster.com>
+  This file is part of GlusterFS.
+
+  GlusterFS is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published
+  by the Free Software Foundation; either version 3 of the License,
+  or (at your option) any later version.
+
+  GlusterFS is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __READDIR_AHEAD_H
+#define __READDIR_AHEAD_H
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include "glusterfs.h"
+#include "logging.h"
+#include "dict.h"
+#include "xlator.h"
+#include "list.h"
+#include "call-stub.h"
+#include "defaults.h"
+#include "readdir-ahead-mem-types.h"
+
+/* fd context state flags */
+#define RDA_FD_NEW      (1 << 0)   /* no prefetch issued yet */
+#define RDA_FD_RUNNING  (1 << 1)   /* a fill readdirp is in flight */
+#define RDA_FD_EOD      (1 << 2)   /* end of directory reached */
+#define RDA_FD_ERROR    (1 << 3)   /* the last fill failed */
+#define RDA_FD_BYPASS   (1 << 4)   /* non-sequential access, pass through */
+#define RDA_FD_PLUGGED  (1 << 5)   /* fill stopped at the high watermark */
+
+struct rda_fd_ctx {
+        off_t             cur_offset;   /* offset the next reader asks for */
+        size_t            cur_size;     /* bytes of dirents buffered */
+        off_t             next_offset;  /* offset of the next fill */
+        uint32_t          state;
+        uint64_t          gen;          /* generation of the directory
+                                           when the oldest entry held in
+                                           the buffer was fetched */
+        uint64_t          seq;          /* bumped when the buffer is
+                                           dropped, so that a fill still
+                                           in flight is discarded */
+        gf_dirent_t       entries;
+        call_frame_t     *fill_frame;
+
+        /* reader waiting for a fill to complete */
+        call_frame_t     *wait_frame;
+        size_t            wait_size;
+        gf_boolean_t      wait_plus;
+        uint64_t          wait_gen;
+
+        int               op_errno;
+        uint64_t          hits;
+        uint64_t          waits;
+        gf_lock_t         lock;
+};
+typedef struct rda_fd_ctx rda_fd_ctx_t;
+
+struct rda_local {
+        fd_t             *fd;
+        off_t             offset;
+        uint64_t          gen;
+        uint64_t          seq;
+        inode_t          *newparent;    /* of a rename */
+};
+typedef struct rda_local rda_local_t;
+
+struct rda_priv {
+        uint64_t          rda_req_size;
+        uint64_t          rda_low_wmark;
+        uint64_t          rda_high_wmark;
+
+        uint64_t          bypassed;
+        gf_lock_t         lock;
+};
+typedef struct rda_priv rda_priv_t;
+
+#endif /* __READDIR_AHEAD_H */
@@ -18,6 +18,7 @@
 */
 
 #include "stat-prefetch.h"
+#include "defaults.h"
 #include "statedump.h"
 #include "fd.h"
 
@@ -2352,6 +2353,183 @@ unwind:
         return 0;
 }
 
+int32_t
+sp_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              int32_t keep_size, off_t offset, size_t len)
+{
+        sp_fd_ctx_t *fd_ctx = NULL;
+        uint64_t     value  = 0;
+        int32_t      ret    = 0, op_errno = EINVAL;
+        inode_t     *parent = NULL;
+        char        *name   = NULL;
+
+        GF_ASSERT (frame);
+        GF_VALIDATE_OR_GOTO (frame->this ? frame->this->name : "stat-prefetch",
+                             this, unwind);
+        GF_VALIDATE_OR_GOTO (this->name, fd, unwind);
+
+        ret = fd_ctx_get (fd, this, &value);
+        if (ret == -1) {
+                gf_log (this->name, GF_LOG_WARNING, "stat-prefetch context not "
+                        "set in fd (%p) opened on inode (gfid:%s)", fd,
+                        uuid_utoa (fd->inode->gfid));
+                goto unwind;
+        }
+
+        fd_ctx = (void *)(long)value;
+        name   = fd_ctx->name;
+        parent = fd_ctx->parent_inode;
+
+        sp_remove_caches_from_all_fds_opened (this, parent, (char *)name);
+
+        STACK_WIND (frame, sp_truncate_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->fallocate, fd, keep_size, offset,
+                    len);
+        return 0;
+
+unwind:
+        SP_STACK_UNWIND (fallocate, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+sp_discard (call_frame_t *frame, xlator_t *this, fd_t *fd,
+            off_t offset, size_t len)
+{
+        sp_fd_ctx_t *fd_ctx = NULL;
+        uint64_t     value  = 0;
+        int32_t      ret    = 0, op_errno = EINVAL;
+        inode_t     *parent = NULL;
+        char        *name   = NULL;
+
+        GF_ASSERT (frame);
+        GF_VALIDATE_OR_GOTO (frame->this ? frame->this->name : "stat-prefetch",
+                             this, unwind);
+        GF_VALIDATE_OR_GOTO (this->name, fd, unwind);
+
+        ret = fd_ctx_get (fd, this, &value);
+        if (ret == -1) {
+                gf_log (this->name, GF_LOG_WARNING, "stat-prefetch context not "
+                        "set in fd (%p) opened on inode (gfid:%s)", fd,
+                        uuid_utoa (fd->inode->gfid));
+                goto unwind;
+        }
+
+        fd_ctx = (void *)(long)value;
+        name   = fd_ctx->name;
+        parent = fd_ctx->parent_inode;
+
+        sp_remove_caches_from_all_fds_opened (this, parent, (char *)name);
+
+        STACK_WIND (frame, sp_truncate_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->discard, fd, offset, len);
+        return 0;
+
+unwind:
+        SP_STACK_UNWIND (discard, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+sp_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd,
+             off_t offset, size_t len)
+{
+        sp_fd_ctx_t *fd_ctx = NULL;
+        uint64_t     value  = 0;
+        int32_t      ret    = 0, op_errno = EINVAL;
+        inode_t     *parent = NULL;
+        char        *name   = NULL;
+
+        GF_ASSERT (frame);
+        GF_VALIDATE_OR_GOTO (frame->this ? frame->this->name : "stat-prefetch",
+                             this, unwind);
+        GF_VALIDATE_OR_GOTO (this->name, fd, unwind);
+
+        ret = fd_ctx_get (fd, this, &value);
+        if (ret == -1) {
+                gf_log (this->name, GF_LOG_WARNING, "stat-prefetch context not "
+                        "set in fd (%p) opened on inode (gfid:%s)", fd,
+                        uuid_utoa (fd->inode->gfid));
+                goto unwind;
+        }
+
+        fd_ctx = (void *)(long)value;
+        name   = fd_ctx->name;
+        parent = fd_ctx->parent_inode;
+
+        sp_remove_caches_from_all_fds_opened (this, parent, (char *)name);
+
+        STACK_WIND (frame, sp_truncate_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->zerofill, fd, offset, len);
+        return 0;
+
+unwind:
+        SP_STACK_UNWIND (zerofill, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+sp_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                        int32_t op_ret, int32_t op_errno,
+                        struct iatt *stbuf_in, struct iatt *prebuf,
+                        struct iatt *postbuf)
+{
+        GF_ASSERT (frame);
+
+        SP_STACK_UNWIND (copy_file_range, frame, op_ret, op_errno, stbuf_in,
+                         prebuf, postbuf);
+        return 0;
+}
+
+
+/* the copy reads one file, as a readv, and writes the other */
+int32_t
+sp_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                    uint32_t flags)
+{
+        sp_fd_ctx_t *fd_ctx = NULL;
+        uint64_t     value  = 0;
+        int32_t      ret    = 0, op_errno = EINVAL;
+        fd_t        *fds[2] = {fd_in, fd_out};
+        int          i      = 0;
+
+        GF_ASSERT (frame);
+        GF_VALIDATE_OR_GOTO (frame->this ? frame->this->name : "stat-prefetch",
+                             this, unwind);
+        GF_VALIDATE_OR_GOTO (this->name, fd_in, unwind);
+        GF_VALIDATE_OR_GOTO (this->name, fd_out, unwind);
+
+        for (i = 0; i < 2; i++) {
+                ret = fd_ctx_get (fds[i], this, &value);
+                if (ret == -1) {
+                        gf_log (this->name, GF_LOG_WARNING, "stat-prefetch "
+                                "context not set in fd (%p) opened on inode "
+                                "(gfid:%s)", fds[i],
+                                uuid_utoa (fds[i]->inode->gfid));
+                        goto unwind;
+                }
+
+                fd_ctx = (void *)(long)value;
+                sp_remove_caches_from_all_fds_opened (this,
+                                                      fd_ctx->parent_inode,
+                                                      fd_ctx->name);
+        }
+
+        STACK_WIND (frame, sp_copy_file_range_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags);
+        return 0;
+
+unwind:
+        SP_STACK_UNWIND (copy_file_range, frame, -1, op_errno, NULL, NULL,
+                         NULL);
+        return 0;
+}
+
 
 int32_t
 sp_setattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
@@ -3930,6 +4108,87 @@ out:
 }
 
 
+/* another client changed @inode: drop the entries describing it from the
+ * caches of its parent directories. If it is a directory whose entries
+ * changed, drop everything cached for it as well.
+ */
+static void
+sp_upcall_invalidate (xlator_t *this, inode_t *inode, uint32_t flags)
+{
+        dentry_t *dentry = NULL;
+        inode_t  *parent = NULL;
+        struct dentry_wrapper {
+                uuid_t            pargfid;
+                char             *name;
+                struct list_head  list;
+        };
+
+        struct dentry_wrapper *wrapper = NULL, *tmp = NULL;
+        struct list_head       head    = {0, };
+
+        INIT_LIST_HEAD (&head);
+
+        if ((flags & GF_UPCALL_ENTRY) && IA_ISDIR (inode->ia_type))
+                sp_remove_caches_from_all_fds_opened (this, inode, NULL);
+
+        if (!(flags & (GF_UPCALL_ATTR | GF_UPCALL_DATA | GF_UPCALL_NAMES)))
+                return;
+
+        pthread_mutex_lock (&inode->table->lock);
+        {
+                list_for_each_entry (dentry, &inode->dentry_list,
+                                     inode_list) {
+                        if (!dentry->parent || !dentry->name)
+                                continue;
+
+                        wrapper = GF_CALLOC (1, sizeof (*wrapper),
+                                             gf_sp_mt_dentry_wrapper_t);
+                        if (wrapper == NULL)
+                                break;
+
+                        wrapper->name = gf_strdup (dentry->name);
+                        if (wrapper->name == NULL) {
+                                GF_FREE (wrapper);
+                                break;
+                        }
+
+                        uuid_copy (wrapper->pargfid, dentry->parent->gfid);
+                        list_add_tail (&wrapper->list, &head);
+                }
+        }
+        pthread_mutex_unlock (&inode->table->lock);
+
+        list_for_each_entry_safe (wrapper, tmp, &head, list) {
+                parent = inode_find (inode->table, wrapper->pargfid);
+                if (parent) {
+                        sp_remove_caches_from_all_fds_opened (this, parent,
+                                                              wrapper->name);
+                        inode_unref (parent);
+                }
+
+                list_del (&wrapper->list);
+                GF_FREE (wrapper->name);
+                GF_FREE (wrapper);
+        }
+}
+
+
+int
+notify (xlator_t *this, int32_t event, void *data, ...)
+{
+        struct gf_upcall *upcall = NULL;
+
+        if (event == GF_EVENT_UPCALL) {
+                upcall = data;
+                if (upcall->inode)
+                        sp_upcall_invalidate (this, upcall->inode,
+                                              upcall->flags);
+        }
+
+        return default_notify (this, event, data);
+}
+
+
 int32_t
 sp_release (xlator_t *this, fd_t *fd)
 {
@@ -4225,6 +4484,10 @@ struct xlator_fops fops = {
         .link        = sp_link,
         .truncate    = sp_truncate,
         .ftruncate   = sp_ftruncate,
+        .fallocate   = sp_fallocate,
+        .discard     = sp_discard,
+        .zerofill    = sp_zerofill,
+        .copy_file_range = sp_copy_file_range,
         .readlink    = sp_readlink,
         .unlink      = sp_unlink,
         .rmdir       = sp_rmdir,
@@ -1179,6 +1179,594 @@ unwind:
 }
 
 
+int32_t
+wb_fallocate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                  struct iatt *postbuf)
+{
+        wb_local_t   *local   = NULL;
+        wb_request_t *request = NULL;
+        wb_file_t    *file    = NULL;
+        int32_t       ret     = -1;
+
+        GF_ASSERT (frame);
+
+        local = frame->local;
+        file = local->file;
+        request = local->request;
+
+        if ((request != NULL) && (file != NULL)) {
+                wb_request_unref (request);
+                ret = wb_process_queue (frame, file);
+                if (ret == -1) {
+                        if (errno == ENOMEM) {
+                                op_ret = -1;
+                                op_errno = ENOMEM;
+                        }
+
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "request queue processing failed");
+                }
+        }
+
+        STACK_UNWIND_STRICT (fallocate, frame, op_ret, op_errno, prebuf,
+                             postbuf);
+
+        return 0;
+}
+
+
+static int32_t
+wb_fallocate_helper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                     int32_t keep_size, off_t offset, size_t len)
+{
+        GF_ASSERT (frame);
+        GF_ASSERT (this);
+
+        STACK_WIND (frame, wb_fallocate_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->fallocate, fd, keep_size, offset,
+                    len);
+        return 0;
+}
+
+
+int32_t
+wb_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+              int32_t keep_size, off_t offset, size_t len)
+{
+        wb_file_t    *file     = NULL;
+        wb_local_t   *local    = NULL;
+        uint64_t      tmp_file = 0;
+        call_stub_t  *stub     = NULL;
+        wb_request_t *request  = NULL;
+        int32_t       ret      = -1;
+        int           op_errno = EINVAL;
+
+        GF_ASSERT (frame);
+        GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd, unwind);
+
+
+        if ((!IA_ISDIR (fd->inode->ia_type))
+            && fd_ctx_get (fd, this, &tmp_file)) {
+                file = wb_file_create (this, fd, 0);
+        } else {
+                file = (wb_file_t *)(long)tmp_file;
+                if ((!IA_ISDIR (fd->inode->ia_type)) && (file == NULL)) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "wb_file not found for fd %p", fd);
+                        op_errno = EBADFD;
+                        goto unwind;
+                }
+        }
+
+        local = GF_CALLOC (1, sizeof (*local), gf_wb_mt_wb_local_t);
+        if (local == NULL) {
+                op_errno = ENOMEM;
+                goto unwind;
+        }
+
+        local->file = file;
+
+        frame->local = local;
+
+        if (file) {
+                stub = fop_fallocate_stub (frame, wb_fallocate_helper, fd,
+                                           keep_size, offset, len);
+                if (stub == NULL) {
+                        op_errno = ENOMEM;
+                        goto unwind;
+                }
+
+                request = wb_enqueue (file, stub);
+                if (request == NULL) {
+                        op_errno = ENOMEM;
+                        goto unwind;
+                }
+
+                ret = wb_process_queue (frame, file);
+                if (ret == -1) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "request queue processing failed");
+                }
+        } else {
+                STACK_WIND (frame, wb_fallocate_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->fallocate, fd,
+                            keep_size, offset, len);
+        }
+
+        return 0;
+
+unwind:
+        STACK_UNWIND_STRICT (fallocate, frame, -1, op_errno, NULL, NULL);
+
+        if (stub) {
+                call_stub_destroy (stub);
+        }
+
+        return 0;
+}
+
+
+int32_t
+wb_discard_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                struct iatt *postbuf)
+{
+        wb_local_t   *local   = NULL;
+        wb_request_t *request = NULL;
+        wb_file_t    *file    = NULL;
+        int32_t       ret     = -1;
+
+        GF_ASSERT (frame);
+
+        local = frame->local;
+        file = local->file;
+        request = local->request;
+
+        if ((request != NULL) && (file != NULL)) {
+                wb_request_unref (request);
+                ret = wb_process_queue (frame, file);
+                if (ret == -1) {
+                        if (errno == ENOMEM) {
+                                op_ret = -1;
+                                op_errno = ENOMEM;
+                        }
+
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "request queue processing failed");
+                }
+        }
+
+        STACK_UNWIND_STRICT (discard, frame, op_ret, op_errno, prebuf,
+                             postbuf);
+
+        return 0;
+}
+
+
+static int32_t
+wb_discard_helper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                   off_t offset, size_t len)
+{
+        GF_ASSERT (frame);
+        GF_ASSERT (this);
+
+        STACK_WIND (frame, wb_discard_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->discard, fd, offset, len);
+        return 0;
+}
+
+
+int32_t
+wb_discard (call_frame_t *frame, xlator_t *this, fd_t *fd,
+            off_t offset, size_t len)
+{
+        wb_file_t    *file     = NULL;
+        wb_local_t   *local    = NULL;
+        uint64_t      tmp_file = 0;
+        call_stub_t  *stub     = NULL;
+        wb_request_t *request  = NULL;
+        int32_t       ret      = -1;
+        int           op_errno = EINVAL;
+
+        GF_ASSERT (frame);
+        GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd, unwind);
+
+
+        if ((!IA_ISDIR (fd->inode->ia_type))
+            && fd_ctx_get (fd, this, &tmp_file)) {
+                file = wb_file_create (this, fd, 0);
+        } else {
+                file = (wb_file_t *)(long)tmp_file;
+                if ((!IA_ISDIR (fd->inode->ia_type)) && (file == NULL)) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "wb_file not found for fd %p", fd);
+                        op_errno = EBADFD;
+                        goto unwind;
+                }
+        }
+
+        local = GF_CALLOC (1, sizeof (*local), gf_wb_mt_wb_local_t);
+        if (local == NULL) {
+                op_errno = ENOMEM;
+                goto unwind;
+        }
+
+        local->file = file;
+
+        frame->local = local;
+
+        if (file) {
+                stub = fop_discard_stub (frame, wb_discard_helper, fd,
+                                         offset, len);
+                if (stub == NULL) {
+                        op_errno = ENOMEM;
+                        goto unwind;
+                }
+
+                request = wb_enqueue (file, stub);
+                if (request == NULL) {
+                        op_errno = ENOMEM;
+                        goto unwind;
+                }
+
+                ret = wb_process_queue (frame, file);
+                if (ret == -1) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "request queue processing failed");
+                }
+        } else {
+                STACK_WIND (frame, wb_discard_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->discard, fd, offset, len);
+        }
+
+        return 0;
+
+unwind:
+        STACK_UNWIND_STRICT (discard, frame, -1, op_errno, NULL, NULL);
+
+        if (stub) {
+                call_stub_destroy (stub);
+        }
+
+        return 0;
+}
+
+
+int32_t
+wb_zerofill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                 struct iatt *postbuf)
+{
+        wb_local_t   *local   = NULL;
+        wb_request_t *request = NULL;
+        wb_file_t    *file    = NULL;
+        int32_t       ret     = -1;
+
+        GF_ASSERT (frame);
+
+        local = frame->local;
+        file = local->file;
+        request = local->request;
+
+        if ((request != NULL) && (file != NULL)) {
+                wb_request_unref (request);
+                ret = wb_process_queue (frame, file);
+                if (ret == -1) {
+                        if (errno == ENOMEM) {
+                                op_ret = -1;
+                                op_errno = ENOMEM;
+                        }
+
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "request queue processing failed");
+                }
+        }
+
+        STACK_UNWIND_STRICT (zerofill, frame, op_ret, op_errno, prebuf,
+                             postbuf);
+
+        return 0;
+}
+
+
+static int32_t
+wb_zerofill_helper (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                    off_t offset, size_t len)
+{
+        GF_ASSERT (frame);
+        GF_ASSERT (this);
+
+        STACK_WIND (frame, wb_zerofill_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->zerofill, fd, offset, len);
+        return 0;
+}
+
+
+int32_t
+wb_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd,
+             off_t offset, size_t len)
+{
+        wb_file_t    *file     = NULL;
+        wb_local_t   *local    = NULL;
+        uint64_t      tmp_file = 0;
+        call_stub_t  *stub     = NULL;
+        wb_request_t *request  = NULL;
+        int32_t       ret      = -1;
+        int           op_errno = EINVAL;
+
+        GF_ASSERT (frame);
+        GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd, unwind);
+
+
+        if ((!IA_ISDIR (fd->inode->ia_type))
+            && fd_ctx_get (fd, this, &tmp_file)) {
+                file = wb_file_create (this, fd, 0);
+        } else {
+                file = (wb_file_t *)(long)tmp_file;
+                if ((!IA_ISDIR (fd->inode->ia_type)) && (file == NULL)) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "wb_file not found for fd %p", fd);
+                        op_errno = EBADFD;
+                        goto unwind;
+                }
+        }
+
+        local = GF_CALLOC (1, sizeof (*local), gf_wb_mt_wb_local_t);
+        if (local == NULL) {
+                op_errno = ENOMEM;
+                goto unwind;
+        }
+
+        local->file = file;
+
+        frame->local = local;
+
+        if (file) {
+                stub = fop_zerofill_stub (frame, wb_zerofill_helper, fd,
+                                          offset, len);
+                if (stub == NULL) {
+                        op_errno = ENOMEM;
+                        goto unwind;
+                }
+
+                request = wb_enqueue (file, stub);
+                if (request == NULL) {
+                        op_errno = ENOMEM;
+                        goto unwind;
+                }
+
+                ret = wb_process_queue (frame, file);
+                if (ret == -1) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "request queue processing failed");
+                }
+        } else {
+                STACK_WIND (frame, wb_zerofill_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->zerofill, fd, offset, len);
+        }
+
+        return 0;
+
+unwind:
+        STACK_UNWIND_STRICT (zerofill, frame, -1, op_errno, NULL, NULL);
+
+        if (stub) {
+                call_stub_destroy (stub);
+        }
+
+        return 0;
+}
+
+
+int32_t
+wb_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                        int32_t op_ret, int32_t op_errno,
+                        struct iatt *stbuf_in, struct iatt *prebuf,
+                        struct iatt *postbuf)
+{
+        wb_local_t   *local   = NULL;
+        wb_request_t *request = NULL;
+        wb_file_t    *file    = NULL;
+        int32_t       ret     = -1;
+
+        GF_ASSERT (frame);
+
+        local = frame->local;
+        file = local->file;
+        request = local->request;
+
+        if ((request != NULL) && (file != NULL)) {
+                wb_request_unref (request);
+                ret = wb_process_queue (frame, file);
+                if (ret == -1) {
+                        if (errno == ENOMEM) {
+                                op_ret = -1;
+                                op_errno = ENOMEM;
+                        }
+
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "request queue processing failed");
+                }
+        }
+
+        STACK_UNWIND_STRICT (copy_file_range, frame, op_ret, op_errno,
+                             stbuf_in, prebuf, postbuf);
+
+        return 0;
+}
+
+
+static int32_t
+wb_copy_file_range_helper (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                           off_t off_in, fd_t *fd_out, off_t off_out,
+                           size_t len, uint32_t flags)
+{
+        GF_ASSERT (frame);
+        GF_ASSERT (this);
+
+        STACK_WIND (frame, wb_copy_file_range_cbk, FIRST_CHILD(this),
+                    FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                    fd_out, off_out, len, flags);
+        return 0;
+}
+
+
+/* the copy is ordered behind the writes cached for the destination, as
+   any other write to it */
+static int32_t
+wb_copy_file_range_ordered (call_frame_t *frame, xlator_t *this,
+                            fd_t *fd_in, off_t off_in, fd_t *fd_out,
+                            off_t off_out, size_t len, uint32_t flags)
+{
+        wb_file_t    *file     = NULL;
+        wb_local_t   *local    = NULL;
+        uint64_t      tmp_file = 0;
+        call_stub_t  *stub     = NULL;
+        wb_request_t *request  = NULL;
+        int32_t       ret      = -1;
+        int           op_errno = EINVAL;
+
+        if (fd_ctx_get (fd_out, this, &tmp_file)) {
+                file = wb_file_create (this, fd_out, 0);
+        } else {
+                file = (wb_file_t *)(long)tmp_file;
+                if (file == NULL) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "wb_file not found for fd %p", fd_out);
+                        op_errno = EBADFD;
+                        goto unwind;
+                }
+        }
+
+        local = GF_CALLOC (1, sizeof (*local), gf_wb_mt_wb_local_t);
+        if (local == NULL) {
+                op_errno = ENOMEM;
+                goto unwind;
+        }
+
+        local->file = file;
+
+        frame->local = local;
+
+        if (file) {
+                stub = fop_copy_file_range_stub (frame,
+                                                 wb_copy_file_range_helper,
+                                                 fd_in, off_in, fd_out,
+                                                 off_out, len, flags);
+                if (stub == NULL) {
+                        op_errno = ENOMEM;
+                        goto unwind;
+                }
+
+                request = wb_enqueue (file, stub);
+                if (request == NULL) {
+                        op_errno = ENOMEM;
+                        goto unwind;
+                }
+
+                ret = wb_process_queue (frame, file);
+                if (ret == -1) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "request queue processing failed");
+                }
+        } else {
+                STACK_WIND (frame, wb_copy_file_range_cbk, FIRST_CHILD(this),
+                            FIRST_CHILD(this)->fops->copy_file_range, fd_in,
+                            off_in, fd_out, off_out, len, flags);
+        }
+
+        return 0;
+
+unwind:
+        STACK_UNWIND_STRICT (copy_file_range, frame, -1, op_errno, NULL, NULL,
+                             NULL);
+
+        if (stub) {
+                call_stub_destroy (stub);
+        }
+
+        return 0;
+}
+
+
+static int32_t
+wb_copy_file_range_sync_cbk (call_frame_t *frame, void *cookie,
+                             xlator_t *this, int32_t op_ret, int32_t op_errno,
+                             struct iatt *buf)
+{
+        call_stub_t *stub = NULL;
+
+        stub = cookie;
+
+        if (op_ret == -1) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "writes cached for the source of the copy failed "
+                        "(%s)", strerror (op_errno));
+                STACK_UNWIND_STRICT (copy_file_range, frame, -1, op_errno,
+                                     NULL, NULL, NULL);
+                call_stub_destroy (stub);
+                return 0;
+        }
+
+        call_resume (stub);
+
+        return 0;
+}
+
+
+/* the writes cached for the source have to reach it before it is read:
+   an fstat of it, which waits for them like a read, is done first */
+int32_t
+wb_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                    uint32_t flags)
+{
+        uint64_t      tmp_file = 0;
+        call_stub_t  *stub     = NULL;
+        int           op_errno = EINVAL;
+
+        GF_ASSERT (frame);
+        GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd_in, unwind);
+        GF_VALIDATE_OR_GOTO (frame->this->name, fd_out, unwind);
+
+        if (IA_ISDIR (fd_in->inode->ia_type) ||
+            IA_ISDIR (fd_out->inode->ia_type)) {
+                op_errno = EISDIR;
+                goto unwind;
+        }
+
+        if ((fd_in == fd_out) || fd_ctx_get (fd_in, this, &tmp_file)
+            || !tmp_file) {
+                wb_copy_file_range_ordered (frame, this, fd_in, off_in,
+                                            fd_out, off_out, len, flags);
+                return 0;
+        }
+
+        stub = fop_copy_file_range_stub (frame, wb_copy_file_range_ordered,
+                                         fd_in, off_in, fd_out, off_out, len,
+                                         flags);
+        if (stub == NULL) {
+                op_errno = ENOMEM;
+                goto unwind;
+        }
+
+        STACK_WIND_COOKIE (frame, wb_copy_file_range_sync_cbk, stub, this,
+                           this->fops->fstat, fd_in);
+
+        return 0;
+
+unwind:
+        STACK_UNWIND_STRICT (copy_file_range, frame, -1, op_errno, NULL, NULL,
+                             NULL);
+        return 0;
+}
+
+
 int32_t
 wb_setattr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                 int32_t op_ret, int32_t op_errno, struct iatt *statpre,
@@ -2973,6 +3561,10 @@ struct xlator_fops fops = {
         .fstat       = wb_fstat,
         .truncate    = wb_truncate,
         .ftruncate   = wb_ftruncate,
+        .fallocate   = wb_fallocate,
+        .discard     = wb_discard,
+        .zerofill    = wb_zerofill,
+        .copy_file_range = wb_copy_file_range,
         .setattr     = wb_setattr,
 };
 
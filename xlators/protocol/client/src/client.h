@@ -135,6 +135,7 @@ typedef struct client_local {
 typedef struct client_args {
         loc_t              *loc;
         fd_t               *fd;
+        fd_t               *fd_out;
         dict_t             *xattr_req;
         const char         *linkname;
         struct iobref      *iobref;
@@ -149,6 +150,7 @@ typedef struct client_args {
         const char         *volume;
         const char         *basename;
         off_t               offset;
+        off_t               offset_out;
         int32_t             mask;
         int32_t             cmd;
         size_t              size;
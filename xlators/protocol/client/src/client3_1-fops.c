@@ -31,6 +31,17 @@ int32_t client3_getspec (call_frame_t *frame, xlator_t *this, void *data);
 void client_start_ping (void *data);
 rpc_clnt_prog_t clnt3_1_fop_prog;
 
+/* errno of a failed rpc for the procedures servers may not have yet:
+   one older than the procedure answers PROC_UNAVAIL */
+static int
+client_new_proc_errno (struct rpc_req *req)
+{
+        if (req->accept_status == PROC_UNAVAIL)
+                return EOPNOTSUPP;
+
+        return ENOTCONN;
+}
+
 int
 client_submit_vec_request (xlator_t  *this, void *req, call_frame_t  *frame,
                            rpc_clnt_prog_t *prog, int procnum, fop_cbk_fn_t cbk,
@@ -1159,6 +1170,190 @@ out:
         return 0;
 }
 
+int
+client3_1_fallocate_cbk (struct rpc_req *req, struct iovec *iov, int count,
+                         void *myframe)
+{
+        gfs3_fallocate_rsp rsp      = {0,};
+        call_frame_t  *frame    = NULL;
+        struct iatt    prestat  = {0,};
+        struct iatt    poststat = {0,};
+        int            ret      = 0;
+        xlator_t      *this     = NULL;
+
+        this = THIS;
+
+        frame = myframe;
+
+        if (-1 == req->rpc_status) {
+                rsp.op_ret   = -1;
+                rsp.op_errno = client_new_proc_errno (req);
+                goto out;
+        }
+        ret = xdr_to_generic (*iov, &rsp, (xdrproc_t)xdr_gfs3_fallocate_rsp);
+        if (ret < 0) {
+                gf_log (this->name, GF_LOG_ERROR, "XDR decoding failed");
+                rsp.op_ret   = -1;
+                rsp.op_errno = EINVAL;
+                goto out;
+        }
+
+        if (-1 != rsp.op_ret) {
+                gf_stat_to_iatt (&rsp.statpre, &prestat);
+                gf_stat_to_iatt (&rsp.statpost, &poststat);
+        }
+
+out:
+        if (rsp.op_ret == -1) {
+                gf_log (this->name, GF_LOG_WARNING, "remote operation failed: %s",
+                        strerror (gf_error_to_errno (rsp.op_errno)));
+        }
+        STACK_UNWIND_STRICT (fallocate, frame, rsp.op_ret,
+                             gf_error_to_errno (rsp.op_errno), &prestat,
+                             &poststat);
+
+        return 0;
+}
+
+int
+client3_1_discard_cbk (struct rpc_req *req, struct iovec *iov, int count,
+                       void *myframe)
+{
+        gfs3_discard_rsp rsp      = {0,};
+        call_frame_t  *frame    = NULL;
+        struct iatt    prestat  = {0,};
+        struct iatt    poststat = {0,};
+        int            ret      = 0;
+        xlator_t      *this     = NULL;
+
+        this = THIS;
+
+        frame = myframe;
+
+        if (-1 == req->rpc_status) {
+                rsp.op_ret   = -1;
+                rsp.op_errno = client_new_proc_errno (req);
+                goto out;
+        }
+        ret = xdr_to_generic (*iov, &rsp, (xdrproc_t)xdr_gfs3_discard_rsp);
+        if (ret < 0) {
+                gf_log (this->name, GF_LOG_ERROR, "XDR decoding failed");
+                rsp.op_ret   = -1;
+                rsp.op_errno = EINVAL;
+                goto out;
+        }
+
+        if (-1 != rsp.op_ret) {
+                gf_stat_to_iatt (&rsp.statpre, &prestat);
+                gf_stat_to_iatt (&rsp.statpost, &poststat);
+        }
+
+out:
+        if (rsp.op_ret == -1) {
+                gf_log (this->name, GF_LOG_WARNING, "remote operation failed: %s",
+                        strerror (gf_error_to_errno (rsp.op_errno)));
+        }
+        STACK_UNWIND_STRICT (discard, frame, rsp.op_ret,
+                             gf_error_to_errno (rsp.op_errno), &prestat,
+                             &poststat);
+
+        return 0;
+}
+
+int
+client3_1_zerofill_cbk (struct rpc_req *req, struct iovec *iov, int count,
+                        void *myframe)
+{
+        gfs3_zerofill_rsp rsp      = {0,};
+        call_frame_t  *frame    = NULL;
+        struct iatt    prestat  = {0,};
+        struct iatt    poststat = {0,};
+        int            ret      = 0;
+        xlator_t      *this     = NULL;
+
+        this = THIS;
+
+        frame = myframe;
+
+        if (-1 == req->rpc_status) {
+                rsp.op_ret   = -1;
+                rsp.op_errno = client_new_proc_errno (req);
+                goto out;
+        }
+        ret = xdr_to_generic (*iov, &rsp, (xdrproc_t)xdr_gfs3_zerofill_rsp);
+        if (ret < 0) {
+                gf_log (this->name, GF_LOG_ERROR, "XDR decoding failed");
+                rsp.op_ret   = -1;
+                rsp.op_errno = EINVAL;
+                goto out;
+        }
+
+        if (-1 != rsp.op_ret) {
+                gf_stat_to_iatt (&rsp.statpre, &prestat);
+                gf_stat_to_iatt (&rsp.statpost, &poststat);
+        }
+
+out:
+        if (rsp.op_ret == -1) {
+                gf_log (this->name, GF_LOG_WARNING, "remote operation failed: %s",
+                        strerror (gf_error_to_errno (rsp.op_errno)));
+        }
+        STACK_UNWIND_STRICT (zerofill, frame, rsp.op_ret,
+                             gf_error_to_errno (rsp.op_errno), &prestat,
+                             &poststat);
+
+        return 0;
+}
+
+int
+client3_1_copy_file_range_cbk (struct rpc_req *req, struct iovec *iov,
+                               int count, void *myframe)
+{
+        gfs3_copy_file_range_rsp rsp = {0,};
+        call_frame_t  *frame    = NULL;
+        struct iatt    stat     = {0,};
+        struct iatt    prestat  = {0,};
+        struct iatt    poststat = {0,};
+        int            ret      = 0;
+        xlator_t      *this     = NULL;
+
+        this = THIS;
+
+        frame = myframe;
+
+        if (-1 == req->rpc_status) {
+                rsp.op_ret   = -1;
+                rsp.op_errno = client_new_proc_errno (req);
+                goto out;
+        }
+        ret = xdr_to_generic (*iov, &rsp,
+                              (xdrproc_t)xdr_gfs3_copy_file_range_rsp);
+        if (ret < 0) {
+                gf_log (this->name, GF_LOG_ERROR, "XDR decoding failed");
+                rsp.op_ret   = -1;
+                rsp.op_errno = EINVAL;
+                goto out;
+        }
+
+        if (-1 != rsp.op_ret) {
+                gf_stat_to_iatt (&rsp.stat, &stat);
+                gf_stat_to_iatt (&rsp.statpre, &prestat);
+                gf_stat_to_iatt (&rsp.statpost, &poststat);
+        }
+
+out:
+        /* EXDEV is how the layers above learn to copy it themselves */
+        if ((rsp.op_ret == -1) && (rsp.op_errno != EXDEV)) {
+                gf_log (this->name, GF_LOG_WARNING, "remote operation failed: %s",
+                        strerror (gf_error_to_errno (rsp.op_errno)));
+        }
+        STACK_UNWIND_STRICT (copy_file_range, frame, rsp.op_ret,
+                             gf_error_to_errno (rsp.op_errno), &stat,
+                             &prestat, &poststat);
+
+        return 0;
+}
+
 int
 client3_1_fstat_cbk (struct rpc_req *req, struct iovec *iov, int count,
                      void *myframe)
@@ -2789,6 +2984,182 @@ unwind:
 }
 
 
+int32_t
+client3_1_fallocate (call_frame_t *frame, xlator_t *this,
+                     void *data)
+{
+        clnt_args_t       *args      = NULL;
+        int64_t            remote_fd = -1;
+        clnt_conf_t       *conf      = NULL;
+        gfs3_fallocate_req req       = {{0,},};
+        int                op_errno  = EINVAL;
+        int                ret       = 0;
+
+        if (!frame || !this || !data)
+                goto unwind;
+
+        args = data;
+
+        conf = this->private;
+
+        CLIENT_GET_REMOTE_FD(conf, args->fd, remote_fd, unwind);
+
+        req.fd     = remote_fd;
+        req.flags  = args->flags;
+        req.offset = args->offset;
+        req.size   = args->size;
+        memcpy (req.gfid, args->fd->inode->gfid, 16);
+
+        ret = client_submit_request (this, &req, frame, conf->fops,
+                                     GFS3_OP_FALLOCATE,
+                                     client3_1_fallocate_cbk, NULL,
+                                     NULL, 0, NULL, 0,
+                                     NULL, (xdrproc_t)xdr_gfs3_fallocate_req);
+        if (ret) {
+                op_errno = ENOTCONN;
+                goto unwind;
+        }
+        return 0;
+unwind:
+        gf_log (this->name, GF_LOG_WARNING, "failed to send the fop: %s", strerror (op_errno));
+        STACK_UNWIND_STRICT (fallocate, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+client3_1_discard (call_frame_t *frame, xlator_t *this,
+                   void *data)
+{
+        clnt_args_t       *args      = NULL;
+        int64_t            remote_fd = -1;
+        clnt_conf_t       *conf      = NULL;
+        gfs3_discard_req   req       = {{0,},};
+        int                op_errno  = EINVAL;
+        int                ret       = 0;
+
+        if (!frame || !this || !data)
+                goto unwind;
+
+        args = data;
+
+        conf = this->private;
+
+        CLIENT_GET_REMOTE_FD(conf, args->fd, remote_fd, unwind);
+
+        req.fd     = remote_fd;
+        req.offset = args->offset;
+        req.size   = args->size;
+        memcpy (req.gfid, args->fd->inode->gfid, 16);
+
+        ret = client_submit_request (this, &req, frame, conf->fops,
+                                     GFS3_OP_DISCARD,
+                                     client3_1_discard_cbk, NULL,
+                                     NULL, 0, NULL, 0,
+                                     NULL, (xdrproc_t)xdr_gfs3_discard_req);
+        if (ret) {
+                op_errno = ENOTCONN;
+                goto unwind;
+        }
+        return 0;
+unwind:
+        gf_log (this->name, GF_LOG_WARNING, "failed to send the fop: %s", strerror (op_errno));
+        STACK_UNWIND_STRICT (discard, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+client3_1_zerofill (call_frame_t *frame, xlator_t *this,
+                    void *data)
+{
+        clnt_args_t       *args      = NULL;
+        int64_t            remote_fd = -1;
+        clnt_conf_t       *conf      = NULL;
+        gfs3_zerofill_req  req       = {{0,},};
+        int                op_errno  = EINVAL;
+        int                ret       = 0;
+
+        if (!frame || !this || !data)
+                goto unwind;
+
+        args = data;
+
+        conf = this->private;
+
+        CLIENT_GET_REMOTE_FD(conf, args->fd, remote_fd, unwind);
+
+        req.fd     = remote_fd;
+        req.offset = args->offset;
+        req.size   = args->size;
+        memcpy (req.gfid, args->fd->inode->gfid, 16);
+
+        ret = client_submit_request (this, &req, frame, conf->fops,
+                                     GFS3_OP_ZEROFILL,
+                                     client3_1_zerofill_cbk, NULL,
+                                     NULL, 0, NULL, 0,
+                                     NULL, (xdrproc_t)xdr_gfs3_zerofill_req);
+        if (ret) {
+                op_errno = ENOTCONN;
+                goto unwind;
+        }
+        return 0;
+unwind:
+        gf_log (this->name, GF_LOG_WARNING, "failed to send the fop: %s", strerror (op_errno));
+        STACK_UNWIND_STRICT (zerofill, frame, -1, op_errno, NULL, NULL);
+        return 0;
+}
+
+
+int32_t
+client3_1_copy_file_range (call_frame_t *frame, xlator_t *this,
+                           void *data)
+{
+        clnt_args_t              *args       = NULL;
+        int64_t                   remote_fd  = -1;
+        clnt_conf_t              *conf       = NULL;
+        gfs3_copy_file_range_req  req        = {{0,},};
+        int                       op_errno   = EINVAL;
+        int                       ret        = 0;
+
+        if (!frame || !this || !data)
+                goto unwind;
+
+        args = data;
+
+        conf = this->private;
+
+        CLIENT_GET_REMOTE_FD(conf, args->fd, remote_fd, unwind);
+        req.fd_in   = remote_fd;
+
+        CLIENT_GET_REMOTE_FD(conf, args->fd_out, remote_fd, unwind);
+        req.fd_out  = remote_fd;
+
+        req.off_in  = args->offset;
+        req.off_out = args->offset_out;
+        req.size    = args->size;
+        req.flags   = args->flags;
+        memcpy (req.gfid_in, args->fd->inode->gfid, 16);
+        memcpy (req.gfid_out, args->fd_out->inode->gfid, 16);
+
+        ret = client_submit_request (this, &req, frame, conf->fops,
+                                     GFS3_OP_COPY_FILE_RANGE,
+                                     client3_1_copy_file_range_cbk, NULL,
+                                     NULL, 0, NULL, 0, NULL,
+                                     (xdrproc_t)xdr_gfs3_copy_file_range_req);
+        if (ret) {
+                op_errno = ENOTCONN;
+                goto unwind;
+        }
+        return 0;
+unwind:
+        gf_log (this->name, GF_LOG_WARNING, "failed to send the fop: %s", strerror (op_errno));
+        STACK_UNWIND_STRICT (copy_file_range, frame, -1, op_errno, NULL, NULL,
+                             NULL);
+        return 0;
+}
+
+
 
 int32_t
 client3_1_access (call_frame_t *frame, xlator_t *this,
@@ -5293,6 +5664,10 @@ rpc_clnt_procedure_t clnt3_1_fop_actors[GF_FOP_MAXVALUE] = {
         [GF_FOP_RELEASE]     = { "RELEASE",     client3_1_release },
         [GF_FOP_RELEASEDIR]  = { "RELEASEDIR",  client3_1_releasedir },
         [GF_FOP_GETSPEC]     = { "GETSPEC",     client3_getspec },
+        [GF_FOP_FALLOCATE]   = { "FALLOCATE",   client3_1_fallocate },
+        [GF_FOP_DISCARD]     = { "DISCARD",     client3_1_discard },
+        [GF_FOP_ZEROFILL]    = { "ZEROFILL",    client3_1_zerofill },
+        [GF_FOP_COPY_FILE_RANGE] = { "COPY_FILE_RANGE", client3_1_copy_file_range },
 };
 
 /* Used From RPC-CLNT library to log proper name of procedure based on number */
@@ -5340,6 +5715,10 @@ char *clnt3_1_fop_names[GFS3_OP_MAXVALUE] = {
         [GFS3_OP_READDIRP]    = "READDIRP",
         [GFS3_OP_RELEASE]     = "RELEASE",
         [GFS3_OP_RELEASEDIR]  = "RELEASEDIR",
+        [GFS3_OP_FALLOCATE]   = "FALLOCATE",
+        [GFS3_OP_DISCARD]     = "DISCARD",
+        [GFS3_OP_ZEROFILL]    = "ZEROFILL",
+        [GFS3_OP_COPY_FILE_RANGE] = "COPY_FILE_RANGE",
 };
 
 rpc_clnt_prog_t clnt3_1_fop_prog = {
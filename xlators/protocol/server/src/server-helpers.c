@@ -96,6 +96,11 @@ free_state (server_state_t *state)
                 state->fd = NULL;
         }
 
+        if (state->fd_out) {
+                fd_unref (state->fd_out);
+                state->fd_out = NULL;
+        }
+
         if (state->params) {
                 dict_unref (state->params);
                 state->params = NULL;
@@ -897,6 +902,10 @@ get_frame_from_request (rpcsvc_request_t *req)
         frame->root->trans    = req->trans->xl_private;
         frame->root->lk_owner = req->lk_owner;
 
+        if (frame->root->trans)
+                frame->root->client_uid =
+                        ((server_connection_t *)frame->root->trans)->id;
+
         server_decode_groups (frame, req);
 
         frame->local = req;
@@ -421,7 +421,10 @@ resolve_anonfd_simple (call_frame_t *frame)
 
         ret = 0;
 
-        state->fd = fd_anonymous (inode);
+        if (resolve == &state->resolve2)
+                state->fd_out = fd_anonymous (inode);
+        else
+                state->fd = fd_anonymous (inode);
 out:
         if (inode)
                 inode_unref (inode);
@@ -462,6 +465,7 @@ server_resolve_fd (call_frame_t *frame)
         server_resolve_t     *resolve = NULL;
         server_connection_t  *conn = NULL;
         uint64_t              fd_no = -1;
+        fd_t                 *fd = NULL;
 
         state = CALL_STATE (frame);
         resolve = state->resolve_now;
@@ -474,9 +478,16 @@ server_resolve_fd (call_frame_t *frame)
                 return 0;
         }
 
-        state->fd = gf_fd_fdptr_get (conn->fdtable, fd_no);
+        /* the second fd is the destination of a copy_file_range */
+        if (resolve == &state->resolve2) {
+                state->fd_out = gf_fd_fdptr_get (conn->fdtable, fd_no);
+                fd = state->fd_out;
+        } else {
+                state->fd = gf_fd_fdptr_get (conn->fdtable, fd_no);
+                fd = state->fd;
+        }
 
-        if (!state->fd) {
+        if (!fd) {
                 gf_log ("", GF_LOG_INFO, "fd not found in context");
                 resolve->op_ret   = -1;
                 resolve->op_errno = EBADF;
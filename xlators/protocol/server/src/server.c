@@ -36,6 +36,12 @@
 #include "authenticate.h"
 #include "rpcsvc.h"
 
+rpcsvc_cbk_program_t server_cbk_prog = {
+        .progname  = "Gluster Callback",
+        .prognum   = GLUSTER_CBK_PROGRAM,
+        .progver   = GLUSTER_CBK_VERSION,
+};
+
 struct iobuf *
 gfs_serialize_reply (rpcsvc_request_t *req, void *arg, struct iovec *outmsg,
                      xdrproc_t xdrproc)
@@ -412,7 +418,11 @@ server_rpc_notify (rpcsvc_t *rpc, void *xl, rpcsvc_event_t event,
                 */
                 INIT_LIST_HEAD (&xprt->list);
 
-                list_add_tail (&xprt->list, &conf->xprt_list);
+                pthread_mutex_lock (&conf->mutex);
+                {
+                        list_add_tail (&xprt->list, &conf->xprt_list);
+                }
+                pthread_mutex_unlock (&conf->mutex);
 
                 break;
         }
@@ -425,7 +435,11 @@ server_rpc_notify (rpcsvc_t *rpc, void *xl, rpcsvc_event_t event,
                         "disconnected connection from %s",
                         xprt->peerinfo.identifier);
 
-                list_del (&xprt->list);
+                pthread_mutex_lock (&conf->mutex);
+                {
+                        list_del (&xprt->list);
+                }
+                pthread_mutex_unlock (&conf->mutex);
 
                 break;
         case RPCSVC_EVENT_TRANSPORT_DESTROY:
@@ -790,11 +804,72 @@ fini (xlator_t *this)
         return;
 }
 
+/* send a cache invalidation raised by features/upcall to the client it
+ * is meant for, if that client is still connected.
+ */
+static int
+server_process_upcall (xlator_t *this, struct gf_upcall *upcall)
+{
+        server_conf_t                    *conf     = NULL;
+        rpc_transport_t                  *xprt     = NULL;
+        server_connection_t              *conn     = NULL;
+        gfs3_cbk_cache_invalidation_req   req      = {{0, }, };
+        struct iovec                      iov      = {0, };
+        char                              buf[64]  = {0, };
+        int                               ret      = -1;
+
+        conf = this->private;
+        if (!conf || !upcall || !upcall->client_uid)
+                goto out;
+
+        memcpy (req.gfid, upcall->gfid, 16);
+        req.flags = upcall->flags;
+
+        iov.iov_base = buf;
+        iov.iov_len  = sizeof (buf);
+
+        ret = xdr_serialize_generic (iov, &req,
+                                     (xdrproc_t)xdr_gfs3_cbk_cache_invalidation_req);
+        if (ret == -1) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "failed to encode cache invalidation of %s",
+                        uuid_utoa (upcall->gfid));
+                goto out;
+        }
+        iov.iov_len = ret;
+
+        ret = -1;
+        pthread_mutex_lock (&conf->mutex);
+        {
+                list_for_each_entry (xprt, &conf->xprt_list, list) {
+                        conn = xprt->xl_private;
+                        if (!conn || !conn->id ||
+                            strcmp (conn->id, upcall->client_uid))
+                                continue;
+
+                        ret = rpcsvc_callback_submit (conf->rpc, xprt,
+                                                      &server_cbk_prog,
+                                                      GF_CBK_CACHE_INVALIDATION,
+                                                      &iov, 1);
+                        break;
+                }
+        }
+        pthread_mutex_unlock (&conf->mutex);
+
+out:
+        return ret;
+}
+
 int
 notify (xlator_t *this, int32_t event, void *data, ...)
 {
         int          ret = 0;
         switch (event) {
+        case GF_EVENT_UPCALL:
+                /* upcalls end at the server, they are not propagated */
+                server_process_upcall (this, data);
+                break;
+
         default:
                 default_notify (this, event, data);
                 break;
@@ -153,6 +153,7 @@ struct _server_state {
         int               valid;
 
         fd_t             *fd;
+        fd_t             *fd_out;    /* fd of resolve2, copy_file_range */
         dict_t           *params;
         int               flags;
         int               wbflags;
@@ -163,6 +164,7 @@ struct _server_state {
 
         size_t            size;
         off_t             offset;
+        off_t             offset_out;
         mode_t            mode;
         dev_t             dev;
         size_t            nr_count;
@@ -1150,6 +1150,144 @@ server_ftruncate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         return 0;
 }
 
+int
+server_fallocate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                      int32_t op_ret, int32_t op_errno, struct iatt *statpre,
+                      struct iatt *statpost)
+{
+        gfs3_fallocate_rsp rsp   = {0,};
+        server_state_t   *state = NULL;
+        rpcsvc_request_t *req   = NULL;
+
+        req           = frame->local;
+
+        rsp.op_ret    = op_ret;
+        rsp.op_errno  = gf_errno_to_error (op_errno);
+
+        state = CALL_STATE (frame);
+
+        if (op_ret == 0) {
+                gf_stat_from_iatt (&rsp.statpre, statpre);
+                gf_stat_from_iatt (&rsp.statpost, statpost);
+        } else {
+                gf_log (this->name, GF_LOG_INFO,
+                        "%"PRId64": FALLOCATE %"PRId64" (%s)==> %"PRId32" (%s)",
+                        frame->root->unique, state->resolve.fd_no,
+                        state->fd ? uuid_utoa (state->fd->inode->gfid) : "--",
+                        op_ret, strerror (op_errno));
+        }
+
+        server_submit_reply (frame, req, &rsp, NULL, 0, NULL,
+                             (xdrproc_t)xdr_gfs3_fallocate_rsp);
+
+        return 0;
+}
+
+int
+server_discard_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                    int32_t op_ret, int32_t op_errno, struct iatt *statpre,
+                    struct iatt *statpost)
+{
+        gfs3_discard_rsp rsp   = {0,};
+        server_state_t   *state = NULL;
+        rpcsvc_request_t *req   = NULL;
+
+        req           = frame->local;
+
+        rsp.op_ret    = op_ret;
+        rsp.op_errno  = gf_errno_to_error (op_errno);
+
+        state = CALL_STATE (frame);
+
+        if (op_ret == 0) {
+                gf_stat_from_iatt (&rsp.statpre, statpre);
+                gf_stat_from_iatt (&rsp.statpost, statpost);
+        } else {
+                gf_log (this->name, GF_LOG_INFO,
+                        "%"PRId64": DISCARD %"PRId64" (%s)==> %"PRId32" (%s)",
+                        frame->root->unique, state->resolve.fd_no,
+                        state->fd ? uuid_utoa (state->fd->inode->gfid) : "--",
+                        op_ret, strerror (op_errno));
+        }
+
+        server_submit_reply (frame, req, &rsp, NULL, 0, NULL,
+                             (xdrproc_t)xdr_gfs3_discard_rsp);
+
+        return 0;
+}
+
+int
+server_zerofill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                     int32_t op_ret, int32_t op_errno, struct iatt *statpre,
+                     struct iatt *statpost)
+{
+        gfs3_zerofill_rsp rsp   = {0,};
+        server_state_t   *state = NULL;
+        rpcsvc_request_t *req   = NULL;
+
+        req           = frame->local;
+
+        rsp.op_ret    = op_ret;
+        rsp.op_errno  = gf_errno_to_error (op_errno);
+
+        state = CALL_STATE (frame);
+
+        if (op_ret == 0) {
+                gf_stat_from_iatt (&rsp.statpre, statpre);
+                gf_stat_from_iatt (&rsp.statpost, statpost);
+        } else {
+                gf_log (this->name, GF_LOG_INFO,
+                        "%"PRId64": ZEROFILL %"PRId64" (%s)==> %"PRId32" (%s)",
+                        frame->root->unique, state->resolve.fd_no,
+                        state->fd ? uuid_utoa (state->fd->inode->gfid) : "--",
+                        op_ret, strerror (op_errno));
+        }
+
+        server_submit_reply (frame, req, &rsp, NULL, 0, NULL,
+                             (xdrproc_t)xdr_gfs3_zerofill_rsp);
+
+        return 0;
+}
+
+int
+server_copy_file_range_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                            int32_t op_ret, int32_t op_errno,
+                            struct iatt *stbuf_in, struct iatt *statpre,
+                            struct iatt *statpost)
+{
+        gfs3_copy_file_range_rsp rsp   = {0,};
+        server_state_t          *state = NULL;
+        rpcsvc_request_t        *req   = NULL;
+
+        req           = frame->local;
+
+        rsp.op_ret    = op_ret;
+        rsp.op_errno  = gf_errno_to_error (op_errno);
+
+        state = CALL_STATE (frame);
+
+        if (op_ret >= 0) {
+                gf_stat_from_iatt (&rsp.stat, stbuf_in);
+                gf_stat_from_iatt (&rsp.statpre, statpre);
+                gf_stat_from_iatt (&rsp.statpost, statpost);
+        } else if (op_errno != EXDEV) {
+                gf_log (this->name, GF_LOG_INFO,
+                        "%"PRId64": COPY_FILE_RANGE %"PRId64" (%s) -> "
+                        "%"PRId64" (%s) ==> %"PRId32" (%s)",
+                        frame->root->unique, state->resolve.fd_no,
+                        state->fd ? uuid_utoa (state->fd->inode->gfid) : "--",
+                        state->resolve2.fd_no,
+                        state->fd_out ?
+                        uuid_utoa (state->fd_out->inode->gfid) : "--",
+                        op_ret, strerror (op_errno));
+        }
+
+        server_submit_reply (frame, req, &rsp, NULL, 0, NULL,
+                             (xdrproc_t)xdr_gfs3_copy_file_range_rsp);
+
+        return 0;
+}
+
 int
 server_flush_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                   int32_t op_ret, int32_t op_errno)
@@ -1254,9 +1392,22 @@ server_readv_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         gfs3_read_rsp     rsp   = {0,};
         server_state_t   *state = NULL;
         rpcsvc_request_t *req   = NULL;
+        int               ret   = 0;
 
         req           = frame->local;
 
+        /* the data may be a region of a file on the brick, which is read
+           here for the transports that can not send it from the file */
+        if ((op_ret > 0) && iobref && iobref->file && !req->trans->sendfile) {
+                ret = iobref_file_read (iobref, this->ctx->iobuf_pool,
+                                        vector, count);
+                if (ret) {
+                        op_ret   = -1;
+                        op_errno = -ret;
+                        count    = 0;
+                }
+        }
+
         rsp.op_ret    = op_ret;
         rsp.op_errno  = gf_errno_to_error (op_errno);
 
@@ -2413,6 +2564,103 @@ err:
 }
 
 
+int
+server_fallocate_resume (call_frame_t *frame, xlator_t *bound_xl)
+{
+        server_state_t    *state = NULL;
+
+        state = CALL_STATE (frame);
+
+        if (state->resolve.op_ret != 0)
+                goto err;
+
+        STACK_WIND (frame, server_fallocate_cbk,
+                    bound_xl, bound_xl->fops->fallocate,
+                    state->fd, state->flags, state->offset,
+                    state->size);
+        return 0;
+err:
+        server_fallocate_cbk (frame, NULL, frame->this, state->resolve.op_ret,
+                              state->resolve.op_errno, NULL, NULL);
+
+        return 0;
+}
+
+
+int
+server_discard_resume (call_frame_t *frame, xlator_t *bound_xl)
+{
+        server_state_t    *state = NULL;
+
+        state = CALL_STATE (frame);
+
+        if (state->resolve.op_ret != 0)
+                goto err;
+
+        STACK_WIND (frame, server_discard_cbk,
+                    bound_xl, bound_xl->fops->discard,
+                    state->fd, state->offset, state->size);
+        return 0;
+err:
+        server_discard_cbk (frame, NULL, frame->this, state->resolve.op_ret,
+                            state->resolve.op_errno, NULL, NULL);
+
+        return 0;
+}
+
+
+int
+server_zerofill_resume (call_frame_t *frame, xlator_t *bound_xl)
+{
+        server_state_t    *state = NULL;
+
+        state = CALL_STATE (frame);
+
+        if (state->resolve.op_ret != 0)
+                goto err;
+
+        STACK_WIND (frame, server_zerofill_cbk,
+                    bound_xl, bound_xl->fops->zerofill,
+                    state->fd, state->offset, state->size);
+        return 0;
+err:
+        server_zerofill_cbk (frame, NULL, frame->this, state->resolve.op_ret,
+                             state->resolve.op_errno, NULL, NULL);
+
+        return 0;
+}
+
+
+int
+server_copy_file_range_resume (call_frame_t *frame, xlator_t *bound_xl)
+{
+        server_state_t    *state = NULL;
+
+        state = CALL_STATE (frame);
+
+        if (state->resolve.op_ret != 0)
+                goto err;
+
+        if (state->resolve2.op_ret != 0) {
+                state->resolve.op_ret   = state->resolve2.op_ret;
+                state->resolve.op_errno = state->resolve2.op_errno;
+                goto err;
+        }
+
+        STACK_WIND (frame, server_copy_file_range_cbk,
+                    bound_xl, bound_xl->fops->copy_file_range,
+                    state->fd, state->offset, state->fd_out,
+                    state->offset_out, state->size, state->flags);
+        return 0;
+err:
+        server_copy_file_range_cbk (frame, NULL, frame->this,
+                                    state->resolve.op_ret,
+                                    state->resolve.op_errno, NULL, NULL, NULL);
+
+        return 0;
+}
+
+
 int
 server_flush_resume (call_frame_t *frame, xlator_t *bound_xl)
 {
@@ -3323,6 +3571,195 @@ out:
 }
 
 
+int
+server_fallocate (rpcsvc_request_t *req)
+{
+        server_state_t   *state = NULL;
+        call_frame_t     *frame = NULL;
+        gfs3_fallocate_req args  = {{0,},};
+        int               ret   = -1;
+
+        if (!req)
+                return ret;
+
+        if (!xdr_to_generic (req->msg[0], &args, (xdrproc_t)xdr_gfs3_fallocate_req)) {
+                //failed to decode msg;
+                req->rpc_err = GARBAGE_ARGS;
+                goto out;
+        }
+
+        frame = get_frame_from_request (req);
+        if (!frame) {
+                // something wrong, mostly insufficient memory
+                req->rpc_err = GARBAGE_ARGS; /* TODO */
+                goto out;
+        }
+        frame->root->op = GF_FOP_FALLOCATE;
+
+        state = CALL_STATE (frame);
+        if (!state->conn->bound_xl) {
+                /* auth failure, request on subvolume without setvolume */
+                req->rpc_err = GARBAGE_ARGS;
+                goto out;
+        }
+
+        state->resolve.type   = RESOLVE_MUST;
+        state->resolve.fd_no  = args.fd;
+        state->flags          = args.flags;
+        state->offset         = args.offset;
+        state->size           = args.size;
+        memcpy (state->resolve.gfid, args.gfid, 16);
+
+        ret = 0;
+        resolve_and_resume (frame, server_fallocate_resume);
+out:
+        return ret;
+}
+
+
+int
+server_discard (rpcsvc_request_t *req)
+{
+        server_state_t   *state = NULL;
+        call_frame_t     *frame = NULL;
+        gfs3_discard_req args  = {{0,},};
+        int               ret   = -1;
+
+        if (!req)
+                return ret;
+
+        if (!xdr_to_generic (req->msg[0], &args, (xdrproc_t)xdr_gfs3_discard_req)) {
+                //failed to decode msg;
+                req->rpc_err = GARBAGE_ARGS;
+                goto out;
+        }
+
+        frame = get_frame_from_request (req);
+        if (!frame) {
+                // something wrong, mostly insufficient memory
+                req->rpc_err = GARBAGE_ARGS; /* TODO */
+                goto out;
+        }
+        frame->root->op = GF_FOP_DISCARD;
+
+        state = CALL_STATE (frame);
+        if (!state->conn->bound_xl) {
+                /* auth failure, request on subvolume without setvolume */
+                req->rpc_err = GARBAGE_ARGS;
+                goto out;
+        }
+
+        state->resolve.type   = RESOLVE_MUST;
+        state->resolve.fd_no  = args.fd;
+        state->offset         = args.offset;
+        state->size           = args.size;
+        memcpy (state->resolve.gfid, args.gfid, 16);
+
+        ret = 0;
+        resolve_and_resume (frame, server_discard_resume);
+out:
+        return ret;
+}
+
+
+int
+server_zerofill (rpcsvc_request_t *req)
+{
+        server_state_t   *state = NULL;
+        call_frame_t     *frame = NULL;
+        gfs3_zerofill_req args  = {{0,},};
+        int               ret   = -1;
+
+        if (!req)
+                return ret;
+
+        if (!xdr_to_generic (req->msg[0], &args, (xdrproc_t)xdr_gfs3_zerofill_req)) {
+                //failed to decode msg;
+                req->rpc_err = GARBAGE_ARGS;
+                goto out;
+        }
+
+        frame = get_frame_from_request (req);
+        if (!frame) {
+                // something wrong, mostly insufficient memory
+                req->rpc_err = GARBAGE_ARGS; /* TODO */
+                goto out;
+        }
+        frame->root->op = GF_FOP_ZEROFILL;
+
+        state = CALL_STATE (frame);
+        if (!state->conn->bound_xl) {
+                /* auth failure, request on subvolume without setvolume */
+                req->rpc_err = GARBAGE_ARGS;
+                goto out;
+        }
+
+        state->resolve.type   = RESOLVE_MUST;
+        state->resolve.fd_no  = args.fd;
+        state->offset         = args.offset;
+        state->size           = args.size;
+        memcpy (state->resolve.gfid, args.gfid, 16);
+
+        ret = 0;
+        resolve_and_resume (frame, server_zerofill_resume);
+out:
+        return ret;
+}
+
+
+int
+server_copy_file_range (rpcsvc_request_t *req)
+{
+        server_state_t          *state = NULL;
+        call_frame_t            *frame = NULL;
+        gfs3_copy_file_range_req args  = {{0,},};
+        int                      ret   = -1;
+
+        if (!req)
+                return ret;
+
+        if (!xdr_to_generic (req->msg[0], &args,
+                             (xdrproc_t)xdr_gfs3_copy_file_range_req)) {
+                //failed to decode msg;
+                req->rpc_err = GARBAGE_ARGS;
+                goto out;
+        }
+
+        frame = get_frame_from_request (req);
+        if (!frame) {
+                // something wrong, mostly insufficient memory
+                req->rpc_err = GARBAGE_ARGS; /* TODO */
+                goto out;
+        }
+        frame->root->op = GF_FOP_COPY_FILE_RANGE;
+
+        state = CALL_STATE (frame);
+        if (!state->conn->bound_xl) {
+                /* auth failure, request on subvolume without setvolume */
+                req->rpc_err = GARBAGE_ARGS;
+                goto out;
+        }
+
+        state->resolve.type   = RESOLVE_MUST;
+        state->resolve.fd_no  = args.fd_in;
+        state->offset         = args.off_in;
+        memcpy (state->resolve.gfid, args.gfid_in, 16);
+
+        state->resolve2.type  = RESOLVE_MUST;
+        state->resolve2.fd_no = args.fd_out;
+        state->offset_out     = args.off_out;
+        memcpy (state->resolve2.gfid, args.gfid_out, 16);
+
+        state->size           = args.size;
+        state->flags          = args.flags;
+
+        ret = 0;
+        resolve_and_resume (frame, server_copy_file_range_resume);
+out:
+        return ret;
+}
+
+
 int
 server_fstat (rpcsvc_request_t *req)
 {
@@ -5193,6 +5630,10 @@ rpcsvc_actor_t glusterfs3_1_fop_actors[] = {
         [GFS3_OP_READDIRP]    = { "READDIRP",   GFS3_OP_READDIRP, server_readdirp, NULL, NULL, 0},
         [GFS3_OP_RELEASE]     = { "RELEASE",    GFS3_OP_RELEASE, server_release, NULL, NULL, 0},
         [GFS3_OP_RELEASEDIR]  = { "RELEASEDIR", GFS3_OP_RELEASEDIR, server_releasedir, NULL, NULL, 0},
+        [GFS3_OP_FALLOCATE]   = { "FALLOCATE",  GFS3_OP_FALLOCATE, server_fallocate, NULL, NULL, 0},
+        [GFS3_OP_DISCARD]     = { "DISCARD",    GFS3_OP_DISCARD, server_discard, NULL, NULL, 0},
+        [GFS3_OP_ZEROFILL]    = { "ZEROFILL",   GFS3_OP_ZEROFILL, server_zerofill, NULL, NULL, 0},
+        [GFS3_OP_COPY_FILE_RANGE] = { "COPY_FILE_RANGE", GFS3_OP_COPY_FILE_RANGE, server_copy_file_range, NULL, NULL, 0},
 };
 
 
@@ -0,0 +1,645 @@
+/*
+   Copyright (c) 2012 Gluster, Inc. <http://www.gluster.com>
+   This file is part of GlusterFS.
+
+   GlusterFS is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 3 of the License,
+   or (at your option) any later version.
+
+   GlusterFS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see
+   <http://www.gnu.org/licenses/>.
+*/
+
+
+/* Asynchronous data path of posix: readv, writev and fsync are submitted
+   to a Linux AIO context of the brick and unwound from a completion
+   thread, so that the number of I/Os in flight is no longer bound by the
+   number of threads that can block in pread/pwrite. The raw system calls
+   are used, there is no dependency on libaio.
+
+   Linux AIO is asynchronous only for O_DIRECT: reads and writes of
+   buffered fds would complete inside io_submit(), and are done
+   synchronously. */
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "posix.h"
+#include "posix-aio.h"
+#include "xlator.h"
+#include "iobuf.h"
+#include "common-utils.h"
+
+#ifdef HAVE_LINUX_AIO
+
+#include <sys/syscall.h>
+#include <linux/aio_abi.h>
+
+struct posix_aio_cb {
+        struct iocb     iocb;
+        call_frame_t   *frame;
+        xlator_t       *this;
+        fd_t           *fd;
+        int             _fd;
+        glusterfs_fop_t op;
+        off_t           offset;
+        char           *buf;
+        struct iobref  *iobref;
+        struct iovec   *vector;
+        int             count;
+        int             flushwrites;
+        struct iatt     prebuf;
+};
+
+static void
+posix_aio_done (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+
+        priv = this->private;
+
+        pthread_mutex_lock (&priv->aio_lock);
+        {
+                if (!--priv->aio_in_flight)
+                        pthread_cond_broadcast (&priv->aio_cond);
+        }
+        pthread_mutex_unlock (&priv->aio_lock);
+}
+
+static int
+posix_io_setup (unsigned nr, aio_context_t *ctxp)
+{
+        return syscall (SYS_io_setup, nr, ctxp);
+}
+
+static int
+posix_io_destroy (aio_context_t ctx)
+{
+        return syscall (SYS_io_destroy, ctx);
+}
+
+static int
+posix_io_submit (aio_context_t ctx, long nr, struct iocb **iocbpp)
+{
+        return syscall (SYS_io_submit, ctx, nr, iocbpp);
+}
+
+static int
+posix_io_getevents (aio_context_t ctx, long min_nr, long nr,
+                    struct io_event *events, struct timespec *timeout)
+{
+        return syscall (SYS_io_getevents, ctx, min_nr, nr, events, timeout);
+}
+
+static void
+posix_aio_cb_free (struct posix_aio_cb *paiocb)
+{
+        if (!paiocb)
+                return;
+
+        if (paiocb->fd)
+                fd_unref (paiocb->fd);
+        if (paiocb->iobref)
+                iobref_unref (paiocb->iobref);
+        if (paiocb->vector)
+                GF_FREE (paiocb->vector);
+
+        GF_FREE (paiocb);
+}
+
+static struct posix_aio_cb *
+posix_aio_cb_new (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                  struct posix_fd *pfd, glusterfs_fop_t op, off_t offset)
+{
+        struct posix_aio_cb *paiocb = NULL;
+
+        paiocb = GF_CALLOC (1, sizeof (*paiocb), gf_posix_mt_paiocb);
+        if (!paiocb)
+                return NULL;
+
+        paiocb->frame       = frame;
+        paiocb->this        = this;
+        paiocb->fd          = fd_ref (fd);
+        paiocb->_fd         = pfd->fd;
+        paiocb->op          = op;
+        paiocb->offset      = offset;
+        paiocb->flushwrites = pfd->flushwrites;
+
+        paiocb->iocb.aio_data   = (uint64_t) (unsigned long) paiocb;
+        paiocb->iocb.aio_fildes = pfd->fd;
+
+        return paiocb;
+}
+
+/* an aligned buffer of size bytes, kept by paiocb->iobref */
+static int
+posix_aio_buf_get (xlator_t *this, struct posix_aio_cb *paiocb, size_t size)
+{
+        struct iobuf *iobuf = NULL;
+        int           ret   = -1;
+
+        iobuf = iobuf_get2 (this->ctx->iobuf_pool, size + POSIX_AIO_ALIGN);
+        if (!iobuf)
+                goto out;
+
+        paiocb->iobref = iobref_new ();
+        if (!paiocb->iobref)
+                goto out;
+
+        ret = iobref_add (paiocb->iobref, iobuf);
+        if (ret)
+                goto out;
+
+        paiocb->buf = ALIGN_BUF (iobuf->ptr, POSIX_AIO_ALIGN);
+out:
+        if (iobuf)
+                iobuf_unref (iobuf);
+
+        return ret;
+}
+
+/* the submissions are counted so that posix_aio_off() can wait for
+   their completions before the context goes */
+static int
+posix_aio_submit (xlator_t *this, struct posix_aio_cb *paiocb)
+{
+        struct posix_private *priv     = NULL;
+        struct iocb          *iocbs[1] = {&paiocb->iocb};
+        gf_boolean_t          capable  = _gf_false;
+        int                   ret      = -1;
+
+        priv = this->private;
+
+        pthread_mutex_lock (&priv->aio_lock);
+        {
+                capable = priv->aio_capable;
+                if (capable)
+                        priv->aio_in_flight++;
+        }
+        pthread_mutex_unlock (&priv->aio_lock);
+
+        if (!capable)
+                return -1;
+
+        ret = posix_io_submit (priv->aio_ctx, 1, iocbs);
+        if (ret != 1) {
+                /* a full ring is not an error, the fop is done
+                   synchronously */
+                if (errno != EAGAIN)
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "io_submit() of %s failed: %s",
+                                gf_fop_list[paiocb->op], strerror (errno));
+                posix_aio_done (this);
+                return -1;
+        }
+
+        return 0;
+}
+
+static void
+posix_aio_readv_complete (struct posix_aio_cb *paiocb, long res)
+{
+        xlator_t             *this     = NULL;
+        struct posix_private *priv     = NULL;
+        struct iovec          vec      = {0,};
+        struct iatt           stbuf    = {0,};
+        int32_t               op_ret   = -1;
+        int32_t               op_errno = 0;
+
+        this = paiocb->this;
+        priv = this->private;
+
+        if (res < 0) {
+                op_errno = -res;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "read failed on fd=%p: %s", paiocb->fd,
+                        strerror (op_errno));
+                goto out;
+        }
+
+        LOCK (&priv->lock);
+        {
+                priv->read_value += res;
+        }
+        UNLOCK (&priv->lock);
+
+        vec.iov_base = paiocb->buf;
+        vec.iov_len  = res;
+
+        op_ret = posix_fdstat (this, paiocb->_fd, &stbuf);
+        if (op_ret == -1) {
+                op_errno = errno;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "fstat failed on fd=%p: %s", paiocb->fd,
+                        strerror (op_errno));
+                goto out;
+        }
+
+        /* Hack to notify higher layers of EOF. */
+        if (stbuf.ia_size == 0)
+                op_errno = ENOENT;
+        else if ((paiocb->offset + vec.iov_len) == stbuf.ia_size)
+                op_errno = ENOENT;
+        else if (paiocb->offset > stbuf.ia_size)
+                op_errno = ENOENT;
+
+        op_ret = vec.iov_len;
+out:
+        STACK_UNWIND_STRICT (readv, paiocb->frame, op_ret, op_errno,
+                             &vec, 1, &stbuf, paiocb->iobref);
+}
+
+static void
+posix_aio_writev_complete (struct posix_aio_cb *paiocb, long res)
+{
+        xlator_t             *this     = NULL;
+        struct posix_private *priv     = NULL;
+        struct iatt           postbuf  = {0,};
+        int32_t               op_ret   = -1;
+        int32_t               op_errno = 0;
+
+        this = paiocb->this;
+        priv = this->private;
+
+        if (res < 0) {
+                op_errno = -res;
+                gf_log (this->name, GF_LOG_ERROR, "write failed: offset %"
+                        PRIu64", %s", paiocb->offset, strerror (op_errno));
+                goto out;
+        }
+
+        LOCK (&priv->lock);
+        {
+                priv->write_value += res;
+        }
+        UNLOCK (&priv->lock);
+
+        if (paiocb->flushwrites) {
+                /* NOTE: ignore the error, if one occurs at this point */
+                fsync (paiocb->_fd);
+        }
+
+        if (posix_fdstat (this, paiocb->_fd, &postbuf) == -1) {
+                op_errno = errno;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "post-operation fstat failed on fd=%p: %s",
+                        paiocb->fd, strerror (op_errno));
+                goto out;
+        }
+
+        op_ret = res;
+out:
+        STACK_UNWIND_STRICT (writev, paiocb->frame, op_ret, op_errno,
+                             &paiocb->prebuf, &postbuf);
+}
+
+static void
+posix_aio_fsync_complete (struct posix_aio_cb *paiocb, long res)
+{
+        xlator_t    *this     = NULL;
+        struct iatt  postbuf  = {0,};
+        int32_t      op_ret   = -1;
+        int32_t      op_errno = 0;
+
+        this = paiocb->this;
+
+        if (res < 0) {
+                op_errno = -res;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "fsync on fd=%p failed: %s", paiocb->fd,
+                        strerror (op_errno));
+                goto out;
+        }
+
+        if (posix_fdstat (this, paiocb->_fd, &postbuf) == -1) {
+                op_errno = errno;
+                gf_log (this->name, GF_LOG_WARNING,
+                        "post-operation fstat failed on fd=%p: %s",
+                        paiocb->fd, strerror (op_errno));
+                goto out;
+        }
+
+        op_ret = 0;
+out:
+        STACK_UNWIND_STRICT (fsync, paiocb->frame, op_ret, op_errno,
+                             &paiocb->prebuf, &postbuf);
+}
+
+static void *
+posix_aio_thread (void *data)
+{
+        xlator_t             *this   = NULL;
+        struct posix_private *priv   = NULL;
+        struct posix_aio_cb  *paiocb = NULL;
+        struct io_event       events[POSIX_AIO_MAX_NR_GETEVENTS];
+        int                   ret    = 0;
+        int                   i      = 0;
+
+        this = data;
+        priv = this->private;
+
+        for (;;) {
+                ret = posix_io_getevents (priv->aio_ctx, 1,
+                                          POSIX_AIO_MAX_NR_GETEVENTS,
+                                          events, NULL);
+                if (ret < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        /* the context is gone, posix_aio_off() */
+                        gf_log (this->name, GF_LOG_DEBUG,
+                                "io_getevents() returned %s, completion "
+                                "thread exiting", strerror (errno));
+                        break;
+                }
+
+                for (i = 0; i < ret; i++) {
+                        paiocb = (void *) (unsigned long) events[i].data;
+
+                        THIS = this;
+
+                        switch (paiocb->op) {
+                        case GF_FOP_READ:
+                                posix_aio_readv_complete (paiocb,
+                                                          events[i].res);
+                                break;
+                        case GF_FOP_WRITE:
+                                posix_aio_writev_complete (paiocb,
+                                                           events[i].res);
+                                break;
+                        case GF_FOP_FSYNC:
+                                posix_aio_fsync_complete (paiocb,
+                                                          events[i].res);
+                                break;
+                        default:
+                                gf_log (this->name, GF_LOG_ERROR,
+                                        "completion of unknown fop %d",
+                                        paiocb->op);
+                                break;
+                        }
+
+                        posix_aio_cb_free (paiocb);
+                        posix_aio_done (this);
+                }
+        }
+
+        return NULL;
+}
+
+int
+posix_aio_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                 struct posix_fd *pfd, size_t size, off_t offset)
+{
+        struct posix_aio_cb *paiocb = NULL;
+
+        if (!pfd->odirect)
+                return -1;
+
+        paiocb = posix_aio_cb_new (frame, this, fd, pfd, GF_FOP_READ, offset);
+        if (!paiocb)
+                goto err;
+
+        if (posix_aio_buf_get (this, paiocb, size))
+                goto err;
+
+        paiocb->iocb.aio_lio_opcode = IOCB_CMD_PREAD;
+        paiocb->iocb.aio_buf        = (uint64_t) (unsigned long) paiocb->buf;
+        paiocb->iocb.aio_nbytes     = size;
+        paiocb->iocb.aio_offset     = offset;
+
+        if (posix_aio_submit (this, paiocb))
+                goto err;
+
+        return 0;
+err:
+        posix_aio_cb_free (paiocb);
+        return -1;
+}
+
+static gf_boolean_t
+posix_aio_aligned (struct iovec *vector, int32_t count, off_t offset)
+{
+        int i = 0;
+
+        if (offset % POSIX_AIO_ALIGN)
+                return _gf_false;
+
+        for (i = 0; i < count; i++) {
+                if (((unsigned long) vector[i].iov_base % POSIX_AIO_ALIGN) ||
+                    (vector[i].iov_len % POSIX_AIO_ALIGN))
+                        return _gf_false;
+        }
+
+        return _gf_true;
+}
+
+int
+posix_aio_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                  struct posix_fd *pfd, struct iovec *vector, int32_t count,
+                  off_t offset, struct iobref *iobref, struct iatt *prebuf)
+{
+        struct posix_aio_cb *paiocb = NULL;
+        size_t               size   = 0;
+
+        if (!pfd->odirect)
+                return -1;
+
+        paiocb = posix_aio_cb_new (frame, this, fd, pfd, GF_FOP_WRITE,
+                                   offset);
+        if (!paiocb)
+                goto err;
+
+        paiocb->prebuf = *prebuf;
+        size = iov_length (vector, count);
+
+        if (!posix_aio_aligned (vector, count, offset)) {
+                /* O_DIRECT wants aligned buffers: the data is written from
+                   one aligned copy, as __posix_writev() does */
+                if (posix_aio_buf_get (this, paiocb, size))
+                        goto err;
+                iov_unload (paiocb->buf, vector, count);
+
+                paiocb->iocb.aio_lio_opcode = IOCB_CMD_PWRITE;
+                paiocb->iocb.aio_buf    = (uint64_t) (unsigned long)
+                                          paiocb->buf;
+                paiocb->iocb.aio_nbytes = size;
+        } else {
+                paiocb->vector = iov_dup (vector, count);
+                if (!paiocb->vector)
+                        goto err;
+                paiocb->count = count;
+                if (iobref)
+                        paiocb->iobref = iobref_ref (iobref);
+
+                paiocb->iocb.aio_lio_opcode = IOCB_CMD_PWRITEV;
+                paiocb->iocb.aio_buf    = (uint64_t) (unsigned long)
+                                          paiocb->vector;
+                paiocb->iocb.aio_nbytes = count;
+        }
+        paiocb->iocb.aio_offset = offset;
+
+        if (posix_aio_submit (this, paiocb))
+                goto err;
+
+        return 0;
+err:
+        posix_aio_cb_free (paiocb);
+        return -1;
+}
+
+int
+posix_aio_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                 struct posix_fd *pfd, int32_t datasync, struct iatt *prebuf)
+{
+        struct posix_private *priv   = NULL;
+        struct posix_aio_cb  *paiocb = NULL;
+
+        priv = this->private;
+
+        paiocb = posix_aio_cb_new (frame, this, fd, pfd, GF_FOP_FSYNC, 0);
+        if (!paiocb)
+                goto err;
+
+        paiocb->prebuf = *prebuf;
+        paiocb->iocb.aio_lio_opcode = datasync ? IOCB_CMD_FDSYNC :
+                                                 IOCB_CMD_FSYNC;
+
+        if (posix_aio_submit (this, paiocb)) {
+                /* older kernels and some filesystems can not sync
+                   asynchronously, stop trying */
+                if (errno == EINVAL) {
+                        gf_log (this->name, GF_LOG_INFO, "asynchronous "
+                                "fsync is not supported, fsync is done "
+                                "synchronously");
+                        priv->aio_fsync = _gf_false;
+                }
+                goto err;
+        }
+
+        return 0;
+err:
+        posix_aio_cb_free (paiocb);
+        return -1;
+}
+
+int
+posix_aio_on (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+        int                   ret  = -1;
+
+        priv = this->private;
+
+        pthread_mutex_init (&priv->aio_lock, NULL);
+        pthread_cond_init (&priv->aio_cond, NULL);
+        priv->aio_in_flight = 0;
+
+        ret = posix_io_setup (POSIX_AIO_MAX_NR_EVENTS, &priv->aio_ctx);
+        if (ret) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "io_setup() failed: %s", strerror (errno));
+                goto out;
+        }
+
+        ret = pthread_create (&priv->aiothread, NULL, posix_aio_thread,
+                              this);
+        if (ret) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "spawning the aio completion thread failed: %s",
+                        strerror (ret));
+                posix_io_destroy (priv->aio_ctx);
+                priv->aio_ctx = 0;
+                ret = -1;
+                goto out;
+        }
+
+        priv->aio_capable = _gf_true;
+        priv->aio_fsync   = _gf_true;
+
+        gf_log (this->name, GF_LOG_INFO, "linux aio enabled, %d events "
+                "in flight at most", POSIX_AIO_MAX_NR_EVENTS);
+out:
+        return ret;
+}
+
+int
+posix_aio_off (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+
+        priv = this->private;
+
+        if (!priv->aio_capable)
+                return 0;
+
+        /* no more submissions, and those in flight are unwound by the
+           completion thread before the context goes: io_destroy() would
+           drop their events */
+        pthread_mutex_lock (&priv->aio_lock);
+        {
+                priv->aio_capable = _gf_false;
+                while (priv->aio_in_flight)
+                        pthread_cond_wait (&priv->aio_cond, &priv->aio_lock);
+        }
+        pthread_mutex_unlock (&priv->aio_lock);
+
+        /* wakes up the completion thread with EINVAL */
+        posix_io_destroy (priv->aio_ctx);
+        pthread_join (priv->aiothread, NULL);
+        priv->aio_ctx = 0;
+
+        return 0;
+}
+
+#else /* !HAVE_LINUX_AIO */
+
+int
+posix_aio_on (xlator_t *this)
+{
+        gf_log (this->name, GF_LOG_WARNING,
+                "linux aio is not available in this build");
+        return -1;
+}
+
+int
+posix_aio_off (xlator_t *this)
+{
+        return 0;
+}
+
+int
+posix_aio_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                 struct posix_fd *pfd, size_t size, off_t offset)
+{
+        return -1;
+}
+
+int
+posix_aio_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                  struct posix_fd *pfd, struct iovec *vector, int32_t count,
+                  off_t offset, struct iobref *iobref, struct iatt *prebuf)
+{
+        return -1;
+}
+
+int
+posix_aio_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                 struct posix_fd *pfd, int32_t datasync, struct iatt *prebuf)
+{
+        return -1;
+}
+
+#endif /* HAVE_LINUX_AIO */
@@ -0,0 +1,53 @@
+/*
+   Copyright (c) 2012 Gluster, Inc. <http://www.gluster.com>
+   This file is part of GlusterFS.
+
+   GlusterFS is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 3 of the License,
+   or (at your option) any later version.
+
+   GlusterFS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see
+   <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _POSIX_AIO_H
+#define _POSIX_AIO_H
+
+#include "xlator.h"
+#include "glusterfs.h"
+
+/* events the per brick context can have in flight */
+#define POSIX_AIO_MAX_NR_EVENTS    256
+/* events reaped by the completion thread at a time */
+#define POSIX_AIO_MAX_NR_GETEVENTS 16
+
+/* buffers handed to the kernel are aligned for O_DIRECT */
+#define POSIX_AIO_ALIGN            4096
+
+struct posix_fd;
+
+int posix_aio_on (xlator_t *this);
+int posix_aio_off (xlator_t *this);
+
+/* these return 0 when the fop was taken over (it is unwound from the
+   completion thread, or was already unwound with an error), and -1 when
+   it has to be done synchronously */
+int posix_aio_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                     struct posix_fd *pfd, size_t size, off_t offset);
+int posix_aio_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                      struct posix_fd *pfd, struct iovec *vector,
+                      int32_t count, off_t offset, struct iobref *iobref,
+                      struct iatt *prebuf);
+int posix_aio_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                     struct posix_fd *pfd, int32_t datasync,
+                     struct iatt *prebuf);
+
+#endif /* _POSIX_AIO_H */
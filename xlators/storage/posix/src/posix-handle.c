@@ -28,6 +28,7 @@
 #include <unistd.h>
 #include <libgen.h>
 #include <alloca.h>
+#include <fcntl.h>
 
 #include "posix-handle.h"
 #include "posix.h"
@@ -159,6 +160,341 @@ err:
 }
 
 
+/*
+  Directory handles are symlinks to "../../xx/yy/<parent gfid>/<name>",
+  resolving one costs an lstat and a readlink per level pumped. The
+  resolved paths of directories are kept in a bounded cache, together with
+  an O_PATH fd of the directory which posix_istat() uses with fstatat().
+
+  An entry is dropped when its handle is unset (unlink, rmdir, and the
+  victim or source of a rename). A pumped path can go through the names
+  of several ancestors, so renaming a directory flushes the whole cache;
+  the generation number keeps a resolution which started before a flush
+  from being cached after it.
+*/
+
+static struct list_head *
+posix_handle_cache_bucket (struct posix_handle_cache *cache, uuid_t gfid)
+{
+        uint32_t hash = 0;
+
+        hash = (gfid[12] << 24) | (gfid[13] << 16) | (gfid[14] << 8) |
+                gfid[15];
+
+        return &cache->buckets[hash % POSIX_HANDLE_CACHE_BUCKETS];
+}
+
+
+static struct posix_handle_cache_entry *
+__posix_handle_cache_find (struct posix_handle_cache *cache, uuid_t gfid)
+{
+        struct posix_handle_cache_entry *entry = NULL;
+        struct list_head                *head  = NULL;
+
+        head = posix_handle_cache_bucket (cache, gfid);
+
+        list_for_each_entry (entry, head, hash) {
+                if (uuid_compare (entry->gfid, gfid) == 0)
+                        return entry;
+        }
+
+        return NULL;
+}
+
+
+static void
+posix_handle_cache_entry_free (struct posix_handle_cache_entry *entry)
+{
+        if (entry->fd != -1)
+                close (entry->fd);
+
+        GF_FREE (entry->path);
+        GF_FREE (entry);
+}
+
+
+/* unlinks the entry, which is freed now or when its last user is done */
+static struct posix_handle_cache_entry *
+__posix_handle_cache_unlink (struct posix_handle_cache *cache,
+                             struct posix_handle_cache_entry *entry)
+{
+        list_del_init (&entry->hash);
+        list_del_init (&entry->lru);
+        cache->count--;
+
+        entry->dead = _gf_true;
+        if (entry->ref)
+                return NULL;
+
+        return entry;
+}
+
+
+struct posix_handle_cache *
+posix_handle_cache_new (xlator_t *this, uint32_t limit)
+{
+        struct posix_handle_cache *cache = NULL;
+        int                        i     = 0;
+
+        if (!limit)
+                return NULL;
+
+        cache = GF_CALLOC (1, sizeof (*cache), gf_posix_mt_handle_cache);
+        if (!cache)
+                return NULL;
+
+        LOCK_INIT (&cache->lock);
+        for (i = 0; i < POSIX_HANDLE_CACHE_BUCKETS; i++)
+                INIT_LIST_HEAD (&cache->buckets[i]);
+        INIT_LIST_HEAD (&cache->lru);
+        cache->limit = limit;
+
+        return cache;
+}
+
+
+void
+posix_handle_cache_destroy (struct posix_handle_cache *cache)
+{
+        struct posix_handle_cache_entry *entry = NULL;
+        struct posix_handle_cache_entry *tmp   = NULL;
+
+        if (!cache)
+                return;
+
+        list_for_each_entry_safe (entry, tmp, &cache->lru, lru) {
+                list_del_init (&entry->lru);
+                posix_handle_cache_entry_free (entry);
+        }
+
+        LOCK_DESTROY (&cache->lock);
+        GF_FREE (cache);
+}
+
+
+/* fills buf with the cached path of the directory followed by basename,
+   and returns its length; -1 when gfid is not cached */
+static int
+posix_handle_cache_path (xlator_t *this, uuid_t gfid, const char *basename,
+                         char *buf, int maxlen, uint64_t *generation)
+{
+        struct posix_private            *priv  = NULL;
+        struct posix_handle_cache       *cache = NULL;
+        struct posix_handle_cache_entry *entry = NULL;
+        int                              len   = -1;
+
+        priv  = this->private;
+        cache = priv->handle_cache;
+        if (!cache)
+                return -1;
+
+        LOCK (&cache->lock);
+        {
+                *generation = cache->generation;
+
+                entry = __posix_handle_cache_find (cache, gfid);
+                if (!entry)
+                        goto unlock;
+
+                cache->hits++;
+                list_move (&entry->lru, &cache->lru);
+
+                if (basename)
+                        len = snprintf (buf, maxlen, "%s/%s", entry->path,
+                                        basename);
+                else
+                        len = snprintf (buf, maxlen, "%s", entry->path);
+        }
+unlock:
+        UNLOCK (&cache->lock);
+
+        return len;
+}
+
+
+static void
+posix_handle_cache_add (xlator_t *this, uuid_t gfid, const char *path,
+                        int len, uint64_t generation)
+{
+        struct posix_private            *priv    = NULL;
+        struct posix_handle_cache       *cache   = NULL;
+        struct posix_handle_cache_entry *entry   = NULL;
+        struct posix_handle_cache_entry *victim  = NULL;
+        struct posix_handle_cache_entry *discard = NULL;
+
+        priv  = this->private;
+        cache = priv->handle_cache;
+        if (!cache)
+                return;
+
+        entry = GF_CALLOC (1, sizeof (*entry),
+                           gf_posix_mt_handle_cache_entry);
+        if (!entry)
+                return;
+
+        entry->path = GF_CALLOC (1, len + 1, gf_posix_mt_char);
+        if (!entry->path) {
+                GF_FREE (entry);
+                return;
+        }
+
+        memcpy (entry->path, path, len);
+        entry->len = len;
+        uuid_copy (entry->gfid, gfid);
+        INIT_LIST_HEAD (&entry->hash);
+        INIT_LIST_HEAD (&entry->lru);
+
+#ifdef O_PATH
+        entry->fd = open (entry->path, O_PATH | O_DIRECTORY);
+#else
+        entry->fd = -1;
+#endif
+
+        LOCK (&cache->lock);
+        {
+                /* only directories are pumped, and cached */
+                cache->misses++;
+
+                if ((generation != cache->generation) ||
+                    __posix_handle_cache_find (cache, gfid)) {
+                        discard = entry;
+                        goto unlock;
+                }
+
+                if (cache->count >= cache->limit) {
+                        victim = list_entry (cache->lru.prev,
+                                             struct posix_handle_cache_entry,
+                                             lru);
+                        victim = __posix_handle_cache_unlink (cache, victim);
+                }
+
+                list_add (&entry->hash, posix_handle_cache_bucket (cache,
+                                                                   gfid));
+                list_add (&entry->lru, &cache->lru);
+                cache->count++;
+        }
+unlock:
+        UNLOCK (&cache->lock);
+
+        if (discard)
+                posix_handle_cache_entry_free (discard);
+        if (victim)
+                posix_handle_cache_entry_free (victim);
+}
+
+
+void
+posix_handle_cache_forget (xlator_t *this, uuid_t gfid)
+{
+        struct posix_private            *priv  = NULL;
+        struct posix_handle_cache       *cache = NULL;
+        struct posix_handle_cache_entry *entry = NULL;
+
+        priv  = this->private;
+        cache = priv->handle_cache;
+        if (!cache)
+                return;
+
+        LOCK (&cache->lock);
+        {
+                cache->generation++;
+
+                entry = __posix_handle_cache_find (cache, gfid);
+                if (entry)
+                        entry = __posix_handle_cache_unlink (cache, entry);
+        }
+        UNLOCK (&cache->lock);
+
+        if (entry)
+                posix_handle_cache_entry_free (entry);
+}
+
+
+void
+posix_handle_cache_flush (xlator_t *this)
+{
+        struct posix_private            *priv  = NULL;
+        struct posix_handle_cache       *cache = NULL;
+        struct posix_handle_cache_entry *entry = NULL;
+        struct posix_handle_cache_entry *tmp   = NULL;
+        struct list_head                 freed;
+
+        priv  = this->private;
+        cache = priv->handle_cache;
+        if (!cache)
+                return;
+
+        INIT_LIST_HEAD (&freed);
+
+        LOCK (&cache->lock);
+        {
+                cache->generation++;
+
+                list_for_each_entry_safe (entry, tmp, &cache->lru, lru) {
+                        if (__posix_handle_cache_unlink (cache, entry))
+                                list_add (&entry->lru, &freed);
+                }
+        }
+        UNLOCK (&cache->lock);
+
+        list_for_each_entry_safe (entry, tmp, &freed, lru)
+                posix_handle_cache_entry_free (entry);
+}
+
+
+/* lstat() of the handle of gfid, or of basename in it, relative to the
+   cached fd of the directory: 1 when gfid has no cached fd */
+int
+posix_handle_cache_stat (xlator_t *this, uuid_t gfid, const char *basename,
+                         struct stat *stbuf)
+{
+#ifdef O_PATH
+        struct posix_private            *priv  = NULL;
+        struct posix_handle_cache       *cache = NULL;
+        struct posix_handle_cache_entry *entry = NULL;
+        int                              ret   = 1;
+
+        priv  = this->private;
+        cache = priv->handle_cache;
+        if (!cache)
+                return 1;
+
+        LOCK (&cache->lock);
+        {
+                entry = __posix_handle_cache_find (cache, gfid);
+                if (entry && entry->fd != -1)
+                        entry->ref++;
+                else
+                        entry = NULL;
+        }
+        UNLOCK (&cache->lock);
+
+        if (!entry)
+                return 1;
+
+        if (basename)
+                ret = fstatat (entry->fd, basename, stbuf,
+                               AT_SYMLINK_NOFOLLOW);
+        else
+                ret = fstatat (entry->fd, "", stbuf, AT_EMPTY_PATH);
+
+        LOCK (&cache->lock);
+        {
+                if (--entry->ref || !entry->dead)
+                        entry = NULL;
+        }
+        UNLOCK (&cache->lock);
+
+        if (entry)
+                posix_handle_cache_entry_free (entry);
+
+        return ret;
+#else
+        return 1;
+#endif
+}
+
+
 /*
   posix_handle_path differs from posix_handle_gfid_path in the way that the
   path filled in @buf by posix_handle_path will return type IA_IFDIR when
@@ -182,11 +518,11 @@ posix_handle_path (xlator_t *this, uuid_t gfid, const char *basename,
         int                   pfx_len;
         int                   maxlen;
         char                 *buf;
+        uint64_t              generation = 0;
+        int                   dir_len = 0;
 
         priv = this->private;
 
-        uuid_str = uuid_utoa (gfid);
-
         if (ubuf) {
                 buf = ubuf;
                 maxlen = size;
@@ -195,6 +531,13 @@ posix_handle_path (xlator_t *this, uuid_t gfid, const char *basename,
                 buf = alloca (maxlen);
         }
 
+        len = posix_handle_cache_path (this, gfid, basename, buf, maxlen,
+                                       &generation);
+        if (len >= 0)
+                goto out;
+
+        uuid_str = uuid_utoa (gfid);
+
         base_len = (priv->base_path_length + SLEN(HANDLE_PFX) + 45);
         base_str = alloca (base_len + 1);
         base_len = snprintf (base_str, base_len + 1, "%s/%s/%02x/%02x/%s",
@@ -226,6 +569,12 @@ posix_handle_path (xlator_t *this, uuid_t gfid, const char *basename,
                 ret = lstat (buf, &stat);
         } while ((ret == -1) && errno == ELOOP);
 
+        if (ret == 0 && len < maxlen) {
+                dir_len = strlen (buf);
+                if (basename)
+                        dir_len -= (strlen (basename) + 1);
+                posix_handle_cache_add (this, gfid, buf, dir_len, generation);
+        }
 out:
         return len + 1;
 }
@@ -568,6 +917,8 @@ posix_handle_unset_gfid (xlator_t *this, uuid_t gfid)
         int          ret = 0;
         struct stat  stat;
 
+        posix_handle_cache_forget (this, gfid);
+
         MAKE_HANDLE_GFID_PATH (path, this, gfid, NULL);
 
         ret = lstat (path, &stat);
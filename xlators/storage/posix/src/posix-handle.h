@@ -26,9 +26,41 @@
 #endif
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #include "xlator.h"
 
 
+/* buckets of the gfid to handle path cache of directories */
+#define POSIX_HANDLE_CACHE_BUCKETS 1024
+#define POSIX_HANDLE_CACHE_DEFAULT 4096
+
+/**
+ * posix_handle_cache_entry - resolved handle of a directory: the path
+ *     posix_handle_path() gives once the symlink handles are pumped, and an
+ *     O_PATH fd of the directory when the platform has O_PATH.
+ */
+struct posix_handle_cache_entry {
+        struct list_head  hash;
+        struct list_head  lru;
+        uuid_t            gfid;
+        char             *path;
+        int               len;
+        int               fd;
+        int               ref;
+        gf_boolean_t      dead;
+};
+
+struct posix_handle_cache {
+        gf_lock_t         lock;
+        struct list_head  buckets[POSIX_HANDLE_CACHE_BUCKETS];
+        struct list_head  lru;
+        uint32_t          count;
+        uint32_t          limit;
+        uint64_t          generation;
+        uint64_t          hits;
+        uint64_t          misses;
+};
+
 #define LOC_HAS_ABSPATH(loc) ((loc) && (loc->path) && (loc->path[0] == '/'))
 
 #define MAKE_REAL_PATH(var, this, path) do {                            \
@@ -145,4 +177,12 @@ int posix_handle_mkdir_hashes (xlator_t *this, const char *newpath);
 
 int posix_handle_init (xlator_t *this);
 
+struct posix_handle_cache *posix_handle_cache_new (xlator_t *this,
+                                                   uint32_t limit);
+void posix_handle_cache_destroy (struct posix_handle_cache *cache);
+void posix_handle_cache_forget (xlator_t *this, uuid_t gfid);
+void posix_handle_cache_flush (xlator_t *this);
+int posix_handle_cache_stat (xlator_t *this, uuid_t gfid,
+                             const char *basename, struct stat *stbuf);
+
 #endif /* !_POSIX_HANDLE_H */
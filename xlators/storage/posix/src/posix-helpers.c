@@ -43,6 +43,8 @@
 #include "dict.h"
 #include "logging.h"
 #include "posix.h"
+#include "posix-xattrop.h"
+#include "posix-pack.h"
 #include "xlator.h"
 #include "defaults.h"
 #include "common-utils.h"
@@ -63,6 +65,8 @@ typedef struct {
         dict_t      *xattr;
         struct iatt *stbuf;
         loc_t       *loc;
+        dict_t      *cache;
+        gf_boolean_t cache_tried;
 } posix_xattr_filler_t;
 
 static char* posix_ignore_xattrs[] = {
@@ -95,6 +99,269 @@ out:
         return ignore;
 }
 
+
+/*
+  The trusted.* and system.* xattrs of an inode are read in one pass (one
+  llistxattr and a getxattr per name) and kept in the inode ctx, lookups
+  asking for keys of these namespaces are then answered without syscalls.
+
+  The cache is dropped by every fop of posix which changes the xattrs or
+  the mode (which may change the ACL) of the inode, and is only used while
+  the ctime and gfid of the inode are the ones it was read with, which
+  also catches changes made behind the back of posix. The generation
+  keeps a read which raced with a change from being cached.
+*/
+
+static gf_boolean_t
+posix_xattr_cacheable (const char *key)
+{
+        return (!strncmp (key, "trusted.", 8) ||
+                !strncmp (key, "system.", 7));
+}
+
+
+static struct posix_xattr_cache *
+__posix_xattr_cache_ctx (xlator_t *this, inode_t *inode, gf_boolean_t create)
+{
+        struct posix_xattr_cache *cache = NULL;
+        uint64_t                  tmp   = 0;
+
+        if (__inode_ctx_get (inode, this, &tmp) == 0)
+                return (struct posix_xattr_cache *)(long) tmp;
+
+        if (!create)
+                return NULL;
+
+        cache = GF_CALLOC (1, sizeof (*cache), gf_posix_mt_xattr_cache);
+        if (!cache)
+                return NULL;
+
+        if (__inode_ctx_put (inode, this, (uint64_t)(long) cache)) {
+                GF_FREE (cache);
+                return NULL;
+        }
+
+        return cache;
+}
+
+
+void
+posix_xattr_cache_free (struct posix_xattr_cache *cache)
+{
+        if (!cache)
+                return;
+
+        if (cache->xattrs)
+                dict_unref (cache->xattrs);
+        GF_FREE (cache);
+}
+
+
+void
+posix_xattr_cache_invalidate (xlator_t *this, inode_t *inode)
+{
+        struct posix_private     *priv   = NULL;
+        struct posix_xattr_cache *cache  = NULL;
+        dict_t                   *xattrs = NULL;
+
+        if (!this || !inode)
+                return;
+
+        priv = this->private;
+        if (!priv->xattr_cache)
+                return;
+
+        LOCK (&inode->lock);
+        {
+                /* created if missing, for the generation to move */
+                cache = __posix_xattr_cache_ctx (this, inode, _gf_true);
+                if (cache) {
+                        cache->generation++;
+                        xattrs = cache->xattrs;
+                        cache->xattrs = NULL;
+                }
+        }
+        UNLOCK (&inode->lock);
+
+        if (xattrs)
+                dict_unref (xattrs);
+}
+
+
+/* reads all the cacheable xattrs of real_path, NULL when they do not fit
+   in the bounds of the cache */
+static dict_t *
+posix_xattr_cache_read (xlator_t *this, const char *real_path)
+{
+        char     list[POSIX_XATTR_CACHE_MAX_SIZE];
+        char     value[POSIX_XATTR_CACHE_MAX_SIZE];
+        char    *key    = NULL;
+        char    *copy   = NULL;
+        dict_t  *xattrs = NULL;
+        ssize_t  size   = 0;
+        ssize_t  vsize  = 0;
+        ssize_t  total  = 0;
+        int      ret    = -1;
+
+        size = sys_llistxattr (real_path, list, sizeof (list));
+        if (size < 0)
+                goto out;
+
+        xattrs = dict_new ();
+        if (!xattrs)
+                goto out;
+
+        for (key = list; key < list + size; key += strlen (key) + 1) {
+                if (!posix_xattr_cacheable (key))
+                        continue;
+
+                vsize = sys_lgetxattr (real_path, key, value, sizeof (value));
+                if (vsize == -1) {
+                        /* removed since the listing */
+                        if (errno == ENODATA || errno == ENOATTR)
+                                continue;
+                        goto out;
+                }
+
+                total += vsize;
+                if (total > POSIX_XATTR_CACHE_MAX_SIZE)
+                        goto out;
+
+                copy = GF_CALLOC (1, vsize + 1, gf_posix_mt_char);
+                if (!copy)
+                        goto out;
+                memcpy (copy, value, vsize);
+
+                if (dict_set_bin (xattrs, key, copy, vsize)) {
+                        GF_FREE (copy);
+                        goto out;
+                }
+        }
+
+        ret = 0;
+out:
+        if (ret && xattrs) {
+                dict_unref (xattrs);
+                xattrs = NULL;
+        }
+
+        return xattrs;
+}
+
+
+/* the cached xattrs of the inode, read now if they are missing or stale;
+   buf is the stat of the inode taken before */
+static dict_t *
+posix_xattr_cache_get (xlator_t *this, inode_t *inode, const char *real_path,
+                       struct iatt *buf)
+{
+        struct posix_private     *priv       = NULL;
+        struct posix_xattr_cache *cache      = NULL;
+        dict_t                   *xattrs     = NULL;
+        dict_t                   *old        = NULL;
+        uint64_t                  generation = 0;
+
+        priv = this->private;
+
+        LOCK (&inode->lock);
+        {
+                cache = __posix_xattr_cache_ctx (this, inode, _gf_false);
+                if (cache) {
+                        generation = cache->generation;
+                        if (cache->xattrs &&
+                            (cache->ctime == buf->ia_ctime) &&
+                            (cache->ctime_nsec == buf->ia_ctime_nsec) &&
+                            !uuid_compare (cache->gfid, buf->ia_gfid))
+                                xattrs = dict_ref (cache->xattrs);
+                }
+        }
+        UNLOCK (&inode->lock);
+
+        if (xattrs) {
+                LOCK (&priv->lock);
+                {
+                        priv->xattr_cache_hits++;
+                }
+                UNLOCK (&priv->lock);
+                return xattrs;
+        }
+
+        LOCK (&priv->lock);
+        {
+                priv->xattr_cache_misses++;
+        }
+        UNLOCK (&priv->lock);
+
+        xattrs = posix_xattr_cache_read (this, real_path);
+        if (!xattrs)
+                return NULL;
+
+        LOCK (&inode->lock);
+        {
+                cache = __posix_xattr_cache_ctx (this, inode, _gf_true);
+                if (cache && (cache->generation == generation)) {
+                        old = cache->xattrs;
+                        cache->xattrs     = dict_ref (xattrs);
+                        cache->ctime      = buf->ia_ctime;
+                        cache->ctime_nsec = buf->ia_ctime_nsec;
+                        uuid_copy (cache->gfid, buf->ia_gfid);
+                }
+        }
+        UNLOCK (&inode->lock);
+
+        if (old)
+                dict_unref (old);
+
+        return xattrs;
+}
+
+
+static int
+posix_xattr_cache_fill (posix_xattr_filler_t *filler, char *key)
+{
+        struct posix_private *priv  = NULL;
+        data_t               *data  = NULL;
+        char                 *value = NULL;
+
+        priv = filler->this->private;
+
+        if (!priv->xattr_cache || !posix_xattr_cacheable (key) ||
+            !filler->loc || !filler->loc->inode)
+                return -1;
+
+        if (!filler->cache_tried) {
+                filler->cache_tried = _gf_true;
+                filler->cache = posix_xattr_cache_get (filler->this,
+                                                       filler->loc->inode,
+                                                       filler->real_path,
+                                                       filler->stbuf);
+        }
+
+        if (!filler->cache)
+                return -1;
+
+        /* not in the cache: the inode does not have it */
+        data = dict_get (filler->cache, key);
+        if (!data)
+                return 0;
+
+        value = GF_CALLOC (1, data->len + 1, gf_posix_mt_char);
+        if (!value)
+                return 0;
+        memcpy (value, data->data, data->len);
+
+        if (dict_set_bin (filler->xattr, key, value, data->len) < 0) {
+                GF_FREE (value);
+                gf_log (filler->this->name, GF_LOG_DEBUG,
+                        "dict set failed. path: %s, key: %s",
+                        filler->real_path, key);
+        }
+
+        return 0;
+}
+
+
+
 static void
 _posix_xattr_get_set (dict_t *xattr_req,
                       char *key,
@@ -183,6 +450,8 @@ _posix_xattr_get_set (dict_t *xattr_req,
                                         "Failed to set dictionary value for %s",
                                         key);
                 }
+        } else if (posix_xattr_cache_fill (filler, key) == 0) {
+                ;
         } else {
                 xattr_size = sys_lgetxattr (filler->real_path, key, NULL, 0);
 
@@ -308,7 +577,14 @@ posix_istat (xlator_t *this, uuid_t gfid, const char *basename,
 
         MAKE_HANDLE_PATH (real_path, this, gfid, basename);
 
-        ret = lstat (real_path, &lstatbuf);
+        ret = posix_handle_cache_stat (this, gfid, basename, &lstatbuf);
+        if (ret == 1)
+                ret = lstat (real_path, &lstatbuf);
+
+        /* a packed file is needed as a regular one from now on */
+        if ((ret == -1) && (errno == ENOENT) && priv->pack &&
+            (posix_pack_spill (this, gfid, basename) == 0))
+                ret = lstat (real_path, &lstatbuf);
 
         if (ret == -1) {
                 if (errno != ENOENT && errno != ELOOP)
@@ -396,6 +672,7 @@ posix_lookup_xattr_fill (xlator_t *this, const char *real_path, loc_t *loc,
                          dict_t *xattr_req, struct iatt *buf)
 {
         dict_t     *xattr             = NULL;
+        dict_t     *pending           = NULL;
         posix_xattr_filler_t filler   = {0, };
 
         xattr = get_new_dict();
@@ -403,6 +680,10 @@ posix_lookup_xattr_fill (xlator_t *this, const char *real_path, loc_t *loc,
                 goto out;
         }
 
+        /* xattrops not flushed yet, taken before the disk is read as the
+           flush thread may set them there and forget them meanwhile */
+        pending = posix_xattrop_snapshot (this, buf->ia_gfid, xattr_req);
+
         filler.this      = this;
         filler.real_path = real_path;
         filler.xattr     = xattr;
@@ -410,6 +691,14 @@ posix_lookup_xattr_fill (xlator_t *this, const char *real_path, loc_t *loc,
         filler.loc       = loc;
 
         dict_foreach (xattr_req, _posix_xattr_get_set, &filler);
+
+        if (pending) {
+                dict_copy (pending, xattr);
+                dict_unref (pending);
+        }
+
+        if (filler.cache)
+                dict_unref (filler.cache);
 out:
         return xattr;
 }
@@ -445,6 +734,7 @@ posix_gfid_set (xlator_t *this, const char *path, loc_t *loc, dict_t *xattr_req)
         }
 
         ret = sys_lsetxattr (path, GFID_XATTR_KEY, uuid_req, 16, XATTR_CREATE);
+        posix_xattr_cache_invalidate (this, loc->inode);
         if (ret != 0) {
                 gf_log (this->name, GF_LOG_WARNING,
                         "setting GFID on %s failed (%s)", path,
@@ -714,10 +1004,35 @@ out:
 }
 
 
+/* the handle of an entry of the trash goes with its last name */
+static void
+janitor_handle_unset (xlator_t *this, const char *fpath,
+                      const struct stat *sb)
+{
+        uuid_t gfid = {0, };
+
+        if (!S_ISDIR (sb->st_mode) && (sb->st_nlink > 2))
+                return;
+
+        if (sys_lgetxattr (fpath, GFID_XATTR_KEY, gfid, 16) != 16)
+                return;
+
+        if (S_ISDIR (sb->st_mode))
+                posix_pack_drop_dir (this, gfid);
+
+        posix_handle_unset (this, gfid, NULL);
+}
+
+
 static int
 janitor_walker (const char *fpath, const struct stat *sb,
                 int typeflag, struct FTW *ftwbuf)
 {
+        struct posix_private *priv = NULL;
+        int                   ret  = -1;
+
+        priv = THIS->private;
+
         switch (sb->st_mode & S_IFMT) {
         case S_IFREG:
         case S_IFBLK:
@@ -727,7 +1042,8 @@ janitor_walker (const char *fpath, const struct stat *sb,
         case S_IFSOCK:
                 gf_log (THIS->name, GF_LOG_TRACE,
                         "unlinking %s", fpath);
-                unlink (fpath);
+                janitor_handle_unset (THIS, fpath, sb);
+                ret = unlink (fpath);
                 break;
 
         case S_IFDIR:
@@ -735,11 +1051,20 @@ janitor_walker (const char *fpath, const struct stat *sb,
                         gf_log (THIS->name, GF_LOG_TRACE,
                                 "removing directory %s", fpath);
 
-                        rmdir (fpath);
+                        janitor_handle_unset (THIS, fpath, sb);
+                        ret = rmdir (fpath);
                 }
                 break;
         }
 
+        if (ret == 0) {
+                pthread_mutex_lock (&priv->janitor_lock);
+                {
+                        priv->janitor_removed++;
+                }
+                pthread_mutex_unlock (&priv->janitor_lock);
+        }
+
         return 0;   /* 0 = FTW_CONTINUE */
 }
 
@@ -757,6 +1082,9 @@ janitor_get_next_fd (xlator_t *this)
         pthread_mutex_lock (&priv->janitor_lock);
         {
                 if (list_empty (&priv->janitor_fds)) {
+                        if (priv->janitor_trash_pending)
+                                goto unlock;
+
                         time (&timeout.tv_sec);
                         timeout.tv_sec += priv->janitor_sleep_duration;
                         timeout.tv_nsec = 0;
@@ -785,6 +1113,7 @@ posix_janitor_thread_proc (void *data)
         xlator_t *            this = NULL;
         struct posix_private *priv = NULL;
         struct posix_fd *pfd;
+        uint64_t pending = 0;
 
         time_t now;
 
@@ -794,8 +1123,16 @@ posix_janitor_thread_proc (void *data)
         THIS = this;
 
         while (1) {
+                pthread_mutex_lock (&priv->janitor_lock);
+                {
+                        pending = priv->janitor_trash_pending;
+                }
+                pthread_mutex_unlock (&priv->janitor_lock);
+
+                /* trees removed with rmdir are deleted right away */
                 time (&now);
-                if ((now - priv->last_landfill_check) > priv->janitor_sleep_duration) {
+                if (pending ||
+                    (now - priv->last_landfill_check) > priv->janitor_sleep_duration) {
                         gf_log (this->name, GF_LOG_TRACE,
                                 "janitor cleaning out /" GF_REPLICATE_TRASH_DIR);
 
@@ -805,6 +1142,14 @@ posix_janitor_thread_proc (void *data)
                               FTW_DEPTH | FTW_PHYS);
 
                         priv->last_landfill_check = now;
+
+                        posix_pack_compact (this);
+
+                        pthread_mutex_lock (&priv->janitor_lock);
+                        {
+                                priv->janitor_trash_pending -= pending;
+                        }
+                        pthread_mutex_unlock (&priv->janitor_lock);
                 }
 
                 pfd = janitor_get_next_fd (this);
@@ -998,14 +1343,34 @@ out:
 int
 posix_fd_ctx_get (fd_t *fd, xlator_t *this, struct posix_fd **pfd)
 {
-        int   ret;
+        struct posix_private *priv  = NULL;
+        int                   ret   = 0;
+        int                   retry = 1;
 
+        priv = this->private;
+again:
         LOCK (&fd->inode->lock);
         {
                 ret = __posix_fd_ctx_get (fd, this, pfd);
         }
         UNLOCK (&fd->inode->lock);
 
+        if (!priv->pack)
+                return ret;
+
+        /* the file of an anonymous fd may be packed */
+        if ((ret < 0) && (errno == ENOENT) && retry--) {
+                if (posix_pack_spill (this, fd->inode->gfid, NULL) == 0)
+                        goto again;
+        }
+
+        /* fops without a packed version get a regular file */
+        if ((ret == 0) && *pfd && (*pfd)->pack &&
+            posix_pack_fd_unpack (this, fd, *pfd)) {
+                errno = EIO;
+                ret = -EIO;
+        }
+
         return ret;
 }
 
@@ -1017,3 +1382,68 @@ posix_fd_ctx_get_off (fd_t *fd, xlator_t *this, struct posix_fd **pfd,
         return posix_fd_ctx_get (fd, this, pfd);
 }
 
+
+
+/* Sets GF_XATTR_DATA_EXTENTS_KEY in @dict to the data extents of @fd,
+ * found with SEEK_DATA and SEEK_HOLE. A file which is a hole up to its end
+ * is reported as one empty extent at its end. */
+int
+posix_fd_data_extents (xlator_t *this, int fd, dict_t *dict)
+{
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+        struct stat  stbuf   = {0, };
+        uint64_t    *extents = NULL;
+        off_t        data    = 0;
+        off_t        hole    = 0;
+        int          count   = 0;
+        int          ret     = -1;
+
+        if (fstat (fd, &stbuf))
+                return -errno;
+
+        extents = GF_CALLOC (2 * GF_DATA_EXTENTS_MAX, sizeof (*extents),
+                             gf_posix_mt_char);
+        if (!extents)
+                return -ENOMEM;
+
+        while (hole < stbuf.st_size) {
+                data = lseek (fd, hole, SEEK_DATA);
+                if (data == -1) {
+                        if (errno == ENXIO)
+                                break; /* a hole up to the end */
+                        ret = -errno;
+                        goto out;
+                }
+
+                hole = lseek (fd, data, SEEK_HOLE);
+                if (hole == -1) {
+                        ret = -errno;
+                        goto out;
+                }
+
+                if (count == GF_DATA_EXTENTS_MAX - 1)
+                        hole = max (hole, stbuf.st_size);
+
+                extents[2 * count]     = hton64 (data);
+                extents[2 * count + 1] = hton64 (hole - data);
+                count++;
+        }
+
+        if (!count) {
+                extents[0] = hton64 (stbuf.st_size);
+                extents[1] = 0;
+                count = 1;
+        }
+
+        ret = dict_set_dynptr (dict, GF_XATTR_DATA_EXTENTS_KEY, extents,
+                               2 * count * sizeof (*extents));
+        if (ret)
+                goto out;
+        extents = NULL;
+out:
+        GF_FREE (extents);
+        return ret;
+#else
+        return -ENOTSUP;
+#endif
+}
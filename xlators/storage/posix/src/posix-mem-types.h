@@ -30,6 +30,18 @@ enum gf_posix_mem_types_ {
         gf_posix_mt_int32_t,
         gf_posix_mt_posix_dev_t,
         gf_posix_mt_trash_path,
+        gf_posix_mt_paiocb,
+        gf_posix_mt_handle_cache,
+        gf_posix_mt_handle_cache_entry,
+        gf_posix_mt_xattr_cache,
+        gf_posix_mt_xattrop_table,
+        gf_posix_mt_xattrop_entry,
+        gf_posix_mt_xattrop_flush,
+        gf_posix_mt_readdirp_pool,
+        gf_posix_mt_pack_table,
+        gf_posix_mt_pack_entry,
+        gf_posix_mt_pack_dir,
+        gf_posix_mt_pack_container,
         gf_posix_mt_end
 };
 #endif
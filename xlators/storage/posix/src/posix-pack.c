@@ -0,0 +1,3285 @@
+/*
+   Copyright (c) 2012 Gluster, Inc. <http://www.gluster.com>
+   This file is part of GlusterFS.
+
+   GlusterFS is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 3 of the License,
+   or (at your option) any later version.
+
+   GlusterFS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see
+   <http://www.gnu.org/licenses/>.
+*/
+
+
+/* Packed small files: a regular file created with a gfid is not created
+   on the filesystem of the brick but kept in memory, and its data is
+   appended to a container file each time it is written. What makes it
+   up is recorded in an append-only index, one record per change, which
+   is replayed at init. A file costs no inode, handle or xattr of its own
+   until it grows past the threshold or a fop posix has no packed version
+   of is done on it: then it is spilled, written out as the regular file
+   it would have been, and posix goes on as if it always was one.
+
+   The packed versions of the fops answer from the entry, under the lock
+   of the table. The data is read from and written to the containers out
+   of it. Containers whose data is mostly superseded are compacted by the
+   janitor, the index is rewritten when it is mostly superseded
+   records. */
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "posix.h"
+#include "posix-handle.h"
+#include "posix-pack.h"
+#include "xlator.h"
+#include "common-utils.h"
+#include "compat.h"
+#include "compat-errno.h"
+#include "hashfn.h"
+#include "syscall.h"
+#include "glusterfs3-xdr.h"
+
+#define POSIX_PACK_MAGIC        0x5041434b   /* "PACK" */
+
+#define POSIX_PACK_PUT          1
+#define POSIX_PACK_DEL          2
+
+/* bound of the serialized xattrs of a packed file, it is spilled past */
+#define POSIX_PACK_XATTR_MAX    (64 * 1024)
+#define POSIX_PACK_REPLAY_CHUNK (1024 * 1024)
+
+/* a PUT record is followed by the name, with its '\0', and the xattrs,
+   each a posix_pack_xattr followed by the key with its '\0' and the
+   value. A DEL record has only the gfid. */
+struct posix_pack_record {
+        uint32_t magic;
+        uint32_t op;
+        uuid_t   gfid;
+        uuid_t   pargfid;
+        uint32_t container;
+        uint64_t offset;
+        uint64_t size;
+        uint32_t mode;
+        uint32_t uid;
+        uint32_t gid;
+        uint32_t atime;
+        uint32_t atime_nsec;
+        uint32_t mtime;
+        uint32_t mtime_nsec;
+        uint32_t ctime;
+        uint32_t ctime_nsec;
+        uint32_t namelen;
+        uint32_t xattrlen;
+} __attribute__ ((packed));
+
+struct posix_pack_xattr {
+        uint32_t keylen;
+        uint32_t vallen;
+} __attribute__ ((packed));
+
+
+static uint32_t
+posix_pack_gfid_hash (uuid_t gfid)
+{
+        return (gfid[12] << 24) | (gfid[13] << 16) | (gfid[14] << 8) |
+                gfid[15];
+}
+
+
+static uint32_t
+posix_pack_name_hash (uuid_t pargfid, const char *name)
+{
+        return posix_pack_gfid_hash (pargfid) ^
+                gf_dm_hashfn (name, strlen (name));
+}
+
+
+static struct posix_pack_entry *
+__posix_pack_get (struct posix_pack_table *table, uuid_t gfid)
+{
+        struct posix_pack_entry *entry = NULL;
+        struct list_head        *head  = NULL;
+
+        head = &table->gfids[posix_pack_gfid_hash (gfid) % POSIX_PACK_BUCKETS];
+
+        list_for_each_entry (entry, head, hash) {
+                if (uuid_compare (entry->gfid, gfid) == 0)
+                        return entry;
+        }
+
+        return NULL;
+}
+
+
+static struct posix_pack_entry *
+__posix_pack_get_name (struct posix_pack_table *table, uuid_t pargfid,
+                       const char *name)
+{
+        struct posix_pack_entry *entry = NULL;
+        struct list_head        *head  = NULL;
+
+        head = &table->names[posix_pack_name_hash (pargfid, name) %
+                             POSIX_PACK_BUCKETS];
+
+        list_for_each_entry (entry, head, name) {
+                if ((uuid_compare (entry->pargfid, pargfid) == 0) &&
+                    (strcmp (entry->basename, name) == 0))
+                        return entry;
+        }
+
+        return NULL;
+}
+
+
+static struct posix_pack_dir *
+__posix_pack_dir_get (struct posix_pack_table *table, uuid_t gfid,
+                      gf_boolean_t create)
+{
+        struct posix_pack_dir *dir  = NULL;
+        struct list_head      *head = NULL;
+
+        head = &table->dirs[posix_pack_gfid_hash (gfid) % POSIX_PACK_BUCKETS];
+
+        list_for_each_entry (dir, head, hash) {
+                if (uuid_compare (dir->gfid, gfid) == 0)
+                        return dir;
+        }
+
+        if (!create)
+                return NULL;
+
+        dir = GF_CALLOC (1, sizeof (*dir), gf_posix_mt_pack_dir);
+        if (!dir)
+                return NULL;
+
+        INIT_LIST_HEAD (&dir->entries);
+        uuid_copy (dir->gfid, gfid);
+        list_add_tail (&dir->hash, head);
+
+        return dir;
+}
+
+
+static struct posix_pack_container *
+__posix_pack_container_get (struct posix_pack_table *table, uint32_t id)
+{
+        struct posix_pack_container *container = NULL;
+
+        list_for_each_entry (container, &table->containers, list) {
+                if (container->id == id)
+                        return container;
+        }
+
+        return NULL;
+}
+
+
+static struct posix_pack_entry *
+__posix_pack_entry_new (struct posix_pack_table *table, uuid_t gfid,
+                        uuid_t pargfid, const char *name)
+{
+        struct posix_pack_entry *entry = NULL;
+        struct posix_pack_dir   *dir   = NULL;
+
+        dir = __posix_pack_dir_get (table, pargfid, _gf_true);
+        if (!dir)
+                return NULL;
+
+        entry = GF_CALLOC (1, sizeof (*entry), gf_posix_mt_pack_entry);
+        if (!entry)
+                goto err;
+
+        entry->basename = gf_strdup (name);
+        entry->xattrs = dict_new ();
+        if (!entry->basename || !entry->xattrs)
+                goto err;
+
+        uuid_copy (entry->gfid, gfid);
+        uuid_copy (entry->pargfid, pargfid);
+        entry->seq = ++table->seq;
+        entry->state = POSIX_PACK_LIVE;
+        entry->ref = 1;
+
+        list_add_tail (&entry->hash, &table->gfids[posix_pack_gfid_hash (gfid)
+                                                   % POSIX_PACK_BUCKETS]);
+        list_add_tail (&entry->name,
+                       &table->names[posix_pack_name_hash (pargfid, name) %
+                                     POSIX_PACK_BUCKETS]);
+        list_add_tail (&entry->list, &dir->entries);
+        table->count++;
+
+        return entry;
+err:
+        if (entry) {
+                if (entry->basename)
+                        GF_FREE (entry->basename);
+                if (entry->xattrs)
+                        dict_unref (entry->xattrs);
+                GF_FREE (entry);
+        }
+        if (list_empty (&dir->entries)) {
+                list_del (&dir->hash);
+                GF_FREE (dir);
+        }
+
+        return NULL;
+}
+
+
+static void
+__posix_pack_entry_unref (struct posix_pack_entry *entry)
+{
+        if (--entry->ref)
+                return;
+
+        if (entry->buf)
+                GF_FREE (entry->buf);
+        dict_unref (entry->xattrs);
+        GF_FREE (entry->basename);
+        GF_FREE (entry);
+}
+
+
+/* takes entry out of the table, with the reference the table has */
+static void
+__posix_pack_entry_remove (struct posix_pack_table *table,
+                           struct posix_pack_entry *entry,
+                           enum posix_pack_state state)
+{
+        struct posix_pack_dir *dir = NULL;
+
+        if (entry->state != POSIX_PACK_LIVE)
+                return;
+
+        list_del_init (&entry->hash);
+        list_del_init (&entry->name);
+        list_del_init (&entry->list);
+        table->count--;
+
+        dir = __posix_pack_dir_get (table, entry->pargfid, _gf_false);
+        if (dir && list_empty (&dir->entries)) {
+                list_del (&dir->hash);
+                GF_FREE (dir);
+        }
+
+        if (entry->container)
+                entry->container->live -= entry->disk_size;
+        entry->container = NULL;
+        entry->disk_size = 0;
+
+        entry->state = state;
+        if (state == POSIX_PACK_SPILLED && entry->buf) {
+                GF_FREE (entry->buf);
+                entry->buf = NULL;
+                entry->buf_size = 0;
+        }
+
+        __posix_pack_entry_unref (entry);
+}
+
+
+static void
+posix_pack_now (uint32_t *sec, uint32_t *nsec)
+{
+        struct timeval tv = {0, };
+
+        gettimeofday (&tv, NULL);
+        *sec  = tv.tv_sec;
+        *nsec = tv.tv_usec * 1000;
+}
+
+
+static void
+posix_pack_iatt (xlator_t *this, struct posix_pack_entry *entry,
+                 struct iatt *iatt)
+{
+        struct posix_private *priv  = NULL;
+        struct stat           stbuf = {0, };
+
+        priv = this->private;
+
+        stbuf.st_dev     = priv->handledir.st_dev;
+        stbuf.st_mode    = S_IFREG | (entry->mode & 07777);
+        stbuf.st_nlink   = 1;
+        stbuf.st_uid     = entry->uid;
+        stbuf.st_gid     = entry->gid;
+        stbuf.st_size    = entry->size;
+        stbuf.st_blksize = 4096;
+        stbuf.st_blocks  = (entry->size + 511) / 512;
+
+        iatt_from_stat (iatt, &stbuf);
+
+        iatt->ia_atime      = entry->atime;
+        iatt->ia_atime_nsec = entry->atime_nsec;
+        iatt->ia_mtime      = entry->mtime;
+        iatt->ia_mtime_nsec = entry->mtime_nsec;
+        iatt->ia_ctime      = entry->ctime;
+        iatt->ia_ctime_nsec = entry->ctime_nsec;
+
+        uuid_copy (iatt->ia_gfid, entry->gfid);
+        posix_fill_ino_from_gfid (this, iatt);
+}
+
+
+/* xattrs a packed file keeps itself, the others are left to posix */
+static gf_boolean_t
+posix_pack_key_native (const char *key)
+{
+        if (!strcmp (key, GFID_XATTR_KEY))
+                return _gf_false;
+
+        if (!strncmp (key, "trusted.glusterfs.", strlen ("trusted.glusterfs.")))
+                return _gf_false;
+
+        return (!strncmp (key, "trusted.", strlen ("trusted.")) ||
+                !strncmp (key, "user.", strlen ("user.")));
+}
+
+
+/* stores a copy of the len bytes of value as key of dict */
+static int
+posix_pack_dict_set (dict_t *dict, char *key, void *value, int len)
+{
+        char *copy = NULL;
+        int   ret  = -1;
+
+        copy = GF_CALLOC (len + 1, sizeof (char), gf_posix_mt_char);
+        if (!copy)
+                return -ENOMEM;
+
+        memcpy (copy, value, len);
+
+        ret = dict_set_bin (dict, key, copy, len);
+        if (ret)
+                GF_FREE (copy);
+
+        return ret;
+}
+
+
+static size_t
+posix_pack_xattrs_size (dict_t *xattrs)
+{
+        data_pair_t *trav = NULL;
+        size_t       len  = 0;
+
+        for (trav = xattrs->members_list; trav; trav = trav->next)
+                len += sizeof (struct posix_pack_xattr) + strlen (trav->key) +
+                        1 + trav->value->len;
+
+        return len;
+}
+
+
+static char *
+posix_pack_xattrs_fill (char *buf, dict_t *xattrs)
+{
+        struct posix_pack_xattr  xattr = {0, };
+        data_pair_t             *trav  = NULL;
+
+        for (trav = xattrs->members_list; trav; trav = trav->next) {
+                xattr.keylen = strlen (trav->key) + 1;
+                xattr.vallen = trav->value->len;
+
+                memcpy (buf, &xattr, sizeof (xattr));
+                buf += sizeof (xattr);
+                memcpy (buf, trav->key, xattr.keylen);
+                buf += xattr.keylen;
+                memcpy (buf, trav->value->data, xattr.vallen);
+                buf += xattr.vallen;
+        }
+
+        return buf;
+}
+
+
+static int
+posix_pack_xattrs_parse (char *buf, size_t len, dict_t *xattrs)
+{
+        struct posix_pack_xattr xattr = {0, };
+        char                   *key   = NULL;
+
+        while (len >= sizeof (xattr)) {
+                memcpy (&xattr, buf, sizeof (xattr));
+                buf += sizeof (xattr);
+                len -= sizeof (xattr);
+
+                if ((len < xattr.keylen + xattr.vallen) || !xattr.keylen)
+                        return -1;
+
+                key = buf;
+                if (key[xattr.keylen - 1] != '\0')
+                        return -1;
+
+                if (posix_pack_dict_set (xattrs, key, buf + xattr.keylen,
+                                         xattr.vallen))
+                        return -1;
+
+                buf += xattr.keylen + xattr.vallen;
+                len -= xattr.keylen + xattr.vallen;
+        }
+
+        return len ? -1 : 0;
+}
+
+
+/* the writes to the index of table are under its index_lock */
+static int
+__posix_pack_index_write (xlator_t *this, struct posix_pack_table *table,
+                          int fd, char *buf, size_t len)
+{
+        ssize_t ret = 0;
+
+        ret = write (fd, buf, len);
+        if (ret != len) {
+                if (ret >= 0)
+                        errno = ENOSPC;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "write to the pack index failed: %s",
+                        strerror (errno));
+                /* a partial record is dropped at replay */
+                return -errno;
+        }
+
+        if (fd == table->index_fd)
+                table->index_size += len;
+
+        return 0;
+}
+
+
+static size_t
+posix_pack_record_size (struct posix_pack_entry *entry)
+{
+        return sizeof (struct posix_pack_record) + strlen (entry->basename) +
+                1 + posix_pack_xattrs_size (entry->xattrs);
+}
+
+
+static char *
+posix_pack_record_fill (char *buf, struct posix_pack_entry *entry, int op)
+{
+        struct posix_pack_record record = {0, };
+
+        record.magic = POSIX_PACK_MAGIC;
+        record.op = op;
+        uuid_copy (record.gfid, entry->gfid);
+
+        if (op == POSIX_PACK_DEL) {
+                memcpy (buf, &record, sizeof (record));
+                return buf + sizeof (record);
+        }
+
+        uuid_copy (record.pargfid, entry->pargfid);
+        record.container  = entry->container ? entry->container->id : 0;
+        record.offset     = entry->offset;
+        record.size       = entry->disk_size;
+        record.mode       = entry->mode;
+        record.uid        = entry->uid;
+        record.gid        = entry->gid;
+        record.atime      = entry->atime;
+        record.atime_nsec = entry->atime_nsec;
+        record.mtime      = entry->mtime;
+        record.mtime_nsec = entry->mtime_nsec;
+        record.ctime      = entry->ctime;
+        record.ctime_nsec = entry->ctime_nsec;
+        record.namelen    = strlen (entry->basename) + 1;
+        record.xattrlen   = posix_pack_xattrs_size (entry->xattrs);
+
+        memcpy (buf, &record, sizeof (record));
+        buf += sizeof (record);
+        memcpy (buf, entry->basename, record.namelen);
+        buf += record.namelen;
+
+        return posix_pack_xattrs_fill (buf, entry->xattrs);
+}
+
+
+/* records entry as it is now (PUT) or its removal (DEL) */
+static int
+__posix_pack_log (xlator_t *this, struct posix_pack_table *table,
+                  struct posix_pack_entry *entry, int op)
+{
+        char   *buf = NULL;
+        size_t  len = 0;
+        int     ret = 0;
+
+        if (op == POSIX_PACK_DEL)
+                len = sizeof (struct posix_pack_record);
+        else
+                len = posix_pack_record_size (entry);
+
+        buf = GF_CALLOC (1, len, gf_posix_mt_char);
+        if (!buf)
+                return -ENOMEM;
+
+        posix_pack_record_fill (buf, entry, op);
+
+        pthread_mutex_lock (&table->index_lock);
+        {
+                ret = __posix_pack_index_write (this, table, table->index_fd,
+                                                buf, len);
+        }
+        pthread_mutex_unlock (&table->index_lock);
+
+        GF_FREE (buf);
+
+        return ret;
+}
+
+
+static struct posix_pack_container *
+posix_pack_container_open (xlator_t *this, struct posix_pack_table *table,
+                           uint32_t id, int flags)
+{
+        struct posix_pack_container *container = NULL;
+        struct stat                  stbuf     = {0, };
+        char                        *path      = NULL;
+        int                          fd        = -1;
+
+        path = alloca (strlen (table->path) + 32);
+        sprintf (path, "%s/container.%08x", table->path, id);
+
+        fd = open (path, O_RDWR | flags, 0600);
+        if (fd == -1) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "opening the pack container %s failed: %s", path,
+                        strerror (errno));
+                return NULL;
+        }
+
+        if (fstat (fd, &stbuf) == -1)
+                goto err;
+
+        container = GF_CALLOC (1, sizeof (*container),
+                               gf_posix_mt_pack_container);
+        if (!container)
+                goto err;
+
+        container->id = id;
+        container->fd = fd;
+        container->size = stbuf.st_size;
+        list_add_tail (&container->list, &table->containers);
+
+        return container;
+err:
+        close (fd);
+        return NULL;
+}
+
+
+static void
+__posix_pack_container_destroy (struct posix_pack_table *table,
+                                struct posix_pack_container *container,
+                                gf_boolean_t remove)
+{
+        char *path = NULL;
+
+        if (remove) {
+                path = alloca (strlen (table->path) + 32);
+                sprintf (path, "%s/container.%08x", table->path,
+                         container->id);
+                unlink (path);
+        }
+
+        if (table->current == container)
+                table->current = NULL;
+
+        list_del (&container->list);
+        close (container->fd);
+        GF_FREE (container);
+}
+
+
+/* makes room for len bytes of data at the end of the current
+   container, which is referenced for the caller to write them */
+static int
+__posix_pack_reserve (xlator_t *this, struct posix_pack_table *table,
+                      size_t len, struct posix_pack_container **container_p,
+                      off_t *off_p)
+{
+        struct posix_pack_container *container = NULL;
+        uint32_t                     id        = 0;
+
+        container = table->current;
+        if (!container ||
+            (container->size && (container->size + len >
+                                 POSIX_PACK_CONTAINER_MAX))) {
+                if (container)
+                        id = container->id;
+                list_for_each_entry (container, &table->containers, list) {
+                        if (container->id > id)
+                                id = container->id;
+                }
+
+                container = posix_pack_container_open (this, table, id + 1,
+                                                       O_CREAT | O_EXCL);
+                if (!container)
+                        return -errno;
+                table->current = container;
+        }
+
+        *container_p = container;
+        *off_p = container->size;
+        container->size += len;
+        container->ref++;
+
+        return 0;
+}
+
+
+static int
+posix_pack_container_write (xlator_t *this,
+                            struct posix_pack_container *container,
+                            char *data, size_t len, off_t offset)
+{
+        ssize_t ret = 0;
+
+        if (!len)
+                return 0;
+
+        ret = pwrite (container->fd, data, len, offset);
+        if (ret != len) {
+                if (ret >= 0)
+                        errno = ENOSPC;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "write to the pack container %08x failed: %s",
+                        container->id, strerror (errno));
+                return -errno;
+        }
+
+        return 0;
+}
+
+
+/* appends len bytes of data to the current container */
+static int
+__posix_pack_append (xlator_t *this, struct posix_pack_table *table,
+                     char *data, size_t len,
+                     struct posix_pack_container **container_p, off_t *off_p)
+{
+        int ret = 0;
+
+        ret = __posix_pack_reserve (this, table, len, container_p, off_p);
+        if (ret)
+                return ret;
+
+        (*container_p)->ref--;
+
+        return posix_pack_container_write (this, *container_p, data, len,
+                                           *off_p);
+}
+
+
+/* reads up to size bytes of the data of entry at offset */
+static ssize_t
+__posix_pack_pread (xlator_t *this, struct posix_pack_entry *entry,
+                    char *buf, size_t size, off_t offset)
+{
+        ssize_t ret = 0;
+
+        if (offset >= entry->size)
+                return 0;
+
+        size = min (size, entry->size - offset);
+
+        if (entry->buf) {
+                memcpy (buf, entry->buf + offset, size);
+                return size;
+        }
+
+        if (!entry->container)
+                return 0;
+
+        ret = pread (entry->container->fd, buf, size, entry->offset + offset);
+        if (ret != size) {
+                if (ret >= 0)
+                        errno = EIO;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "reading %s from the pack container %08x failed: %s",
+                        uuid_utoa (entry->gfid), entry->container->id,
+                        strerror (errno));
+                return -errno;
+        }
+
+        return ret;
+}
+
+
+/* __posix_pack_pread() with the stored data read out of the lock of the
+   table, which the caller does not hold; it has entry referenced */
+static ssize_t
+posix_pack_pread (xlator_t *this, struct posix_pack_table *table,
+                  struct posix_pack_entry *entry, char *buf, size_t size,
+                  off_t offset)
+{
+        struct posix_pack_container *container = NULL;
+        off_t                        off       = 0;
+        ssize_t                      ret       = 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                if (entry->buf || !entry->container ||
+                    (offset >= entry->size)) {
+                        ret = __posix_pack_pread (this, entry, buf, size,
+                                                  offset);
+                        goto unlock;
+                }
+
+                size = min (size, entry->size - offset);
+                off = entry->offset + offset;
+                container = entry->container;
+                container->ref++;
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+
+        if (!container)
+                return ret;
+
+        ret = pread (container->fd, buf, size, off);
+        if (ret != size) {
+                if (ret >= 0)
+                        errno = EIO;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "reading %s from the pack container %08x failed: %s",
+                        uuid_utoa (entry->gfid), container->id,
+                        strerror (errno));
+                ret = -errno;
+        }
+
+        pthread_mutex_lock (&table->lock);
+        {
+                container->ref--;
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        return ret;
+}
+
+
+/* brings the stored data of entry into its buf out of the lock of the
+   table, for the fop about to change it to find it there. What fails is
+   left to __posix_pack_load() to tell. */
+static void
+posix_pack_load (xlator_t *this, struct posix_pack_table *table,
+                 struct posix_pack_entry *entry)
+{
+        struct posix_pack_container *container = NULL;
+        char                        *buf       = NULL;
+        size_t                       size      = 0;
+        size_t                       buf_size  = 0;
+        off_t                        offset    = 0;
+        ssize_t                      ret       = -1;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                if (!entry->buf && entry->container) {
+                        container = entry->container;
+                        container->ref++;
+                        offset = entry->offset;
+                        size = entry->disk_size;
+                }
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (!container)
+                return;
+
+        buf_size = (max (size, 1) + 4095) & ~4095;
+        buf = GF_CALLOC (1, buf_size, gf_posix_mt_char);
+        if (buf)
+                ret = pread (container->fd, buf, size, offset);
+
+        pthread_mutex_lock (&table->lock);
+        {
+                container->ref--;
+                /* the data is where it was, nothing loaded it meanwhile */
+                if ((ret == size) && !entry->buf &&
+                    (entry->container == container) &&
+                    (entry->offset == offset)) {
+                        entry->buf = buf;
+                        entry->buf_size = buf_size;
+                        buf = NULL;
+                }
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (buf)
+                GF_FREE (buf);
+}
+
+
+/* brings the data of entry into its buf, with room for want bytes */
+static int
+__posix_pack_load (xlator_t *this, struct posix_pack_entry *entry,
+                   size_t want)
+{
+        char    *buf  = NULL;
+        size_t   size = 0;
+        ssize_t  ret  = 0;
+
+        size = max (want, entry->size);
+        if (entry->buf && (entry->buf_size >= size))
+                return 0;
+
+        size = (size + 4095) & ~4095;
+
+        buf = GF_CALLOC (1, size, gf_posix_mt_char);
+        if (!buf)
+                return -ENOMEM;
+
+        ret = __posix_pack_pread (this, entry, buf, entry->size, 0);
+        if (ret < 0) {
+                GF_FREE (buf);
+                return ret;
+        }
+
+        if (entry->buf)
+                GF_FREE (entry->buf);
+        entry->buf = buf;
+        entry->buf_size = size;
+
+        return 0;
+}
+
+
+/* changes the size of the data of entry, zeroing what is added */
+static int
+__posix_pack_resize (xlator_t *this, struct posix_pack_entry *entry,
+                     size_t size)
+{
+        int ret = 0;
+
+        ret = __posix_pack_load (this, entry, size);
+        if (ret)
+                return ret;
+
+        if (size > entry->size)
+                memset (entry->buf + entry->size, 0, size - entry->size);
+
+        entry->size = size;
+        entry->dirty = _gf_true;
+
+        return 0;
+}
+
+
+/* stores the data of entry written since it was stored last */
+static int
+__posix_pack_persist (xlator_t *this, struct posix_pack_table *table,
+                      struct posix_pack_entry *entry)
+{
+        struct posix_pack_container *container = NULL;
+        off_t                        offset    = 0;
+        int                          ret       = 0;
+
+        if (!entry->dirty || (entry->state != POSIX_PACK_LIVE))
+                return 0;
+
+        ret = __posix_pack_append (this, table, entry->buf, entry->size,
+                                   &container, &offset);
+        if (ret)
+                return ret;
+
+        if (entry->container)
+                entry->container->live -= entry->disk_size;
+        entry->container = container;
+        entry->offset = offset;
+        entry->disk_size = entry->size;
+        container->live += entry->size;
+        entry->stored = ++entry->stores;
+
+        ret = __posix_pack_log (this, table, entry, POSIX_PACK_PUT);
+        if (ret)
+                return ret;
+
+        entry->dirty = _gf_false;
+
+        return 0;
+}
+
+
+/* __posix_pack_persist() with the data written to the container out of
+   the lock of the table, which the caller does not hold; it has entry
+   referenced */
+static int
+posix_pack_store (xlator_t *this, struct posix_pack_table *table,
+                  struct posix_pack_entry *entry)
+{
+        struct posix_pack_container *container = NULL;
+        char                        *data      = NULL;
+        char                        *record    = NULL;
+        size_t                       len       = 0;
+        size_t                       reclen    = 0;
+        off_t                        offset    = 0;
+        uint64_t                     store     = 0;
+        int                          ret       = 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                if (!entry->dirty || (entry->state != POSIX_PACK_LIVE))
+                        goto unlock;
+
+                len = entry->size;
+                if (len) {
+                        data = GF_MALLOC (len, gf_posix_mt_char);
+                        if (!data) {
+                                ret = -ENOMEM;
+                                goto unlock;
+                        }
+                        memcpy (data, entry->buf, len);
+                }
+
+                ret = __posix_pack_reserve (this, table, len, &container,
+                                            &offset);
+                if (ret)
+                        goto unlock;
+
+                store = ++entry->stores;
+                entry->dirty = _gf_false;
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+
+        if (!container)
+                goto out;
+
+        ret = posix_pack_container_write (this, container, data, len, offset);
+
+        pthread_mutex_lock (&table->lock);
+        {
+                container->ref--;
+
+                /* a later store was recorded first, or entry is gone */
+                if (!ret && ((store < entry->stored) ||
+                             (entry->state != POSIX_PACK_LIVE)))
+                        goto unlock2;
+
+                if (!ret) {
+                        reclen = posix_pack_record_size (entry);
+                        record = GF_CALLOC (1, reclen, gf_posix_mt_char);
+                        if (!record)
+                                ret = -ENOMEM;
+                }
+
+                if (ret) {
+                        entry->dirty = _gf_true;
+                        goto unlock2;
+                }
+
+                if (entry->container)
+                        entry->container->live -= entry->disk_size;
+                entry->container = container;
+                entry->offset = offset;
+                entry->disk_size = len;
+                container->live += len;
+                entry->stored = store;
+
+                posix_pack_record_fill (record, entry, POSIX_PACK_PUT);
+
+                /* taken before the lock is let go, the records of an
+                   entry reach the index in the order of its stores */
+                pthread_mutex_lock (&table->index_lock);
+        }
+unlock2:
+        pthread_mutex_unlock (&table->lock);
+
+        if (!record)
+                goto out;
+
+        ret = __posix_pack_index_write (this, table, table->index_fd, record,
+                                        reclen);
+        pthread_mutex_unlock (&table->index_lock);
+
+        if (ret) {
+                pthread_mutex_lock (&table->lock);
+                {
+                        entry->dirty = _gf_true;
+                }
+                pthread_mutex_unlock (&table->lock);
+        }
+out:
+        if (data)
+                GF_FREE (data);
+        if (record)
+                GF_FREE (record);
+
+        return ret;
+}
+
+
+/* makes what is stored of entry, and the index, durable. The caller
+   does not hold the lock of the table, and has entry referenced. */
+static int
+posix_pack_sync (struct posix_pack_table *table,
+                 struct posix_pack_entry *entry)
+{
+        struct posix_pack_container *container = NULL;
+        int                          fd        = -1;
+        int                          ret       = 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                container = entry->container;
+                if (container)
+                        container->ref++;
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (container && (fsync (container->fd) == -1))
+                ret = -errno;
+
+        /* the index may be rewritten, and its fd closed, meanwhile */
+        pthread_mutex_lock (&table->index_lock);
+        {
+                fd = dup (table->index_fd);
+        }
+        pthread_mutex_unlock (&table->index_lock);
+
+        if (!ret && (fd == -1))
+                ret = -errno;
+        if (!ret && (fsync (fd) == -1))
+                ret = -errno;
+        if (fd != -1)
+                close (fd);
+
+        if (container) {
+                pthread_mutex_lock (&table->lock);
+                {
+                        container->ref--;
+                }
+                pthread_mutex_unlock (&table->lock);
+        }
+
+        return ret;
+}
+
+
+/* drops the buf of an entry nobody has open and is stored */
+static void
+__posix_pack_unload (struct posix_pack_entry *entry)
+{
+        if (entry->opens || entry->dirty || !entry->buf)
+                return;
+
+        GF_FREE (entry->buf);
+        entry->buf = NULL;
+        entry->buf_size = 0;
+}
+
+
+/* writes entry out as a regular file of the brick and takes it out of
+   the table. An unlinked entry becomes a file without name, the fd of
+   which is returned in fd_p. */
+static int
+__posix_pack_spill (xlator_t *this, struct posix_pack_table *table,
+                    struct posix_pack_entry *entry, int *fd_p)
+{
+        struct stat     stbuf    = {0, };
+        struct timeval  tv[2]    = {{0, }, {0, }};
+        data_pair_t    *trav     = NULL;
+        char           *path     = NULL;
+        int             _fd      = -1;
+        ssize_t         ret      = 0;
+        int             op_errno = 0;
+
+        if (entry->state == POSIX_PACK_LIVE) {
+                MAKE_HANDLE_PATH (path, this, entry->pargfid, entry->basename);
+        } else if ((entry->state == POSIX_PACK_UNLINKED) && fd_p) {
+                path = alloca (strlen (table->path) + 64);
+                sprintf (path, "%s/spill.%s", table->path,
+                         uuid_utoa (entry->gfid));
+        }
+
+        if (!path) {
+                errno = ENOENT;
+                return -1;
+        }
+
+        ret = __posix_pack_load (this, entry, 0);
+        if (ret) {
+                errno = -ret;
+                return -1;
+        }
+
+        _fd = open (path, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (_fd == -1) {
+                op_errno = errno;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "spilling packed file %s to %s failed: %s",
+                        uuid_utoa (entry->gfid), path, strerror (op_errno));
+                errno = op_errno;
+                return -1;
+        }
+
+        if (entry->size) {
+                ret = pwrite (_fd, entry->buf, entry->size, 0);
+                if (ret != entry->size) {
+                        op_errno = (ret == -1) ? errno : ENOSPC;
+                        goto err;
+                }
+        }
+
+        for (trav = entry->xattrs->members_list; trav; trav = trav->next) {
+                ret = sys_fsetxattr (_fd, trav->key, trav->value->data,
+                                     trav->value->len, 0);
+                if (ret == -1) {
+                        op_errno = errno;
+                        goto err;
+                }
+        }
+
+        ret = sys_fsetxattr (_fd, GFID_XATTR_KEY, entry->gfid, 16,
+                             XATTR_CREATE);
+        if (ret == -1) {
+                op_errno = errno;
+                goto err;
+        }
+
+        if ((fchown (_fd, entry->uid, entry->gid) == -1) ||
+            (fchmod (_fd, entry->mode & 07777) == -1)) {
+                op_errno = errno;
+                goto err;
+        }
+
+        tv[0].tv_sec  = entry->atime;
+        tv[0].tv_usec = entry->atime_nsec / 1000;
+        tv[1].tv_sec  = entry->mtime;
+        tv[1].tv_usec = entry->mtime_nsec / 1000;
+        utimes (path, tv);
+
+        if (entry->state == POSIX_PACK_LIVE) {
+                if (lstat (path, &stbuf) == -1) {
+                        op_errno = errno;
+                        goto err;
+                }
+                if (posix_handle_hard (this, path, entry->gfid, &stbuf)) {
+                        op_errno = errno;
+                        goto err;
+                }
+        } else {
+                unlink (path);
+        }
+
+        if (entry->state == POSIX_PACK_LIVE) {
+                __posix_pack_log (this, table, entry, POSIX_PACK_DEL);
+                __posix_pack_entry_remove (table, entry, POSIX_PACK_SPILLED);
+        } else {
+                entry->state = POSIX_PACK_SPILLED;
+        }
+
+        table->spills++;
+
+        gf_log (this->name, GF_LOG_DEBUG, "spilled packed file %s to %s",
+                uuid_utoa (entry->gfid), path);
+
+        if (fd_p)
+                *fd_p = _fd;
+        else
+                close (_fd);
+
+        return 0;
+err:
+        gf_log (this->name, GF_LOG_ERROR,
+                "spilling packed file %s to %s failed: %s",
+                uuid_utoa (entry->gfid), path, strerror (op_errno));
+
+        close (_fd);
+        unlink (path);
+
+        errno = op_errno;
+        return -1;
+}
+
+
+int
+posix_pack_spill (xlator_t *this, uuid_t gfid, const char *basename)
+{
+        struct posix_private    *priv  = NULL;
+        struct posix_pack_table *table = NULL;
+        struct posix_pack_entry *entry = NULL;
+        int                      ret   = -1;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return -1;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                if (basename)
+                        entry = __posix_pack_get_name (table, gfid, basename);
+                else
+                        entry = __posix_pack_get (table, gfid);
+
+                if (entry)
+                        ret = __posix_pack_spill (this, table, entry, NULL);
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry)
+                errno = ENOENT;
+
+        return ret;
+}
+
+
+/* the packed entry of fd, given one if fd is anonymous */
+static struct posix_pack_entry *
+__posix_pack_fd_entry (xlator_t *this, struct posix_pack_table *table,
+                       fd_t *fd, struct posix_fd **pfd_p)
+{
+        struct posix_pack_entry *entry   = NULL;
+        struct posix_fd         *pfd     = NULL;
+        uint64_t                 tmp_pfd = 0;
+
+        if (fd_ctx_get (fd, this, &tmp_pfd) == 0) {
+                pfd = (struct posix_fd *)(long) tmp_pfd;
+                entry = pfd->pack;
+                if (!entry || (entry->state == POSIX_PACK_SPILLED))
+                        return NULL;
+                goto out;
+        }
+
+        if (fd->pid != -1)
+                return NULL;
+
+        entry = __posix_pack_get (table, fd->inode->gfid);
+        if (!entry)
+                return NULL;
+
+        pfd = GF_CALLOC (1, sizeof (*pfd), gf_posix_mt_posix_fd);
+        if (!pfd)
+                return NULL;
+
+        pfd->fd = -1;
+        pfd->flags = O_RDWR;
+        pfd->pack = entry;
+
+        if (fd_ctx_set (fd, this, (uint64_t)(long) pfd)) {
+                GF_FREE (pfd);
+                return NULL;
+        }
+
+        entry->ref++;
+        entry->opens++;
+out:
+        if (pfd_p)
+                *pfd_p = pfd;
+
+        return entry;
+}
+
+
+static uuid_t *
+posix_pack_loc_gfid (loc_t *loc)
+{
+        if (uuid_is_null (loc->gfid) && loc->inode)
+                return &loc->inode->gfid;
+
+        return &loc->gfid;
+}
+
+
+/* the entry a fop on loc or fd is done on */
+static struct posix_pack_entry *
+__posix_pack_target (xlator_t *this, struct posix_pack_table *table,
+                     loc_t *loc, fd_t *fd, struct posix_fd **pfd_p)
+{
+        if (fd)
+                return __posix_pack_fd_entry (this, table, fd, pfd_p);
+
+        return __posix_pack_get (table, *posix_pack_loc_gfid (loc));
+}
+
+
+int
+posix_pack_fd_unpack (xlator_t *this, fd_t *fd, struct posix_fd *pfd)
+{
+        struct posix_private    *priv  = NULL;
+        struct posix_pack_table *table = NULL;
+        struct posix_pack_entry *entry = NULL;
+        char                    *path  = NULL;
+        int                      _fd   = -1;
+        int                      ret   = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry = pfd->pack;
+                if (!entry)
+                        goto unlock;
+
+                if (entry->state != POSIX_PACK_SPILLED) {
+                        ret = __posix_pack_spill (this, table, entry,
+                                                  (entry->state ==
+                                                   POSIX_PACK_UNLINKED) ?
+                                                  &_fd : NULL);
+                        if (ret)
+                                goto unlock;
+                }
+
+                if (_fd == -1) {
+                        MAKE_HANDLE_PATH (path, this, entry->gfid, NULL);
+                        if (path)
+                                _fd = open (path, pfd->flags &
+                                            ~(O_CREAT | O_EXCL | O_TRUNC));
+                        if (_fd == -1) {
+                                gf_log (this->name, GF_LOG_ERROR,
+                                        "opening spilled file %s failed: %s",
+                                        uuid_utoa (entry->gfid),
+                                        strerror (errno));
+                                ret = -1;
+                                goto unlock;
+                        }
+                }
+
+                pfd->fd = _fd;
+                pfd->pack = NULL;
+                entry->opens--;
+                __posix_pack_entry_unref (entry);
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+
+        return ret;
+}
+
+
+/* the xattrs of xattr_req a lookup of entry is answered with */
+static dict_t *
+__posix_pack_xattr_fill (xlator_t *this, struct posix_pack_entry *entry,
+                         loc_t *loc, dict_t *xattr_req)
+{
+        dict_t      *xattr    = NULL;
+        data_pair_t *trav     = NULL;
+        data_t      *value    = NULL;
+
+        xattr = get_new_dict ();
+        if (!xattr)
+                return NULL;
+
+        for (trav = xattr_req->members_list; trav; trav = trav->next) {
+                /* the content is read out of the lock, by the lookup */
+                if (!strcmp (trav->key, GF_CONTENT_KEY)) {
+                        continue;
+                } else if (!strcmp (trav->key, GLUSTERFS_OPEN_FD_COUNT)) {
+                        if (dict_set_uint32 (xattr, trav->key,
+                                             (loc->inode && !list_empty
+                                              (&loc->inode->fd_list)) ? 1 : 0))
+                                gf_log (this->name, GF_LOG_DEBUG,
+                                        "could not set the open fd count of "
+                                        "%s", loc->path);
+                } else if ((value = dict_get (entry->xattrs, trav->key))) {
+                        posix_pack_dict_set (xattr, trav->key, value->data,
+                                             value->len);
+                }
+        }
+
+        return xattr;
+}
+
+
+/* sets the data of entry as GF_CONTENT_KEY in xattr, when it is no
+   larger than req_size */
+static void
+posix_pack_content_fill (xlator_t *this, struct posix_pack_table *table,
+                         struct posix_pack_entry *entry, dict_t *xattr,
+                         uint64_t req_size)
+{
+        char    *databuf = NULL;
+        size_t   size    = 0;
+        ssize_t  ret     = 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                size = entry->size;
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (req_size < size)
+                return;
+
+        databuf = GF_CALLOC (1, size + 1, gf_posix_mt_char);
+        if (!databuf)
+                return;
+
+        ret = posix_pack_pread (this, table, entry, databuf, size, 0);
+        if ((ret != size) || dict_set_bin (xattr, GF_CONTENT_KEY, databuf,
+                                           size))
+                GF_FREE (databuf);
+}
+
+
+int
+posix_pack_lookup (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                   dict_t *xattr_req)
+{
+        struct posix_private    *priv       = NULL;
+        struct posix_pack_table *table      = NULL;
+        struct posix_pack_entry *entry      = NULL;
+        struct iatt              buf        = {0, };
+        struct iatt              postparent = {0, };
+        dict_t                  *xattr      = NULL;
+        char                    *par_path   = NULL;
+        gf_boolean_t             named      = _gf_false;
+        data_t                  *content    = NULL;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return 0;
+
+        named = !uuid_is_null (loc->pargfid) && loc->name;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                if (named)
+                        entry = __posix_pack_get_name (table, loc->pargfid,
+                                                       loc->name);
+                else
+                        entry = __posix_pack_get (table, loc->gfid);
+
+                if (entry) {
+                        posix_pack_iatt (this, entry, &buf);
+                        if (xattr_req)
+                                xattr = __posix_pack_xattr_fill (this, entry,
+                                                                 loc,
+                                                                 xattr_req);
+                        if (xattr)
+                                content = dict_get (xattr_req,
+                                                    GF_CONTENT_KEY);
+                        if (content)
+                                entry->ref++;
+                }
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry)
+                return 0;
+
+        if (content) {
+                posix_pack_content_fill (this, table, entry, xattr,
+                                         data_to_uint64 (content));
+
+                pthread_mutex_lock (&table->lock);
+                {
+                        __posix_pack_entry_unref (entry);
+                }
+                pthread_mutex_unlock (&table->lock);
+        }
+
+        if (named) {
+                MAKE_HANDLE_PATH (par_path, this, loc->pargfid, NULL);
+                if (par_path)
+                        posix_pstat (this, loc->pargfid, par_path,
+                                     &postparent);
+        }
+
+        if (xattr)
+                dict_ref (xattr);
+
+        STACK_UNWIND_STRICT (lookup, frame, 0, 0, loc->inode, &buf, xattr,
+                             &postparent);
+
+        if (xattr)
+                dict_unref (xattr);
+
+        return 1;
+}
+
+
+int
+posix_pack_stat (call_frame_t *frame, xlator_t *this, loc_t *loc)
+{
+        struct posix_private    *priv  = NULL;
+        struct posix_pack_table *table = NULL;
+        struct posix_pack_entry *entry = NULL;
+        struct iatt              buf   = {0, };
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry = __posix_pack_get (table, *posix_pack_loc_gfid (loc));
+                if (entry)
+                        posix_pack_iatt (this, entry, &buf);
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry)
+                return 0;
+
+        STACK_UNWIND_STRICT (stat, frame, 0, 0, &buf);
+
+        return 1;
+}
+
+
+int
+posix_pack_fstat (call_frame_t *frame, xlator_t *this, fd_t *fd)
+{
+        struct posix_private    *priv  = NULL;
+        struct posix_pack_table *table = NULL;
+        struct posix_pack_entry *entry = NULL;
+        struct iatt              buf   = {0, };
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry = __posix_pack_fd_entry (this, table, fd, NULL);
+                if (entry)
+                        posix_pack_iatt (this, entry, &buf);
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry)
+                return 0;
+
+        STACK_UNWIND_STRICT (fstat, frame, 0, 0, &buf);
+
+        return 1;
+}
+
+
+/* a packed create or unlink changes the directory as a real one would */
+static void
+posix_pack_touch_dir (const char *par_path)
+{
+#ifdef UTIME_NOW
+        struct timespec ts[2] = {{0, UTIME_OMIT}, {0, UTIME_NOW}};
+
+        utimensat (AT_FDCWD, par_path, ts, 0);
+#else
+        utimes (par_path, NULL);
+#endif
+}
+
+
+int
+posix_pack_create (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                   int32_t flags, mode_t mode, fd_t *fd, dict_t *params,
+                   const char *par_path)
+{
+        struct posix_private    *priv       = NULL;
+        struct posix_pack_table *table      = NULL;
+        struct posix_pack_entry *entry      = NULL;
+        struct posix_fd         *pfd        = NULL;
+        struct iatt              stbuf      = {0, };
+        struct iatt              preparent  = {0, };
+        struct iatt              postparent = {0, };
+        data_pair_t             *trav       = NULL;
+        void                    *uuid_req   = NULL;
+        gid_t                    gid        = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table || !table->threshold || priv->o_direct || !par_path)
+                return 0;
+
+        if (!params || dict_get_ptr (params, "gfid-req", &uuid_req) ||
+            uuid_is_null (uuid_req))
+                return 0;
+
+        if (strlen (loc->name) > NAME_MAX)
+                return 0;
+
+        /* ACLs are for the filesystem of the brick to apply */
+        for (trav = params->members_list; trav; trav = trav->next) {
+                if (!strcmp (trav->key, "gfid-req") ||
+                    !strcmp (trav->key, GFID_XATTR_KEY))
+                        continue;
+                if (!posix_pack_key_native (trav->key))
+                        return 0;
+        }
+
+        if (sys_lgetxattr (par_path, "system.posix_acl_default", NULL, 0) > 0)
+                return 0;
+
+        if (posix_pstat (this, loc->pargfid, par_path, &preparent) == -1)
+                return 0;
+
+        gid = frame->root->gid;
+        if (preparent.ia_prot.sgid)
+                gid = preparent.ia_gid;
+
+        pfd = GF_CALLOC (1, sizeof (*pfd), gf_posix_mt_posix_fd);
+        if (!pfd)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                if (__posix_pack_get_name (table, loc->pargfid, loc->name) ||
+                    __posix_pack_get (table, uuid_req))
+                        goto unlock;
+
+                entry = __posix_pack_entry_new (table, uuid_req, loc->pargfid,
+                                                loc->name);
+                if (!entry)
+                        goto unlock;
+
+                entry->mode = mode & 07777;
+                entry->uid  = frame->root->uid;
+                entry->gid  = gid;
+                posix_pack_now (&entry->mtime, &entry->mtime_nsec);
+                entry->atime = entry->ctime = entry->mtime;
+                entry->atime_nsec = entry->ctime_nsec = entry->mtime_nsec;
+
+                for (trav = params->members_list; trav; trav = trav->next) {
+                        if (!strcmp (trav->key, "gfid-req") ||
+                            !strcmp (trav->key, GFID_XATTR_KEY))
+                                continue;
+                        posix_pack_dict_set (entry->xattrs, trav->key,
+                                             trav->value->data,
+                                             trav->value->len);
+                }
+
+                if (__posix_pack_log (this, table, entry, POSIX_PACK_PUT)) {
+                        __posix_pack_entry_remove (table, entry,
+                                                   POSIX_PACK_UNLINKED);
+                        entry = NULL;
+                        goto unlock;
+                }
+
+                entry->ref++;
+                entry->opens++;
+                posix_pack_iatt (this, entry, &stbuf);
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry) {
+                GF_FREE (pfd);
+                return 0;
+        }
+
+        posix_pack_touch_dir (par_path);
+        posix_pstat (this, loc->pargfid, par_path, &postparent);
+
+        pfd->fd    = -1;
+        pfd->flags = flags;
+        pfd->pack  = entry;
+
+        if (fd_ctx_set (fd, this, (uint64_t)(long) pfd))
+                gf_log (this->name, GF_LOG_WARNING,
+                        "failed to set the fd context path=%s fd=%p",
+                        loc->path, fd);
+
+        LOCK (&priv->lock);
+        {
+                priv->nr_files++;
+        }
+        UNLOCK (&priv->lock);
+
+        STACK_UNWIND_STRICT (create, frame, 0, 0, fd, loc->inode, &stbuf,
+                             &preparent, &postparent);
+
+        return 1;
+}
+
+
+int
+posix_pack_open (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                 int32_t flags, fd_t *fd, int wbflags)
+{
+        struct posix_private    *priv  = NULL;
+        struct posix_pack_table *table = NULL;
+        struct posix_pack_entry *entry = NULL;
+        struct posix_fd         *pfd   = NULL;
+        int                      ret   = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table || priv->o_direct)
+                return 0;
+
+        pfd = GF_CALLOC (1, sizeof (*pfd), gf_posix_mt_posix_fd);
+        if (!pfd)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry = __posix_pack_get (table, *posix_pack_loc_gfid (loc));
+                if (!entry)
+                        goto unlock;
+
+                if ((flags & O_TRUNC) && entry->size) {
+                        if (__posix_pack_resize (this, entry, 0)) {
+                                entry = NULL;
+                                goto unlock;
+                        }
+                        posix_pack_now (&entry->mtime, &entry->mtime_nsec);
+                        entry->ctime = entry->mtime;
+                        entry->ctime_nsec = entry->mtime_nsec;
+                }
+
+                entry->ref++;
+                entry->opens++;
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry) {
+                GF_FREE (pfd);
+                return 0;
+        }
+
+        pfd->fd    = -1;
+        pfd->flags = flags;
+        pfd->pack  = entry;
+        if (wbflags == GF_OPEN_FSYNC)
+                pfd->flushwrites = 1;
+
+        /* of O_TRUNC, stored before the open is acknowledged */
+        ret = posix_pack_store (this, table, entry);
+        if (ret)
+                gf_log (this->name, GF_LOG_WARNING,
+                        "storing the truncation of packed file %s failed: %s",
+                        uuid_utoa (entry->gfid), strerror (-ret));
+
+        if (fd_ctx_set (fd, this, (uint64_t)(long) pfd))
+                gf_log (this->name, GF_LOG_WARNING,
+                        "failed to set the fd context path=%s fd=%p",
+                        loc->path, fd);
+
+        LOCK (&priv->lock);
+        {
+                priv->nr_files++;
+        }
+        UNLOCK (&priv->lock);
+
+        STACK_UNWIND_STRICT (open, frame, 0, 0, fd);
+
+        return 1;
+}
+
+
+int
+posix_pack_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                  size_t size, off_t offset)
+{
+        struct posix_private    *priv     = NULL;
+        struct posix_pack_table *table    = NULL;
+        struct posix_pack_entry *entry    = NULL;
+        struct iobuf            *iobuf    = NULL;
+        struct iobref           *iobref   = NULL;
+        struct iovec             vec      = {0, };
+        struct iatt              stbuf    = {0, };
+        int32_t                  op_ret   = -1;
+        int32_t                  op_errno = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table || !size)
+                return 0;
+
+        iobuf = iobuf_get2 (this->ctx->iobuf_pool, size);
+        if (!iobuf)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry = __posix_pack_fd_entry (this, table, fd, NULL);
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry) {
+                iobuf_unref (iobuf);
+                return 0;
+        }
+
+        op_ret = posix_pack_pread (this, table, entry, iobuf->ptr, size,
+                                   offset);
+        if (op_ret < 0) {
+                op_errno = -op_ret;
+                op_ret = -1;
+        }
+
+        pthread_mutex_lock (&table->lock);
+        {
+                posix_pack_iatt (this, entry, &stbuf);
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (op_ret == -1)
+                goto out;
+
+        LOCK (&priv->lock);
+        {
+                priv->read_value += op_ret;
+        }
+        UNLOCK (&priv->lock);
+
+        vec.iov_base = iobuf->ptr;
+        vec.iov_len  = op_ret;
+
+        iobref = iobref_new ();
+        if (!iobref) {
+                op_ret = -1;
+                op_errno = ENOMEM;
+                goto out;
+        }
+        iobref_add (iobref, iobuf);
+
+        /* EOF, as posix_readv() tells it */
+        if ((offset + vec.iov_len) >= stbuf.ia_size)
+                op_errno = ENOENT;
+out:
+        STACK_UNWIND_STRICT (readv, frame, op_ret, op_errno, &vec, 1, &stbuf,
+                             iobref);
+
+        if (iobref)
+                iobref_unref (iobref);
+        iobuf_unref (iobuf);
+
+        return 1;
+}
+
+
+int
+posix_pack_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                   struct iovec *vector, int32_t count, off_t offset)
+{
+        struct posix_private    *priv     = NULL;
+        struct posix_pack_table *table    = NULL;
+        struct posix_pack_entry *entry    = NULL;
+        struct posix_fd         *pfd      = NULL;
+        struct iatt              preop    = {0, };
+        struct iatt              postop   = {0, };
+        size_t                   len      = 0;
+        size_t                   end      = 0;
+        int32_t                  op_ret   = -1;
+        int32_t                  op_errno = 0;
+        int                      ret      = 0;
+        int                      i        = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return 0;
+
+        len = iov_length (vector, count);
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry = __posix_pack_fd_entry (this, table, fd, &pfd);
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry)
+                return 0;
+
+        posix_pack_load (this, table, entry);
+
+        pthread_mutex_lock (&table->lock);
+        {
+                if (entry->state == POSIX_PACK_SPILLED) {
+                        entry = NULL;
+                        goto unlock;
+                }
+
+                if (pfd->flags & O_APPEND)
+                        offset = entry->size;
+
+                /* a larger file is a regular one, the write is done on it */
+                if (offset + len > table->threshold) {
+                        if (entry->state == POSIX_PACK_LIVE)
+                                __posix_pack_spill (this, table, entry, NULL);
+                        entry = NULL;
+                        goto unlock;
+                }
+
+                posix_pack_iatt (this, entry, &preop);
+
+                end = max (entry->size, offset + len);
+                ret = __posix_pack_resize (this, entry, end);
+                if (ret) {
+                        op_errno = -ret;
+                        goto stat;
+                }
+
+                for (i = 0; i < count; i++) {
+                        memcpy (entry->buf + offset, vector[i].iov_base,
+                                vector[i].iov_len);
+                        offset += vector[i].iov_len;
+                }
+
+                posix_pack_now (&entry->mtime, &entry->mtime_nsec);
+                entry->ctime = entry->mtime;
+                entry->ctime_nsec = entry->mtime_nsec;
+
+                op_ret = len;
+        stat:
+                posix_pack_iatt (this, entry, &postop);
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry)
+                return 0;
+
+        /* stored before it is acknowledged, buf only saves the reads
+           from going to the container */
+        if (op_ret > 0) {
+                ret = posix_pack_store (this, table, entry);
+                if (!ret && pfd->flushwrites)
+                        ret = posix_pack_sync (table, entry);
+                if (ret) {
+                        op_ret = -1;
+                        op_errno = -ret;
+                }
+        }
+
+        if (op_ret > 0) {
+                LOCK (&priv->lock);
+                {
+                        priv->write_value += op_ret;
+                }
+                UNLOCK (&priv->lock);
+        }
+
+        STACK_UNWIND_STRICT (writev, frame, op_ret, op_errno, &preop, &postop);
+
+        return 1;
+}
+
+
+int
+posix_pack_flush (call_frame_t *frame, xlator_t *this, fd_t *fd)
+{
+        struct posix_private    *priv     = NULL;
+        struct posix_pack_table *table    = NULL;
+        struct posix_pack_entry *entry    = NULL;
+        int32_t                  op_ret   = 0;
+        int32_t                  op_errno = 0;
+        int                      ret      = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry = __posix_pack_fd_entry (this, table, fd, NULL);
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry)
+                return 0;
+
+        ret = posix_pack_store (this, table, entry);
+
+        if (ret) {
+                op_ret = -1;
+                op_errno = -ret;
+        }
+
+        STACK_UNWIND_STRICT (flush, frame, op_ret, op_errno);
+
+        return 1;
+}
+
+
+int
+posix_pack_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd)
+{
+        struct posix_private    *priv     = NULL;
+        struct posix_pack_table *table    = NULL;
+        struct posix_pack_entry *entry    = NULL;
+        struct iatt              preop    = {0, };
+        struct iatt              postop   = {0, };
+        int32_t                  op_ret   = 0;
+        int32_t                  op_errno = 0;
+        int                      ret      = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry = __posix_pack_fd_entry (this, table, fd, NULL);
+                if (entry)
+                        posix_pack_iatt (this, entry, &preop);
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry)
+                return 0;
+
+        ret = posix_pack_store (this, table, entry);
+        if (!ret)
+                ret = posix_pack_sync (table, entry);
+
+        pthread_mutex_lock (&table->lock);
+        {
+                posix_pack_iatt (this, entry, &postop);
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (ret) {
+                op_ret = -1;
+                op_errno = -ret;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "fsync of packed file %s failed: %s",
+                        uuid_utoa (fd->inode->gfid), strerror (op_errno));
+        }
+
+        STACK_UNWIND_STRICT (fsync, frame, op_ret, op_errno, &preop, &postop);
+
+        return 1;
+}
+
+
+int
+posix_pack_release (xlator_t *this, fd_t *fd)
+{
+        struct posix_private    *priv    = NULL;
+        struct posix_pack_table *table   = NULL;
+        struct posix_pack_entry *entry   = NULL;
+        struct posix_fd         *pfd     = NULL;
+        uint64_t                 tmp_pfd = 0;
+        int                      ret     = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                if (fd_ctx_get (fd, this, &tmp_pfd))
+                        goto unlock;
+
+                pfd = (struct posix_fd *)(long) tmp_pfd;
+                entry = pfd->pack;
+                if (!entry)
+                        goto unlock;
+
+                fd_ctx_del (fd, this, NULL);
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry)
+                return 0;
+
+        ret = posix_pack_store (this, table, entry);
+        if (ret)
+                gf_log (this->name, GF_LOG_ERROR,
+                        "storing packed file %s failed, its last writes are "
+                        "lost: %s", uuid_utoa (entry->gfid), strerror (-ret));
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry->opens--;
+                if (!entry->opens)
+                        entry->dirty = _gf_false;
+                __posix_pack_unload (entry);
+                __posix_pack_entry_unref (entry);
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        GF_FREE (pfd);
+
+        LOCK (&priv->lock);
+        {
+                priv->nr_files--;
+        }
+        UNLOCK (&priv->lock);
+
+        return 1;
+}
+
+
+int
+posix_pack_truncate (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                     fd_t *fd, off_t offset)
+{
+        struct posix_private    *priv     = NULL;
+        struct posix_pack_table *table    = NULL;
+        struct posix_pack_entry *entry    = NULL;
+        struct iatt              prebuf   = {0, };
+        struct iatt              postbuf  = {0, };
+        int32_t                  op_ret   = 0;
+        int32_t                  op_errno = 0;
+        int                      ret      = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry = __posix_pack_target (this, table, loc, fd, NULL);
+                if (!entry)
+                        goto unlock;
+
+                if (offset > table->threshold) {
+                        if (entry->state == POSIX_PACK_LIVE)
+                                __posix_pack_spill (this, table, entry, NULL);
+                        entry = NULL;
+                        goto unlock;
+                }
+
+                entry->ref++;
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry)
+                return 0;
+
+        posix_pack_load (this, table, entry);
+
+        pthread_mutex_lock (&table->lock);
+        {
+                posix_pack_iatt (this, entry, &prebuf);
+
+                ret = __posix_pack_resize (this, entry, offset);
+                if (!ret) {
+                        posix_pack_now (&entry->mtime, &entry->mtime_nsec);
+                        entry->ctime = entry->mtime;
+                        entry->ctime_nsec = entry->mtime_nsec;
+                }
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (!ret)
+                ret = posix_pack_store (this, table, entry);
+
+        pthread_mutex_lock (&table->lock);
+        {
+                __posix_pack_unload (entry);
+                posix_pack_iatt (this, entry, &postbuf);
+                __posix_pack_entry_unref (entry);
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (ret) {
+                op_ret = -1;
+                op_errno = -ret;
+        }
+
+        if (fd)
+                STACK_UNWIND_STRICT (ftruncate, frame, op_ret, op_errno,
+                                     &prebuf, &postbuf);
+        else
+                STACK_UNWIND_STRICT (truncate, frame, op_ret, op_errno,
+                                     &prebuf, &postbuf);
+
+        return 1;
+}
+
+
+int
+posix_pack_setattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                    fd_t *fd, struct iatt *stbuf, int32_t valid)
+{
+        struct posix_private    *priv     = NULL;
+        struct posix_pack_table *table    = NULL;
+        struct posix_pack_entry *entry    = NULL;
+        struct iatt              statpre  = {0, };
+        struct iatt              statpost = {0, };
+        int32_t                  op_ret   = 0;
+        int32_t                  op_errno = 0;
+        int                      ret      = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry = __posix_pack_target (this, table, loc, fd, NULL);
+                if (!entry)
+                        goto unlock;
+
+                posix_pack_iatt (this, entry, &statpre);
+
+                if (valid & GF_SET_ATTR_MODE)
+                        entry->mode = st_mode_from_ia (stbuf->ia_prot,
+                                                       IA_IFREG) & 07777;
+                if (valid & GF_SET_ATTR_UID)
+                        entry->uid = stbuf->ia_uid;
+                if (valid & GF_SET_ATTR_GID)
+                        entry->gid = stbuf->ia_gid;
+                if (valid & (GF_SET_ATTR_ATIME | GF_SET_ATTR_MTIME)) {
+                        entry->atime = stbuf->ia_atime;
+                        entry->atime_nsec = stbuf->ia_atime_nsec;
+                        entry->mtime = stbuf->ia_mtime;
+                        entry->mtime_nsec = stbuf->ia_mtime_nsec;
+                }
+                posix_pack_now (&entry->ctime, &entry->ctime_nsec);
+
+                if (entry->state == POSIX_PACK_LIVE)
+                        ret = __posix_pack_log (this, table, entry,
+                                                POSIX_PACK_PUT);
+
+                posix_pack_iatt (this, entry, &statpost);
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry)
+                return 0;
+
+        if (ret) {
+                op_ret = -1;
+                op_errno = -ret;
+        }
+
+        if (fd)
+                STACK_UNWIND_STRICT (fsetattr, frame, op_ret, op_errno,
+                                     &statpre, &statpost);
+        else
+                STACK_UNWIND_STRICT (setattr, frame, op_ret, op_errno,
+                                     &statpre, &statpost);
+
+        return 1;
+}
+
+
+int
+posix_pack_getxattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                     fd_t *fd, const char *name)
+{
+        struct posix_private    *priv     = NULL;
+        struct posix_pack_table *table    = NULL;
+        struct posix_pack_entry *entry    = NULL;
+        data_pair_t             *trav     = NULL;
+        data_t                  *value    = NULL;
+        dict_t                  *dict     = NULL;
+        int32_t                  op_ret   = 0;
+        int32_t                  op_errno = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return 0;
+
+        dict = get_new_dict ();
+        if (!dict)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry = __posix_pack_target (this, table, loc, fd, NULL);
+                if (!entry)
+                        goto unlock;
+
+                if (name && !strcmp (name, GLUSTERFS_OPEN_FD_COUNT)) {
+                        if (dict_set_uint32 (dict, (char *)name,
+                                             (fd || entry->opens) ? 1 : 0)) {
+                                op_ret = -1;
+                                op_errno = ENOMEM;
+                        }
+                        goto unlock;
+                }
+
+                if (name && !posix_pack_key_native (name)) {
+                        if (entry->state == POSIX_PACK_LIVE)
+                                __posix_pack_spill (this, table, entry, NULL);
+                        entry = NULL;
+                        goto unlock;
+                }
+
+                if (name) {
+                        value = dict_get (entry->xattrs, (char *)name);
+                        if (!value) {
+                                op_ret = -1;
+                                op_errno = ENODATA;
+                                goto unlock;
+                        }
+                        posix_pack_dict_set (dict, (char *)name, value->data,
+                                             value->len);
+                        op_ret = value->len;
+                        goto unlock;
+                }
+
+                for (trav = entry->xattrs->members_list; trav;
+                     trav = trav->next) {
+                        posix_pack_dict_set (dict, trav->key,
+                                             trav->value->data,
+                                             trav->value->len);
+                        op_ret += strlen (trav->key) + 1;
+                }
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry) {
+                dict_destroy (dict);
+                return 0;
+        }
+
+        dict_ref (dict);
+
+        if (fd)
+                STACK_UNWIND_STRICT (fgetxattr, frame, op_ret, op_errno, dict);
+        else
+                STACK_UNWIND_STRICT (getxattr, frame, op_ret, op_errno, dict);
+
+        dict_unref (dict);
+
+        return 1;
+}
+
+
+int
+posix_pack_setxattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                     fd_t *fd, dict_t *dict, int flags)
+{
+        struct posix_private    *priv     = NULL;
+        struct posix_pack_table *table    = NULL;
+        struct posix_pack_entry *entry    = NULL;
+        data_pair_t             *trav     = NULL;
+        size_t                   len      = 0;
+        int32_t                  op_ret   = 0;
+        int32_t                  op_errno = 0;
+        int                      ret      = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry = __posix_pack_target (this, table, loc, fd, NULL);
+                if (!entry)
+                        goto unlock;
+
+                len = posix_pack_xattrs_size (entry->xattrs);
+                for (trav = dict->members_list; trav; trav = trav->next) {
+                        if (!strcmp (trav->key, GFID_XATTR_KEY))
+                                continue;
+                        len += strlen (trav->key) + trav->value->len;
+                        if (posix_pack_key_native (trav->key) &&
+                            (len <= POSIX_PACK_XATTR_MAX))
+                                continue;
+
+                        if (entry->state == POSIX_PACK_LIVE)
+                                __posix_pack_spill (this, table, entry, NULL);
+                        entry = NULL;
+                        goto unlock;
+                }
+
+                for (trav = dict->members_list; trav; trav = trav->next) {
+                        if (!strcmp (trav->key, GFID_XATTR_KEY))
+                                continue;
+                        if ((flags & XATTR_CREATE) &&
+                            dict_get (entry->xattrs, trav->key)) {
+                                op_errno = EEXIST;
+                                goto unlock;
+                        }
+                        if ((flags & XATTR_REPLACE) &&
+                            !dict_get (entry->xattrs, trav->key)) {
+                                op_errno = ENODATA;
+                                goto unlock;
+                        }
+                }
+
+                for (trav = dict->members_list; trav; trav = trav->next) {
+                        if (!strcmp (trav->key, GFID_XATTR_KEY))
+                                continue;
+                        ret = posix_pack_dict_set (entry->xattrs, trav->key,
+                                                   trav->value->data,
+                                                   trav->value->len);
+                        if (ret) {
+                                op_errno = ENOMEM;
+                                goto unlock;
+                        }
+                }
+
+                posix_pack_now (&entry->ctime, &entry->ctime_nsec);
+
+                if (entry->state == POSIX_PACK_LIVE) {
+                        ret = __posix_pack_log (this, table, entry,
+                                                POSIX_PACK_PUT);
+                        if (ret)
+                                op_errno = -ret;
+                }
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry)
+                return 0;
+
+        if (op_errno)
+                op_ret = -1;
+
+        if (fd)
+                STACK_UNWIND_STRICT (fsetxattr, frame, op_ret, op_errno);
+        else
+                STACK_UNWIND_STRICT (setxattr, frame, op_ret, op_errno);
+
+        return 1;
+}
+
+
+int
+posix_pack_xattrop (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                    fd_t *fd, gf_xattrop_flags_t optype, dict_t *xattr)
+{
+        struct posix_private    *priv     = NULL;
+        struct posix_pack_table *table    = NULL;
+        struct posix_pack_entry *entry    = NULL;
+        data_pair_t             *trav     = NULL;
+        data_t                  *value    = NULL;
+        char                    *array    = NULL;
+        int32_t                  op_ret   = 0;
+        int32_t                  op_errno = 0;
+        int                      ret      = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry = __posix_pack_target (this, table, loc, fd, NULL);
+                if (!entry)
+                        goto unlock;
+
+                for (trav = xattr->members_list; trav; trav = trav->next) {
+                        value = dict_get (entry->xattrs, trav->key);
+                        if (((optype == GF_XATTROP_ADD_ARRAY) ||
+                             (optype == GF_XATTROP_ADD_ARRAY64)) &&
+                            posix_pack_key_native (trav->key) &&
+                            (!value || (value->len == trav->value->len)))
+                                continue;
+
+                        if (entry->state == POSIX_PACK_LIVE)
+                                __posix_pack_spill (this, table, entry, NULL);
+                        entry = NULL;
+                        goto unlock;
+                }
+
+                for (trav = xattr->members_list; trav; trav = trav->next) {
+                        array = GF_CALLOC (trav->value->len, sizeof (char),
+                                           gf_posix_mt_char);
+                        if (!array) {
+                                op_errno = ENOMEM;
+                                goto unlock;
+                        }
+
+                        value = dict_get (entry->xattrs, trav->key);
+                        if (value)
+                                memcpy (array, value->data, value->len);
+
+                        if (optype == GF_XATTROP_ADD_ARRAY)
+                                __add_array ((int32_t *) array,
+                                             (int32_t *) trav->value->data,
+                                             trav->value->len / 4);
+                        else
+                                __add_long_array ((int64_t *) array,
+                                                  (int64_t *) trav->value->data,
+                                                  trav->value->len / 8);
+
+                        ret = posix_pack_dict_set (entry->xattrs, trav->key,
+                                                   array, trav->value->len);
+                        if (ret || dict_set_bin (xattr, trav->key, array,
+                                                 trav->value->len)) {
+                                GF_FREE (array);
+                                op_errno = ENOMEM;
+                                goto unlock;
+                        }
+                }
+
+                if (entry->state == POSIX_PACK_LIVE) {
+                        ret = __posix_pack_log (this, table, entry,
+                                                POSIX_PACK_PUT);
+                        if (ret)
+                                op_errno = -ret;
+                }
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry)
+                return 0;
+
+        if (op_errno)
+                op_ret = -1;
+
+        STACK_UNWIND_STRICT (xattrop, frame, op_ret, op_errno, xattr);
+
+        return 1;
+}
+
+
+int
+posix_pack_unlink (call_frame_t *frame, xlator_t *this, loc_t *loc)
+{
+        struct posix_private    *priv       = NULL;
+        struct posix_pack_table *table      = NULL;
+        struct posix_pack_entry *entry      = NULL;
+        struct iatt              preparent  = {0, };
+        struct iatt              postparent = {0, };
+        char                    *par_path   = NULL;
+        int32_t                  op_ret     = 0;
+        int32_t                  op_errno   = 0;
+        int                      ret        = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table || uuid_is_null (loc->pargfid) || !loc->name)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry = __posix_pack_get_name (table, loc->pargfid, loc->name);
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry)
+                return 0;
+
+        MAKE_HANDLE_PATH (par_path, this, loc->pargfid, NULL);
+        if (!par_path)
+                return 0;
+
+        if (posix_pstat (this, loc->pargfid, par_path, &preparent) == -1)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry = __posix_pack_get_name (table, loc->pargfid, loc->name);
+                if (!entry)
+                        goto unlock;
+
+                ret = __posix_pack_log (this, table, entry, POSIX_PACK_DEL);
+                if (ret) {
+                        op_errno = -ret;
+                        goto unlock;
+                }
+
+                /* the data of open fds stays in memory until released */
+                __posix_pack_entry_remove (table, entry, POSIX_PACK_UNLINKED);
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+
+        if (!entry)
+                return 0;
+
+        if (op_errno) {
+                op_ret = -1;
+        } else {
+                posix_pack_touch_dir (par_path);
+                posix_pstat (this, loc->pargfid, par_path, &postparent);
+        }
+
+        STACK_UNWIND_STRICT (unlink, frame, op_ret, op_errno, &preparent,
+                             &postparent);
+
+        return 1;
+}
+
+
+int
+posix_pack_rmdir (xlator_t *this, uuid_t gfid)
+{
+        struct posix_private    *priv  = NULL;
+        struct posix_pack_table *table = NULL;
+        int                      ret   = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                if (__posix_pack_dir_get (table, gfid, _gf_false))
+                        ret = -ENOTEMPTY;
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        return ret;
+}
+
+
+void
+posix_pack_drop_dir (xlator_t *this, uuid_t gfid)
+{
+        struct posix_private    *priv  = NULL;
+        struct posix_pack_table *table = NULL;
+        struct posix_pack_dir   *dir   = NULL;
+        struct posix_pack_entry *entry = NULL;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                /* the dir goes with its last entry */
+                while ((dir = __posix_pack_dir_get (table, gfid, _gf_false))) {
+                        entry = list_entry (dir->entries.next,
+                                            struct posix_pack_entry, list);
+                        __posix_pack_log (this, table, entry, POSIX_PACK_DEL);
+                        __posix_pack_entry_remove (table, entry,
+                                                   POSIX_PACK_UNLINKED);
+                }
+        }
+        pthread_mutex_unlock (&table->lock);
+}
+
+
+int
+posix_pack_readdir (xlator_t *this, fd_t *fd, off_t off, size_t size,
+                    gf_dirent_t *entries, int whichop)
+{
+        struct posix_private    *priv       = NULL;
+        struct posix_pack_table *table      = NULL;
+        struct posix_pack_dir   *dir        = NULL;
+        struct posix_pack_entry *entry      = NULL;
+        gf_dirent_t             *this_entry = NULL;
+        uint64_t                 after      = 0;
+        size_t                   filled     = 0;
+        int32_t                  this_size  = 0;
+        int                      count      = 0;
+        int                      op_errno   = ENOENT;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                goto out;
+
+        /* the entries of the directory already in the reply */
+        list_for_each_entry (this_entry, &entries->list, list) {
+                filled += max (sizeof (gf_dirent_t), sizeof (gfs3_dirplist))
+                        + strlen (this_entry->d_name) + 1;
+        }
+
+        if (POSIX_PACK_IS_DOFF (off))
+                after = off - POSIX_PACK_DOFF_BASE;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                dir = __posix_pack_dir_get (table, fd->inode->gfid, _gf_false);
+                if (!dir)
+                        goto unlock;
+
+                list_for_each_entry (entry, &dir->entries, list) {
+                        if (entry->seq <= after)
+                                continue;
+                        if (entry->seq > POSIX_PACK_DOFF_MAX -
+                                         POSIX_PACK_DOFF_BASE)
+                                break;
+
+                        this_size = max (sizeof (gf_dirent_t),
+                                         sizeof (gfs3_dirplist))
+                                + strlen (entry->basename) + 1;
+
+                        if (this_size + filled > size) {
+                                /* the listing goes on from here */
+                                op_errno = 0;
+                                break;
+                        }
+
+                        this_entry = gf_dirent_for_name (entry->basename);
+                        if (!this_entry)
+                                break;
+
+                        posix_pack_iatt (this, entry, &this_entry->d_stat);
+                        this_entry->d_off  = POSIX_PACK_DOFF_BASE + entry->seq;
+                        this_entry->d_ino  = this_entry->d_stat.ia_ino;
+                        this_entry->d_type = DT_REG;
+                        if (whichop != GF_FOP_READDIRP)
+                                memset (&this_entry->d_stat, 0,
+                                        sizeof (this_entry->d_stat));
+
+                        list_add_tail (&this_entry->list, &entries->list);
+
+                        filled += this_size;
+                        count++;
+                }
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+out:
+        errno = op_errno;
+        return count;
+}
+
+
+/* moves the live data of container to the current one */
+static int
+__posix_pack_compact_container (xlator_t *this,
+                                struct posix_pack_table *table,
+                                struct posix_pack_container *container)
+{
+        struct posix_pack_container *to     = NULL;
+        struct posix_pack_entry     *entry  = NULL;
+        char                        *buf    = NULL;
+        off_t                        offset = 0;
+        ssize_t                      ret    = 0;
+        int                          i      = 0;
+
+        /* the threshold may have been higher when the data was packed */
+        buf = GF_MALLOC (POSIX_PACK_MAX_THRESHOLD, gf_posix_mt_char);
+        if (!buf)
+                return -ENOMEM;
+
+        for (i = 0; i < POSIX_PACK_BUCKETS && container->live; i++) {
+                list_for_each_entry (entry, &table->gfids[i], hash) {
+                        if (entry->container != container)
+                                continue;
+
+                        ret = pread (container->fd, buf, entry->disk_size,
+                                     entry->offset);
+                        if (ret != entry->disk_size) {
+                                ret = (ret == -1) ? -errno : -EIO;
+                                goto out;
+                        }
+
+                        ret = __posix_pack_append (this, table, buf,
+                                                   entry->disk_size, &to,
+                                                   &offset);
+                        if (ret)
+                                goto out;
+
+                        container->live -= entry->disk_size;
+                        to->live += entry->disk_size;
+                        entry->container = to;
+                        entry->offset = offset;
+
+                        ret = __posix_pack_log (this, table, entry,
+                                                POSIX_PACK_PUT);
+                        if (ret)
+                                goto out;
+                }
+        }
+
+        ret = 0;
+out:
+        GF_FREE (buf);
+
+        return ret;
+}
+
+
+/* writes the records of the live entries to a new index */
+static int
+__posix_pack_index_rewrite (xlator_t *this, struct posix_pack_table *table)
+{
+        struct posix_pack_entry *entry = NULL;
+        char                    *path  = NULL;
+        char                    *tmp   = NULL;
+        char                    *buf   = NULL;
+        size_t                   len   = 0;
+        off_t                    size  = 0;
+        int                      fd    = -1;
+        int                      ret   = -1;
+        int                      i     = 0;
+
+        path = alloca (strlen (table->path) + 16);
+        sprintf (path, "%s/" POSIX_PACK_INDEX, table->path);
+        tmp = alloca (strlen (table->path) + 16);
+        sprintf (tmp, "%s/" POSIX_PACK_INDEX ".tmp", table->path);
+
+        fd = open (tmp, O_CREAT | O_TRUNC | O_WRONLY | O_APPEND, 0600);
+        if (fd == -1)
+                goto out;
+
+        for (i = 0; i < POSIX_PACK_BUCKETS; i++) {
+                list_for_each_entry (entry, &table->gfids[i], hash) {
+                        len = posix_pack_record_size (entry);
+                        buf = GF_CALLOC (1, len, gf_posix_mt_char);
+                        if (!buf)
+                                goto out;
+                        posix_pack_record_fill (buf, entry, POSIX_PACK_PUT);
+                        ret = __posix_pack_index_write (this, table, fd, buf,
+                                                        len);
+                        GF_FREE (buf);
+                        if (ret)
+                                goto out;
+                        size += len;
+                }
+        }
+
+        ret = -1;
+        if ((fsync (fd) == -1) || (rename (tmp, path) == -1))
+                goto out;
+
+        pthread_mutex_lock (&table->index_lock);
+        {
+                close (table->index_fd);
+                table->index_fd = fd;
+                table->index_size = size;
+        }
+        pthread_mutex_unlock (&table->index_lock);
+        fd = -1;
+        ret = 0;
+out:
+        if (fd != -1) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "rewriting the pack index failed: %s",
+                        strerror (errno));
+                close (fd);
+                unlink (tmp);
+        }
+
+        return ret;
+}
+
+
+void
+posix_pack_compact (xlator_t *this)
+{
+        struct posix_private        *priv      = NULL;
+        struct posix_pack_table     *table     = NULL;
+        struct posix_pack_container *container = NULL;
+        struct posix_pack_container *tmp       = NULL;
+        struct posix_pack_entry     *entry     = NULL;
+        gf_boolean_t                 found     = _gf_false;
+        off_t                        live      = 0;
+        int                          i         = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return;
+
+        /* a container at a time, the fops wait for the lock meanwhile */
+        do {
+                found = _gf_false;
+
+                pthread_mutex_lock (&table->lock);
+                {
+                        list_for_each_entry_safe (container, tmp,
+                                                  &table->containers, list) {
+                                if ((container == table->current) ||
+                                    container->ref ||
+                                    (container->live * 2 >= container->size))
+                                        continue;
+
+                                if (__posix_pack_compact_container (this, table,
+                                                                    container)) {
+                                        gf_log (this->name, GF_LOG_WARNING,
+                                                "compacting pack container "
+                                                "%08x failed",
+                                                container->id);
+                                        break;
+                                }
+
+                                gf_log (this->name, GF_LOG_DEBUG,
+                                        "removing pack container %08x",
+                                        container->id);
+                                __posix_pack_container_destroy (table,
+                                                                container,
+                                                                _gf_true);
+                                table->compactions++;
+                                found = _gf_true;
+                                break;
+                        }
+                }
+                pthread_mutex_unlock (&table->lock);
+        } while (found);
+
+        pthread_mutex_lock (&table->lock);
+        {
+                if (table->index_size < POSIX_PACK_INDEX_MIN)
+                        goto unlock;
+
+                for (i = 0; i < POSIX_PACK_BUCKETS; i++) {
+                        list_for_each_entry (entry, &table->gfids[i], hash)
+                                live += posix_pack_record_size (entry);
+                }
+
+                if (table->index_size > 2 * live)
+                        __posix_pack_index_rewrite (this, table);
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+}
+
+
+static int
+__posix_pack_replay_record (xlator_t *this, struct posix_pack_table *table,
+                            struct posix_pack_record *record, char *name,
+                            char *xattrs)
+{
+        struct posix_pack_entry     *entry     = NULL;
+        struct posix_pack_container *container = NULL;
+
+        entry = __posix_pack_get (table, record->gfid);
+
+        if (record->op == POSIX_PACK_DEL) {
+                if (entry)
+                        __posix_pack_entry_remove (table, entry,
+                                                   POSIX_PACK_UNLINKED);
+                return 0;
+        }
+
+        if (entry && ((uuid_compare (entry->pargfid, record->pargfid) != 0) ||
+                      strcmp (entry->basename, name))) {
+                __posix_pack_entry_remove (table, entry, POSIX_PACK_UNLINKED);
+                entry = NULL;
+        }
+
+        if (!entry) {
+                entry = __posix_pack_entry_new (table, record->gfid,
+                                                record->pargfid, name);
+                if (!entry)
+                        return -ENOMEM;
+        }
+
+        entry->mode       = record->mode;
+        entry->uid        = record->uid;
+        entry->gid        = record->gid;
+        entry->atime      = record->atime;
+        entry->atime_nsec = record->atime_nsec;
+        entry->mtime      = record->mtime;
+        entry->mtime_nsec = record->mtime_nsec;
+        entry->ctime      = record->ctime;
+        entry->ctime_nsec = record->ctime_nsec;
+
+        dict_unref (entry->xattrs);
+        entry->xattrs = dict_new ();
+        if (!entry->xattrs ||
+            posix_pack_xattrs_parse (xattrs, record->xattrlen, entry->xattrs))
+                return -EINVAL;
+
+        if (entry->container)
+                entry->container->live -= entry->disk_size;
+        entry->container = NULL;
+        entry->offset = 0;
+        entry->disk_size = entry->size = 0;
+
+        if (!record->container)
+                return 0;
+
+        container = __posix_pack_container_get (table, record->container);
+        if (!container ||
+            (container->size < record->offset + record->size)) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "data of packed file %s missing from pack container "
+                        "%08x, it is left empty", uuid_utoa (record->gfid),
+                        record->container);
+                return 0;
+        }
+
+        entry->container = container;
+        entry->offset = record->offset;
+        entry->disk_size = entry->size = record->size;
+        container->live += record->size;
+
+        return 0;
+}
+
+
+static int
+posix_pack_replay (xlator_t *this, struct posix_pack_table *table)
+{
+        struct posix_pack_record  record  = {0, };
+        char                     *buf     = NULL;
+        char                     *ptr     = NULL;
+        size_t                    len     = 0;
+        size_t                    left    = 0;
+        size_t                    need    = 0;
+        off_t                     pos     = 0;
+        ssize_t                   n       = 0;
+        struct stat               stbuf   = {0, };
+        gf_boolean_t              bad     = _gf_false;
+        int                       records = 0;
+        int                       ret     = -1;
+
+        if (fstat (table->index_fd, &stbuf) == -1)
+                return -1;
+
+        buf = GF_MALLOC (POSIX_PACK_REPLAY_CHUNK, gf_posix_mt_char);
+        if (!buf)
+                return -1;
+
+        for (;;) {
+                n = pread (table->index_fd, buf + len,
+                           POSIX_PACK_REPLAY_CHUNK - len, pos + len);
+                if (n == -1) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "reading the pack index failed: %s",
+                                strerror (errno));
+                        goto out;
+                }
+                len += n;
+
+                ptr = buf;
+                left = len;
+                while (left >= sizeof (record)) {
+                        memcpy (&record, ptr, sizeof (record));
+                        if ((record.magic != POSIX_PACK_MAGIC) ||
+                            ((record.op != POSIX_PACK_PUT) &&
+                             (record.op != POSIX_PACK_DEL))) {
+                                bad = _gf_true;
+                                break;
+                        }
+
+                        need = sizeof (record) + record.namelen +
+                                record.xattrlen;
+                        if ((need > POSIX_PACK_REPLAY_CHUNK) ||
+                            ((record.op == POSIX_PACK_PUT) &&
+                             (!record.namelen ||
+                              ((left >= need) &&
+                               ptr[sizeof (record) + record.namelen - 1])))) {
+                                bad = _gf_true;
+                                break;
+                        }
+                        if (left < need)
+                                break;
+
+                        if (__posix_pack_replay_record (this, table, &record,
+                                                        ptr + sizeof (record),
+                                                        ptr + sizeof (record) +
+                                                        record.namelen))
+                                goto out;
+
+                        ptr  += need;
+                        left -= need;
+                        records++;
+                }
+
+                pos += len - left;
+                memmove (buf, ptr, left);
+                len = left;
+
+                if (bad || !n)
+                        break;
+        }
+
+        if (pos < stbuf.st_size) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "dropping the %"PRId64" bytes of incomplete records "
+                        "at the end of the pack index",
+                        (int64_t) (stbuf.st_size - pos));
+                if (ftruncate (table->index_fd, pos) == -1)
+                        goto out;
+        }
+
+        gf_log (this->name, GF_LOG_INFO,
+                "replayed %d records of the pack index, %"PRIu64" packed "
+                "files", records, table->count);
+
+        table->index_size = pos;
+        ret = 0;
+out:
+        GF_FREE (buf);
+
+        return ret;
+}
+
+
+static int
+posix_pack_containers_open (xlator_t *this, struct posix_pack_table *table)
+{
+        struct posix_pack_container *container = NULL;
+        struct dirent               *entry     = NULL;
+        DIR                         *dir       = NULL;
+        uint32_t                     id        = 0;
+        char                         tail      = 0;
+
+        dir = opendir (table->path);
+        if (!dir)
+                return -1;
+
+        while ((entry = readdir (dir))) {
+                if (sscanf (entry->d_name, "container.%08x%c", &id,
+                            &tail) != 1)
+                        continue;
+
+                container = posix_pack_container_open (this, table, id, 0);
+                if (!container) {
+                        closedir (dir);
+                        return -1;
+                }
+
+                if (!table->current || (table->current->id < id))
+                        table->current = container;
+        }
+
+        closedir (dir);
+
+        return 0;
+}
+
+
+static void
+posix_pack_table_destroy (struct posix_pack_table *table)
+{
+        struct posix_pack_entry     *entry     = NULL;
+        struct posix_pack_entry     *tmp       = NULL;
+        struct posix_pack_container *container = NULL;
+        struct posix_pack_container *ctmp      = NULL;
+        int                          i         = 0;
+
+        for (i = 0; i < POSIX_PACK_BUCKETS; i++) {
+                list_for_each_entry_safe (entry, tmp, &table->gfids[i], hash)
+                        __posix_pack_entry_remove (table, entry,
+                                                   POSIX_PACK_UNLINKED);
+        }
+
+        list_for_each_entry_safe (container, ctmp, &table->containers, list)
+                __posix_pack_container_destroy (table, container, _gf_false);
+
+        if (table->index_fd != -1)
+                close (table->index_fd);
+
+        pthread_mutex_destroy (&table->index_lock);
+        pthread_mutex_destroy (&table->lock);
+        GF_FREE (table->path);
+        GF_FREE (table);
+}
+
+
+int
+posix_pack_init (xlator_t *this, gf_boolean_t pack, size_t threshold)
+{
+        struct posix_private    *priv  = NULL;
+        struct posix_pack_table *table = NULL;
+        char                    *index = NULL;
+        int                      i     = 0;
+        int                      ret   = -1;
+
+        priv = this->private;
+
+        table = GF_CALLOC (1, sizeof (*table), gf_posix_mt_pack_table);
+        if (!table)
+                goto out;
+
+        pthread_mutex_init (&table->lock, NULL);
+        pthread_mutex_init (&table->index_lock, NULL);
+        for (i = 0; i < POSIX_PACK_BUCKETS; i++) {
+                INIT_LIST_HEAD (&table->gfids[i]);
+                INIT_LIST_HEAD (&table->names[i]);
+                INIT_LIST_HEAD (&table->dirs[i]);
+        }
+        INIT_LIST_HEAD (&table->containers);
+        table->index_fd = -1;
+        /* 0 when packing is off: new files are not packed, the ones
+           packed before are still served */
+        table->threshold = pack ? threshold : 0;
+
+        ret = gf_asprintf (&table->path, "%s/" GF_HIDDEN_PATH "/"
+                           POSIX_PACK_DIR, priv->base_path);
+        if (ret == -1) {
+                table->path = NULL;
+                goto out;
+        }
+        ret = -1;
+
+        index = alloca (strlen (table->path) + 16);
+        sprintf (index, "%s/" POSIX_PACK_INDEX, table->path);
+
+        if (!pack && (access (index, F_OK) == -1)) {
+                ret = 0;
+                goto out;
+        }
+
+        if ((mkdir (table->path, 0700) == -1) && (errno != EEXIST)) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "creating %s failed: %s", table->path,
+                        strerror (errno));
+                goto out;
+        }
+
+        if (posix_pack_containers_open (this, table)) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "opening the pack containers of %s failed",
+                        table->path);
+                goto out;
+        }
+
+        table->index_fd = open (index, O_CREAT | O_RDWR | O_APPEND, 0600);
+        if (table->index_fd == -1) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "opening the pack index %s failed: %s", index,
+                        strerror (errno));
+                goto out;
+        }
+
+        if (posix_pack_replay (this, table)) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "replaying the pack index %s failed", index);
+                goto out;
+        }
+
+        priv->pack = table;
+        table = NULL;
+        ret = 0;
+
+        if (pack)
+                gf_log (this->name, GF_LOG_INFO, "files up to %zu bytes "
+                        "are packed in %s", threshold, priv->pack->path);
+out:
+        if (table)
+                posix_pack_table_destroy (table);
+
+        return ret;
+}
+
+
+void
+posix_pack_fini (xlator_t *this)
+{
+        struct posix_private    *priv  = NULL;
+        struct posix_pack_table *table = NULL;
+        struct posix_pack_entry *entry = NULL;
+        int                      i     = 0;
+
+        priv = this->private;
+        table = priv->pack;
+        if (!table)
+                return;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                for (i = 0; i < POSIX_PACK_BUCKETS; i++) {
+                        list_for_each_entry (entry, &table->gfids[i], hash)
+                                __posix_pack_persist (this, table, entry);
+                }
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        priv->pack = NULL;
+        posix_pack_table_destroy (table);
+}
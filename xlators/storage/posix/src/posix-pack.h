@@ -0,0 +1,203 @@
+/*
+   Copyright (c) 2012 Gluster, Inc. <http://www.gluster.com>
+   This file is part of GlusterFS.
+
+   GlusterFS is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 3 of the License,
+   or (at your option) any later version.
+
+   GlusterFS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see
+   <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _POSIX_PACK_H
+#define _POSIX_PACK_H
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <pthread.h>
+
+#include "xlator.h"
+#include "glusterfs.h"
+#include "gf-dirent.h"
+#include "list.h"
+
+/* containers and index, under the hidden directory of the brick */
+#define POSIX_PACK_DIR                  "pack"
+#define POSIX_PACK_INDEX                "index"
+
+#define POSIX_PACK_THRESHOLD            (16 * 1024)
+#define POSIX_PACK_MAX_THRESHOLD        (1024 * 1024)
+/* a new container is started past this size */
+#define POSIX_PACK_CONTAINER_MAX        (64 * 1024 * 1024)
+/* the index is not rewritten below this size */
+#define POSIX_PACK_INDEX_MIN            (4 * 1024 * 1024)
+
+#define POSIX_PACK_BUCKETS              16384
+
+/* the d_off of packed entries, listed after the end of the directory.
+   ext4 never hands out a hash cookie in this range, its 64-bit EOF
+   cookie is just past it; xfs and btrfs cookies are far below it */
+#define POSIX_PACK_DOFF_BASE            0x7fffffff00000000ULL
+#define POSIX_PACK_DOFF_MAX             0x7ffffffffffffffeULL
+#define POSIX_PACK_IS_DOFF(off)                                         \
+        (((uint64_t)(off) >= POSIX_PACK_DOFF_BASE) &&                   \
+         ((uint64_t)(off) <= POSIX_PACK_DOFF_MAX))
+
+struct posix_fd;
+
+enum posix_pack_state {
+        POSIX_PACK_LIVE,
+        POSIX_PACK_UNLINKED,    /* only open fds have it */
+        POSIX_PACK_SPILLED,     /* a regular file of the brick now */
+};
+
+struct posix_pack_container {
+        struct list_head  list;
+        uint32_t          id;
+        int               fd;
+        off_t             size;
+        off_t             live;     /* bytes of it some entry points to */
+        int               ref;      /* I/O on it out of the table lock */
+};
+
+/**
+ * posix_pack_dir - the packed entries of a directory, in the order they
+ * were created in, which is the order readdir returns them in.
+ */
+struct posix_pack_dir {
+        struct list_head  hash;
+        struct list_head  entries;
+        uuid_t            gfid;
+};
+
+/**
+ * posix_pack_entry - a regular file kept in a container instead of the
+ * filesystem of the brick. The data stored is at offset of container,
+ * buf holds it while the file is open and may be ahead of it. Stores are
+ * numbered: one done out of the lock is dropped when a later one was
+ * recorded before it.
+ */
+struct posix_pack_entry {
+        struct list_head             hash;     /* by gfid */
+        struct list_head             name;     /* by pargfid and name */
+        struct list_head             list;     /* of its posix_pack_dir */
+        uuid_t                       gfid;
+        uuid_t                       pargfid;
+        char                        *basename;
+        uint64_t                     seq;
+        enum posix_pack_state        state;
+        int                          ref;
+        int                          opens;
+
+        uint32_t                     mode;
+        uint32_t                     uid;
+        uint32_t                     gid;
+        uint32_t                     atime;
+        uint32_t                     atime_nsec;
+        uint32_t                     mtime;
+        uint32_t                     mtime_nsec;
+        uint32_t                     ctime;
+        uint32_t                     ctime_nsec;
+        dict_t                      *xattrs;
+
+        struct posix_pack_container *container;
+        off_t                        offset;
+        size_t                       disk_size;
+
+        char                        *buf;
+        size_t                       buf_size;
+        size_t                       size;
+        gf_boolean_t                 dirty;
+        uint64_t                     stores;
+        uint64_t                     stored;
+};
+
+/* I/O on the containers is done out of lock, the writes to the index
+   under index_lock, taken after lock when both are */
+struct posix_pack_table {
+        pthread_mutex_t              lock;
+        pthread_mutex_t              index_lock;
+        struct list_head             gfids[POSIX_PACK_BUCKETS];
+        struct list_head             names[POSIX_PACK_BUCKETS];
+        struct list_head             dirs[POSIX_PACK_BUCKETS];
+        struct list_head             containers;
+        struct posix_pack_container *current;
+        char                        *path;
+        int                          index_fd;
+        off_t                        index_size;
+        uint64_t                     count;
+        uint64_t                     seq;
+        size_t                       threshold;    /* 0: not packing */
+        uint64_t                     spills;
+        uint64_t                     compactions;
+};
+
+int posix_pack_init (xlator_t *this, gf_boolean_t pack, size_t threshold);
+void posix_pack_fini (xlator_t *this);
+
+/* the hooks of the fops below return 1 when the fop was answered from
+   the packed file, 0 when posix is to do it */
+int posix_pack_lookup (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                       dict_t *xattr_req);
+int posix_pack_stat (call_frame_t *frame, xlator_t *this, loc_t *loc);
+int posix_pack_fstat (call_frame_t *frame, xlator_t *this, fd_t *fd);
+int posix_pack_create (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                       int32_t flags, mode_t mode, fd_t *fd, dict_t *params,
+                       const char *par_path);
+int posix_pack_open (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                     int32_t flags, fd_t *fd, int wbflags);
+int posix_pack_readv (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                      size_t size, off_t offset);
+int posix_pack_writev (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                       struct iovec *vector, int32_t count, off_t offset);
+int posix_pack_flush (call_frame_t *frame, xlator_t *this, fd_t *fd);
+int posix_pack_fsync (call_frame_t *frame, xlator_t *this, fd_t *fd);
+int posix_pack_release (xlator_t *this, fd_t *fd);
+int posix_pack_truncate (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                         fd_t *fd, off_t offset);
+int posix_pack_setattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                        fd_t *fd, struct iatt *stbuf, int32_t valid);
+int posix_pack_getxattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                         fd_t *fd, const char *name);
+int posix_pack_setxattr (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                         fd_t *fd, dict_t *dict, int flags);
+int posix_pack_xattrop (call_frame_t *frame, xlator_t *this, loc_t *loc,
+                        fd_t *fd, gf_xattrop_flags_t optype, dict_t *xattr);
+int posix_pack_unlink (call_frame_t *frame, xlator_t *this, loc_t *loc);
+
+/* makes the packed file of gfid, or of basename in the directory gfid, a
+   regular file of the brick; 0 when there was one */
+int posix_pack_spill (xlator_t *this, uuid_t gfid, const char *basename);
+
+/* gives a packed fd the fd of the regular file its entry becomes */
+int posix_pack_fd_unpack (xlator_t *this, fd_t *fd, struct posix_fd *pfd);
+
+/* -ENOTEMPTY when the directory gfid has packed entries */
+int posix_pack_rmdir (xlator_t *this, uuid_t gfid);
+
+/* forgets the packed entries of a directory removed with its tree */
+void posix_pack_drop_dir (xlator_t *this, uuid_t gfid);
+
+/* lists the packed entries of the directory of fd after those already in
+   entries, which come from the directory up to its end. off is where the
+   listing is, the packed entries are listed from the first one unless it
+   is the d_off of one. errno is left ENOENT when the entries ran out */
+int posix_pack_readdir (xlator_t *this, fd_t *fd, off_t off, size_t size,
+                        gf_dirent_t *entries, int whichop);
+
+/* moves the live data out of mostly dead containers, and rewrites the
+   index when it is mostly superseded records */
+void posix_pack_compact (xlator_t *this);
+
+#endif /* _POSIX_PACK_H */
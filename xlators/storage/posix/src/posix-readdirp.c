@@ -0,0 +1,471 @@
+/*
+   Copyright (c) 2012 Gluster, Inc. <http://www.gluster.com>
+   This file is part of GlusterFS.
+
+   GlusterFS is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 3 of the License,
+   or (at your option) any later version.
+
+   GlusterFS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see
+   <http://www.gnu.org/licenses/>.
+*/
+
+
+/* Directory listing of posix. On linux the entries are read straight
+   from the fd of the directory with getdents64, in large batches and
+   with their type. For readdirp every entry is stat'ed relative to that
+   fd rather than through a handle path of its own, and a large batch is
+   split in shares, each stat'ed, and its gfid getxattr'ed, by one of the
+   threads of a pool started at init, the calling thread doing one share. */
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <alloca.h>
+
+#include "posix.h"
+#include "posix-handle.h"
+#include "posix-readdirp.h"
+#include "xlator.h"
+#include "common-utils.h"
+#include "glusterfs3-xdr.h"
+
+#ifdef GF_LINUX_HOST_OS
+#include <sys/syscall.h>
+
+struct posix_dirent64 {
+        uint64_t       d_ino;
+        int64_t        d_off;
+        unsigned short d_reclen;
+        unsigned char  d_type;
+        char           d_name[];
+};
+#endif
+
+struct posix_readdirp_slice {
+        struct list_head  list;    /* in the queue of the pool */
+        xlator_t         *this;
+        int               dfd;
+        const char       *dir_path;
+        gf_dirent_t     **entries;
+        int               count;
+        gf_boolean_t      done;
+};
+
+
+int
+posix_readdir_skip (fd_t *fd, const char *name)
+{
+        uuid_t rootgfid = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1};
+
+        if (uuid_compare (fd->inode->gfid, rootgfid) != 0)
+                return 0;
+
+        if (!strcmp (name, GF_REPLICATE_TRASH_DIR))
+                return 1;
+
+#ifdef __NetBSD__
+        /*
+         * NetBSD with UFS1 backend uses backing files for
+         * extended attributes. They can be found in a
+         * .attribute file located at the root of the filesystem
+         * We hide it to glusterfs clients, since chaos will occur
+         * when the cluster/dht xlator decides to distribute
+         * exended attribute backing file accross storage servers.
+         */
+        if (!strcmp (name, ".attribute"))
+                return 1;
+#endif /* __NetBSD__ */
+
+        if (!strncmp (GF_HIDDEN_PATH, name, strlen (GF_HIDDEN_PATH)))
+                return 1;
+
+        return 0;
+}
+
+
+#ifdef GF_LINUX_HOST_OS
+int
+posix_fill_readdir_getdents (xlator_t *this, fd_t *fd, int dfd, off_t off,
+                             size_t size, gf_dirent_t *entries)
+{
+        struct posix_dirent64 *entry      = NULL;
+        gf_dirent_t           *this_entry = NULL;
+        char                  *buf        = NULL;
+        long                   nread      = 0;
+        long                   pos        = 0;
+        size_t                 filled     = 0;
+        int32_t                this_size  = -1;
+        int                    count      = 0;
+        gf_boolean_t           full       = _gf_false;
+        gf_boolean_t           eof        = _gf_false;
+        int                    op_errno   = 0;
+
+        buf = GF_MALLOC (POSIX_GETDENTS_BUF_SIZE, gf_posix_mt_char);
+        if (!buf) {
+                errno = ENOMEM;
+                return 0;
+        }
+
+        /* every call seeks to its own offset, the position of the fd is
+           shared with the other readdirs of the fd */
+        LOCK (&fd->lock);
+        {
+                if (lseek (dfd, off, SEEK_SET) == -1) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "seek to %"PRId64" failed on fd=%d: %s",
+                                (int64_t) off, dfd, strerror (errno));
+                        goto unlock;
+                }
+
+                while (!full) {
+                        nread = syscall (SYS_getdents64, dfd, buf,
+                                         POSIX_GETDENTS_BUF_SIZE);
+                        if (nread == -1) {
+                                gf_log (this->name, GF_LOG_WARNING,
+                                        "getdents64 failed on fd=%d: %s",
+                                        dfd, strerror (errno));
+                                goto unlock;
+                        }
+
+                        if (nread == 0) {
+                                eof = _gf_true;
+                                break;
+                        }
+
+                        for (pos = 0; pos < nread; pos += entry->d_reclen) {
+                                entry = (void *) (buf + pos);
+
+                                if (posix_readdir_skip (fd, entry->d_name))
+                                        continue;
+
+                                this_size = max (sizeof (gf_dirent_t),
+                                                 sizeof (gfs3_dirplist))
+                                        + strlen (entry->d_name) + 1;
+
+                                if (this_size + filled > size) {
+                                        full = _gf_true;
+                                        break;
+                                }
+
+                                this_entry = gf_dirent_for_name (entry->d_name);
+                                if (!this_entry) {
+                                        gf_log (this->name, GF_LOG_ERROR,
+                                                "could not create gf_dirent "
+                                                "for entry %s: (%s)",
+                                                entry->d_name,
+                                                strerror (errno));
+                                        goto unlock;
+                                }
+                                this_entry->d_off  = entry->d_off;
+                                this_entry->d_ino  = entry->d_ino;
+                                this_entry->d_type = entry->d_type;
+
+                                list_add_tail (&this_entry->list,
+                                               &entries->list);
+
+                                filled += this_size;
+                                count++;
+                        }
+                }
+
+                /* Indicate EOF */
+                errno = eof ? ENOENT : 0;
+        }
+unlock:
+        op_errno = errno;
+        UNLOCK (&fd->lock);
+
+        GF_FREE (buf);
+
+        errno = op_errno;
+        return count;
+}
+#endif /* GF_LINUX_HOST_OS */
+
+
+static void
+posix_readdirp_stat (xlator_t *this, int dfd, const char *dir_path,
+                     gf_dirent_t *entry)
+{
+        struct posix_private *priv     = NULL;
+        struct stat           lstatbuf = {0, };
+        struct iatt           stbuf    = {0, };
+        char                 *path     = NULL;
+
+        priv = this->private;
+
+        if (fstatat (dfd, entry->d_name, &lstatbuf,
+                     AT_SYMLINK_NOFOLLOW) == -1) {
+                if (errno != ENOENT && errno != ELOOP)
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "lstat failed on %s/%s (%s)", dir_path,
+                                entry->d_name, strerror (errno));
+                goto out;
+        }
+
+        if ((lstatbuf.st_ino == priv->handledir.st_ino) &&
+            (lstatbuf.st_dev == priv->handledir.st_dev))
+                goto out;
+
+        if (!S_ISDIR (lstatbuf.st_mode))
+                lstatbuf.st_nlink --;
+
+        iatt_from_stat (&stbuf, &lstatbuf);
+
+        path = alloca (strlen (dir_path) + strlen (entry->d_name) + 2);
+        sprintf (path, "%s/%s", dir_path, entry->d_name);
+        posix_fill_gfid_path (this, path, &stbuf);
+
+        posix_fill_ino_from_gfid (this, &stbuf);
+out:
+        if (stbuf.ia_ino)
+                entry->d_ino = stbuf.ia_ino;
+        entry->d_stat = stbuf;
+}
+
+
+static void
+posix_readdirp_slice_stat (struct posix_readdirp_slice *slice)
+{
+        int i = 0;
+
+        for (i = 0; i < slice->count; i++)
+                posix_readdirp_stat (slice->this, slice->dfd, slice->dir_path,
+                                     slice->entries[i]);
+}
+
+
+static void *
+posix_readdirp_worker (void *data)
+{
+        struct posix_readdirp_pool  *pool  = NULL;
+        struct posix_readdirp_slice *slice = NULL;
+
+        pool = data;
+
+        pthread_mutex_lock (&pool->lock);
+        {
+                while (!pool->fini) {
+                        if (list_empty (&pool->queue)) {
+                                pthread_cond_wait (&pool->cond, &pool->lock);
+                                continue;
+                        }
+
+                        slice = list_entry (pool->queue.next,
+                                            struct posix_readdirp_slice, list);
+                        list_del_init (&slice->list);
+
+                        pthread_mutex_unlock (&pool->lock);
+                        {
+                                THIS = slice->this;
+                                posix_readdirp_slice_stat (slice);
+                        }
+                        pthread_mutex_lock (&pool->lock);
+
+                        slice->done = _gf_true;
+                        pthread_cond_broadcast (&pool->done);
+                }
+        }
+        pthread_mutex_unlock (&pool->lock);
+
+        return NULL;
+}
+
+
+void
+posix_readdirp_fill (xlator_t *this, fd_t *fd, int dfd, gf_dirent_t *entries,
+                     int count)
+{
+        struct posix_private        *priv     = NULL;
+        struct posix_readdirp_pool  *pool     = NULL;
+        struct posix_readdirp_slice *slices   = NULL;
+        gf_dirent_t                **array    = NULL;
+        gf_dirent_t                 *entry    = NULL;
+        char                        *dir_path = NULL;
+        int                          threads  = 0;
+        int                          per      = 0;
+        int                          pending  = 0;
+        int                          i        = 0;
+
+        priv = this->private;
+        pool = priv->readdirp_pool;
+
+        MAKE_HANDLE_PATH (dir_path, this, fd->inode->gfid, NULL);
+        if (!dir_path) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "could not resolve the handle of the directory of "
+                        "fd=%p", fd);
+                return;
+        }
+
+        if (pool)
+                threads = pool->count + 1;
+        if (threads > count / (POSIX_READDIRP_PARALLEL_MIN / 2))
+                threads = count / (POSIX_READDIRP_PARALLEL_MIN / 2);
+
+        if ((threads > 1) && (count >= POSIX_READDIRP_PARALLEL_MIN))
+                array = GF_CALLOC (count, sizeof (*array), gf_posix_mt_char);
+
+        if (!array) {
+                list_for_each_entry (entry, &entries->list, list)
+                        posix_readdirp_stat (this, dfd, dir_path, entry);
+                return;
+        }
+
+        list_for_each_entry (entry, &entries->list, list)
+                array[i++] = entry;
+        count = i;
+
+        slices = alloca (threads * sizeof (*slices));
+        per = (count + threads - 1) / threads;
+
+        for (i = 0; i < threads; i++) {
+                INIT_LIST_HEAD (&slices[i].list);
+                slices[i].this     = this;
+                slices[i].dfd      = dfd;
+                slices[i].dir_path = dir_path;
+                slices[i].entries  = &array[i * per];
+                slices[i].count    = min (per, count - i * per);
+                slices[i].done     = _gf_false;
+                if (slices[i].count < 0)
+                        slices[i].count = 0;
+        }
+
+        pthread_mutex_lock (&pool->lock);
+        {
+                for (i = 1; i < threads; i++)
+                        list_add_tail (&slices[i].list, &pool->queue);
+                pthread_cond_broadcast (&pool->cond);
+        }
+        pthread_mutex_unlock (&pool->lock);
+
+        posix_readdirp_slice_stat (&slices[0]);
+
+        /* the shares no thread of the pool took yet, busy with the other
+           readdirps, are done here too */
+        pthread_mutex_lock (&pool->lock);
+        {
+                for (;;) {
+                        pending = 0;
+                        for (i = 1; i < threads; i++) {
+                                if (!list_empty (&slices[i].list)) {
+                                        list_del_init (&slices[i].list);
+
+                                        pthread_mutex_unlock (&pool->lock);
+                                        {
+                                                posix_readdirp_slice_stat
+                                                        (&slices[i]);
+                                        }
+                                        pthread_mutex_lock (&pool->lock);
+
+                                        slices[i].done = _gf_true;
+                                }
+                                if (!slices[i].done)
+                                        pending++;
+                        }
+
+                        if (!pending)
+                                break;
+
+                        pthread_cond_wait (&pool->done, &pool->lock);
+                }
+        }
+        pthread_mutex_unlock (&pool->lock);
+
+        GF_FREE (array);
+}
+
+
+int
+posix_readdirp_init (xlator_t *this, int threads)
+{
+        struct posix_private       *priv = NULL;
+        struct posix_readdirp_pool *pool = NULL;
+        int                         ret  = 0;
+
+        priv = this->private;
+
+        /* the calling thread does a share itself */
+        if (threads <= 1)
+                return 0;
+
+        pool = GF_CALLOC (1, sizeof (*pool), gf_posix_mt_readdirp_pool);
+        if (!pool)
+                return -1;
+
+        pool->threads = GF_CALLOC (threads - 1, sizeof (*pool->threads),
+                                   gf_posix_mt_readdirp_pool);
+        if (!pool->threads) {
+                GF_FREE (pool);
+                return -1;
+        }
+
+        pthread_mutex_init (&pool->lock, NULL);
+        pthread_cond_init (&pool->cond, NULL);
+        pthread_cond_init (&pool->done, NULL);
+        INIT_LIST_HEAD (&pool->queue);
+
+        for (pool->count = 0; pool->count < threads - 1; pool->count++) {
+                ret = pthread_create (&pool->threads[pool->count], NULL,
+                                      posix_readdirp_worker, pool);
+                if (ret) {
+                        /* the readdirps get along with fewer */
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "spawning a readdirp thread failed: %s",
+                                strerror (ret));
+                        break;
+                }
+        }
+
+        priv->readdirp_pool = pool;
+
+        return 0;
+}
+
+
+void
+posix_readdirp_fini (xlator_t *this)
+{
+        struct posix_private       *priv = NULL;
+        struct posix_readdirp_pool *pool = NULL;
+        int                         i    = 0;
+
+        priv = this->private;
+        pool = priv->readdirp_pool;
+        if (!pool)
+                return;
+
+        pthread_mutex_lock (&pool->lock);
+        {
+                pool->fini = _gf_true;
+                pthread_cond_broadcast (&pool->cond);
+        }
+        pthread_mutex_unlock (&pool->lock);
+
+        for (i = 0; i < pool->count; i++)
+                pthread_join (pool->threads[i], NULL);
+
+        priv->readdirp_pool = NULL;
+
+        pthread_cond_destroy (&pool->done);
+        pthread_cond_destroy (&pool->cond);
+        pthread_mutex_destroy (&pool->lock);
+        GF_FREE (pool->threads);
+        GF_FREE (pool);
+}
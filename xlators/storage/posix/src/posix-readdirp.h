@@ -0,0 +1,68 @@
+/*
+   Copyright (c) 2012 Gluster, Inc. <http://www.gluster.com>
+   This file is part of GlusterFS.
+
+   GlusterFS is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 3 of the License,
+   or (at your option) any later version.
+
+   GlusterFS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see
+   <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _POSIX_READDIRP_H
+#define _POSIX_READDIRP_H
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <pthread.h>
+
+#include "xlator.h"
+#include "gf-dirent.h"
+#include "list.h"
+
+/* bytes of directory entries asked to getdents64 at once */
+#define POSIX_GETDENTS_BUF_SIZE        (128 * 1024)
+
+/* readdirp of fewer entries is not split across threads */
+#define POSIX_READDIRP_PARALLEL_MIN    64
+#define POSIX_READDIRP_MAX_THREADS     16
+#define POSIX_READDIRP_THREADS         4
+
+/* threads started at init, which stat the shares of the large readdirps */
+struct posix_readdirp_pool {
+        pthread_mutex_t   lock;
+        pthread_cond_t    cond;     /* a share is queued, or fini */
+        pthread_cond_t    done;     /* a share is done */
+        struct list_head  queue;
+        pthread_t        *threads;
+        int               count;
+        gf_boolean_t      fini;
+};
+
+int posix_readdirp_init (xlator_t *this, int threads);
+void posix_readdirp_fini (xlator_t *this);
+
+/* entries of the root which are not shown */
+int posix_readdir_skip (fd_t *fd, const char *name);
+
+/* same as posix_fill_readdir(), reading from the fd of the directory
+   with getdents64; entries get their d_type */
+int posix_fill_readdir_getdents (xlator_t *this, fd_t *fd, int dfd, off_t off,
+                                 size_t size, gf_dirent_t *entries);
+
+/* fills the d_stat of the count entries, stat'ed relative to dfd */
+void posix_readdirp_fill (xlator_t *this, fd_t *fd, int dfd,
+                          gf_dirent_t *entries, int count);
+
+#endif /* _POSIX_READDIRP_H */
@@ -0,0 +1,962 @@
+/*
+   Copyright (c) 2012 Gluster, Inc. <http://www.gluster.com>
+   This file is part of GlusterFS.
+
+   GlusterFS is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 3 of the License,
+   or (at your option) any later version.
+
+   GlusterFS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see
+   <http://www.gnu.org/licenses/>.
+*/
+
+
+/* Batched xattrops: the changelog and marker counters of replicate and
+   quota are added to in memory and set on disk by a flush thread, so that
+   the pre-op and post-op of many fops on an inode end up in a single
+   setxattr per key.
+
+   Before an xattrop is answered the values it produced are appended to a
+   journal, with one write(), so that the brick going down loses no more
+   than a setxattr would have: the journal holds absolute values, and
+   setting them again at init is idempotent. It is emptied whenever all
+   the pending values are on disk. */
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "posix.h"
+#include "posix-handle.h"
+#include "posix-xattrop.h"
+#include "xlator.h"
+#include "common-utils.h"
+#include "compat.h"
+#include "compat-errno.h"
+#include "syscall.h"
+
+#define POSIX_XATTROP_MAGIC 0x58415452   /* "XATR" */
+
+/* a record is followed by the key, with its '\0', and the value. A
+   record without key drops what was recorded before it for the gfid. */
+struct posix_xattrop_record {
+        uint32_t magic;
+        uint32_t keylen;
+        uint32_t vallen;
+        uuid_t   gfid;
+} __attribute__ ((packed));
+
+
+static struct list_head *
+posix_xattrop_bucket (struct posix_xattrop_table *table, uuid_t gfid)
+{
+        uint32_t hash = 0;
+
+        hash = (gfid[12] << 24) | (gfid[13] << 16) | (gfid[14] << 8) |
+                gfid[15];
+
+        return &table->buckets[hash % POSIX_XATTROP_BUCKETS];
+}
+
+
+static struct posix_xattrop_entry *
+__posix_xattrop_entry_get (struct posix_xattrop_table *table, uuid_t gfid)
+{
+        struct posix_xattrop_entry *entry = NULL;
+        struct list_head           *head  = NULL;
+
+        head = posix_xattrop_bucket (table, gfid);
+
+        list_for_each_entry (entry, head, hash) {
+                if (uuid_compare (entry->gfid, gfid) == 0)
+                        return entry;
+        }
+
+        return NULL;
+}
+
+
+static struct posix_xattrop_entry *
+__posix_xattrop_entry_new (struct posix_xattrop_table *table, uuid_t gfid)
+{
+        struct posix_xattrop_entry *entry = NULL;
+
+        entry = GF_CALLOC (1, sizeof (*entry), gf_posix_mt_xattrop_entry);
+        if (!entry)
+                return NULL;
+
+        entry->xattrs = dict_new ();
+        if (!entry->xattrs) {
+                GF_FREE (entry);
+                return NULL;
+        }
+
+        uuid_copy (entry->gfid, gfid);
+        list_add_tail (&entry->hash, posix_xattrop_bucket (table, gfid));
+        list_add_tail (&entry->list, &table->entries);
+        table->count++;
+
+        return entry;
+}
+
+
+static void
+__posix_xattrop_entry_free (struct posix_xattrop_table *table,
+                            struct posix_xattrop_entry *entry)
+{
+        list_del_init (&entry->hash);
+        list_del_init (&entry->list);
+        table->count--;
+
+        if (entry->inode)
+                inode_unref (entry->inode);
+        dict_unref (entry->xattrs);
+        GF_FREE (entry);
+}
+
+
+/* stores a copy of the len bytes of value as key of dict */
+static int
+posix_xattrop_dict_set (dict_t *dict, char *key, void *value, int len)
+{
+        char *copy = NULL;
+        int   ret  = -1;
+
+        copy = GF_CALLOC (len, sizeof (char), gf_posix_mt_char);
+        if (!copy)
+                return -ENOMEM;
+
+        memcpy (copy, value, len);
+
+        ret = dict_set_bin (dict, key, copy, len);
+        if (ret)
+                GF_FREE (copy);
+
+        return ret;
+}
+
+
+static size_t
+posix_xattrop_record_size (data_pair_t *trav)
+{
+        return sizeof (struct posix_xattrop_record) + strlen (trav->key) + 1 +
+                trav->value->len;
+}
+
+
+static char *
+posix_xattrop_record_fill (char *buf, uuid_t gfid, char *key, void *value,
+                           uint32_t vallen)
+{
+        struct posix_xattrop_record record = {0, };
+
+        record.magic = POSIX_XATTROP_MAGIC;
+        record.keylen = strlen (key) + 1;
+        record.vallen = vallen;
+        uuid_copy (record.gfid, gfid);
+
+        memcpy (buf, &record, sizeof (record));
+        buf += sizeof (record);
+
+        memcpy (buf, key, record.keylen);
+        buf += record.keylen;
+
+        if (vallen) {
+                memcpy (buf, value, vallen);
+                buf += vallen;
+        }
+
+        return buf;
+}
+
+
+/* a record without key, see posix_xattrop_replay() */
+static void
+posix_xattrop_drop_record_fill (struct posix_xattrop_record *record,
+                                uuid_t gfid)
+{
+        memset (record, 0, sizeof (*record));
+
+        record->magic = POSIX_XATTROP_MAGIC;
+        uuid_copy (record->gfid, gfid);
+}
+
+
+static int
+__posix_xattrop_journal_write (xlator_t *this,
+                               struct posix_xattrop_table *table,
+                               char *buf, size_t len)
+{
+        ssize_t ret = 0;
+
+        ret = write (table->journal_fd, buf, len);
+        if (ret != len) {
+                if (ret >= 0)
+                        errno = ENOSPC;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "write to the xattrop journal failed: %s",
+                        strerror (errno));
+                /* a partial record is ignored at replay */
+                return -errno;
+        }
+
+        table->journal_size += len;
+
+        return 0;
+}
+
+
+static int
+__posix_xattrop_journal_entry (xlator_t *this,
+                               struct posix_xattrop_table *table,
+                               struct posix_xattrop_entry *entry)
+{
+        data_pair_t *trav = NULL;
+        size_t       len  = 0;
+        char        *buf  = NULL;
+        char        *ptr  = NULL;
+        int          ret  = 0;
+
+        for (trav = entry->xattrs->members_list; trav; trav = trav->next)
+                len += posix_xattrop_record_size (trav);
+
+        if (!len)
+                return 0;
+
+        buf = GF_CALLOC (1, len, gf_posix_mt_char);
+        if (!buf)
+                return -ENOMEM;
+
+        ptr = buf;
+        for (trav = entry->xattrs->members_list; trav; trav = trav->next)
+                ptr = posix_xattrop_record_fill (ptr, entry->gfid, trav->key,
+                                                 trav->value->data,
+                                                 trav->value->len);
+
+        ret = __posix_xattrop_journal_write (this, table, buf, len);
+
+        GF_FREE (buf);
+
+        return ret;
+}
+
+
+/* one entry of the batch set on disk by posix_xattrop_flush_all() */
+struct posix_xattrop_flush {
+        struct list_head            list;
+        struct posix_xattrop_entry *entry;
+        dict_t                     *xattrs;
+        uint64_t                    version;
+        int                         ret;
+};
+
+
+/* sets xattrs on the gfid on disk: 0 when they are (or the gfid is gone),
+   -1 when they have to be kept */
+static int
+posix_xattrop_entry_set (xlator_t *this, uuid_t gfid, dict_t *xattrs)
+{
+        char        *real_path = NULL;
+        data_pair_t *trav      = NULL;
+        int          ret       = 0;
+
+        MAKE_HANDLE_PATH (real_path, this, gfid, NULL);
+        if (!real_path)
+                return 0;
+
+        for (trav = xattrs->members_list; trav; trav = trav->next) {
+                ret = sys_lsetxattr (real_path, trav->key, trav->value->data,
+                                     trav->value->len, 0);
+                if (ret == -1) {
+                        if (errno == ENOENT)
+                                return 0;
+
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "setxattr failed on %s while flushing "
+                                "xattrops: key=%s (%s)", real_path,
+                                trav->key, strerror (errno));
+                        return -1;
+                }
+        }
+
+        return 0;
+}
+
+
+/* sets the values of entry on disk and forgets it, for the gfid to be
+   changed there directly */
+static int
+__posix_xattrop_entry_drop (xlator_t *this, struct posix_xattrop_table *table,
+                            struct posix_xattrop_entry *entry)
+{
+        struct posix_xattrop_record record = {0, };
+        int                         ret    = 0;
+
+        ret = posix_xattrop_entry_set (this, entry->gfid, entry->xattrs);
+        if (ret)
+                return -EIO;
+
+        posix_xattr_cache_invalidate (this, entry->inode);
+
+        posix_xattrop_drop_record_fill (&record, entry->gfid);
+        __posix_xattrop_entry_free (table, entry);
+
+        /* the records of the gfid must not be replayed over what is set
+           on disk from now on */
+        if (!table->count && (ftruncate (table->journal_fd, 0) == 0)) {
+                table->journal_size = 0;
+                return 0;
+        }
+
+        return __posix_xattrop_journal_write (this, table, (char *)&record,
+                                              sizeof (record));
+}
+
+
+/* drops the entry of gfid, once the flush thread is done with it */
+static int
+__posix_xattrop_gfid_drop (xlator_t *this, struct posix_xattrop_table *table,
+                           uuid_t gfid)
+{
+        struct posix_xattrop_entry *entry = NULL;
+
+        while ((entry = __posix_xattrop_entry_get (table, gfid)) &&
+               entry->flushing)
+                pthread_cond_wait (&table->flushed, &table->lock);
+
+        if (!entry)
+                return 0;
+
+        return __posix_xattrop_entry_drop (this, table, entry);
+}
+
+
+/* the values are copied under the lock and set on disk out of it, so that
+   xattrops and lookups go on meanwhile. An entry changed in between is kept
+   for the next flush; one being flushed is not dropped, see
+   __posix_xattrop_gfid_drop(). */
+static void
+posix_xattrop_flush_all (xlator_t *this, struct posix_xattrop_table *table)
+{
+        struct posix_xattrop_entry *entry = NULL;
+        struct posix_xattrop_flush *flush = NULL;
+        struct posix_xattrop_flush *tmp   = NULL;
+        struct list_head            batch;
+
+        INIT_LIST_HEAD (&batch);
+
+        pthread_mutex_lock (&table->lock);
+        {
+                list_for_each_entry (entry, &table->entries, list) {
+                        flush = GF_CALLOC (1, sizeof (*flush),
+                                           gf_posix_mt_xattrop_flush);
+                        if (!flush)
+                                break;
+
+                        flush->xattrs = dict_copy_with_ref (entry->xattrs,
+                                                            NULL);
+                        if (!flush->xattrs) {
+                                GF_FREE (flush);
+                                break;
+                        }
+
+                        flush->entry = entry;
+                        flush->version = entry->version;
+                        entry->flushing = _gf_true;
+                        list_add_tail (&flush->list, &batch);
+                }
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        list_for_each_entry (flush, &batch, list)
+                flush->ret = posix_xattrop_entry_set (this, flush->entry->gfid,
+                                                      flush->xattrs);
+
+        pthread_mutex_lock (&table->lock);
+        {
+                list_for_each_entry_safe (flush, tmp, &batch, list) {
+                        entry = flush->entry;
+                        entry->flushing = _gf_false;
+
+                        if (!flush->ret) {
+                                posix_xattr_cache_invalidate (this,
+                                                              entry->inode);
+                                if (entry->version == flush->version)
+                                        __posix_xattrop_entry_free (table,
+                                                                    entry);
+                        }
+
+                        list_del_init (&flush->list);
+                        dict_unref (flush->xattrs);
+                        GF_FREE (flush);
+                }
+                pthread_cond_broadcast (&table->flushed);
+
+                if ((table->journal_fd == -1) ||
+                    (!table->count && !table->journal_size))
+                        goto unlock;
+
+                if (ftruncate (table->journal_fd, 0) == -1) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "truncating the xattrop journal failed: %s",
+                                strerror (errno));
+                        goto unlock;
+                }
+                table->journal_size = 0;
+
+                /* what is still pending, set since or not set, is written
+                   again */
+                list_for_each_entry (entry, &table->entries, list)
+                        __posix_xattrop_journal_entry (this, table, entry);
+        }
+unlock:
+        table->flushes++;
+        pthread_mutex_unlock (&table->lock);
+}
+
+
+static void *
+posix_xattrop_thread (void *data)
+{
+        xlator_t                   *this  = NULL;
+        struct posix_private       *priv  = NULL;
+        struct posix_xattrop_table *table = NULL;
+        struct timeval              tv    = {0, };
+        struct timespec             ts    = {0, };
+        gf_boolean_t                fini  = _gf_false;
+
+        this = data;
+        priv = this->private;
+        table = priv->xattrop;
+
+        THIS = this;
+
+        for (;;) {
+                pthread_mutex_lock (&table->lock);
+                {
+                        if (!table->fini &&
+                            (table->count < POSIX_XATTROP_MAX_PENDING) &&
+                            (table->journal_size < POSIX_XATTROP_JOURNAL_MAX)) {
+                                gettimeofday (&tv, NULL);
+                                ts.tv_sec  = tv.tv_sec + table->interval;
+                                ts.tv_nsec = tv.tv_usec * 1000;
+                                pthread_cond_timedwait (&table->cond,
+                                                        &table->lock, &ts);
+                        }
+                        fini = table->fini;
+                }
+                pthread_mutex_unlock (&table->lock);
+
+                if (fini)
+                        break;
+
+                posix_xattrop_flush_all (this, table);
+        }
+
+        return NULL;
+}
+
+
+static int
+posix_xattrop_replay (xlator_t *this, struct posix_xattrop_table *table)
+{
+        struct posix_xattrop_record  record  = {0, };
+        struct posix_xattrop_entry  *entry   = NULL;
+        struct stat                  stbuf   = {0, };
+        char                        *buf     = NULL;
+        char                        *ptr     = NULL;
+        char                        *key     = NULL;
+        size_t                       left    = 0;
+        int                          records = 0;
+        int                          ret     = -1;
+
+        if (fstat (table->journal_fd, &stbuf) == -1)
+                goto out;
+
+        if (!stbuf.st_size) {
+                ret = 0;
+                goto out;
+        }
+
+        buf = GF_CALLOC (1, stbuf.st_size, gf_posix_mt_char);
+        if (!buf)
+                goto out;
+
+        if (pread (table->journal_fd, buf, stbuf.st_size, 0) !=
+            stbuf.st_size) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "reading the xattrop journal failed: %s",
+                        strerror (errno));
+                goto out;
+        }
+
+        ptr = buf;
+        left = stbuf.st_size;
+        while (left >= sizeof (record)) {
+                memcpy (&record, ptr, sizeof (record));
+                if ((record.magic != POSIX_XATTROP_MAGIC) ||
+                    (left - sizeof (record) < record.keylen + record.vallen))
+                        break;
+
+                ptr += sizeof (record);
+                key = ptr;
+                if (record.keylen && key[record.keylen - 1] != '\0')
+                        break;
+
+                entry = __posix_xattrop_entry_get (table, record.gfid);
+                if (!record.keylen) {
+                        if (entry)
+                                __posix_xattrop_entry_free (table, entry);
+                } else {
+                        if (!entry)
+                                entry = __posix_xattrop_entry_new (table,
+                                                                   record.gfid);
+                        if (!entry)
+                                goto out;
+                        if (posix_xattrop_dict_set (entry->xattrs, key,
+                                                    ptr + record.keylen,
+                                                    record.vallen))
+                                goto out;
+                }
+
+                ptr  += record.keylen + record.vallen;
+                left -= sizeof (record) + record.keylen + record.vallen;
+                records++;
+        }
+
+        if (left)
+                gf_log (this->name, GF_LOG_WARNING,
+                        "ignoring the %zu bytes of incomplete records at the "
+                        "end of the xattrop journal", left);
+
+        gf_log (this->name, GF_LOG_INFO,
+                "replaying %d records of the xattrop journal on %u inodes",
+                records, table->count);
+
+        table->journal_size = stbuf.st_size;
+        posix_xattrop_flush_all (this, table);
+        ret = 0;
+out:
+        if (buf)
+                GF_FREE (buf);
+
+        return ret;
+}
+
+
+static void
+posix_xattrop_table_destroy (struct posix_xattrop_table *table)
+{
+        struct posix_xattrop_entry *entry = NULL;
+        struct posix_xattrop_entry *tmp   = NULL;
+
+        list_for_each_entry_safe (entry, tmp, &table->entries, list)
+                __posix_xattrop_entry_free (table, entry);
+
+        if (table->journal_fd != -1)
+                close (table->journal_fd);
+
+        pthread_cond_destroy (&table->flushed);
+        pthread_cond_destroy (&table->cond);
+        pthread_mutex_destroy (&table->lock);
+        GF_FREE (table);
+}
+
+
+int
+posix_xattrop_init (xlator_t *this, gf_boolean_t batch, int interval)
+{
+        struct posix_private       *priv  = NULL;
+        struct posix_xattrop_table *table = NULL;
+        char                       *path  = NULL;
+        int                         i     = 0;
+        int                         ret   = -1;
+
+        priv = this->private;
+
+        path = alloca (priv->base_path_length + strlen ("/" GF_HIDDEN_PATH
+                                                        "/") +
+                       strlen (POSIX_XATTROP_JOURNAL) + 1);
+        sprintf (path, "%s/" GF_HIDDEN_PATH "/" POSIX_XATTROP_JOURNAL,
+                 priv->base_path);
+
+        /* a journal left by a brick which had batching on is replayed
+           even if it is off now */
+        if (!batch && (access (path, F_OK) == -1))
+                return 0;
+
+        table = GF_CALLOC (1, sizeof (*table), gf_posix_mt_xattrop_table);
+        if (!table)
+                goto out;
+
+        pthread_mutex_init (&table->lock, NULL);
+        pthread_cond_init (&table->cond, NULL);
+        pthread_cond_init (&table->flushed, NULL);
+        for (i = 0; i < POSIX_XATTROP_BUCKETS; i++)
+                INIT_LIST_HEAD (&table->buckets[i]);
+        INIT_LIST_HEAD (&table->entries);
+        table->interval = interval;
+
+        table->journal_fd = open (path, O_CREAT | O_RDWR | O_APPEND, 0600);
+        if (table->journal_fd == -1) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "opening the xattrop journal %s failed: %s",
+                        path, strerror (errno));
+                goto out;
+        }
+
+        ret = posix_xattrop_replay (this, table);
+        if (ret) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "replaying the xattrop journal %s failed", path);
+                goto out;
+        }
+
+        if (!batch) {
+                if (table->count) {
+                        /* kept for the next start */
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "%u inodes of the xattrop journal could not "
+                                "be updated", table->count);
+                        ret = -1;
+                        goto out;
+                }
+                unlink (path);
+                goto out;
+        }
+
+        priv->xattrop = table;
+
+        ret = pthread_create (&table->thread, NULL, posix_xattrop_thread,
+                              this);
+        if (ret) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "spawning the xattrop flush thread failed: %s",
+                        strerror (ret));
+                priv->xattrop = NULL;
+                ret = -1;
+                goto out;
+        }
+
+        table = NULL;
+
+        gf_log (this->name, GF_LOG_INFO, "xattrops are batched, flushed "
+                "every %d seconds", interval);
+out:
+        if (table)
+                posix_xattrop_table_destroy (table);
+
+        return ret;
+}
+
+
+void
+posix_xattrop_fini (xlator_t *this)
+{
+        struct posix_private       *priv  = NULL;
+        struct posix_xattrop_table *table = NULL;
+
+        priv = this->private;
+        table = priv->xattrop;
+        if (!table)
+                return;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                table->fini = _gf_true;
+                pthread_cond_signal (&table->cond);
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        pthread_join (table->thread, NULL);
+
+        posix_xattrop_flush_all (this, table);
+
+        priv->xattrop = NULL;
+        posix_xattrop_table_destroy (table);
+}
+
+
+/* the value of key as on disk, zeroes if it is not set */
+static int
+posix_xattrop_disk_value (xlator_t *this, const char *real_path, int _fd,
+                          char *key, char *value, int len)
+{
+        ssize_t size = 0;
+
+        if (real_path)
+                size = sys_lgetxattr (real_path, key, value, len);
+        else
+                size = sys_fgetxattr (_fd, key, value, len);
+
+        if ((size == -1) && (errno != ENODATA) && (errno != ENOATTR)) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "getxattr failed on %s while doing xattrop: "
+                        "key=%s (%s)", real_path ? real_path : "<fd>",
+                        key, strerror (errno));
+                return -errno;
+        }
+
+        return 0;
+}
+
+
+int
+posix_xattrop_batch (xlator_t *this, inode_t *inode, const char *real_path,
+                     int _fd, gf_xattrop_flags_t optype, dict_t *xattr)
+{
+        struct posix_private       *priv    = NULL;
+        struct posix_xattrop_table *table   = NULL;
+        struct posix_xattrop_entry *entry   = NULL;
+        data_pair_t                *trav    = NULL;
+        data_t                     *pending = NULL;
+        dict_t                     *values  = NULL;
+        char                       *array   = NULL;
+        char                       *buf     = NULL;
+        char                       *ptr     = NULL;
+        size_t                      len     = 0;
+        int                         ret     = 1;
+
+        priv = this->private;
+        table = priv->xattrop;
+
+        if (!table || !inode || uuid_is_null (inode->gfid) ||
+            !xattr->members_list)
+                return 1;
+
+        if ((optype != GF_XATTROP_ADD_ARRAY) &&
+            (optype != GF_XATTROP_ADD_ARRAY64))
+                return 1;
+
+        values = dict_new ();
+        if (!values)
+                return -ENOMEM;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                entry = __posix_xattrop_entry_get (table, inode->gfid);
+
+                for (trav = xattr->members_list; trav; trav = trav->next) {
+                        pending = NULL;
+                        if (entry)
+                                pending = dict_get (entry->xattrs, trav->key);
+                        if (pending && (pending->len != trav->value->len)) {
+                                /* not ours to interpret, done on disk */
+                                ret = __posix_xattrop_gfid_drop (this, table,
+                                                                 inode->gfid);
+                                if (!ret)
+                                        ret = 1;
+                                goto unlock;
+                        }
+
+                        array = GF_CALLOC (trav->value->len, sizeof (char),
+                                           gf_posix_mt_char);
+                        if (!array) {
+                                ret = -ENOMEM;
+                                goto unlock;
+                        }
+
+                        if (pending) {
+                                memcpy (array, pending->data, pending->len);
+                        } else {
+                                ret = posix_xattrop_disk_value (this,
+                                                                real_path,
+                                                                _fd,
+                                                                trav->key,
+                                                                array,
+                                                                trav->value->len);
+                                if (ret)
+                                        goto unlock;
+                        }
+
+                        if (optype == GF_XATTROP_ADD_ARRAY)
+                                __add_array ((int32_t *) array,
+                                             (int32_t *) trav->value->data,
+                                             trav->value->len / 4);
+                        else
+                                __add_long_array ((int64_t *) array,
+                                                  (int64_t *) trav->value->data,
+                                                  trav->value->len / 8);
+
+                        ret = dict_set_bin (values, trav->key, array,
+                                            trav->value->len);
+                        if (ret) {
+                                ret = -ENOMEM;
+                                goto unlock;
+                        }
+                        array = NULL;
+
+                        len += posix_xattrop_record_size (trav);
+                }
+
+                /* written ahead of being answered */
+                buf = GF_CALLOC (1, len, gf_posix_mt_char);
+                if (!buf) {
+                        ret = -ENOMEM;
+                        goto unlock;
+                }
+
+                ptr = buf;
+                for (trav = values->members_list; trav; trav = trav->next)
+                        ptr = posix_xattrop_record_fill (ptr, inode->gfid,
+                                                         trav->key,
+                                                         trav->value->data,
+                                                         trav->value->len);
+
+                ret = __posix_xattrop_journal_write (this, table, buf, len);
+                if (ret)
+                        goto unlock;
+
+                if (!entry) {
+                        entry = __posix_xattrop_entry_new (table,
+                                                           inode->gfid);
+                        if (!entry) {
+                                ret = -ENOMEM;
+                                goto unlock;
+                        }
+                }
+                if (!entry->inode)
+                        entry->inode = inode_ref (inode);
+                entry->version++;
+
+                for (trav = values->members_list; trav; trav = trav->next) {
+                        ret = posix_xattrop_dict_set (entry->xattrs,
+                                                      trav->key,
+                                                      trav->value->data,
+                                                      trav->value->len);
+                        if (!ret)
+                                ret = posix_xattrop_dict_set (xattr,
+                                                              trav->key,
+                                                              trav->value->data,
+                                                              trav->value->len);
+                        if (ret) {
+                                ret = -ENOMEM;
+                                goto unlock;
+                        }
+                }
+
+                table->updates++;
+                if ((table->count >= POSIX_XATTROP_MAX_PENDING) ||
+                    (table->journal_size >= POSIX_XATTROP_JOURNAL_MAX))
+                        pthread_cond_signal (&table->cond);
+
+                ret = 0;
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+
+        if (array)
+                GF_FREE (array);
+        if (buf)
+                GF_FREE (buf);
+        dict_unref (values);
+
+        return ret;
+}
+
+
+int
+posix_xattrop_flush_gfid (xlator_t *this, uuid_t gfid)
+{
+        struct posix_private       *priv   = NULL;
+        struct posix_xattrop_table *table  = NULL;
+        int                         ret    = 0;
+
+        priv = this->private;
+        table = priv->xattrop;
+
+        if (!table || uuid_is_null (gfid))
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                ret = __posix_xattrop_gfid_drop (this, table, gfid);
+        }
+        pthread_mutex_unlock (&table->lock);
+
+        return ret;
+}
+
+
+int
+posix_xattrop_overlay (xlator_t *this, uuid_t gfid, const char *name,
+                       dict_t *req, dict_t *xattr)
+{
+        struct posix_private       *priv  = NULL;
+        struct posix_xattrop_table *table = NULL;
+        struct posix_xattrop_entry *entry = NULL;
+        data_pair_t                *trav  = NULL;
+        int                         count = 0;
+
+        priv = this->private;
+        table = priv->xattrop;
+
+        if (!table || !xattr || uuid_is_null (gfid))
+                return 0;
+
+        pthread_mutex_lock (&table->lock);
+        {
+                if (!table->count)
+                        goto unlock;
+
+                entry = __posix_xattrop_entry_get (table, gfid);
+                if (!entry)
+                        goto unlock;
+
+                for (trav = entry->xattrs->members_list; trav;
+                     trav = trav->next) {
+                        if (name && strcmp (name, trav->key))
+                                continue;
+                        if (req && !dict_get (req, trav->key))
+                                continue;
+
+                        if (posix_xattrop_dict_set (xattr, trav->key,
+                                                    trav->value->data,
+                                                    trav->value->len) == 0)
+                                count++;
+                }
+        }
+unlock:
+        pthread_mutex_unlock (&table->lock);
+
+        return count;
+}
+
+
+dict_t *
+posix_xattrop_snapshot (xlator_t *this, uuid_t gfid, dict_t *req)
+{
+        struct posix_private *priv    = NULL;
+        dict_t               *pending = NULL;
+
+        priv = this->private;
+        if (!priv->xattrop || uuid_is_null (gfid))
+                return NULL;
+
+        pending = dict_new ();
+        if (!pending)
+                return NULL;
+
+        if (!posix_xattrop_overlay (this, gfid, NULL, req, pending)) {
+                dict_unref (pending);
+                return NULL;
+        }
+
+        return pending;
+}
@@ -0,0 +1,94 @@
+/*
+   Copyright (c) 2012 Gluster, Inc. <http://www.gluster.com>
+   This file is part of GlusterFS.
+
+   GlusterFS is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published
+   by the Free Software Foundation; either version 3 of the License,
+   or (at your option) any later version.
+
+   GlusterFS is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see
+   <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _POSIX_XATTROP_H
+#define _POSIX_XATTROP_H
+
+#ifndef _CONFIG_H
+#define _CONFIG_H
+#include "config.h"
+#endif
+
+#include <pthread.h>
+
+#include "xlator.h"
+#include "glusterfs.h"
+#include "list.h"
+
+/* journal of the pending values, under the hidden directory of the brick */
+#define POSIX_XATTROP_JOURNAL           "xattrop-journal"
+
+#define POSIX_XATTROP_BUCKETS           1024
+/* the flush thread is woken up early past any of these */
+#define POSIX_XATTROP_MAX_PENDING       1024
+#define POSIX_XATTROP_JOURNAL_MAX       (8 * 1024 * 1024)
+
+#define POSIX_XATTROP_FLUSH_INTERVAL    1
+
+/**
+ * posix_xattrop_entry - the values of the xattrop'ed keys of a gfid, as
+ * they are to be on disk, which are not set on it yet.
+ */
+struct posix_xattrop_entry {
+        struct list_head  hash;
+        struct list_head  list;
+        uuid_t            gfid;
+        inode_t          *inode;   /* NULL when replayed from the journal */
+        dict_t           *xattrs;
+        uint64_t          version;  /* bumped at each change of xattrs */
+        gf_boolean_t      flushing; /* being set on disk by the flush thread */
+};
+
+struct posix_xattrop_table {
+        pthread_mutex_t   lock;
+        pthread_cond_t    cond;
+        pthread_cond_t    flushed;  /* signalled at the end of each flush */
+        struct list_head  buckets[POSIX_XATTROP_BUCKETS];
+        struct list_head  entries;
+        uint32_t          count;
+        int               journal_fd;
+        off_t             journal_size;
+        int               interval;
+        gf_boolean_t      fini;
+        pthread_t         thread;
+        uint64_t          updates;
+        uint64_t          flushes;
+};
+
+int posix_xattrop_init (xlator_t *this, gf_boolean_t batch, int interval);
+void posix_xattrop_fini (xlator_t *this);
+
+/* 0 when the deltas of xattr were applied and it holds the new values,
+   1 when the xattrop has to be done on disk, -errno on failure */
+int posix_xattrop_batch (xlator_t *this, inode_t *inode, const char *real_path,
+                         int _fd, gf_xattrop_flags_t optype, dict_t *xattr);
+
+/* sets the pending values of gfid on disk, before it is changed directly */
+int posix_xattrop_flush_gfid (xlator_t *this, uuid_t gfid);
+
+/* sets the pending values of gfid in xattr, all of them or only name or
+   the keys of req; returns the number of keys set */
+int posix_xattrop_overlay (xlator_t *this, uuid_t gfid, const char *name,
+                           dict_t *req, dict_t *xattr);
+
+/* the pending values of gfid, or of the keys of req, to be set over the
+   values read from disk after it was taken; NULL when there are none */
+dict_t *posix_xattrop_snapshot (xlator_t *this, uuid_t gfid, dict_t *req);
+
+#endif /* _POSIX_XATTROP_H */
@@ -41,12 +41,49 @@
 #include <fcntl.h>
 #endif /* HAVE_LINKAT */
 
+#ifdef GF_LINUX_HOST_OS
+#include <fcntl.h>
+#include <linux/falloc.h>
+
+/* older headers, a kernel without them fails the mode with EOPNOTSUPP */
+#ifndef FALLOC_FL_KEEP_SIZE
+#define FALLOC_FL_KEEP_SIZE  0x01
+#endif
+#ifndef FALLOC_FL_PUNCH_HOLE
+#define FALLOC_FL_PUNCH_HOLE 0x02
+#endif
+#ifndef FALLOC_FL_ZERO_RANGE
+#define FALLOC_FL_ZERO_RANGE 0x10
+#endif
+
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+/* struct file_clone_range and FICLONERANGE of linux/fs.h, which older
+   headers do not have */
+struct posix_clone_range {
+        int64_t  src_fd;
+        uint64_t src_offset;
+        uint64_t src_length;
+        uint64_t dest_offset;
+};
+#define POSIX_FICLONERANGE _IOW (0x94, 13, struct posix_clone_range)
+#else
+#define FALLOC_FL_KEEP_SIZE  0x01
+#define FALLOC_FL_PUNCH_HOLE 0x02
+#define FALLOC_FL_ZERO_RANGE 0x10
+#endif /* GF_LINUX_HOST_OS */
+
 #include "glusterfs.h"
 #include "md5.h"
 #include "checksum.h"
 #include "dict.h"
 #include "logging.h"
 #include "posix.h"
+#include "posix-aio.h"
+#include "posix-xattrop.h"
+#include "posix-pack.h"
+#include "posix-readdirp.h"
 #include "xlator.h"
 #include "defaults.h"
 #include "common-utils.h"
@@ -89,7 +126,8 @@ posix_forget (xlator_t *this, inode_t *inode)
 {
         uint64_t tmp_cache = 0;
         if (!inode_ctx_del (inode, this, &tmp_cache))
-                dict_destroy ((dict_t *)(long)tmp_cache);
+                posix_xattr_cache_free ((struct posix_xattr_cache *)
+                                        (long)tmp_cache);
 
         return 0;
 }
@@ -114,6 +152,9 @@ posix_lookup (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (loc, out);
         VALIDATE_OR_GOTO (loc->path, out);
 
+        if (posix_pack_lookup (frame, this, loc, xattr_req))
+                return 0;
+
         if (uuid_is_null (loc->pargfid)) {
                 /* nameless lookup */
                 MAKE_INODE_HANDLE (real_path, this, loc, &buf);
@@ -187,6 +228,9 @@ posix_stat (call_frame_t *frame, xlator_t *this, loc_t *loc)
         priv = this->private;
         VALIDATE_OR_GOTO (priv, out);
 
+        if (posix_pack_stat (frame, this, loc))
+                return 0;
+
         SET_FS_ID (frame->root->uid, frame->root->gid);
 
         MAKE_INODE_HANDLE (real_path, this, loc, &buf);
@@ -323,6 +367,9 @@ posix_setattr (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (this, out);
         VALIDATE_OR_GOTO (loc, out);
 
+        if (posix_pack_setattr (frame, this, loc, NULL, stbuf, valid))
+                return 0;
+
         SET_FS_ID (frame->root->uid, frame->root->gid);
         MAKE_INODE_HANDLE (real_path, this, loc, &statpre);
 
@@ -336,6 +383,8 @@ posix_setattr (call_frame_t *frame, xlator_t *this,
 
         if (valid & GF_SET_ATTR_MODE) {
                 op_ret = posix_do_chmod (this, real_path, stbuf);
+                /* chmod updates the mask of the access ACL */
+                posix_xattr_cache_invalidate (this, loc->inode);
                 if (op_ret == -1) {
                         op_errno = errno;
                         gf_log (this->name, GF_LOG_ERROR,
@@ -461,6 +510,11 @@ posix_fsetattr (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (this, out);
         VALIDATE_OR_GOTO (fd, out);
 
+        if (posix_pack_setattr (frame, this, NULL, fd, stbuf, valid)) {
+                SET_TO_OLD_FS_ID ();
+                return 0;
+        }
+
         ret = posix_fd_ctx_get (fd, this, &pfd);
         if (ret < 0) {
                 op_errno = -ret;
@@ -480,6 +534,7 @@ posix_fsetattr (call_frame_t *frame, xlator_t *this,
 
         if (valid & GF_SET_ATTR_MODE) {
                 op_ret = posix_do_fchmod (this, pfd->fd, stbuf);
+                posix_xattr_cache_invalidate (this, fd->inode);
                 if (op_ret == -1) {
                         op_errno = errno;
                         gf_log (this->name, GF_LOG_ERROR,
@@ -987,6 +1042,9 @@ posix_unlink (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (this, out);
         VALIDATE_OR_GOTO (loc, out);
 
+        if (posix_pack_unlink (frame, this, loc))
+                return 0;
+
         SET_FS_ID (frame->root->uid, frame->root->gid);
         MAKE_ENTRY_HANDLE (real_path, par_path, this, loc, &stbuf);
 
@@ -1051,6 +1109,49 @@ out:
 }
 
 
+/* whether the sender of frame may remove the tree of the directory
+   stbuf in parent: what rmdir checks, and the ownership of the directory
+   as the permissions of what is below it are not looked at */
+static int
+posix_rmtree_permitted (call_frame_t *frame, struct iatt *parent,
+                        struct iatt *stbuf)
+{
+        uid_t    uid  = frame->root->uid;
+        int      perm = 0;
+        int      i    = 0;
+
+        if (uid == 0)
+                return 0;
+
+        if (uid == parent->ia_uid) {
+                perm = parent->ia_prot.owner.write && parent->ia_prot.owner.exec;
+        } else {
+                perm = -1;
+                if (frame->root->gid == parent->ia_gid)
+                        perm = 1;
+                for (i = 0; (perm == -1) && (i < frame->root->ngrps); i++) {
+                        if (frame->root->groups[i] == parent->ia_gid)
+                                perm = 1;
+                }
+
+                if (perm == 1)
+                        perm = parent->ia_prot.group.write &&
+                                parent->ia_prot.group.exec;
+                else
+                        perm = parent->ia_prot.other.write &&
+                                parent->ia_prot.other.exec;
+        }
+
+        if (!perm)
+                return EACCES;
+
+        if (uid != stbuf->ia_uid)
+                return EPERM;
+
+        return 0;
+}
+
+
 int
 posix_rmdir (call_frame_t *frame, xlator_t *this,
              loc_t *loc, int flags)
@@ -1085,13 +1186,48 @@ posix_rmdir (call_frame_t *frame, xlator_t *this,
         }
 
         if (flags) {
-                uint32_t hashval = 0;
-                char *tmp_path = alloca (strlen (priv->trash_path) + 16);
+                /* the whole tree goes to the trash under the gfid of the
+                   directory, which the janitor empties */
+                char *tmp_path = alloca (strlen (priv->trash_path) + 40);
+
+                op_errno = posix_rmtree_permitted (frame, &preparent,
+                                                   &stbuf);
+                if (op_errno) {
+                        op_ret = -1;
+                        gf_log (this->name, GF_LOG_DEBUG,
+                                "removal of the tree of %s denied: %s",
+                                real_path, strerror (op_errno));
+                        goto out;
+                }
+
+                /* the trash is root's, the move is done as root */
+                SET_TO_OLD_FS_ID ();
 
                 mkdir (priv->trash_path, 0755);
-                hashval = gf_dm_hashfn (real_path, strlen (real_path));
-                sprintf (tmp_path, "%s/%u", priv->trash_path, hashval);
+                sprintf (tmp_path, "%s/%s", priv->trash_path,
+                         uuid_utoa (stbuf.ia_gfid));
                 op_ret = rename (real_path, tmp_path);
+                op_errno = errno;
+
+                SET_FS_ID (frame->root->uid, frame->root->gid);
+                errno = op_errno;
+
+                if (op_ret == 0) {
+                        /* cached handle paths of the subdirectories go
+                           through the old name */
+                        posix_handle_cache_flush (this);
+
+                        pthread_mutex_lock (&priv->janitor_lock);
+                        {
+                                priv->janitor_trash_pending++;
+                                pthread_cond_signal (&priv->janitor_cond);
+                        }
+                        pthread_mutex_unlock (&priv->janitor_lock);
+                }
+        } else if (posix_pack_rmdir (this, stbuf.ia_gfid)) {
+                /* packed files are entries of it too */
+                op_ret = -1;
+                errno = ENOTEMPTY;
         } else {
                 op_ret = rmdir (real_path);
         }
@@ -1362,6 +1498,10 @@ posix_rename (call_frame_t *frame, xlator_t *this,
                 goto out;
         }
 
+        /* cached handle paths may go through the old name */
+        if (IA_ISDIR (oldloc->inode->ia_type))
+                posix_handle_cache_flush (this);
+
         if (was_dir)
                 posix_handle_unset (this, victim, NULL);
 
@@ -1532,6 +1672,9 @@ posix_truncate (call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset)
         priv = this->private;
         VALIDATE_OR_GOTO (priv, out);
 
+        if (posix_pack_truncate (frame, this, loc, NULL, offset))
+                return 0;
+
         SET_FS_ID (frame->root->uid, frame->root->gid);
 
         MAKE_INODE_HANDLE (real_path, this, loc, &prebuf);
@@ -1605,6 +1748,12 @@ posix_create (call_frame_t *frame, xlator_t *this,
 
         MAKE_ENTRY_HANDLE (real_path, par_path, this, loc, &stbuf);
 
+        /* a new regular file may be packed instead */
+        if ((op_ret == -1) && (errno == ENOENT) &&
+            posix_pack_create (frame, this, loc, flags, mode, fd, params,
+                               par_path))
+                return 0;
+
         gid = frame->root->gid;
 
         SET_FS_ID (frame->root->uid, gid);
@@ -1704,6 +1853,7 @@ posix_create (call_frame_t *frame, xlator_t *this,
 
         pfd->flags = flags;
         pfd->fd    = _fd;
+        pfd->odirect = ((_flags & O_DIRECT) != 0);
 
         op_ret = fd_ctx_set (fd, this, (uint64_t)(long)pfd);
         if (op_ret)
@@ -1760,6 +1910,9 @@ posix_open (call_frame_t *frame, xlator_t *this,
         priv = this->private;
         VALIDATE_OR_GOTO (priv, out);
 
+        if (posix_pack_open (frame, this, loc, flags, fd, wbflags))
+                return 0;
+
         MAKE_INODE_HANDLE (real_path, this, loc, &stbuf);
 
         SET_FS_ID (frame->root->uid, frame->root->gid);
@@ -1784,6 +1937,7 @@ posix_open (call_frame_t *frame, xlator_t *this,
 
         pfd->flags = flags;
         pfd->fd    = _fd;
+        pfd->odirect = ((flags & O_DIRECT) != 0);
         if (wbflags == GF_OPEN_FSYNC)
                 pfd->flushwrites = 1;
 
@@ -1815,9 +1969,6 @@ out:
         return 0;
 }
 
-#define ALIGN_BUF(ptr,bound) ((void *)((unsigned long)(ptr + bound - 1) & \
-                                       (unsigned long)(~(bound - 1))))
-
 int
 posix_readv (call_frame_t *frame, xlator_t *this,
              fd_t *fd, size_t size, off_t offset)
@@ -1841,6 +1992,9 @@ posix_readv (call_frame_t *frame, xlator_t *this,
         priv = this->private;
         VALIDATE_OR_GOTO (priv, out);
 
+        if (posix_pack_readv (frame, this, fd, size, offset))
+                return 0;
+
         ret = posix_fd_ctx_get (fd, this, &pfd);
         if (ret < 0) {
                 op_errno = -ret;
@@ -1855,6 +2009,57 @@ posix_readv (call_frame_t *frame, xlator_t *this,
                 goto out;
         }
 
+        /* only a reference to the data is returned, protocol/server has
+           the transport send it from the file */
+        if (priv->zero_copy_read && frame->root->trans && !pfd->odirect &&
+            (size >= POSIX_ZERO_COPY_MIN_SIZE)) {
+                _fd = pfd->fd;
+                op_ret = posix_fdstat (this, _fd, &stbuf);
+                if (op_ret == -1) {
+                        op_errno = errno;
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "fstat failed on fd=%p: %s", fd,
+                                strerror (op_errno));
+                        goto out;
+                }
+
+                if (offset < stbuf.ia_size)
+                        vec.iov_len = min (size, stbuf.ia_size - offset);
+
+                iobref = iobref_new ();
+                if (!iobref) {
+                        op_ret = -1;
+                        op_errno = ENOMEM;
+                        goto out;
+                }
+
+                if (vec.iov_len) {
+                        ret = iobref_add_file (iobref, _fd, offset,
+                                               vec.iov_len);
+                        if (ret) {
+                                op_ret = -1;
+                                op_errno = -ret;
+                                goto out;
+                        }
+                }
+
+                LOCK (&priv->lock);
+                {
+                        priv->read_value    += vec.iov_len;
+                }
+                UNLOCK (&priv->lock);
+
+                if ((offset + vec.iov_len) >= stbuf.ia_size)
+                        op_errno = ENOENT;
+
+                op_ret = vec.iov_len;
+                goto out;
+        }
+
+        if (priv->aio_capable &&
+            !posix_aio_readv (frame, this, fd, pfd, size, offset))
+                return 0;
+
         iobuf = iobuf_get2 (this->ctx->iobuf_pool, size);
         if (!iobuf) {
                 op_errno = ENOMEM;
@@ -2028,6 +2233,9 @@ posix_writev (call_frame_t *frame, xlator_t *this,
 
         VALIDATE_OR_GOTO (priv, out);
 
+        if (posix_pack_writev (frame, this, fd, vector, count, offset))
+                return 0;
+
         ret = posix_fd_ctx_get (fd, this, &pfd);
         if (ret < 0) {
                 gf_log (this->name, GF_LOG_WARNING,
@@ -2047,6 +2255,11 @@ posix_writev (call_frame_t *frame, xlator_t *this,
                 goto out;
         }
 
+        if (priv->aio_capable &&
+            !posix_aio_writev (frame, this, fd, pfd, vector, count, offset,
+                               iobref, &preop))
+                return 0;
+
         op_ret = __posix_writev (_fd, vector, count, offset,
                                  (pfd->flags & O_DIRECT));
         if (op_ret < 0) {
@@ -2152,6 +2365,9 @@ posix_flush (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (this, out);
         VALIDATE_OR_GOTO (fd, out);
 
+        if (posix_pack_flush (frame, this, fd))
+                return 0;
+
         ret = posix_fd_ctx_get (fd, this, &pfd);
         if (ret < 0) {
                 op_errno = -ret;
@@ -2183,6 +2399,9 @@ posix_release (xlator_t *this,
 
         priv = this->private;
 
+        if (posix_pack_release (this, fd))
+                return 0;
+
         ret = fd_ctx_del (fd, this, &tmp_pfd);
         if (ret < 0) {
                 gf_log (this->name, GF_LOG_WARNING,
@@ -2227,6 +2446,7 @@ posix_fsync (call_frame_t *frame, xlator_t *this,
         int               ret      = -1;
         struct iatt       preop = {0,};
         struct iatt       postop = {0,};
+        struct posix_private *priv = NULL;
 
         DECLARE_OLD_FS_ID_VAR;
 
@@ -2234,6 +2454,11 @@ posix_fsync (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (this, out);
         VALIDATE_OR_GOTO (fd, out);
 
+        priv = this->private;
+
+        if (posix_pack_fsync (frame, this, fd))
+                return 0;
+
         SET_FS_ID (frame->root->uid, frame->root->gid);
 
 #ifdef GF_DARWIN_HOST_OS
@@ -2261,6 +2486,12 @@ posix_fsync (call_frame_t *frame, xlator_t *this,
                 goto out;
         }
 
+        if (priv->aio_capable && priv->aio_fsync &&
+            !posix_aio_fsync (frame, this, fd, pfd, datasync, &preop)) {
+                SET_TO_OLD_FS_ID ();
+                return 0;
+        }
+
         if (datasync) {
                 ;
 #ifdef HAVE_FDATASYNC
@@ -2321,10 +2552,22 @@ posix_setxattr (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (loc, out);
         VALIDATE_OR_GOTO (dict, out);
 
+        if (posix_pack_setxattr (frame, this, loc, NULL, dict, flags)) {
+                SET_TO_OLD_FS_ID ();
+                return 0;
+        }
+
         MAKE_INODE_HANDLE (real_path, this, loc, NULL);
 
         dict_del (dict, GFID_XATTR_KEY);
 
+        ret = posix_xattrop_flush_gfid (this, loc->inode ? loc->inode->gfid
+                                        : loc->gfid);
+        if (ret < 0) {
+                op_errno = -ret;
+                goto out;
+        }
+
         trav = dict->members_list;
 
         while (trav) {
@@ -2339,6 +2582,9 @@ posix_setxattr (call_frame_t *frame, xlator_t *this,
         op_ret = 0;
 
 out:
+        if (loc)
+                posix_xattr_cache_invalidate (this, loc->inode);
+
         SET_TO_OLD_FS_ID ();
 
         STACK_UNWIND_STRICT (setxattr, frame, op_ret, op_errno);
@@ -2368,6 +2614,7 @@ posix_getxattr (call_frame_t *frame, xlator_t *this,
         char *   real_path      = NULL;
         dict_t * dict           = NULL;
         char *   file_contents  = NULL;
+        dict_t * pending        = NULL;
         int      ret            = -1;
 
         DECLARE_OLD_FS_ID_VAR;
@@ -2376,6 +2623,9 @@ posix_getxattr (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (this, out);
         VALIDATE_OR_GOTO (loc, out);
 
+        if (posix_pack_getxattr (frame, this, loc, NULL, name))
+                return 0;
+
         SET_FS_ID (frame->root->uid, frame->root->gid);
         MAKE_INODE_HANDLE (real_path, this, loc, NULL);
 
@@ -2416,6 +2666,27 @@ posix_getxattr (call_frame_t *frame, xlator_t *this,
                 }
                 goto done;
         }
+        if (name && !strcmp (name, GF_XATTR_RMTREE_STATUS_KEY)) {
+                pthread_mutex_lock (&priv->janitor_lock);
+                {
+                        snprintf (host_buf, 1024, "pending=%"PRIu64
+                                  " removed=%"PRIu64,
+                                  priv->janitor_trash_pending,
+                                  priv->janitor_removed);
+                }
+                pthread_mutex_unlock (&priv->janitor_lock);
+
+                size = strlen (host_buf) + 1;
+                ret = dict_set_dynstr (dict, GF_XATTR_RMTREE_STATUS_KEY,
+                                       gf_strdup (host_buf));
+                if (ret < 0) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "could not set value (%s) in dictionary",
+                                host_buf);
+                }
+                goto done;
+        }
+
         if (loc->inode && name &&
             (strcmp (name, GF_XATTR_PATHINFO_KEY) == 0)) {
                 snprintf (host_buf, 1024, "<POSIX:%s:%s>", priv->hostname,
@@ -2434,6 +2705,12 @@ posix_getxattr (call_frame_t *frame, xlator_t *this,
         if (name) {
                 strcpy (key, name);
 
+                if (posix_xattrop_overlay (this, loc->inode ? loc->inode->gfid
+                                           : loc->gfid, key, NULL, dict)) {
+                        size = dict_get (dict, key)->len;
+                        goto done;
+                }
+
                 size = sys_lgetxattr (real_path, key, NULL, 0);
                 if (size == -1) {
                         op_ret = -1;
@@ -2459,6 +2736,10 @@ posix_getxattr (call_frame_t *frame, xlator_t *this,
                 goto done;
         }
 
+        /* taken first, the flush thread may set it on disk meanwhile */
+        pending = posix_xattrop_snapshot (this, loc->inode ? loc->inode->gfid
+                                          : loc->gfid, NULL);
+
         size = sys_llistxattr (real_path, NULL, 0);
         if (size == -1) {
                 op_errno = errno;
@@ -2523,6 +2804,10 @@ posix_getxattr (call_frame_t *frame, xlator_t *this,
         } /* while (remaining_size > 0) */
 
 done:
+        /* xattrops not flushed yet */
+        if (pending)
+                dict_copy (pending, dict);
+
         op_ret = size;
 
         if (dict) {
@@ -2537,6 +2822,8 @@ out:
 
         if (dict)
                 dict_unref (dict);
+        if (pending)
+                dict_unref (pending);
 
         return 0;
 }
@@ -2557,6 +2844,7 @@ posix_fgetxattr (call_frame_t *frame, xlator_t *this,
         char *            value          = NULL;
         char *            list           = NULL;
         dict_t *          dict           = NULL;
+        dict_t *          pending        = NULL;
         int               ret            = -1;
 
         DECLARE_OLD_FS_ID_VAR;
@@ -2565,6 +2853,9 @@ posix_fgetxattr (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (this, out);
         VALIDATE_OR_GOTO (fd, out);
 
+        if (posix_pack_getxattr (frame, this, NULL, fd, name))
+                return 0;
+
         SET_FS_ID (frame->root->uid, frame->root->gid);
 
         ret = posix_fd_ctx_get (fd, this, &pfd);
@@ -2592,9 +2883,24 @@ posix_fgetxattr (call_frame_t *frame, xlator_t *this,
                 goto done;
         }
 
+        if (name && !strcmp (name, GF_XATTR_DATA_EXTENTS_KEY)) {
+                ret = posix_fd_data_extents (this, _fd, dict);
+                if (ret) {
+                        op_errno = -ret;
+                        goto out;
+                }
+                goto done;
+        }
+
         if (name) {
                 strcpy (key, name);
 
+                if (posix_xattrop_overlay (this, fd->inode->gfid, key, NULL,
+                                           dict)) {
+                        size = dict_get (dict, key)->len;
+                        goto done;
+                }
+
                 size = sys_fgetxattr (_fd, key, NULL, 0);
                 value = GF_CALLOC (size + 1, sizeof(char), gf_posix_mt_char);
                 if (!value) {
@@ -2614,6 +2920,9 @@ posix_fgetxattr (call_frame_t *frame, xlator_t *this,
                 goto done;
         }
 
+        /* taken first, the flush thread may set it on disk meanwhile */
+        pending = posix_xattrop_snapshot (this, fd->inode->gfid, NULL);
+
         size = sys_flistxattr (_fd, NULL, 0);
         if (size == -1) {
                 op_errno = errno;
@@ -2675,6 +2984,10 @@ posix_fgetxattr (call_frame_t *frame, xlator_t *this,
         } /* while (remaining_size > 0) */
 
 done:
+        /* xattrops not flushed yet */
+        if (pending)
+                dict_copy (pending, dict);
+
         op_ret = size;
 
         if (dict) {
@@ -2689,6 +3002,8 @@ out:
 
         if (dict)
                 dict_unref (dict);
+        if (pending)
+                dict_unref (pending);
 
         return 0;
 }
@@ -2713,6 +3028,11 @@ posix_fsetxattr (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (fd, out);
         VALIDATE_OR_GOTO (dict, out);
 
+        if (posix_pack_setxattr (frame, this, NULL, fd, dict, flags)) {
+                SET_TO_OLD_FS_ID ();
+                return 0;
+        }
+
         ret = posix_fd_ctx_get (fd, this, &pfd);
         if (ret < 0) {
                 op_errno = -ret;
@@ -2724,6 +3044,12 @@ posix_fsetxattr (call_frame_t *frame, xlator_t *this,
 
         dict_del (dict, GFID_XATTR_KEY);
 
+        ret = posix_xattrop_flush_gfid (this, fd->inode->gfid);
+        if (ret < 0) {
+                op_errno = -ret;
+                goto out;
+        }
+
         trav = dict->members_list;
 
         while (trav) {
@@ -2738,6 +3064,9 @@ posix_fsetxattr (call_frame_t *frame, xlator_t *this,
         op_ret = 0;
 
 out:
+        if (fd)
+                posix_xattr_cache_invalidate (this, fd->inode);
+
         SET_TO_OLD_FS_ID ();
 
         STACK_UNWIND_STRICT (fsetxattr, frame, op_ret, op_errno);
@@ -2767,7 +3096,16 @@ posix_removexattr (call_frame_t *frame, xlator_t *this,
 
         SET_FS_ID (frame->root->uid, frame->root->gid);
 
+        op_ret = posix_xattrop_flush_gfid (this, loc->inode ? loc->inode->gfid
+                                           : loc->gfid);
+        if (op_ret < 0) {
+                op_errno = -op_ret;
+                op_ret = -1;
+                goto out;
+        }
+
         op_ret = sys_lremovexattr (real_path, name);
+        posix_xattr_cache_invalidate (this, loc->inode);
         if (op_ret == -1) {
                 op_errno = errno;
                 if (op_errno != ENOATTR && op_errno != EPERM)
@@ -2835,7 +3173,7 @@ posix_print_xattr (dict_t *this,
  * FIXME: handle overflow
  */
 
-static void
+void
 __add_array (int32_t *dest, int32_t *src, int count)
 {
         int i = 0;
@@ -2844,7 +3182,7 @@ __add_array (int32_t *dest, int32_t *src, int count)
         }
 }
 
-static void
+void
 __add_long_array (int64_t *dest, int64_t *src, int count)
 {
         int i = 0;
@@ -2880,11 +3218,17 @@ do_xattrop (call_frame_t *frame, xlator_t *this,
 
         char *    path  = NULL;
         inode_t * inode = NULL;
+        struct posix_private *priv = NULL;
+        gf_boolean_t batched = _gf_false;
 
         VALIDATE_OR_GOTO (frame, out);
         VALIDATE_OR_GOTO (xattr, out);
         VALIDATE_OR_GOTO (this, out);
 
+        if (posix_pack_xattrop (frame, this, loc, fd, optype, xattr))
+                return 0;
+
+        priv = this->private;
         trav = xattr->members_list;
 
         if (fd) {
@@ -2910,6 +3254,20 @@ do_xattrop (call_frame_t *frame, xlator_t *this,
                 inode = fd->inode;
         }
 
+        if (priv->xattrop) {
+                ret = posix_xattrop_batch (this, inode, real_path, _fd,
+                                           optype, xattr);
+                if (ret == 0) {
+                        batched = _gf_true;
+                        goto out;
+                }
+                if (ret < 0) {
+                        op_ret = -1;
+                        op_errno = -ret;
+                        goto out;
+                }
+        }
+
         while (trav && inode) {
                 count = trav->value->len;
                 array = GF_CALLOC (count, sizeof (char),
@@ -3029,6 +3387,10 @@ do_xattrop (call_frame_t *frame, xlator_t *this,
         }
 
 out:
+        /* batched values are not on disk yet, see posix_xattrop_overlay() */
+        if (!batched)
+                posix_xattr_cache_invalidate (this, inode);
+
         if (array)
                 GF_FREE (array);
 
@@ -3115,6 +3477,11 @@ posix_ftruncate (call_frame_t *frame, xlator_t *this,
         priv = this->private;
         VALIDATE_OR_GOTO (priv, out);
 
+        if (posix_pack_truncate (frame, this, NULL, fd, offset)) {
+                SET_TO_OLD_FS_ID ();
+                return 0;
+        }
+
         ret = posix_fd_ctx_get (fd, this, &pfd);
         if (ret < 0) {
                 gf_log (this->name, GF_LOG_WARNING,
@@ -3164,77 +3531,513 @@ out:
 }
 
 
-int32_t
-posix_fstat (call_frame_t *frame, xlator_t *this,
-             fd_t *fd)
+static int
+posix_write_zeros (int _fd, off_t offset, size_t len)
 {
-        int                   _fd      = -1;
-        int32_t               op_ret   = -1;
-        int32_t               op_errno = 0;
-        struct iatt           buf      = {0,};
-        struct posix_fd      *pfd      = NULL;
-        int                   ret      = -1;
-        struct posix_private *priv     = NULL;
+        char    *zeros = NULL;
+        size_t   chunk = 0;
+        ssize_t  ret   = 0;
+        int      op_ret = 0;
 
-        DECLARE_OLD_FS_ID_VAR;
-        SET_FS_ID (frame->root->uid, frame->root->gid);
+        zeros = GF_CALLOC (1, POSIX_ZEROFILL_CHUNK_SIZE, gf_posix_mt_char);
+        if (!zeros)
+                return -ENOMEM;
 
-        VALIDATE_OR_GOTO (frame, out);
-        VALIDATE_OR_GOTO (this, out);
-        VALIDATE_OR_GOTO (fd, out);
+        while (len > 0) {
+                chunk = min (len, POSIX_ZEROFILL_CHUNK_SIZE);
 
-        priv = this->private;
-        VALIDATE_OR_GOTO (priv, out);
+                ret = pwrite (_fd, zeros, chunk, offset);
+                if (ret <= 0) {
+                        op_ret = (ret == 0) ? -EIO : -errno;
+                        break;
+                }
+
+                offset += ret;
+                len    -= ret;
+        }
+
+        GF_FREE (zeros);
+
+        return op_ret;
+}
+
+
+/* the range is handed to fallocate(2), mode being the FALLOC_FL_* flags;
+   a zero-fill which the filesystem can not do itself writes the zeros.
+   Returns 0 or -errno, with preop and postop filled. */
+static int
+posix_do_fallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                    int32_t mode, gf_boolean_t zerofill, off_t offset,
+                    size_t len, struct iatt *preop, struct iatt *postop)
+{
+        struct posix_fd *pfd   = NULL;
+        int              _fd   = -1;
+        int              ret   = -1;
+        gf_loglevel_t    level = GF_LOG_ERROR;
 
         ret = posix_fd_ctx_get (fd, this, &pfd);
         if (ret < 0) {
                 gf_log (this->name, GF_LOG_WARNING,
                         "pfd is NULL, fd=%p", fd);
-                op_errno = -ret;
-                goto out;
+                return ret;
         }
 
         _fd = pfd->fd;
 
-        op_ret = posix_fdstat (this, _fd, &buf);
-        if (op_ret == -1) {
-                op_errno = errno;
-                gf_log (this->name, GF_LOG_ERROR, "fstat failed on fd=%p: %s",
-                        fd, strerror (op_errno));
-                goto out;
+        ret = posix_fdstat (this, _fd, preop);
+        if (ret == -1) {
+                ret = -errno;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "pre-operation fstat failed on fd=%p: %s", fd,
+                        strerror (-ret));
+                return ret;
         }
 
-        op_ret = 0;
+#ifdef GF_LINUX_HOST_OS
+        ret = fallocate (_fd, mode, offset, len);
+        if (ret == -1)
+                ret = -errno;
+#else
+        ret = -ENOSYS;
+#endif
 
-out:
-        SET_TO_OLD_FS_ID ();
+        if ((ret == -EOPNOTSUPP || ret == -ENOSYS) && zerofill)
+                ret = posix_write_zeros (_fd, offset, len);
+
+        if (ret < 0) {
+                /* not supported by the filesystem is not worth an error */
+                level = (ret == -EOPNOTSUPP) ? GF_LOG_DEBUG : GF_LOG_ERROR;
+                gf_log (this->name, level, "fallocate (mode %d) failed on "
+                        "fd=%p (%"PRId64", %"GF_PRI_SIZET"): %s", mode, fd,
+                        offset, len, strerror (-ret));
+                return ret;
+        }
+
+        ret = posix_fdstat (this, _fd, postop);
+        if (ret == -1) {
+                ret = -errno;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "post-operation fstat failed on fd=%p: %s",
+                        fd, strerror (-ret));
+                return ret;
+        }
 
-        STACK_UNWIND_STRICT (fstat, frame, op_ret, op_errno, &buf);
         return 0;
 }
 
-static int gf_posix_lk_log;
 
 int32_t
-posix_lk (call_frame_t *frame, xlator_t *this,
-          fd_t *fd, int32_t cmd, struct gf_flock *lock)
+posix_glfallocate (call_frame_t *frame, xlator_t *this, fd_t *fd,
+                   int32_t keep_size, off_t offset, size_t len)
 {
-        struct gf_flock nullock = {0, };
+        int32_t     op_ret   = -1;
+        int32_t     op_errno = 0;
+        int32_t     mode     = 0;
+        struct iatt preop    = {0,};
+        struct iatt postop   = {0,};
 
-        GF_LOG_OCCASIONALLY (gf_posix_lk_log, this->name, GF_LOG_CRITICAL,
-                             "\"features/locks\" translator is "
-                             "not loaded. You need to use it for proper "
-                             "functioning of your application.");
+        DECLARE_OLD_FS_ID_VAR;
+        SET_FS_ID (frame->root->uid, frame->root->gid);
 
-        STACK_UNWIND_STRICT (lk, frame, -1, ENOSYS, &nullock);
-        return 0;
-}
+        VALIDATE_OR_GOTO (frame, out);
+        VALIDATE_OR_GOTO (this, out);
+        VALIDATE_OR_GOTO (fd, out);
 
-int32_t
-posix_inodelk (call_frame_t *frame, xlator_t *this,
-               const char *volume, loc_t *loc, int32_t cmd, struct gf_flock *lock)
-{
-        GF_LOG_OCCASIONALLY (gf_posix_lk_log, this->name, GF_LOG_CRITICAL,
+        if (keep_size)
+                mode = FALLOC_FL_KEEP_SIZE;
+
+        op_ret = posix_do_fallocate (frame, this, fd, mode, _gf_false,
+                                     offset, len, &preop, &postop);
+        if (op_ret < 0) {
+                op_errno = -op_ret;
+                op_ret = -1;
+                goto out;
+        }
+
+        op_ret = 0;
+out:
+        SET_TO_OLD_FS_ID ();
+
+        STACK_UNWIND_STRICT (fallocate, frame, op_ret, op_errno, &preop,
+                             &postop);
+
+        return 0;
+}
+
+
+int32_t
+posix_discard (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+               size_t len)
+{
+        int32_t     op_ret   = -1;
+        int32_t     op_errno = 0;
+        struct iatt preop    = {0,};
+        struct iatt postop   = {0,};
+
+        DECLARE_OLD_FS_ID_VAR;
+        SET_FS_ID (frame->root->uid, frame->root->gid);
+
+        VALIDATE_OR_GOTO (frame, out);
+        VALIDATE_OR_GOTO (this, out);
+        VALIDATE_OR_GOTO (fd, out);
+
+        op_ret = posix_do_fallocate (frame, this, fd,
+                                     FALLOC_FL_PUNCH_HOLE|FALLOC_FL_KEEP_SIZE,
+                                     _gf_false, offset, len, &preop, &postop);
+        if (op_ret < 0) {
+                op_errno = -op_ret;
+                op_ret = -1;
+                goto out;
+        }
+
+        op_ret = 0;
+out:
+        SET_TO_OLD_FS_ID ();
+
+        STACK_UNWIND_STRICT (discard, frame, op_ret, op_errno, &preop,
+                             &postop);
+
+        return 0;
+}
+
+
+int32_t
+posix_zerofill (call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+                size_t len)
+{
+        int32_t     op_ret   = -1;
+        int32_t     op_errno = 0;
+        struct iatt preop    = {0,};
+        struct iatt postop   = {0,};
+
+        DECLARE_OLD_FS_ID_VAR;
+        SET_FS_ID (frame->root->uid, frame->root->gid);
+
+        VALIDATE_OR_GOTO (frame, out);
+        VALIDATE_OR_GOTO (this, out);
+        VALIDATE_OR_GOTO (fd, out);
+
+        op_ret = posix_do_fallocate (frame, this, fd, FALLOC_FL_ZERO_RANGE,
+                                     _gf_true, offset, len, &preop, &postop);
+        if (op_ret < 0) {
+                op_errno = -op_ret;
+                op_ret = -1;
+                goto out;
+        }
+
+        op_ret = 0;
+out:
+        SET_TO_OLD_FS_ID ();
+
+        STACK_UNWIND_STRICT (zerofill, frame, op_ret, op_errno, &preop,
+                             &postop);
+
+        return 0;
+}
+
+
+static ssize_t
+posix_copy_rw (int _fd_in, off_t off_in, int _fd_out, off_t off_out,
+               size_t len)
+{
+        char    *buf    = NULL;
+        ssize_t  copied = 0;
+        ssize_t  nread  = 0;
+        ssize_t  ret    = 0;
+
+        buf = GF_MALLOC (POSIX_COPY_CHUNK_SIZE, gf_posix_mt_char);
+        if (!buf)
+                return -ENOMEM;
+
+        while (copied < len) {
+                nread = pread (_fd_in, buf,
+                               min (len - copied, POSIX_COPY_CHUNK_SIZE),
+                               off_in + copied);
+                if (nread <= 0) {
+                        if (nread == -1)
+                                ret = -errno;
+                        break;
+                }
+
+                ret = pwrite (_fd_out, buf, nread, off_out + copied);
+                if (ret <= 0) {
+                        ret = (ret == 0) ? -EIO : -errno;
+                        break;
+                }
+
+                copied += ret;
+                if (ret < nread)
+                        break;
+        }
+
+        GF_FREE (buf);
+
+        if (copied == 0 && ret < 0)
+                return ret;
+
+        return copied;
+}
+
+
+/* copies len bytes of _fd_in at off_in, which holds in_size bytes, to
+   _fd_out at off_out. The blocks are shared when the filesystem can
+   clone them, the data is copied by the kernel with copy_file_range(2)
+   otherwise, and read and written here when neither is possible.
+   Returns the bytes copied or -errno. */
+static ssize_t
+posix_do_copy_file_range (xlator_t *this, int _fd_in, off_t off_in,
+                          int _fd_out, off_t off_out, size_t len,
+                          off_t in_size, uint32_t blksize)
+{
+        ssize_t                  copied = 0;
+        ssize_t                  ret    = 0;
+#ifdef GF_LINUX_HOST_OS
+        struct posix_clone_range range  = {0, };
+        loff_t                   in_off = 0;
+        loff_t                   out_off = 0;
+#endif
+
+        if (off_in >= in_size)
+                return 0;
+
+        if (len > in_size - off_in)
+                len = in_size - off_in;
+
+#ifdef GF_LINUX_HOST_OS
+        /* a clone has to start on a block, and end on one or at the end
+           of the source */
+        if (blksize && (off_in % blksize == 0) && (off_out % blksize == 0)
+            && ((len % blksize == 0) || (off_in + len == in_size))) {
+                range.src_fd      = _fd_in;
+                range.src_offset  = off_in;
+                range.src_length  = len;
+                range.dest_offset = off_out;
+
+                ret = ioctl (_fd_out, POSIX_FICLONERANGE, &range);
+                if (ret == 0)
+                        return len;
+
+                gf_log (this->name, GF_LOG_TRACE,
+                        "clone of %"GF_PRI_SIZET" bytes failed (%s), "
+                        "copying them", len, strerror (errno));
+        }
+
+#ifdef __NR_copy_file_range
+        while (copied < len) {
+                in_off  = off_in + copied;
+                out_off = off_out + copied;
+
+                ret = syscall (__NR_copy_file_range, _fd_in, &in_off,
+                               _fd_out, &out_off, len - copied, 0);
+                if (ret > 0) {
+                        copied += ret;
+                        continue;
+                }
+
+                if (ret == 0)
+                        break;
+
+                /* the kernel or the filesystem can not copy it */
+                if (copied == 0 && (errno == ENOSYS || errno == EXDEV ||
+                                    errno == EOPNOTSUPP || errno == EINVAL))
+                        goto rw;
+
+                return copied ? copied : -errno;
+        }
+
+        return copied;
+rw:
+#endif /* __NR_copy_file_range */
+#endif /* GF_LINUX_HOST_OS */
+
+        return posix_copy_rw (_fd_in, off_in, _fd_out, off_out, len);
+}
+
+
+int32_t
+posix_copy_file_range (call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                       off_t off_in, fd_t *fd_out, off_t off_out, size_t len,
+                       uint32_t flags)
+{
+        int32_t          op_ret   = -1;
+        int32_t          op_errno = 0;
+        int              ret      = -1;
+        ssize_t          copied   = 0;
+        struct posix_fd *pfd_in   = NULL;
+        struct posix_fd *pfd_out  = NULL;
+        struct iatt      stbuf_in = {0,};
+        struct iatt      preop    = {0,};
+        struct iatt      postop   = {0,};
+
+        DECLARE_OLD_FS_ID_VAR;
+        SET_FS_ID (frame->root->uid, frame->root->gid);
+
+        VALIDATE_OR_GOTO (frame, out);
+        VALIDATE_OR_GOTO (this, out);
+        VALIDATE_OR_GOTO (fd_in, out);
+        VALIDATE_OR_GOTO (fd_out, out);
+
+        /* no flags are defined */
+        if (flags) {
+                op_errno = EINVAL;
+                goto out;
+        }
+
+        ret = posix_fd_ctx_get (fd_in, this, &pfd_in);
+        if (ret < 0) {
+                op_errno = -ret;
+                gf_log (this->name, GF_LOG_WARNING,
+                        "pfd is NULL, fd=%p", fd_in);
+                goto out;
+        }
+
+        ret = posix_fd_ctx_get (fd_out, this, &pfd_out);
+        if (ret < 0) {
+                op_errno = -ret;
+                gf_log (this->name, GF_LOG_WARNING,
+                        "pfd is NULL, fd=%p", fd_out);
+                goto out;
+        }
+
+        ret = posix_fdstat (this, pfd_in->fd, &stbuf_in);
+        if (ret == -1) {
+                op_errno = errno;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "fstat failed on fd=%p: %s", fd_in,
+                        strerror (op_errno));
+                goto out;
+        }
+
+        ret = posix_fdstat (this, pfd_out->fd, &preop);
+        if (ret == -1) {
+                op_errno = errno;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "pre-operation fstat failed on fd=%p: %s", fd_out,
+                        strerror (op_errno));
+                goto out;
+        }
+
+        /* as copy_file_range(2), the ranges of one file may not overlap */
+        if (!uuid_compare (stbuf_in.ia_gfid, preop.ia_gfid) &&
+            (off_in < off_out + len) && (off_out < off_in + len)) {
+                op_errno = EINVAL;
+                goto out;
+        }
+
+        if (len > POSIX_COPY_MAX)
+                len = POSIX_COPY_MAX;
+
+        copied = posix_do_copy_file_range (this, pfd_in->fd, off_in,
+                                           pfd_out->fd, off_out, len,
+                                           stbuf_in.ia_size,
+                                           stbuf_in.ia_blksize);
+        if (copied < 0) {
+                op_errno = -copied;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "copy of %"GF_PRI_SIZET" bytes from fd=%p "
+                        "(%"PRId64") to fd=%p (%"PRId64") failed: %s", len,
+                        fd_in, off_in, fd_out, off_out, strerror (op_errno));
+                goto out;
+        }
+
+        ret = posix_fdstat (this, pfd_out->fd, &postop);
+        if (ret == -1) {
+                op_errno = errno;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "post-operation fstat failed on fd=%p: %s", fd_out,
+                        strerror (op_errno));
+                goto out;
+        }
+
+        posix_fdstat (this, pfd_in->fd, &stbuf_in);
+
+        op_ret = copied;
+out:
+        SET_TO_OLD_FS_ID ();
+
+        STACK_UNWIND_STRICT (copy_file_range, frame, op_ret, op_errno,
+                             &stbuf_in, &preop, &postop);
+
+        return 0;
+}
+
+
+int32_t
+posix_fstat (call_frame_t *frame, xlator_t *this,
+             fd_t *fd)
+{
+        int                   _fd      = -1;
+        int32_t               op_ret   = -1;
+        int32_t               op_errno = 0;
+        struct iatt           buf      = {0,};
+        struct posix_fd      *pfd      = NULL;
+        int                   ret      = -1;
+        struct posix_private *priv     = NULL;
+
+        DECLARE_OLD_FS_ID_VAR;
+        SET_FS_ID (frame->root->uid, frame->root->gid);
+
+        VALIDATE_OR_GOTO (frame, out);
+        VALIDATE_OR_GOTO (this, out);
+        VALIDATE_OR_GOTO (fd, out);
+
+        priv = this->private;
+        VALIDATE_OR_GOTO (priv, out);
+
+        if (posix_pack_fstat (frame, this, fd)) {
+                SET_TO_OLD_FS_ID ();
+                return 0;
+        }
+
+        ret = posix_fd_ctx_get (fd, this, &pfd);
+        if (ret < 0) {
+                gf_log (this->name, GF_LOG_WARNING,
+                        "pfd is NULL, fd=%p", fd);
+                op_errno = -ret;
+                goto out;
+        }
+
+        _fd = pfd->fd;
+
+        op_ret = posix_fdstat (this, _fd, &buf);
+        if (op_ret == -1) {
+                op_errno = errno;
+                gf_log (this->name, GF_LOG_ERROR, "fstat failed on fd=%p: %s",
+                        fd, strerror (op_errno));
+                goto out;
+        }
+
+        op_ret = 0;
+
+out:
+        SET_TO_OLD_FS_ID ();
+
+        STACK_UNWIND_STRICT (fstat, frame, op_ret, op_errno, &buf);
+        return 0;
+}
+
+static int gf_posix_lk_log;
+
+int32_t
+posix_lk (call_frame_t *frame, xlator_t *this,
+          fd_t *fd, int32_t cmd, struct gf_flock *lock)
+{
+        struct gf_flock nullock = {0, };
+
+        GF_LOG_OCCASIONALLY (gf_posix_lk_log, this->name, GF_LOG_CRITICAL,
+                             "\"features/locks\" translator is "
+                             "not loaded. You need to use it for proper "
+                             "functioning of your application.");
+
+        STACK_UNWIND_STRICT (lk, frame, -1, ENOSYS, &nullock);
+        return 0;
+}
+
+int32_t
+posix_inodelk (call_frame_t *frame, xlator_t *this,
+               const char *volume, loc_t *loc, int32_t cmd, struct gf_flock *lock)
+{
+        GF_LOG_OCCASIONALLY (gf_posix_lk_log, this->name, GF_LOG_CRITICAL,
                              "\"features/locks\" translator is "
                              "not loaded. You need to use it for proper "
                              "functioning of your application.");
@@ -3297,7 +4100,6 @@ posix_fill_readdir (fd_t *fd, DIR *dir, off_t off, size_t size,
         struct dirent  *entry          = NULL;
         int32_t               this_size      = -1;
         gf_dirent_t          *this_entry     = NULL;
-        uuid_t                rootgfid = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1};
 
         if (!off) {
                 rewinddir (dir);
@@ -3329,30 +4131,9 @@ posix_fill_readdir (fd_t *fd, DIR *dir, off_t off, size_t size,
                         break;
                 }
 
-                if ((uuid_compare (fd->inode->gfid, rootgfid) == 0)
-                    && (!strcmp (entry->d_name, GF_REPLICATE_TRASH_DIR)))
+                if (posix_readdir_skip (fd, entry->d_name))
                         continue;
 
-#ifdef __NetBSD__
-	       /*
-		* NetBSD with UFS1 backend uses backing files for
-		* extended attributes. They can be found in a
-		* .attribute file located at the root of the filesystem
-		* We hide it to glusterfs clients, since chaos will occur
-		* when the cluster/dht xlator decides to distribute
-		* exended attribute backing file accross storage servers.
-		*/
-		if ((uuid_compare (fd->inode->gfid, rootgfid) == 0)
-		    && (!strcmp(entry->d_name, ".attribute")))
-			continue;
-#endif /* __NetBSD__ */
-
-                if ((uuid_compare (fd->inode->gfid, rootgfid) == 0)
-                    && (!strncmp (GF_HIDDEN_PATH, entry->d_name,
-                                  strlen (GF_HIDDEN_PATH)))) {
-                        continue;
-                }
-
                 this_size = max (sizeof (gf_dirent_t),
                                  sizeof (gfs3_dirplist))
                         + strlen (entry->d_name) + 1;
@@ -3395,12 +4176,13 @@ posix_do_readdir (call_frame_t *frame, xlator_t *this,
         DIR                  *dir            = NULL;
         int                   ret            = -1;
         int                   count          = 0;
+        int                   pack_count     = 0;
         int32_t               op_ret         = -1;
         int32_t               op_errno       = 0;
         gf_dirent_t           entries;
+#ifdef IGNORE_READDIRP_ATTRS
         struct iatt           stbuf          = {0, };
         gf_dirent_t          *tmp_entry      = NULL;
-#ifdef IGNORE_READDIRP_ATTRS
         uuid_t                gfid;
         ia_type_t             entry_type     = 0;
 #endif
@@ -3428,14 +4210,25 @@ posix_do_readdir (call_frame_t *frame, xlator_t *this,
                 goto out;
         }
 
-        count = posix_fill_readdir (fd, dir, off, size, &entries);
+        /* packed files are listed after the end of the directory */
+        if (POSIX_PACK_IS_DOFF (off)) {
+                errno = ENOENT;
+        } else {
+                errno = 0;
+#ifdef GF_LINUX_HOST_OS
+                count = posix_fill_readdir_getdents (this, fd, pfd->fd, off,
+                                                     size, &entries);
+#else
+                count = posix_fill_readdir (fd, dir, off, size, &entries);
+#endif
+        }
 
         /* pick ENOENT to indicate EOF */
         op_errno = errno;
 
         if (whichop == GF_FOP_READDIRP) {
-                list_for_each_entry (tmp_entry, &entries.list, list) {
 #ifdef IGNORE_READDIRP_ATTRS
+                list_for_each_entry (tmp_entry, &entries.list, list) {
                         ret = inode_grep_for_gfid (fd->inode->table, fd->inode,
                                                    tmp_entry->d_name, gfid,
                                                    &entry_type);
@@ -3448,17 +4241,22 @@ posix_do_readdir (call_frame_t *frame, xlator_t *this,
                                 posix_istat (this, fd->inode->gfid,
                                              tmp_entry->d_name, &stbuf);
                         }
-#else
-                        posix_istat (this, fd->inode->gfid,
-                                     tmp_entry->d_name, &stbuf);
-#endif
                         if (stbuf.ia_ino)
                                 tmp_entry->d_ino = stbuf.ia_ino;
                         tmp_entry->d_stat = stbuf;
                 }
+#else
+                posix_readdirp_fill (this, fd, pfd->fd, &entries, count);
+#endif
+        }
+
+        if (op_errno == ENOENT) {
+                pack_count = posix_pack_readdir (this, fd, off, size,
+                                                 &entries, whichop);
+                op_errno = errno;
         }
 
-        op_ret = count;
+        op_ret = count + pack_count;
 
 out:
         STACK_UNWIND_STRICT (readdir, frame, op_ret, op_errno, &entries);
@@ -3509,6 +4307,37 @@ posix_priv (xlator_t *this)
         gf_proc_dump_write("max_read","%d", priv->read_value);
         gf_proc_dump_write("max_write","%d", priv->write_value);
         gf_proc_dump_write("nr_files","%ld", priv->nr_files);
+        gf_proc_dump_write("linux_aio","%d", priv->aio_capable);
+        if (priv->xattr_cache) {
+                gf_proc_dump_write("xattr_cache_hits","%"PRIu64,
+                                   priv->xattr_cache_hits);
+                gf_proc_dump_write("xattr_cache_misses","%"PRIu64,
+                                   priv->xattr_cache_misses);
+        }
+        if (priv->xattrop) {
+                gf_proc_dump_write("xattrop_pending","%u",
+                                   priv->xattrop->count);
+                gf_proc_dump_write("xattrop_updates","%"PRIu64,
+                                   priv->xattrop->updates);
+                gf_proc_dump_write("xattrop_flushes","%"PRIu64,
+                                   priv->xattrop->flushes);
+        }
+        if (priv->pack) {
+                gf_proc_dump_write("pack_files","%"PRIu64,
+                                   priv->pack->count);
+                gf_proc_dump_write("pack_spills","%"PRIu64,
+                                   priv->pack->spills);
+                gf_proc_dump_write("pack_compactions","%"PRIu64,
+                                   priv->pack->compactions);
+        }
+        if (priv->handle_cache) {
+                gf_proc_dump_write("handle_cache_entries","%u",
+                                   priv->handle_cache->count);
+                gf_proc_dump_write("handle_cache_hits","%"PRIu64,
+                                   priv->handle_cache->hits);
+                gf_proc_dump_write("handle_cache_misses","%"PRIu64,
+                                   priv->handle_cache->misses);
+        }
 
         return 0;
 }
@@ -3520,6 +4349,9 @@ posix_inode (xlator_t *this)
 }
 
 
+/* ranges larger than this are read and summed in pieces of this size */
+#define POSIX_RCHECKSUM_CHUNK (128 * 1024)
+
 int32_t
 posix_rchecksum (call_frame_t *frame, xlator_t *this,
                  fd_t *fd, off_t offset, int32_t len)
@@ -3529,6 +4361,7 @@ posix_rchecksum (call_frame_t *frame, xlator_t *this,
         int       _fd      = -1;
 
         struct posix_fd *pfd  = NULL;
+        struct posix_private *priv = NULL;
 
         int op_ret   = -1;
         int op_errno = 0;
@@ -3538,12 +4371,19 @@ posix_rchecksum (call_frame_t *frame, xlator_t *this,
         int32_t weak_checksum = 0;
         uint8_t strong_checksum[MD5_DIGEST_LEN];
 
+        gf_checksum_ctx_t ctx;
+        int32_t   chunk = 0;
+        int32_t   done  = 0;
+
         VALIDATE_OR_GOTO (frame, out);
         VALIDATE_OR_GOTO (this, out);
         VALIDATE_OR_GOTO (fd, out);
 
+        priv = this->private;
+
         memset (strong_checksum, 0, MD5_DIGEST_LEN);
-        buf = GF_CALLOC (1, len, gf_posix_mt_char);
+        buf = GF_CALLOC (1, min (len, POSIX_RCHECKSUM_CHUNK),
+                         gf_posix_mt_char);
 
         if (!buf) {
                 op_errno = ENOMEM;
@@ -3560,23 +4400,42 @@ posix_rchecksum (call_frame_t *frame, xlator_t *this,
 
         _fd = pfd->fd;
 
-        ret = pread (_fd, buf, len, offset);
-        if (ret < 0) {
-                gf_log (this->name, GF_LOG_WARNING,
-                        "pread of %d bytes returned %d (%s)",
-                        len, ret, strerror (errno));
+        gf_checksum_init (&ctx, priv->checksum_type);
 
-                op_errno = errno;
-                goto out;
-        }
+        /* data past the end of the file sums as zeroes */
+        while (done < len) {
+                chunk = min (len - done, POSIX_RCHECKSUM_CHUNK);
+                if (done)
+                        memset (buf, 0, chunk);
 
-        weak_checksum = gf_rsync_weak_checksum (buf, len);
-        gf_rsync_strong_checksum (buf, len, strong_checksum);
+                ret = pread (_fd, buf, chunk, offset + done);
+                if (ret < 0) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "pread of %d bytes returned %d (%s)",
+                                chunk, ret, strerror (errno));
 
-        GF_FREE (buf);
+                        op_errno = errno;
+                        goto out;
+                }
+
+                if (done)
+                        weak_checksum = gf_rsync_weak_checksum_combine
+                                (weak_checksum,
+                                 gf_rsync_weak_checksum (buf, chunk), chunk);
+                else
+                        weak_checksum = gf_rsync_weak_checksum (buf, chunk);
+
+                gf_checksum_update (&ctx, buf, chunk);
+
+                done += chunk;
+        }
+
+        gf_checksum_final (&ctx, strong_checksum);
 
         op_ret = 0;
 out:
+        GF_FREE (buf);
+
         STACK_UNWIND_STRICT (rchecksum, frame, op_ret, op_errno,
                              weak_checksum, strong_checksum);
         return 0;
@@ -3641,6 +4500,9 @@ init (xlator_t *this)
         int                    ret           = 0;
         int                    op_ret        = -1;
         int32_t                janitor_sleep = 0;
+        int32_t                handle_cache_size = 0;
+        int32_t                xattrop_interval = 0;
+        int32_t                readdirp_threads = 0;
         uuid_t                 old_uuid      = {0,};
         uuid_t                 dict_uuid     = {0,};
         uuid_t                 gfid          = {0,};
@@ -3892,6 +4754,118 @@ init (xlator_t *this)
                                 "for every open)");
         }
 
+        tmp_data = dict_get (this->options, "xattr-cache");
+        if (tmp_data) {
+                if (gf_string2boolean (tmp_data->data,
+                                       &_private->xattr_cache) == -1) {
+                        ret = -1;
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "wrong option provided for 'xattr-cache'");
+                        goto out;
+                }
+        }
+
+        tmp_data = dict_get (this->options, "xattrop-batch");
+        if (tmp_data) {
+                if (gf_string2boolean (tmp_data->data,
+                                       &_private->xattrop_batch) == -1) {
+                        ret = -1;
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "wrong option provided for 'xattrop-batch'");
+                        goto out;
+                }
+        }
+
+        xattrop_interval = POSIX_XATTROP_FLUSH_INTERVAL;
+        dict_ret = dict_get_int32 (this->options, "xattrop-flush-interval",
+                                   &xattrop_interval);
+        if ((dict_ret == 0) && (xattrop_interval < 1)) {
+                ret = -1;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "wrong option provided for 'xattrop-flush-interval'");
+                goto out;
+        }
+
+        readdirp_threads = POSIX_READDIRP_THREADS;
+        dict_ret = dict_get_int32 (this->options, "readdirp-threads",
+                                   &readdirp_threads);
+        if ((dict_ret == 0) && ((readdirp_threads < 0) ||
+                                (readdirp_threads > POSIX_READDIRP_MAX_THREADS))) {
+                ret = -1;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "wrong option provided for 'readdirp-threads'");
+                goto out;
+        }
+        _private->readdirp_threads = readdirp_threads;
+
+        tmp_data = dict_get (this->options, "zero-copy-read");
+        if (tmp_data) {
+                if (gf_string2boolean (tmp_data->data,
+                                       &_private->zero_copy_read) == -1) {
+                        ret = -1;
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "wrong option provided for 'zero-copy-read'");
+                        goto out;
+                }
+        }
+
+        tmp_data = dict_get (this->options, "pack-small-files");
+        if (tmp_data) {
+                if (gf_string2boolean (tmp_data->data,
+                                       &_private->pack_small_files) == -1) {
+                        ret = -1;
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "wrong option provided for 'pack-small-files'");
+                        goto out;
+                }
+        }
+
+        _private->pack_threshold = POSIX_PACK_THRESHOLD;
+        tmp_data = dict_get (this->options, "pack-threshold");
+        if (tmp_data) {
+                if ((gf_string2bytesize (tmp_data->data,
+                                         &_private->pack_threshold) != 0) ||
+                    (_private->pack_threshold > POSIX_PACK_MAX_THRESHOLD)) {
+                        ret = -1;
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "wrong option provided for 'pack-threshold'");
+                        goto out;
+                }
+        }
+
+        tmp_data = dict_get (this->options, "linux-aio");
+        if (tmp_data) {
+                if (gf_string2boolean (tmp_data->data,
+                                       &_private->aio_configured) == -1) {
+                        ret = -1;
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "wrong option provided for 'linux-aio'");
+                        goto out;
+                }
+        }
+
+        _private->checksum_type = GF_CHECKSUM_MD5;
+        tmp_data = dict_get (this->options, "checksum-type");
+        if (tmp_data) {
+                if (gf_checksum_type_from_str (tmp_data->data,
+                                               &_private->checksum_type)) {
+                        ret = -1;
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "wrong option provided for 'checksum-type'");
+                        goto out;
+                }
+        }
+
+        handle_cache_size = POSIX_HANDLE_CACHE_DEFAULT;
+        dict_ret = dict_get_int32 (this->options, "handle-cache-size",
+                                   &handle_cache_size);
+        if ((dict_ret == 0) && (handle_cache_size < 0)) {
+                ret = -1;
+                gf_log (this->name, GF_LOG_ERROR,
+                        "wrong option provided for 'handle-cache-size'");
+                goto out;
+        }
+
         _private->janitor_sleep_duration = 600;
 
         dict_ret = dict_get_int32 (this->options, "janitor-sleep-duration",
@@ -3950,11 +4924,39 @@ init (xlator_t *this)
                 goto out;
         }
 
+        _private->handle_cache = posix_handle_cache_new (this,
+                                                         handle_cache_size);
+
+        /* replays what a previous run left in the journal */
+        op_ret = posix_xattrop_init (this, _private->xattrop_batch,
+                                     xattrop_interval);
+        if (op_ret == -1) {
+                ret = -1;
+                goto out;
+        }
+
+        /* not fatal, readdirps stat their entries in the calling thread */
+        if (posix_readdirp_init (this, _private->readdirp_threads) == -1)
+                gf_log (this->name, GF_LOG_WARNING,
+                        "starting the readdirp threads failed");
+
+        /* files packed before are served even with packing off */
+        op_ret = posix_pack_init (this, _private->pack_small_files,
+                                  _private->pack_threshold);
+        if (op_ret == -1) {
+                ret = -1;
+                goto out;
+        }
+
         pthread_mutex_init (&_private->janitor_lock, NULL);
         pthread_cond_init (&_private->janitor_cond, NULL);
         INIT_LIST_HEAD (&_private->janitor_fds);
 
         posix_spawn_janitor_thread (this);
+
+        /* not fatal, the data path stays synchronous */
+        if (_private->aio_configured)
+                posix_aio_on (this);
 out:
         return ret;
 }
@@ -3965,6 +4967,11 @@ fini (xlator_t *this)
         struct posix_private *priv = this->private;
         if (!priv)
                 return;
+        posix_aio_off (this);
+        posix_readdirp_fini (this);
+        posix_xattrop_fini (this);
+        posix_pack_fini (this);
+        posix_handle_cache_destroy (priv->handle_cache);
         this->private = NULL;
         /*unlock brick dir*/
         if (priv->mount_lock)
@@ -4019,6 +5026,10 @@ struct xlator_fops fops = {
         .fxattrop    = posix_fxattrop,
         .setattr     = posix_setattr,
         .fsetattr    = posix_fsetattr,
+        .fallocate   = posix_glfallocate,
+        .discard     = posix_discard,
+        .zerofill    = posix_zerofill,
+        .copy_file_range = posix_copy_file_range,
 };
 
 struct xlator_cbks cbks = {
@@ -4044,5 +5055,91 @@ struct volume_options options[] = {
           .type = GF_OPTION_TYPE_INT },
         { .key  = {"volume-id"},
           .type = GF_OPTION_TYPE_ANY },
+        { .key  = {"handle-cache-size"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 0,
+          .default_value = "4096",
+          .description = "Number of directories whose resolved gfid handle "
+                         "is kept in memory, 0 disables the cache."
+        },
+        { .key  = {"xattr-cache"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Read all the trusted.* and system.* xattrs of an "
+                         "inode at once on lookup and keep them with the "
+                         "inode, so that further lookups asking for them "
+                         "need no getxattr."
+        },
+        { .key  = {"xattrop-batch"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Add up xattrops (the changelog of replicate, the "
+                         "counters of marker) in memory and set them on disk "
+                         "in batches, after recording the new values in a "
+                         "journal under .glusterfs of the brick."
+        },
+        { .key  = {"xattrop-flush-interval"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 1,
+          .default_value = "1",
+          .description = "Seconds batched xattrops stay in memory at most "
+                         "before being set on disk."
+        },
+        { .key  = {"readdirp-threads"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 0,
+          .max  = 16,
+          .default_value = "4",
+          .description = "Number of threads the entries of a large readdirp "
+                         "are stat'ed by, 0 or 1 to stat them in the thread "
+                         "of the fop."
+        },
+        { .key  = {"zero-copy-read"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Answer reads coming from the network with a "
+                         "reference to the region of the file, which the "
+                         "socket transport sends with sendfile() instead of "
+                         "the data being copied through an iobuf. Not to be "
+                         "used with translators on the brick which look at "
+                         "the data of reads."
+        },
+        { .key  = {"pack-small-files"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Keep newly created regular files in large "
+                         "containers under .glusterfs of the brick, with an "
+                         "index of their names and attributes, instead of "
+                         "an inode and a handle each. A file becomes a "
+                         "regular one of the brick when it grows past "
+                         "pack-threshold or a fop needs it to be."
+        },
+        { .key  = {"pack-threshold"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min  = 0,
+          .max  = POSIX_PACK_MAX_THRESHOLD,
+          .default_value = "16KB",
+          .description = "Size up to which a file stays packed."
+        },
+        { .key  = {"linux-aio"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Submit reads, writes and fsyncs to a linux aio "
+                         "context of the brick and complete them from a "
+                         "dedicated thread, instead of blocking the thread "
+                         "of the fop. Reads and writes go that way only on "
+                         "fds opened with O_DIRECT (see o-direct): on "
+                         "buffered fds linux aio completes them inside "
+                         "io_submit()."
+        },
+        { .key  = {"checksum-type"},
+          .type = GF_OPTION_TYPE_STR,
+          .value = { "md5", "crc32c", "xxhash64", "" },
+          .default_value = "md5",
+          .description = "Strong checksum of the data returned by "
+                         "rchecksum. \"crc32c\" and \"xxhash64\" are "
+                         "much cheaper than \"md5\", it has to be the same "
+                         "on all the bricks of a replica."
+        },
         { .key  = {NULL} }
 };
@@ -53,6 +53,7 @@
 #include "timer.h"
 #include "posix-mem-types.h"
 #include "posix-handle.h"
+#include "checksum.h"
 
 
 /**
@@ -67,9 +68,36 @@ struct posix_fd {
         int     odirect;
         int     op_performed;
         struct list_head list; /* to add to the janitor list */
+        struct posix_pack_entry *pack; /* packed file, no fd yet */
 };
 
 
+/* smaller reads are copied, a sendfile() is not worth it */
+#define POSIX_ZERO_COPY_MIN_SIZE (64 * 1024)
+
+/* bounds the xattrs of an inode which are cached, in bytes */
+#define POSIX_XATTR_CACHE_MAX_SIZE 8192
+
+/* zeros written at once when the filesystem can not zero a range itself */
+#define POSIX_ZEROFILL_CHUNK_SIZE (128 * 1024)
+
+/* read and written at once by a copy the kernel can not do itself */
+#define POSIX_COPY_CHUNK_SIZE (128 * 1024)
+/* the most one copy_file_range does, its count has to fit op_ret */
+#define POSIX_COPY_MAX        (1024 * 1024 * 1024)
+
+/**
+ * posix_xattr_cache - trusted.* and system.* xattrs of an inode, kept in
+ * its ctx along with the ctime and gfid they were read with.
+ */
+struct posix_xattr_cache {
+        dict_t   *xattrs;
+        uint64_t  generation;
+        uint32_t  ctime;
+        uint32_t  ctime_nsec;
+        uuid_t    gfid;
+};
+
 struct posix_private {
 	char   *base_path;
 	int32_t base_path_length;
@@ -87,6 +115,9 @@ struct posix_private {
         struct list_head janitor_fds;
         pthread_cond_t janitor_cond;
         pthread_mutex_t janitor_lock;
+        uint64_t janitor_trash_pending; /* trees moved to the trash, not yet
+                                           walked by the janitor */
+        uint64_t janitor_removed;       /* entries deleted from the trash */
 
 	int64_t read_value;    /* Total read, from init */
 	int64_t write_value;   /* Total write, from init */
@@ -122,8 +153,47 @@ struct posix_private {
 
         struct stat     handledir;
 
+/* strong checksum rchecksum returns, the same on all the bricks */
+        gf_checksum_type_t checksum_type;
+
+/* resolved handles of directories (posix-handle.c) */
+        struct posix_handle_cache *handle_cache;
+
+/* lookups answered from the cached xattrs of the inodes */
+        gf_boolean_t    xattr_cache;
+        uint64_t        xattr_cache_hits;
+        uint64_t        xattr_cache_misses;
+
+/* threads stat'ing the entries of a readdirp (posix-readdirp.c) */
+        int32_t         readdirp_threads;
+        struct posix_readdirp_pool *readdirp_pool;
+
+/* xattrops added up in memory and flushed in batches (posix-xattrop.c) */
+        gf_boolean_t    xattrop_batch;
+        struct posix_xattrop_table *xattrop;
+
+/* small regular files kept in containers (posix-pack.c) */
+        gf_boolean_t    pack_small_files;
+        uint64_t        pack_threshold;
+        struct posix_pack_table *pack;
+
+/* reads answered with a file region of the iobref, see posix_readv() */
+        gf_boolean_t    zero_copy_read;
+
+/* readv, writev and fsync go through linux aio (posix-aio.c) */
+        gf_boolean_t    aio_configured;
+        gf_boolean_t    aio_capable;
+        gf_boolean_t    aio_fsync;
+        unsigned long   aio_ctx;
+        pthread_t       aiothread;
+        pthread_mutex_t aio_lock;
+        pthread_cond_t  aio_cond;   /* the last submission completed */
+        int             aio_in_flight;
 };
 
+#define ALIGN_BUF(ptr,bound) ((void *)((unsigned long)(ptr + bound - 1) & \
+                                       (unsigned long)(~(bound - 1))))
+
 #define POSIX_BASE_PATH(this) (((struct posix_private *)this->private)->base_path)
 
 #define POSIX_BASE_PATH_LEN(this) (((struct posix_private *)this->private)->base_path_length)
@@ -155,5 +225,11 @@ int posix_fd_ctx_get (fd_t *fd, xlator_t *this, struct posix_fd **pfd);
 int posix_fd_ctx_get_off (fd_t *fd, xlator_t *this, struct posix_fd **pfd,
                           off_t off);
 void posix_fill_ino_from_gfid (xlator_t *this, struct iatt *buf);
+int posix_fill_gfid_path (xlator_t *this, const char *path, struct iatt *iatt);
+void __add_array (int32_t *dest, int32_t *src, int count);
+void __add_long_array (int64_t *dest, int64_t *src, int count);
+int posix_fd_data_extents (xlator_t *this, int fd, dict_t *dict);
+void posix_xattr_cache_invalidate (xlator_t *this, inode_t *inode);
+void posix_xattr_cache_free (struct posix_xattr_cache *cache);
 
 #endif /* _POSIX_H */